@@ -0,0 +1,130 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ViennaRNA/model.h>
+#include <ViennaRNA/fold_compound.h>
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/utils/strings.h>
+#include <ViennaRNA/mfe.h>
+#include <ViennaRNA/part_func.h>
+
+#include "benchmark_utils.h"
+
+/*
+ *  Throughput benchmark for batch MFE and partition function computations
+ *  of many short sequences, e.g. siRNA candidates
+ *
+ *  Usage: benchmark_batch [number of sequences] [min. length] [max. length]
+ */
+
+static void
+report(const char   *method,
+       unsigned int num,
+       double       t,
+       float        *energies,
+       float        *energies_ref)
+{
+  printf("%-24s\t%.3f\t%.0f\t%s\n",
+         method,
+         t,
+         (double)num / t,
+         (memcmp(energies, energies_ref, sizeof(float) * num) == 0) ? "yes" : "no");
+}
+
+int
+main(int  argc,
+     char *argv[])
+{
+  unsigned int  i, num, min_length, max_length;
+  char          **sequences, **structures, *structure;
+  float         *energies, *energies_ref;
+  double        t0, mfe;
+  vrna_md_t     md;
+
+  num         = (argc > 1) ? (unsigned int)atoi(argv[1]) : 100000;
+  min_length  = (argc > 2) ? (unsigned int)atoi(argv[2]) : 20;
+  max_length  = (argc > 3) ? (unsigned int)atoi(argv[3]) : 30;
+
+  vrna_init_rand_seed(42);
+
+  sequences     = (char **)vrna_alloc(sizeof(char *) * (num + 1));
+  energies      = (float *)vrna_alloc(sizeof(float) * num);
+  energies_ref  = (float *)vrna_alloc(sizeof(float) * num);
+  structures    = (char **)vrna_alloc(sizeof(char *) * num);
+  structure     = (char *)vrna_alloc(sizeof(char) * (max_length + 1));
+
+  for (i = 0; i < num; i++)
+    sequences[i] = vrna_random_string(vrna_int_urn(min_length, max_length), "ACGU");
+
+  printf("# %u sequences of length %u-%u\n# method\ttime [s]\tsequences/s\tidentical\n",
+         num,
+         min_length,
+         max_length);
+
+  vrna_md_set_default(&md);
+
+  /* MFE */
+  t0 = wall_time();
+  for (i = 0; i < num; i++) {
+    vrna_fold_compound_t *fc = vrna_fold_compound(sequences[i], &md, VRNA_OPTION_DEFAULT);
+    energies_ref[i] = vrna_mfe(fc, structure);
+    vrna_fold_compound_free(fc);
+  }
+  report("mfe (single)", num, wall_time() - t0, energies_ref, energies_ref);
+
+  /* with structures, every sequence is processed on its own */
+  md.threads  = 1;
+  t0          = wall_time();
+  vrna_mfe_batch((const char **)sequences, &md, energies, structures);
+  report("mfe+mfs (batch, 1 thread)", num, wall_time() - t0, energies, energies_ref);
+
+  for (i = 0; i < num; i++)
+    free(structures[i]);
+
+  /* energies only, equal-length sequences are processed in lanes */
+  t0 = wall_time();
+  vrna_mfe_batch((const char **)sequences, &md, energies, NULL);
+  report("mfe (batch, 1 thread)", num, wall_time() - t0, energies, energies_ref);
+
+  md.threads  = 0;
+  t0          = wall_time();
+  vrna_mfe_batch((const char **)sequences, &md, energies, NULL);
+  report("mfe (batch, all threads)", num, wall_time() - t0, energies, energies_ref);
+
+  /* partition function */
+  vrna_md_set_default(&md);
+  md.backtrack    = 0;
+  md.compute_bpp  = 0;
+
+  t0 = wall_time();
+  for (i = 0; i < num; i++) {
+    vrna_fold_compound_t *fc = vrna_fold_compound(sequences[i], &md, VRNA_OPTION_DEFAULT);
+    mfe             = (double)vrna_mfe(fc, NULL);
+    vrna_exp_params_rescale(fc, &mfe);
+    energies_ref[i] = vrna_pf(fc, NULL);
+    vrna_fold_compound_free(fc);
+  }
+  report("pf (single)", num, wall_time() - t0, energies_ref, energies_ref);
+
+  md.threads  = 1;
+  t0          = wall_time();
+  vrna_pf_batch((const char **)sequences, &md, energies, NULL);
+  report("pf (batch, 1 thread)", num, wall_time() - t0, energies, energies_ref);
+
+  md.threads  = 0;
+  t0          = wall_time();
+  vrna_pf_batch((const char **)sequences, &md, energies, NULL);
+  report("pf (batch, all threads)", num, wall_time() - t0, energies, energies_ref);
+
+  for (i = 0; i < num; i++)
+    free(sequences[i]);
+
+  free(sequences);
+  free(structures);
+  free(energies);
+  free(energies_ref);
+  free(structure);
+
+  return 0;
+}
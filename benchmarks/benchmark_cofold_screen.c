@@ -0,0 +1,143 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <ViennaRNA/model.h>
+#include <ViennaRNA/fold_compound.h>
+#include <ViennaRNA/mfe.h>
+#include <ViennaRNA/part_func.h>
+#include <ViennaRNA/part_func_co.h>
+#include <ViennaRNA/pf_multifold.h>
+#include <ViennaRNA/combinatorics.h>
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/utils/strings.h>
+
+#include "benchmark_utils.h"
+
+/*
+ *  Benchmark for an all-vs-all dimer screen of a library of strands, as
+ *  done by RNAcofold --all-vs-all. For each pair of strands A, B (including
+ *  homodimers), we compute the free energies of the dimer AB and the
+ *  monomers A and B
+ *
+ *  - with a separate vrna_pf_dimer() run for each pair, where each monomer
+ *    is re-folded as part of every dimer it participates in
+ *  - with vrna_pf_complexes_strands(), which folds each monomer once and
+ *    continues from its matrices for all dimers that start with it, using
+ *    1 to max. threads
+ *
+ *  and report the time and the maximum difference of the free energies.
+ *
+ *  Usage: benchmark_cofold_screen [strands] [length] [max. threads]
+ */
+
+int
+main(int  argc,
+     char *argv[])
+{
+  unsigned int          num_strands = (argc > 1) ? (unsigned int)atoi(argv[1]) : 20;
+  unsigned int          length      = (argc > 2) ? (unsigned int)atoi(argv[2]) : 40;
+  int                   max_threads = (argc > 3) ? atoi(argv[3]) : 8;
+  unsigned int          k, c, a, b, num_pairs, ***complexes;
+  int                   threads;
+  char                  **strands, *seq;
+  double                t0, mfe, diff, **dG, *FcAB, *FA, *FB;
+  vrna_md_t             md;
+  vrna_dimer_pf_t       AB;
+  vrna_fold_compound_t  *fc;
+
+  vrna_md_set_default(&md);
+  md.compute_bpp = 0;
+  vrna_init_rand_seed(42);
+
+  strands = (char **)vrna_alloc(sizeof(char *) * num_strands);
+
+  for (a = 0; a < num_strands; a++)
+    strands[a] = vrna_random_string(length, "ACGU");
+
+  complexes = (unsigned int ***)vrna_alloc(sizeof(unsigned int **) * 2);
+
+  for (k = 1; k <= 2; k++)
+    complexes[k - 1] = vrna_n_multichoose_k(num_strands, k);
+
+  for (num_pairs = 0; complexes[1][num_pairs]; num_pairs++);
+
+  FcAB  = (double *)vrna_alloc(sizeof(double) * num_pairs);
+  FA    = (double *)vrna_alloc(sizeof(double) * num_pairs);
+  FB    = (double *)vrna_alloc(sizeof(double) * num_pairs);
+
+  /* one dimer run per pair */
+  t0 = wall_time();
+
+  for (c = 0; c < num_pairs; c++) {
+    a   = complexes[1][c][0];
+    b   = complexes[1][c][1];
+    seq = vrna_strdup_printf("%s&%s", strands[a], strands[b]);
+    fc  = vrna_fold_compound(seq, &md, VRNA_OPTION_DEFAULT | VRNA_OPTION_PF);
+    mfe = (double)vrna_mfe(fc, NULL);
+    vrna_exp_params_rescale(fc, &mfe);
+
+    AB      = vrna_pf_dimer(fc, NULL);
+    FcAB[c] = AB.FcAB;
+    FA[c]   = AB.FA;
+    FB[c]   = AB.FB;
+
+    vrna_fold_compound_free(fc);
+    free(seq);
+  }
+
+  t0 = wall_time() - t0;
+
+  printf("# %u strands of length %u (%u dimers)\n"
+         "# method\tthreads\ttime [s]\tdimers/s\tmax. |ddG| [kcal/mol]\n"
+         "pairwise\t1\t%.3f\t%.1f\t%g\n",
+         num_strands,
+         length,
+         num_pairs,
+         t0,
+         (double)num_pairs / t0,
+         0.);
+  fflush(stdout);
+
+  for (threads = 1; threads <= max_threads; threads *= 2) {
+    md.threads = threads;
+
+    t0  = wall_time();
+    dG  = vrna_pf_complexes_strands((const char **)strands, num_strands, &md, complexes, 2);
+    t0  = wall_time() - t0;
+
+    for (diff = 0., c = 0; c < num_pairs; c++) {
+      a     = complexes[1][c][0];
+      b     = complexes[1][c][1];
+      diff  = fmax(diff, fabs(dG[1][c] - FcAB[c]));
+      diff  = fmax(diff, fabs(dG[0][a] - FA[c]));
+      diff  = fmax(diff, fabs(dG[0][b] - FB[c]));
+    }
+
+    printf("screen\t%d\t%.3f\t%.1f\t%g\n", threads, t0, (double)num_pairs / t0, diff);
+    fflush(stdout);
+
+    free(dG[0]);
+    free(dG[1]);
+    free(dG);
+  }
+
+  for (k = 1; k <= 2; k++) {
+    for (c = 0; complexes[k - 1][c]; c++)
+      free(complexes[k - 1][c]);
+
+    free(complexes[k - 1]);
+  }
+
+  for (a = 0; a < num_strands; a++)
+    free(strands[a]);
+
+  free(complexes);
+  free(strands);
+  free(FcAB);
+  free(FA);
+  free(FB);
+
+  return 0;
+}
@@ -0,0 +1,189 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/utils/strings.h>
+#include <ViennaRNA/io/file_formats.h>
+
+#include "benchmark_utils.h"
+
+/*
+ *  Benchmark for reading large multi-FASTA files. We create a file with
+ *  random transcripts (60 nucleotides per line) and read it
+ *
+ *  - line by line with vrna_file_fasta_read_record()
+ *  - with the memory mapped reader vrna_file_fasta_reader()
+ *  - with the memory mapped reader split into shards, one for each thread
+ *
+ *  For each method, the number of records, the total sequence length and
+ *  a simple checksum are reported, which must be identical.
+ *
+ *  Usage: benchmark_fasta_reader [size in MB] [max. threads]
+ */
+
+struct shard_data {
+  const char    *filename;
+  unsigned int  shard;
+  unsigned int  num_shards;
+  unsigned long records;
+  unsigned long nucleotides;
+  unsigned long checksum;
+};
+
+static unsigned long
+checksum(const char *s,
+         size_t     n)
+{
+  size_t        i;
+  unsigned long h = 0;
+
+  for (i = 0; i < n; i++)
+    h = 31 * h + (unsigned char)s[i];
+
+  return h;
+}
+
+static void *
+read_shard(void *arg)
+{
+  struct shard_data   *d = (struct shard_data *)arg;
+  vrna_fasta_reader_t reader;
+  vrna_fasta_record_t record;
+
+  reader = vrna_file_fasta_reader(d->filename, d->shard, d->num_shards, VRNA_INPUT_NO_REST);
+
+  while (!(vrna_file_fasta_reader_next(reader, &record) & (VRNA_INPUT_ERROR | VRNA_INPUT_QUIT))) {
+    d->records++;
+    d->nucleotides  += record.length;
+    d->checksum     += checksum(record.sequence, record.length);
+  }
+
+  vrna_file_fasta_reader_free(reader);
+
+  return NULL;
+}
+
+static size_t
+create_input(const char *filename,
+             size_t     size)
+{
+  FILE          *fp;
+  char          *seq;
+  size_t        written;
+  unsigned int  n, i, l;
+
+  fp      = fopen(filename, "w");
+  written = 0;
+
+  vrna_init_rand_seed(42);
+
+  for (n = 0; written < size; n++) {
+    l       = 200 + (unsigned int)(vrna_urn() * 4800);
+    seq     = vrna_random_string(l, "ACGU");
+    written += fprintf(fp, ">transcript_%u length=%u\n", n, l);
+
+    for (i = 0; i < l; i += 60)
+      written += fprintf(fp, "%.*s\n", (int)((l - i < 60) ? l - i : 60), seq + i);
+
+    free(seq);
+  }
+
+  fclose(fp);
+
+  return written;
+}
+
+int
+main(int  argc,
+     char *argv[])
+{
+  size_t              size        = (size_t)((argc > 1) ? atoi(argv[1]) : 256) << 20;
+  unsigned int        max_threads = (argc > 2) ? (unsigned int)atoi(argv[2]) : 8;
+  unsigned int        threads, t;
+  unsigned long       records, nucleotides, sum;
+  char                filename[] = "/tmp/benchmark_fasta_readerXXXXXX";
+  char                *id, *seq, **rest;
+  int                 fd, i;
+  double              t0;
+  FILE                *fp;
+  pthread_t           *tid;
+  struct shard_data   *sd;
+
+  if ((fd = mkstemp(filename)) < 0)
+    vrna_message_error("Unable to create temporary file");
+
+  close(fd);
+
+  size = create_input(filename, size);
+
+  printf("# %.1f MB input\n"
+         "# method\tthreads\ttime [s]\tMB/s\trecords\tnucleotides\tchecksum\n",
+         (double)size / (1 << 20));
+
+  /* line by line */
+  records = nucleotides = sum = 0;
+  fp      = fopen(filename, "r");
+  t0      = wall_time();
+
+  while (!(vrna_file_fasta_read_record(&id, &seq, &rest, fp, VRNA_INPUT_NO_REST) &
+           (VRNA_INPUT_ERROR | VRNA_INPUT_QUIT))) {
+    records++;
+    nucleotides += strlen(seq);
+    sum         += checksum(seq, strlen(seq));
+
+    for (i = 0; rest[i]; i++)
+      free(rest[i]);
+
+    free(rest);
+    free(id);
+    free(seq);
+  }
+
+  t0 = wall_time() - t0;
+  fclose(fp);
+
+  printf("stream\t1\t%.3f\t%.1f\t%lu\t%lu\t%lx\n",
+         t0, (double)size / (1 << 20) / t0, records, nucleotides, sum);
+  fflush(stdout);
+
+  /* memory mapped, split into shards */
+  tid = (pthread_t *)vrna_alloc(sizeof(pthread_t) * max_threads);
+  sd  = (struct shard_data *)vrna_alloc(sizeof(struct shard_data) * max_threads);
+
+  for (threads = 1; threads <= max_threads; threads *= 2) {
+    memset(sd, 0, sizeof(struct shard_data) * threads);
+
+    t0 = wall_time();
+
+    for (t = 0; t < threads; t++) {
+      sd[t].filename    = filename;
+      sd[t].shard       = t;
+      sd[t].num_shards  = threads;
+      pthread_create(tid + t, NULL, &read_shard, (void *)(sd + t));
+    }
+
+    for (t = 0; t < threads; t++)
+      pthread_join(tid[t], NULL);
+
+    t0 = wall_time() - t0;
+
+    for (records = nucleotides = sum = 0, t = 0; t < threads; t++) {
+      records     += sd[t].records;
+      nucleotides += sd[t].nucleotides;
+      sum         += sd[t].checksum;
+    }
+
+    printf("mapped\t%u\t%.3f\t%.1f\t%lu\t%lu\t%lx\n",
+           threads, t0, (double)size / (1 << 20) / t0, records, nucleotides, sum);
+    fflush(stdout);
+  }
+
+  free(tid);
+  free(sd);
+  unlink(filename);
+
+  return 0;
+}
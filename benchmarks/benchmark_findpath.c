@@ -0,0 +1,82 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ViennaRNA/model.h>
+#include <ViennaRNA/fold_compound.h>
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/utils/strings.h>
+#include <ViennaRNA/utils/structures.h>
+#include <ViennaRNA/constraints/basic.h>
+#include <ViennaRNA/mfe.h>
+#include <ViennaRNA/landscape/findpath.h>
+
+#include "benchmark_utils.h"
+
+/*
+ *  Benchmark for the direct refolding path heuristic (findpath) with
+ *  increasing search width. The path connects the MFE structure of a
+ *  random sequence with the MFE structure obtained when the 5' third
+ *  of the sequence is forced to remain unpaired
+ *
+ *  Usage: benchmark_findpath [length] [max. width]
+ */
+
+int
+main(int  argc,
+     char *argv[])
+{
+  int                   length    = (argc > 1) ? atoi(argv[1]) : 500;
+  int                   max_width = (argc > 2) ? atoi(argv[2]) : 10000;
+  int                   width, saddle;
+  char                  *sequence, *s1, *s2, *constraint;
+  double                t;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+
+  vrna_init_rand_seed(42);
+
+  sequence    = vrna_random_string(length, "ACGU");
+  s1          = (char *)vrna_alloc(sizeof(char) * (length + 1));
+  s2          = (char *)vrna_alloc(sizeof(char) * (length + 1));
+  constraint  = (char *)vrna_alloc(sizeof(char) * (length + 1));
+
+  vrna_md_set_default(&md);
+
+  /* start and target structure */
+  fc = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+  (void)vrna_mfe(fc, s2);
+  vrna_fold_compound_free(fc);
+
+  memset(constraint, '.', length);
+  memset(constraint, 'x', length / 3);
+
+  fc = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+  vrna_constraints_add(fc, constraint, VRNA_CONSTRAINT_DB_DEFAULT);
+  (void)vrna_mfe(fc, s1);
+  vrna_fold_compound_free(fc);
+
+  fc = vrna_fold_compound(sequence, &md, VRNA_OPTION_EVAL_ONLY);
+
+  printf("# length %d, base pair distance %d\n"
+         "# width\ttime [s]\tsaddle [kcal/mol]\n",
+         length,
+         vrna_bp_distance(s1, s2));
+
+  for (width = 10; width <= max_width; width *= 10) {
+    t       = wall_time();
+    saddle  = vrna_path_findpath_saddle(fc, s1, s2, width);
+    t       = wall_time() - t;
+
+    printf("%d\t%.3f\t%6.2f\n", width, t, (double)saddle / 100.);
+    fflush(stdout);
+  }
+
+  vrna_fold_compound_free(fc);
+  free(sequence);
+  free(s1);
+  free(s2);
+  free(constraint);
+
+  return 0;
+}
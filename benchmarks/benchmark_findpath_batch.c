@@ -0,0 +1,136 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ViennaRNA/model.h>
+#include <ViennaRNA/fold_compound.h>
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/utils/strings.h>
+#include <ViennaRNA/subopt.h>
+#include <ViennaRNA/landscape/findpath.h>
+
+#include "benchmark_utils.h"
+
+/*
+ *  Benchmark for batches of direct refolding paths (findpath). The
+ *  suboptimal structures of a random sequence are connected pairwise
+ *  and the saddle point energies are computed
+ *
+ *  - one pair after another with vrna_path_findpath_saddle()
+ *  - all pairs at once with vrna_path_findpath_batch()
+ *
+ *  for an increasing number of threads
+ *
+ *  Usage: benchmark_findpath_batch [length] [number of structures] [width] [max. threads]
+ */
+
+typedef struct {
+  char          **structures;
+  unsigned int  num;
+  unsigned int  max;
+} structure_list;
+
+static void
+store_structure(const char  *structure,
+                float       energy,
+                void        *data)
+{
+  structure_list *l = (structure_list *)data;
+
+  if ((structure) && (l->num < l->max))
+    l->structures[l->num++] = strdup(structure);
+}
+
+int
+main(int  argc,
+     char *argv[])
+{
+  int                   length      = (argc > 1) ? atoi(argv[1]) : 200;
+  int                   num         = (argc > 2) ? atoi(argv[2]) : 200;
+  int                   width       = (argc > 3) ? atoi(argv[3]) : 10;
+  int                   max_threads = (argc > 4) ? atoi(argv[4]) : 8;
+  int                   threads, *saddles, delta;
+  char                  *sequence;
+  const char            **s1, **s2;
+  unsigned int          i, n;
+  double                t;
+  structure_list        l;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+
+  vrna_init_rand_seed(42);
+
+  sequence      = vrna_random_string(length, "ACGU");
+  l.structures  = (char **)vrna_alloc(sizeof(char *) * num);
+  l.num         = 0;
+  l.max         = num;
+
+  vrna_md_set_default(&md);
+  md.uniq_ML = 1;
+
+  /* collect (at least) the requested number of suboptimal structures */
+  fc = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+  for (delta = 100; (l.num < l.max) && (delta <= 2000); delta += 100) {
+    while (l.num > 0)
+      free(l.structures[--l.num]);
+
+    vrna_subopt_cb(fc, delta, store_structure, (void *)&l);
+  }
+  vrna_fold_compound_free(fc);
+
+  /* connect the i-th structure with the i-th structure from the end */
+  n       = l.num / 2;
+  s1      = (const char **)vrna_alloc(sizeof(char *) * (n + 1));
+  s2      = (const char **)vrna_alloc(sizeof(char *) * (n + 1));
+  saddles = (int *)vrna_alloc(sizeof(int) * (n + 1));
+
+  for (i = 0; i < n; i++) {
+    s1[i] = l.structures[i];
+    s2[i] = l.structures[l.num - 1 - i];
+  }
+
+  printf("# length %d, %u pairs, width %d\n"
+         "# threads\tmethod\ttime [s]\tpairs/s\n",
+         length,
+         n,
+         width);
+
+  md.uniq_ML  = 0;
+  md.threads  = 1;
+  fc          = vrna_fold_compound(sequence, &md, VRNA_OPTION_EVAL_ONLY);
+
+  t = wall_time();
+  for (i = 0; i < n; i++)
+    saddles[i] = vrna_path_findpath_saddle(fc, s1[i], s2[i], width);
+  t = wall_time() - t;
+
+  printf("1\tsingle\t%.3f\t%.1f\n", t, (t > 0.) ? (double)n / t : 0.);
+  fflush(stdout);
+
+  vrna_fold_compound_free(fc);
+
+  for (threads = 1; threads <= max_threads; threads *= 2) {
+    md.threads  = threads;
+    fc          = vrna_fold_compound(sequence, &md, VRNA_OPTION_EVAL_ONLY);
+
+    t = wall_time();
+    (void)vrna_path_findpath_batch(fc, s1, s2, n, width, saddles, NULL);
+    t = wall_time() - t;
+
+    printf("%d\tbatch\t%.3f\t%.1f\n", threads, t, (t > 0.) ? (double)n / t : 0.);
+    fflush(stdout);
+
+    vrna_fold_compound_free(fc);
+  }
+
+  for (i = 0; i < l.num; i++)
+    free(l.structures[i]);
+
+  free(l.structures);
+  free(s1);
+  free(s2);
+  free(saddles);
+  free(sequence);
+
+  return 0;
+}
@@ -0,0 +1,88 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#include <ViennaRNA/params/constants.h>
+#include <ViennaRNA/model.h>
+#include <ViennaRNA/fold_compound.h>
+#include <ViennaRNA/heat_capacity.h>
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/utils/strings.h>
+
+#include "benchmark_utils.h"
+
+/*
+ *  Benchmark for heat capacity curves of single sequences, as computed
+ *  by RNAheat with default settings, i.e. from 0 to 100 degrees Celsius
+ *  in steps of 1 degree and 2 interpolation points. For random sequences
+ *  of increasing length, the partition functions for all temperatures are
+ *  computed with an increasing number of threads. The maximum absolute
+ *  deviation of the heat capacities from those of the single threaded
+ *  computation is reported as well.
+ *
+ *  Usage: benchmark_heat_capacity [max. length] [max. threads]
+ */
+
+int
+main(int  argc,
+     char *argv[])
+{
+  int                   max_length  = (argc > 1) ? atoi(argv[1]) : 800;
+  int                   max_threads = (argc > 2) ? atoi(argv[2]) : 8;
+  int                   length, threads, i, l;
+  int                   lengths[] = {
+    100, 200, 400, 800, 0
+  };
+  char                  *sequence;
+  double                t, t_serial, diff;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+  vrna_heat_capacity_t  *hc, *hc_serial;
+
+  printf("# length\tthreads\ttime [s]\tspeedup\tmax. deviation\n");
+
+  for (l = 0; (length = lengths[l]) && (length <= max_length); l++) {
+    vrna_init_rand_seed(length);
+
+    sequence  = vrna_random_string(length, "ACGU");
+    hc_serial = NULL;
+    t_serial  = 0.;
+
+    for (threads = 1; threads <= max_threads; threads *= 2) {
+      vrna_md_set_default(&md);
+      md.threads = threads;
+
+      fc = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+
+      t   = wall_time();
+      hc  = vrna_heat_capacity(fc, 0., 100., 1., 2);
+      t   = wall_time() - t;
+
+      if (threads == 1) {
+        hc_serial = hc;
+        t_serial  = t;
+      }
+
+      for (diff = 0., i = 0; hc[i].temperature >= -K0; i++)
+        diff = MAX2(diff, fabs(hc[i].heat_capacity - hc_serial[i].heat_capacity));
+
+      printf("%d\t%d\t%.3f\t%.2f\t%g\n",
+             length,
+             threads,
+             t,
+             t_serial / t,
+             diff);
+      fflush(stdout);
+
+      if (hc != hc_serial)
+        free(hc);
+
+      vrna_fold_compound_free(fc);
+    }
+
+    free(hc_serial);
+    free(sequence);
+  }
+
+  return 0;
+}
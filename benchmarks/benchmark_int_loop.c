@@ -0,0 +1,106 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ViennaRNA/model.h>
+#include <ViennaRNA/fold_compound.h>
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/utils/strings.h>
+#include <ViennaRNA/utils/higher_order_functions.h>
+#include <ViennaRNA/mfe.h>
+
+#include "benchmark_utils.h"
+
+/*
+ *  Micro benchmark for the interior loop kernel of the MFE fill, comparing
+ *  the scalar implementation against the SIMD variant selected at run time
+ *
+ *  Usage: benchmark_int_loop [sequence length] [number of sequences]
+ */
+
+static double
+fill(char         **sequences,
+     unsigned int num,
+     vrna_md_t    *md,
+     float        *energies,
+     int          **c)
+{
+  unsigned int          i, n;
+  double                t0, t;
+  vrna_fold_compound_t  *fc;
+
+  t = 0.;
+
+  for (i = 0; i < num; i++) {
+    fc  = vrna_fold_compound(sequences[i], md, VRNA_OPTION_DEFAULT);
+    n   = fc->length;
+
+    t0          = wall_time();
+    energies[i] = vrna_mfe(fc, NULL);
+    t           += wall_time() - t0;
+
+    if (!c[i]) {
+      c[i] = (int *)vrna_alloc(sizeof(int) * ((n * (n + 1)) / 2 + 2));
+      memcpy(c[i], fc->matrices->c, sizeof(int) * ((n * (n + 1)) / 2 + 2));
+    } else if (memcmp(c[i], fc->matrices->c, sizeof(int) * ((n * (n + 1)) / 2 + 2)) != 0) {
+      energies[i] = (float)INF;
+    }
+
+    vrna_fold_compound_free(fc);
+  }
+
+  return t;
+}
+
+int
+main(int  argc,
+     char *argv[])
+{
+  unsigned int  i, length, num;
+  char          **sequences;
+  int           **c;
+  float         *e_scalar, *e_simd;
+  double        t_scalar, t_simd;
+  vrna_md_t     md;
+
+  length  = (argc > 1) ? (unsigned int)atoi(argv[1]) : 1000;
+  num     = (argc > 2) ? (unsigned int)atoi(argv[2]) : 5;
+
+  vrna_init_rand_seed(42);
+  vrna_md_set_default(&md);
+
+  sequences = (char **)vrna_alloc(sizeof(char *) * num);
+  c         = (int **)vrna_alloc(sizeof(int *) * num);
+  e_scalar  = (float *)vrna_alloc(sizeof(float) * num);
+  e_simd    = (float *)vrna_alloc(sizeof(float) * num);
+
+  for (i = 0; i < num; i++)
+    sequences[i] = vrna_random_string(length, "ACGU");
+
+  vrna_fun_dispatch_disable();
+  t_scalar = fill(sequences, num, &md, e_scalar, c);
+
+  vrna_fun_dispatch_enable();
+  t_simd = fill(sequences, num, &md, e_simd, c);
+
+  printf("# %u sequences of length %u\n# kernel\ttime [s]\tspeedup\tidentical\n",
+         num,
+         length);
+  printf("scalar\t%.3f\t%.2f\t-\n", t_scalar, 1.);
+  printf("simd\t%.3f\t%.2f\t%s\n",
+         t_simd,
+         t_scalar / t_simd,
+         (memcmp(e_scalar, e_simd, sizeof(float) * num) == 0) ? "yes" : "no");
+
+  for (i = 0; i < num; i++) {
+    free(sequences[i]);
+    free(c[i]);
+  }
+
+  free(sequences);
+  free(c);
+  free(e_scalar);
+  free(e_simd);
+
+  return 0;
+}
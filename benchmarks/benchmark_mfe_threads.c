@@ -0,0 +1,72 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ViennaRNA/model.h>
+#include <ViennaRNA/fold_compound.h>
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/utils/strings.h>
+#include <ViennaRNA/mfe.h>
+
+#include "benchmark_utils.h"
+
+/*
+ *  Scaling benchmark for the anti-diagonal parallel MFE fill
+ *
+ *  Usage: benchmark_mfe_threads [length]
+ */
+
+int
+main(int  argc,
+     char *argv[])
+{
+  int       threads[]   = {
+    1, 2, 4, 8, 16
+  };
+  int       length      = (argc > 1) ? atoi(argv[1]) : 5000;
+  char      *seq, *structure, *structure_serial;
+  double    t0, t_serial;
+  float     mfe;
+  unsigned int i;
+  vrna_md_t md;
+
+  vrna_init_rand();
+
+  seq               = vrna_random_string(length, "ACGU");
+  structure         = (char *)vrna_alloc(sizeof(char) * (length + 1));
+  structure_serial  = (char *)vrna_alloc(sizeof(char) * (length + 1));
+  t_serial          = 0.;
+
+  printf("# length %d\n# threads\ttime [s]\tspeedup\tidentical\n", length);
+
+  for (i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
+    vrna_md_set_default(&md);
+    md.threads = threads[i];
+
+    vrna_fold_compound_t *fc = vrna_fold_compound(seq, &md, VRNA_OPTION_DEFAULT);
+
+    t0  = wall_time();
+    mfe = vrna_mfe(fc, structure);
+    t0  = wall_time() - t0;
+
+    if (threads[i] == 1) {
+      t_serial = t0;
+      strcpy(structure_serial, structure);
+    }
+
+    printf("%d\t%.3f\t%.2f\t%s\t[ %6.2f ]\n",
+           threads[i],
+           t0,
+           t_serial / t0,
+           strcmp(structure, structure_serial) ? "no" : "yes",
+           mfe);
+
+    vrna_fold_compound_free(fc);
+  }
+
+  free(seq);
+  free(structure);
+  free(structure_serial);
+
+  return 0;
+}
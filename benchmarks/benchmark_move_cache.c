@@ -0,0 +1,169 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <ViennaRNA/params/constants.h>
+#include <ViennaRNA/model.h>
+#include <ViennaRNA/fold_compound.h>
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/utils/strings.h>
+#include <ViennaRNA/utils/structures.h>
+#include <ViennaRNA/eval.h>
+#include <ViennaRNA/landscape/move.h>
+#include <ViennaRNA/landscape/neighbor.h>
+#include <ViennaRNA/landscape/walk.h>
+
+#include "benchmark_utils.h"
+
+/*
+ *  Benchmark for the evaluation of moves to neighboring structures
+ *  in kinetic simulations. For random sequences of increasing length,
+ *  we compute
+ *
+ *  - Kinfold-like stochastic trajectories, where the energy change of
+ *    all neighbors is evaluated in each step, either with
+ *    vrna_eval_move_pt() or with a loop decomposition cache
+ *    (vrna_eval_move_cache())
+ *  - gradient walks (vrna_path_gradient()) starting from the structures
+ *    the trajectories end in
+ *
+ *  Usage: benchmark_move_cache [max. length] [steps]
+ */
+
+/* Gillespie-type trajectory with Kawasaki rates */
+static unsigned long
+trajectory(vrna_fold_compound_t *fc,
+           short                *pt,
+           unsigned int         steps,
+           int                  cached,
+           unsigned long        *evaluations)
+{
+  unsigned int      s;
+  int               n, k, *dG;
+  double            kT, *rates, r, sum;
+  vrna_move_t       *neighbors;
+  vrna_loop_cache_t *cache;
+
+  kT    = (fc->params->model_details.temperature + K0) * GASCONST;
+  cache = (cached) ? vrna_loop_cache_init(fc, pt) : NULL;
+  dG    = NULL;
+  rates = NULL;
+
+  for (s = 0; s < steps; s++) {
+    neighbors = vrna_neighbors(fc, pt, VRNA_MOVESET_DEFAULT);
+
+    for (n = 0; neighbors[n].pos_5 != 0; n++);
+
+    dG    = (int *)vrna_realloc(dG, sizeof(int) * (n + 1));
+    rates = (double *)vrna_realloc(rates, sizeof(double) * (n + 1));
+
+    for (sum = 0., k = 0; k < n; k++) {
+      if (cache)
+        dG[k] = vrna_eval_move_cache(fc, cache, neighbors[k].pos_5, neighbors[k].pos_3);
+      else
+        dG[k] = vrna_eval_move_pt(fc, pt, neighbors[k].pos_5, neighbors[k].pos_3);
+
+      rates[k]  = exp(-(double)dG[k] * 10. / (2. * kT));
+      sum       += rates[k];
+    }
+
+    *evaluations += n;
+
+    r = vrna_urn() * sum;
+    for (k = 0; (k < n - 1) && ((r -= rates[k]) > 0.); k++);
+
+    vrna_move_apply(pt, &(neighbors[k]));
+    if (cache)
+      (void)vrna_loop_cache_apply(fc, cache, neighbors[k].pos_5, neighbors[k].pos_3);
+
+    free(neighbors);
+  }
+
+  vrna_loop_cache_free(cache);
+  free(dG);
+  free(rates);
+
+  return steps;
+}
+
+int
+main(int  argc,
+     char *argv[])
+{
+  int                   max_length  = (argc > 1) ? atoi(argv[1]) : 2000;
+  unsigned int          steps       = (argc > 2) ? (unsigned int)atoi(argv[2]) : 100;
+  int                   length, cached, num_moves, l;
+  int                   lengths[] = {
+    200, 500, 1000, 2000, 0
+  };
+  char                  *sequence, *structure;
+  short                 *pt, *pt_start;
+  unsigned long         evaluations;
+  double                t;
+  const char            *names[] = {
+    "plain", "cached"
+  };
+  vrna_move_t           *moves;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+
+  printf("# length\tmethod\ttime [s]\tsteps/s\tmoves/s\n");
+
+  for (l = 0; (length = lengths[l]) && (length <= max_length); l++) {
+    vrna_init_rand_seed(42);
+
+    sequence  = vrna_random_string(length, "ACGU");
+    structure = (char *)vrna_alloc(sizeof(char) * (length + 1));
+    memset(structure, '.', length);
+
+    vrna_md_set_default(&md);
+    fc        = vrna_fold_compound(sequence, &md, VRNA_OPTION_EVAL_ONLY);
+    pt_start  = vrna_ptable(structure);
+
+    for (cached = 0; cached < 2; cached++) {
+      vrna_init_rand_seed(length);
+
+      pt          = vrna_ptable_copy(pt_start);
+      evaluations = 0;
+
+      t = wall_time();
+      (void)trajectory(fc, pt, steps, cached, &evaluations);
+      t = wall_time() - t;
+
+      printf("%d\t%s\t%.3f\t%.1f\t%.0f\n",
+             length,
+             names[cached],
+             t,
+             (t > 0.) ? (double)steps / t : 0.,
+             (t > 0.) ? (double)evaluations / t : 0.);
+      fflush(stdout);
+
+      free(pt);
+    }
+
+    /* gradient walk from the last structure of the trajectory */
+    vrna_init_rand_seed(length);
+    evaluations = 0;
+    (void)trajectory(fc, pt_start, steps, 1, &evaluations);
+
+    t         = wall_time();
+    moves     = vrna_path_gradient(fc, pt_start, VRNA_MOVESET_DEFAULT);
+    t         = wall_time() - t;
+    for (num_moves = 0; moves[num_moves].pos_5 != 0; num_moves++);
+
+    printf("%d\tgradient\t%.3f\t%.1f\t-\n",
+           length,
+           t,
+           (t > 0.) ? (double)num_moves / t : 0.);
+    fflush(stdout);
+
+    free(moves);
+    free(pt_start);
+    vrna_fold_compound_free(fc);
+    free(structure);
+    free(sequence);
+  }
+
+  return 0;
+}
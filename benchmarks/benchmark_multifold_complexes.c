@@ -0,0 +1,177 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <ViennaRNA/model.h>
+#include <ViennaRNA/fold_compound.h>
+#include <ViennaRNA/mfe.h>
+#include <ViennaRNA/part_func.h>
+#include <ViennaRNA/pf_multifold.h>
+#include <ViennaRNA/combinatorics.h>
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/utils/strings.h>
+
+#include "benchmark_utils.h"
+
+/*
+ *  Benchmark for the ensemble free energies of all complexes as computed
+ *  by RNAmultifold. For a number of random strands, we compute the free
+ *  energies of all complexes up to the given size
+ *
+ *  - by predicting each non-cyclic permutation independently (MFE to
+ *    adapt the scaling factor, followed by the partition function)
+ *  - with vrna_pf_complexes(), which re-uses the matrices of permutations
+ *    that share a prefix of strands, using 1 to max. threads
+ *
+ *  and report the time and the maximum difference of the free energies.
+ *
+ *  Usage: benchmark_multifold_complexes [strands] [max. size] [length] [max. threads]
+ */
+
+int
+main(int  argc,
+     char *argv[])
+{
+  unsigned int          num_strands = (argc > 1) ? (unsigned int)atoi(argv[1]) : 3;
+  unsigned int          max_size    = (argc > 2) ? (unsigned int)atoi(argv[2]) : 4;
+  unsigned int          length      = (argc > 3) ? (unsigned int)atoi(argv[3]) : 40;
+  int                   max_threads = (argc > 4) ? atoi(argv[4]) : 8;
+  unsigned int          k, c, s, p, n, *species, *mapping, **permutations, ***complexes;
+  int                   threads;
+  size_t                num_complexes, num_permutations;
+  char                  *input, *seq, **strands;
+  double                t0, kT, mfe, F, diff, **dG, **dG_ref;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc, *fc_perm;
+
+  vrna_md_set_default(&md);
+  vrna_init_rand_seed(42);
+
+  strands = (char **)vrna_alloc(sizeof(char *) * num_strands);
+  input   = (char *)vrna_alloc(sizeof(char) * (num_strands * (length + 1)));
+
+  for (s = 0; s < num_strands; s++) {
+    strands[s] = vrna_random_string(length, "ACGU");
+    if (s > 0)
+      strcat(input, "&");
+
+    strcat(input, strands[s]);
+  }
+
+  fc  = vrna_fold_compound(input, &md, VRNA_OPTION_DEFAULT | VRNA_OPTION_PF);
+  kT  = md.betaScale * (md.temperature + K0) * GASCONST / 1000.;
+
+  complexes = (unsigned int ***)vrna_alloc(sizeof(unsigned int **) * max_size);
+  dG_ref    = (double **)vrna_alloc(sizeof(double *) * max_size);
+  species   = (unsigned int *)vrna_alloc(sizeof(unsigned int) * (max_size + 1));
+  mapping   = (unsigned int *)vrna_alloc(sizeof(unsigned int) * num_strands);
+  seq       = (char *)vrna_alloc(sizeof(char) * (max_size * (length + 1)));
+
+  num_complexes = num_permutations = 0;
+
+  /* independent predictions for each permutation */
+  t0 = wall_time();
+
+  for (k = 1; k <= max_size; k++) {
+    complexes[k - 1] = vrna_n_multichoose_k(num_strands, k);
+
+    for (c = 0; complexes[k - 1][c]; c++);
+
+    dG_ref[k - 1] = (double *)vrna_alloc(sizeof(double) * (c + 1));
+
+    for (c = 0; complexes[k - 1][c]; c++, num_complexes++) {
+      memset(species, 0, sizeof(unsigned int) * (max_size + 1));
+
+      for (n = s = 0; s < num_strands; s++) {
+        for (p = 0; p < k; p++)
+          if (complexes[k - 1][c][p] == s)
+            species[n]++;
+
+        if (species[n] > 0)
+          mapping[n++] = s;
+      }
+
+      permutations = vrna_enumerate_necklaces(species);
+
+      for (p = 0; permutations[p]; p++, num_permutations++) {
+        seq[0] = '\0';
+        for (s = 1; s <= k; s++) {
+          if (s > 1)
+            strcat(seq, "&");
+
+          strcat(seq, strands[mapping[permutations[p][s]]]);
+        }
+
+        fc_perm = vrna_fold_compound(seq, &md, VRNA_OPTION_DEFAULT | VRNA_OPTION_PF);
+        mfe     = (double)vrna_mfe(fc_perm, NULL);
+        vrna_exp_params_rescale(fc_perm, &mfe);
+        F = (double)vrna_pf(fc_perm, NULL);
+
+        dG_ref[k - 1][c] = (p == 0) ? F : vrna_pf_add(dG_ref[k - 1][c], F, kT);
+
+        vrna_fold_compound_free(fc_perm);
+        free(permutations[p]);
+      }
+
+      free(permutations);
+    }
+  }
+
+  t0 = wall_time() - t0;
+
+  printf("# %u strands of length %u, complexes up to size %u (%lu complexes, %lu permutations)\n"
+         "# method\tthreads\ttime [s]\tmax. |ddG| [kcal/mol]\n"
+         "permutations\t1\t%.3f\t%g\n",
+         num_strands,
+         length,
+         max_size,
+         (unsigned long)num_complexes,
+         (unsigned long)num_permutations,
+         t0,
+         0.);
+  fflush(stdout);
+
+  for (threads = 1; threads <= max_threads; threads *= 2) {
+    fc->params->model_details.threads = threads;
+
+    t0  = wall_time();
+    dG  = vrna_pf_complexes(fc, complexes, max_size);
+    t0  = wall_time() - t0;
+
+    for (diff = 0., k = 1; k <= max_size; k++) {
+      for (c = 0; complexes[k - 1][c]; c++)
+        if (fabs(dG[k - 1][c] - dG_ref[k - 1][c]) > diff)
+          diff = fabs(dG[k - 1][c] - dG_ref[k - 1][c]);
+
+      free(dG[k - 1]);
+    }
+
+    free(dG);
+
+    printf("complexes\t%d\t%.3f\t%g\n", threads, t0, diff);
+    fflush(stdout);
+  }
+
+  for (k = 1; k <= max_size; k++) {
+    for (c = 0; complexes[k - 1][c]; c++)
+      free(complexes[k - 1][c]);
+
+    free(complexes[k - 1]);
+    free(dG_ref[k - 1]);
+  }
+
+  for (s = 0; s < num_strands; s++)
+    free(strands[s]);
+
+  free(complexes);
+  free(dG_ref);
+  free(species);
+  free(mapping);
+  free(strands);
+  free(seq);
+  free(input);
+  vrna_fold_compound_free(fc);
+
+  return 0;
+}
@@ -0,0 +1,98 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ViennaRNA/model.h>
+#include <ViennaRNA/fold_compound.h>
+#include <ViennaRNA/dp_matrices.h>
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/utils/strings.h>
+#include <ViennaRNA/mfe.h>
+
+#include "benchmark_utils.h"
+
+/*
+ *  Benchmark for the memory layout of the MFE matrices, comparing the
+ *  default triangular layout against the blocked (tiled) layout for
+ *  increasing sequence lengths
+ *
+ *  Usage: benchmark_mx_layout [min. length] [max. length] [number of sequences]
+ */
+
+static double
+fill(char           **sequences,
+     unsigned int   num,
+     vrna_md_t      *md,
+     vrna_mx_type_e type,
+     float          *energies)
+{
+  unsigned int          i;
+  double                t0, t;
+  vrna_fold_compound_t  *fc;
+
+  t = 0.;
+
+  for (i = 0; i < num; i++) {
+    fc = vrna_fold_compound(sequences[i], md, VRNA_OPTION_DEFAULT);
+
+    if (type != VRNA_MX_DEFAULT)
+      vrna_mx_add(fc, type, VRNA_OPTION_MFE);
+
+    t0          = wall_time();
+    energies[i] = vrna_mfe(fc, NULL);
+    t           += wall_time() - t0;
+
+    vrna_fold_compound_free(fc);
+  }
+
+  return t;
+}
+
+int
+main(int  argc,
+     char *argv[])
+{
+  unsigned int  i, length, min_length, max_length, num;
+  char          **sequences;
+  float         *e_default, *e_tiled;
+  double        t_default, t_tiled;
+  vrna_md_t     md;
+
+  min_length  = (argc > 1) ? (unsigned int)atoi(argv[1]) : 1000;
+  max_length  = (argc > 2) ? (unsigned int)atoi(argv[2]) : 4000;
+  num         = (argc > 3) ? (unsigned int)atoi(argv[3]) : 2;
+
+  vrna_init_rand_seed(42);
+  vrna_md_set_default(&md);
+
+  sequences = (char **)vrna_alloc(sizeof(char *) * num);
+  e_default = (float *)vrna_alloc(sizeof(float) * num);
+  e_tiled   = (float *)vrna_alloc(sizeof(float) * num);
+
+  printf("# %u sequences per length\n# length\tdefault [s]\ttiled [s]\tspeedup\tidentical\n",
+         num);
+
+  for (length = min_length; length <= max_length; length *= 2) {
+    for (i = 0; i < num; i++)
+      sequences[i] = vrna_random_string(length, "ACGU");
+
+    t_default = fill(sequences, num, &md, VRNA_MX_DEFAULT, e_default);
+    t_tiled   = fill(sequences, num, &md, VRNA_MX_TILED, e_tiled);
+
+    printf("%u\t%.3f\t%.3f\t%.2f\t%s\n",
+           length,
+           t_default,
+           t_tiled,
+           t_default / t_tiled,
+           (memcmp(e_default, e_tiled, sizeof(float) * num) == 0) ? "yes" : "no");
+
+    for (i = 0; i < num; i++)
+      free(sequences[i]);
+  }
+
+  free(sequences);
+  free(e_default);
+  free(e_tiled);
+
+  return 0;
+}
@@ -0,0 +1,96 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#include <ViennaRNA/model.h>
+#include <ViennaRNA/fold_compound.h>
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/utils/strings.h>
+#include <ViennaRNA/part_func.h>
+#include <ViennaRNA/boltzmann_sampling.h>
+
+#include "benchmark_utils.h"
+
+/*
+ *  Benchmark for the memory requirements and throughput of
+ *  non-redundant Boltzmann sampling. Samples are drawn in rounds
+ *  until 10^4, 10^5, ... unique structures have been collected. After
+ *  each round, the growth of the peak resident set size since the
+ *  partition function has been computed is reported per sample
+ *
+ *  Usage: benchmark_nr_sampling [length] [max. number of samples]
+ */
+
+static double
+peak_rss(void)
+{
+  struct rusage u;
+
+  getrusage(RUSAGE_SELF, &u);
+
+  /* kilobytes on Linux */
+  return (double)u.ru_maxrss * 1024.;
+}
+
+int
+main(int  argc,
+     char *argv[])
+{
+  int                   length      = (argc > 1) ? atoi(argv[1]) : 300;
+  unsigned long         max_samples = (argc > 2) ? strtoul(argv[2], NULL, 10) : 10000000UL;
+  char                  *seq;
+  unsigned int          n;
+  unsigned long         target, total;
+  double                t0, t, rss0;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+  vrna_pbacktrack_mem_t nr_mem;
+
+  vrna_init_rand_seed(42);
+
+  seq = vrna_random_string(length, "ACGU");
+
+  vrna_md_set_default(&md);
+  md.uniq_ML      = 1;
+  md.compute_bpp  = 0;
+
+  fc = vrna_fold_compound(seq, &md, VRNA_OPTION_PF);
+  (void)vrna_pf(fc, NULL);
+
+  nr_mem  = NULL;
+  total   = 0;
+  rss0    = peak_rss();
+
+  printf("# length %d\n"
+         "# samples\ttime [s]\tsamples/s\tbytes/sample\n",
+         length);
+
+  for (target = 10000; target <= max_samples; target *= 10) {
+    t0  = wall_time();
+    n   = vrna_pbacktrack_resume_cb(fc,
+                                    (unsigned int)(target - total),
+                                    NULL,
+                                    NULL,
+                                    &nr_mem,
+                                    VRNA_PBACKTRACK_NON_REDUNDANT);
+    t = wall_time() - t0;
+
+    total += n;
+
+    printf("%lu\t%.3f\t%.0f\t%.1f\n",
+           total,
+           t,
+           (double)n / t,
+           (peak_rss() - rss0) / (double)total);
+
+    if (total < target)
+      break;
+  }
+
+  vrna_pbacktrack_mem_free(nr_mem);
+  vrna_fold_compound_free(fc);
+  free(seq);
+
+  return 0;
+}
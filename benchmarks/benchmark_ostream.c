@@ -0,0 +1,207 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/datastructures/stream_output.h>
+
+#include "benchmark_utils.h"
+
+/*
+ *  Benchmark for the ordered output stream with many tiny records, as
+ *  produced e.g. by RNAeval for short sequences. A number of threads
+ *  concurrently request indices and provide small strings that are written
+ *  in order to /dev/null. We compare
+ *
+ *  - a mutex protected stream that writes and flushes each record while
+ *    holding the lock (the former implementation of vrna_ostream_t)
+ *  - vrna_ostream_t where providing threads process the output
+ *  - vrna_ostream_t with a dedicated writer thread
+ *
+ *  and report the throughput and the average time threads spend in the
+ *  provide function, i.e. the lock contention.
+ *
+ *  Usage: benchmark_ostream [records] [max. threads]
+ */
+
+struct mutex_stream {
+  pthread_mutex_t mtx;
+  unsigned int    start;
+  unsigned int    size;
+  char            **data;
+  FILE            *out;
+};
+
+struct thread_data {
+  unsigned int        *next;
+  unsigned int        num_records;
+  int                 method;
+  vrna_ostream_t      stream;
+  struct mutex_stream *mstream;
+  double              time_provide;
+};
+
+static pthread_mutex_t  counter_mtx = PTHREAD_MUTEX_INITIALIZER;
+
+static void
+mutex_stream_provide(struct mutex_stream  *s,
+                     unsigned int         i,
+                     char                 *data)
+{
+  pthread_mutex_lock(&(s->mtx));
+
+  s->data[i] = data;
+
+  for (; (s->start < s->size) && (s->data[s->start]); s->start++) {
+    fputs(s->data[s->start], s->out);
+    fflush(s->out);
+    free(s->data[s->start]);
+  }
+
+  pthread_mutex_unlock(&(s->mtx));
+}
+
+static void
+write_record(void         *auxdata,
+             unsigned int i,
+             void         *data)
+{
+  fputs((char *)data, (FILE *)auxdata);
+  free(data);
+}
+
+static void
+flush_records(void *auxdata)
+{
+  fflush((FILE *)auxdata);
+}
+
+static void *
+worker(void *arg)
+{
+  struct thread_data  *d = (struct thread_data *)arg;
+  unsigned int        i;
+  char                *record;
+  double              t;
+
+  for (;;) {
+    pthread_mutex_lock(&counter_mtx);
+    i = (*(d->next))++;
+    if ((d->method > 0) &&
+        (i < d->num_records))
+      vrna_ostream_request(d->stream, i);
+
+    pthread_mutex_unlock(&counter_mtx);
+
+    if (i >= d->num_records)
+      break;
+
+    record = (char *)vrna_alloc(sizeof(char) * 32);
+    snprintf(record, 32, "%u\t%8.2f\n", i, (double)i / 100.);
+
+    t = wall_time();
+    if (d->method == 0)
+      mutex_stream_provide(d->mstream, i, record);
+    else
+      vrna_ostream_provide(d->stream, i, (void *)record);
+
+    d->time_provide += wall_time() - t;
+  }
+
+  return NULL;
+}
+
+int
+main(int  argc,
+     char *argv[])
+{
+  unsigned int        num_records = (argc > 1) ? (unsigned int)atoi(argv[1]) : 1000000;
+  unsigned int        max_threads = (argc > 2) ? (unsigned int)atoi(argv[2]) : 128;
+  unsigned int        threads, next, t, i;
+  int                 method;
+  double              t0, t_provide;
+  const char          *names[] = {
+    "mutex", "inline", "writer"
+  };
+  FILE                *out;
+  pthread_t           *tid;
+  struct thread_data  *td;
+  struct mutex_stream ms;
+
+  out = fopen("/dev/null", "w");
+  tid = (pthread_t *)vrna_alloc(sizeof(pthread_t) * max_threads);
+  td  = (struct thread_data *)vrna_alloc(sizeof(struct thread_data) * max_threads);
+
+  printf("# %u records\n"
+         "# threads\tmethod\ttime [s]\trecords/s\tavg. time in provide [ns]\n",
+         num_records);
+
+  for (threads = 1; threads <= max_threads; threads *= 2) {
+    for (method = 0; method < 3; method++) {
+      next = 0;
+
+      memset(&ms, 0, sizeof(struct mutex_stream));
+      if (method == 0) {
+        pthread_mutex_init(&(ms.mtx), NULL);
+        ms.size = num_records;
+        ms.data = (char **)vrna_alloc(sizeof(char *) * num_records);
+        ms.out  = out;
+      }
+
+      for (t = 0; t < threads; t++) {
+        td[t].next          = &next;
+        td[t].num_records   = num_records;
+        td[t].method        = method;
+        td[t].mstream       = &ms;
+        td[t].time_provide  = 0.;
+        td[t].stream        = NULL;
+      }
+
+      if (method > 0) {
+        td[0].stream = vrna_ostream_init_bounded(&write_record,
+                                                 &flush_records,
+                                                 (void *)out,
+                                                 0,
+                                                 (method == 2) ? VRNA_OSTREAM_WRITER_THREAD : 0);
+        for (t = 1; t < threads; t++)
+          td[t].stream = td[0].stream;
+      }
+
+      t0 = wall_time();
+
+      for (t = 0; t < threads; t++)
+        pthread_create(tid + t, NULL, &worker, (void *)(td + t));
+
+      for (t = 0; t < threads; t++)
+        pthread_join(tid[t], NULL);
+
+      if (method > 0)
+        vrna_ostream_free(td[0].stream);
+
+      t0 = wall_time() - t0;
+
+      for (t_provide = 0., i = 0; i < threads; i++)
+        t_provide += td[i].time_provide;
+
+      if (method == 0) {
+        pthread_mutex_destroy(&(ms.mtx));
+        free(ms.data);
+      }
+
+      printf("%u\t%s\t%.3f\t%.0f\t%.0f\n",
+             threads,
+             names[method],
+             t0,
+             (double)num_records / t0,
+             t_provide * 1e9 / (double)num_records);
+      fflush(stdout);
+    }
+  }
+
+  fclose(out);
+  free(tid);
+  free(td);
+
+  return 0;
+}
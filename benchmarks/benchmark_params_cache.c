@@ -0,0 +1,99 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ViennaRNA/model.h>
+#include <ViennaRNA/fold_compound.h>
+#include <ViennaRNA/params/basic.h>
+#include <ViennaRNA/mfe.h>
+#include <ViennaRNA/part_func.h>
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/utils/strings.h>
+
+#include "benchmark_utils.h"
+
+/*
+ *  Benchmark for the energy parameter cache in batch mode, i.e. many short
+ *  sequences folded with identical model details. For each sequence, we
+ *  create a fold compound and compute MFE and partition function, where
+ *  the cache is either emptied before each sequence (thus, all parameters
+ *  are re-scaled as before), or kept. For the latter, the hit rate of the
+ *  cache is reported as well.
+ *
+ *  Usage: benchmark_params_cache [sequences] [length]
+ */
+
+int
+main(int  argc,
+     char *argv[])
+{
+  unsigned int              num     = (argc > 1) ? (unsigned int)atoi(argv[1]) : 10000;
+  unsigned int              length  = (argc > 2) ? (unsigned int)atoi(argv[2]) : 30;
+  unsigned int              i;
+  int                       cached;
+  char                      *sequence, *structure;
+  double                    t, t_init;
+  const char                *names[] = {
+    "rescale", "cached"
+  };
+  vrna_md_t                 md;
+  vrna_fold_compound_t      *fc;
+  vrna_params_cache_stats_t stats, stats_before;
+
+  vrna_md_set_default(&md);
+
+  structure = (char *)vrna_alloc(sizeof(char) * (length + 1));
+
+  printf("# %u sequences of length %u\n"
+         "# method\ttime [s]\tinit [s]\tseq/s\thits\tmisses\tentries\tmemory [kB]\n",
+         num,
+         length);
+
+  for (cached = 0; cached < 2; cached++) {
+    vrna_init_rand_seed(42);
+    vrna_params_cache_clear();
+    vrna_params_cache_stats(&stats_before);
+
+    t_init  = 0.;
+    t       = wall_time();
+
+    for (i = 0; i < num; i++) {
+      double t0;
+
+      if (!cached)
+        vrna_params_cache_clear();
+
+      sequence  = vrna_random_string(length, "ACGU");
+      t0        = wall_time();
+      fc        = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+      vrna_params_prepare(fc, VRNA_OPTION_PF);
+      t_init    += wall_time() - t0;
+
+      (void)vrna_mfe(fc, structure);
+      vrna_exp_params_rescale(fc, NULL);
+      (void)vrna_pf(fc, NULL);
+
+      vrna_fold_compound_free(fc);
+      free(sequence);
+    }
+
+    t = wall_time() - t;
+
+    vrna_params_cache_stats(&stats);
+
+    printf("%s\t%.3f\t%.3f\t%.0f\t%lu\t%lu\t%u\t%.0f\n",
+           names[cached],
+           t,
+           t_init,
+           (double)num / t,
+           stats.hits - stats_before.hits,
+           stats.misses - stats_before.misses,
+           stats.entries,
+           (double)stats.memory / 1024.);
+    fflush(stdout);
+  }
+
+  free(structure);
+
+  return 0;
+}
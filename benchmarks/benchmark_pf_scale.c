@@ -0,0 +1,108 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ViennaRNA/model.h>
+#include <ViennaRNA/fold_compound.h>
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/utils/strings.h>
+#include <ViennaRNA/params/basic.h>
+#include <ViennaRNA/mfe.h>
+#include <ViennaRNA/part_func.h>
+
+#include "benchmark_utils.h"
+
+/*
+ *  Benchmark for the scaling of the partition function, comparing
+ *
+ *  - a single fill with a known, suitable scaling factor
+ *  - vrna_pf() with its on-the-fly calibration of the scaling factor
+ *  - the conventional approach of re-scaling with the MFE prior to vrna_pf()
+ *
+ *  for random and GC-rich sequences of increasing length
+ *
+ *  Usage: benchmark_pf_scale [min. length] [max. length]
+ */
+
+static double
+pf(const char *sequence,
+   vrna_md_t  *md,
+   int        mode,
+   double     *pf_scale,
+   double     *G)
+{
+  double                t0, mfe;
+  vrna_fold_compound_t  *fc;
+
+  t0  = wall_time();
+  fc  = vrna_fold_compound(sequence, md, (mode == 2) ? VRNA_OPTION_DEFAULT : VRNA_OPTION_PF);
+
+  switch (mode) {
+    case 0:
+      /* known scaling factor */
+      fc->exp_params->pf_scale = *pf_scale;
+      vrna_exp_params_rescale(fc, NULL);
+      break;
+
+    case 2:
+      mfe = (double)vrna_mfe(fc, NULL);
+      vrna_exp_params_rescale(fc, &mfe);
+      break;
+
+    default:
+      break;
+  }
+
+  *G        = (double)vrna_pf(fc, NULL);
+  *pf_scale = fc->exp_params->pf_scale;
+
+  vrna_fold_compound_free(fc);
+
+  return wall_time() - t0;
+}
+
+int
+main(int  argc,
+     char *argv[])
+{
+  unsigned int  length, min_length, max_length, a;
+  const char    *alphabets[] = {
+    "ACGU", "GGGCCCAU", NULL
+  };
+  char          *sequence;
+  double        pf_scale, G[3], t[3];
+  vrna_md_t     md;
+
+  min_length  = (argc > 1) ? (unsigned int)atoi(argv[1]) : 500;
+  max_length  = (argc > 2) ? (unsigned int)atoi(argv[2]) : 2000;
+
+  vrna_init_rand_seed(42);
+  vrna_md_set_default(&md);
+  md.compute_bpp = 0;
+
+  printf("# alphabet\tlength\tknown [s]\tcalibrated [s]\toverhead\tMFE rescaled [s]\tidentical\n");
+
+  for (a = 0; alphabets[a]; a++) {
+    for (length = min_length; length <= max_length; length *= 2) {
+      sequence = vrna_random_string(length, alphabets[a]);
+
+      /* calibrate first to obtain a suitable scaling factor for the reference */
+      t[1] = pf(sequence, &md, 1, &pf_scale, &G[1]);
+      t[0] = pf(sequence, &md, 0, &pf_scale, &G[0]);
+      t[2] = pf(sequence, &md, 2, &pf_scale, &G[2]);
+
+      printf("%s\t%u\t%.3f\t%.3f\t%.2f\t%.3f\t%s\n",
+             alphabets[a],
+             length,
+             t[0],
+             t[1],
+             t[1] / t[0],
+             t[2],
+             ((G[0] - G[1] < 1e-6) && (G[1] - G[0] < 1e-6)) ? "yes" : "no");
+
+      free(sequence);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,105 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ViennaRNA/model.h>
+#include <ViennaRNA/fold_compound.h>
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/utils/strings.h>
+#include <ViennaRNA/part_func_window.h>
+
+#include "benchmark_utils.h"
+
+/*
+ *  Throughput benchmark for the chunked parallel sliding window
+ *  partition function (RNAplfold) computing base pair and unpaired
+ *  probabilities. The callback computes a checksum over the entire
+ *  stream of reported data to verify that the output is identical
+ *  to the serial scan
+ *
+ *  Usage: benchmark_plfold_threads [length] [window size] [span] [ulength]
+ */
+
+static void
+checksum_cb(FLT_OR_DBL    *pr,
+            int           pr_size,
+            int           i,
+            int           max,
+            unsigned int  type,
+            void          *data)
+{
+  int           k, lo;
+  unsigned long *h = (unsigned long *)data;
+
+  lo = (type & VRNA_PROBS_WINDOW_BPP) ? i + 1 : 1;
+
+  *h = (*h * 31UL) ^ (unsigned long)i ^ ((unsigned long)type << 32);
+
+  for (k = lo; k <= pr_size; k++)
+    *h = (*h * 1099511628211UL) ^ (unsigned long)(pr[k] * 1e15);
+}
+
+int
+main(int  argc,
+     char *argv[])
+{
+  int           threads[]   = {
+    1, 2, 4, 8, 16
+  };
+  int           length      = (argc > 1) ? atoi(argv[1]) : 100000;
+  int           winsize     = (argc > 2) ? atoi(argv[2]) : 70;
+  int           span        = (argc > 3) ? atoi(argv[3]) : 70;
+  int           ulength     = (argc > 4) ? atoi(argv[4]) : 31;
+  char          *seq;
+  double        t0, t_serial;
+  unsigned int  i;
+  unsigned long h, h_serial;
+  vrna_md_t     md;
+
+  vrna_init_rand_seed(42);
+
+  seq       = vrna_random_string(length, "ACGU");
+  t_serial  = 0.;
+  h_serial  = 0;
+
+  printf("# length %d, window size %d, span %d, ulength %d\n"
+         "# threads\ttime [s]\tnt/s\tspeedup\tidentical\n",
+         length, winsize, span, ulength);
+
+  for (i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
+    vrna_md_set_default(&md);
+    md.window_size  = winsize;
+    md.max_bp_span  = span;
+    md.compute_bpp  = 1;
+    md.threads      = threads[i];
+
+    vrna_fold_compound_t *fc = vrna_fold_compound(seq, &md, VRNA_OPTION_WINDOW);
+
+    h   = 0;
+    t0  = wall_time();
+    (void)vrna_probs_window(fc,
+                            ulength,
+                            VRNA_PROBS_WINDOW_BPP | VRNA_PROBS_WINDOW_UP,
+                            &checksum_cb,
+                            (void *)&h);
+    t0 = wall_time() - t0;
+
+    if (threads[i] == 1) {
+      t_serial  = t0;
+      h_serial  = h;
+    }
+
+    printf("%d\t%.3f\t%.0f\t%.2f\t%s\n",
+           threads[i],
+           t0,
+           (double)length / t0,
+           t_serial / t0,
+           (h == h_serial) ? "yes" : "no");
+
+    vrna_fold_compound_free(fc);
+  }
+
+  free(seq);
+
+  return 0;
+}
@@ -0,0 +1,99 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ViennaRNA/model.h>
+#include <ViennaRNA/fold_compound.h>
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/utils/strings.h>
+#include <ViennaRNA/part_func.h>
+#include <ViennaRNA/boltzmann_sampling.h>
+
+#include "benchmark_utils.h"
+
+/*
+ *  Throughput benchmark for seeded parallel Boltzmann sampling. The
+ *  partition function is computed once, and the samples are then drawn
+ *  with an increasing number of threads. The callback computes a
+ *  checksum over the stream of samples to verify that the output is
+ *  identical to the single-threaded run
+ *
+ *  Usage: benchmark_sample_threads [length] [number of samples]
+ */
+
+static void
+checksum_cb(const char  *structure,
+            void        *data)
+{
+  const char    *c;
+  unsigned long *h = (unsigned long *)data;
+
+  for (c = structure; *c; c++)
+    *h = (*h * 1099511628211UL) ^ (unsigned long)*c;
+}
+
+int
+main(int  argc,
+     char *argv[])
+{
+  int                   threads[]   = {
+    1, 2, 4, 8, 16
+  };
+  int                   length      = (argc > 1) ? atoi(argv[1]) : 1000;
+  unsigned int          num_samples = (argc > 2) ? (unsigned int)atoi(argv[2]) : 10000;
+  char                  *seq;
+  double                t0, t_serial;
+  unsigned int          i;
+  unsigned long         h, h_serial;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+
+  vrna_init_rand_seed(42);
+
+  seq       = vrna_random_string(length, "ACGU");
+  t_serial  = 0.;
+  h_serial  = 0;
+
+  vrna_md_set_default(&md);
+  md.uniq_ML      = 1;
+  md.compute_bpp  = 0;
+
+  fc = vrna_fold_compound(seq, &md, VRNA_OPTION_PF);
+  (void)vrna_pf(fc, NULL);
+
+  printf("# length %d, samples %u\n"
+         "# threads\ttime [s]\tsamples/s\tspeedup\tidentical\n",
+         length, num_samples);
+
+  for (i = 0; i < sizeof(threads) / sizeof(threads[0]); i++) {
+    /* the sampling code reads the number of threads from the model details */
+    fc->exp_params->model_details.threads = threads[i];
+
+    h   = 0;
+    t0  = wall_time();
+    (void)vrna_pbacktrack_seeded_cb(fc,
+                                    num_samples,
+                                    42,
+                                    &checksum_cb,
+                                    (void *)&h,
+                                    VRNA_PBACKTRACK_DEFAULT);
+    t0 = wall_time() - t0;
+
+    if (threads[i] == 1) {
+      t_serial  = t0;
+      h_serial  = h;
+    }
+
+    printf("%d\t%.3f\t%.0f\t%.2f\t%s\n",
+           threads[i],
+           t0,
+           (double)num_samples / t0,
+           t_serial / t0,
+           (h == h_serial) ? "yes" : "no");
+  }
+
+  vrna_fold_compound_free(fc);
+  free(seq);
+
+  return 0;
+}
@@ -0,0 +1,112 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <ViennaRNA/fold.h>
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/utils/strings.h>
+#include <ViennaRNA/utils/scheduler.h>
+#include <ViennaRNA/datastructures/stream_output.h>
+
+#include "benchmark_utils.h"
+
+/*
+ *  Throughput benchmark for the task scheduler on a workload of many short
+ *  records, similar to batch processing in RNAfold --jobs
+ *
+ *  Usage: benchmark_scheduler [records] [length]
+ */
+
+struct record {
+  unsigned int    number;
+  char            *sequence;
+  vrna_ostream_t  output;
+};
+
+static void
+process_record(void *data)
+{
+  struct record *r          = (struct record *)data;
+  char          *structure  = (char *)vrna_alloc(sizeof(char) * (strlen(r->sequence) + 1));
+
+  (void)vrna_fold(r->sequence, structure);
+
+  vrna_ostream_provide(r->output, r->number, (void *)structure);
+
+  free(r->sequence);
+  free(r);
+}
+
+static void
+consume_output(void         *auxdata,
+               unsigned int i,
+               void         *data)
+{
+  unsigned long *checksum = (unsigned long *)auxdata;
+  char          *s        = (char *)data;
+
+  for (; *s; s++)
+    *checksum = *checksum * 31 + (unsigned char)(*s);
+
+  free(data);
+}
+
+int
+main(int  argc,
+     char *argv[])
+{
+  unsigned int  workers[] = {
+    1, 2, 4, 8, 16, 32, 64
+  };
+  unsigned int  i, r, num_records, length;
+  unsigned long checksum, checksum_serial;
+  double        t0;
+
+  num_records     = (argc > 1) ? (unsigned int)atoi(argv[1]) : 100000;
+  length          = (argc > 2) ? (unsigned int)atoi(argv[2]) : 50;
+  checksum_serial = 0;
+
+  printf("# %u records of length %u\n# workers\ttime [s]\trecords/s\tidentical\n",
+         num_records,
+         length);
+
+  for (i = 0; i < sizeof(workers) / sizeof(workers[0]); i++) {
+    vrna_scheduler_t  scheduler = vrna_scheduler_init(workers[i], 0);
+    vrna_ostream_t    output;
+
+    checksum  = 0;
+    output    = vrna_ostream_init(&consume_output, (void *)&checksum);
+
+    /* use the same sequences in each round */
+    vrna_init_rand_seed(42);
+
+    t0 = wall_time();
+
+    for (r = 0; r < num_records; r++) {
+      struct record *rec = (struct record *)vrna_alloc(sizeof(struct record));
+
+      rec->number   = r;
+      rec->sequence = vrna_random_string(length, "ACGU");
+      rec->output   = output;
+
+      vrna_ostream_request(output, r);
+      vrna_scheduler_submit(scheduler, &process_record, (void *)rec);
+    }
+
+    vrna_scheduler_free(scheduler);
+    vrna_ostream_free(output);
+
+    t0 = wall_time() - t0;
+
+    if (i == 0)
+      checksum_serial = checksum;
+
+    printf("%u\t%.3f\t%.0f\t%s\n",
+           workers[i],
+           t0,
+           (double)num_records / t0,
+           (checksum == checksum_serial) ? "yes" : "no");
+  }
+
+  return 0;
+}
@@ -0,0 +1,150 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include <ViennaRNA/model.h>
+#include <ViennaRNA/fold_compound.h>
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/utils/strings.h>
+#include <ViennaRNA/subopt.h>
+
+#include "benchmark_utils.h"
+
+/*
+ *  Benchmark for energy-ordered suboptimal structure generation, comparing
+ *
+ *  - vrna_subopt() that stores all structures and sorts them afterwards
+ *  - vrna_subopt_sorted_cb() that generates the structures in ascending order
+ *  - vrna_subopt_sorted_cb() with a memory limit
+ *
+ *  for a random sequence and increasing energy bands. Each run is executed
+ *  in a separate process to obtain its peak resident set size
+ *
+ *  Usage: benchmark_subopt_sorted [length] [max. delta in dcal/mol] [memory limit in MB]
+ */
+
+typedef struct {
+  double        time;
+  double        rss;
+  unsigned long num;
+  int           delta;
+} result;
+
+static void
+count_structure(const char  *structure,
+                float       energy,
+                void        *data)
+{
+  if (structure)
+    (*((unsigned long *)data))++;
+}
+
+static void
+run(const char  *sequence,
+    int         delta,
+    int         mode,
+    size_t      max_memory,
+    result      *r)
+{
+  int                     fd[2];
+  double                  t0;
+  struct rusage           u;
+  vrna_md_t               md;
+  vrna_fold_compound_t    *fc;
+  vrna_subopt_solution_t  *sol, *s;
+
+  memset(r, 0, sizeof(result));
+
+  if (pipe(fd))
+    return;
+
+  fflush(stdout);
+
+  if (fork() == 0) {
+    close(fd[0]);
+
+    vrna_md_set_default(&md);
+    md.uniq_ML = 1;
+
+    fc        = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+    t0        = wall_time();
+    r->delta  = delta;
+
+    if (mode == 0) {
+      sol = vrna_subopt(fc, delta, VRNA_SORT_BY_ENERGY_ASC, NULL);
+      for (s = sol; s->structure; s++, r->num++)
+        free(s->structure);
+
+      free(sol);
+    } else {
+      r->delta = vrna_subopt_sorted_cb(fc, delta, max_memory, count_structure, &(r->num));
+    }
+
+    r->time = wall_time() - t0;
+
+    getrusage(RUSAGE_SELF, &u);
+    /* kilobytes on Linux */
+    r->rss = (double)u.ru_maxrss / 1024.;
+
+    vrna_fold_compound_free(fc);
+
+    if (write(fd[1], r, sizeof(result)) != sizeof(result))
+      exit(EXIT_FAILURE);
+
+    exit(EXIT_SUCCESS);
+  }
+
+  close(fd[1]);
+  if (read(fd[0], r, sizeof(result)) != sizeof(result))
+    memset(r, 0, sizeof(result));
+
+  close(fd[0]);
+  wait(NULL);
+}
+
+int
+main(int  argc,
+     char *argv[])
+{
+  int         length      = (argc > 1) ? atoi(argv[1]) : 300;
+  int         max_delta   = (argc > 2) ? atoi(argv[2]) : 600;
+  size_t      max_memory  = (argc > 3) ? (size_t)atol(argv[3]) : 64;
+  int         delta, mode;
+  char        *sequence;
+  const char  *names[] = {
+    "sort", "ordered", "bounded"
+  };
+  result      r;
+
+  vrna_init_rand_seed(42);
+
+  sequence    = vrna_random_string(length, "ACGU");
+  max_memory *= 1024 * 1024;
+
+  printf("# length %d, memory limit %lu bytes\n"
+         "# delta\tmethod\tstructures\ttime [s]\tstructures/s\tpeak RSS [MB]\tcomplete delta\n",
+         length,
+         (unsigned long)max_memory);
+
+  for (delta = 100; delta <= max_delta; delta += 100) {
+    for (mode = 0; mode < 3; mode++) {
+      run(sequence, delta, mode, (mode == 2) ? max_memory : 0, &r);
+
+      printf("%d\t%s\t%lu\t%.3f\t%.0f\t%.1f\t%d\n",
+             delta,
+             names[mode],
+             r.num,
+             r.time,
+             (r.time > 0.) ? (double)r.num / r.time : 0.,
+             r.rss,
+             r.delta);
+    }
+  }
+
+  free(sequence);
+
+  return 0;
+}
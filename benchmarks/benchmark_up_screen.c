@@ -0,0 +1,214 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#include <ViennaRNA/model.h>
+#include <ViennaRNA/fold_compound.h>
+#include <ViennaRNA/fold_vars.h>
+#include <ViennaRNA/fold.h>
+#include <ViennaRNA/mfe.h>
+#include <ViennaRNA/part_func.h>
+#include <ViennaRNA/part_func_up.h>
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/utils/strings.h>
+
+#include "benchmark_utils.h"
+
+/*
+ *  Benchmark for an RNAup target screen, i.e. a single sRNA that is tested
+ *  for interactions with many mRNA UTRs. The probabilities of being unpaired
+ *  for the sRNA are computed only once. For each UTR, we compute its own
+ *  probabilities of being unpaired and the interaction with the sRNA
+ *
+ *  - serially with the global state functions pf_fold(), pf_unstru() and
+ *    pf_interact()
+ *  - with the reentrant functions vrna_pf_unstru() and vrna_pf_interact(),
+ *    where the UTRs are distributed among an increasing number of threads
+ *
+ *  For each method, the sum of the best interaction energies is reported,
+ *  which must be identical.
+ *
+ *  Usage: benchmark_up_screen [targets] [sRNA length] [max. threads]
+ */
+
+#define W 25
+
+struct screen_data {
+  char                  **targets;
+  unsigned int          num;
+  unsigned int          thread;
+  unsigned int          num_threads;
+  vrna_md_t             *md;
+  char                  *srna;
+  pu_contrib            *srna_unstr;
+  double                *dG;
+};
+
+static pu_contrib *
+unstructured(const char           *sequence,
+             vrna_md_t            *md,
+             vrna_fold_compound_t **fc_p)
+{
+  int                   w;
+  double                mfe;
+  pu_contrib            *pu;
+  vrna_fold_compound_t  *fc;
+
+  w   = (strlen(sequence) < W) ? (int)strlen(sequence) : W;
+  fc  = vrna_fold_compound(sequence, md, VRNA_OPTION_DEFAULT);
+  mfe = (double)vrna_mfe(fc, NULL);
+  vrna_exp_params_rescale(fc, &mfe);
+  (void)vrna_pf(fc, NULL);
+  pu = vrna_pf_unstru(fc, w);
+
+  *fc_p = fc;
+
+  return pu;
+}
+
+static void *
+screen_targets(void *arg)
+{
+  struct screen_data    *d = (struct screen_data *)arg;
+  unsigned int          i;
+  pu_contrib            *pu;
+  interact              *in;
+  vrna_fold_compound_t  *fc;
+
+  for (i = d->thread; i < d->num; i += d->num_threads) {
+    pu  = unstructured(d->targets[i], d->md, &fc);
+    in  = vrna_pf_interact(fc, d->srna, pu, d->srna_unstr, W, NULL, 0, 0);
+
+    d->dG[i] = in->Gikjl;
+
+    free_interact(in);
+    free_pu_contrib_struct(pu);
+    vrna_fold_compound_free(fc);
+  }
+
+  return NULL;
+}
+
+static pu_contrib *
+unstructured_legacy(char *sequence)
+{
+  int     n, w;
+  char    *structure;
+  double  mfe, kT;
+
+  n         = (int)strlen(sequence);
+  w         = (n < W) ? n : W;
+  structure = (char *)vrna_alloc(sizeof(char) * (n + 1));
+  kT        = (temperature + K0) * GASCONST / 1000.;
+
+  mfe       = (double)fold(sequence, structure);
+  pf_scale  = exp(-(1.07 * mfe) / kT / n);
+  (void)pf_fold(sequence, structure);
+  free_arrays();
+  free(structure);
+
+  return pf_unstru(sequence, w);
+}
+
+int
+main(int  argc,
+     char *argv[])
+{
+  unsigned int          num         = (argc > 1) ? (unsigned int)atoi(argv[1]) : 5000;
+  unsigned int          length      = (argc > 2) ? (unsigned int)atoi(argv[2]) : 80;
+  unsigned int          max_threads = (argc > 3) ? (unsigned int)atoi(argv[3]) : 8;
+  unsigned int          i, threads, t;
+  char                  *srna, **targets;
+  double                t0, sum, *dG;
+  pu_contrib            *srna_unstr, *pu;
+  interact              *in;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *srna_fc;
+  pthread_t             *tid;
+  struct screen_data    *sd;
+
+  vrna_init_rand_seed(42);
+
+  srna    = vrna_random_string(length, "ACGU");
+  targets = (char **)vrna_alloc(sizeof(char *) * num);
+  dG      = (double *)vrna_alloc(sizeof(double) * num);
+
+  /* UTRs of 100 - 300 nt */
+  for (i = 0; i < num; i++)
+    targets[i] = vrna_random_string(100 + (unsigned int)(vrna_urn() * 200), "ACGU");
+
+  printf("# %u targets, sRNA of length %u\n"
+         "# method\tthreads\ttime [s]\ttargets/s\tsum dG\n",
+         num,
+         length);
+
+  /* serial screen with the global state functions */
+  t0          = wall_time();
+  srna_unstr  = unstructured_legacy(srna);
+  free_pf_arrays();
+
+  for (sum = 0., i = 0; i < num; i++) {
+    pu  = unstructured_legacy(targets[i]);
+    in  = pf_interact(targets[i], srna, pu, srna_unstr, W, NULL, 0, 0);
+    sum += in->Gikjl;
+    free_interact(in);
+    free_pu_contrib_struct(pu);
+  }
+
+  t0 = wall_time() - t0;
+  free_pu_contrib_struct(srna_unstr);
+
+  printf("legacy\t1\t%.3f\t%.1f\t%.6f\n", t0, (double)num / t0, sum);
+  fflush(stdout);
+
+  /* reentrant screen, the sRNA data is shared by all threads */
+  set_model_details(&md);
+  md.sfact = 1.07;
+
+  tid = (pthread_t *)vrna_alloc(sizeof(pthread_t) * max_threads);
+  sd  = (struct screen_data *)vrna_alloc(sizeof(struct screen_data) * max_threads);
+
+  for (threads = 1; threads <= max_threads; threads *= 2) {
+    t0          = wall_time();
+    srna_unstr  = unstructured(srna, &md, &srna_fc);
+
+    for (t = 0; t < threads; t++) {
+      sd[t].targets     = targets;
+      sd[t].num         = num;
+      sd[t].thread      = t;
+      sd[t].num_threads = threads;
+      sd[t].md          = &md;
+      sd[t].srna        = srna;
+      sd[t].srna_unstr  = srna_unstr;
+      sd[t].dG          = dG;
+      pthread_create(tid + t, NULL, &screen_targets, (void *)(sd + t));
+    }
+
+    for (t = 0; t < threads; t++)
+      pthread_join(tid[t], NULL);
+
+    t0 = wall_time() - t0;
+
+    for (sum = 0., i = 0; i < num; i++)
+      sum += dG[i];
+
+    printf("reentrant\t%u\t%.3f\t%.1f\t%.6f\n", threads, t0, (double)num / t0, sum);
+    fflush(stdout);
+
+    free_pu_contrib_struct(srna_unstr);
+    vrna_fold_compound_free(srna_fc);
+  }
+
+  for (i = 0; i < num; i++)
+    free(targets[i]);
+
+  free(targets);
+  free(dG);
+  free(srna);
+  free(tid);
+  free(sd);
+
+  return 0;
+}
@@ -0,0 +1,22 @@
+#ifndef VIENNA_RNA_PACKAGE_BENCHMARK_UTILS_H
+#define VIENNA_RNA_PACKAGE_BENCHMARK_UTILS_H
+
+#include <time.h>
+
+/*
+ *  Helpers shared by the benchmark programs in this directory
+ */
+
+/* monotonic wall clock time in seconds */
+static inline double
+wall_time(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+
+  return (double)t.tv_sec + (double)t.tv_nsec * 1e-9;
+}
+
+
+#endif
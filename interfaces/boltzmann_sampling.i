@@ -45,6 +45,8 @@ typedef struct {} vrna_pbacktrack_mem_t;
 %feature("kwargs") vrna_fold_compound_t::pbacktrack;
 %feature("autodoc")vrna_fold_compound_t::pbacktrack_sub;
 %feature("kwargs") vrna_fold_compound_t::pbacktrack_sub;
+%feature("autodoc")vrna_fold_compound_t::pbacktrack_seeded;
+%feature("kwargs") vrna_fold_compound_t::pbacktrack_seeded;
 #endif
 
 %extend vrna_fold_compound_t {
@@ -89,6 +91,28 @@ typedef struct {} vrna_pbacktrack_mem_t;
     return str_vec;
   }
 
+  std::vector<std::string>
+  pbacktrack_seeded(unsigned int num_samples,
+                    unsigned int seed,
+                    unsigned int options = VRNA_PBACKTRACK_DEFAULT)
+  {
+    std::vector<std::string> str_vec;
+    char  **ptr, **output;
+
+    output = vrna_pbacktrack_seeded_num($self, num_samples, seed, options);
+
+    if (output) {
+      for (ptr = output; *ptr != NULL; ptr++) {
+        str_vec.push_back(std::string(*ptr));
+        free(*ptr);
+      }
+
+      free(output);
+    }
+
+    return str_vec;
+  }
+
   std::vector<std::string>
   pbacktrack5(unsigned int num_samples,
               unsigned int length,
@@ -50,6 +50,7 @@ typedef struct {
   float   saltDPXInitFact;
   float   helical_rise;
   float   backbone_length;
+  int     threads;
 } vrna_md_t;
 
 
@@ -93,7 +94,8 @@ typedef struct {
     const int     saltDPXInit     = vrna_md_defaults_saltDPXInit_get(),
     const float   saltDPXInitFact = vrna_md_defaults_saltDPXInitFact_get(),
     const float   helical_rise    = vrna_md_defaults_helical_rise_get(),
-    const float   backbone_length = vrna_md_defaults_backbone_length_get())
+    const float   backbone_length = vrna_md_defaults_backbone_length_get(),
+    const int     threads         = vrna_md_defaults_threads_get())
   {
     vrna_md_t *md       = (vrna_md_t *)vrna_alloc(sizeof(vrna_md_t));
     md->temperature     = temperature;
@@ -127,6 +129,7 @@ typedef struct {
     md->saltDPXInitFact = saltDPXInitFact;
     md->helical_rise    = helical_rise;
     md->backbone_length = backbone_length;
+    md->threads         = threads;
 
     vrna_md_update(md);
 
@@ -192,6 +195,7 @@ typedef struct {
     out << ", saltDPXInitFact: " << $self->saltDPXInitFact ;
     out << ", helical_rise: " << $self->helical_rise ;
     out << ", backbone_length: " << $self->backbone_length ;
+    out << ", threads: " << $self->threads ;
     out << " }";
 
     return std::string(out.str());
@@ -295,6 +295,34 @@ std::vector<vrna_path_t> my_get_path(std::string seq, std::string s1, std::strin
       return v;
   }
 
+#ifdef SWIGPYTHON
+%feature("autodoc") path_findpath_saddle_batch;
+%feature("kwargs") path_findpath_saddle_batch;
+#endif
+
+  std::vector<int>
+  path_findpath_saddle_batch(std::vector<std::string> s1,
+                             std::vector<std::string> s2,
+                             int                      width = 1)
+  {
+    std::vector<const char *> v1, v2;
+    std::vector<int>          saddles(std::min(s1.size(), s2.size()));
+
+    std::transform(s1.begin(), s1.end(), std::back_inserter(v1), convert_vecstring2veccharcp);
+    std::transform(s2.begin(), s2.end(), std::back_inserter(v2), convert_vecstring2veccharcp);
+
+    if (saddles.size() > 0)
+      vrna_path_findpath_batch($self,
+                               (const char **)&v1[0],
+                               (const char **)&v2[0],
+                               saddles.size(),
+                               width,
+                               &saddles[0],
+                               NULL);
+
+    return saddles;
+  }
+
 #ifdef SWIGPYTHON
 %feature("autodoc") path_direct;
 %feature("kwargs") path_direct;
@@ -20,9 +20,11 @@
 #include <float.h>    /* #defines FLT_MAX ... */
 #include "ViennaRNA/datastructures/basic.h"
 #include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/utils/cpu.h"
 #include "ViennaRNA/params/default.h"
 #include "ViennaRNA/fold_vars.h"
 #include "ViennaRNA/plotting/probabilities.h"
+#include "ViennaRNA/mfe.h"
 #include "ViennaRNA/part_func.h"
 #include "ViennaRNA/params/basic.h"
 #include "ViennaRNA/loops/all.h"
@@ -31,6 +33,12 @@
 #include "ViennaRNA/alphabet.h"
 #include "ViennaRNA/part_func_window.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define CHUNK_FACTOR  8   /* ratio between reported and re-computed sliding window iterations per chunk */
+
 /*
  #################################
  # GLOBAL VARIABLES              #
@@ -64,6 +72,35 @@ typedef struct {
   double      **pUH;
 } helper_arrays;
 
+/* a single callback invocation recorded for later replay */
+typedef struct {
+  unsigned int  type;
+  int           pr_size;
+  int           i;
+  int           max;
+  int           lo;     /* lowest index of the probability array passed to the callback */
+  size_t        start;  /* position of the recorded probabilities in the chunk buffer */
+} chunk_event;
+
+/* a chunk of the sliding window iterations processed independently of the others */
+typedef struct {
+  int                 offset;   /* position of the chunk in the full sequence minus one */
+  int                 first;    /* first sliding window iteration reported by this chunk */
+  int                 last;     /* last sliding window iteration reported by this chunk */
+  int                 j;        /* current sliding window iteration */
+  int                 overflow; /* 5' end of the segment whose partition function overflowed */
+
+  vrna_probs_window_f cb;       /* callback reported iterations are forwarded to, if any */
+  void                *data;
+
+  chunk_event   *events;
+  size_t        events_num;
+  size_t        events_max;
+  FLT_OR_DBL    *values;
+  size_t        values_num;
+  size_t        values_max;
+} window_chunk;
+
 /* soft constraint contributions function (interior-loops) */
 typedef FLT_OR_DBL (*sc_int)(vrna_fold_compound_t *,
                             int,
@@ -86,10 +123,6 @@ typedef void (*add_QI5)(FLT_OR_DBL **,
 
 #ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
 
-#ifdef _OPENMP
-#include <omp.h>
-#endif
-
 /* some backward compatibility stuff */
 PRIVATE vrna_fold_compound_t  *backward_compat_compound = NULL;
 PRIVATE int                   backward_compat           = 0;
@@ -121,6 +154,59 @@ free_helper_arrays(vrna_fold_compound_t *vc,
                    unsigned int         options);
 
 
+PRIVATE int
+probs_window(vrna_fold_compound_t *vc,
+             int                  ulength,
+             unsigned int         options,
+             vrna_probs_window_f  cb,
+             void                 *data,
+             window_chunk         *chunk);
+
+
+PRIVATE int
+probs_window_serial(vrna_fold_compound_t *vc,
+                    int                  ulength,
+                    unsigned int         options,
+                    vrna_probs_window_f  cb,
+                    void                 *data);
+
+
+PRIVATE void
+forward_chunk_callback(FLT_OR_DBL   *pr,
+                       int          pr_size,
+                       int          i,
+                       int          max,
+                       unsigned int type,
+                       void         *data);
+
+
+PRIVATE int
+rescale_window(vrna_fold_compound_t *vc,
+               int                  i,
+               int                  j);
+
+
+#ifdef _OPENMP
+PRIVATE int
+probs_window_chunked(vrna_fold_compound_t *vc,
+                     int                  ulength,
+                     unsigned int         options,
+                     vrna_probs_window_f  cb,
+                     void                 *data,
+                     int                  num_threads);
+
+
+PRIVATE void
+record_chunk_callback(FLT_OR_DBL    *pr,
+                      int           pr_size,
+                      int           i,
+                      int           max,
+                      unsigned int  type,
+                      void          *data);
+
+
+#endif
+
 PRIVATE void
 compute_probs(vrna_fold_compound_t        *vc,
               int                         j,
@@ -227,6 +313,301 @@ backward_compat_callback(FLT_OR_DBL   *pr,
                          void         *data);
 
 
+#ifdef _OPENMP
+
+/*
+ *  Process the sliding window iterations in independent chunks. Each chunk
+ *  re-computes the partition functions for a sufficiently large prefix of
+ *  the sequence on its own fold compound, such that all data it reports is
+ *  identical to what the serial scan reports in the same iterations. The
+ *  callback invocations of each chunk are recorded and replayed in order,
+ *  so the user-provided callback is never called concurrently.
+ */
+PRIVATE int
+probs_window_chunked(vrna_fold_compound_t *vc,
+                     int                  ulength,
+                     unsigned int         options,
+                     vrna_probs_window_f  cb,
+                     void                 *data,
+                     int                  num_threads)
+{
+  int       n, winSize, overlap_5, overlap_3, chunk_size, num_chunks, c, c_start, failed,
+            overflow_i, overflow_j;
+  vrna_md_t md;
+
+  n       = (int)vc->length;
+  winSize = vc->window_size;
+
+  /*
+   *  data reported in iteration j refers to windows starting at
+   *  j - 3 * winSize - MAXLOOP at the earliest, the 3' overlap keeps
+   *  the sequence end out of sight
+   */
+  overlap_5   = 4 * winSize + 2 * MAXLOOP + MAX2(ulength, 0) + 2;
+  overlap_3   = 2 * winSize + MAXLOOP + MAX2(ulength, 0) + 2;
+  chunk_size  = CHUNK_FACTOR * (overlap_5 + overlap_3);
+  num_chunks  = (n + winSize - 1 + chunk_size - 1) / chunk_size;
+
+  if (num_chunks < 2)
+    return probs_window_serial(vc, ulength, options, cb, data);
+
+  md          = vc->exp_params->model_details;
+  md.threads  = 1;
+  c_start     = 0;
+  overflow_i  = overflow_j = 0;
+
+  /*
+   *  if the partition function of a chunk overflows, all chunks from this
+   *  one onwards are processed again with a larger scaling factor
+   */
+  do {
+    failed = num_chunks;
+
+#pragma omp parallel for ordered schedule(dynamic, 1) num_threads(num_threads)
+    for (c = c_start; c < num_chunks; c++) {
+      int                   a, b, ret;
+      size_t                e;
+      char                  *sequence;
+      window_chunk          chunk;
+      chunk_event           *event;
+      vrna_fold_compound_t  *fc;
+
+      memset(&chunk, 0, sizeof(window_chunk));
+
+      chunk.first = 2 + c * chunk_size;
+      chunk.last  = (c == num_chunks - 1) ? n + winSize + 1 : chunk.first + chunk_size - 1;
+
+      a             = MAX2(1, chunk.first - overlap_5);
+      b             = (c == num_chunks - 1) ? n : MIN2(n, chunk.last + overlap_3);
+      chunk.offset  = a - 1;
+
+      sequence = vrna_alloc(sizeof(char) * (b - a + 2));
+      memcpy(sequence, vc->sequence + a - 1, sizeof(char) * (b - a + 1));
+
+      fc  = vrna_fold_compound(sequence, &md, VRNA_OPTION_PF | VRNA_OPTION_WINDOW);
+      ret = 0;
+
+      if ((fc) &&
+          (vrna_fold_compound_prepare(fc, VRNA_OPTION_PF | VRNA_OPTION_WINDOW))) {
+        /* use the same Boltzmann factors and scaling as the full sequence */
+        vrna_exp_params_subst(fc, vc->exp_params);
+        ret = probs_window(fc, ulength, options, &record_chunk_callback, (void *)&chunk, &chunk);
+      }
+
+#pragma omp ordered
+      {
+        if (c < failed) {
+          if (ret) {
+            for (e = 0; e < chunk.events_num; e++) {
+              event = chunk.events + e;
+              cb(chunk.values + event->start - event->lo,
+                 event->pr_size,
+                 event->i,
+                 event->max,
+                 event->type,
+                 data);
+            }
+          } else {
+            failed      = c;
+            overflow_i  = chunk.overflow;
+            overflow_j  = chunk.j;
+          }
+        }
+      }
+
+      vrna_fold_compound_free(fc);
+      free(sequence);
+      free(chunk.events);
+      free(chunk.values);
+    }
+
+    c_start = failed;
+  } while ((failed < num_chunks) &&
+           (overflow_i > 0) &&
+           (rescale_window(vc, overflow_i, overflow_j)));
+
+  return (failed < num_chunks) ? 0 : 1;
+}
+
+
+/* store callback data of the iterations a chunk reports, in global coordinates */
+PRIVATE void
+record_chunk_callback(FLT_OR_DBL    *pr,
+                      int           pr_size,
+                      int           i,
+                      int           max,
+                      unsigned int  type,
+                      void          *data)
+{
+  int           lo, hi, shift;
+  window_chunk  *chunk;
+  chunk_event   *event;
+
+  chunk = (window_chunk *)data;
+
+  if ((chunk->j < chunk->first) ||
+      (chunk->j > chunk->last))
+    return;
+
+  shift = chunk->offset;
+
+  if (type & VRNA_PROBS_WINDOW_BPP) {
+    lo      = i + 1;
+    hi      = pr_size;
+    pr_size += shift;
+  } else if (type & VRNA_PROBS_WINDOW_STACKP) {
+    lo  = i + 1;
+    hi  = i + pr_size - 1;
+  } else if (type & VRNA_PROBS_WINDOW_PF) {
+    lo      = i;
+    hi      = pr_size;
+    pr_size += shift;
+  } else {
+    /* unpaired probabilities are indexed by the length of the segment */
+    lo    = 0;
+    hi    = pr_size;
+    shift = 0;
+  }
+
+  if (chunk->events_num == chunk->events_max) {
+    chunk->events_max = (chunk->events_max) ? 2 * chunk->events_max : 1024;
+    chunk->events     = vrna_realloc(chunk->events, sizeof(chunk_event) * chunk->events_max);
+  }
+
+  if (hi < lo)
+    hi = lo - 1;
+
+  if (chunk->values_num + (hi - lo + 1) > chunk->values_max) {
+    chunk->values_max = MAX2(2 * chunk->values_max, chunk->values_num + (hi - lo + 1));
+    chunk->values     = vrna_realloc(chunk->values, sizeof(FLT_OR_DBL) * chunk->values_max);
+  }
+
+  event           = chunk->events + chunk->events_num++;
+  event->type     = type;
+  event->pr_size  = pr_size;
+  event->i        = i + chunk->offset;
+  event->max      = max;
+  event->lo       = lo + shift;
+  event->start    = chunk->values_num;
+
+  if (hi >= lo)
+    memcpy(chunk->values + chunk->values_num, pr + lo, sizeof(FLT_OR_DBL) * (hi - lo + 1));
+
+  chunk->values_num += hi - lo + 1;
+}
+
+
+#endif
+
+
+/*
+ *  Process all sliding window iterations at once. If the partition function
+ *  overflows, the scan is repeated with a larger scaling factor, where the
+ *  data of all iterations that have been reported already is discarded
+ */
+PRIVATE int
+probs_window_serial(vrna_fold_compound_t *vc,
+                    int                  ulength,
+                    unsigned int         options,
+                    vrna_probs_window_f  cb,
+                    void                 *data)
+{
+  int           ret;
+  window_chunk  chunk;
+
+  memset(&chunk, 0, sizeof(window_chunk));
+
+  chunk.last  = vc->length + vc->window_size + 1;
+  chunk.cb    = cb;
+  chunk.data  = data;
+
+  while (!(ret = probs_window(vc, ulength, options, &forward_chunk_callback, (void *)&chunk, &chunk))) {
+    if ((chunk.overflow == 0) ||
+        (!rescale_window(vc, chunk.overflow, chunk.j)))
+      break;
+
+    /* all iterations before the one that overflowed are complete */
+    chunk.first = chunk.j;
+  }
+
+  return ret;
+}
+
+
+/* pass callback data of the iterations that have not been reported yet */
+PRIVATE void
+forward_chunk_callback(FLT_OR_DBL   *pr,
+                       int          pr_size,
+                       int          i,
+                       int          max,
+                       unsigned int type,
+                       void         *data)
+{
+  window_chunk *chunk = (window_chunk *)data;
+
+  if (chunk->j >= chunk->first)
+    chunk->cb(pr, pr_size, i, max, type, chunk->data);
+}
+
+
+/*
+ *  Increase the scaling factor after the partition function of segment
+ *  [i:j] overflowed. As in vrna_exp_params_rescale(), the new scaling factor
+ *  is derived from the MFE, here the one of the segment. Returns whether the
+ *  scaling factor actually changed
+ */
+PRIVATE int
+rescale_window(vrna_fold_compound_t *vc,
+               int                  i,
+               int                  j)
+{
+  char                  *segment;
+  double                mfe, pf_scale;
+  vrna_md_t             md;
+  vrna_exp_param_t      *pf_params;
+  vrna_fold_compound_t  *fc;
+
+  pf_params = vc->exp_params;
+  pf_scale  = pf_params->pf_scale;
+
+  if (vc->type == VRNA_FC_TYPE_SINGLE) {
+    segment = (char *)vrna_alloc(sizeof(char) * (j - i + 2));
+    memcpy(segment, vc->sequence + i - 1, sizeof(char) * (j - i + 1));
+
+    vrna_md_copy(&md, &(pf_params->model_details));
+
+    fc = vrna_fold_compound(segment, &md, VRNA_OPTION_DEFAULT);
+
+    if (fc) {
+      mfe       = (double)vrna_mfe(fc, NULL);
+      pf_scale  = exp(-(md.sfact * mfe * 1000. / (j - i + 1)) / pf_params->kT);
+      vrna_fold_compound_free(fc);
+    }
+
+    free(segment);
+  }
+
+  if (pf_scale <= pf_params->pf_scale) {
+    vrna_message_warning("vrna_probs_window: "
+                         "overflow while computing partition function for segment q[%d,%d]\n"
+                         "use larger pf_scale",
+                         i,
+                         j);
+    return 0;
+  }
+
+  vrna_message_warning("vrna_probs_window: "
+                       "re-computing partition function with pf_scale = %g",
+                       pf_scale);
+
+  vc->exp_params            = vrna_exp_params_unshare(vc->exp_params);
+  vc->exp_params->pf_scale  = pf_scale;
+  vrna_exp_params_rescale(vc, NULL);
+
+  return 1;
+}
+
+
 PRIVATE FLT_OR_DBL
 sc_contribution(vrna_fold_compound_t  *vc,
                 int                   i,
@@ -489,6 +870,7 @@ allocate_dp_matrices(vrna_fold_compound_t *vc,
 
 PRIVATE INLINE void
 free_dp_matrices(vrna_fold_compound_t *vc,
+                 int                  j,
                  unsigned int         options)
 {
   size_t        i, n;
@@ -510,9 +892,12 @@ free_dp_matrices(vrna_fold_compound_t *vc,
   hc      = vc->hc;
   sc      = vc->sc;
 
+  /* rows that are still allocated after the sliding window reached position j */
   i = 1;
-  if (n > winSize + MAXLOOP)
-    i = n - winSize - MAXLOOP;
+  if (j > 2 * winSize + MAXLOOP + 1)
+    i = (size_t)j - (2 * winSize + MAXLOOP);
+
+  n = MIN2(n, (size_t)MAX2(j + 1, 2 * winSize + MAXLOOP + 2));
 
   for (; i <= n; i++) {
     free(pR[i] + i);
@@ -678,9 +1063,52 @@ vrna_probs_window(vrna_fold_compound_t        *vc,
                   unsigned int                options,
                   vrna_probs_window_f  cb,
                   void                        *data)
+{
+  if ((!vc) || (!cb))
+    return 0; /* failure */
+
+  if (!vrna_fold_compound_prepare(vc, VRNA_OPTION_PF | VRNA_OPTION_WINDOW)) {
+    vrna_message_warning("vrna_probs_window: "
+                         "Failed to prepare vrna_fold_compound");
+    return 0; /* failure */
+  }
+
+#ifdef _OPENMP
+  vrna_md_t *md         = &(vc->exp_params->model_details);
+  int       num_threads = vrna_cpu_threads(md->threads);
+
+  /*
+   *  split long sequences into chunks of sliding window iterations that
+   *  are processed in parallel, constraints that refer to the full
+   *  sequence require the serial scan below
+   */
+  if ((md->threads != 1) &&
+      (num_threads > 1) &&
+      (vc->type == VRNA_FC_TYPE_SINGLE) &&
+      (vc->strands == 1) &&
+      (!vc->sc) &&
+      (!vc->domains_up) &&
+      (!vc->aux_grammar) &&
+      (!vc->hc->depot) &&
+      (!vc->hc->f))
+    return probs_window_chunked(vc, ulength, options, cb, data, num_threads);
+
+#endif
+
+  return probs_window_serial(vc, ulength, options, cb, data);
+}
+
+
+PRIVATE int
+probs_window(vrna_fold_compound_t *vc,
+             int                  ulength,
+             unsigned int         options,
+             vrna_probs_window_f  cb,
+             void                 *data,
+             window_chunk         *chunk)
 {
   unsigned char       hc_decompose;
-  int                 n, i, j, k, maxl, ov, winSize, pairSize, turn;
+  int                 n, i, j, k, maxl, ov, winSize, pairSize, turn, jmax;
   FLT_OR_DBL          temp, Qmax, qbt1, **q, **qb, **qm, **qm2, **pR;
   double              max_real, *Fwindow;
   vrna_exp_param_t    *pf_params;
@@ -694,15 +1122,6 @@ vrna_probs_window(vrna_fold_compound_t        *vc,
   ov    = 0;
   Qmax  = 0;
 
-  if ((!vc) || (!cb))
-    return 0; /* failure */
-
-  if (!vrna_fold_compound_prepare(vc, VRNA_OPTION_PF | VRNA_OPTION_WINDOW)) {
-    vrna_message_warning("vrna_probs_window: "
-                         "Failed to prepare vrna_fold_compound");
-    return 0; /* failure */
-  }
-
   /* here space for initializing everything */
 
   n         = vc->length;
@@ -763,6 +1182,13 @@ vrna_probs_window(vrna_fold_compound_t        *vc,
 
   /* start recursions */
   for (j = 2; j <= n + winSize; j++) {
+    if (chunk) {
+      /* the remaining iterations are reported by the subsequent chunk */
+      chunk->j = chunk->offset + j;
+      if (chunk->j > chunk->last)
+        break;
+    }
+
     if (j <= n) {
       vrna_exp_E_ext_fast_update(vc, j, aux_mx_el);
       for (i = j - 1; i >= MAX2(1, (j - winSize + 1)); i--) {
@@ -811,15 +1237,15 @@ vrna_probs_window(vrna_fold_compound_t        *vc,
         }
 
         if (temp >= max_real) {
-          vrna_message_warning("vrna_probs_window: "
-                               "overflow while computing partition function for segment q[%d,%d]\n"
-                               "use larger pf_scale",
-                               i,
-                               j);
+          /* leave it to the caller whether to re-scale or to give up */
+          if (chunk)
+            chunk->overflow = chunk->offset + i;
 
+          free_dp_matrices(vc, j - 1, options);
           vrna_exp_E_ml_fast_free(aux_mx_ml);
           vrna_exp_E_ext_fast_free(aux_mx_el);
           free_helper_arrays(vc, ulength, &aux_arrays, options);
+          free(Fwindow);
 
           return 0; /* failure */
         }
@@ -899,35 +1325,43 @@ vrna_probs_window(vrna_fold_compound_t        *vc,
     } /* end if (do_backtrack) */
   }   /* end for j */
 
-  /* finish output */
-  if (options & VRNA_PROBS_WINDOW_UP)
-    for (j = MAX2(1, n - MAXLOOP); j <= n; j++)
-      compute_pU(vc, j, ulength, &aux_arrays, cb, data, options);
-
-  for (j = MAX2(n - winSize - MAXLOOP, 1); j <= n; j++) {
-    probability_correction(vc, j);
-    if (options & VRNA_PROBS_WINDOW_BPP) {
-      cb(pR[j],
-         MIN2(j + winSize, n),
-         j,
-         winSize,
-         VRNA_PROBS_WINDOW_BPP,
-         data);
-    }
+  /* last sliding window iteration that has been processed */
+  jmax = j - 1;
 
-    if ((options & VRNA_PROBS_WINDOW_STACKP) && j < n) {
-      int start = j;
-      if (start > 1) {
-        FLT_OR_DBL *stack_probs = compute_stack_probabilities(vc, start);
-        stack_probs -= start + 1;
-        cb(stack_probs,
-           MIN2(n - start, pairSize),
-           start,
+  /* finish output */
+  if (j > n + winSize) {
+    if (chunk)
+      chunk->j = chunk->offset + j;
+
+    if (options & VRNA_PROBS_WINDOW_UP)
+      for (j = MAX2(1, n - MAXLOOP); j <= n; j++)
+        compute_pU(vc, j, ulength, &aux_arrays, cb, data, options);
+
+    for (j = MAX2(n - winSize - MAXLOOP, 1); j <= n; j++) {
+      probability_correction(vc, j);
+      if (options & VRNA_PROBS_WINDOW_BPP) {
+        cb(pR[j],
+           MIN2(j + winSize, n),
+           j,
            winSize,
-           VRNA_PROBS_WINDOW_STACKP,
+           VRNA_PROBS_WINDOW_BPP,
            data);
-        stack_probs += start + 1;
-        free(stack_probs);
+      }
+
+      if ((options & VRNA_PROBS_WINDOW_STACKP) && j < n) {
+        int start = j;
+        if (start > 1) {
+          FLT_OR_DBL *stack_probs = compute_stack_probabilities(vc, start);
+          stack_probs -= start + 1;
+          cb(stack_probs,
+             MIN2(n - start, pairSize),
+             start,
+             winSize,
+             VRNA_PROBS_WINDOW_STACKP,
+             data);
+          stack_probs += start + 1;
+          free(stack_probs);
+        }
       }
     }
   }
@@ -940,7 +1374,7 @@ vrna_probs_window(vrna_fold_compound_t        *vc,
                          pf_params->pf_scale);
   }
 
-  free_dp_matrices(vc, options);
+  free_dp_matrices(vc, jmax, options);
   free_helper_arrays(vc, ulength, &aux_arrays, options);
 
   /* free memory occupied by auxiliary arrays for fast exterior/multibranch loops */
@@ -2190,7 +2624,7 @@ wrap_pf_foldLP(char             *sequence,
    *  default parameters but take care of re-setting it to (initialized)
    *  model details
    */
-  free(vc->exp_params);
+  vrna_exp_params_free(vc->exp_params);
   if (parameters) {
     vrna_md_copy(&(parameters->model_details), &(vc->params->model_details));
     vc->exp_params = vrna_exp_params_copy(parameters);
@@ -125,7 +125,7 @@ wrap_alifold(const char   **strings,
 
   if (parameters) {
     /* replace params if necessary */
-    free(vc->params);
+    vrna_params_free(vc->params);
     vc->params = P;
   } else {
     free(P);
@@ -206,7 +206,7 @@ update_alifold_params(void)
     v = backward_compat_compound;
 
     if (v->params)
-      free(v->params);
+      vrna_params_free(v->params);
 
     vrna_md_t md;
     set_model_details(&md);
@@ -172,11 +172,9 @@ vrna_ptypes_prepare(vrna_fold_compound_t  *fc,
           if (!fc->ptype) {
             /* temporary hack for multi-strand case */
             if (fc->strands > 1) {
-              int min_loop_size = fc->params->model_details.min_loop_size;
-              fc->params->model_details.min_loop_size = 0;
-              fc->ptype = vrna_ptypes(fc->sequence_encoding2,
-                                      &(fc->params->model_details));
-              fc->params->model_details.min_loop_size = min_loop_size;
+              vrna_md_t md = fc->params->model_details;
+              md.min_loop_size  = 0;
+              fc->ptype         = vrna_ptypes(fc->sequence_encoding2, &md);
             } else {
               fc->ptype = vrna_ptypes(fc->sequence_encoding2,
                                       &(fc->params->model_details));
@@ -204,11 +202,9 @@ vrna_ptypes_prepare(vrna_fold_compound_t  *fc,
           if (!fc->ptype) {
             /* temporary hack for multi-strand case */
             if (fc->strands > 1) {
-              int min_loop_size = fc->exp_params->model_details.min_loop_size;
-              fc->exp_params->model_details.min_loop_size = 0;
-              fc->ptype = vrna_ptypes(fc->sequence_encoding2,
-                                      &(fc->exp_params->model_details));
-              fc->exp_params->model_details.min_loop_size = min_loop_size;
+              vrna_md_t md = fc->exp_params->model_details;
+              md.min_loop_size  = 0;
+              fc->ptype         = vrna_ptypes(fc->sequence_encoding2, &md);
             } else {
               fc->ptype = vrna_ptypes(fc->sequence_encoding2, &(fc->exp_params->model_details));
             }
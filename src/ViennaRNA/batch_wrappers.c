@@ -0,0 +1,633 @@
+/*
+ * Wrappers to compute MFE and partition function for many sequences at once
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ViennaRNA/fold_compound.h"
+#include "ViennaRNA/model.h"
+#include "ViennaRNA/params/default.h"
+#include "ViennaRNA/params/basic.h"
+#include "ViennaRNA/alphabet.h"
+#include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/utils/strings.h"
+#include "ViennaRNA/utils/cpu.h"
+#include "ViennaRNA/loops/hairpin.h"
+#include "ViennaRNA/mfe.h"
+#include "ViennaRNA/part_func.h"
+
+#ifndef INLINE
+#ifdef __GNUC__
+# define INLINE inline
+#else
+# define INLINE
+#endif
+#endif
+
+/*
+ #################################
+ # PRIVATE MACROS                #
+ #################################
+ */
+
+/* number of sequences processed simultaneously by the lane-batched MFE kernels */
+#define VRNA_BATCH_LANES          8
+
+/* sequences longer than this are always processed one at a time */
+#define VRNA_BATCH_LANES_MAX_LEN  150
+
+/* generic lane operations, the SIMD variants reside in batch_wrappers_avx2.c */
+#define LV                  lanes_t
+#define LV_SET1(x)          lv_set1(x)
+#define LV_LOAD(p)          lv_load(p)
+#define LV_STORE(p, a)      lv_store((p), (a))
+#define LV_ADD(a, b)        lv_add((a), (b))
+#define LV_MIN(a, b)        lv_min((a), (b))
+#define LV_MULC(a, x)       lv_mulc((a), (x))
+#define LV_GATHER(base, i)  lv_gather((base), (i))
+#define LV_MASK_INF(a, t)   lv_mask_inf((a), (t))
+#define LANES_MFE           lanes_mfe_default
+#define LANES_SCOPE         PRIVATE
+
+/*
+ #################################
+ # PRIVATE DATA STRUCTURES       #
+ #################################
+ */
+struct batch_item {
+  unsigned int  length;
+  unsigned int  index;
+};
+
+
+/* a single sequence, or a group of equal-length sequences for the lane-batched MFE kernel */
+struct batch_job {
+  unsigned int  first;
+  unsigned int  count;
+};
+
+
+/* lanes of the generic MFE kernel */
+typedef struct {
+  int v[VRNA_BATCH_LANES];
+} lanes_t;
+
+
+/*
+ #################################
+ # PRIVATE FUNCTION DECLARATIONS #
+ #################################
+ */
+PRIVATE unsigned int
+process_batch(const char      **sequences,
+              const vrna_md_t *md_p,
+              float           *energies,
+              char            **structures,
+              unsigned int    options);
+
+
+PRIVATE int
+compare_batch_items(const void  *a,
+                    const void  *b);
+
+
+PRIVATE INLINE lanes_t
+lv_set1(int x);
+
+
+PRIVATE INLINE lanes_t
+lv_load(const int *p);
+
+
+PRIVATE INLINE void
+lv_store(int      *p,
+         lanes_t  a);
+
+
+PRIVATE INLINE lanes_t
+lv_add(lanes_t  a,
+       lanes_t  b);
+
+
+PRIVATE INLINE lanes_t
+lv_min(lanes_t  a,
+       lanes_t  b);
+
+
+PRIVATE INLINE lanes_t
+lv_mulc(lanes_t a,
+        int     x);
+
+
+PRIVATE INLINE lanes_t
+lv_gather(const int *base,
+          lanes_t   idx);
+
+
+PRIVATE INLINE lanes_t
+lv_mask_inf(lanes_t a,
+            lanes_t t);
+
+
+#include "ViennaRNA/batch_wrappers_lanes.inc"
+
+
+PRIVATE int
+lanes_supported(const vrna_md_t *md,
+                unsigned int    options,
+                char            **structures);
+
+
+PRIVATE int
+lanes_eligible(const char       *sequence,
+               unsigned int     length,
+               const vrna_md_t  *md);
+
+
+PRIVATE void
+lanes_init(struct batch_lanes *L,
+           unsigned int       n,
+           vrna_param_t       *P);
+
+
+PRIVATE void
+lanes_prepare(struct batch_lanes  *L,
+              const char          **sequences,
+              unsigned int        count);
+
+
+PRIVATE void
+lanes_free(struct batch_lanes *L);
+
+
+#if VRNA_WITH_SIMD_AVX2
+void
+vrna_batch_lanes_mfe_avx2(struct batch_lanes *L);
+
+
+#endif
+
+
+/*
+ #################################
+ # BEGIN OF FUNCTION DEFINITIONS #
+ #################################
+ */
+PUBLIC unsigned int
+vrna_mfe_batch(const char       **sequences,
+               const vrna_md_t  *md_p,
+               float            *mfe,
+               char             **structures)
+{
+  return process_batch(sequences, md_p, mfe, structures, VRNA_OPTION_MFE);
+}
+
+
+PUBLIC unsigned int
+vrna_pf_batch(const char      **sequences,
+              const vrna_md_t *md_p,
+              float           *energies,
+              char            **structures)
+{
+  return process_batch(sequences, md_p, energies, structures, VRNA_OPTION_PF);
+}
+
+
+/*
+ #################################
+ # STATIC helper functions below #
+ #################################
+ */
+PRIVATE unsigned int
+process_batch(const char      **sequences,
+              const vrna_md_t *md_p,
+              float           *energies,
+              char            **structures,
+              unsigned int    options)
+{
+  unsigned int      n, k, cnt, num_jobs, processed;
+  int               num_threads, lanes;
+  struct batch_item *items;
+  struct batch_job  *jobs;
+  vrna_md_t         md;
+  vrna_param_t      *P;
+  void              (*lanes_mfe)(struct batch_lanes *);
+
+  if ((!sequences) || (!energies))
+    return 0;
+
+  for (n = 0; sequences[n]; n++);
+
+  if (n == 0)
+    return 0;
+
+  if (md_p)
+    md = *md_p;
+  else
+    vrna_md_set_default(&md);
+
+  /* distribute the sequences over the threads, each prediction runs serially */
+  num_threads = vrna_cpu_threads(md.threads);
+  md.threads  = 1;
+
+  if (options & VRNA_OPTION_PF) {
+    /* same settings as in vrna_pf_fold() */
+    md.backtrack = 0;
+    if (!structures)
+      md.compute_bpp = 0;
+  }
+
+  /*
+   *  process sequences in order of decreasing length, such that the DP
+   *  matrices of each thread are allocated only once
+   */
+  items = (struct batch_item *)vrna_alloc(sizeof(struct batch_item) * n);
+
+  for (k = 0; k < n; k++) {
+    items[k].length = strlen(sequences[k]);
+    items[k].index  = k;
+  }
+
+  qsort(items, n, sizeof(struct batch_item), &compare_batch_items);
+
+  /*
+   *  MFE energies of equal-length sequences are computed in groups of
+   *  VRNA_BATCH_LANES by the lane-batched kernel, all other sequences
+   *  are processed one at a time
+   */
+  lanes     = lanes_supported(&md, options, structures);
+  P         = (lanes) ? vrna_params(&md) : NULL;
+  lanes_mfe = &lanes_mfe_default;
+
+#if VRNA_WITH_SIMD_AVX2
+  if (vrna_cpu_simd_capabilities() & VRNA_CPU_SIMD_AVX2)
+    lanes_mfe = &vrna_batch_lanes_mfe_avx2;
+
+#endif
+
+  jobs      = (struct batch_job *)vrna_alloc(sizeof(struct batch_job) * n);
+  num_jobs  = 0;
+
+  for (k = 0; k < n; k += cnt) {
+    cnt = 1;
+
+    if ((lanes) &&
+        (lanes_eligible(sequences[items[k].index], items[k].length, &md)))
+      while ((cnt < VRNA_BATCH_LANES) &&
+             (k + cnt < n) &&
+             (items[k + cnt].length == items[k].length) &&
+             (lanes_eligible(sequences[items[k + cnt].index], items[k + cnt].length, &md)))
+        cnt++;
+
+    jobs[num_jobs].first    = k;
+    jobs[num_jobs++].count  = cnt;
+  }
+
+  processed = 0;
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(num_threads) if (num_threads > 1) reduction(+:processed)
+#endif
+  {
+    unsigned int          i, v, job;
+    char                  *structure;
+    const char            *group[VRNA_BATCH_LANES];
+    double                mfe;
+    vrna_fold_compound_t  *fc = NULL;
+    struct batch_lanes    L;
+
+    memset(&L, 0, sizeof(struct batch_lanes));
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+    for (job = 0; job < num_jobs; job++) {
+      k = jobs[job].first;
+
+      if (jobs[job].count > 1) {
+        if (!L.P)
+          lanes_init(&L, items[k].length, P);
+
+        for (v = 0; v < jobs[job].count; v++)
+          group[v] = sequences[items[k + v].index];
+
+        lanes_prepare(&L, group, jobs[job].count);
+        (*lanes_mfe)(&L);
+
+        for (v = 0; v < jobs[job].count; v++)
+          energies[items[k + v].index] = (float)L.f5[L.n * VRNA_BATCH_LANES + v] / 100.;
+
+        processed += jobs[job].count;
+        continue;
+      }
+
+      i = items[k].index;
+
+      if ((!fc) ||
+          (!vrna_fold_compound_retarget(fc, sequences[i], &md, VRNA_OPTION_DEFAULT))) {
+        vrna_fold_compound_free(fc);
+        fc = vrna_fold_compound(sequences[i], &md, VRNA_OPTION_DEFAULT);
+      }
+
+      structure = NULL;
+
+      if (structures)
+        structures[i] = NULL;
+
+      if (!fc) {
+        energies[i] = (float)(INF / 100.);
+        continue;
+      }
+
+      if (structures)
+        structure = (char *)vrna_alloc(sizeof(char) * (items[k].length + 1));
+
+      if (options & VRNA_OPTION_PF) {
+        mfe = (double)vrna_mfe(fc, NULL);
+        vrna_exp_params_rescale(fc, &mfe);
+        energies[i] = vrna_pf(fc, structure);
+      } else {
+        energies[i] = vrna_mfe(fc, structure);
+      }
+
+      if (structures)
+        structures[i] = structure;
+
+      processed++;
+    }
+
+    vrna_fold_compound_free(fc);
+    lanes_free(&L);
+  }
+
+  free(P);
+  free(jobs);
+  free(items);
+
+  return processed;
+}
+
+
+PRIVATE int
+compare_batch_items(const void  *a,
+                    const void  *b)
+{
+  const struct batch_item *i1 = (const struct batch_item *)a;
+  const struct batch_item *i2 = (const struct batch_item *)b;
+
+  if (i1->length != i2->length)
+    return (i1->length > i2->length) ? -1 : 1;
+
+  return (i1->index > i2->index) - (i1->index < i2->index);
+}
+
+
+/*
+ *  The lane-batched kernel implements the plain MFE recursions of a
+ *  single strand, i.e. without backtracking and without any model
+ *  extension that would require a fold compound
+ */
+PRIVATE int
+lanes_supported(const vrna_md_t *md,
+                unsigned int    options,
+                char            **structures)
+{
+  if ((options & VRNA_OPTION_PF) ||
+      (structures) ||
+      ((md->dangles != 0) && (md->dangles != 2)) ||
+      (md->circ) ||
+      (md->gquad) ||
+      (md->noLP) ||
+      (md->noGUclosure) ||
+      (md->backtrack_type != 'F') ||
+      (md->salt != VRNA_MODEL_DEFAULT_SALT))
+    return 0;
+
+  return 1;
+}
+
+
+PRIVATE int
+lanes_eligible(const char       *sequence,
+               unsigned int     length,
+               const vrna_md_t  *md)
+{
+  if ((length > VRNA_BATCH_LANES_MAX_LEN) ||
+      (length <= (unsigned int)md->min_loop_size) ||
+      ((md->max_bp_span > 0) && (md->max_bp_span < (int)length)) ||
+      (strchr(sequence, '&')))
+    return 0;
+
+  return 1;
+}
+
+
+PRIVATE void
+lanes_init(struct batch_lanes *L,
+           unsigned int       n,
+           vrna_param_t       *P)
+{
+  unsigned int  t;
+  size_t        size;
+
+  /* all groups of a thread are at most as long as its first one */
+  size = sizeof(int) * (n + 2) * (n + 2) * VRNA_BATCH_LANES;
+
+  L->n      = (int)n;
+  L->P      = P;
+  L->S      = (int *)vrna_alloc(sizeof(int) * (n + 2) * VRNA_BATCH_LANES);
+  L->f5     = (int *)vrna_alloc(sizeof(int) * (n + 1) * VRNA_BATCH_LANES);
+  L->ptype  = (int *)vrna_alloc(size);
+  L->hp     = (int *)vrna_alloc(size);
+  L->c      = (int *)vrna_alloc(size);
+  L->fML    = (int *)vrna_alloc(size);
+  L->DML    = (int *)vrna_alloc(size);
+  L->cI     = (int *)vrna_alloc(size);
+  L->c1n    = (int *)vrna_alloc(size);
+  L->c23    = (int *)vrna_alloc(size);
+  L->cB     = (int *)vrna_alloc(size);
+
+  for (t = 0; t <= NBPAIRS; t++)
+    L->tAU[t] = (t > 2) ? P->TerminalAU : 0;
+}
+
+
+/*
+ *  Interleave the encodings, allowed pair types, and hairpin loop
+ *  energies of a group of equal-length sequences. Incomplete groups
+ *  are padded with copies of their first sequence.
+ */
+PRIVATE void
+lanes_prepare(struct batch_lanes  *L,
+              const char          **sequences,
+              unsigned int        count)
+{
+  char          *seq;
+  short         *S, *S2;
+  unsigned int  v;
+  int           i, j, n, type, turn, noGU;
+  size_t        ij, cells;
+  vrna_md_t     *md;
+
+  md    = &(L->P->model_details);
+  n     = (int)strlen(sequences[0]);
+  turn  = md->min_loop_size;
+  noGU  = md->noGU;
+  L->n  = n;
+  cells = (size_t)(n + 2) * (n + 2) * VRNA_BATCH_LANES;
+
+  for (ij = 0; ij < cells; ij++)
+    L->c[ij] = L->fML[ij] = L->DML[ij] = INF;
+
+  for (v = 0; v < VRNA_BATCH_LANES; v++) {
+    /* same sequence representation as in the fold compound, see vrna_sequence_add() */
+    seq = strdup(sequences[(v < count) ? v : 0]);
+    vrna_seq_toupper(seq);
+
+    S   = vrna_seq_encode(seq, md);
+    S2  = vrna_seq_encode_simple(seq, md);
+
+    for (i = 0; i <= n + 1; i++)
+      L->S[i * VRNA_BATCH_LANES + v] = S[i];
+
+    for (i = 1; i < n; i++)
+      for (j = i + 1; j <= n; j++) {
+        ij    = LANES_IDX(L, i, j) + v;
+        type  = md->pair[S2[i]][S2[j]];
+
+        if ((j - i <= turn) ||
+            ((noGU) && ((type == 3) || (type == 4))))
+          type = 0;
+
+        L->ptype[ij]  = type;
+        L->hp[ij]     = (type) ?
+                        E_Hairpin(j - i - 1, type, S[i + 1], S[j - 1], seq + i - 1, L->P) :
+                        INF;
+      }
+
+    free(S);
+    free(S2);
+    free(seq);
+  }
+}
+
+
+PRIVATE void
+lanes_free(struct batch_lanes *L)
+{
+  free(L->S);
+  free(L->f5);
+  free(L->ptype);
+  free(L->hp);
+  free(L->c);
+  free(L->fML);
+  free(L->DML);
+  free(L->cI);
+  free(L->c1n);
+  free(L->c23);
+  free(L->cB);
+}
+
+
+PRIVATE INLINE lanes_t
+lv_set1(int x)
+{
+  int     v;
+  lanes_t r;
+
+  for (v = 0; v < VRNA_BATCH_LANES; v++)
+    r.v[v] = x;
+
+  return r;
+}
+
+
+PRIVATE INLINE lanes_t
+lv_load(const int *p)
+{
+  lanes_t r;
+
+  memcpy(r.v, p, sizeof(int) * VRNA_BATCH_LANES);
+
+  return r;
+}
+
+
+PRIVATE INLINE void
+lv_store(int      *p,
+         lanes_t  a)
+{
+  memcpy(p, a.v, sizeof(int) * VRNA_BATCH_LANES);
+}
+
+
+PRIVATE INLINE lanes_t
+lv_add(lanes_t  a,
+       lanes_t  b)
+{
+  int v;
+
+  for (v = 0; v < VRNA_BATCH_LANES; v++)
+    a.v[v] += b.v[v];
+
+  return a;
+}
+
+
+PRIVATE INLINE lanes_t
+lv_min(lanes_t  a,
+       lanes_t  b)
+{
+  int v;
+
+  for (v = 0; v < VRNA_BATCH_LANES; v++)
+    a.v[v] = MIN2(a.v[v], b.v[v]);
+
+  return a;
+}
+
+
+PRIVATE INLINE lanes_t
+lv_mulc(lanes_t a,
+        int     x)
+{
+  int v;
+
+  for (v = 0; v < VRNA_BATCH_LANES; v++)
+    a.v[v] *= x;
+
+  return a;
+}
+
+
+PRIVATE INLINE lanes_t
+lv_gather(const int *base,
+          lanes_t   idx)
+{
+  int     v;
+  lanes_t r;
+
+  for (v = 0; v < VRNA_BATCH_LANES; v++)
+    r.v[v] = base[idx.v[v]];
+
+  return r;
+}
+
+
+PRIVATE INLINE lanes_t
+lv_mask_inf(lanes_t a,
+            lanes_t t)
+{
+  int v;
+
+  for (v = 0; v < VRNA_BATCH_LANES; v++)
+    a.v[v] = (t.v[v] == 0) ? INF : MIN2(a.v[v], INF);
+
+  return a;
+}
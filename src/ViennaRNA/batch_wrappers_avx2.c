@@ -0,0 +1,43 @@
+/*
+ * AVX2 variant of the lane-batched MFE kernel used by vrna_mfe_batch()
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/params/default.h"
+#include "ViennaRNA/params/basic.h"
+
+#include <immintrin.h>
+
+#ifndef INLINE
+#ifdef __GNUC__
+# define INLINE inline
+#else
+# define INLINE
+#endif
+#endif
+
+/* one 32-bit lane of a __m256i per sequence */
+#define VRNA_BATCH_LANES    8
+
+#define LV                  __m256i
+#define LV_SET1(x)          _mm256_set1_epi32(x)
+#define LV_LOAD(p)          _mm256_loadu_si256((const __m256i *)(p))
+#define LV_STORE(p, a)      _mm256_storeu_si256((__m256i *)(p), (a))
+#define LV_ADD(a, b)        _mm256_add_epi32((a), (b))
+#define LV_MIN(a, b)        _mm256_min_epi32((a), (b))
+#define LV_MULC(a, x)       _mm256_mullo_epi32((a), _mm256_set1_epi32(x))
+#define LV_GATHER(base, i)  _mm256_i32gather_epi32((const int *)(base), (i), 4)
+#define LV_MASK_INF(a, t)   _mm256_blendv_epi8(_mm256_min_epi32((a), _mm256_set1_epi32(INF)), \
+                                               _mm256_set1_epi32(INF), \
+                                               _mm256_cmpeq_epi32((t), _mm256_setzero_si256()))
+#define LANES_MFE           vrna_batch_lanes_mfe_avx2
+#define LANES_SCOPE         PUBLIC
+
+#include "ViennaRNA/batch_wrappers_lanes.inc"
@@ -14,8 +14,10 @@
 #include <string.h>
 #include <float.h>
 #include <math.h>
+#include <stdint.h>
 
 #include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/utils/cpu.h"
 #include "ViennaRNA/params/default.h"
 #include "ViennaRNA/fold_vars.h"
 #include "ViennaRNA/loops/all.h"
@@ -32,21 +34,33 @@
 
 #include "ViennaRNA/data_structures_nonred.inc"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 /*
  #################################
  # PREPROCESSOR DEFININTIONS     #
  #################################
  */
 
+#if defined(__GNUC__)
+# define INLINE inline
+#else
+# define INLINE
+#endif
+
+#define RNG_MASK  0xFFFFFFFFFFFFULL   /* random number generator state is 48 bit wide, as in erand48() */
+
 #ifdef VRNA_NR_SAMPLING_HASH
 # define NR_NODE tr_node
 # define NR_TOTAL_WEIGHT(a) total_weight_par(a)
-# define NR_TOTAL_WEIGHT_TYPE(a, b) total_weight_par_type(a, b)
+# define NR_TOTAL_WEIGHT_TYPE(m, a, b) total_weight_par_type(a, b)
 # define NR_GET_WEIGHT(a, b, c, d, e)  tr_node_weight(a, c, d, e)
 #else
 # define NR_NODE tllr_node
 # define NR_TOTAL_WEIGHT(a) get_weight_all(a)
-# define NR_TOTAL_WEIGHT_TYPE(a, b) get_weight_type_spec(a, b)
+# define NR_TOTAL_WEIGHT_TYPE(m, a, b) get_weight_type_spec(m, a, b)
 # define NR_GET_WEIGHT(a, b, c, d, e)  get_weight(b, c, d, e)
 #endif
 
@@ -55,6 +69,16 @@ struct aux_mem {
   FLT_OR_DBL *qik;
 };
 
+/*
+ * random number stream for seeded sampling, each sample is drawn with
+ * its own stream such that the result does not depend on the order in
+ * which the samples are generated
+ */
+struct bs_rng {
+  uint64_t  seed;
+  uint64_t  state;
+};
+
 /* combination of soft constraint wrappers */
 struct sc_wrappers {
   struct sc_ext_exp_dat sc_wrapper_ext;
@@ -130,6 +154,21 @@ PRIVATE void
 sc_free(struct sc_wrappers *sc_wrap);
 
 
+PRIVATE int
+check_input(vrna_fold_compound_t  *fc,
+            unsigned int          start,
+            unsigned int          end);
+
+
+PRIVATE INLINE void
+rng_stream(struct bs_rng  *rng,
+           unsigned int   sample);
+
+
+PRIVATE INLINE double
+bs_urn(struct bs_rng *rng);
+
+
 PRIVATE unsigned int
 wrap_pbacktrack(vrna_fold_compound_t              *vc,
                 unsigned int                      start,
@@ -137,7 +176,23 @@ wrap_pbacktrack(vrna_fold_compound_t              *vc,
                 unsigned int                      num_samples,
                 vrna_bs_result_f  bs_cb,
                 void                              *data,
-                struct vrna_pbacktrack_memory_s   *nr_mem);
+                struct vrna_pbacktrack_memory_s   *nr_mem,
+                struct bs_rng                     *rng);
+
+
+#ifdef _OPENMP
+PRIVATE unsigned int
+wrap_pbacktrack_parallel(vrna_fold_compound_t *vc,
+                         unsigned int         start,
+                         unsigned int         end,
+                         unsigned int         num_samples,
+                         vrna_bs_result_f     bs_cb,
+                         void                 *data,
+                         unsigned int         seed,
+                         int                  num_threads);
+
+
+#endif
 
 
 PRIVATE int
@@ -146,7 +201,8 @@ backtrack(int                             i,
           char                            *pstruc,
           vrna_fold_compound_t            *vc,
           struct sc_wrappers              *sc_wrap,
-          struct vrna_pbacktrack_memory_s *nr_mem);
+          struct vrna_pbacktrack_memory_s *nr_mem,
+          struct bs_rng                   *rng);
 
 
 PRIVATE int
@@ -156,7 +212,8 @@ backtrack_ext_loop(int                              start,
                    vrna_fold_compound_t             *vc,
                    struct aux_mem                   *helper_arrays,
                    struct sc_wrappers               *sc_wrap,
-                   struct vrna_pbacktrack_memory_s  *nr_mem);
+                   struct vrna_pbacktrack_memory_s  *nr_mem,
+                   struct bs_rng                    *rng);
 
 
 PRIVATE int
@@ -165,7 +222,8 @@ backtrack_qm(int                              i,
              char                             *pstruc,
              vrna_fold_compound_t             *vc,
              struct sc_wrappers               *sc_wrap,
-             struct vrna_pbacktrack_memory_s  *nr_mem);
+             struct vrna_pbacktrack_memory_s  *nr_mem,
+             struct bs_rng                    *rng);
 
 
 PRIVATE int
@@ -174,7 +232,8 @@ backtrack_qm1(int                             i,
               char                            *pstruc,
               vrna_fold_compound_t            *vc,
               struct sc_wrappers              *sc_wrap,
-              struct vrna_pbacktrack_memory_s *nr_mem);
+              struct vrna_pbacktrack_memory_s *nr_mem,
+              struct bs_rng                   *rng);
 
 
 PRIVATE void
@@ -182,14 +241,16 @@ backtrack_qm2(int                   u,
               int                   n,
               char                  *pstruc,
               vrna_fold_compound_t  *vc,
-              struct sc_wrappers    *sc_wrap);
+              struct sc_wrappers    *sc_wrap,
+              struct bs_rng         *rng);
 
 
 PRIVATE unsigned int
 pbacktrack_circ(vrna_fold_compound_t              *fc,
                 unsigned int                      num_samples,
                 vrna_bs_result_f  bs_cb,
-                void                              *data);
+                void                              *data,
+                struct bs_rng                     *rng);
 
 
 /*
@@ -209,23 +270,8 @@ vrna_pbacktrack_sub_resume_cb(vrna_fold_compound_t              *fc,
 {
   unsigned int i = 0;
 
-  if (fc) {
-    vrna_mx_pf_t *matrices = fc->exp_matrices;
-
-    if (start == 0) {
-      vrna_message_warning("vrna_pbacktrack*(): interval start coordinate must be at least 1");
-    } else if (end > fc->length) {
-      vrna_message_warning("vrna_pbacktrack*(): interval end coordinate exceeds sequence length");
-    } else if (end < start) {
-      vrna_message_warning("vrna_pbacktrack*(): interval end < start");
-    } else if ((!matrices) || (!matrices->q) || (!matrices->qb) || (!matrices->qm) ||
-               (!fc->exp_params)) {
-      vrna_message_warning("vrna_pbacktrack*(): %s", info_call_pf);
-    } else if ((!fc->exp_params->model_details.uniq_ML) || (!matrices->qm1)) {
-      vrna_message_warning("vrna_pbacktrack*(): %s", info_set_uniq_ml);
-    } else if ((fc->exp_params->model_details.circ) && (end < fc->length)) {
-      vrna_message_warning("vrna_pbacktrack5*(): %s", info_no_circ);
-    } else if (options & VRNA_PBACKTRACK_NON_REDUNDANT) {
+  if (check_input(fc, start, end)) {
+    if (options & VRNA_PBACKTRACK_NON_REDUNDANT) {
       if (fc->exp_params->model_details.circ) {
         vrna_message_warning("vrna_pbacktrack5*(): %s", info_no_circ);
       } else if (!nr_mem) {
@@ -240,7 +286,7 @@ vrna_pbacktrack_sub_resume_cb(vrna_fold_compound_t              *fc,
           *nr_mem = nr_init(fc, start, end);
         }
 
-        i = wrap_pbacktrack(fc, start, end, num_samples, bs_cb, data, *nr_mem);
+        i = wrap_pbacktrack(fc, start, end, num_samples, bs_cb, data, *nr_mem, NULL);
 
         /* print warning if we've aborted backtracking too early */
         if ((i > 0) && (i < num_samples)) {
@@ -255,9 +301,9 @@ vrna_pbacktrack_sub_resume_cb(vrna_fold_compound_t              *fc,
         }
       }
     } else if (fc->exp_params->model_details.circ) {
-      i = pbacktrack_circ(fc, num_samples, bs_cb, data);
+      i = pbacktrack_circ(fc, num_samples, bs_cb, data, NULL);
     } else {
-      i = wrap_pbacktrack(fc, start, end, num_samples, bs_cb, data, NULL);
+      i = wrap_pbacktrack(fc, start, end, num_samples, bs_cb, data, NULL, NULL);
     }
   }
 
@@ -265,6 +311,61 @@ vrna_pbacktrack_sub_resume_cb(vrna_fold_compound_t              *fc,
 }
 
 
+PUBLIC unsigned int
+vrna_pbacktrack_sub_seeded_cb(vrna_fold_compound_t  *fc,
+                              unsigned int          num_samples,
+                              unsigned int          start,
+                              unsigned int          end,
+                              unsigned int          seed,
+                              vrna_bs_result_f      bs_cb,
+                              void                  *data,
+                              unsigned int          options)
+{
+  unsigned int                    i = 0;
+  struct bs_rng                   rng;
+  struct vrna_pbacktrack_memory_s *nr_mem;
+
+  if (check_input(fc, start, end)) {
+    rng.seed  = (uint64_t)seed;
+    rng.state = 0;
+
+    if (options & VRNA_PBACKTRACK_NON_REDUNDANT) {
+      if (fc->exp_params->model_details.circ) {
+        vrna_message_warning("vrna_pbacktrack*_seeded_cb(): %s", info_no_circ);
+      } else {
+        /* all samples depend on their predecessors, so there is no way to parallelize */
+        nr_mem  = nr_init(fc, start, end);
+        i       = wrap_pbacktrack(fc, start, end, num_samples, bs_cb, data, nr_mem, &rng);
+        vrna_pbacktrack_mem_free(nr_mem);
+      }
+    } else if (fc->exp_params->model_details.circ) {
+      i = pbacktrack_circ(fc, num_samples, bs_cb, data, &rng);
+    } else {
+#ifdef _OPENMP
+      int num_threads = vrna_cpu_threads(fc->exp_params->model_details.threads);
+
+      if ((fc->exp_params->model_details.threads != 1) &&
+          (num_threads > 1) &&
+          (num_samples > 1)) {
+        return wrap_pbacktrack_parallel(fc,
+                                        start,
+                                        end,
+                                        num_samples,
+                                        bs_cb,
+                                        data,
+                                        seed,
+                                        num_threads);
+      }
+
+#endif
+      i = wrap_pbacktrack(fc, start, end, num_samples, bs_cb, data, NULL, &rng);
+    }
+  }
+
+  return i;
+}
+
+
 PUBLIC void
 vrna_pbacktrack_mem_free(struct vrna_pbacktrack_memory_s *s)
 {
@@ -284,6 +385,76 @@ vrna_pbacktrack_mem_free(struct vrna_pbacktrack_memory_s *s)
  # BEGIN OF STATIC HELPER FUNCTIONS  #
  #####################################
  */
+PRIVATE int
+check_input(vrna_fold_compound_t  *fc,
+            unsigned int          start,
+            unsigned int          end)
+{
+  vrna_mx_pf_t *matrices;
+
+  if (!fc)
+    return 0;
+
+  matrices = fc->exp_matrices;
+
+  if (start == 0) {
+    vrna_message_warning("vrna_pbacktrack*(): interval start coordinate must be at least 1");
+  } else if (end > fc->length) {
+    vrna_message_warning("vrna_pbacktrack*(): interval end coordinate exceeds sequence length");
+  } else if (end < start) {
+    vrna_message_warning("vrna_pbacktrack*(): interval end < start");
+  } else if ((!matrices) || (!matrices->q) || (!matrices->qb) || (!matrices->qm) ||
+             (!fc->exp_params)) {
+    vrna_message_warning("vrna_pbacktrack*(): %s", info_call_pf);
+  } else if ((!fc->exp_params->model_details.uniq_ML) || (!matrices->qm1)) {
+    vrna_message_warning("vrna_pbacktrack*(): %s", info_set_uniq_ml);
+  } else if ((fc->exp_params->model_details.circ) && (end < fc->length)) {
+    vrna_message_warning("vrna_pbacktrack5*(): %s", info_no_circ);
+  } else {
+    return 1;
+  }
+
+  return 0;
+}
+
+
+/*
+ * derive the initial state of the stream for a particular sample
+ * from the seed by means of the splitmix64 finalizer, which is a
+ * bijection, such that different (seed, sample) pairs never start
+ * from the same 64 bit value
+ */
+PRIVATE INLINE void
+rng_stream(struct bs_rng  *rng,
+           unsigned int   sample)
+{
+  uint64_t z = (rng->seed << 32) | (uint64_t)sample;
+
+  z           += 0x9E3779B97F4A7C15ULL;
+  z           = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z           = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  z           ^= z >> 31;
+  rng->state  = z & RNG_MASK;
+}
+
+
+/*
+ * uniform random number in [0,1) drawn from the stream rng, or from
+ * the global random number generator vrna_urn() if rng is NULL. The
+ * stream uses the same linear congruential generator as erand48()
+ */
+PRIVATE INLINE double
+bs_urn(struct bs_rng *rng)
+{
+  if (!rng)
+    return vrna_urn();
+
+  rng->state = (0x5DEECE66DULL * rng->state + 0xBULL) & RNG_MASK;
+
+  return ldexp((double)rng->state, -48);
+}
+
+
 PRIVATE struct sc_wrappers *
 sc_init(vrna_fold_compound_t *fc)
 {
@@ -313,7 +484,6 @@ nr_init(vrna_fold_compound_t  *fc,
         unsigned int          start,
         unsigned int          end)
 {
-  size_t                          block_size;
   double                          pf;
   struct vrna_pbacktrack_memory_s *s;
 
@@ -325,13 +495,12 @@ nr_init(vrna_fold_compound_t  *fc,
   s->memory_dat = NULL;
   s->q_remain   = 0;
 
-  pf          = fc->exp_matrices->q[fc->iindx[start] - end];
-  block_size  = 5000 * sizeof(NR_NODE);
+  pf = fc->exp_matrices->q[fc->iindx[start] - end];
 
 #ifdef VRNA_NR_SAMPLING_HASH
   s->root_node = create_root(end, pf);
 #else
-  s->memory_dat = create_nr_memory(sizeof(NR_NODE), block_size, NULL);  /* memory pre-allocation */
+  s->memory_dat = create_nr_memory();
   s->root_node  = create_ll_root(&(s->memory_dat), pf);
 #endif
 
@@ -349,7 +518,8 @@ wrap_pbacktrack(vrna_fold_compound_t              *vc,
                 unsigned int                      num_samples,
                 vrna_bs_result_f  bs_cb,
                 void                              *data,
-                struct vrna_pbacktrack_memory_s   *nr_mem)
+                struct vrna_pbacktrack_memory_s   *nr_mem,
+                struct bs_rng                     *rng)
 {
   char                *pstruc;
   unsigned int        i;
@@ -377,6 +547,10 @@ wrap_pbacktrack(vrna_fold_compound_t              *vc,
 
   for (i = 0; i < num_samples; i++) {
     is_dup  = 1;
+
+    if (rng)
+      rng_stream(rng, i);
+
     pstruc  = vrna_alloc(((end - start + 1) + 1) * sizeof(char));
     memset(pstruc, '.', sizeof(char) * (end - start + 1));
     pstruc -= start - 1;
@@ -385,7 +559,7 @@ wrap_pbacktrack(vrna_fold_compound_t              *vc,
     if (nr_mem)
       nr_mem->q_remain = vc->exp_matrices->q[vc->iindx[start] - end]; /* really */
 
-    ret = backtrack_ext_loop(start, end, pstruc, vc, &helper_arrays, sc_wrap, nr_mem);
+    ret = backtrack_ext_loop(start, end, pstruc, vc, &helper_arrays, sc_wrap, nr_mem, rng);
 
     if (nr_mem) {
 #ifdef VRNA_NR_SAMPLING_HASH
@@ -394,7 +568,8 @@ wrap_pbacktrack(vrna_fold_compound_t              *vc,
                                                &is_dup,
                                                &pf_overflow);
 #else
-      nr_mem->current_node = traceback_to_ll_root(nr_mem->current_node,
+      nr_mem->current_node = traceback_to_ll_root(nr_mem->memory_dat,
+                                                  nr_mem->current_node,
                                                   nr_mem->q_remain,
                                                   &is_dup,
                                                   &pf_overflow);
@@ -431,6 +606,99 @@ wrap_pbacktrack(vrna_fold_compound_t              *vc,
 }
 
 
+#ifdef _OPENMP
+/*
+ * distribute the samples among the threads. The DP matrices are only
+ * read, so each thread merely requires its own soft constraint wrappers
+ * and structure buffer. Each sample is drawn from its own random number
+ * stream, and the ordered construct passes them to the callback in the
+ * same order as wrap_pbacktrack() would. Just like there, nothing is
+ * reported from the first failed backtrack onwards, and the number of
+ * samples drawn before it is returned
+ */
+PRIVATE unsigned int
+wrap_pbacktrack_parallel(vrna_fold_compound_t *vc,
+                         unsigned int         start,
+                         unsigned int         end,
+                         unsigned int         num_samples,
+                         vrna_bs_result_f     bs_cb,
+                         void                 *data,
+                         unsigned int         seed,
+                         int                  num_threads)
+{
+  unsigned int    i, failed;
+  int             *my_iindx;
+  FLT_OR_DBL      *q;
+  struct aux_mem  helper_arrays;
+
+  my_iindx  = vc->iindx;
+  q         = vc->exp_matrices->q;
+  failed    = num_samples;
+
+  helper_arrays.qik = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (end - start + 2));
+  helper_arrays.qik -= start - 1;
+
+  for (i = start; i <= end; i++)
+    helper_arrays.qik[i] = q[my_iindx[start] - i];
+
+  helper_arrays.qik[start - 1] = 1.0;
+
+#pragma omp parallel num_threads(num_threads)
+  {
+    char                *pstruc;
+    unsigned int        f;
+    int                 ret, s;
+    struct bs_rng       rng;
+    struct sc_wrappers  *sc_wrap;
+
+    sc_wrap   = sc_init(vc);
+    rng.seed  = (uint64_t)seed;
+    rng.state = 0;
+    pstruc    = vrna_alloc(((end - start + 1) + 1) * sizeof(char));
+    pstruc    -= start - 1;
+
+#pragma omp for ordered schedule(dynamic, 1)
+    for (s = 0; s < (int)num_samples; s++) {
+#pragma omp atomic read
+      f = failed;
+
+      /* samples after a failed backtrack will be discarded anyway */
+      ret = 0;
+      if ((unsigned int)s < f) {
+        memset(pstruc + (start - 1), '.', sizeof(char) * (end - start + 1));
+        rng_stream(&rng, (unsigned int)s);
+
+        ret = backtrack_ext_loop(start, end, pstruc, vc, &helper_arrays, sc_wrap, NULL, &rng);
+      }
+
+#pragma omp ordered
+      {
+        if ((unsigned int)s < failed) {
+          if ((ret > 0) && (bs_cb))
+            bs_cb(pstruc + (start - 1), data);
+
+          if (ret == 0) {
+#pragma omp atomic write
+            failed = (unsigned int)s;
+          }
+        }
+      }
+    }
+
+    free(pstruc + (start - 1));
+    sc_free(sc_wrap);
+  }
+
+  helper_arrays.qik += start - 1;
+  free(helper_arrays.qik);
+
+  return failed;
+}
+
+
+#endif
+
+
 /* backtrack one external */
 PRIVATE int
 backtrack_ext_loop(int                              start,
@@ -439,7 +707,8 @@ backtrack_ext_loop(int                              start,
                    vrna_fold_compound_t             *vc,
                    struct aux_mem                   *helper_arrays,
                    struct sc_wrappers               *sc_wrap,
-                   struct vrna_pbacktrack_memory_s  *nr_mem)
+                   struct vrna_pbacktrack_memory_s  *nr_mem,
+                   struct bs_rng                    *rng)
 {
   unsigned char         *hard_constraints;
   short                 *S1, *S2, **S, **S5, **S3;
@@ -516,7 +785,7 @@ backtrack_ext_loop(int                              start,
 #ifndef VRNA_NR_SAMPLING_HASH
   if (current_node) {
     memorized_node_prev = NULL;
-    memorized_node_cur  = (*current_node)->head;
+    memorized_node_cur  = nr_node(*memory_dat, (*current_node)->head);
   }
 
 #endif
@@ -542,7 +811,7 @@ backtrack_ext_loop(int                              start,
             return 0;
         }
 
-        r       = vrna_urn() * (q1k[j] - fbd);
+        r       = bs_urn(rng) * (q1k[j] - fbd);
         q_temp  = q1k[j - 1] * scale[1];
 
         if (sc_wrapper_ext->red_ext)
@@ -570,7 +839,7 @@ backtrack_ext_loop(int                              start,
                                             memorized_node_cur,
                                             *current_node,
                                             *q_remain);
-          reset_cursor(&memorized_node_prev, &memorized_node_cur, *current_node); /* resets cursor */
+          reset_cursor(*memory_dat, &memorized_node_prev, &memorized_node_cur, *current_node); /* resets cursor */
 #endif
         }
       } else {
@@ -583,17 +852,17 @@ backtrack_ext_loop(int                              start,
 
 #ifndef  VRNA_NR_SAMPLING_HASH
     if (current_node)
-      advance_cursor(&memorized_node_prev, &memorized_node_cur, NRT_UNPAIRED_SG, j - 1, j);
+      advance_cursor(*memory_dat, &memorized_node_prev, &memorized_node_cur, NRT_UNPAIRED_SG, j - 1, j);
 
 #endif
     /* now find the pairing partner i */
     if (current_node) {
-      fbd = NR_TOTAL_WEIGHT_TYPE(NRT_EXT_LOOP, *current_node) *
+      fbd = NR_TOTAL_WEIGHT_TYPE(*memory_dat, NRT_EXT_LOOP, *current_node) *
             q1k[j] /
             (*q_remain);
     }
 
-    r = vrna_urn() * (q1k[j] - q_temp - fbd);
+    r = bs_urn(rng) * (q1k[j] - q_temp - fbd);
     i = 2;
 
     unsigned int *is = vrna_boustrophedon(start, j - 1);
@@ -660,7 +929,7 @@ backtrack_ext_loop(int                              start,
 
 #ifndef VRNA_NR_SAMPLING_HASH
         if (current_node)
-          advance_cursor(&memorized_node_prev, &memorized_node_cur, NRT_EXT_LOOP, i, j);
+          advance_cursor(*memory_dat, &memorized_node_prev, &memorized_node_cur, NRT_EXT_LOOP, i, j);
 
 #endif
       }
@@ -679,9 +948,9 @@ backtrack_ext_loop(int                              start,
       }
     }
 
-    backtrack(i, j, pstruc, vc, sc_wrap, nr_mem);
+    backtrack(i, j, pstruc, vc, sc_wrap, nr_mem, rng);
     j   = i - 1;
-    ret = backtrack_ext_loop(start, j, pstruc, vc, helper_arrays, sc_wrap, nr_mem);
+    ret = backtrack_ext_loop(start, j, pstruc, vc, helper_arrays, sc_wrap, nr_mem, rng);
   }
 
   return ret;
@@ -695,7 +964,8 @@ backtrack_qm(int                              i,
              char                             *pstruc,
              vrna_fold_compound_t             *vc,
              struct sc_wrappers               *sc_wrap,
-             struct vrna_pbacktrack_memory_s  *nr_mem)
+             struct vrna_pbacktrack_memory_s  *nr_mem,
+             struct bs_rng                    *rng)
 {
   /* divide multiloop into qm and qm1  */
   int                   k, u, cnt, span, turn, is_unpaired, *my_iindx, *jindx, *hc_up_ml, ret;
@@ -748,7 +1018,7 @@ backtrack_qm(int                              i,
 #ifndef VRNA_NR_SAMPLING_HASH
   if (current_node) {
     memorized_node_prev = NULL;
-    memorized_node_cur  = (*current_node)->head;
+    memorized_node_cur  = nr_node(*memory_dat, (*current_node)->head);
   }
 
 #endif
@@ -762,7 +1032,7 @@ backtrack_qm(int                              i,
             (*q_remain);
     }
 
-    r = vrna_urn() * (qm[my_iindx[i] - j] - fbd);
+    r = bs_urn(rng) * (qm[my_iindx[i] - j] - fbd);
     if (current_node) {
       fbds = NR_GET_WEIGHT(*current_node, memorized_node_cur, NRT_QM_UNPAIR, i, 0) *
              qm[my_iindx[i] - j] /
@@ -778,7 +1048,7 @@ backtrack_qm(int                              i,
     if (qmt < r) {
 #ifndef VRNA_NR_SAMPLING_HASH
       if (current_node)
-        advance_cursor(&memorized_node_prev, &memorized_node_cur, NRT_QM_UNPAIR, i, 0);
+        advance_cursor(*memory_dat, &memorized_node_prev, &memorized_node_cur, NRT_QM_UNPAIR, i, 0);
 
 #endif
 
@@ -812,7 +1082,7 @@ backtrack_qm(int                              i,
 
 #ifndef VRNA_NR_SAMPLING_HASH
         if (current_node)
-          advance_cursor(&memorized_node_prev, &memorized_node_cur, NRT_QM_UNPAIR, k, 0);
+          advance_cursor(*memory_dat, &memorized_node_prev, &memorized_node_cur, NRT_QM_UNPAIR, k, 0);
 
 #endif
 
@@ -837,7 +1107,7 @@ backtrack_qm(int                              i,
 
 #ifndef VRNA_NR_SAMPLING_HASH
         if (current_node)
-          advance_cursor(&memorized_node_prev, &memorized_node_cur, NRT_QM_PAIR, k, 0);
+          advance_cursor(*memory_dat, &memorized_node_prev, &memorized_node_cur, NRT_QM_PAIR, k, 0);
 
 #endif
       }
@@ -880,7 +1150,7 @@ backtrack_qm(int                              i,
     if (cnt > j)
       return 0;
 
-    ret = backtrack_qm1(k, j, pstruc, vc, sc_wrap, nr_mem);
+    ret = backtrack_qm1(k, j, pstruc, vc, sc_wrap, nr_mem, rng);
 
     if (ret == 0)
       return ret;
@@ -890,7 +1160,7 @@ backtrack_qm(int                              i,
 
     if (!is_unpaired) {
       /* if we've chosen creating a branch in [i..k-1] */
-      ret = backtrack_qm(i, k - 1, pstruc, vc, sc_wrap, nr_mem);
+      ret = backtrack_qm(i, k - 1, pstruc, vc, sc_wrap, nr_mem, rng);
 
       if (ret == 0)
         return ret;
@@ -907,7 +1177,8 @@ backtrack_qm1(int                             i,
               char                            *pstruc,
               vrna_fold_compound_t            *vc,
               struct sc_wrappers              *sc_wrap,
-              struct vrna_pbacktrack_memory_s *nr_mem)
+              struct vrna_pbacktrack_memory_s *nr_mem,
+              struct bs_rng                   *rng)
 {
   /* i is paired to l, i<l<j; backtrack in qm1 to find l */
   unsigned char         *hard_constraints;
@@ -980,7 +1251,7 @@ backtrack_qm1(int                             i,
 #ifndef VRNA_NR_SAMPLING_HASH
   if (current_node) {
     memorized_node_prev = NULL;
-    memorized_node_cur  = (*current_node)->head;
+    memorized_node_cur  = nr_node(*memory_dat, (*current_node)->head);
   }
 
 #endif
@@ -991,7 +1262,7 @@ backtrack_qm1(int                             i,
           (*q_remain);
   }
 
-  r   = vrna_urn() * (qm1[jindx[j] + i] - fbd);
+  r   = bs_urn(rng) * (qm1[jindx[j] + i] - fbd);
   ii  = my_iindx[i];
   for (qt = 0., l = j; l > i + turn; l--) {
     il = jindx[l] + i;
@@ -1045,7 +1316,7 @@ backtrack_qm1(int                             i,
 
 #ifndef VRNA_NR_SAMPLING_HASH
         if (current_node)
-          advance_cursor(&memorized_node_prev, &memorized_node_cur, NRT_QM1_BRANCH, i, l);
+          advance_cursor(*memory_dat, &memorized_node_prev, &memorized_node_cur, NRT_QM1_BRANCH, i, l);
 
 #endif
       } else {
@@ -1063,7 +1334,7 @@ backtrack_qm1(int                             i,
     }
   }
 
-  return backtrack(i, l, pstruc, vc, sc_wrap, nr_mem);
+  return backtrack(i, l, pstruc, vc, sc_wrap, nr_mem, rng);
 }
 
 
@@ -1072,7 +1343,8 @@ backtrack_qm2(int                   k,
               int                   n,
               char                  *pstruc,
               vrna_fold_compound_t  *vc,
-              struct sc_wrappers    *sc_wrap)
+              struct sc_wrappers    *sc_wrap,
+              struct bs_rng         *rng)
 {
   int                   u, turn, *jindx;
   FLT_OR_DBL            qom2t, r, *qm1, *qm2;
@@ -1084,7 +1356,7 @@ backtrack_qm2(int                   k,
   turn          = vc->exp_params->model_details.min_loop_size;
   sc_wrapper_ml = &(sc_wrap->sc_wrapper_ml);
 
-  r = vrna_urn() * qm2[k];
+  r = bs_urn(rng) * qm2[k];
   /* we have to search for our barrier u between qm1 and qm1  */
   if (sc_wrapper_ml->decomp_ml) {
     for (qom2t = 0., u = k + turn + 1; u < n - turn - 1; u++) {
@@ -1106,8 +1378,8 @@ backtrack_qm2(int                   k,
   if (u == n - turn)
     vrna_message_error("backtrack failed in qm2");
 
-  backtrack_qm1(k, u, pstruc, vc, sc_wrap, NULL);
-  backtrack_qm1(u + 1, n, pstruc, vc, sc_wrap, NULL);
+  backtrack_qm1(k, u, pstruc, vc, sc_wrap, NULL, rng);
+  backtrack_qm1(u + 1, n, pstruc, vc, sc_wrap, NULL, rng);
 }
 
 
@@ -1117,7 +1389,8 @@ backtrack(int                             i,
           char                            *pstruc,
           vrna_fold_compound_t            *vc,
           struct sc_wrappers              *sc_wrap,
-          struct vrna_pbacktrack_memory_s *nr_mem)
+          struct vrna_pbacktrack_memory_s *nr_mem,
+          struct bs_rng                   *rng)
 {
   unsigned char         *hard_constraints, hc_decompose;
   char                  *ptype;
@@ -1209,7 +1482,7 @@ backtrack(int                             i,
 #ifndef VRNA_NR_SAMPLING_HASH
   if (current_node) {
     memorized_node_prev = NULL;
-    memorized_node_cur  = (*current_node)->head;
+    memorized_node_cur  = nr_node(*memory_dat, (*current_node)->head);
   }
 
 #endif
@@ -1236,7 +1509,7 @@ backtrack(int                             i,
     pstruc[i - 1] = '(';
     pstruc[j - 1] = ')';
 
-    r     = vrna_urn() * (qbr - fbd);
+    r     = bs_urn(rng) * (qbr - fbd);
     qbt1  = 0.;
 
     hc_decompose = hard_constraints[n * i + j];
@@ -1278,7 +1551,7 @@ backtrack(int                             i,
 
 #ifndef VRNA_NR_SAMPLING_HASH
     if (current_node)
-      advance_cursor(&memorized_node_prev, &memorized_node_cur, NRT_HAIRPIN, 0, 0);
+      advance_cursor(*memory_dat, &memorized_node_prev, &memorized_node_cur, NRT_HAIRPIN, 0, 0);
 
 #endif
 
@@ -1346,7 +1619,7 @@ backtrack(int                             i,
 
 #ifndef VRNA_NR_SAMPLING_HASH
             if (current_node)
-              advance_cursor(&memorized_node_prev, &memorized_node_cur, NRT_IT_LOOP, k, l);
+              advance_cursor(*memory_dat, &memorized_node_prev, &memorized_node_cur, NRT_IT_LOOP, k, l);
 
 #endif
           }
@@ -1373,7 +1646,7 @@ backtrack(int                             i,
 
         free(types);
 
-        return backtrack(k, l, pstruc, vc, sc_wrap, nr_mem); /* found the interior loop, repeat for inside */
+        return backtrack(k, l, pstruc, vc, sc_wrap, nr_mem, rng); /* found the interior loop, repeat for inside */
       } else {
         /* interior loop contributions did not exceed threshold, so we break */
         break;
@@ -1437,7 +1710,7 @@ backtrack(int                             i,
 
 #ifndef VRNA_NR_SAMPLING_HASH
         if (current_node)
-          advance_cursor(&memorized_node_prev, &memorized_node_cur, NRT_MT_LOOP, k, 0);
+          advance_cursor(*memory_dat, &memorized_node_prev, &memorized_node_cur, NRT_MT_LOOP, k, 0);
 
 #endif
       }
@@ -1463,7 +1736,7 @@ backtrack(int                             i,
 
 #ifndef VRNA_NR_SAMPLING_HASH
         if (current_node)
-          advance_cursor(&memorized_node_prev, &memorized_node_cur, NRT_MT_LOOP, k, 0);
+          advance_cursor(*memory_dat, &memorized_node_prev, &memorized_node_cur, NRT_MT_LOOP, k, 0);
 
 #endif
       }
@@ -1494,7 +1767,7 @@ backtrack(int                             i,
 #endif
     }
 
-    ret = backtrack_qm1(k, j, pstruc, vc, sc_wrap, nr_mem);
+    ret = backtrack_qm1(k, j, pstruc, vc, sc_wrap, nr_mem, rng);
 
     if (ret == 0) {
       free(types);
@@ -1503,7 +1776,7 @@ backtrack(int                             i,
 
     j = k - 1;
 
-    ret = backtrack_qm(i, j, pstruc, vc, sc_wrap, nr_mem);
+    ret = backtrack_qm(i, j, pstruc, vc, sc_wrap, nr_mem, rng);
   }
 
   free(types);
@@ -1516,7 +1789,8 @@ PRIVATE unsigned int
 pbacktrack_circ(vrna_fold_compound_t              *vc,
                 unsigned int                      num_samples,
                 vrna_bs_result_f  bs_cb,
-                void                              *data)
+                void                              *data,
+                struct bs_rng                     *rng)
 {
   unsigned char         *hc_mx, eval_loop;
   char                  *pstruc;
@@ -1583,6 +1857,9 @@ pbacktrack_circ(vrna_fold_compound_t              *vc,
   for (count = 0; count < num_samples; count++) {
     pstruc = vrna_alloc((n + 1) * sizeof(char));
 
+    if (rng)
+      rng_stream(rng, count);
+
     /* initialize pstruct with single bases  */
     memset(pstruc, '.', sizeof(char) * n);
 
@@ -1592,7 +1869,7 @@ pbacktrack_circ(vrna_fold_compound_t              *vc,
     if (sc_wrapper_ext->red_up)
       qt *= sc_wrapper_ext->red_up(1, n, sc_wrapper_ext);
 
-    r = vrna_urn() * qo;
+    r = bs_urn(rng) * qo;
 
     /* open chain? */
     if (qt > r)
@@ -1612,7 +1889,7 @@ pbacktrack_circ(vrna_fold_compound_t              *vc,
 
         /* found a hairpin? so backtrack in the enclosed part and we're done  */
         if (qt > r) {
-          backtrack(i, j, pstruc, vc, sc_wrap, NULL);
+          backtrack(i, j, pstruc, vc, sc_wrap, NULL, rng);
           goto pbacktrack_circ_loop_end;
         }
 
@@ -1694,8 +1971,8 @@ pbacktrack_circ(vrna_fold_compound_t              *vc,
                  * forward and backtracking the both enclosed parts and we're done
                  */
                 if (qt > r) {
-                  backtrack(i, j, pstruc, vc, sc_wrap, NULL);
-                  backtrack(k, l, pstruc, vc, sc_wrap, NULL);
+                  backtrack(i, j, pstruc, vc, sc_wrap, NULL, rng);
+                  backtrack(k, l, pstruc, vc, sc_wrap, NULL, rng);
                   goto pbacktrack_circ_loop_end;
                 }
               }
@@ -1707,7 +1984,7 @@ pbacktrack_circ(vrna_fold_compound_t              *vc,
     {
       /* as we reach this part, we have to search for our barrier between qm and qm2  */
       qt  = 0.;
-      r   = vrna_urn() * qmo;
+      r   = bs_urn(rng) * qmo;
       if (sc_wrapper_ml->decomp_ml) {
         for (k = turn + 2; k < n - 2 * turn - 3; k++) {
           qt += qm[my_iindx[1] - k] *
@@ -1723,8 +2000,8 @@ pbacktrack_circ(vrna_fold_compound_t              *vc,
 
           /* backtrack in qm and qm2 if we've found a valid barrier k  */
           if (qt > r) {
-            backtrack_qm(1, k, pstruc, vc, sc_wrap, NULL);
-            backtrack_qm2(k + 1, n, pstruc, vc, sc_wrap);
+            backtrack_qm(1, k, pstruc, vc, sc_wrap, NULL, rng);
+            backtrack_qm2(k + 1, n, pstruc, vc, sc_wrap, rng);
             goto pbacktrack_circ_loop_end;
           }
         }
@@ -1735,8 +2012,8 @@ pbacktrack_circ(vrna_fold_compound_t              *vc,
                 expMLclosing;
           /* backtrack in qm and qm2 if we've found a valid barrier k  */
           if (qt > r) {
-            backtrack_qm(1, k, pstruc, vc, sc_wrap, NULL);
-            backtrack_qm2(k + 1, n, pstruc, vc, sc_wrap);
+            backtrack_qm(1, k, pstruc, vc, sc_wrap, NULL, rng);
+            backtrack_qm2(k + 1, n, pstruc, vc, sc_wrap, rng);
             goto pbacktrack_circ_loop_end;
           }
         }
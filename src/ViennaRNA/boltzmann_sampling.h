@@ -1061,6 +1061,102 @@ vrna_pbacktrack_sub_resume_cb(vrna_fold_compound_t             *fc,
                               unsigned int                     options);
 
 
+/**
+ *  @brief Obtain a reproducible set of secondary structure samples for a subsequence from the Boltzmann ensemble
+ *
+ *  Perform a probabilistic (stochastic) backtracing in the partition function DP arrays
+ *  to obtain a set of @p num_samples secondary structures of the subsequence between
+ *  @p start and @p end, just like vrna_pbacktrack_sub_resume_cb(). However, instead of the
+ *  global random number generator (see vrna_urn()), the k-th sample is drawn from a random
+ *  number stream of its own that is derived from @p seed and k. Hence, the same @p seed always
+ *  yields the same samples in the same order.
+ *
+ *  If more than one thread is requested by the vrna_md_t.threads attribute of the model details
+ *  used to create @p fc, and OpenMP support is available, the samples are distributed among the
+ *  threads. All threads share the partition function DP matrices, and the samples are passed to
+ *  the callback @p cb in the order of their stream index by one thread at a time, so neither the
+ *  samples nor their order depend on the number of threads.
+ *
+ *  @pre    Unique multiloop decomposition has to be active upon creation of @p fc with vrna_fold_compound()
+ *          or similar. This can be done easily by passing vrna_fold_compound() a model details parameter
+ *          with vrna_md_t.uniq_ML = 1.<br>
+ *          vrna_pf() has to be called first to fill the partition function matrices
+ *
+ *  @note This function is polymorphic. It accepts #vrna_fold_compound_t of type
+ *        #VRNA_FC_TYPE_SINGLE, and #VRNA_FC_TYPE_COMPARATIVE.
+ *
+ *  @note Non-redundant sampling (#VRNA_PBACKTRACK_NON_REDUNDANT) and sampling for circular RNAs
+ *        are always performed by a single thread.
+ *
+ *  @see  vrna_pbacktrack_seeded_cb(), vrna_pbacktrack_seeded_num(), vrna_pbacktrack_sub_resume_cb(),
+ *        #VRNA_PBACKTRACK_DEFAULT, #VRNA_PBACKTRACK_NON_REDUNDANT
+ *
+ *  @param  fc            The fold compound data structure
+ *  @param  num_samples   The size of the sample set, i.e. number of structures
+ *  @param  start         The start of  the subsequence to consider, i.e. 5'-end position(1-based)
+ *  @param  end           The end of the subsequence to consider, i.e. 3'-end position (1-based)
+ *  @param  seed          The seed for the random number streams
+ *  @param  cb            The callback that receives the sampled structure
+ *  @param  data          A data structure passed through to the callback @p cb
+ *  @param  options       A bitwise OR-flag indicating the backtracing mode.
+ *  @return               The number of structures actually backtraced
+ */
+unsigned int
+vrna_pbacktrack_sub_seeded_cb(vrna_fold_compound_t  *fc,
+                              unsigned int          num_samples,
+                              unsigned int          start,
+                              unsigned int          end,
+                              unsigned int          seed,
+                              vrna_bs_result_f      cb,
+                              void                  *data,
+                              unsigned int          options);
+
+
+/**
+ *  @brief Obtain a reproducible set of secondary structure samples from the Boltzmann ensemble
+ *
+ *  This is a convenience wrapper around vrna_pbacktrack_sub_seeded_cb() for the entire sequence.
+ *
+ *  @see  vrna_pbacktrack_sub_seeded_cb(), vrna_pbacktrack_seeded_num(), vrna_pbacktrack_cb()
+ *
+ *  @param  fc            The fold compound data structure
+ *  @param  num_samples   The size of the sample set, i.e. number of structures
+ *  @param  seed          The seed for the random number streams
+ *  @param  cb            The callback that receives the sampled structure
+ *  @param  data          A data structure passed through to the callback @p cb
+ *  @param  options       A bitwise OR-flag indicating the backtracing mode.
+ *  @return               The number of structures actually backtraced
+ */
+unsigned int
+vrna_pbacktrack_seeded_cb(vrna_fold_compound_t  *fc,
+                          unsigned int          num_samples,
+                          unsigned int          seed,
+                          vrna_bs_result_f      cb,
+                          void                  *data,
+                          unsigned int          options);
+
+
+/**
+ *  @brief Obtain a reproducible set of secondary structure samples from the Boltzmann ensemble
+ *
+ *  This is a convenience wrapper around vrna_pbacktrack_sub_seeded_cb() for the entire sequence
+ *  that returns the samples as a list.
+ *
+ *  @see  vrna_pbacktrack_sub_seeded_cb(), vrna_pbacktrack_seeded_cb(), vrna_pbacktrack_num()
+ *
+ *  @param  fc            The fold compound data structure
+ *  @param  num_samples   The size of the sample set, i.e. number of structures
+ *  @param  seed          The seed for the random number streams
+ *  @param  options       A bitwise OR-flag indicating the backtracing mode.
+ *  @return               A set of secondary structure samples in dot-bracket notation terminated by NULL (or NULL on error)
+ */
+char **
+vrna_pbacktrack_seeded_num(vrna_fold_compound_t *fc,
+                           unsigned int         num_samples,
+                           unsigned int         seed,
+                           unsigned int         options);
+
+
 /**
  *  @brief  Release memory occupied by a Boltzmann sampling memory data structure
  *
@@ -253,6 +253,66 @@ vrna_pbacktrack_cb(vrna_fold_compound_t             *fc,
 }
 
 
+PUBLIC unsigned int
+vrna_pbacktrack_seeded_cb(vrna_fold_compound_t  *fc,
+                          unsigned int          num_samples,
+                          unsigned int          seed,
+                          vrna_bs_result_f      bs_cb,
+                          void                  *data,
+                          unsigned int          options)
+{
+  if (fc) {
+    return vrna_pbacktrack_sub_seeded_cb(fc,
+                                         num_samples,
+                                         1,
+                                         fc->length,
+                                         seed,
+                                         bs_cb,
+                                         data,
+                                         options);
+  }
+
+  return 0;
+}
+
+
+PUBLIC char **
+vrna_pbacktrack_seeded_num(vrna_fold_compound_t *fc,
+                           unsigned int         num_samples,
+                           unsigned int         seed,
+                           unsigned int         options)
+{
+  unsigned int          i;
+  struct structure_list data;
+
+  if (fc) {
+    data.num      = 0;
+    data.list     = (char **)vrna_alloc(sizeof(char *) * num_samples);
+    data.list[0]  = NULL;
+
+    i = vrna_pbacktrack_seeded_cb(fc,
+                                  num_samples,
+                                  seed,
+                                  &store_sample_list,
+                                  (void *)&data,
+                                  options);
+
+    if (i > 0) {
+      /* re-allocate memory */
+      data.list           = (char **)vrna_realloc(data.list, sizeof(char *) * (data.num + 1));
+      data.list[data.num] = NULL;
+    } else {
+      free(data.list);
+      return NULL;
+    }
+
+    return data.list;
+  }
+
+  return NULL;
+}
+
+
 PUBLIC char **
 vrna_pbacktrack_resume(vrna_fold_compound_t   *fc,
                        unsigned int           num_samples,
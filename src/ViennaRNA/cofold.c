@@ -166,7 +166,7 @@ wrap_cofold(const char    *string,
 
   if (parameters) {
     /* replace params if necessary */
-    free(vc->params);
+    vrna_params_free(vc->params);
     vc->params = P;
   } else {
     free(P);
@@ -252,7 +252,7 @@ wrap_zukersubopt(const char   *string,
 
   if (parameters) {
     /* replace params if necessary */
-    free(vc->params);
+    vrna_params_free(vc->params);
     vc->params = P;
   } else {
     free(P);
@@ -360,7 +360,7 @@ update_cofold_params(void)
     v = backward_compat_compound;
 
     if (v->params)
-      free(v->params);
+      vrna_params_free(v->params);
 
     set_model_details(&md);
     v->params = vrna_params(&md);
@@ -377,7 +377,7 @@ update_cofold_params_par(vrna_param_t *parameters)
     v = backward_compat_compound;
 
     if (v->params)
-      free(v->params);
+      vrna_params_free(v->params);
 
     if (parameters) {
       v->params = vrna_params_copy(parameters);
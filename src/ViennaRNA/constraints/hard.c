@@ -157,31 +157,51 @@ vrna_hc_init(vrna_fold_compound_t *vc)
 
   n = vc->length;
 
-  /* free previous hard constraints */
-  vrna_hc_free(vc->hc);
-
-  /* allocate memory new hard constraints data structure */
-  hc          = (vrna_hc_t *)vrna_alloc(sizeof(vrna_hc_t));
-  hc->type    = VRNA_HC_DEFAULT;
-  hc->n       = n;
-  hc->mx      = (unsigned char *)vrna_alloc(sizeof(unsigned char) * ((n + 1) * (n + 1) + 1));
-  hc->up_ext  = (int *)vrna_alloc(sizeof(int) * (n + 2));
-  hc->up_hp   = (int *)vrna_alloc(sizeof(int) * (n + 2));
-  hc->up_int  = (int *)vrna_alloc(sizeof(int) * (n + 2));
-  hc->up_ml   = (int *)vrna_alloc(sizeof(int) * (n + 2));
-  hc->depot   = NULL;
-  hc->state   = STATE_UNINITIALIZED;
+  if ((vc->hc) && (vc->hc->type == VRNA_HC_DEFAULT)) {
+    /* re-use memory of previous hard constraints */
+    hc = vc->hc;
+    hc_depot_free(hc);
 
-  /* set new hard constraints */
-  vc->hc = hc;
+    hc->n       = n;
+    hc->mx      = (unsigned char *)vrna_realloc(hc->mx,
+                                                sizeof(unsigned char) * ((n + 1) * (n + 1) + 1));
+    hc->up_ext  = (int *)vrna_realloc(hc->up_ext, sizeof(int) * (n + 2));
+    hc->up_hp   = (int *)vrna_realloc(hc->up_hp, sizeof(int) * (n + 2));
+    hc->up_int  = (int *)vrna_realloc(hc->up_int, sizeof(int) * (n + 2));
+    hc->up_ml   = (int *)vrna_realloc(hc->up_ml, sizeof(int) * (n + 2));
+    hc->state   = STATE_UNINITIALIZED;
 
-  /* prefill default values  */
-  hc_reset_to_default(vc);
+    memset(hc->mx, 0, sizeof(unsigned char) * ((n + 1) * (n + 1) + 1));
 
-  /* add null pointers for the generalized hard constraint feature */
-  hc->f         = NULL;
-  hc->data      = NULL;
-  hc->free_data = NULL;
+    /* prefill default values, this also removes the generalized hard constraints */
+    hc_reset_to_default(vc);
+  } else {
+    /* free previous hard constraints */
+    vrna_hc_free(vc->hc);
+
+    /* allocate memory new hard constraints data structure */
+    hc          = (vrna_hc_t *)vrna_alloc(sizeof(vrna_hc_t));
+    hc->type    = VRNA_HC_DEFAULT;
+    hc->n       = n;
+    hc->mx      = (unsigned char *)vrna_alloc(sizeof(unsigned char) * ((n + 1) * (n + 1) + 1));
+    hc->up_ext  = (int *)vrna_alloc(sizeof(int) * (n + 2));
+    hc->up_hp   = (int *)vrna_alloc(sizeof(int) * (n + 2));
+    hc->up_int  = (int *)vrna_alloc(sizeof(int) * (n + 2));
+    hc->up_ml   = (int *)vrna_alloc(sizeof(int) * (n + 2));
+    hc->depot   = NULL;
+    hc->state   = STATE_UNINITIALIZED;
+
+    /* set new hard constraints */
+    vc->hc = hc;
+
+    /* prefill default values  */
+    hc_reset_to_default(vc);
+
+    /* add null pointers for the generalized hard constraint feature */
+    hc->f         = NULL;
+    hc->data      = NULL;
+    hc->free_data = NULL;
+  }
 
   /* update */
   hc_update_up(vc);
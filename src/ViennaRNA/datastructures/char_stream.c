@@ -141,6 +141,22 @@ vrna_cstr_fflush(struct vrna_cstr_s *buf)
 }
 
 
+void
+vrna_cstr_write(struct vrna_cstr_s *buf)
+{
+  if (buf) {
+    if ((buf->output) &&
+        (buf->string) &&
+        (buf->string[0] != '\0'))
+      (void)fwrite(buf->string, sizeof(char), strlen(buf->string), buf->output);
+
+    buf->size       = CSTR_OVERHEAD;
+    buf->string     = (char *)vrna_realloc(buf->string, sizeof(char) * buf->size);
+    buf->string[0]  = '\0';
+  }
+}
+
+
 int
 vrna_cstr_printf(struct vrna_cstr_s *buf,
                  const char         *format,
@@ -80,7 +80,7 @@ vrna_cstr_close(vrna_cstr_t buf);
  *
  *  @post The stream buffer is empty after execution of this function
  *
- *  @see  vrna_cstr(), vrna_cstr_close(), vrna_cstr_free()
+ *  @see  vrna_cstr(), vrna_cstr_close(), vrna_cstr_free(), vrna_cstr_write()
  *
  *  @param  buf   The dynamic char * stream data structure to flush
  */
@@ -88,6 +88,24 @@ void
 vrna_cstr_fflush(struct vrna_cstr_s *buf);
 
 
+/**
+ *  @brief  Write the dynamic char * output stream without flushing the file handle
+ *
+ *  Same as vrna_cstr_fflush() but the data is only handed over to the
+ *  buffer of the attached file handle. This allows for writing many
+ *  small streams in a row and flushing the file handle only once
+ *  afterwards.
+ *
+ *  @post The stream buffer is empty after execution of this function
+ *
+ *  @see  vrna_cstr_fflush(), vrna_cstr()
+ *
+ *  @param  buf   The dynamic char * stream data structure to write
+ */
+void
+vrna_cstr_write(struct vrna_cstr_s *buf);
+
+
 const char *
 vrna_cstr_string(vrna_cstr_t buf);
 
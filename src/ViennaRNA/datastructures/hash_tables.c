@@ -255,7 +255,7 @@ vrna_ht_remove(struct vrna_hash_table_s *ht,
           } else {
             void  *offset     = entries->hash_entries + i;
             void  *next_entry = entries->hash_entries + i + 1;
-            memcpy(offset, next_entry, size_rest * sizeof(void *));
+            memmove(offset, next_entry, size_rest * sizeof(void *));
           }
 
           entries->hash_entries[entries->length - 1] = NULL;
@@ -1,3 +1,19 @@
+/*
+ *  Ordered output stream
+ *
+ *  Data blocks are stored in a ring buffer. Each slot carries a sequence
+ *  number that is published atomically once the data for its index has
+ *  been provided, so providers of bounded streams never need to acquire
+ *  a lock. Consecutive data blocks from the start of the stream are then
+ *  processed either by a dedicated writer thread, or by whichever
+ *  providing thread manages to claim the processing role. Mutex and
+ *  condition variables are only used to put the writer thread or blocked
+ *  requests to sleep.
+ *
+ *  Unbounded streams grow the ring buffer instead of blocking requests.
+ *  Here, providers and the processing thread hold a shared lock on the
+ *  buffer, which is only taken exclusively to grow it.
+ */
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
@@ -19,71 +35,116 @@
 # define INLINE
 #endif
 
-#define QUEUE_OVERHEAD  32
+#if VRNA_WITH_PTHREADS
+# define LOAD(x)            __atomic_load_n(&(x), __ATOMIC_SEQ_CST)
+# define STORE(x, v)        __atomic_store_n(&(x), (v), __ATOMIC_SEQ_CST)
+# define EXCHANGE(x, v)     __atomic_exchange_n(&(x), (v), __ATOMIC_SEQ_CST)
+#else
+# define LOAD(x)            (x)
+# define STORE(x, v)        ((x) = (v))
+#endif
+
+/*
+ #################################
+ # PRIVATE DATA STRUCTURES       #
+ #################################
+ */
+struct slot {
+  void          *data;
+  unsigned int  seq;              /* i + 1 as soon as data for index i is provided */
+};
 
 
 struct vrna_ordered_stream_s {
-  unsigned int                start;      /* first element index in queue, i.e. start of queue */
-  unsigned int                end;        /* last element index in queue */
-  unsigned int                size;       /* available memory size for 'data' and 'provided' */
-  unsigned int                shift;      /* pointer offset for 'data' and 'provided' */
-
-  vrna_stream_output_f output;    /* callback to execute if consecutive elements from head are available */
-  void                        **data;     /* actual data passed to the callback */
-  unsigned char               *provided;  /* for simplicity we use unsigned char instead of single bits per element */
-  void                        *auxdata;   /* auxiliary data passed to the callback */
+  vrna_stream_output_f  output;   /* callback to execute for consecutive elements from the start */
+  vrna_stream_flush_f   flush;    /* callback to execute after each batch of consecutive elements */
+  void                  *auxdata; /* auxiliary data passed to the callbacks */
+
+  struct slot           *slots;   /* ring buffer */
+  unsigned int          capacity; /* number of slots, a power of 2 */
+  unsigned int          start;    /* index of the next element to process */
+  unsigned int          end;      /* largest requested index + 1 */
+  unsigned char         bounded;  /* whether requests block instead of growing the buffer */
+
 #if VRNA_WITH_PTHREADS
-  pthread_mutex_t             mtx;        /* semaphore to provide concurrent access */
+  unsigned int          processing;       /* whether a providing thread currently processes the output */
+  unsigned int          writer_waiting;   /* whether the writer thread sleeps */
+  unsigned int          requests_waiting; /* number of requests blocked by a full buffer */
+  unsigned char         shutdown;
+  unsigned char         has_writer;
+  pthread_t             writer;
+  pthread_mutex_t       mtx;              /* protects sleeping only */
+  pthread_cond_t        data_available;
+  pthread_cond_t        space_available;
+  pthread_rwlock_t      resize;           /* exclusive to grow the buffer of unbounded streams */
 #endif
 };
 
 
-PRIVATE INLINE void
-flush_output(struct vrna_ordered_stream_s *queue)
-{
-  unsigned int j;
-
-  /* flush all consecutive blocks available from the start of queue */
+/*
+ #################################
+ # PRIVATE FUNCTION DECLARATIONS #
+ #################################
+ */
+PRIVATE struct vrna_ordered_stream_s *
+init_stream(vrna_stream_output_f  output,
+            vrna_stream_flush_f   flush,
+            void                  *auxdata,
+            unsigned int          capacity,
+            unsigned int          options,
+            unsigned char         bounded);
 
-  /* 1. process output callback */
-  if (queue->output)
-    for (j = queue->start; (j <= queue->end) && (queue->provided[j]); j++)
-      queue->output(queue->auxdata, j, queue->data[j]);
 
-  /* 2. move start of queue */
-  while ((queue->start <= queue->end) && (queue->provided[queue->start]))
-    queue->start++;
+PRIVATE INLINE int
+data_available(struct vrna_ordered_stream_s *queue);
 
-  /* 3. set empty queue condition if necessary */
-  if (queue->end < queue->start) {
-    queue->provided[queue->start] = 0;
-    queue->end                    = queue->start;
-  }
-}
 
+PRIVATE unsigned int
+process_output(struct vrna_ordered_stream_s *queue);
 
-PUBLIC struct vrna_ordered_stream_s *
-vrna_ostream_init(vrna_stream_output_f output,
-                  void                        *auxdata)
-{
-  struct vrna_ordered_stream_s *queue;
 
-  queue = (struct vrna_ordered_stream_s *)vrna_alloc(sizeof(struct vrna_ordered_stream_s));
+PRIVATE void
+grow_buffer(struct vrna_ordered_stream_s  *queue,
+            unsigned int                  size);
 
-  queue->start    = 0;
-  queue->end      = 0;
-  queue->size     = QUEUE_OVERHEAD;
-  queue->shift    = 0;
-  queue->output   = output;
-  queue->auxdata  = auxdata;
-  queue->data     = (void **)vrna_alloc(sizeof(void *) * QUEUE_OVERHEAD);
-  queue->provided = (unsigned char *)vrna_alloc(sizeof(unsigned char) * QUEUE_OVERHEAD);
 
 #if VRNA_WITH_PTHREADS
-  pthread_mutex_init(&queue->mtx, NULL);
+
+PRIVATE void *
+writer_loop(void *arg);
+
+
+PRIVATE INLINE void
+buffer_acquire(struct vrna_ordered_stream_s *queue);
+
+
+PRIVATE INLINE void
+buffer_release(struct vrna_ordered_stream_s *queue);
+
+
 #endif
 
-  return queue;
+/*
+ #################################
+ # BEGIN OF FUNCTION DEFINITIONS #
+ #################################
+ */
+PUBLIC struct vrna_ordered_stream_s *
+vrna_ostream_init(vrna_stream_output_f  output,
+                  void                  *auxdata)
+{
+  return init_stream(output, NULL, auxdata, 0, 0, 0);
+}
+
+
+PUBLIC struct vrna_ordered_stream_s *
+vrna_ostream_init_bounded(vrna_stream_output_f  output,
+                          vrna_stream_flush_f   flush,
+                          void                  *auxdata,
+                          unsigned int          capacity,
+                          unsigned int          options)
+{
+  return init_stream(output, flush, auxdata, capacity, options, 1);
 }
 
 
@@ -92,22 +153,32 @@ vrna_ostream_free(struct vrna_ordered_stream_s *queue)
 {
   if (queue) {
 #if VRNA_WITH_PTHREADS
-    pthread_mutex_lock(&queue->mtx);
-#endif
+    if (queue->has_writer) {
+      /* the writer processes all remaining consecutive data before it terminates */
+      pthread_mutex_lock(&(queue->mtx));
+      queue->shutdown = 1;
+      pthread_cond_signal(&(queue->data_available));
+      pthread_mutex_unlock(&(queue->mtx));
 
-    flush_output(queue);
+      pthread_join(queue->writer, NULL);
+    } else {
+      while (EXCHANGE(queue->processing, 1))
+        ;
 
-#if VRNA_WITH_PTHREADS
-    pthread_mutex_unlock(&queue->mtx);
-#endif
+      process_output(queue);
 
-    /* free remaining memory */
-    queue->data     += queue->shift;
-    queue->provided += queue->shift;
-    free(queue->data);
-    free(queue->provided);
+      STORE(queue->processing, 0);
+    }
 
-    /* free ostream itself */
+    pthread_mutex_destroy(&(queue->mtx));
+    pthread_cond_destroy(&(queue->data_available));
+    pthread_cond_destroy(&(queue->space_available));
+    pthread_rwlock_destroy(&(queue->resize));
+#else
+    process_output(queue);
+#endif
+
+    free(queue->slots);
     free(queue);
   }
 }
@@ -128,70 +199,48 @@ PUBLIC void
 vrna_ostream_request(struct vrna_ordered_stream_s *queue,
                      unsigned int                 num)
 {
-  unsigned int i;
+  unsigned int end;
 
   if (queue) {
 #if VRNA_WITH_PTHREADS
-    pthread_mutex_lock(&queue->mtx);
-#endif
-    if (num >= queue->end) {
-      /* check whether we have to increase memory */
-      unsigned int new_size = num - queue->shift + 1;
-
-      if (queue->size < new_size + 1) {
-        /*
-         *  Check whether we can simply move data around to get more space.
-         *  We do this only, if more than half of the first buffer is empty.
-         *  Otherwise, we simply increase the buffer to fit incoming data.
-         */
-        unsigned int mem_unavail = queue->start - queue->shift;
-        if ((mem_unavail > (queue->size / 2)) &&
-            (new_size - mem_unavail < queue->size + 1)) {
-          /* reset pointer shift */
-          queue->data     += queue->shift;
-          queue->provided += queue->shift;
-
-          /* move remaining data to the front */
-          queue->data = memmove(queue->data,
-                                queue->data + mem_unavail,
-                                sizeof(void *) * (queue->end - queue->start + 1));
-
-          /* move provider bitmask to the front */
-          queue->provided = memmove(queue->provided,
-                                    queue->provided + mem_unavail,
-                                    sizeof(unsigned char) * (queue->end - queue->start + 1));
-
-          /* reset start and pointer shifts */
-          queue->shift    = queue->start;
-          queue->data     -= queue->start;
-          queue->provided -= queue->start;
-        } else {
-          /* increase stream buffer size */
-          new_size += QUEUE_OVERHEAD;
-          /* reset pointer shift */
-          queue->data     += queue->shift;
-          queue->provided += queue->shift;
-
-          /* reallocate memory blocks */
-          queue->data     = (void **)vrna_realloc(queue->data, sizeof(void *) * new_size);
-          queue->provided =
-            (unsigned char *)vrna_realloc(queue->provided, sizeof(void *) * new_size);
-          queue->size = new_size;
-
-          /* restore pointer shift */
-          queue->data     -= queue->shift;
-          queue->provided -= queue->shift;
-        }
+    if (!queue->bounded) {
+      /* grow the buffer instead of blocking */
+      pthread_rwlock_rdlock(&(queue->resize));
+      end = ((int)(num - LOAD(queue->start)) >= (int)queue->capacity) ? 1 : 0;
+      pthread_rwlock_unlock(&(queue->resize));
+
+      if (end) {
+        pthread_rwlock_wrlock(&(queue->resize));
+        if ((int)(num - queue->start) >= (int)queue->capacity)
+          grow_buffer(queue, num - queue->start + 1);
+
+        pthread_rwlock_unlock(&(queue->resize));
       }
+    } else if ((int)(num - LOAD(queue->start)) >= (int)queue->capacity) {
+      /* apply back-pressure while the buffer is full */
+      pthread_mutex_lock(&(queue->mtx));
+      __atomic_add_fetch(&(queue->requests_waiting), 1, __ATOMIC_SEQ_CST);
 
-      for (i = queue->end + 1; i <= num; i++)
-        queue->provided[i] = 0;
+      while ((int)(num - LOAD(queue->start)) >= (int)queue->capacity)
+        pthread_cond_wait(&(queue->space_available), &(queue->mtx));
 
-      queue->end = num;
+      __atomic_sub_fetch(&(queue->requests_waiting), 1, __ATOMIC_SEQ_CST);
+      pthread_mutex_unlock(&(queue->mtx));
     }
 
-#if VRNA_WITH_PTHREADS
-    pthread_mutex_unlock(&queue->mtx);
+    end = LOAD(queue->end);
+    while (((int)(num + 1 - end) > 0) &&
+           (!__atomic_compare_exchange_n(&(queue->end), &end, num + 1, 0,
+                                         __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)))
+      ;
+#else
+    if ((int)(num - queue->start) >= (int)queue->capacity)
+      grow_buffer(queue, num - queue->start + 1);
+
+    end = queue->end;
+    if ((int)(num + 1 - end) > 0)
+      queue->end = num + 1;
+
 #endif
   }
 }
@@ -202,29 +251,257 @@ vrna_ostream_provide(struct vrna_ordered_stream_s *queue,
                      unsigned int                 i,
                      void                         *data)
 {
+  unsigned int  start, end;
+  struct slot   *s;
+
   if (queue) {
 #if VRNA_WITH_PTHREADS
-    pthread_mutex_lock(&queue->mtx);
+    buffer_acquire(queue);
+#endif
+
+    start = LOAD(queue->start);
+    end   = LOAD(queue->end);
+
+    if ((i - start) >= (end - start)) {
+#if VRNA_WITH_PTHREADS
+      buffer_release(queue);
 #endif
-    if ((queue->end < i) || (i < queue->start)) {
       vrna_message_warning(
-        "vrna_ostream_provide(): data position (%d) out of range [%d:%d]!",
+        "vrna_ostream_provide(): data position (%u) out of range [%u:%u]!",
         i,
-        queue->start,
-        queue->end);
+        start,
+        end - 1);
+      return;
+    }
+
+    /* publish data */
+    s       = queue->slots + (i & (queue->capacity - 1));
+    s->data = data;
+    STORE(s->seq, i + 1);
+
+#if VRNA_WITH_PTHREADS
+    if (queue->has_writer) {
+      buffer_release(queue);
+
+      /* the writer only sleeps while waiting for the element at the start */
+      if ((LOAD(queue->writer_waiting)) &&
+          (i == LOAD(queue->start))) {
+        pthread_mutex_lock(&(queue->mtx));
+        pthread_cond_signal(&(queue->data_available));
+        pthread_mutex_unlock(&(queue->mtx));
+      }
+
       return;
     }
 
-    /* store data */
-    queue->data[i]      = data;
-    queue->provided[i]  = 1;
+    /*
+     *  process all consecutive blocks available from the start unless
+     *  another thread already does so. Since that thread may have missed
+     *  the data we just provided, we need to check again after the
+     *  processing role has been released
+     */
+    do {
+      if (EXCHANGE(queue->processing, 1))
+        break;
+
+      process_output(queue);
 
-    /* process all consecutive blocks available from the start */
+      STORE(queue->processing, 0);
+    } while (data_available(queue));
+
+    buffer_release(queue);
+#else
     if (i == queue->start)
-      flush_output(queue);
+      process_output(queue);
+
+#endif
+  }
+}
+
+
+/*
+ #################################
+ # STATIC helper functions below #
+ #################################
+ */
+PRIVATE struct vrna_ordered_stream_s *
+init_stream(vrna_stream_output_f  output,
+            vrna_stream_flush_f   flush,
+            void                  *auxdata,
+            unsigned int          capacity,
+            unsigned int          options,
+            unsigned char         bounded)
+{
+  unsigned int                  size;
+  struct vrna_ordered_stream_s  *queue;
+
+  if (capacity == 0)
+    capacity = VRNA_OSTREAM_DEFAULT_CAPACITY;
+
+  for (size = 1; size < capacity; size <<= 1);
+
+  queue = (struct vrna_ordered_stream_s *)vrna_alloc(sizeof(struct vrna_ordered_stream_s));
+
+  queue->output   = output;
+  queue->flush    = flush;
+  queue->auxdata  = auxdata;
+  queue->slots    = (struct slot *)vrna_alloc(sizeof(struct slot) * size);
+  queue->capacity = size;
+  queue->start    = 0;
+  queue->end      = 0;
+  queue->bounded  = bounded;
+
+#if VRNA_WITH_PTHREADS
+  queue->processing       = 0;
+  queue->writer_waiting   = 0;
+  queue->requests_waiting = 0;
+  queue->shutdown         = 0;
+  queue->has_writer       = 0;
+
+  pthread_mutex_init(&(queue->mtx), NULL);
+  pthread_cond_init(&(queue->data_available), NULL);
+  pthread_cond_init(&(queue->space_available), NULL);
+  pthread_rwlock_init(&(queue->resize), NULL);
+
+  if ((options & VRNA_OSTREAM_WRITER_THREAD) &&
+      (pthread_create(&(queue->writer), NULL, &writer_loop, (void *)queue) == 0))
+    queue->has_writer = 1;
+
+#endif
+
+  return queue;
+}
+
+
+PRIVATE INLINE int
+data_available(struct vrna_ordered_stream_s *queue)
+{
+  unsigned int i = LOAD(queue->start);
+
+  return (LOAD(queue->slots[i & (queue->capacity - 1)].seq) == i + 1) ? 1 : 0;
+}
+
+
+/*
+ *  Process consecutive data blocks from the start of the stream. Must
+ *  only be called by a single thread at a time
+ */
+PRIVATE unsigned int
+process_output(struct vrna_ordered_stream_s *queue)
+{
+  unsigned int  i, n;
+  struct slot   *s;
+
+  i = queue->start;
+
+  /* limit batch size such that blocked requests are released regularly */
+  for (n = 0; n < queue->capacity; n++, i++) {
+    s = queue->slots + (i & (queue->capacity - 1));
+
+    if (LOAD(s->seq) != i + 1)
+      break;
+
+    if (queue->output)
+      queue->output(queue->auxdata, i, s->data);
+
+    STORE(queue->start, i + 1);
+  }
+
+  if (n > 0) {
+    if (queue->flush)
+      queue->flush(queue->auxdata);
+
+#if VRNA_WITH_PTHREADS
+    if (LOAD(queue->requests_waiting)) {
+      pthread_mutex_lock(&(queue->mtx));
+      pthread_cond_broadcast(&(queue->space_available));
+      pthread_mutex_unlock(&(queue->mtx));
+    }
+
+#endif
+  }
+
+  return n;
+}
+
 
 #if VRNA_WITH_PTHREADS
-    pthread_mutex_unlock(&queue->mtx);
+
+PRIVATE void *
+writer_loop(void *arg)
+{
+  int                           done;
+  struct vrna_ordered_stream_s  *queue = (struct vrna_ordered_stream_s *)arg;
+
+  done = 0;
+
+  while (!done) {
+    if (process_output(queue))
+      continue;
+
+    pthread_mutex_lock(&(queue->mtx));
+
+    STORE(queue->writer_waiting, 1);
+
+    while ((!data_available(queue)) &&
+           (!queue->shutdown))
+      pthread_cond_wait(&(queue->data_available), &(queue->mtx));
+
+    STORE(queue->writer_waiting, 0);
+
+    done = (queue->shutdown) && (!data_available(queue));
+
+    pthread_mutex_unlock(&(queue->mtx));
+  }
+
+  return NULL;
+}
+
+
+/* providers of unbounded streams must not access the buffer while it grows */
+PRIVATE INLINE void
+buffer_acquire(struct vrna_ordered_stream_s *queue)
+{
+  if (!queue->bounded)
+    pthread_rwlock_rdlock(&(queue->resize));
+}
+
+
+PRIVATE INLINE void
+buffer_release(struct vrna_ordered_stream_s *queue)
+{
+  if (!queue->bounded)
+    pthread_rwlock_unlock(&(queue->resize));
+}
+
+
 #endif
+
+/*
+ *  Increase the capacity of the ring buffer such that it holds at least
+ *  size elements from the start of the stream. Requires exclusive access
+ *  to the buffer
+ */
+PRIVATE void
+grow_buffer(struct vrna_ordered_stream_s  *queue,
+            unsigned int                  size)
+{
+  unsigned int  i, capacity;
+  struct slot   *slots, *s;
+
+  for (capacity = queue->capacity; capacity < size; capacity <<= 1);
+
+  slots = (struct slot *)vrna_alloc(sizeof(struct slot) * capacity);
+
+  /* only move data that has already been provided */
+  for (i = queue->start; i != queue->start + queue->capacity; i++) {
+    s = queue->slots + (i & (queue->capacity - 1));
+    if (s->seq == i + 1)
+      slots[i & (capacity - 1)] = *s;
   }
+
+  free(queue->slots);
+
+  queue->slots    = slots;
+  queue->capacity = capacity;
 }
@@ -55,10 +55,44 @@ DEPRECATED(typedef void (vrna_callback_stream_output)(void         *auxdata,
            "Use vrna_stream_output_f instead!");
 
 
+/**
+ *  @brief  Ordered stream batch processing callback
+ *
+ *  This callback will be processed after each batch of consecutive data
+ *  blocks has been passed to the #vrna_stream_output_f callback, e.g. to
+ *  flush the underlying file streams once per batch rather than once
+ *  per data block.
+ *
+ *  @param  auxdata   A shared pointer for all calls, as provided to vrna_ostream_init_bounded()
+ */
+typedef void (*vrna_stream_flush_f)(void *auxdata);
+
+
+/**
+ *  @brief  Default number of data blocks that may be pending in an ordered output stream
+ *
+ *  @see  vrna_ostream_init_bounded(), vrna_ostream_request()
+ */
+#define VRNA_OSTREAM_DEFAULT_CAPACITY   4096U
+
+
+/**
+ *  @brief  Option flag to process the output of an ordered output stream in a dedicated writer thread
+ *
+ *  @see  vrna_ostream_init_bounded()
+ */
+#define VRNA_OSTREAM_WRITER_THREAD      1U
+
+
 /**
  *  @brief  Get an initialized ordered output stream
  *
- *  @see  vrna_ostream_free(), vrna_ostream_request(), vrna_ostream_provide()
+ *  Similar to vrna_ostream_init_bounded() without batch processing callback
+ *  and without dedicated writer thread. The capacity of the stream, however,
+ *  is not limited, i.e. its buffer grows whenever an index is requested
+ *  that exceeds the current capacity, and vrna_ostream_request() never blocks.
+ *
+ *  @see  vrna_ostream_init_bounded(), vrna_ostream_free(), vrna_ostream_request(), vrna_ostream_provide()
  *
  *  @param  output    A callback function that processes and releases data in the stream
  *  @param  auxdata   A pointer to auxiliary data passed as first argument to the @p output callback
@@ -69,6 +103,36 @@ vrna_ostream_init(vrna_stream_output_f output,
                   void                        *auxdata);
 
 
+/**
+ *  @brief  Get an initialized ordered output stream with bounded capacity
+ *
+ *  Data blocks are stored in a ring buffer of (at least) @p capacity elements
+ *  and are published to the stream without locking. The stream processes
+ *  consecutive data blocks from its start either in the thread that provides
+ *  them, or, if @p options contains #VRNA_OSTREAM_WRITER_THREAD, in a
+ *  dedicated writer thread. In either case, the @p output and @p flush
+ *  callbacks are never executed concurrently.
+ *
+ *  @note In non-threaded builds, the @p options are ignored and the buffer
+ *        grows as required, see vrna_ostream_threadsafe().
+ *
+ *  @see  vrna_ostream_init(), vrna_ostream_free(), vrna_ostream_request(), vrna_ostream_provide()
+ *
+ *  @param  output    A callback function that processes and releases data in the stream
+ *  @param  flush     A callback function that is executed after each batch of consecutive data blocks (may be NULL)
+ *  @param  auxdata   A pointer to auxiliary data passed as first argument to the @p output and @p flush callbacks
+ *  @param  capacity  The maximum number of pending data blocks (0 for #VRNA_OSTREAM_DEFAULT_CAPACITY)
+ *  @param  options   Options, e.g. #VRNA_OSTREAM_WRITER_THREAD
+ *  @return           An initialized ordered output stream
+ */
+vrna_ostream_t
+vrna_ostream_init_bounded(vrna_stream_output_f  output,
+                          vrna_stream_flush_f   flush,
+                          void                  *auxdata,
+                          unsigned int          capacity,
+                          unsigned int          options);
+
+
 /**
  *  @brief  Free an initialized ordered output stream
  *
@@ -91,6 +155,14 @@ vrna_ostream_threadsafe(void);
  *  indicate that data associted with a certain index number is expected
  *  to be inserted into the stream in the future.
  *
+ *  Indices are expected to start at 0. For streams obtained from
+ *  vrna_ostream_init_bounded(), this function blocks until enough data from
+ *  the start of the stream has been processed if the stream already holds
+ *  its maximum number of pending data blocks. Requests to such a stream must
+ *  therefore not run ahead of the provided data by more than its capacity
+ *  within a single thread. Streams obtained from vrna_ostream_init() grow
+ *  their buffer instead.
+ *
  *  @see vrna_ostream_init(), vrna_ostream_provide(), vrna_ostream_free()
  *
  *  @param  dat   The output stream for which the index is requested
@@ -139,6 +139,11 @@ init_mx_mfe_default(vrna_fold_compound_t  *fc,
                     unsigned int          alloc_vector);
 
 
+PRIVATE vrna_mx_mfe_t *
+init_mx_mfe_tiled(vrna_fold_compound_t  *fc,
+                  unsigned int          alloc_vector);
+
+
 PRIVATE vrna_mx_mfe_t *
 init_mx_mfe_window(vrna_fold_compound_t *fc,
                    unsigned int         alloc_vector);
@@ -185,6 +190,8 @@ vrna_mx_mfe_free(vrna_fold_compound_t *vc)
     if (self) {
       switch (self->type) {
         case VRNA_MX_DEFAULT:
+        /* fall through */
+        case VRNA_MX_TILED:
           mfe_matrices_free_default(self);
           break;
 
@@ -293,6 +300,10 @@ vrna_mx_pf_add(vrna_fold_compound_t *vc,
 {
   unsigned int mx_alloc_vector;
 
+  /* there is no blocked layout for the partition function matrices */
+  if (mx_type == VRNA_MX_TILED)
+    mx_type = VRNA_MX_DEFAULT;
+
   if (vc->exp_params) {
     mx_alloc_vector = get_mx_alloc_vector(vc,
                                           mx_type,
@@ -323,6 +334,11 @@ vrna_mx_prepare(vrna_fold_compound_t  *vc,
       /* prepare for MFE computation */
       if (options & VRNA_OPTION_WINDOW) /* Windowing approach, a.k.a. locally optimal */
         mx_type = VRNA_MX_WINDOW;
+      else if ((vc->matrices) &&        /* keep tiled matrices as long as they are applicable */
+               (vc->matrices->type == VRNA_MX_TILED) &&
+               (vc->strands == 1) &&
+               (!vc->params->model_details.circ))
+        mx_type = VRNA_MX_TILED;
       else                              /* default is regular MFE */
         mx_type = VRNA_MX_DEFAULT;
 
@@ -404,6 +420,8 @@ get_mx_mfe_alloc_vector_current(vrna_mx_mfe_t   *mx,
   if (mx) {
     switch (mx_type) {
       case VRNA_MX_DEFAULT:
+      /* fall through */
+      case VRNA_MX_TILED:
         if (mx->f5)
           mx_alloc_vector |= ALLOC_F5;
 
@@ -535,6 +553,10 @@ add_mfe_matrices(vrna_fold_compound_t *vc,
         vc->matrices = init_mx_mfe_default(vc, alloc_vector);
         break;
 
+      case VRNA_MX_TILED:
+        vc->matrices = init_mx_mfe_tiled(vc, alloc_vector);
+        break;
+
       case VRNA_MX_WINDOW:
         vc->matrices = init_mx_mfe_window(vc, alloc_vector);
         break;
@@ -610,8 +632,14 @@ get_mx_alloc_vector(vrna_fold_compound_t  *fc,
 
   /* matrices for circular folding ? */
   if (md_p->circ) {
-    md_p->uniq_ML = 1; /* we need unique ML arrays for circular folding */
-    v             |= ALLOC_CIRC;
+    if (!md_p->uniq_ML) {
+      /* we need unique ML arrays for circular folding */
+      fc->params    = vrna_params_unshare(fc->params);
+      md_p          = &(fc->params->model_details);
+      md_p->uniq_ML = 1;
+    }
+
+    v |= ALLOC_CIRC;
   }
 
   /* unique ML decomposition ? */
@@ -645,6 +673,8 @@ mfe_matrices_free_default(vrna_mx_mfe_t *self)
   free(self->fM1);
   free(self->fM2);
   free(self->ggg);
+  free(self->row_offset);
+  free(self->col_offset);
 }
 
 
@@ -1344,6 +1374,91 @@ init_mx_mfe_default(vrna_fold_compound_t  *fc,
 
     if (alloc_vector & ALLOC_CIRC)
       mx->fM2 = (int *)vrna_alloc(sizeof(int) * lin_size);
+
+    /* column-wise addressing, i.e. the same as fc->jindx[j] + i */
+    mx->row_offset  = (int *)vrna_alloc(sizeof(int) * lin_size);
+    mx->col_offset  = (int *)vrna_alloc(sizeof(int) * lin_size);
+
+    for (s = 0; s < lin_size; s++) {
+      mx->row_offset[s] = (int)s;
+      mx->col_offset[s] = (int)((s * (s - 1)) / 2);
+    }
+  }
+
+  return mx;
+}
+
+
+PRIVATE vrna_mx_mfe_t *
+init_mx_mfe_tiled(vrna_fold_compound_t  *fc,
+                  unsigned int          alloc_vector)
+{
+  unsigned int  n, i, p, b, lin_size;
+  size_t        size;
+  vrna_mx_mfe_t *mx;
+  vrna_mx_mfe_t init = {
+    .type = VRNA_MX_TILED
+  };
+
+  n         = fc->length;
+  b         = VRNA_MX_TILE_SIZE;
+  lin_size  = n + 2;
+
+  if (alloc_vector & (ALLOC_CIRC | ALLOC_MULTISTRAND)) {
+    vrna_message_warning("init_mx_mfe_tiled(): "
+                         "tiled matrices are not available for circular or multi-strand folding");
+    return NULL;
+  }
+
+  /*
+   *  columns are grouped into panels of b consecutive columns. Panel p
+   *  consists of the p + 2 square tiles of b x b entries that cover rows
+   *  0, ..., (p + 2) * b - 1, i.e. at least up to row j + 1 for each column
+   *  j of the panel. Within a tile, rows are stored contiguously. This keeps
+   *  the addressing separable into a row and a column offset, while all
+   *  entries (k,l) in the vicinity of (i,j) end up in only a few tiles
+   */
+  for (size = 0, p = 0; p * b < lin_size; p++)
+    size += (size_t)b * b * (p + 2);
+
+  if (size >= (size_t)INT_MAX) {
+    vrna_message_warning("init_mx_mfe_tiled(): "
+                         "sequence length %d exceeds addressable range",
+                         n);
+    return NULL;
+  }
+
+  mx = vrna_alloc(sizeof(vrna_mx_mfe_t));
+
+  if (mx) {
+    memcpy(mx, &init, sizeof(vrna_mx_mfe_t));
+    nullify_mfe(mx);
+
+    mx->length      = n;
+    mx->strands     = fc->strands;
+    mx->row_offset  = (int *)vrna_alloc(sizeof(int) * lin_size);
+    mx->col_offset  = (int *)vrna_alloc(sizeof(int) * lin_size);
+
+    for (i = 0; i < lin_size; i++) {
+      p                 = i / b;
+      mx->row_offset[i] = (int)(p * b * b + i % b);
+      mx->col_offset[i] = (int)((size_t)b * b * ((p * (p + 3)) / 2) + (i % b) * b);
+    }
+
+    if (alloc_vector & ALLOC_F5)
+      mx->f5 = (int *)vrna_alloc(sizeof(int) * lin_size);
+
+    if (alloc_vector & ALLOC_F3)
+      mx->f3 = (int *)vrna_alloc(sizeof(int) * lin_size);
+
+    if (alloc_vector & ALLOC_C)
+      mx->c = (int *)vrna_alloc(sizeof(int) * size);
+
+    if (alloc_vector & ALLOC_FML)
+      mx->fML = (int *)vrna_alloc(sizeof(int) * size);
+
+    if (alloc_vector & ALLOC_UNIQ)
+      mx->fM1 = (int *)vrna_alloc(sizeof(int) * size);
   }
 
   return mx;
@@ -1511,19 +1626,23 @@ nullify_mfe(vrna_mx_mfe_t *mx)
 
     switch (mx->type) {
       case VRNA_MX_DEFAULT:
-        mx->c     = NULL;
-        mx->f5    = NULL;
-        mx->f3    = NULL;
-        mx->fms5  = NULL;
-        mx->fms3  = NULL;
-        mx->fML   = NULL;
-        mx->fM1   = NULL;
-        mx->fM2   = NULL;
-        mx->ggg   = NULL;
-        mx->Fc    = INF;
-        mx->FcH   = INF;
-        mx->FcI   = INF;
-        mx->FcM   = INF;
+      /* fall through */
+      case VRNA_MX_TILED:
+        mx->c          = NULL;
+        mx->f5         = NULL;
+        mx->f3         = NULL;
+        mx->fms5       = NULL;
+        mx->fms3       = NULL;
+        mx->fML        = NULL;
+        mx->fM1        = NULL;
+        mx->fM2        = NULL;
+        mx->ggg        = NULL;
+        mx->Fc         = INF;
+        mx->FcH        = INF;
+        mx->FcI        = INF;
+        mx->FcM        = INF;
+        mx->row_offset = NULL;
+        mx->col_offset = NULL;
         break;
 
       case VRNA_MX_WINDOW:
@@ -1923,6 +2042,9 @@ nullify_pf(vrna_mx_pf_t *mx)
         mx->Q_cM_rem    = 0.;
 
         break;
+
+      default:                /* do nothing */
+        break;
     }
   }
 }
@@ -36,11 +36,42 @@ typedef enum {
                      *    window approach.
                      *    @see    vrna_mfe_window(), vrna_mfe_window_zscore(), pfl_fold()
                      */
-  VRNA_MX_2DFOLD    /**<  @brief  DP matrices suitable for distance class partitioned structure prediction
+  VRNA_MX_2DFOLD,   /**<  @brief  DP matrices suitable for distance class partitioned structure prediction
                      *    @see  vrna_mfe_TwoD(), vrna_pf_TwoD()
                      */
+  VRNA_MX_TILED     /**<  @brief  Default MFE DP matrices in a blocked (tiled) memory layout
+                     *    @see  #VRNA_MX_TILE_SIZE, VRNA_MX_MFE_IDX()
+                     */
 } vrna_mx_type_e;
 
+
+/**
+ *  @brief  Number of rows and columns of a single tile in #VRNA_MX_TILED matrices
+ *
+ *  The triangular matrices c, fML, and fM1 of the #VRNA_MX_TILED type are split
+ *  into panels of #VRNA_MX_TILE_SIZE consecutive columns. Each panel is stored as
+ *  a sequence of square tiles with contiguous rows, such that all entries
+ *  @f$ (k,l) @f$ in the vicinity of @f$ (i,j) @f$ share only a few cache lines.
+ */
+#define VRNA_MX_TILE_SIZE   64
+
+
+/**
+ *  @brief  Get the linear index of entry (i, j) in the c, fML, and fM1 MFE matrices
+ *
+ *  This accessor is valid for both, #VRNA_MX_DEFAULT and #VRNA_MX_TILED matrices.
+ *  For the former, it yields the same index as @code fc->jindx[j] + i @endcode.
+ *  Consecutive rows @f$ i, i + 1, \ldots @f$ of a column are stored contiguously
+ *  for default matrices, and within each tile of #VRNA_MX_TILE_SIZE rows for
+ *  tiled matrices only.
+ *
+ *  @param  mx  The MFE matrices data structure (#vrna_mx_mfe_t)
+ *  @param  i   The row index
+ *  @param  j   The column index
+ */
+#define VRNA_MX_MFE_IDX(mx, i, j)   ((mx)->col_offset[(j)] + (mx)->row_offset[(i)])
+
+
 /**
  *  @brief  Minimum Free Energy (MFE) Dynamic Programming (DP) matrices data structure required within the #vrna_fold_compound_t
  */
@@ -63,6 +94,8 @@ struct vrna_mx_mfe_s {
   /** @name Default DP matrices
    *  @note These data fields are available if
    *        @code vrna_mx_mfe_t.type == VRNA_MX_DEFAULT @endcode
+   *        or
+   *        @code vrna_mx_mfe_t.type == VRNA_MX_TILED @endcode
    * @{
    */
   int *c;           /**<  @brief  Energy array, given that i-j pair */
@@ -78,6 +111,8 @@ struct vrna_mx_mfe_s {
   int FcH;          /**<  @brief  Minimum Free Energy of hairpin loop cases in circular RNA */
   int FcI;          /**<  @brief  Minimum Free Energy of internal loop cases in circular RNA */
   int FcM;          /**<  @brief  Minimum Free Energy of multibranch loop cases in circular RNA */
+  int *row_offset;  /**<  @brief  Row offsets into c, fML, and fM1, see VRNA_MX_MFE_IDX() */
+  int *col_offset;  /**<  @brief  Column offsets into c, fML, and fM1, see VRNA_MX_MFE_IDX() */
   /**
    * @}
    */
@@ -374,7 +409,9 @@ struct {
  *
  *  @note Usually, there is no need to call this function, since
  *        the constructors of #vrna_fold_compound_t are handling all the DP
- *        matrix memory allocation.
+ *        matrix memory allocation. An exception is the #VRNA_MX_TILED
+ *        layout for single sequence or comparative MFE prediction, which
+ *        must be requested explicitly prior to calling vrna_mfe().
  *
  *  @see  vrna_mx_mfe_add(), vrna_mx_pf_add(), vrna_fold_compound(),
  *        vrna_fold_compound_comparative(), vrna_fold_compound_free(),
@@ -16,7 +16,12 @@
 #include <float.h>    /* #defines FLT_MAX ... */
 #include <limits.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/utils/cpu.h"
 #include "ViennaRNA/params/default.h"
 #include "ViennaRNA/fold_vars.h"
 #include "ViennaRNA/loops/all.h"
@@ -222,6 +227,24 @@ compute_bpp_multibranch_comparative(vrna_fold_compound_t  *fc,
                                     constraints_helper    *constraints);
 
 
+PRIVATE int
+bpp_threads(vrna_fold_compound_t *fc);
+
+
+#ifdef _OPENMP
+PRIVATE void
+compute_bpp_multibranch_parallel(vrna_fold_compound_t *fc,
+                                 int                  l,
+                                 helper_arrays        *ml_helpers,
+                                 FLT_OR_DBL           *Qmax,
+                                 int                  *ov,
+                                 constraints_helper   *constraints,
+                                 int                  num_threads);
+
+
+#endif
+
+
 PRIVATE FLT_OR_DBL
 contrib_ext_pair(vrna_fold_compound_t *fc,
                  unsigned int         i,
@@ -283,6 +306,7 @@ vrna_pr_structure(vrna_fold_compound_t  *fc,
     if (fc->params->model_details.dangles % 2) {
       /* only compute probabilities with dangles = 2 || 0 */
       int dang_bak = fc->params->model_details.dangles;
+      fc->params                        = vrna_params_unshare(fc->params);
       fc->params->model_details.dangles = 2;
       e                                 = (double)vrna_eval_structure(fc, structure);
       fc->params->model_details.dangles = dang_bak;
@@ -1212,7 +1236,7 @@ compute_bpp_internal(vrna_fold_compound_t *fc,
   char                  *ptype;
   short                 *S1;
   int                   i, j, k, n, ij, kl, u1, u2, *my_iindx, *jindx, *rtype,
-                        with_ud, *hc_up_int;
+                        with_ud, *hc_up_int, num_threads;
   FLT_OR_DBL            temp, tmp2, *qb, *probs, *scale;
   double                max_real;
   vrna_exp_param_t      *pf_params;
@@ -1248,7 +1272,18 @@ compute_bpp_internal(vrna_fold_compound_t *fc,
 
   max_real = (sizeof(FLT_OR_DBL) == sizeof(float)) ? FLT_MAX : DBL_MAX;
 
+  /*
+   *  all pairs (k, l) only receive contributions from pairs (i, j) with j > l,
+   *  so we may process them in parallel unless we need to store probability
+   *  corrections for auxiliary base pairs
+   */
+  num_threads = ((sc) && (sc->exp_f) && (sc->bt)) ? 1 : bpp_threads(fc);
+
   /* 2. bonding k,l as substem of 2:loop enclosed by i,j */
+#ifdef _OPENMP
+#pragma omp parallel for private(i, j, ij, kl, u1, u2, type, type_2, temp, tmp2) \
+  schedule(dynamic) num_threads(num_threads) if (num_threads > 1)
+#endif
   for (k = 1; k < l; k++) {
     kl = my_iindx[k] - l;
 
@@ -1346,6 +1381,13 @@ compute_bpp_internal(vrna_fold_compound_t *fc,
         }
       }
     }
+  }
+
+  for (k = 1; k < l; k++) {
+    kl = my_iindx[k] - l;
+
+    if (qb[kl] == 0.)
+      continue;
 
     if (probs[kl] > (*Qmax)) {
       (*Qmax) = probs[kl];
@@ -1542,6 +1584,16 @@ compute_bpp_multibranch(vrna_fold_compound_t  *fc,
   hc_eval     = constraints->hc_eval_mb;
   sc_wrapper  = &(constraints->sc_wrapper_mb);
 
+#ifdef _OPENMP
+  int num_threads = (with_ud) ? 1 : bpp_threads(fc);
+
+  if (num_threads > 1) {
+    compute_bpp_multibranch_parallel(fc, l, ml_helpers, Qmax, ov, constraints, num_threads);
+    return;
+  }
+
+#endif
+
   prm_MLb   = 0.;
   max_real  = (sizeof(FLT_OR_DBL) == sizeof(float)) ? FLT_MAX : DBL_MAX;
 
@@ -1752,6 +1804,237 @@ compute_bpp_multibranch(vrna_fold_compound_t  *fc,
 }
 
 
+/*
+ *  Number of threads for the outside recursions of a single sequence. We only
+ *  parallelize loops whose iterations write to distinct entries and keep the
+ *  serial summation order within each entry, so the resulting probabilities
+ *  are identical to those of the serial implementation
+ */
+PRIVATE int
+bpp_threads(vrna_fold_compound_t *fc)
+{
+  vrna_md_t *md = &(fc->exp_params->model_details);
+
+  if ((md->threads == 1) ||
+      (fc->strands > 1))
+    return 1;
+
+  return vrna_cpu_threads(md->threads);
+}
+
+
+#ifdef _OPENMP
+/*
+ *  Same as compute_bpp_multibranch() for a single strand without unstructured
+ *  domains. The serial implementation intertwines two linear recurrences over k
+ *  (prm_MLb and the cumulative prml) with two O(n) sums for each k. We first
+ *  compute the sums over enclosing pairs (i, j) in parallel, then resolve the
+ *  recurrences serially, and finally decompose the multibranch loop parts for
+ *  all k in parallel
+ */
+PRIVATE void
+compute_bpp_multibranch_parallel(vrna_fold_compound_t *fc,
+                                 int                  l,
+                                 helper_arrays        *ml_helpers,
+                                 FLT_OR_DBL           *Qmax,
+                                 int                  *ov,
+                                 constraints_helper   *constraints,
+                                 int                  num_threads)
+{
+  unsigned char         tt;
+  char                  *ptype;
+  short                 *S, *S1, s3;
+  int                   i, j, k, n, ii, ij, kl, lj, *my_iindx, *jindx, *rtype, with_gquad;
+  FLT_OR_DBL            temp, ppp, prm_MLb, prmt, prmt1, *prm_MLb_k, *prml, *prm_l, *prm_l1,
+                        *qb, *probs, *qm, *G, *scale, *expMLbase, expMLclosing, expMLstem;
+  double                max_real;
+  vrna_exp_param_t      *pf_params;
+  vrna_md_t             *md;
+  struct hc_mb_def_dat  *hc_dat;
+  vrna_hc_eval_f        hc_eval;
+  struct sc_mb_exp_dat  *sc_wrapper;
+
+  n             = (int)fc->length;
+  S             = fc->sequence_encoding2;
+  S1            = fc->sequence_encoding;
+  my_iindx      = fc->iindx;
+  jindx         = fc->jindx;
+  pf_params     = fc->exp_params;
+  md            = &(pf_params->model_details);
+  rtype         = &(md->rtype[0]);
+  ptype         = fc->ptype;
+  qb            = fc->exp_matrices->qb;
+  qm            = fc->exp_matrices->qm;
+  G             = fc->exp_matrices->G;
+  probs         = fc->exp_matrices->probs;
+  scale         = fc->exp_matrices->scale;
+  expMLbase     = fc->exp_matrices->expMLbase;
+  expMLclosing  = pf_params->expMLclosing;
+  with_gquad    = md->gquad;
+  expMLstem     = (with_gquad) ? exp_E_MLstem(0, -1, -1, pf_params) : 0;
+  prml          = ml_helpers->prml;
+  prm_l         = ml_helpers->prm_l;
+  prm_l1        = ml_helpers->prm_l1;
+  max_real      = (sizeof(FLT_OR_DBL) == sizeof(float)) ? FLT_MAX : DBL_MAX;
+
+  hc_dat      = &(constraints->hc_dat_mb);
+  hc_eval     = constraints->hc_eval_mb;
+  sc_wrapper  = &(constraints->sc_wrapper_mb);
+
+  prm_MLb_k = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 2));
+
+  /* 1st, all multibranch loops (k - 1, j) with left-most stem (k, l) */
+#pragma omp parallel for private(i, j, ii, ij, lj, s3, tt, ppp, prmt, prmt1) \
+  schedule(dynamic) num_threads(num_threads)
+  for (k = 2; k < l; k++) {
+    i     = k - 1;
+    prmt  = prmt1 = 0.0;
+
+    ij  = my_iindx[i] - (l + 2);
+    lj  = my_iindx[l + 1] - (l + 1);
+    s3  = S1[i + 1];
+
+    for (j = l + 2; j <= n; j++, ij--, lj--) {
+      if (hc_eval(i, j, i + 1, j - 1, VRNA_DECOMP_PAIR_ML, hc_dat)) {
+        tt  = vrna_get_ptype_md(S[j], S[i], md);
+        ppp = probs[ij] *
+              exp_E_MLstem(tt, S1[j - 1], s3, pf_params) *
+              qm[lj];
+
+        if (sc_wrapper->pair)
+          ppp *= sc_wrapper->pair(i, j, sc_wrapper);
+
+        prmt += ppp;
+      }
+    }
+
+    ii  = my_iindx[i];
+    tt  = rtype[vrna_get_ptype(jindx[l + 1] + i, ptype)];
+    if (hc_eval(i, l + 1, i + 1, l, VRNA_DECOMP_PAIR_ML, hc_dat)) {
+      prmt1 = probs[ii - (l + 1)] *
+              exp_E_MLstem(tt,
+                           S1[l],
+                           S1[i + 1],
+                           pf_params) *
+              expMLclosing;
+
+      if (sc_wrapper->pair)
+        prmt1 *= sc_wrapper->pair(i, l + 1, sc_wrapper);
+    }
+
+    prml[i] = prmt * expMLclosing;
+
+    /* l+1 is unpaired */
+    if (hc_eval(k, l + 1, k, l, VRNA_DECOMP_ML_ML, hc_dat)) {
+      ppp = prm_l1[i] *
+            expMLbase[1];
+
+      if (sc_wrapper->red_ml)
+        ppp *= sc_wrapper->red_ml(k, l + 1, k, l, sc_wrapper);
+
+      prm_l[i] = ppp + prmt1;
+    } else {
+      prm_l[i] = prmt1;
+    }
+  }
+
+  /* 2nd, the linear recurrences for prm_MLb and prml */
+  prm_MLb = 0.;
+
+  for (k = 2; k < l; k++) {
+    i = k - 1;
+
+    if (hc_eval(i, l, i + 1, l, VRNA_DECOMP_ML_ML, hc_dat)) {
+      ppp = prm_MLb *
+            expMLbase[1];
+
+      if (sc_wrapper->red_ml)
+        ppp *= sc_wrapper->red_ml(i, l, i + 1, l, sc_wrapper);
+
+      prm_MLb = ppp + prml[i];
+    } else {
+      prm_MLb = prml[i];
+    }
+
+    prm_MLb_k[k]  = prm_MLb;
+    prml[i]       = prml[i] + prm_l[i];
+  }
+
+  /* 3rd, the actual multibranch loop decomposition for each pair (k, l) */
+#pragma omp parallel for private(i, kl, tt, temp) schedule(dynamic) num_threads(num_threads)
+  for (k = 2; k < l; k++) {
+    kl  = my_iindx[k] - l;
+    tt  = ptype[jindx[l] + k];
+
+    if (with_gquad) {
+      if ((!tt) &&
+          (G[kl] == 0.))
+        continue;
+    } else {
+      if (qb[kl] == 0.)
+        continue;
+    }
+
+    temp = prm_MLb_k[k];
+
+    if (sc_wrapper->decomp_ml) {
+      for (i = 1; i <= k - 2; i++)
+        temp += prml[i] *
+                qm[my_iindx[i + 1] - (k - 1)] *
+                sc_wrapper->decomp_ml(i + 1, l, k - 1, k, sc_wrapper);
+    } else {
+      for (i = 1; i <= k - 2; i++)
+        temp += prml[i] *
+                qm[my_iindx[i + 1] - (k - 1)];
+    }
+
+    if ((with_gquad) &&
+        (qb[kl] == 0.)) {
+      temp *= G[kl] *
+              expMLstem;
+    } else if (hc_eval(k, l, k, l, VRNA_DECOMP_ML_STEM, hc_dat)) {
+      if (tt == 0)
+        tt = 7;
+
+      temp *= exp_E_MLstem(tt, S1[k - 1], (l < n) ? S1[l + 1] : -1, pf_params);
+    }
+
+    if (sc_wrapper->red_stem)
+      temp *= sc_wrapper->red_stem(k, l, k, l, sc_wrapper);
+
+    probs[kl] += temp *
+                 scale[2];
+  }
+
+  for (k = 2; k < l; k++) {
+    kl  = my_iindx[k] - l;
+    tt  = ptype[jindx[l] + k];
+
+    if ((with_gquad) ? ((!tt) && (G[kl] == 0.)) : (qb[kl] == 0.))
+      continue;
+
+    if (probs[kl] > (*Qmax)) {
+      (*Qmax) = probs[kl];
+      if ((*Qmax) > max_real / 10.)
+        vrna_message_warning("P close to overflow: %d %d %g %g\n",
+                             k, l, probs[kl], qb[kl]);
+    }
+
+    if (probs[kl] >= max_real) {
+      (*ov)++;
+      probs[kl] = FLT_MAX;
+    }
+  }
+
+  free(prm_MLb_k);
+
+  rotate_ml_helper_arrays_outer(ml_helpers);
+}
+
+
+#endif
+
+
 PRIVATE void
 compute_bpp_multibranch_comparative(vrna_fold_compound_t  *fc,
                                     int                   l,
@@ -66,11 +66,42 @@
  #################################
  */
 
+struct vrna_loop_cache_s {
+  unsigned int  length;
+  short         *pt;      /* pair table of the current structure */
+  int           *loop_e;  /* energy of the loop closed by (i, pt[i]), exterior loop at 0 */
+  int           *outer;   /* 5' position of the pair enclosing position i, 0 for the exterior loop */
+  int           energy;   /* free energy of the current structure */
+  int           local;    /* whether or not moves may be evaluated from the loop decomposition */
+};
+
 /*
  #################################
  # PRIVATE FUNCTION DECLARATIONS #
  #################################
  */
+PRIVATE int
+cache_insert(vrna_fold_compound_t *fc,
+             vrna_loop_cache_t    *cache,
+             int                  k,
+             int                  l,
+             int                  store);
+
+
+PRIVATE int
+cache_delete(vrna_fold_compound_t *fc,
+             vrna_loop_cache_t    *cache,
+             int                  k,
+             int                  l,
+             int                  store);
+
+
+PRIVATE void
+cache_update(vrna_loop_cache_t  *cache,
+             int                m1,
+             int                m2);
+
+
 PRIVATE int
 stack_energy(vrna_fold_compound_t *fc,
              int                  i,
@@ -402,6 +433,206 @@ vrna_eval_move_pt(vrna_fold_compound_t  *fc,
 }
 
 
+PUBLIC vrna_loop_cache_t *
+vrna_loop_cache_init(vrna_fold_compound_t *fc,
+                     const short          *pt)
+{
+  int               i, n, top, *stack;
+  vrna_loop_cache_t *cache;
+
+  cache = NULL;
+
+  if ((fc) &&
+      (pt)) {
+    n = (int)fc->length;
+
+    if (pt[0] != (short)n) {
+      vrna_message_warning("vrna_loop_cache_init: "
+                           "sequence and structure have unequal length (%d vs. %d)",
+                           n,
+                           pt[0]);
+      return cache;
+    }
+
+    cache         = (vrna_loop_cache_t *)vrna_alloc(sizeof(vrna_loop_cache_t));
+    cache->length = fc->length;
+    cache->pt     = vrna_ptable_copy(pt);
+    cache->loop_e = (int *)vrna_alloc(sizeof(int) * (n + 1));
+    cache->outer  = (int *)vrna_alloc(sizeof(int) * (n + 1));
+    cache->energy = vrna_eval_structure_pt(fc, pt);
+
+    /*
+     *  Loops of structures formed by multiple strands may span strand
+     *  nicks, and with coaxial stacking (dangles = 3) the energy of a loop
+     *  also depends on its enclosing loop. We therefore use the loop
+     *  decomposition only if loop energies are strictly local and fall
+     *  back to plain move evaluation otherwise
+     */
+    cache->local = ((fc->strands == 1) &&
+                    (fc->params->model_details.dangles != 3)) ? 1 : 0;
+
+    if (cache->local) {
+      stack = (int *)vrna_alloc(sizeof(int) * (n + 1));
+      top   = 0;
+
+      cache->loop_e[0] = vrna_eval_loop_pt(fc, 0, pt);
+
+      for (i = 1; i <= n; i++) {
+        if ((pt[i] > 0) &&
+            (pt[i] < i)) {
+          cache->outer[i] = cache->outer[pt[i]];
+          top--;
+        } else {
+          cache->outer[i] = (top > 0) ? stack[top - 1] : 0;
+          if (pt[i] > i) {
+            cache->loop_e[i]  = vrna_eval_loop_pt(fc, i, pt);
+            stack[top++]      = i;
+          }
+        }
+      }
+
+      free(stack);
+    }
+  }
+
+  return cache;
+}
+
+
+PUBLIC void
+vrna_loop_cache_free(vrna_loop_cache_t *cache)
+{
+  if (cache) {
+    free(cache->pt);
+    free(cache->loop_e);
+    free(cache->outer);
+    free(cache);
+  }
+}
+
+
+PUBLIC int
+vrna_loop_cache_energy(const vrna_loop_cache_t *cache)
+{
+  return (cache) ? cache->energy : INF;
+}
+
+
+PUBLIC const short *
+vrna_loop_cache_ptable(const vrna_loop_cache_t *cache)
+{
+  return (cache) ? (const short *)cache->pt : NULL;
+}
+
+
+PUBLIC int
+vrna_eval_move_cache(vrna_fold_compound_t *fc,
+                     vrna_loop_cache_t    *cache,
+                     int                  m1,
+                     int                  m2)
+{
+  int         e, k, i, l, p, e_outer, e_inner;
+  vrna_move_t m;
+
+  e = INF;
+
+  if ((fc) &&
+      (cache) &&
+      (cache->length == fc->length)) {
+    m = vrna_move_init(m1, m2);
+
+    if (!cache->local)
+      return vrna_eval_move_shift_pt(fc, &m, cache->pt);
+
+    if (vrna_move_is_shift(&m)) {
+      /* split shift move into deletion and insertion */
+      k = (m1 > 0) ? m1 : m2;
+      l = (m1 > 0) ? -m2 : -m1;
+      i = (k <= (int)cache->length) ? cache->pt[k] : 0;
+
+      if (i == 0)
+        return INF;
+
+      p       = cache->outer[MIN2(k, i)];
+      e_outer = cache->loop_e[p];
+      e_inner = cache->loop_e[MIN2(k, i)];
+      e       = cache_delete(fc, cache, MIN2(k, i), MAX2(k, i), 1);
+
+      if (e != INF) {
+        cache_update(cache, -MIN2(k, i), -MAX2(k, i));
+        e = ADD_OR_INF(e, cache_insert(fc, cache, MIN2(k, l), MAX2(k, l), 0));
+        cache_update(cache, MIN2(k, i), MAX2(k, i));
+
+        cache->loop_e[p]          = e_outer;
+        cache->loop_e[MIN2(k, i)] = e_inner;
+      }
+    } else if (m1 < 0) {
+      e = cache_delete(fc, cache, -m1, -m2, 0);
+    } else {
+      e = cache_insert(fc, cache, m1, m2, 0);
+    }
+  }
+
+  return e;
+}
+
+
+PUBLIC int
+vrna_loop_cache_apply(vrna_fold_compound_t  *fc,
+                      vrna_loop_cache_t     *cache,
+                      int                   m1,
+                      int                   m2)
+{
+  int         e, e_ins, k, i, l;
+  vrna_move_t m;
+
+  e = INF;
+
+  if ((fc) &&
+      (cache) &&
+      (cache->length == fc->length)) {
+    m = vrna_move_init(m1, m2);
+
+    if (!cache->local) {
+      e = vrna_eval_move_shift_pt(fc, &m, cache->pt);
+      if (e != INF)
+        vrna_move_apply(cache->pt, &m);
+    } else if (vrna_move_is_shift(&m)) {
+      k = (m1 > 0) ? m1 : m2;
+      l = (m1 > 0) ? -m2 : -m1;
+      i = (k <= (int)cache->length) ? cache->pt[k] : 0;
+
+      if ((i != 0) &&
+          ((e = cache_delete(fc, cache, MIN2(k, i), MAX2(k, i), 1)) != INF)) {
+        cache_update(cache, -MIN2(k, i), -MAX2(k, i));
+
+        e_ins = cache_insert(fc, cache, MIN2(k, l), MAX2(k, l), 1);
+        if (e_ins != INF) {
+          cache_update(cache, MIN2(k, l), MAX2(k, l));
+          e += e_ins;
+        } else {
+          /* restore the original pair */
+          (void)cache_insert(fc, cache, MIN2(k, i), MAX2(k, i), 1);
+          cache_update(cache, MIN2(k, i), MAX2(k, i));
+          e = INF;
+        }
+      }
+    } else if (m1 < 0) {
+      if ((e = cache_delete(fc, cache, -m1, -m2, 1)) != INF)
+        cache_update(cache, m1, m2);
+    } else {
+      if ((e = cache_insert(fc, cache, m1, m2, 1)) != INF)
+        cache_update(cache, m1, m2);
+    }
+
+    if (e != INF)
+      cache->energy += e;
+  }
+
+  return e;
+}
+
+
 /*
  #################################
  # STATIC helper functions below #
@@ -492,14 +723,21 @@ wrap_eval_structure(vrna_fold_compound_t  *fc,
   n_seq     = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq;
   md        = &(fc->params->model_details);
   gq        = md->gquad;
-  md->gquad = 0;
+
+  if (gq) {
+    /* energy parameters may be shared with other fold compounds */
+    fc->params  = vrna_params_unshare(fc->params);
+    md          = &(fc->params->model_details);
+    md->gquad   = 0;
+  }
 
   if (md->circ)
     res = eval_circ_pt(fc, pt, output_stream, verbosity);
   else
     res = eval_pt(fc, pt, output_stream, verbosity);
 
-  md->gquad = gq;
+  if (gq)
+    md->gquad = gq;
 
   if (gq && (parse_gquad(structure, &L, l) > 0)) {
     if (verbosity > 0)
@@ -2133,3 +2371,129 @@ energy_of_ml_pt(vrna_fold_compound_t  *fc,
 
   return energy + bonus;
 }
+
+
+/*
+ *  Energy change of inserting pair (k,l) into the cached structure.
+ *  The novel loop energies are stored in the cache if 'store' is
+ *  non-zero, the pair table remains unchanged
+ */
+PRIVATE int
+cache_insert(vrna_fold_compound_t *fc,
+             vrna_loop_cache_t    *cache,
+             int                  k,
+             int                  l,
+             int                  store)
+{
+  int   p, e, e_in, e_out;
+  short *pt = cache->pt;
+
+  if ((k <= 0) ||
+      (k >= l) ||
+      (l > (int)cache->length) ||
+      (pt[k] != 0) ||
+      (pt[l] != 0) ||
+      (cache->outer[k] != cache->outer[l])) {
+    vrna_message_warning("vrna_eval_move_cache: "
+                         "illegal insertion move (%d,%d)",
+                         k, l);
+    return INF;
+  }
+
+  p     = cache->outer[k];
+  pt[k] = l;
+  pt[l] = k;
+  e_in  = vrna_eval_loop_pt(fc, k, (const short *)pt);
+  e_out = vrna_eval_loop_pt(fc, p, (const short *)pt);
+  pt[k] = 0;
+  pt[l] = 0;
+
+  e = e_in + e_out - cache->loop_e[p];
+
+  if (store) {
+    cache->loop_e[k]  = e_in;
+    cache->loop_e[p]  = e_out;
+  }
+
+  return e;
+}
+
+
+/*
+ *  Energy change of deleting pair (k,l) from the cached structure.
+ *  The novel loop energy is stored in the cache if 'store' is
+ *  non-zero, the pair table remains unchanged
+ */
+PRIVATE int
+cache_delete(vrna_fold_compound_t *fc,
+             vrna_loop_cache_t    *cache,
+             int                  k,
+             int                  l,
+             int                  store)
+{
+  int   p, e, e_out;
+  short *pt = cache->pt;
+
+  if ((k <= 0) ||
+      (k >= l) ||
+      (l > (int)cache->length) ||
+      (pt[k] != l)) {
+    vrna_message_warning("vrna_eval_move_cache: "
+                         "illegal deletion move (%d,%d)",
+                         -k, -l);
+    return INF;
+  }
+
+  p     = cache->outer[k];
+  pt[k] = 0;
+  pt[l] = 0;
+  e_out = vrna_eval_loop_pt(fc, p, (const short *)pt);
+  pt[k] = l;
+  pt[l] = k;
+
+  e = e_out - cache->loop_e[p] - cache->loop_e[k];
+
+  if (store) {
+    cache->loop_e[k]  = 0;
+    cache->loop_e[p]  = e_out;
+  }
+
+  return e;
+}
+
+
+/*
+ *  Apply an insertion (m1 > 0) or deletion (m1 < 0) move to the pair
+ *  table of the cache and re-assign the enclosing loop of all positions
+ *  directly within the affected pair
+ */
+PRIVATE void
+cache_update(vrna_loop_cache_t  *cache,
+             int                m1,
+             int                m2)
+{
+  int   k, l, x, p;
+  short *pt = cache->pt;
+
+  if (m1 < 0) {
+    k     = -m1;
+    l     = -m2;
+    p     = cache->outer[k];
+    pt[k] = 0;
+    pt[l] = 0;
+  } else {
+    k     = m1;
+    l     = m2;
+    p     = k;
+    pt[k] = l;
+    pt[l] = k;
+  }
+
+  for (x = k + 1; x < l; x++) {
+    cache->outer[x] = p;
+    if (pt[x] > x) {
+      x               = pt[x];
+      cache->outer[x] = p;
+    }
+  }
+}
@@ -947,6 +947,114 @@ vrna_eval_move_shift_pt(vrna_fold_compound_t  *fc,
                         short                 *structure);
 
 
+/**
+ *  @brief  Loop decomposition of a secondary structure for fast move evaluation
+ *
+ *  @see  vrna_loop_cache_init(), vrna_eval_move_cache(), vrna_loop_cache_apply(),
+ *        vrna_loop_cache_free()
+ */
+typedef struct vrna_loop_cache_s vrna_loop_cache_t;
+
+
+/**
+ *  @brief  Create a loop decomposition cache for a secondary structure
+ *
+ *  The cache stores a copy of the pair table together with the free energy
+ *  of each loop and the enclosing loop of each nucleotide. Energy changes
+ *  of moves to neighboring structures are then obtained by evaluating the
+ *  affected loops only, see vrna_eval_move_cache(). Applying a move with
+ *  vrna_loop_cache_apply() updates the cache in place.
+ *
+ *  @note The cache must not be used with a fold compound other than @p fc
+ *        or after modification of its energy parameters or constraints.
+ *        For fold compounds with multiple strands or coaxial stacking
+ *        (#vrna_md_t.dangles = 3), the cache falls back to vrna_eval_move_shift_pt().
+ *
+ *  @see  vrna_loop_cache_free(), vrna_eval_move_cache(), vrna_loop_cache_apply()
+ *
+ *  @param fc   A vrna_fold_compound_t containing the energy parameters and model details
+ *  @param pt   The pair table of the secondary structure
+ *  @return     The loop decomposition cache, or @em NULL on any error
+ */
+vrna_loop_cache_t *
+vrna_loop_cache_init(vrna_fold_compound_t *fc,
+                     const short          *pt);
+
+
+/**
+ *  @brief  Release memory occupied by a loop decomposition cache
+ *
+ *  @see  vrna_loop_cache_init()
+ *
+ *  @param cache  The loop decomposition cache
+ */
+void
+vrna_loop_cache_free(vrna_loop_cache_t *cache);
+
+
+/**
+ *  @brief  Get the free energy of the current structure of a loop decomposition cache
+ *
+ *  @param cache  The loop decomposition cache
+ *  @return       The free energy of the current structure in 10cal/mol
+ */
+int
+vrna_loop_cache_energy(const vrna_loop_cache_t *cache);
+
+
+/**
+ *  @brief  Get the pair table of the current structure of a loop decomposition cache
+ *
+ *  @param cache  The loop decomposition cache
+ *  @return       The pair table of the current structure
+ */
+const short *
+vrna_loop_cache_ptable(const vrna_loop_cache_t *cache);
+
+
+/**
+ *  @brief  Calculate the energy of a move using a loop decomposition cache
+ *
+ *  Same as vrna_eval_move_pt() for the structure stored in @p cache, but the
+ *  energies of the loops that remain unchanged by the move are taken from
+ *  the cache rather than being re-evaluated. In addition to insertions and
+ *  deletions, this function also evaluates shift moves, see vrna_eval_move_shift_pt().
+ *
+ *  @see  vrna_loop_cache_init(), vrna_loop_cache_apply(), vrna_eval_move_pt()
+ *
+ *  @param fc     A vrna_fold_compound_t containing the energy parameters and model details
+ *  @param cache  The loop decomposition cache
+ *  @param m1     first coordinate of base pair
+ *  @param m2     second coordinate of base pair
+ *  @returns      energy change of the move in 10cal/mol (#INF upon any error)
+ */
+int
+vrna_eval_move_cache(vrna_fold_compound_t *fc,
+                     vrna_loop_cache_t    *cache,
+                     int                  m1,
+                     int                  m2);
+
+
+/**
+ *  @brief  Apply a move to the structure of a loop decomposition cache
+ *
+ *  Only the loops affected by the move are re-evaluated.
+ *
+ *  @see  vrna_loop_cache_init(), vrna_eval_move_cache()
+ *
+ *  @param fc     A vrna_fold_compound_t containing the energy parameters and model details
+ *  @param cache  The loop decomposition cache
+ *  @param m1     first coordinate of base pair
+ *  @param m2     second coordinate of base pair
+ *  @returns      energy change of the move in 10cal/mol (#INF upon any error, in which case the cache remains unchanged)
+ */
+int
+vrna_loop_cache_apply(vrna_fold_compound_t  *fc,
+                      vrna_loop_cache_t     *cache,
+                      int                   m1,
+                      int                   m2);
+
+
 /**
  * @}
  */
@@ -89,9 +89,18 @@ vrna_eval_covar_structure(vrna_fold_compound_t  *fc,
     pt        = vrna_ptable(structure);
     md        = &(fc->params->model_details);
     gq        = md->gquad;
-    md->gquad = 0;
-    res       = covar_energy_of_struct_pt(fc, pt);
-    md->gquad = gq;
+
+    if (gq) {
+      /* energy parameters may be shared with other fold compounds */
+      fc->params  = vrna_params_unshare(fc->params);
+      md          = &(fc->params->model_details);
+      md->gquad   = 0;
+    }
+
+    res = covar_energy_of_struct_pt(fc, pt);
+
+    if (gq)
+      md->gquad = gq;
 
     if (gq) {
       loop_idx  = vrna_loopidx_from_ptable(pt);
@@ -23,6 +23,10 @@
 #include <string.h>
 #include <limits.h>
 
+#if VRNA_WITH_PTHREADS
+# include <pthread.h>
+#endif
+
 #include "ViennaRNA/utils/basic.h"
 #include "ViennaRNA/utils/structures.h"
 #include "ViennaRNA/utils/strings.h"
@@ -39,6 +43,8 @@
 #include "ViennaRNA/cofold.h"
 #include "ViennaRNA/mm.h"
 #include "ViennaRNA/alphabet.h"
+#include "ViennaRNA/grammar.h"
+#include "ViennaRNA/unstructured_domains.h"
 #include "ViennaRNA/fold_compound.h"
 
 /*
@@ -61,6 +67,15 @@
  # PRIVATE VARIABLES             #
  #################################
  */
+struct vrna_fc_pool_s {
+  vrna_fold_compound_t  **fcs;
+  unsigned int          num;
+  unsigned int          size;
+  unsigned int          max_length;
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_t       mtx;
+#endif
+};
 
 /*
  #################################
@@ -82,6 +97,12 @@ sanitize_bp_span(vrna_fold_compound_t *fc,
                  unsigned int         options);
 
 
+PRIVATE void
+sanitize_md_bp_span(vrna_md_t     *md,
+                    unsigned int  length,
+                    unsigned int  options);
+
+
 PRIVATE void
 add_params(vrna_fold_compound_t *fc,
            vrna_md_t            *md_p,
@@ -116,8 +137,8 @@ vrna_fold_compound_free(vrna_fold_compound_t *fc)
     vrna_mx_pf_free(fc);
     free(fc->iindx);
     free(fc->jindx);
-    free(fc->params);
-    free(fc->exp_params);
+    vrna_params_free(fc->params);
+    vrna_exp_params_free(fc->exp_params);
 
     vrna_hc_free(fc->hc);
     vrna_ud_remove(fc);
@@ -229,6 +250,8 @@ vrna_fold_compound(const char       *sequence,
     vrna_md_set_default(&md);
 
   /* now for the energy parameters */
+  sanitize_md_bp_span(&md, length, options);
+
   add_params(fc, &md, options);
 
   sanitize_bp_span(fc, options);
@@ -334,6 +357,8 @@ vrna_fold_compound_comparative2(const char                **sequences,
       vrna_md_set_default(&md);
 
     /* now for the energy parameters */
+    sanitize_md_bp_span(&md, length, options);
+
     add_params(fc, &md, options);
 
     sanitize_bp_span(fc, options);
@@ -482,6 +507,240 @@ vrna_fold_compound_TwoD(const char    *sequence,
 }
 
 
+PUBLIC int
+vrna_fold_compound_retarget(vrna_fold_compound_t  *fc,
+                            const char            *sequence,
+                            const vrna_md_t       *md_p,
+                            unsigned int          options)
+{
+  unsigned int  length, aux_options;
+  vrna_md_t     md;
+
+  if ((!fc) || (!sequence))
+    return 0;
+
+  /* only global single sequence predictions can be re-targeted */
+  if ((fc->type != VRNA_FC_TYPE_SINGLE) ||
+      (options & VRNA_OPTION_WINDOW) ||
+      (fc->ptype_local) ||
+      (fc->reference_pt1) ||
+      ((fc->hc) && (fc->hc->type != VRNA_HC_DEFAULT)) ||
+      ((fc->matrices) && (fc->matrices->type != VRNA_MX_DEFAULT)) ||
+      ((fc->exp_matrices) && (fc->exp_matrices->type != VRNA_MX_DEFAULT)))
+    return 0;
+
+  /* sanity check */
+  length = strlen(sequence);
+  if (length == 0) {
+    vrna_message_warning("vrna_fold_compound_retarget: "
+                         "sequence length must be greater 0");
+    return 0;
+  }
+
+  if (length > vrna_sequence_length_max(options)) {
+    vrna_message_warning("vrna_fold_compound_retarget: "
+                         "sequence length of %d exceeds addressable range",
+                         length);
+    return 0;
+  }
+
+  if (md_p) {
+    md = *md_p;
+  } else {
+    md = fc->params->model_details;
+    /* base pair span was limited by the previous sequence length only */
+    if (md.max_bp_span >= md.window_size)
+      md.max_bp_span = -1;
+  }
+
+  /* same as sanitize_bp_span() for the new sequence */
+  md.window_size = (int)length;
+  if ((md.max_bp_span <= 0) || (md.max_bp_span > md.window_size))
+    md.max_bp_span = md.window_size;
+
+  /*
+   *  window size and base pair span do not enter the energy parameters,
+   *  so the parameter cache provides them without re-computation. The
+   *  Boltzmann factors are dropped to enforce re-computation of the
+   *  scaling factor for the new sequence
+   */
+  vrna_exp_params_free(fc->exp_params);
+  fc->exp_params = NULL;
+
+  add_params(fc, &md, options);
+
+  /* remove everything that depends on the previous sequence */
+  vrna_sc_remove(fc);
+  vrna_ud_remove(fc);
+  vrna_gr_reset(fc);
+
+  if (fc->free_auxdata)
+    fc->free_auxdata(fc->auxdata);
+
+  fc->auxdata       = NULL;
+  fc->free_auxdata  = NULL;
+
+  vrna_sequence_remove_all(fc);
+
+  free(fc->sequence);
+  free(fc->ptype);
+  free(fc->ptype_pf_compat);
+  free(fc->iindx);
+  free(fc->jindx);
+
+  fc->ptype           = NULL;
+  fc->ptype_pf_compat = NULL;
+  fc->iindx           = NULL;
+  fc->jindx           = NULL;
+  fc->cutpoint        = -1;
+  fc->length          = length;
+  fc->sequence        = strdup(sequence);
+
+  aux_options = WITH_PTYPE;
+
+  if (options & VRNA_OPTION_PF)
+    aux_options |= WITH_PTYPE_COMPAT;
+
+  set_fold_compound(fc, options, aux_options);
+
+  if (!(options & VRNA_OPTION_EVAL_ONLY)) {
+    /* reset hard constraints, this re-uses the previous memory */
+    vrna_hc_init(fc);
+
+    /* DP matrices are re-used as long as they are large enough */
+    if (fc->matrices) {
+      if ((fc->matrices->length < length) ||
+          (fc->matrices->strands != fc->strands)) {
+        vrna_mx_mfe_free(fc);
+      } else if (fc->params->model_details.gquad) {
+        free(fc->matrices->ggg);
+        fc->matrices->ggg = get_gquad_matrix(fc->sequence_encoding2, fc->params);
+      }
+    }
+
+    if ((fc->exp_matrices) &&
+        (fc->exp_matrices->length < length))
+      vrna_mx_pf_free(fc);
+
+    vrna_mx_prepare(fc, options);
+  } else {
+    vrna_hc_free(fc->hc);
+    fc->hc = NULL;
+  }
+
+  return 1;
+}
+
+
+PUBLIC vrna_fold_compound_pool_t
+vrna_fold_compound_pool_init(unsigned int max_length)
+{
+  struct vrna_fc_pool_s *pool;
+
+  pool = (struct vrna_fc_pool_s *)vrna_alloc(sizeof(struct vrna_fc_pool_s));
+
+  pool->size        = 8;
+  pool->num         = 0;
+  pool->max_length  = max_length;
+  pool->fcs         = (vrna_fold_compound_t **)vrna_alloc(sizeof(vrna_fold_compound_t *) *
+                                                          pool->size);
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_init(&(pool->mtx), NULL);
+#endif
+
+  return pool;
+}
+
+
+PUBLIC vrna_fold_compound_t *
+vrna_fold_compound_pool_acquire(vrna_fold_compound_pool_t pool,
+                                const char                *sequence,
+                                const vrna_md_t           *md_p,
+                                unsigned int              options)
+{
+  vrna_fold_compound_t *fc = NULL;
+
+  if (sequence == NULL)
+    return NULL;
+
+  if (pool) {
+#if VRNA_WITH_PTHREADS
+    pthread_mutex_lock(&(pool->mtx));
+#endif
+
+    if (pool->num > 0)
+      fc = pool->fcs[--pool->num];
+
+#if VRNA_WITH_PTHREADS
+    pthread_mutex_unlock(&(pool->mtx));
+#endif
+
+    if (fc) {
+      if (vrna_fold_compound_retarget(fc, sequence, md_p, options))
+        return fc;
+
+      vrna_fold_compound_free(fc);
+    }
+  }
+
+  return vrna_fold_compound(sequence, md_p, options);
+}
+
+
+PUBLIC void
+vrna_fold_compound_pool_release(vrna_fold_compound_pool_t pool,
+                                vrna_fold_compound_t      *fc)
+{
+  if (!fc)
+    return;
+
+  if ((!pool) ||
+      (fc->type != VRNA_FC_TYPE_SINGLE) ||
+      ((pool->max_length > 0) && (fc->length > pool->max_length))) {
+    vrna_fold_compound_free(fc);
+    return;
+  }
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_lock(&(pool->mtx));
+#endif
+
+  if (pool->num == pool->size) {
+    pool->size  *= 2;
+    pool->fcs   = (vrna_fold_compound_t **)vrna_realloc(pool->fcs,
+                                                        sizeof(vrna_fold_compound_t *) *
+                                                        pool->size);
+  }
+
+  pool->fcs[pool->num++] = fc;
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_unlock(&(pool->mtx));
+#endif
+}
+
+
+PUBLIC void
+vrna_fold_compound_pool_free(vrna_fold_compound_pool_t pool)
+{
+  unsigned int i;
+
+  if (pool) {
+    for (i = 0; i < pool->num; i++)
+      vrna_fold_compound_free(pool->fcs[i]);
+
+    free(pool->fcs);
+
+#if VRNA_WITH_PTHREADS
+    pthread_mutex_destroy(&(pool->mtx));
+#endif
+
+    free(pool);
+  }
+}
+
+
 PUBLIC void
 vrna_fold_compound_add_auxdata(vrna_fold_compound_t       *fc,
                                void                       *data,
@@ -534,8 +793,11 @@ vrna_fold_compound_prepare(vrna_fold_compound_t *fc,
 
     switch (fc->type) {
       case VRNA_FC_TYPE_SINGLE:     /* get pre-computed Boltzmann factors if not present*/
-        if (fc->domains_up)         /* turn on unique ML decomposition with qm1 array */
+        if ((fc->domains_up) &&     /* turn on unique ML decomposition with qm1 array */
+            (!fc->exp_params->model_details.uniq_ML)) {
+          fc->exp_params                        = vrna_exp_params_unshare(fc->exp_params);
           fc->exp_params->model_details.uniq_ML = 1;
+        }
 
         break;
 
@@ -567,21 +829,39 @@ PRIVATE void
 sanitize_bp_span(vrna_fold_compound_t *fc,
                  unsigned int         options)
 {
-  vrna_md_t *md;
+  vrna_md_t md;
+
+  md = fc->params->model_details;
 
-  md = &(fc->params->model_details);
+  sanitize_md_bp_span(&md, fc->length, options);
+
+  /* energy parameters may be shared, so only modify them if necessary */
+  if ((md.window_size != fc->params->model_details.window_size) ||
+      (md.max_bp_span != fc->params->model_details.max_bp_span)) {
+    fc->params                            = vrna_params_unshare(fc->params);
+    fc->params->model_details.window_size = md.window_size;
+    fc->params->model_details.max_bp_span = md.max_bp_span;
+  }
+
+  if (options & VRNA_OPTION_WINDOW)
+    fc->window_size = md.window_size;
+}
 
+
+PRIVATE void
+sanitize_md_bp_span(vrna_md_t     *md,
+                    unsigned int  length,
+                    unsigned int  options)
+{
   /* make sure that min_loop_size, max_bp_span, and window_size are sane */
   if (options & VRNA_OPTION_WINDOW) {
     if (md->window_size <= 0)
-      md->window_size = (int)fc->length;
-    else if (md->window_size > (int)fc->length)
-      md->window_size = (int)fc->length;
-
-    fc->window_size = md->window_size;
+      md->window_size = (int)length;
+    else if (md->window_size > (int)length)
+      md->window_size = (int)length;
   } else {
     /* non-local fold mode */
-    md->window_size = (int)fc->length;
+    md->window_size = (int)length;
   }
 
   if ((md->max_bp_span <= 0) || (md->max_bp_span > md->window_size))
@@ -600,13 +880,13 @@ add_params(vrna_fold_compound_t *fc,
    */
   if (fc->params) {
     if (memcmp(md_p, &(fc->params->model_details), sizeof(vrna_md_t)) != 0) {
-      free(fc->params);
+      vrna_params_free(fc->params);
       fc->params = NULL;
     }
   }
 
   if (!fc->params)
-    fc->params = vrna_params(md_p);
+    fc->params = vrna_params_shared(md_p);
 
   vrna_params_prepare(fc, options);
 }
@@ -660,10 +940,9 @@ set_fold_compound(vrna_fold_compound_t  *fc,
       if (!(options & VRNA_OPTION_EVAL_ONLY)) {
         /* temporary hack for multi-strand case */
         if (fc->strands > 1) {
-          int min_loop_size = md_p->min_loop_size;
-          md_p->min_loop_size = 0;
-          fc->ptype = (aux & WITH_PTYPE) ? vrna_ptypes(fc->sequence_encoding2, md_p) : NULL;
-          md_p->min_loop_size = min_loop_size;
+          vrna_md_t md = *md_p;
+          md.min_loop_size  = 0;
+          fc->ptype         = (aux & WITH_PTYPE) ? vrna_ptypes(fc->sequence_encoding2, &md) : NULL;
         } else {
           fc->ptype = (aux & WITH_PTYPE) ? vrna_ptypes(fc->sequence_encoding2, md_p) : NULL;
         }
@@ -761,6 +1040,15 @@ make_pscores(vrna_fold_compound_t *fc)
       dm = get_ribosum((const char **)AS, n_seq, n);
 
     if (dm) {
+      /* the distance matrix is specific for this alignment */
+      if (fc->params) {
+        fc->params  = vrna_params_unshare(fc->params);
+        md          = &(fc->params->model_details);
+      } else {
+        fc->exp_params  = vrna_exp_params_unshare(fc->exp_params);
+        md              = &(fc->exp_params->model_details);
+      }
+
       for (i = 0; i < 7; i++) {
         for (j = 0; j < 7; j++)
           md->pair_dist[i][j] = dm[i][j];
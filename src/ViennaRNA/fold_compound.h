@@ -109,6 +109,10 @@ DEPRECATED(typedef void (vrna_callback_recursion_status)(unsigned char status,
 /**
  *  @brief  Status message indicating that Partition function computations are about to begin
  *
+ *  This message is sent exactly once per call to vrna_pf(), and always followed by
+ *  #VRNA_STATUS_PF_POST. If the scaling factor is adjusted during the computations,
+ *  the Boltzmann factors in #vrna_fold_compound_t.exp_params change in between.
+ *
  *  @see  #vrna_fold_compound_t.stat_cb, vrna_recursion_status_f(), vrna_pf()
  */
 #define VRNA_STATUS_PF_PRE      (unsigned char)3
@@ -549,6 +553,112 @@ void
 vrna_fold_compound_free(vrna_fold_compound_t *fc);
 
 
+/**
+ *  @brief  Re-target a #vrna_fold_compound_t to a new sequence
+ *
+ *  This function replaces the sequence of a single sequence #vrna_fold_compound_t as
+ *  obtained from vrna_fold_compound() while keeping as much of its memory as possible.
+ *  In particular, the energy parameters and Boltzmann factors, the hard constraints
+ *  data structure, and the DP matrices are re-used if the new sequence is not longer
+ *  than the largest sequence the compound has been used for before. The result of any
+ *  subsequent computation is the same as for a newly created #vrna_fold_compound_t.
+ *
+ *  Hard constraints are reset to their default state, while soft constraints, unstructured
+ *  domains, grammar extensions, and auxiliary data are removed from the compound.
+ *
+ *  The optional parameter @p md_p can be used to specify new model details. If they differ
+ *  from the current model in more than the window size and the maximum base pair span, the
+ *  energy parameters are re-computed. Passing NULL keeps the current model.
+ *
+ *  @note Fold compounds for comparative structure prediction, sliding-window mode, and
+ *        distance class partitioning can not be re-targeted.
+ *
+ *  @see  vrna_fold_compound(), vrna_fold_compound_pool_acquire()
+ *
+ *  @param  fc        The fold compound to re-target
+ *  @param  sequence  A single sequence, or concatenated sequences seperated by an '&' character
+ *  @param  md_p      An optional set of model details
+ *  @param  options   The options for DP matrices memory allocation
+ *  @return           1 on success, 0 if the fold compound could not be re-targeted
+ */
+int
+vrna_fold_compound_retarget(vrna_fold_compound_t  *fc,
+                            const char            *sequence,
+                            const vrna_md_t       *md_p,
+                            unsigned int          options);
+
+
+/**
+ *  @brief  A pool of re-usable fold compounds
+ *
+ *  Batch processing of many (short) sequences spends a considerable amount of
+ *  time in creating and destroying #vrna_fold_compound_t objects. A pool keeps
+ *  released fold compounds around and hands them out again after re-targeting
+ *  them to a new sequence, such that each thread that processes records
+ *  effectively works on its own, re-used fold compound.
+ *
+ *  All pool functions are thread-safe.
+ *
+ *  @see  vrna_fold_compound_pool_init(), vrna_fold_compound_pool_acquire(),
+ *        vrna_fold_compound_pool_release(), vrna_fold_compound_pool_free()
+ */
+typedef struct vrna_fc_pool_s *vrna_fold_compound_pool_t;
+
+
+/**
+ *  @brief  Create a pool of re-usable fold compounds
+ *
+ *  @param  max_length  Fold compounds for sequences longer than this are not kept in the pool (0 = no limit)
+ *  @return             An empty pool
+ */
+vrna_fold_compound_pool_t
+vrna_fold_compound_pool_init(unsigned int max_length);
+
+
+/**
+ *  @brief  Obtain a #vrna_fold_compound_t for a sequence from a pool
+ *
+ *  Takes a fold compound from the pool and re-targets it to @p sequence using
+ *  vrna_fold_compound_retarget(). If the pool is empty, or re-targeting is not
+ *  possible, a new fold compound is created with vrna_fold_compound() instead.
+ *  The returned fold compound belongs to the calling thread until it is handed
+ *  back with vrna_fold_compound_pool_release().
+ *
+ *  @param  pool      The pool (may be NULL)
+ *  @param  sequence  A single sequence, or concatenated sequences seperated by an '&' character
+ *  @param  md_p      An optional set of model details
+ *  @param  options   The options for DP matrices memory allocation
+ *  @return           A prefilled #vrna_fold_compound_t (may be @p NULL on error)
+ */
+vrna_fold_compound_t *
+vrna_fold_compound_pool_acquire(vrna_fold_compound_pool_t pool,
+                                const char                *sequence,
+                                const vrna_md_t           *md_p,
+                                unsigned int              options);
+
+
+/**
+ *  @brief  Hand a #vrna_fold_compound_t back to a pool
+ *
+ *  If @p pool is NULL, or the fold compound can not be re-used, it is simply free'd.
+ *
+ *  @param  pool  The pool (may be NULL)
+ *  @param  fc    The fold compound obtained from vrna_fold_compound_pool_acquire()
+ */
+void
+vrna_fold_compound_pool_release(vrna_fold_compound_pool_t pool,
+                                vrna_fold_compound_t      *fc);
+
+
+/**
+ *  @brief  Free a pool of fold compounds including all fold compounds it holds
+ *
+ *  @param  pool  The pool
+ */
+void
+vrna_fold_compound_pool_free(vrna_fold_compound_pool_t pool);
+
+
 /**
  *  @brief  Add auxiliary data to the #vrna_fold_compound_t
  *
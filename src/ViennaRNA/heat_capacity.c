@@ -1,15 +1,24 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include  <stdio.h>
 #include  <stdlib.h>
 #include  <math.h>
 
+#ifdef _OPENMP
+#include  <omp.h>
+#endif
+
 #include  "ViennaRNA/utils/basic.h"
+#include  "ViennaRNA/utils/cpu.h"
 #include  "ViennaRNA/params/constants.h"
+#include  "ViennaRNA/params/basic.h"
+#include  "ViennaRNA/fold_compound.h"
 #include  "ViennaRNA/mfe.h"
 #include  "ViennaRNA/part_func.h"
 #include  "ViennaRNA/heat_capacity.h"
 
-#define MAXWIDTH  201
-
 struct data_collector {
   struct vrna_heat_capacity_s *data;
   size_t                      num_entries;
@@ -29,6 +38,30 @@ store_results_cb(float  t,
                  void   *data);
 
 
+PRIVATE void
+sweep_temperatures(vrna_fold_compound_t *fc,
+                   vrna_md_t            *md,
+                   const double         *temperatures,
+                   unsigned int         num,
+                   float                h,
+                   float                *F);
+
+
+#ifdef _OPENMP
+
+PRIVATE int
+sweep_temperatures_parallel(vrna_fold_compound_t  *fc,
+                            vrna_md_t             *md,
+                            const double          *temperatures,
+                            unsigned int          num,
+                            float                 h,
+                            float                 *F,
+                            int                   num_threads);
+
+
+#endif
+
+
 PUBLIC struct vrna_heat_capacity_s *
 vrna_heat_capacity_simple(const char    *sequence,
                           float         T_min,
@@ -101,10 +134,10 @@ vrna_heat_capacity_cb(vrna_fold_compound_t        *fc,
                       vrna_heat_capacity_f cb,
                       void                        *data)
 {
-  unsigned int  i, n;
-  int           ret;
-  float         hc, F[MAXWIDTH];
-  double        min_en;
+  unsigned int  i, num, size;
+  int           ret, done;
+  float         hc, *F;
+  double        *temperatures, T;
   vrna_md_t     md, md_init;
 
   ret = 0;
@@ -128,8 +161,30 @@ vrna_heat_capacity_cb(vrna_fold_compound_t        *fc,
     if (h > (T_max - T_min))
       h = T_max - T_min;
 
+    /*
+     *  collect all temperatures we require the ensemble free energy for,
+     *  i.e. 2 * m + 1 points for the first result and one additional point
+     *  for each subsequent result
+     */
+    num           = 0;
+    size          = 2 * m + 2;
+    temperatures  = (double *)vrna_alloc(sizeof(double) * size);
+
+    for (T = T_min - m * h; (num < 2 * m + 1) || (T <= (T_max + m * h + h)); T += h) {
+      if (num == size) {
+        size          *= 2;
+        temperatures  = (double *)vrna_realloc(temperatures, sizeof(double) * size);
+      }
+
+      temperatures[num++] = T;
+    }
+
+    /* the last temperature only terminates the sweep */
+    num--;
+
+    F = (float *)vrna_alloc(sizeof(float) * num);
+
     /* now for the actual algorithm */
-    n       = fc->length;
     md_init = md = fc->params->model_details;
 
     /* required for vrna_exp_param_rescale() in subsequent calls */
@@ -137,49 +192,48 @@ vrna_heat_capacity_cb(vrna_fold_compound_t        *fc,
     md.backtrack    = 0;
     md.compute_bpp  = 0;
 
-    md.temperature = T_min - m * h;
-    vrna_params_reset(fc, &md);
-
-    min_en = (double)vrna_mfe(fc, NULL);
-
-    vrna_exp_params_rescale(fc, &min_en);
-
-    for (i = 0; i < 2 * m + 1; i++) {
-      F[i] = vrna_pf(fc, NULL);
-      /* increase temperature */
-      md.temperature += h;
-      /* reset all energy parameters according to temperature changes */
-      vrna_params_reset(fc, &md);
-
-      min_en = F[i] + h * 0.00727 * n;
-
-      vrna_exp_params_rescale(fc, &min_en);
-    }
-
-    while (md.temperature <= (T_max + m * h + h)) {
-      hc = -ddiff(F, h, m) * (md.temperature + K0 - m * h - h);
+    done = 0;
+
+#ifdef _OPENMP
+    int num_threads = vrna_cpu_threads(md.threads);
+
+    /*
+     *  distribute the temperatures among several threads, each with its
+     *  own fold compound. Constraints and other extensions attached to
+     *  the fold compound can't be transferred, so they require the serial
+     *  sweep below
+     */
+    if ((md.threads != 1) &&
+        (num_threads > 1) &&
+        (fc->type == VRNA_FC_TYPE_SINGLE) &&
+        (fc->strands == 1) &&
+        (!fc->sc) &&
+        (!fc->domains_up) &&
+        (!fc->aux_grammar) &&
+        (!fc->hc->depot) &&
+        (!fc->hc->f))
+      done = sweep_temperatures_parallel(fc, &md, temperatures, num, h, F, num_threads);
+
+#endif
+
+    if (!done)
+      sweep_temperatures(fc, &md, temperatures, num, h, F);
+
+    /* numerical differentiation over 2 * m + 1 consecutive points each */
+    for (i = 0; i + 2 * m < num; i++) {
+      T   = temperatures[i + 2 * m + 1];
+      hc  = -ddiff(F + i, h, m) * (T + K0 - m * h - h);
 
       /* return results */
-      cb((md.temperature - (float)m * h - h), hc, data);
-
-      for (i = 0; i < 2 * m; i++)
-        F[i] = F[i + 1];
-
-      F[2 * m] = vrna_pf(fc, NULL);
-
-      /*       printf("%g\n", F[2*m]);*/
-      md.temperature += h;
-
-      vrna_params_reset(fc, &md);
-
-      min_en = F[i] + h * 0.00727 * n;
-
-      vrna_exp_params_rescale(fc, &min_en);
+      cb((T - (float)m * h - h), hc, data);
     }
 
     /* restore original state of (the model of) the fold_compound */
     vrna_params_reset(fc, &md_init);
 
+    free(F);
+    free(temperatures);
+
     ret = 1;
   }
 
@@ -207,6 +261,102 @@ ddiff(float f[],
 }
 
 
+/*
+ *  Compute the ensemble free energies for a list of increasing
+ *  temperatures. The scaling factor of each partition function is
+ *  estimated from the ensemble free energy at the previous temperature
+ */
+PRIVATE void
+sweep_temperatures(vrna_fold_compound_t *fc,
+                   vrna_md_t            *md,
+                   const double         *temperatures,
+                   unsigned int         num,
+                   float                h,
+                   float                *F)
+{
+  unsigned int  i, n;
+  double        min_en;
+
+  n = fc->length;
+
+  md->temperature = temperatures[0];
+  vrna_params_reset(fc, md);
+
+  min_en = (double)vrna_mfe(fc, NULL);
+
+  vrna_exp_params_rescale(fc, &min_en);
+
+  for (i = 0; i < num; i++) {
+    if (i > 0) {
+      md->temperature = temperatures[i];
+      /* reset all energy parameters according to temperature changes */
+      vrna_params_reset(fc, md);
+
+      min_en = F[i - 1] + h * 0.00727 * n;
+
+      vrna_exp_params_rescale(fc, &min_en);
+    }
+
+    F[i] = vrna_pf(fc, NULL);
+  }
+}
+
+
+#ifdef _OPENMP
+
+/*
+ *  Split the list of temperatures into consecutive blocks that are swept
+ *  concurrently on individual fold compounds. Each block starts with an
+ *  MFE prediction to obtain the scaling factor, just like the serial sweep
+ */
+PRIVATE int
+sweep_temperatures_parallel(vrna_fold_compound_t  *fc,
+                            vrna_md_t             *md,
+                            const double          *temperatures,
+                            unsigned int          num,
+                            float                 h,
+                            float                 *F,
+                            int                   num_threads)
+{
+  int b, num_blocks, failed;
+
+  num_blocks = MIN2(num_threads, (int)num);
+
+  if (num_blocks < 2)
+    return 0;
+
+  failed = 0;
+
+#pragma omp parallel for schedule(static, 1) num_threads(num_threads)
+  for (b = 0; b < num_blocks; b++) {
+    unsigned int          first, last;
+    vrna_md_t             md_block;
+    vrna_fold_compound_t  *fc_block;
+
+    first = (unsigned int)((size_t)num * b / num_blocks);
+    last  = (unsigned int)((size_t)num * (b + 1) / num_blocks);
+
+    md_block          = *md;
+    md_block.threads  = 1;
+
+    fc_block = vrna_fold_compound(fc->sequence, &md_block, VRNA_OPTION_DEFAULT);
+
+    if (fc_block) {
+      sweep_temperatures(fc_block, &md_block, temperatures + first, last - first, h, F + first);
+      vrna_fold_compound_free(fc_block);
+    } else {
+#pragma omp atomic write
+      failed = 1;
+    }
+  }
+
+  return (failed) ? 0 : 1;
+}
+
+
+#endif
+
+
 PRIVATE void
 store_results_cb(float  t,
                  float  hc,
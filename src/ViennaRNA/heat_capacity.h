@@ -135,6 +135,14 @@ vrna_heat_capacity(vrna_fold_compound_t *fc,
  *  to @f$ 2 \cdot mpoints + 1 @f$ data points to calculate 2nd derivatives. Increasing this
  *  parameter produces a smoother curve.
  *
+ *  If the model details of @p fc request more than one thread (see #vrna_md_t.threads),
+ *  the temperature range is split into consecutive blocks that are processed in parallel
+ *  on individual copies of the fold compound. The results agree with those of the
+ *  serial computation up to numerical precision and are passed to the callback in order
+ *  of increasing temperature. Fold compounds with soft constraints, user-defined hard
+ *  constraints, unstructured domains, or additional grammar rules are always processed
+ *  by a single thread.
+ *
  *  @see  vrna_heat_capacity(), vrna_heat_capacity_f
  *
  *  @param  fc            The #vrna_fold_compound_t with the RNA sequence to analyze
@@ -18,6 +18,13 @@
 #include <math.h>
 #include <ctype.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #include "json/json.h"
 
 #include "ViennaRNA/fold_vars.h"
@@ -52,6 +59,20 @@ typedef struct {
 } ct_data;
 
 
+struct vrna_fasta_reader_s {
+  const char    *data;        /* (memory mapped) file content */
+  size_t        size;         /* size of the file */
+  size_t        pos;          /* current read position */
+  size_t        end;          /* end of the part to read */
+  unsigned int  options;
+  unsigned int  done;
+  unsigned int  quit;         /* whether reading stopped at a quit line */
+  char          *buffer;      /* buffer for sequences spanning multiple lines */
+  size_t        buffer_size;
+  int           mapped;
+};
+
+
 PRIVATE char          *inbuf  = NULL;
 PRIVATE char          *inbuf2 = NULL;
 PRIVATE unsigned int  typebuf = 0;
@@ -98,6 +119,32 @@ process_ct_nt_line(ct_data       *data,
                    unsigned int  j,
                    unsigned int  actual_i);
 
+
+PRIVATE INLINE size_t
+next_line(const char  *data,
+          size_t      pos,
+          size_t      end,
+          size_t      *length);
+
+
+PRIVATE unsigned int
+classify_line(const char  *line,
+              size_t      length);
+
+
+PRIVATE size_t
+find_header(const char  *data,
+            size_t      size,
+            size_t      pos);
+
+
+PRIVATE void
+append_sequence(struct vrna_fasta_reader_s  *reader,
+                const char                  **sequence,
+                size_t                      *length,
+                const char                  *line,
+                size_t                      line_length);
+
 /*
  #################################
  # BEGIN OF FUNCTION DEFINITIONS #
@@ -566,6 +613,436 @@ vrna_file_fasta_read_record(char          **header,
 }
 
 
+PUBLIC struct vrna_fasta_reader_s *
+vrna_file_fasta_reader(const char   *filename,
+                       unsigned int shard,
+                       unsigned int num_shards,
+                       unsigned int options)
+{
+  char                        *data;
+  size_t                      size;
+  int                         mapped;
+  struct vrna_fasta_reader_s  *reader;
+
+  if (!filename)
+    return NULL;
+
+  data    = NULL;
+  size    = 0;
+  mapped  = 0;
+
+#ifndef _WIN32
+  int         fd;
+  struct stat st;
+
+  if ((fd = open(filename, O_RDONLY)) < 0)
+    return NULL;
+
+  if ((fstat(fd, &st) != 0) ||
+      (!S_ISREG(st.st_mode))) {
+    close(fd);
+    return NULL;
+  }
+
+  size = (size_t)st.st_size;
+
+  if (size > 0) {
+    data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      return NULL;
+    }
+
+#ifdef MADV_SEQUENTIAL
+    (void)madvise(data, size, MADV_SEQUENTIAL);
+#endif
+    mapped = 1;
+  }
+
+  close(fd);
+#else
+  FILE    *fp;
+  size_t  n;
+
+  if (!(fp = fopen(filename, "rb")))
+    return NULL;
+
+  /* no memory mapping available, so we read the file in large blocks */
+  for (;;) {
+    data  = (char *)vrna_realloc(data, sizeof(char) * (size + (1 << 24)));
+    n     = fread(data + size, sizeof(char), 1 << 24, fp);
+    size  += n;
+    if (n < (1 << 24))
+      break;
+  }
+
+  fclose(fp);
+#endif
+
+  reader = (struct vrna_fasta_reader_s *)vrna_alloc(sizeof(struct vrna_fasta_reader_s));
+
+  reader->data        = (const char *)data;
+  reader->size        = size;
+  reader->options     = options & ~VRNA_INPUT_FASTA_HEADER;
+  reader->done        = 0;
+  reader->quit        = 0;
+  reader->buffer      = NULL;
+  reader->buffer_size = 0;
+  reader->mapped      = mapped;
+
+  if ((num_shards < 2) ||
+      (shard >= num_shards)) {
+    reader->pos = 0;
+    reader->end = ((num_shards < 2) || (shard == 0)) ? size : 0;
+  } else {
+    reader->pos = find_header(reader->data,
+                              size,
+                              (size_t)((double)size * shard / num_shards));
+    reader->end = find_header(reader->data,
+                              size,
+                              (size_t)((double)size * (shard + 1) / num_shards));
+  }
+
+  return reader;
+}
+
+
+PUBLIC unsigned int
+vrna_file_fasta_reader_next(struct vrna_fasta_reader_s  *reader,
+                            vrna_fasta_record_t         *record)
+{
+  const char    *line;
+  size_t        pos, next, length;
+  unsigned int  type, options, stop;
+
+  if ((!reader) ||
+      (!record))
+    return VRNA_INPUT_ERROR;
+
+  if (reader->done)
+    return VRNA_INPUT_QUIT;
+
+  memset(record, 0, sizeof(vrna_fasta_record_t));
+
+  options = reader->options;
+  pos     = reader->pos;
+  type    = 0;
+
+  /* skip everything until we find either a fasta header or a sequence */
+  while (pos < reader->end) {
+    line  = reader->data + pos;
+    next  = next_line(reader->data, pos, reader->end, &length);
+    type  = classify_line(line, length);
+
+    if (type & (VRNA_INPUT_QUIT | VRNA_INPUT_FASTA_HEADER | VRNA_INPUT_SEQUENCE))
+      break;
+
+    pos = next;
+  }
+
+  if ((pos >= reader->end) ||
+      (type & VRNA_INPUT_QUIT)) {
+    reader->done  = 1;
+    reader->quit  = (pos < reader->end) ? 1 : 0;
+    reader->pos   = pos;
+    return VRNA_INPUT_QUIT;
+  }
+
+  record->offset = pos;
+
+  if (type & VRNA_INPUT_FASTA_HEADER) {
+    record->header        = line + 1;
+    record->header_length = length - 1;
+
+    /* the sequence must follow the header */
+    pos = next;
+    while (pos < reader->end) {
+      line  = reader->data + pos;
+      next  = next_line(reader->data, pos, reader->end, &length);
+      type  = classify_line(line, length);
+
+      if ((type & VRNA_INPUT_BLANK_LINE) &&
+          (!(options & VRNA_INPUT_NOSKIP_BLANK_LINES))) {
+        pos = next;
+        continue;
+      }
+
+      if ((type & VRNA_INPUT_COMMENT) &&
+          (!(options & VRNA_INPUT_NOSKIP_COMMENTS))) {
+        pos = next;
+        continue;
+      }
+
+      break;
+    }
+
+    if ((pos >= reader->end) ||
+        (!(type & VRNA_INPUT_SEQUENCE))) {
+      vrna_message_warning("vrna_file_fasta_reader_next: "
+                           "sequence input missing!");
+      reader->done  = 1;
+      reader->pos   = pos;
+      return VRNA_INPUT_ERROR;
+    }
+  }
+
+  append_sequence(reader, &(record->sequence), &(record->length), line, length);
+  pos = next;
+
+  /* sequences may only span multiple lines if preceded by a fasta header */
+  if ((record->header) &&
+      (!(options & VRNA_INPUT_NO_SPAN))) {
+    while (pos < reader->end) {
+      line  = reader->data + pos;
+      next  = next_line(reader->data, pos, reader->end, &length);
+      type  = classify_line(line, length);
+
+      if (type & VRNA_INPUT_SEQUENCE)
+        append_sequence(reader, &(record->sequence), &(record->length), line, length);
+      else if (!(((type & VRNA_INPUT_BLANK_LINE) && (!(options & VRNA_INPUT_NOSKIP_BLANK_LINES))) ||
+                 ((type & VRNA_INPUT_COMMENT) && (!(options & VRNA_INPUT_NOSKIP_COMMENTS)))))
+        break;
+
+      pos = next;
+    }
+  }
+
+  record->buffered = (record->sequence == reader->buffer) ? 1 : 0;
+
+  /* collect the rest until we find user abort, new sequence or new fasta header */
+  stop = VRNA_INPUT_QUIT | VRNA_INPUT_SEQUENCE | VRNA_INPUT_FASTA_HEADER;
+  if (options & VRNA_INPUT_NOSKIP_BLANK_LINES)
+    stop |= VRNA_INPUT_BLANK_LINE;
+
+  record->rest = reader->data + pos;
+
+  while (pos < reader->end) {
+    next = next_line(reader->data, pos, reader->end, &length);
+    if (classify_line(reader->data + pos, length) & stop)
+      break;
+
+    pos = next;
+  }
+
+  if (options & VRNA_INPUT_NO_REST) {
+    record->rest = NULL;
+  } else {
+    record->rest_length = (size_t)(reader->data + pos - record->rest);
+    if (record->rest_length == 0)
+      record->rest = NULL;
+  }
+
+  reader->pos = pos;
+
+  return (record->header) ?
+         VRNA_INPUT_FASTA_HEADER | VRNA_INPUT_SEQUENCE :
+         VRNA_INPUT_SEQUENCE;
+}
+
+
+PUBLIC int
+vrna_file_fasta_reader_quit(struct vrna_fasta_reader_s *reader)
+{
+  return ((reader) && (reader->quit)) ? 1 : 0;
+}
+
+
+PUBLIC void
+vrna_file_fasta_reader_free(struct vrna_fasta_reader_s *reader)
+{
+  if (reader) {
+#ifndef _WIN32
+    if (reader->mapped)
+      munmap((void *)reader->data, reader->size);
+
+#else
+    free((void *)reader->data);
+#endif
+    free(reader->buffer);
+    free(reader);
+  }
+}
+
+
+PUBLIC char **
+vrna_file_fasta_record_rest(const vrna_fasta_record_t *record)
+{
+  char    **lines;
+  size_t  pos, next, length, num;
+
+  num   = 0;
+  lines = (char **)vrna_alloc(sizeof(char *));
+
+  if ((record) &&
+      (record->rest)) {
+    for (pos = 0; pos < record->rest_length; pos = next) {
+      next = next_line(record->rest, pos, record->rest_length, &length);
+
+      if (length == 0)
+        continue;
+
+      lines         = (char **)vrna_realloc(lines, sizeof(char *) * (num + 2));
+      lines[num]    = (char *)vrna_alloc(sizeof(char) * (length + 1));
+      memcpy(lines[num], record->rest + pos, sizeof(char) * length);
+      lines[num][length] = '\0';
+      num++;
+    }
+  }
+
+  lines[num] = NULL;
+
+  return lines;
+}
+
+
+/*
+ *  Find the end of the line starting at 'pos' and return the start of
+ *  the next line. The line length without trailing whitespaces is
+ *  stored in 'length'
+ */
+PRIVATE INLINE size_t
+next_line(const char  *data,
+          size_t      pos,
+          size_t      end,
+          size_t      *length)
+{
+  const char  *nl;
+  size_t      next, l;
+
+  nl    = (const char *)memchr(data + pos, '\n', end - pos);
+  next  = (nl) ? (size_t)(nl - data) + 1 : end;
+  l     = ((nl) ? (size_t)(nl - data) : end) - pos;
+
+  while ((l > 0) &&
+         ((isspace(data[pos + l - 1])) || (!isprint(data[pos + l - 1]))))
+    l--;
+
+  *length = l;
+
+  return next;
+}
+
+
+/*
+ *  Determine the type of an input line in the same way
+ *  read_multiple_input_lines() does
+ */
+PRIVATE unsigned int
+classify_line(const char  *line,
+              size_t      length)
+{
+  size_t i;
+
+  if (length == 0)
+    return VRNA_INPUT_BLANK_LINE;
+
+  switch (*line) {
+    case '@':
+      return VRNA_INPUT_QUIT;
+
+    case '#': /* fall through */
+    case '%': /* fall through */
+    case ';': /* fall through */
+    case '/': /* fall through */
+    case '*': /* fall through */
+    case ' ':
+      return VRNA_INPUT_COMMENT;
+
+    case '>':
+      return VRNA_INPUT_FASTA_HEADER;
+
+    case 'x': /* fall through */
+    case 'e': /* fall through */
+    case 'l': /* fall through */
+    case '&':
+      for (i = 1; (i < length) && ((line[i] == 'x') || (line[i] == 'e') || (line[i] == 'l')); i++);
+
+      if ((i < length) &&
+          (((line[i] > 64) && (line[i] < 91)) ||
+           ((line[i] > 96) && (line[i] < 123))))
+        return VRNA_INPUT_SEQUENCE;
+
+      return VRNA_INPUT_CONSTRAINT;
+
+    case '<': /* fall through */
+    case '.': /* fall through */
+    case '|': /* fall through */
+    case '(': /* fall through */
+    case ')': /* fall through */
+    case '[': /* fall through */
+    case ']': /* fall through */
+    case '{': /* fall through */
+    case '}': /* fall through */
+    case ',': /* fall through */
+    case '+':
+      return VRNA_INPUT_CONSTRAINT;
+
+    default:
+      return VRNA_INPUT_SEQUENCE;
+  }
+}
+
+
+/* find the first fasta header that starts at position 'pos' or later */
+PRIVATE size_t
+find_header(const char  *data,
+            size_t      size,
+            size_t      pos)
+{
+  const char *nl;
+
+  if (pos == 0)
+    return 0;
+
+  for (pos--; pos < size; pos = (size_t)(nl - data)) {
+    if (!(nl = (const char *)memchr(data + pos, '\n', size - pos)))
+      break;
+
+    if ((++nl < data + size) &&
+        (*nl == '>'))
+      return (size_t)(nl - data);
+  }
+
+  return size;
+}
+
+
+/*
+ *  Append a sequence line to the current sequence. As long as the sequence
+ *  consists of a single line only, we simply point to the mapped input
+ */
+PRIVATE void
+append_sequence(struct vrna_fasta_reader_s  *reader,
+                const char                  **sequence,
+                size_t                      *length,
+                const char                  *line,
+                size_t                      line_length)
+{
+  int in_buffer;
+
+  if (*sequence == NULL) {
+    *sequence = line;
+    *length   = line_length;
+    return;
+  }
+
+  in_buffer = (*sequence == reader->buffer) ? 1 : 0;
+
+  if (reader->buffer_size < *length + line_length) {
+    reader->buffer_size = 2 * (*length + line_length);
+    reader->buffer      = (char *)vrna_realloc(reader->buffer, sizeof(char) * reader->buffer_size);
+  }
+
+  if (!in_buffer)
+    memcpy(reader->buffer, *sequence, sizeof(char) * (*length));
+
+  memcpy(reader->buffer + *length, line, sizeof(char) * line_length);
+
+  *sequence = reader->buffer;
+  *length   += line_length;
+}
+
+
 PUBLIC char *
 vrna_extract_record_rest_structure(const char   **lines,
                                    unsigned int length,
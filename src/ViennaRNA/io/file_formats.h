@@ -196,6 +196,136 @@ vrna_file_fasta_read_record(char          **header,
                             unsigned int  options);
 
 
+/**
+ *  @brief  A memory mapped (FASTA) data set reader
+ *
+ *  @see  vrna_file_fasta_reader(), vrna_file_fasta_reader_next(), vrna_file_fasta_reader_free()
+ */
+typedef struct vrna_fasta_reader_s *vrna_fasta_reader_t;
+
+
+/**
+ *  @brief  A view to a single (FASTA) data set as obtained from vrna_file_fasta_reader_next()
+ *
+ *  None of the character arrays is '\0'-terminated, always use the
+ *  corresponding length attributes!
+ */
+typedef struct {
+  const char  *header;        /**< @brief The header line without leading '>' (or NULL) */
+  size_t      header_length;  /**< @brief Length of the header */
+  const char  *sequence;      /**< @brief The sequence */
+  size_t      length;         /**< @brief Length of the sequence */
+  const char  *rest;          /**< @brief Raw input lines following the sequence (or NULL) */
+  size_t      rest_length;    /**< @brief Number of bytes in @p rest */
+  size_t      offset;         /**< @brief Byte offset of the data set within the input file */
+  int         buffered;       /**< @brief Whether @p sequence spans multiple lines and resides in the buffer of the reader */
+} vrna_fasta_record_t;
+
+
+/**
+ *  @brief  Open a file for reading (FASTA) data sets without copying
+ *
+ *  In contrast to vrna_file_fasta_read_record(), this reader maps the
+ *  entire input file into memory and locates the data sets within by
+ *  scanning for line breaks with memchr(). Data sets are then presented
+ *  as views (#vrna_fasta_record_t) to the mapped file, such that no
+ *  memory is allocated for each line read. Only sequences that span
+ *  over multiple lines are concatenated into a buffer that is re-used
+ *  for all data sets.
+ *
+ *  The input may be split into @p num_shards parts of roughly the same
+ *  size, where each data set is assigned to the part its FASTA header
+ *  starts in. Each part can then be read by an individual reader, e.g.
+ *  one for each thread, and the concatenation of data sets obtained
+ *  from shards @f$ 0, \ldots, num\_shards - 1 @f$ is identical to the
+ *  data sets obtained from a single reader for the entire file.
+ *  Note, that a new part may only start at a FASTA header.
+ *
+ *  @warning  A quit line ('@'), or a data set without sequence, only ends the
+ *            part it is located in, i.e. vrna_file_fasta_reader_next() returns
+ *            #VRNA_INPUT_QUIT, or #VRNA_INPUT_ERROR, for this part only. To obtain
+ *            the same data sets as with a single reader, the data sets of all
+ *            subsequent parts must be discarded in these cases. Use
+ *            vrna_file_fasta_reader_quit() to distinguish a quit line from the end
+ *            of a part.
+ *
+ *  The format of the input and the meaning of @p options is the same as
+ *  for vrna_file_fasta_read_record(). However, @p rest is only provided
+ *  as raw data, see vrna_file_fasta_record_rest() to obtain the
+ *  corresponding line array.
+ *
+ *  @see  vrna_file_fasta_reader_next(), vrna_file_fasta_reader_free(),
+ *        vrna_file_fasta_read_record(), vrna_file_fasta_record_rest()
+ *
+ *  @param  filename    The input file
+ *  @param  shard       The part of the input file to read (0-based)
+ *  @param  num_shards  The number of parts the file is split into (0 and 1 mean the entire file)
+ *  @param  options     Some options which may be passed to alter the behavior of the reader, use 0 for no options
+ *  @return             A reader for the requested part of the file, or NULL if the file is not a regular file or could not be read
+ */
+vrna_fasta_reader_t
+vrna_file_fasta_reader(const char   *filename,
+                       unsigned int shard,
+                       unsigned int num_shards,
+                       unsigned int options);
+
+
+/**
+ *  @brief  Get the next (FASTA) data set from a memory mapped reader
+ *
+ *  The views stored in @p record point into the input file and remain
+ *  valid until the reader is free'd. The only exception is a sequence
+ *  that spans multiple lines (#vrna_fasta_record_t.buffered), which is
+ *  only valid until the next call to this function.
+ *
+ *  @see  vrna_file_fasta_reader()
+ *
+ *  @param  reader  The reader
+ *  @param  record  A pointer to the data set view that is to be filled
+ *  @return         A flag with information about what the function actually did read, #VRNA_INPUT_QUIT at the end of the input (part)
+ */
+unsigned int
+vrna_file_fasta_reader_next(vrna_fasta_reader_t reader,
+                            vrna_fasta_record_t *record);
+
+
+/**
+ *  @brief  Check whether a memory mapped (FASTA) reader stopped at a quit line
+ *
+ *  @see  vrna_file_fasta_reader(), vrna_file_fasta_reader_next()
+ *
+ *  @param  reader  The reader
+ *  @return         Non-zero if vrna_file_fasta_reader_next() returned #VRNA_INPUT_QUIT due to a quit line ('@'), 0 otherwise
+ */
+int
+vrna_file_fasta_reader_quit(vrna_fasta_reader_t reader);
+
+
+/**
+ *  @brief  Release a memory mapped (FASTA) reader
+ *
+ *  @see  vrna_file_fasta_reader()
+ *
+ *  @param  reader  The reader to release
+ */
+void
+vrna_file_fasta_reader_free(vrna_fasta_reader_t reader);
+
+
+/**
+ *  @brief  Split the raw data following a sequence into an array of lines
+ *
+ *  The array is identical to the @p rest argument of vrna_file_fasta_read_record()
+ *
+ *  @see  vrna_file_fasta_reader_next(), vrna_file_fasta_read_record()
+ *
+ *  @param  record  The data set view
+ *  @return         A NULL-terminated array of lines
+ */
+char **
+vrna_file_fasta_record_rest(const vrna_fasta_record_t *record);
+
+
 /** @brief Extract a dot-bracket structure string from (multiline)character array
  *
  * This function extracts a dot-bracket structure string from the 'rest' array as
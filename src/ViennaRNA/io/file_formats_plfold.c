@@ -0,0 +1,523 @@
+/*
+ *  file_formats_plfold.c
+ *
+ *  Binary, memory-mappable storage of sliding window pair and
+ *  unpaired probabilities
+ *
+ *  ViennaRNA package
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define fseek_64(fp, pos, whence) _fseeki64((fp), (__int64)(pos), (whence))
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#define fseek_64(fp, pos, whence) fseeko((fp), (off_t)(pos), (whence))
+#endif
+
+#include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/part_func_window.h"
+#include "ViennaRNA/io/file_formats_plfold.h"
+
+#define PLFOLD_BIN_MAGIC        "VRNAPLF"
+#define PLFOLD_BIN_BOM          0x01020304U
+#define PLFOLD_BIN_BUFFER_SIZE  65536
+
+/*
+ #################################
+ # PRIVATE DATA STRUCTURES       #
+ #################################
+ */
+
+/* file header, all members are naturally aligned */
+typedef struct {
+  char      magic[8];
+  uint32_t  version;
+  uint32_t  byte_order;
+  uint32_t  length;
+  uint32_t  window_size;
+  uint32_t  max_bp_span;
+  uint32_t  ulength;
+  float     cutoff;
+  uint32_t  reserved;
+  uint64_t  num_pairs;
+  uint64_t  unpaired_offset;
+  uint64_t  index_offset;
+  uint64_t  pairs_offset;
+} plfold_bin_header;
+
+/* a buffered, sequentially written section of the file */
+typedef struct {
+  uint64_t  pos;
+  size_t    fill;
+  char      buf[PLFOLD_BIN_BUFFER_SIZE];
+} bin_section;
+
+struct vrna_plfold_bin_writer_s {
+  FILE              *fp;
+  int               failed;
+  plfold_bin_header header;
+
+  uint32_t          next_row;   /* next row of unpaired probabilities */
+  uint32_t          next_index; /* next position of the base pair index */
+
+  bin_section       unpaired;
+  bin_section       index;
+  bin_section       pairs;
+};
+
+/*
+ #################################
+ # PRIVATE FUNCTION DECLARATIONS #
+ #################################
+ */
+
+PRIVATE void
+section_write(vrna_plfold_bin_writer_t  *w,
+              bin_section               *s,
+              const void                *data,
+              size_t                    size);
+
+
+PRIVATE void
+section_flush(vrna_plfold_bin_writer_t  *w,
+              bin_section               *s);
+
+
+PRIVATE void
+write_unpaired(vrna_plfold_bin_writer_t *w,
+               unsigned int             i,
+               const FLT_OR_DBL         *pr,
+               int                      pr_size);
+
+
+PRIVATE void
+write_pairs(vrna_plfold_bin_writer_t  *w,
+            unsigned int              i,
+            const FLT_OR_DBL          *pr,
+            int                       pr_size);
+
+
+PRIVATE void
+write_index(vrna_plfold_bin_writer_t  *w,
+            unsigned int              i);
+
+
+PRIVATE int
+index_valid(const plfold_bin_header *header,
+            const void              *data);
+
+
+/*
+ #################################
+ # BEGIN OF FUNCTION DEFINITIONS #
+ #################################
+ */
+PUBLIC vrna_plfold_bin_t *
+vrna_file_plfold_bin_open(const char *filename)
+{
+  void              *data;
+  size_t            size;
+  plfold_bin_header header;
+  vrna_plfold_bin_t *bin;
+
+  if (!filename)
+    return NULL;
+
+#ifdef _WIN32
+  FILE    *fp;
+  __int64 fsize;
+
+  fp = fopen(filename, "rb");
+  if (!fp)
+    return NULL;
+
+  if ((fseek_64(fp, 0, SEEK_END) != 0) ||
+      ((fsize = _ftelli64(fp)) < (__int64)sizeof(plfold_bin_header))) {
+    fclose(fp);
+    return NULL;
+  }
+
+  size  = (size_t)fsize;
+  data  = vrna_alloc(size);
+
+  rewind(fp);
+  if (fread(data, 1, size, fp) != size) {
+    free(data);
+    fclose(fp);
+    return NULL;
+  }
+
+  fclose(fp);
+#else
+  int         fd;
+  struct stat st;
+
+  fd = open(filename, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+
+  if ((fstat(fd, &st) != 0) ||
+      (st.st_size < (off_t)sizeof(plfold_bin_header))) {
+    close(fd);
+    return NULL;
+  }
+
+  size  = (size_t)st.st_size;
+  data  = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if (data == MAP_FAILED)
+    return NULL;
+
+#endif
+
+  memcpy(&header, data, sizeof(plfold_bin_header));
+
+  /* sanity checks */
+  if ((memcmp(header.magic, PLFOLD_BIN_MAGIC, sizeof(PLFOLD_BIN_MAGIC)) != 0) ||
+      (header.version != VRNA_FILE_PLFOLD_BIN_VERSION) ||
+      (header.byte_order != PLFOLD_BIN_BOM) ||
+      (header.unpaired_offset + (uint64_t)header.length * header.ulength * sizeof(float) >
+       header.index_offset) ||
+      (header.index_offset + ((uint64_t)header.length + 2) * sizeof(uint64_t) >
+       header.pairs_offset) ||
+      (header.pairs_offset + header.num_pairs * sizeof(vrna_plfold_bin_pair_t) > size) ||
+      (header.index_offset % sizeof(uint64_t) != 0) ||
+      (!index_valid(&header, data))) {
+    vrna_message_warning("vrna_file_plfold_bin_open: "
+                         "%s is not a valid binary sliding window probability file",
+                         filename);
+#ifdef _WIN32
+    free(data);
+#else
+    munmap(data, size);
+#endif
+    return NULL;
+  }
+
+  bin               = (vrna_plfold_bin_t *)vrna_alloc(sizeof(vrna_plfold_bin_t));
+  bin->length       = header.length;
+  bin->window_size  = header.window_size;
+  bin->max_bp_span  = header.max_bp_span;
+  bin->ulength      = header.ulength;
+  bin->cutoff       = header.cutoff;
+  bin->num_pairs    = (size_t)header.num_pairs;
+  bin->unpaired     = (const float *)((char *)data + header.unpaired_offset);
+  bin->index        = (const uint64_t *)((char *)data + header.index_offset);
+  bin->pairs        = (const vrna_plfold_bin_pair_t *)((char *)data + header.pairs_offset);
+  bin->data         = data;
+  bin->size         = size;
+
+  return bin;
+}
+
+
+PUBLIC void
+vrna_file_plfold_bin_close(vrna_plfold_bin_t *bin)
+{
+  if (bin) {
+#ifdef _WIN32
+    free(bin->data);
+#else
+    munmap(bin->data, bin->size);
+#endif
+    free(bin);
+  }
+}
+
+
+PUBLIC float
+vrna_plfold_bin_unpaired(const vrna_plfold_bin_t  *bin,
+                         unsigned int             i,
+                         unsigned int             u)
+{
+  if ((bin) &&
+      (i >= 1) &&
+      (i <= bin->length) &&
+      (u >= 1) &&
+      (u <= bin->ulength))
+    return bin->unpaired[(size_t)(i - 1) * bin->ulength + u - 1];
+
+  return (float)NAN;
+}
+
+
+PUBLIC const vrna_plfold_bin_pair_t *
+vrna_plfold_bin_pairs(const vrna_plfold_bin_t *bin,
+                      unsigned int            i,
+                      unsigned int            j,
+                      size_t                  *num)
+{
+  if (num)
+    *num = 0;
+
+  if ((!bin) ||
+      (i > j) ||
+      (i > bin->length) ||
+      (j < 1))
+    return NULL;
+
+  if (i < 1)
+    i = 1;
+
+  if (j > bin->length)
+    j = bin->length;
+
+  if (num)
+    *num = (size_t)(bin->index[j + 1] - bin->index[i]);
+
+  return bin->pairs + bin->index[i];
+}
+
+
+PUBLIC vrna_plfold_bin_writer_t *
+vrna_file_plfold_bin_writer(const char    *filename,
+                            unsigned int  length,
+                            unsigned int  window_size,
+                            unsigned int  max_bp_span,
+                            unsigned int  ulength,
+                            double        cutoff)
+{
+  FILE                      *fp;
+  vrna_plfold_bin_writer_t  *w;
+
+  if ((!filename) || (length == 0))
+    return NULL;
+
+  fp = fopen(filename, "wb");
+  if (!fp)
+    return NULL;
+
+  w     = (vrna_plfold_bin_writer_t *)vrna_alloc(sizeof(vrna_plfold_bin_writer_t));
+  w->fp = fp;
+
+  memcpy(w->header.magic, PLFOLD_BIN_MAGIC, sizeof(PLFOLD_BIN_MAGIC));
+  w->header.version         = VRNA_FILE_PLFOLD_BIN_VERSION;
+  w->header.byte_order      = PLFOLD_BIN_BOM;
+  w->header.length          = length;
+  w->header.window_size     = window_size;
+  w->header.max_bp_span     = max_bp_span;
+  w->header.ulength         = ulength;
+  w->header.cutoff          = (float)cutoff;
+  w->header.unpaired_offset = sizeof(plfold_bin_header);
+  /* keep the index and base pair sections aligned to 8 bytes */
+  w->header.index_offset = (w->header.unpaired_offset +
+                            (uint64_t)length * ulength * sizeof(float) + 7) & ~(uint64_t)7;
+  w->header.pairs_offset = w->header.index_offset +
+                           ((uint64_t)length + 2) * sizeof(uint64_t);
+
+  w->unpaired.pos = w->header.unpaired_offset;
+  w->index.pos    = w->header.index_offset;
+  w->pairs.pos    = w->header.pairs_offset;
+  w->next_row     = 1;
+  w->next_index   = 0;
+
+  return w;
+}
+
+
+PUBLIC void
+vrna_file_plfold_bin_cb(FLT_OR_DBL    *pr,
+                        int           pr_size,
+                        int           i,
+                        int           max,
+                        unsigned int  type,
+                        void          *data)
+{
+  vrna_plfold_bin_writer_t *w = (vrna_plfold_bin_writer_t *)data;
+
+  if ((!w) ||
+      (i < 1) ||
+      ((unsigned int)i > w->header.length))
+    return;
+
+  if (type & VRNA_PROBS_WINDOW_BPP)
+    write_pairs(w, (unsigned int)i, pr, pr_size);
+  else if ((type & VRNA_PROBS_WINDOW_UP) &&
+           ((type & VRNA_ANY_LOOP) == VRNA_ANY_LOOP))
+    write_unpaired(w, (unsigned int)i, pr, pr_size);
+}
+
+
+PUBLIC int
+vrna_file_plfold_bin_writer_close(vrna_plfold_bin_writer_t *w)
+{
+  int ret;
+
+  if (!w)
+    return 0;
+
+  /* complete the unpaired probability matrix and the base pair index */
+  if (w->header.ulength > 0)
+    write_unpaired(w, w->header.length + 1, NULL, 0);
+
+  write_index(w, w->header.length + 2);
+
+  section_flush(w, &(w->unpaired));
+  section_flush(w, &(w->index));
+  section_flush(w, &(w->pairs));
+
+  if ((fseek_64(w->fp, 0, SEEK_SET) != 0) ||
+      (fwrite(&(w->header), sizeof(plfold_bin_header), 1, w->fp) != 1))
+    w->failed = 1;
+
+  if (fclose(w->fp) != 0)
+    w->failed = 1;
+
+  ret = (w->failed) ? 0 : 1;
+
+  free(w);
+
+  return ret;
+}
+
+
+/*
+ #####################################
+ # BEGIN OF STATIC HELPER FUNCTIONS  #
+ #####################################
+ */
+PRIVATE void
+section_flush(vrna_plfold_bin_writer_t  *w,
+              bin_section               *s)
+{
+  if (s->fill > 0) {
+    if ((fseek_64(w->fp, s->pos, SEEK_SET) != 0) ||
+        (fwrite(s->buf, 1, s->fill, w->fp) != s->fill))
+      w->failed = 1;
+
+    s->pos  += s->fill;
+    s->fill = 0;
+  }
+}
+
+
+PRIVATE void
+section_write(vrna_plfold_bin_writer_t  *w,
+              bin_section               *s,
+              const void                *data,
+              size_t                    size)
+{
+  if (s->fill + size > PLFOLD_BIN_BUFFER_SIZE)
+    section_flush(w, s);
+
+  memcpy(s->buf + s->fill, data, size);
+  s->fill += size;
+}
+
+
+/* add the unpaired probabilities of row i, missing rows are filled with NaN */
+PRIVATE void
+write_unpaired(vrna_plfold_bin_writer_t *w,
+               unsigned int             i,
+               const FLT_OR_DBL         *pr,
+               int                      pr_size)
+{
+  unsigned int  u, ulength;
+  float         v;
+
+  ulength = w->header.ulength;
+
+  if ((ulength == 0) ||
+      (i < w->next_row)) {
+    if (ulength > 0)
+      vrna_message_warning("vrna_file_plfold_bin_cb: "
+                           "unpaired probabilities for position %u not in order, ignoring",
+                           i);
+
+    return;
+  }
+
+  v = (float)NAN;
+
+  for (; w->next_row < i; w->next_row++)
+    for (u = 1; u <= ulength; u++)
+      section_write(w, &(w->unpaired), &v, sizeof(float));
+
+  if (i > w->header.length)
+    return;
+
+  for (u = 1; u <= ulength; u++) {
+    v = ((int)u <= pr_size) ? (float)pr[u] : (float)NAN;
+    section_write(w, &(w->unpaired), &v, sizeof(float));
+  }
+
+  w->next_row++;
+}
+
+
+/*
+ *  the base pair index must be non-decreasing and end at the total number of
+ *  base pairs, otherwise lookups may address memory beyond the pair section
+ */
+PRIVATE int
+index_valid(const plfold_bin_header *header,
+            const void              *data)
+{
+  const uint64_t  *index;
+  uint32_t        i;
+
+  index = (const uint64_t *)((const char *)data + header->index_offset);
+
+  for (i = 0; i <= header->length; i++)
+    if (index[i] > index[i + 1])
+      return 0;
+
+  return (index[header->length + 1] == header->num_pairs) ? 1 : 0;
+}
+
+
+/* extend the base pair index up to (but excluding) position i */
+PRIVATE void
+write_index(vrna_plfold_bin_writer_t  *w,
+            unsigned int              i)
+{
+  for (; w->next_index < i; w->next_index++)
+    section_write(w, &(w->index), &(w->header.num_pairs), sizeof(uint64_t));
+}
+
+
+PRIVATE void
+write_pairs(vrna_plfold_bin_writer_t  *w,
+            unsigned int              i,
+            const FLT_OR_DBL          *pr,
+            int                       pr_size)
+{
+  int                     j;
+  vrna_plfold_bin_pair_t  pair;
+
+  if (i < w->next_index) {
+    vrna_message_warning("vrna_file_plfold_bin_cb: "
+                         "base pairs for position %u not in order, ignoring",
+                         i);
+    return;
+  }
+
+  write_index(w, i + 1);
+
+  for (j = (int)i + 1; j <= MIN2(pr_size, (int)w->header.length); j++) {
+    if (pr[j] < w->header.cutoff)
+      continue;
+
+    pair.i  = i;
+    pair.j  = (uint32_t)j;
+    pair.p  = (float)pr[j];
+
+    section_write(w, &(w->pairs), &pair, sizeof(vrna_plfold_bin_pair_t));
+    w->header.num_pairs++;
+  }
+}
@@ -0,0 +1,201 @@
+#ifndef VIENNA_RNA_PACKAGE_FILE_FORMATS_PLFOLD_H
+#define VIENNA_RNA_PACKAGE_FILE_FORMATS_PLFOLD_H
+
+/**
+ *  @file     ViennaRNA/io/file_formats_plfold.h
+ *  @ingroup  file_utils, file_formats
+ *  @brief    Binary, memory-mappable storage of sliding window pair and unpaired probabilities
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <ViennaRNA/datastructures/basic.h>
+
+/**
+ *  @addtogroup  file_formats
+ *  @{
+ */
+
+/**
+ *  @brief  Version of the binary sliding window probability file format
+ */
+#define VRNA_FILE_PLFOLD_BIN_VERSION  1U
+
+/**
+ *  @brief  A base pair probability as stored in a binary sliding window probability file
+ */
+typedef struct {
+  uint32_t  i;  /**< @brief 5' position of the base pair */
+  uint32_t  j;  /**< @brief 3' position of the base pair */
+  float     p;  /**< @brief Probability of the base pair */
+} vrna_plfold_bin_pair_t;
+
+/**
+ *  @brief  A binary sliding window probability file opened for reading
+ *
+ *  The file consists of a fixed size header that stores the sequence length,
+ *  the window size, the maximum base pair span, the maximum length of unpaired
+ *  segments, and the probability cutoff for base pairs, followed by
+ *
+ *  - a dense matrix of unpaired probabilities (single precision, one row of
+ *    @p ulength values per sequence position),
+ *  - an index of the first base pair of each sequence position, and
+ *  - the list of base pairs with probability above the cutoff, sorted by
+ *    their 5' and 3' positions.
+ *
+ *  All data is stored in the native byte order and mapped into memory as is,
+ *  such that any interval of the sequence can be accessed in constant time
+ *  without parsing the file.
+ *
+ *  @see  vrna_file_plfold_bin_open(), vrna_plfold_bin_unpaired(), vrna_plfold_bin_pairs(),
+ *        vrna_file_plfold_bin_writer()
+ */
+typedef struct {
+  unsigned int                  length;       /**< @brief Length of the sequence */
+  unsigned int                  window_size;  /**< @brief Size of the sliding window */
+  unsigned int                  max_bp_span;  /**< @brief Maximum base pair span */
+  unsigned int                  ulength;      /**< @brief Maximum length of unpaired segments */
+  float                         cutoff;       /**< @brief Probability cutoff for the stored base pairs */
+  size_t                        num_pairs;    /**< @brief Number of stored base pairs */
+
+  const float                   *unpaired;    /**< @brief Unpaired probabilities, row-major, @p length rows of @p ulength values */
+  const uint64_t                *index;       /**< @brief The base pairs of position i are pairs[index[i]] to pairs[index[i + 1] - 1] */
+  const vrna_plfold_bin_pair_t  *pairs;       /**< @brief The base pair probabilities */
+
+  void                          *data;        /**< @brief The mapped file */
+  size_t                        size;         /**< @brief Size of the mapped file */
+} vrna_plfold_bin_t;
+
+/**
+ *  @brief  A binary sliding window probability file opened for writing
+ *
+ *  @see  vrna_file_plfold_bin_writer(), vrna_file_plfold_bin_cb(), vrna_file_plfold_bin_writer_close()
+ */
+typedef struct vrna_plfold_bin_writer_s vrna_plfold_bin_writer_t;
+
+
+/**
+ *  @brief  Open a binary sliding window probability file
+ *
+ *  The file is mapped into memory, or read entirely on systems without support
+ *  for memory-mapped files.
+ *
+ *  @see  vrna_file_plfold_bin_close(), vrna_plfold_bin_unpaired(), vrna_plfold_bin_pairs()
+ *
+ *  @param  filename  The name of the file
+ *  @return           The opened file, or NULL on any error
+ */
+vrna_plfold_bin_t *
+vrna_file_plfold_bin_open(const char *filename);
+
+
+/**
+ *  @brief  Close a binary sliding window probability file
+ *
+ *  @param  bin   The file as obtained from vrna_file_plfold_bin_open()
+ */
+void
+vrna_file_plfold_bin_close(vrna_plfold_bin_t *bin);
+
+
+/**
+ *  @brief  Get the probability that a segment is unpaired
+ *
+ *  @param  bin   The binary sliding window probability file
+ *  @param  i     The 3' end of the segment
+ *  @param  u     The length of the segment, i.e. the segment spans positions i - u + 1 to i
+ *  @return       The probability that the segment is unpaired, or NaN if not available
+ */
+float
+vrna_plfold_bin_unpaired(const vrna_plfold_bin_t  *bin,
+                         unsigned int             i,
+                         unsigned int             u);
+
+
+/**
+ *  @brief  Get the base pairs with a 5' position within an interval
+ *
+ *  The base pairs of the interval are stored consecutively, sorted by their 5'
+ *  and 3' positions. Note, that their 3' positions may lie outside the interval.
+ *
+ *  @param  bin   The binary sliding window probability file
+ *  @param  i     The first position of the interval
+ *  @param  j     The last position of the interval
+ *  @param  num   A pointer to store the number of base pairs to
+ *  @return       A pointer to the first base pair of the interval
+ */
+const vrna_plfold_bin_pair_t *
+vrna_plfold_bin_pairs(const vrna_plfold_bin_t *bin,
+                      unsigned int            i,
+                      unsigned int            j,
+                      size_t                  *num);
+
+
+/**
+ *  @brief  Create a binary sliding window probability file
+ *
+ *  The data is added to the file with the callback vrna_file_plfold_bin_cb() while
+ *  running vrna_probs_window(), and the file is completed by
+ *  vrna_file_plfold_bin_writer_close(). The data is written as it arrives, so the
+ *  memory requirements do not depend on the length of the sequence.
+ *
+ *  @see  vrna_file_plfold_bin_cb(), vrna_file_plfold_bin_writer_close(), vrna_probs_window()
+ *
+ *  @param  filename      The name of the file
+ *  @param  length        Length of the sequence
+ *  @param  window_size   Size of the sliding window
+ *  @param  max_bp_span   Maximum base pair span
+ *  @param  ulength       Maximum length of unpaired segments (may be 0)
+ *  @param  cutoff        Base pairs with lower probability are not stored
+ *  @return               The file opened for writing, or NULL on any error
+ */
+vrna_plfold_bin_writer_t *
+vrna_file_plfold_bin_writer(const char    *filename,
+                            unsigned int  length,
+                            unsigned int  window_size,
+                            unsigned int  max_bp_span,
+                            unsigned int  ulength,
+                            double        cutoff);
+
+
+/**
+ *  @brief  Sliding window probability callback that writes to a binary file
+ *
+ *  Stores base pair probabilities (#VRNA_PROBS_WINDOW_BPP) and unpaired
+ *  probabilities of any loop type (#VRNA_PROBS_WINDOW_UP together with
+ *  #VRNA_ANY_LOOP), all other data is ignored.
+ *
+ *  @see  vrna_probs_window(), vrna_file_plfold_bin_writer()
+ *
+ *  @param  pr      An array of probabilities
+ *  @param  pr_size The length of the probability array
+ *  @param  i       The i-position (5') of the probabilities
+ *  @param  max     The (theoretical) maximum length of the probability array
+ *  @param  type    The type of data that is provided
+ *  @param  data    The file as obtained from vrna_file_plfold_bin_writer()
+ */
+void
+vrna_file_plfold_bin_cb(FLT_OR_DBL    *pr,
+                        int           pr_size,
+                        int           i,
+                        int           max,
+                        unsigned int  type,
+                        void          *data);
+
+
+/**
+ *  @brief  Complete and close a binary sliding window probability file
+ *
+ *  @param  writer  The file as obtained from vrna_file_plfold_bin_writer()
+ *  @return         1 on success, 0 if any write operation failed
+ */
+int
+vrna_file_plfold_bin_writer_close(vrna_plfold_bin_writer_t *writer);
+
+
+/**
+ * @}
+ */
+
+#endif
@@ -8,8 +8,10 @@
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <stdint.h>
 
 #include "ViennaRNA/datastructures/basic.h"
+#include "ViennaRNA/datastructures/hash_tables.h"
 #include "ViennaRNA/model.h"
 #include "ViennaRNA/params/basic.h"
 #include "ViennaRNA/fold.h"
@@ -18,21 +20,31 @@
 #include "ViennaRNA/utils/basic.h"
 #include "ViennaRNA/utils/strings.h"
 #include "ViennaRNA/utils/structures.h"
+#include "ViennaRNA/utils/cpu.h"
+#include "ViennaRNA/constraints/soft.h"
 #include "ViennaRNA/landscape/findpath.h"
 
 
-#ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
-
 #ifdef _OPENMP
 #include <omp.h>
 #endif
 
+#ifdef __GNUC__
+# define INLINE inline
+#else
+# define INLINE
 #endif
 
 #define LOOP_EN
 
 #define   PATH_DIRECT_FINDPATH     1U
 
+/* number of intermediates allocated at once by the intermediate pool */
+#define   POOL_BLOCK_SIZE          256
+
+/* maximum number of bits for the hash table used to remove duplicate intermediates */
+#define   MAX_HASH_BITS            20
+
 /**
  *  @brief
  */
@@ -47,13 +59,40 @@ typedef struct move {
  *  @brief
  */
 typedef struct intermediate {
-  short   *pt;      /**<  @brief  pair table */
-  int     Sen;      /**<  @brief  saddle energy so far */
-  int     curr_en;  /**<  @brief  current energy */
-  move_t  *moves;   /**<  @brief  remaining moves to target */
+  short     *pt;      /**<  @brief  pair table */
+  int       Sen;      /**<  @brief  saddle energy so far */
+  int       curr_en;  /**<  @brief  current energy */
+  move_t    *moves;   /**<  @brief  remaining moves to target */
+  uint64_t  key;      /**<  @brief  Zobrist key of the pair table */
 } intermediate_t;
 
 
+/**
+ *  @brief  Free-list memory pool for the move lists and pair tables of intermediates
+ *
+ *  The move list and the pair table of an intermediate are stored in a single
+ *  chunk of memory, where the pair table directly follows the move list.
+ */
+typedef struct {
+  size_t  size;         /**<  @brief  size of a chunk in bytes */
+  int     num_moves;    /**<  @brief  length of the move lists, including the terminating entry */
+  char    **blocks;
+  size_t  num_blocks;
+  size_t  block_fill;   /**<  @brief  number of chunks handed out from the last block */
+  void    *recycled;    /**<  @brief  released chunks, linked through their first bytes */
+} intermediate_pool_t;
+
+
+/**
+ *  @brief  The result of a single findpath run
+ */
+struct findpath_dat {
+  int     BP_dist;  /**<  @brief  base pair distance between start and target structure */
+  move_t  *path;    /**<  @brief  moves of the best path found */
+  int     path_fwd; /**<  @brief  1: s1->s2, else s2 -> s1 */
+};
+
+
 struct vrna_path_options_s {
   unsigned int  type;
   unsigned int  method;
@@ -72,11 +111,6 @@ struct vrna_path_options_s {
  # PRIVATE VARIABLES             #
  #################################
  */
-PRIVATE int                   BP_dist;
-PRIVATE move_t                *path = NULL;
-PRIVATE int                   path_fwd; /* 1: s1->s2, else s2 -> s1 */
-
-
 #ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
 
 PRIVATE vrna_fold_compound_t  *backward_compat_compound = NULL;
@@ -85,7 +119,7 @@ PRIVATE vrna_fold_compound_t  *backward_compat_compound = NULL;
 
 /* NOTE: all variables are assumed to be uninitialized if they are declared as threadprivate
  */
-#pragma omp threadprivate(BP_dist, path, path_fwd, backward_compat_compound)
+#pragma omp threadprivate(backward_compat_compound)
 
 #endif
 
@@ -97,12 +131,8 @@ PRIVATE vrna_fold_compound_t  *backward_compat_compound = NULL;
  #################################
  */
 PRIVATE move_t *
-copy_moves(move_t *mvs);
-
-
-PRIVATE int
-compare_ptable(const void *A,
-               const void *B);
+copy_moves(move_t *mvs,
+           int    num_moves);
 
 
 PRIVATE int
@@ -116,7 +146,37 @@ compare_moves_when(const void *A,
 
 
 PRIVATE void
-free_intermediate(intermediate_t *i);
+free_intermediate(intermediate_t      *i,
+                  intermediate_pool_t *pool);
+
+
+PRIVATE void
+init_intermediate(intermediate_t      *i,
+                  intermediate_pool_t *pool,
+                  int                 len);
+
+
+PRIVATE void
+free_intermediate_pool(intermediate_pool_t *pool);
+
+
+PRIVATE INLINE uint64_t
+pair_key(int  i,
+         int  j);
+
+
+PRIVATE int
+compare_intermediate(void *A,
+                     void *B);
+
+
+PRIVATE unsigned int
+hash_intermediate(void          *A,
+                  unsigned long hashtable_size);
+
+
+PRIVATE int
+free_intermediate_entry(void *A);
 
 
 #ifdef TEST_FINDPATH
@@ -133,7 +193,28 @@ find_path_once(vrna_fold_compound_t *vc,
                short                *pt1,
                short                *pt2,
                int                  maxl,
-               int                  maxE);
+               int                  maxE,
+               struct findpath_dat  *dat);
+
+
+PRIVATE int
+findpath_saddle(vrna_fold_compound_t  *vc,
+                const char            *s1,
+                const char            *s2,
+                int                   width,
+                int                   maxE,
+                struct findpath_dat   *dat);
+
+
+PRIVATE vrna_path_t *
+findpath_method(vrna_fold_compound_t  *fc,
+                const char            *s1,
+                const char            *s2,
+                int                   width,
+                int                   maxE,
+                unsigned int          return_type,
+                const float           *endpoints,
+                int                   *saddle);
 
 
 PRIVATE int
@@ -141,7 +222,8 @@ try_moves(vrna_fold_compound_t  *vc,
           intermediate_t        c,
           int                   maxE,
           intermediate_t        *next,
-          int                   dist);
+          int                   dist,
+          intermediate_pool_t   *pool);
 
 
 /*
@@ -189,51 +271,11 @@ vrna_path_findpath_saddle_ub(vrna_fold_compound_t *vc,
                              int                  width,
                              int                  maxE)
 {
-  int     maxl;
-  short   *ptr, *pt1, *pt2;
-  move_t  *bestpath = NULL;
-  int     dir;
-
-  path_fwd  = dir = 0;
-  pt1       = vrna_ptable(s1);
-  pt2       = vrna_ptable(s2);
-
-  maxl = 1;
-  do {
-    int saddleE;
-    path_fwd = !path_fwd;
-    if (maxl > width)
-      maxl = width;
+  struct findpath_dat dat;
 
-    if (path)
-      free(path);
+  maxE = findpath_saddle(vc, s1, s2, width, maxE, &dat);
 
-    saddleE = find_path_once(vc, pt1, pt2, maxl, maxE);
-    if (saddleE < maxE) {
-      maxE = saddleE;
-      if (bestpath)
-        free(bestpath);
-
-      bestpath  = path;
-      path      = NULL;
-      dir       = path_fwd;
-    } else {
-      free(path);
-      path = NULL;
-    }
-
-    ptr   = pt1;
-    pt1   = pt2;
-    pt2   = ptr;
-    maxl  *= 2;
-  } while (maxl < 2 * width);
-
-  /* (re)set some globals */
-  path      = bestpath;
-  path_fwd  = dir;
-
-  free(pt1);
-  free(pt2);
+  free(dat.path);
 
   return maxE;
 }
@@ -284,6 +326,73 @@ vrna_path_findpath_ub(vrna_fold_compound_t  *fc,
 }
 
 
+PUBLIC int
+vrna_path_findpath_batch(vrna_fold_compound_t *fc,
+                         const char           **s1,
+                         const char           **s2,
+                         size_t               num_pairs,
+                         int                  width,
+                         int                  *saddles,
+                         vrna_path_t          **paths)
+{
+  size_t  k;
+  int     num_threads;
+  float   *endpoints;
+
+  if ((!fc) || (!fc->params) || (!s1) || (!s2) || (!saddles))
+    return 0;
+
+  /*
+   *  soft constraints are prepared lazily upon energy evaluation, so we do
+   *  that once in advance to leave the fold compound untouched afterwards
+   */
+  vrna_sc_prepare(fc, VRNA_OPTION_MFE);
+
+  /*
+   *  vrna_eval_structure() temporarily modifies the model details, so the
+   *  energies of the first and last structure of each path are evaluated
+   *  before the threads share the fold compound
+   */
+  endpoints = NULL;
+
+  if (paths) {
+    endpoints = (float *)vrna_alloc(sizeof(float) * 2 * num_pairs);
+
+    for (k = 0; k < num_pairs; k++) {
+      endpoints[2 * k]      = vrna_eval_structure(fc, s1[k]);
+      endpoints[2 * k + 1]  = vrna_eval_structure(fc, s2[k]);
+    }
+  }
+
+  num_threads = vrna_cpu_threads(fc->params->model_details.threads);
+
+  if ((fc->params->model_details.threads == 1) ||
+      (num_pairs < 2))
+    num_threads = 1;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads) if (num_threads > 1)
+#endif
+  for (k = 0; k < num_pairs; k++) {
+    if (paths)
+      paths[k] = findpath_method(fc,
+                                 s1[k],
+                                 s2[k],
+                                 width,
+                                 INT_MAX - 1,
+                                 VRNA_PATH_TYPE_DOT_BRACKET,
+                                 endpoints + 2 * k,
+                                 saddles + k);
+    else
+      saddles[k] = vrna_path_findpath_saddle(fc, s1[k], s2[k], width);
+  }
+
+  free(endpoints);
+
+  return 1;
+}
+
+
 PUBLIC struct vrna_path_options_s *
 vrna_path_options_findpath(int          width,
                            unsigned int type)
@@ -312,13 +421,24 @@ findpath_method(vrna_fold_compound_t  *fc,
                 const char            *s2,
                 int                   width,
                 int                   maxE,
-                unsigned int          return_type)
+                unsigned int          return_type,
+                const float           *endpoints,
+                int                   *saddle)
 {
-  int         E, d;
-  float       last_E;
-  vrna_path_t *route = NULL;
+  int                 E, d, BP_dist;
+  float               last_E, E1, E2;
+  move_t              *path;
+  vrna_path_t         *route = NULL;
+  struct findpath_dat dat;
 
-  E = vrna_path_findpath_saddle_ub(fc, s1, s2, width, maxE);
+  E       = findpath_saddle(fc, s1, s2, width, maxE, &dat);
+  BP_dist = dat.BP_dist;
+  path    = dat.path;
+  E1      = (endpoints) ? endpoints[0] : 0.;
+  E2      = (endpoints) ? endpoints[1] : 0.;
+
+  if (saddle)
+    *saddle = E;
 
   /* did we find a better path than one with saddle maxE? */
   if (E < maxE) {
@@ -328,8 +448,8 @@ findpath_method(vrna_fold_compound_t  *fc,
 
     switch (return_type) {
       case VRNA_PATH_TYPE_MOVES:
-        if (path_fwd) {
-          last_E = vrna_eval_structure(fc, s1);
+        if (dat.path_fwd) {
+          last_E = (endpoints) ? E1 : vrna_eval_structure(fc, s1);
           for (d = 0; d < BP_dist; d++) {
             route[d].type = return_type;
             route[d].move = vrna_move_init(path[d].i,
@@ -341,7 +461,7 @@ findpath_method(vrna_fold_compound_t  *fc,
           route[BP_dist].type = return_type;
           route[BP_dist].move = vrna_move_init(0, 0);
         } else {
-          last_E = vrna_eval_structure(fc, s2);
+          last_E = (endpoints) ? E2 : vrna_eval_structure(fc, s2);
           for (d = 0; d < BP_dist; d++) {
             route[BP_dist - d - 2].type = return_type;
             route[BP_dist - d - 2].move = vrna_move_init(path[d].i,
@@ -360,11 +480,11 @@ findpath_method(vrna_fold_compound_t  *fc,
       /* fall through */
 
       default:
-        if (path_fwd) {
+        if (dat.path_fwd) {
           /* memorize start of path */
           route[0].type = return_type;
           route[0].s    = strdup(s1);
-          route[0].en   = vrna_eval_structure(fc, s1);
+          route[0].en   = (endpoints) ? E1 : vrna_eval_structure(fc, s1);
 
           for (d = 0; d < BP_dist; d++) {
             int i, j;
@@ -386,7 +506,7 @@ findpath_method(vrna_fold_compound_t  *fc,
           /* memorize start of path */
           route[0].type     = return_type;
           route[BP_dist].s  = strdup(s2);
-          route[BP_dist].en = vrna_eval_structure(fc, s2);
+          route[BP_dist].en = (endpoints) ? E2 : vrna_eval_structure(fc, s2);
 
           for (d = 0; d < BP_dist; d++) {
             int i, j;
@@ -421,7 +541,6 @@ findpath_method(vrna_fold_compound_t  *fc,
   }
 
   free(path);
-  path = NULL;
 
   return route;
 }
@@ -459,7 +578,7 @@ vrna_path_direct_ub(vrna_fold_compound_t        *fc,
     case PATH_DIRECT_FINDPATH:
     /* fall through */
     default:
-      route = findpath_method(fc, s1, s2, o->width, maxE, o->type);
+      route = findpath_method(fc, s1, s2, o->width, maxE, o->type, NULL, NULL);
       break;
   }
 
@@ -476,7 +595,6 @@ PUBLIC void
 print_path(const char *seq,
            const char *struc)
 {
-  int   d;
   char  *s;
 
   s = strdup(struc);
@@ -494,21 +612,6 @@ print_path(const char *seq,
     free(pseq);
   }
 
-  qsort(path, BP_dist, sizeof(move_t), compare_moves_when);
-  for (d = 0; d < BP_dist; d++) {
-    int i, j;
-    i = path[d].i;
-    j = path[d].j;
-    if (i < 0) {
-      /* delete */
-      s[(-i) - 1] = s[(-j) - 1] = '.';
-    } else {
-      s[i - 1]  = '(';
-      s[j - 1]  = ')';
-    }
-
-    /* printf("%s %6.2f - %6.2f\n", s, vrna_eval_structure_simple(seq,s), path[d].E/100.0); */
-  }
   free(s);
 }
 
@@ -556,13 +659,8 @@ main(int  argc,
   E = find_saddle(seq, s1, s2, maxkeep);
   printf("saddle_energy = %6.2f\n", E / 100.);
   if (verbose) {
-    if (path_fwd)
-      print_path(seq, s1);
-    else
-      print_path(seq, s2);
+    print_path(seq, s1);
 
-    free(path);
-    path  = NULL;
     route = get_path(seq, s1, s2, maxkeep);
     for (r = route; r->s; r++) {
       if (cut_point == -1) {
@@ -608,7 +706,8 @@ try_moves(vrna_fold_compound_t  *vc,
           intermediate_t        c,
           int                   maxE,
           intermediate_t        *next,
-          int                   dist)
+          int                   dist,
+          intermediate_pool_t   *pool)
 {
   int     *loopidx, len, num_next = 0, en, oldE;
   move_t  *mv;
@@ -622,42 +721,51 @@ try_moves(vrna_fold_compound_t  *vc,
     if (mv->when > 0)
       continue;
 
-    i   = mv->i;
-    j   = mv->j;
-    pt  = (short *)vrna_alloc(sizeof(short) * (len + 1));
-    memcpy(pt, c.pt, (len + 1) * sizeof(short));
+    i = mv->i;
+    j = mv->j;
+
+    if ((j > 0) &&
+        ((loopidx[i] != loopidx[j]) ||  /* i and j belong to different loops */
+         (c.pt[i] != 0) || (c.pt[j] != 0))) /* ... or are paired */
+      continue; /* llegal move, try next; */
+
+#ifdef LOOP_EN
+    en = c.curr_en + vrna_eval_move_pt(vc, c.pt, i, j);
+#else
+    pt = vrna_ptable_copy(c.pt);
     if (j < 0) {
-      /*it's a delete move */
       pt[-i]  = 0;
       pt[-j]  = 0;
     } else {
-      /* insert move */
-      if ((loopidx[i] == loopidx[j]) && /* i and j belong to same loop */
-          (pt[i] == 0) && (pt[j] == 0)  /* ... and are unpaired */
-          ) {
-        pt[i] = j;
-        pt[j] = i;
-      } else {
-        free(pt);
-        continue; /* llegal move, try next; */
-      }
+      pt[i] = j;
+      pt[j] = i;
     }
 
-#ifdef LOOP_EN
-    en = c.curr_en + vrna_eval_move_pt(vc, c.pt, i, j);
-#else
     en = vrna_eval_structure_pt(vc, pt);
+    free(pt);
 #endif
     if (en < maxE) {
+      init_intermediate(next + num_next, pool, len);
+
+      pt = next[num_next].pt;
+      memcpy(pt, c.pt, (len + 1) * sizeof(short));
+      if (j < 0) {
+        /*it's a delete move */
+        pt[-i]  = 0;
+        pt[-j]  = 0;
+      } else {
+        /* insert move */
+        pt[i] = j;
+        pt[j] = i;
+      }
+
       next[num_next].Sen      = (en > oldE) ? en : oldE;
       next[num_next].curr_en  = en;
-      next[num_next].pt       = pt;
+      next[num_next].key      = c.key ^ pair_key((i < 0) ? -i : i, (j < 0) ? -j : j);
       mv->when                = dist;
       mv->E                   = en;
-      next[num_next++].moves  = copy_moves(c.moves);
-      mv->when                = 0;
-    } else {
-      free(pt);
+      memcpy(next[num_next++].moves, c.moves, sizeof(move_t) * pool->num_moves);
+      mv->when = 0;
     }
   }
   free(loopidx);
@@ -665,29 +773,86 @@ try_moves(vrna_fold_compound_t  *vc,
 }
 
 
+PRIVATE int
+findpath_saddle(vrna_fold_compound_t  *vc,
+                const char            *s1,
+                const char            *s2,
+                int                   width,
+                int                   maxE,
+                struct findpath_dat   *dat)
+{
+  int     maxl;
+  short   *ptr, *pt1, *pt2;
+  move_t  *bestpath = NULL;
+  int     dir;
+
+  dat->path     = NULL;
+  dat->path_fwd = dir = 0;
+  pt1           = vrna_ptable(s1);
+  pt2           = vrna_ptable(s2);
+
+  maxl = 1;
+  do {
+    int saddleE;
+    dat->path_fwd = !dat->path_fwd;
+    if (maxl > width)
+      maxl = width;
+
+    saddleE = find_path_once(vc, pt1, pt2, maxl, maxE, dat);
+    if (saddleE < maxE) {
+      maxE = saddleE;
+      if (bestpath)
+        free(bestpath);
+
+      bestpath  = dat->path;
+      dat->path = NULL;
+      dir       = dat->path_fwd;
+    } else {
+      free(dat->path);
+      dat->path = NULL;
+    }
+
+    ptr   = pt1;
+    pt1   = pt2;
+    pt2   = ptr;
+    maxl  *= 2;
+  } while (maxl < 2 * width);
+
+  dat->path     = bestpath;
+  dat->path_fwd = dir;
+
+  free(pt1);
+  free(pt2);
+
+  return maxE;
+}
+
+
 PRIVATE int
 find_path_once(vrna_fold_compound_t *vc,
                short                *pt1,
                short                *pt2,
                int                  maxl,
-               int                  maxE)
+               int                  maxE,
+               struct findpath_dat  *dat)
 {
-  move_t          *mlist;
-  int             i, len, d, dist = 0, result;
-  short           *pt;
-  intermediate_t  *current, *next;
+  move_t              *mlist;
+  int                 i, len, d, dist = 0, result;
+  unsigned int        hash_bits;
+  intermediate_t      *current, *next, *dup;
+  intermediate_pool_t pool;
+  vrna_hash_table_t   ht;
 
   len = (int)pt1[0];
-  pt  = vrna_ptable_copy(pt1);
 
-  mlist = (move_t *)vrna_alloc(sizeof(move_t) * len); /* bp_dist < n */
+  mlist = (move_t *)vrna_alloc(sizeof(move_t) * (len + 1)); /* bp_dist < n */
 
   for (i = 1; i <= len; i++) {
-    if (pt[i] != pt2[i]) {
-      if (i < pt[i]) {
+    if (pt1[i] != pt2[i]) {
+      if (i < pt1[i]) {
         /* need to delete this pair */
         mlist[dist].i       = -i;
-        mlist[dist].j       = -pt[i];
+        mlist[dist].j       = -pt1[i];
         mlist[dist++].when  = 0;
       }
 
@@ -700,12 +865,39 @@ find_path_once(vrna_fold_compound_t *vc,
     }
   }
 
-  BP_dist           = dist;
-  current           = (intermediate_t *)vrna_alloc(sizeof(intermediate_t) * (maxl + 1));
-  current[0].pt     = pt;
-  current[0].Sen    = current[0].curr_en = vrna_eval_structure_pt(vc, pt);
-  current[0].moves  = mlist;
-  next              = (intermediate_t *)vrna_alloc(sizeof(intermediate_t) * (dist * maxl + 1));
+  dat->BP_dist = dist;
+
+  /* move lists and pair tables of all intermediates are drawn from a common pool */
+  pool.num_moves  = dist + 1;
+  pool.size       = sizeof(move_t) * pool.num_moves + sizeof(short) * (len + 1);
+  pool.size       = (pool.size + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *);
+  pool.blocks     = NULL;
+  pool.num_blocks = 0;
+  pool.block_fill = POOL_BLOCK_SIZE;
+  pool.recycled   = NULL;
+
+  current = (intermediate_t *)vrna_alloc(sizeof(intermediate_t) * (maxl + 1));
+  init_intermediate(current, &pool, len);
+  memcpy(current[0].pt, pt1, sizeof(short) * (len + 1));
+  memcpy(current[0].moves, mlist, sizeof(move_t) * pool.num_moves);
+  current[0].Sen = current[0].curr_en = vrna_eval_structure_pt(vc, pt1);
+  current[0].key = 0;
+  for (i = 1; i <= len; i++)
+    if (i < pt1[i])
+      current[0].key ^= pair_key(i, pt1[i]);
+
+  free(mlist);
+
+  next = (intermediate_t *)vrna_alloc(sizeof(intermediate_t) * (dist * maxl + 1));
+
+  /* duplicates are identified by the Zobrist keys of their pair tables */
+  for (hash_bits = 8; (hash_bits < MAX_HASH_BITS) && ((1UL << hash_bits) < 2UL * dist * maxl);
+       hash_bits++);
+
+  ht = vrna_ht_init(hash_bits,
+                    compare_intermediate,
+                    hash_intermediate,
+                    free_intermediate_entry);
 
   for (d = 1; d <= dist; d++) {
     /* go through the distance classes */
@@ -713,75 +905,155 @@ find_path_once(vrna_fold_compound_t *vc,
     intermediate_t  *cc;
 
     for (c = 0; current[c].pt != NULL; c++)
-      num_next += try_moves(vc, current[c], maxE, next + num_next, d);
+      num_next += try_moves(vc, current[c], maxE, next + num_next, d, &pool);
     if (num_next == 0) {
       for (cc = current; cc->pt != NULL; cc++)
-        free_intermediate(cc);
+        free_intermediate(cc, &pool);
       current[0].Sen = INT_MAX;
       break;
     }
 
-    /* remove duplicates via sort|uniq
-     * if this becomes a bottleneck we can use a hash instead */
-    qsort(next, num_next, sizeof(intermediate_t), compare_ptable);
-    for (u = 0, c = 1; c < num_next; c++) {
-      if (memcmp(next[u].pt, next[c].pt, sizeof(short) * len) != 0)
-        next[++u] = next[c];
-      else
-        free_intermediate(next + c);
+    /* remove duplicates, keep the one with lowest saddle energy */
+    for (u = 0, c = 0; c < num_next; c++) {
+      dup = (intermediate_t *)vrna_ht_get(ht, next + c);
+      if (dup == NULL) {
+        next[u] = next[c];
+        vrna_ht_insert(ht, next + u);
+        u++;
+      } else if (compare_energy(next + c, dup) < 0) {
+        free_intermediate(dup, &pool);
+        *dup = next[c];
+      } else {
+        free_intermediate(next + c, &pool);
+      }
     }
-    num_next = u + 1;
+    num_next = u;
+
+    for (c = 0; c < num_next; c++)
+      vrna_ht_remove(ht, next + c);
+
     qsort(next, num_next, sizeof(intermediate_t), compare_energy);
     /* free the old stuff */
     for (cc = current; cc->pt != NULL; cc++)
-      free_intermediate(cc);
+      free_intermediate(cc, &pool);
     for (u = 0; u < maxl && u < num_next; u++)
       current[u] = next[u];
     for (; u < num_next; u++)
-      free_intermediate(next + u);
+      free_intermediate(next + u, &pool);
     num_next = 0;
   }
   free(next);
-  path    = current[0].moves;
-  result  = current[0].Sen;
-  free(current[0].pt);
+  vrna_ht_free(ht);
+
+  dat->path = (current[0].moves) ? copy_moves(current[0].moves, pool.num_moves) : NULL;
+  result    = current[0].Sen;
   free(current);
+  free_intermediate_pool(&pool);
+
   return result;
 }
 
 
 PRIVATE void
-free_intermediate(intermediate_t *i)
+init_intermediate(intermediate_t      *i,
+                  intermediate_pool_t *pool,
+                  int                 len)
 {
-  free(i->pt);
-  free(i->moves);
+  void *chunk;
+
+  if (pool->recycled) {
+    chunk           = pool->recycled;
+    pool->recycled  = *((void **)chunk);
+  } else {
+    if (pool->block_fill == POOL_BLOCK_SIZE) {
+      pool->blocks = (char **)vrna_realloc(pool->blocks,
+                                           sizeof(char *) * (pool->num_blocks + 1));
+      pool->blocks[pool->num_blocks++] = (char *)vrna_alloc(pool->size * POOL_BLOCK_SIZE);
+      pool->block_fill                 = 0;
+    }
+
+    chunk = pool->blocks[pool->num_blocks - 1] + pool->size * pool->block_fill++;
+  }
+
+  i->moves  = (move_t *)chunk;
+  i->pt     = (short *)(i->moves + pool->num_moves);
+}
+
+
+PRIVATE void
+free_intermediate(intermediate_t      *i,
+                  intermediate_pool_t *pool)
+{
+  if (i->moves) {
+    *((void **)i->moves)  = pool->recycled;
+    pool->recycled        = (void *)i->moves;
+  }
+
   i->pt     = NULL;
   i->moves  = NULL;
   i->Sen    = INT_MAX;
 }
 
 
+PRIVATE void
+free_intermediate_pool(intermediate_pool_t *pool)
+{
+  size_t b;
+
+  for (b = 0; b < pool->num_blocks; b++)
+    free(pool->blocks[b]);
+
+  free(pool->blocks);
+}
+
+
+/* Zobrist-like key of a base pair, the key of a structure is the XOR of the keys of its pairs */
+PRIVATE INLINE uint64_t
+pair_key(int  i,
+         int  j)
+{
+  uint64_t z = (((uint64_t)i << 32) | (uint64_t)j) + 0x9E3779B97F4A7C15ULL;
+
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+  return z ^ (z >> 31);
+}
+
+
 PRIVATE int
-compare_ptable(const void *A,
-               const void *B)
+compare_intermediate(void *A,
+                     void *B)
 {
-  intermediate_t  *a, *b;
-  int             c;
+  intermediate_t *a, *b;
 
   a = (intermediate_t *)A;
   b = (intermediate_t *)B;
 
-  c = memcmp(a->pt, b->pt, a->pt[0] * sizeof(short));
-  if (c != 0)
-    return c;
+  if (a->key != b->key)
+    return (a->key < b->key) ? -1 : 1;
 
-  if ((a->Sen - b->Sen) != 0)
-    return a->Sen - b->Sen;
+  return memcmp(a->pt, b->pt, (a->pt[0] + 1) * sizeof(short));
+}
 
-  return a->curr_en - b->curr_en;
+
+PRIVATE unsigned int
+hash_intermediate(void          *A,
+                  unsigned long hashtable_size)
+{
+  return (unsigned int)(((intermediate_t *)A)->key % hashtable_size);
 }
 
 
+PRIVATE int
+free_intermediate_entry(void *A)
+{
+  /* entries are owned by the breadth-first search */
+  return 0;
+}
+
+
+
 PRIVATE int
 compare_energy(const void *A,
                const void *B)
@@ -794,7 +1066,11 @@ compare_energy(const void *A,
   if ((a->Sen - b->Sen) != 0)
     return a->Sen - b->Sen;
 
-  return a->curr_en - b->curr_en;
+  if ((a->curr_en - b->curr_en) != 0)
+    return a->curr_en - b->curr_en;
+
+  /* keep the order of intermediates with equal energies independent of the order they were generated in */
+  return memcmp(a->pt, b->pt, a->pt[0] * sizeof(short));
 }
 
 
@@ -812,12 +1088,13 @@ compare_moves_when(const void *A,
 
 
 PRIVATE move_t *
-copy_moves(move_t *mvs)
+copy_moves(move_t *mvs,
+           int    num_moves)
 {
   move_t *new;
 
-  new = (move_t *)vrna_alloc(sizeof(move_t) * (BP_dist + 1));
-  memcpy(new, mvs, sizeof(move_t) * (BP_dist + 1));
+  new = (move_t *)vrna_alloc(sizeof(move_t) * num_moves);
+  memcpy(new, mvs, sizeof(move_t) * num_moves);
   return new;
 }
 
@@ -152,6 +152,43 @@ vrna_path_findpath_ub(vrna_fold_compound_t  *fc,
                       int                   maxE);
 
 
+/**
+ *  @brief Find refolding paths for a batch of structure pairs
+ *
+ *  Computes the saddle energies, and optionally the direct refolding paths, for
+ *  @p num_pairs pairs of start and target structures, i.e. it is equivalent to
+ *  calling vrna_path_findpath_saddle(), or vrna_path_findpath() for each pair
+ *  @f$(s1[k], s2[k])@f$. The pairs are processed concurrently with the number of
+ *  threads specified in #vrna_md_t.threads of the fold compound. All threads share
+ *  the fold compound @p fc, which is only read during the computations.
+ *
+ *  The results do not depend on the number of threads.
+ *
+ *  @note User-defined soft constraint callbacks must be thread-safe if more than
+ *        one thread is used.
+ *
+ *  @see  vrna_path_findpath_saddle(), vrna_path_findpath(), vrna_path_free(), #vrna_md_t.threads
+ *
+ *  @param fc         The #vrna_fold_compound_t with precomputed sequence encoding and model details
+ *  @param s1         The start structures in dot-bracket notation
+ *  @param s2         The target structures in dot-bracket notation
+ *  @param num_pairs  The number of structure pairs
+ *  @param width      A number specifying how many strutures are being kept at each step during the search
+ *  @param saddles    An array of size @p num_pairs to store the saddle energies in 10cal/mol to
+ *  @param paths      An array of size @p num_pairs to store the refolding paths to, or NULL if only
+ *                    the saddle energies are required. Each path must be released with vrna_path_free().
+ *  @returns          1 on success, 0 otherwise
+ */
+int
+vrna_path_findpath_batch(vrna_fold_compound_t *fc,
+                         const char           **s1,
+                         const char           **s2,
+                         size_t               num_pairs,
+                         int                  width,
+                         int                  *saddles,
+                         vrna_path_t          **paths);
+
+
 #ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
 
 /**
@@ -27,10 +27,11 @@
 
 
 struct heap_rev_idx {
-  vrna_heap_t heap;
-  short       *pt;
-  size_t      *reverse_idx;
-  size_t      *reverse_idx_remove;
+  vrna_heap_t       heap;
+  short             *pt;
+  vrna_loop_cache_t *cache;
+  size_t            *reverse_idx;
+  size_t            *reverse_idx_remove;
 };
 
 
@@ -229,7 +230,9 @@ do_path(vrna_fold_compound_t  *vc,
 
   int         numberOfMoves = 0;
 
-  int         energy = vrna_eval_structure_pt(vc, ptStartAndResultStructure);
+  vrna_loop_cache_t *cache = vrna_loop_cache_init(vc, ptStartAndResultStructure);
+
+  int         energy = vrna_loop_cache_energy(cache);
 
   vrna_move_t *moveset = vrna_neighbors(vc, ptStartAndResultStructure, options);
 
@@ -249,7 +252,7 @@ do_path(vrna_fold_compound_t  *vc,
       int lowestEnergy      = 0;
       int i                 = 0;
       for (vrna_move_t *moveNeighbor = moveset; moveNeighbor->pos_5 != 0; moveNeighbor++, i++) {
-        energyNeighbor = vrna_eval_move_shift_pt(vc, moveNeighbor, ptStartAndResultStructure);
+        energyNeighbor = vrna_eval_move_cache(vc, cache, moveNeighbor->pos_5, moveNeighbor->pos_3);
         if (energyNeighbor <= lowestEnergy) {
           /* make the walk unique */
           if ((energyNeighbor == lowestEnergy) &&
@@ -275,7 +278,7 @@ do_path(vrna_fold_compound_t  *vc,
         length++;
       int index = rand() % length;
       m               = moveset[index];
-      energyNeighbor  = vrna_eval_move_shift_pt(vc, &m, ptStartAndResultStructure);
+      energyNeighbor  = vrna_eval_move_cache(vc, cache, m.pos_5, m.pos_3);
       iterations--;
     }
 
@@ -306,8 +309,9 @@ do_path(vrna_fold_compound_t  *vc,
     free(moveset);
     moveset = newMoveSet;
 
-    /* adjust pt for next round */
+    /* adjust pt and loop energies for next round */
     vrna_move_apply(ptStartAndResultStructure, &m);
+    (void)vrna_loop_cache_apply(vc, cache, m.pos_5, m.pos_3);
     energy += energyNeighbor;
 
     /* alternative neighbor generation
@@ -317,6 +321,10 @@ do_path(vrna_fold_compound_t  *vc,
      */
   }
 
+  /* random walks end with the neighbors of the last structure */
+  if (!isDeepest)
+    free(moveset);
+
   if (!(options & VRNA_PATH_NO_TRANSITION_OUTPUT)) {
     vrna_move_t end = {
       0, 0
@@ -325,6 +333,8 @@ do_path(vrna_fold_compound_t  *vc,
     moves                 = vrna_realloc(moves, sizeof(vrna_move_t) * (numberOfMoves + 1));
   }
 
+  vrna_loop_cache_free(cache);
+
   return moves;
 }
 
@@ -372,6 +382,7 @@ gradient_descent_data(size_t  n,
   d->reverse_idx        = (size_t *)vrna_alloc(sizeof(size_t) * size);
   d->reverse_idx_remove = (size_t *)vrna_alloc(sizeof(size_t) * size);
   d->pt                 = pt;
+  d->cache              = NULL;
 
   return d;
 }
@@ -382,6 +393,7 @@ gradient_descent_data_free(struct heap_rev_idx *d)
 {
   free(d->reverse_idx);
   free(d->reverse_idx_remove);
+  vrna_loop_cache_free(d->cache);
   free(d);
 }
 
@@ -460,7 +472,7 @@ gradient_descent_update_cb(vrna_fold_compound_t *fc,
       break;
 
     case VRNA_NEIGHBOR_NEW:
-      dG = vrna_eval_move_pt(fc, lookup->pt, neighbor.pos_5, neighbor.pos_3);
+      dG = vrna_eval_move_cache(fc, lookup->cache, neighbor.pos_5, neighbor.pos_3);
       if (dG <= 0) {
         mm = move_en_init(neighbor, dG);
         vrna_heap_insert(h, mm);
@@ -469,7 +481,7 @@ gradient_descent_update_cb(vrna_fold_compound_t *fc,
       break;
 
     case VRNA_NEIGHBOR_CHANGE:
-      dG = vrna_eval_move_pt(fc, lookup->pt, neighbor.pos_5, neighbor.pos_3);
+      dG = vrna_eval_move_cache(fc, lookup->cache, neighbor.pos_5, neighbor.pos_3);
       if (dG <= 0) {
         mm = move_en_init(neighbor, dG);
         free(vrna_heap_update(h, mm));
@@ -514,10 +526,11 @@ gradient_descent(vrna_fold_compound_t *fc,
                            &get_move_pos,
                            &set_move_pos,
                            (void *)lookup);
-  lookup->heap = h;
+  lookup->heap  = h;
+  lookup->cache = vrna_loop_cache_init(fc, pt);
 
   for (i = 0; neighbors[i].pos_5 != 0; i++) {
-    dG = vrna_eval_move_pt(fc, pt, neighbors[i].pos_5, neighbors[i].pos_3);
+    dG = vrna_eval_move_cache(fc, lookup->cache, neighbors[i].pos_5, neighbors[i].pos_3);
     if (dG <= 0) {
       struct move_en *mm = move_en_init(neighbors[i], dG);
       vrna_heap_insert(h, mm);
@@ -538,6 +551,9 @@ gradient_descent(vrna_fold_compound_t *fc,
         ((dG == 0) && vrna_move_is_removal(&(next_move))))
       break;
 
+    /* update loop energies such that novel neighbors are evaluated for the new structure */
+    (void)vrna_loop_cache_apply(fc, lookup->cache, next_move.pos_5, next_move.pos_3);
+
     vrna_move_neighbor_diff_cb(fc,
                                pt,
                                next_move,
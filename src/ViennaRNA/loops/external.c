@@ -9,6 +9,10 @@
 #include <string.h>
 #include <limits.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "ViennaRNA/fold_vars.h"
 #include "ViennaRNA/params/default.h"
 #include "ViennaRNA/utils/basic.h"
@@ -20,6 +24,7 @@
 #include "ViennaRNA/unstructured_domains.h"
 #include "ViennaRNA/loops/external.h"
 #include "ViennaRNA/utils/higher_order_functions.h"
+#include "ViennaRNA/utils/cpu.h"
 
 #ifdef __GNUC__
 # define INLINE inline
@@ -217,6 +222,17 @@ add_f3_gquad(vrna_fold_compound_t       *fc,
              struct sc_f3_dat           *sc_wrapper);
 
 
+#ifdef _OPENMP
+PRIVATE void
+fill_f5_parallel(vrna_fold_compound_t   *fc,
+                 int                    num_threads,
+                 vrna_hc_eval_f         evaluate,
+                 struct hc_ext_def_dat  *hc_dat_local,
+                 struct sc_f5_dat       *sc_wrapper);
+
+
+#endif
+
 /*
  #################################
  # BEGIN OF FUNCTION DEFINITIONS #
@@ -251,6 +267,18 @@ vrna_E_ext_loop_5(vrna_fold_compound_t *fc)
       f5[1] = MIN2(f5[1], en);
     }
 
+#ifdef _OPENMP
+    int num_threads = vrna_cpu_threads(P->model_details.threads);
+
+    if ((P->model_details.threads != 1) &&
+        (num_threads > 1)) {
+      fill_f5_parallel(fc, num_threads, evaluate, &hc_dat_local, &sc_wrapper);
+      free_sc_f5(&sc_wrapper);
+      return f5[length];
+    }
+
+#endif
+
     /*
      *  duplicated code may be faster than conditions inside loop or even
      *  using a function pointer ;)
@@ -871,6 +899,7 @@ get_stem_contributions_d0(vrna_fold_compound_t      *fc,
   int           i, ij, *indx, *c, *stems;
   vrna_param_t  *P;
   vrna_md_t     *md;
+  vrna_mx_mfe_t *mx;
 
   sc_f5_cb      sc_spl_stem;
   sc_f5_cb      sc_red_stem;
@@ -881,6 +910,7 @@ get_stem_contributions_d0(vrna_fold_compound_t      *fc,
   md    = &(P->model_details);
   indx  = fc->jindx;
   c     = fc->matrices->c;
+  mx    = fc->matrices;
   ij    = indx[j] + j - 1;
   ptype = (fc->type == VRNA_FC_TYPE_SINGLE) ? fc->ptype : NULL;
   n_seq = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq;
@@ -894,9 +924,9 @@ get_stem_contributions_d0(vrna_fold_compound_t      *fc,
       for (i = j - 1; i > 1; i--, ij--) {
         stems[i] = INF;
 
-        if ((c[ij] != INF) &&
+        if ((c[VRNA_MX_MFE_IDX(mx, i, j)] != INF) &&
             (evaluate(1, j, i - 1, i, VRNA_DECOMP_EXT_EXT_STEM, hc_dat_local))) {
-          stems[i]  = c[ij];
+          stems[i]  = c[VRNA_MX_MFE_IDX(mx, i, j)];
           type      = vrna_get_ptype(ij, ptype);
           stems[i]  += vrna_E_ext_stem(type, -1, -1, P);
         }
@@ -906,9 +936,9 @@ get_stem_contributions_d0(vrna_fold_compound_t      *fc,
     case VRNA_FC_TYPE_COMPARATIVE:
       for (i = j - 1; i > 1; i--, ij--) {
         stems[i] = INF;
-        if ((c[ij] != INF) &&
+        if ((c[VRNA_MX_MFE_IDX(mx, i, j)] != INF) &&
             (evaluate(1, j, i - 1, i, VRNA_DECOMP_EXT_EXT_STEM, hc_dat_local))) {
-          stems[i] = c[ij];
+          stems[i] = c[VRNA_MX_MFE_IDX(mx, i, j)];
 
           for (s = 0; s < n_seq; s++) {
             type      = vrna_get_ptype_md(S[s][i], S[s][j], md);
@@ -927,9 +957,9 @@ get_stem_contributions_d0(vrna_fold_compound_t      *fc,
   stems[1]  = INF;
   ij        = indx[j] + 1;
 
-  if ((c[ij] != INF) &&
+  if ((c[VRNA_MX_MFE_IDX(mx, 1, j)] != INF) &&
       (evaluate(1, j, 1, j, VRNA_DECOMP_EXT_STEM, hc_dat_local))) {
-    stems[1] = c[ij];
+    stems[1] = c[VRNA_MX_MFE_IDX(mx, 1, j)];
 
     switch (fc->type) {
       case VRNA_FC_TYPE_SINGLE:
@@ -1136,6 +1166,7 @@ get_stem_contributions_d2(vrna_fold_compound_t      *fc,
   int           n, i, ij, *indx, *c, *stems, mm5;
   vrna_param_t  *P;
   vrna_md_t     *md;
+  vrna_mx_mfe_t *mx;
 
   sc_f5_cb      sc_spl_stem;
   sc_f5_cb      sc_red_stem;
@@ -1148,6 +1179,7 @@ get_stem_contributions_d2(vrna_fold_compound_t      *fc,
   md    = &(P->model_details);
   indx  = fc->jindx;
   c     = fc->matrices->c;
+  mx    = fc->matrices;
   ij    = indx[j] + j - 1;
 
   sc_spl_stem = sc_wrapper->decomp_stem5;
@@ -1162,10 +1194,10 @@ get_stem_contributions_d2(vrna_fold_compound_t      *fc,
 
       for (i = j - 1; i > 1; i--, ij--, si1--) {
         stems[i] = INF;
-        if ((c[ij] != INF) &&
+        if ((c[VRNA_MX_MFE_IDX(mx, i, j)] != INF) &&
             (evaluate(1, j, i - 1, i, VRNA_DECOMP_EXT_EXT_STEM, hc_dat_local))) {
           type      = vrna_get_ptype(ij, ptype);
-          stems[i]  = c[ij] +
+          stems[i]  = c[VRNA_MX_MFE_IDX(mx, i, j)] +
                       vrna_E_ext_stem(type, *si1, sj1, P);
         }
       }
@@ -1178,9 +1210,9 @@ get_stem_contributions_d2(vrna_fold_compound_t      *fc,
       stems[1]  = INF;
       ij        = indx[j] + 1;
 
-      if ((c[ij] != INF) && (evaluate(1, j, 1, j, VRNA_DECOMP_EXT_STEM, hc_dat_local))) {
+      if ((c[VRNA_MX_MFE_IDX(mx, 1, j)] != INF) && (evaluate(1, j, 1, j, VRNA_DECOMP_EXT_STEM, hc_dat_local))) {
         type      = vrna_get_ptype(ij, ptype);
-        stems[1]  = c[ij] +
+        stems[1]  = c[VRNA_MX_MFE_IDX(mx, 1, j)] +
                     vrna_E_ext_stem(type, -1, sj1, P);
 
         if (sc_red_stem)
@@ -1206,9 +1238,9 @@ get_stem_contributions_d2(vrna_fold_compound_t      *fc,
 
       for (i = j - 1; i > 1; i--, ij--) {
         stems[i] = INF;
-        if ((c[ij] != INF) &&
+        if ((c[VRNA_MX_MFE_IDX(mx, i, j)] != INF) &&
             (evaluate(1, j, i - 1, i, VRNA_DECOMP_EXT_EXT_STEM, hc_dat_local))) {
-          stems[i] = c[ij];
+          stems[i] = c[VRNA_MX_MFE_IDX(mx, i, j)];
           for (s = 0; s < n_seq; s++) {
             type      = vrna_get_ptype_md(SS[s][i], sj[s], md);
             mm5       = (a2s[s][i] > 1) ? S5[s][i] : -1;
@@ -1225,8 +1257,8 @@ get_stem_contributions_d2(vrna_fold_compound_t      *fc,
       stems[1]  = INF;
       ij        = indx[j] + 1;
 
-      if ((c[ij] != INF) && (evaluate(1, j, 1, j, VRNA_DECOMP_EXT_STEM, hc_dat_local))) {
-        stems[1] = c[ij];
+      if ((c[VRNA_MX_MFE_IDX(mx, 1, j)] != INF) && (evaluate(1, j, 1, j, VRNA_DECOMP_EXT_STEM, hc_dat_local))) {
+        stems[1] = c[VRNA_MX_MFE_IDX(mx, 1, j)];
 
         for (s = 0; s < n_seq; s++) {
           type      = vrna_get_ptype_md(SS[s][1], sj[s], md);
@@ -1441,6 +1473,7 @@ f5_get_stem_contributions_d5(vrna_fold_compound_t       *fc,
   int           i, ij, *indx, *c, *stems, mm5;
   vrna_param_t  *P;
   vrna_md_t     *md;
+  vrna_mx_mfe_t *mx;
 
   sc_f5_cb      sc_spl_stem;
   sc_f5_cb      sc_red_stem;
@@ -1451,6 +1484,7 @@ f5_get_stem_contributions_d5(vrna_fold_compound_t       *fc,
   md    = &(P->model_details);
   indx  = fc->jindx;
   c     = fc->matrices->c;
+  mx    = fc->matrices;
   ij    = indx[j] + j;
 
   sc_spl_stem = sc_wrapper->decomp_stem5;
@@ -1464,10 +1498,10 @@ f5_get_stem_contributions_d5(vrna_fold_compound_t       *fc,
 
       for (i = j - 1; i > 1; i--, ij--, si1--) {
         stems[i] = INF;
-        if ((c[ij] != INF) &&
+        if ((c[VRNA_MX_MFE_IDX(mx, i + 1, j)] != INF) &&
             (evaluate(1, j, i - 1, i + 1, VRNA_DECOMP_EXT_EXT_STEM, hc_dat_local))) {
           type      = vrna_get_ptype(ij, ptype);
-          stems[i]  = c[ij] +
+          stems[i]  = c[VRNA_MX_MFE_IDX(mx, i + 1, j)] +
                       vrna_E_ext_stem(type, *si1, -1, P);
         }
       }
@@ -1481,9 +1515,9 @@ f5_get_stem_contributions_d5(vrna_fold_compound_t       *fc,
       if (2 < j) {
         ij        = indx[j] + 2;
 
-        if ((c[ij] != INF) && (evaluate(1, j, 2, j, VRNA_DECOMP_EXT_STEM, hc_dat_local))) {
+        if ((c[VRNA_MX_MFE_IDX(mx, 2, j)] != INF) && (evaluate(1, j, 2, j, VRNA_DECOMP_EXT_STEM, hc_dat_local))) {
           type      = vrna_get_ptype(ij, ptype);
-          stems[1]  = c[ij] +
+          stems[1]  = c[VRNA_MX_MFE_IDX(mx, 2, j)] +
                       vrna_E_ext_stem(type, S[1], -1, P);
 
           if (sc_red_stem)
@@ -1504,9 +1538,9 @@ f5_get_stem_contributions_d5(vrna_fold_compound_t       *fc,
 
       for (i = j - 1; i > 1; i--, ij--) {
         stems[i] = INF;
-        if ((c[ij] != INF) &&
+        if ((c[VRNA_MX_MFE_IDX(mx, i + 1, j)] != INF) &&
             (evaluate(1, j, i - 1, i + 1, VRNA_DECOMP_EXT_EXT_STEM, hc_dat_local))) {
-          stems[i] = c[ij];
+          stems[i] = c[VRNA_MX_MFE_IDX(mx, i + 1, j)];
           for (s = 0; s < n_seq; s++) {
             type      = vrna_get_ptype_md(SS[s][i + 1], sj[s], md);
             mm5       = (a2s[s][i + 1] > 1) ? S5[s][i + 1] : -1;
@@ -1525,8 +1559,8 @@ f5_get_stem_contributions_d5(vrna_fold_compound_t       *fc,
       if (2 < j) {
         ij        = indx[j] + 2;
 
-        if ((c[ij] != INF) && (evaluate(1, j, 2, j, VRNA_DECOMP_EXT_STEM, hc_dat_local))) {
-          stems[1] = c[ij];
+        if ((c[VRNA_MX_MFE_IDX(mx, 2, j)] != INF) && (evaluate(1, j, 2, j, VRNA_DECOMP_EXT_STEM, hc_dat_local))) {
+          stems[1] = c[VRNA_MX_MFE_IDX(mx, 2, j)];
           for (s = 0; s < n_seq; s++) {
             type      = vrna_get_ptype_md(SS[s][2], sj[s], md);
             mm5       = (a2s[s][2] > 1) ? S5[s][2] : -1;
@@ -1733,6 +1767,7 @@ f5_get_stem_contributions_d3(vrna_fold_compound_t       *fc,
   int           i, ij, *indx, *c, *stems;
   vrna_param_t  *P;
   vrna_md_t     *md;
+  vrna_mx_mfe_t *mx;
 
   sc_f5_cb      sc_spl_stem;
   sc_f5_cb      sc_red_stem;
@@ -1744,6 +1779,7 @@ f5_get_stem_contributions_d3(vrna_fold_compound_t       *fc,
   md    = &(P->model_details);
   indx  = fc->jindx;
   c     = fc->matrices->c;
+  mx    = fc->matrices;
   ij    = indx[j - 1] + j - 1;
 
   sc_spl_stem = sc_wrapper->decomp_stem51;
@@ -1758,10 +1794,10 @@ f5_get_stem_contributions_d3(vrna_fold_compound_t       *fc,
       for (i = j - 1; i > 1; i--, ij--) {
         stems[i] = INF;
         if ((i + 1 < j) &&
-            (c[ij] != INF) &&
+            (c[VRNA_MX_MFE_IDX(mx, i, j - 1)] != INF) &&
             (evaluate(1, j, i - 1, i, VRNA_DECOMP_EXT_EXT_STEM1, hc_dat_local))) {
           type      = vrna_get_ptype(ij, ptype);
-          stems[i]  = c[ij] +
+          stems[i]  = c[VRNA_MX_MFE_IDX(mx, i, j - 1)] +
                       vrna_E_ext_stem(type, -1, sj1, P);
         }
       }
@@ -1776,9 +1812,9 @@ f5_get_stem_contributions_d3(vrna_fold_compound_t       *fc,
       if (1 + 1 < j) {
         ij        = indx[j - 1] + 1;
 
-        if ((c[ij] != INF) && (evaluate(1, j, 1, j - 1, VRNA_DECOMP_EXT_STEM, hc_dat_local))) {
+        if ((c[VRNA_MX_MFE_IDX(mx, 1, j - 1)] != INF) && (evaluate(1, j, 1, j - 1, VRNA_DECOMP_EXT_STEM, hc_dat_local))) {
           type      = vrna_get_ptype(ij, ptype);
-          stems[1]  = c[ij] +
+          stems[1]  = c[VRNA_MX_MFE_IDX(mx, 1, j - 1)] +
                       vrna_E_ext_stem(type, -1, sj1, P);
 
           if (sc_red_stem)
@@ -1805,9 +1841,9 @@ f5_get_stem_contributions_d3(vrna_fold_compound_t       *fc,
       for (i = j - 1; i > 1; i--, ij--) {
         stems[i] = INF;
         if ((i + 1 < j) &&
-            (c[ij] != INF) &&
+            (c[VRNA_MX_MFE_IDX(mx, i, j - 1)] != INF) &&
             (evaluate(1, j, i - 1, i, VRNA_DECOMP_EXT_EXT_STEM1, hc_dat_local))) {
-          stems[i] = c[ij];
+          stems[i] = c[VRNA_MX_MFE_IDX(mx, i, j - 1)];
           for (s = 0; s < n_seq; s++) {
             type      = vrna_get_ptype_md(SS[s][i], ssj1[s], md);
             stems[i]  += vrna_E_ext_stem(type, -1, s3j1[s], P);
@@ -1825,8 +1861,8 @@ f5_get_stem_contributions_d3(vrna_fold_compound_t       *fc,
       if (1 + 1 < j) {
         ij        = indx[j - 1] + 1;
 
-        if ((c[ij] != INF) && (evaluate(1, j, 1, j - 1, VRNA_DECOMP_EXT_STEM, hc_dat_local))) {
-          stems[1] = c[ij];
+        if ((c[VRNA_MX_MFE_IDX(mx, 1, j - 1)] != INF) && (evaluate(1, j, 1, j - 1, VRNA_DECOMP_EXT_STEM, hc_dat_local))) {
+          stems[1] = c[VRNA_MX_MFE_IDX(mx, 1, j - 1)];
 
           for (s = 0; s < n_seq; s++) {
             type      = vrna_get_ptype_md(SS[s][1], ssj1[s], md);
@@ -2042,6 +2078,7 @@ f5_get_stem_contributions_d53(vrna_fold_compound_t      *fc,
   int           i, ij, *indx, *c, *stems;
   vrna_param_t  *P;
   vrna_md_t     *md;
+  vrna_mx_mfe_t *mx;
 
   sc_f5_cb      sc_spl_stem;
   sc_f5_cb      sc_red_stem;
@@ -2053,6 +2090,7 @@ f5_get_stem_contributions_d53(vrna_fold_compound_t      *fc,
   md    = &(P->model_details);
   indx  = fc->jindx;
   c     = fc->matrices->c;
+  mx    = fc->matrices;
   ij    = indx[j - 1] + j;
 
   sc_spl_stem = sc_wrapper->decomp_stem51;
@@ -2068,10 +2106,10 @@ f5_get_stem_contributions_d53(vrna_fold_compound_t      *fc,
       for (i = j - 1; i > 1; i--, ij--, si1--) {
         stems[i] = INF;
         if ((i + 2 < j) &&
-            (c[ij] != INF) &&
+            (c[VRNA_MX_MFE_IDX(mx, i + 1, j - 1)] != INF) &&
             (evaluate(1, j, i - 1, i + 1, VRNA_DECOMP_EXT_EXT_STEM1, hc_dat_local))) {
           type      = vrna_get_ptype(ij, ptype);
-          stems[i]  = c[ij] +
+          stems[i]  = c[VRNA_MX_MFE_IDX(mx, i + 1, j - 1)] +
                       vrna_E_ext_stem(type, *si1, sj1, P);
         }
       }
@@ -2086,9 +2124,9 @@ f5_get_stem_contributions_d53(vrna_fold_compound_t      *fc,
       if (2 + 1 < j) {
         ij        = indx[j - 1] + 2;
 
-        if ((c[ij] != INF) && (evaluate(1, j, 2, j - 1, VRNA_DECOMP_EXT_STEM, hc_dat_local))) {
+        if ((c[VRNA_MX_MFE_IDX(mx, 2, j - 1)] != INF) && (evaluate(1, j, 2, j - 1, VRNA_DECOMP_EXT_STEM, hc_dat_local))) {
           type      = vrna_get_ptype(ij, ptype);
-          stems[1]  = c[ij] +
+          stems[1]  = c[VRNA_MX_MFE_IDX(mx, 2, j - 1)] +
                       vrna_E_ext_stem(type, S[1], sj1, P);
 
           if (sc_red_stem)
@@ -2116,9 +2154,9 @@ f5_get_stem_contributions_d53(vrna_fold_compound_t      *fc,
       for (i = j - 1; i > 1; i--, ij--, si1--) {
         stems[i] = INF;
         if ((i + 1 < j) &&
-            (c[ij] != INF) &&
+            (c[VRNA_MX_MFE_IDX(mx, i + 1, j - 1)] != INF) &&
             (evaluate(1, j, i - 1, i + 1, VRNA_DECOMP_EXT_EXT_STEM1, hc_dat_local))) {
-          stems[i] = c[ij];
+          stems[i] = c[VRNA_MX_MFE_IDX(mx, i + 1, j - 1)];
           for (s = 0; s < n_seq; s++) {
             type      = vrna_get_ptype_md(SS[s][i + 1], ssj1[s], md);
             stems[i]  += vrna_E_ext_stem(type, (a2s[s][i + 1] > 1) ? S5[s][i + 1] : -1, s3j1[s], P);
@@ -2135,8 +2173,8 @@ f5_get_stem_contributions_d53(vrna_fold_compound_t      *fc,
       if (2 + 1 < j) {
         ij        = indx[j - 1] + 2;
 
-        if ((c[ij] != INF) && (evaluate(1, j, 2, j - 1, VRNA_DECOMP_EXT_STEM, hc_dat_local))) {
-          stems[1] = c[ij];
+        if ((c[VRNA_MX_MFE_IDX(mx, 2, j - 1)] != INF) && (evaluate(1, j, 2, j - 1, VRNA_DECOMP_EXT_STEM, hc_dat_local))) {
+          stems[1] = c[VRNA_MX_MFE_IDX(mx, 2, j - 1)];
           for (s = 0; s < n_seq; s++) {
             type      = vrna_get_ptype_md(SS[s][2], ssj1[s], md);
             stems[1]  += vrna_E_ext_stem(type, (a2s[s][2] > 1) ? S5[s][2] : -1, s3j1[s], P);
@@ -2425,6 +2463,125 @@ decompose_f3_ext_stem(vrna_fold_compound_t  *fc,
 }
 
 
+#ifdef _OPENMP
+
+typedef int *(*f5_stems_f)(vrna_fold_compound_t   *fc,
+                           int                    j,
+                           vrna_hc_eval_f         evaluate,
+                           struct hc_ext_def_dat  *hc_dat_local,
+                           struct sc_f5_dat       *sc_wrapper);
+
+
+/*
+ *  Fill the f5 array with multiple threads. The stem contributions of
+ *  a block of columns j only depend on the (complete) c matrix and are
+ *  computed in parallel, together with the part of the modular
+ *  decomposition that refers to already known f5 values. The remaining
+ *  tail of each decomposition is then resolved serially. Since we only
+ *  split minimizations, the result is identical to the serial fill.
+ */
+PRIVATE void
+fill_f5_parallel(vrna_fold_compound_t   *fc,
+                 int                    num_threads,
+                 vrna_hc_eval_f         evaluate,
+                 struct hc_ext_def_dat  *hc_dat_local,
+                 struct sc_f5_dat       *sc_wrapper)
+{
+  int           j, j0, j1, b, v, en, head, tail, length, block, num_stems,
+                *f5, *partial, ***stems, with_gquad;
+  f5_stems_f    stem_cbs[4];
+  vrna_gr_aux_t *grammar;
+
+  length      = (int)fc->length;
+  f5          = fc->matrices->f5;
+  with_gquad  = fc->params->model_details.gquad;
+  grammar     = fc->aux_grammar;
+  block       = 4 * num_threads;
+
+  switch (fc->params->model_details.dangles) {
+    case 0:
+      stem_cbs[0] = &get_stem_contributions_d0;
+      num_stems   = 1;
+      break;
+
+    case 2:
+      stem_cbs[0] = &get_stem_contributions_d2;
+      num_stems   = 1;
+      break;
+
+    default:
+      stem_cbs[0] = &get_stem_contributions_d0;
+      stem_cbs[1] = &f5_get_stem_contributions_d5;
+      stem_cbs[2] = &f5_get_stem_contributions_d3;
+      stem_cbs[3] = &f5_get_stem_contributions_d53;
+      num_stems   = 4;
+      break;
+  }
+
+  partial = (int *)vrna_alloc(sizeof(int) * block);
+  stems   = (int ***)vrna_alloc(sizeof(int **) * block);
+
+  for (b = 0; b < block; b++)
+    stems[b] = (int **)vrna_alloc(sizeof(int *) * num_stems);
+
+  for (j0 = 2; j0 <= length; j0 += block) {
+    j1 = MIN2(j0 + block - 1, length);
+
+#pragma omp parallel for private(j, v, en, head) schedule(dynamic, 1) num_threads(num_threads)
+    for (j = j0; j <= j1; j++) {
+      /* f5[1..j0 - 1] is already known */
+      head              = MIN2(j - 2, j0 - 1);
+      partial[j - j0]   = INF;
+
+      for (v = 0; v < num_stems; v++) {
+        stems[j - j0][v]  = stem_cbs[v](fc, j, evaluate, hc_dat_local, sc_wrapper);
+        en                = vrna_fun_zip_add_min(f5 + 1, stems[j - j0][v] + 2, head);
+        en                = MIN2(en, stems[j - j0][v][1]);
+        partial[j - j0]   = MIN2(partial[j - j0], en);
+      }
+    }
+
+    for (j = j0; j <= j1; j++) {
+      /* extend previous solution(s) by adding an unpaired region */
+      f5[j] = reduce_f5_up(fc, j, evaluate, hc_dat_local, sc_wrapper);
+      f5[j] = MIN2(f5[j], partial[j - j0]);
+
+      /* resolve the remaining decompositions into exterior loop part followed by a stem */
+      head  = MIN2(j - 2, j0 - 1);
+      tail  = j - 2 - head;
+
+      for (v = 0; v < num_stems; v++) {
+        if (tail > 0) {
+          en    = vrna_fun_zip_add_min(f5 + 1 + head, stems[j - j0][v] + 2 + head, tail);
+          f5[j] = MIN2(f5[j], en);
+        }
+
+        free(stems[j - j0][v]);
+      }
+
+      if (with_gquad) {
+        en    = add_f5_gquad(fc, j, evaluate, hc_dat_local, sc_wrapper);
+        f5[j] = MIN2(f5[j], en);
+      }
+
+      if ((grammar) && (grammar->cb_aux_f)) {
+        en    = grammar->cb_aux_f(fc, 1, j, grammar->data);
+        f5[j] = MIN2(f5[j], en);
+      }
+    }
+  }
+
+  for (b = 0; b < block; b++)
+    free(stems[b]);
+
+  free(stems);
+  free(partial);
+}
+
+
+#endif
+
+
 /*
  *###########################################
  *# deprecated functions below              #
@@ -151,6 +151,18 @@ void
 vrna_exp_E_ext_fast_free(vrna_mx_pf_aux_el_t aux_mx);
 
 
+/**
+ *  @brief  Let the helper arrays of the exterior loop decomposition point to external memory
+ *
+ *  Same as vrna_exp_E_ml_fast_attach() but for the exterior loop helper arrays
+ *  of the current (@p qq) and previous (@p qq1) column.
+ */
+void
+vrna_exp_E_ext_fast_attach(vrna_mx_pf_aux_el_t  aux_mx,
+                           FLT_OR_DBL           *qq,
+                           FLT_OR_DBL           *qq1);
+
+
 FLT_OR_DBL
 vrna_exp_E_ext_fast(vrna_fold_compound_t  *fc,
                     int                   i,
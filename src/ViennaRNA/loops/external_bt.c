@@ -179,6 +179,7 @@ BT_ext_loop_f5(vrna_fold_compound_t *fc,
                             dangle_model, with_gquad, cnt, ii, with_ud;
   vrna_param_t              *P;
   vrna_md_t                 *md;
+  vrna_mx_mfe_t             *mx;
   vrna_sc_t                 *sc;
   vrna_ud_t                 *domains_up;
   vrna_hc_eval_f  evaluate;
@@ -190,6 +191,7 @@ BT_ext_loop_f5(vrna_fold_compound_t *fc,
   sn            = fc->strand_number;
   sc            = fc->sc;
   my_f5         = fc->matrices->f5;
+  mx            = fc->matrices;
   my_c          = fc->matrices->c;
   my_ggg        = fc->matrices->ggg;
   domains_up    = fc->domains_up;
@@ -316,7 +318,7 @@ BT_ext_loop_f5(vrna_fold_compound_t *fc,
         if (evaluate(1, jj, u - 1, u, VRNA_DECOMP_EXT_EXT_STEM, &hc_dat_local)) {
           type = vrna_get_ptype(idx[jj] + u, ptype);
 
-          en = my_c[idx[jj] + u];
+          en = my_c[VRNA_MX_MFE_IDX(mx, u, jj)];
           if (sc)
             if (sc->f)
               en += sc->f(1, jj, u - 1, u, VRNA_DECOMP_EXT_EXT_STEM, sc->data);
@@ -353,7 +355,7 @@ BT_ext_loop_f5(vrna_fold_compound_t *fc,
           mm5   = ((u > 1) && (sn[u] == sn[u - 1])) ? S1[u - 1] : -1;
           type  = vrna_get_ptype(idx[jj] + u, ptype);
 
-          en = my_c[idx[jj] + u];
+          en = my_c[VRNA_MX_MFE_IDX(mx, u, jj)];
           if (sc)
             if (sc->f)
               en += sc->f(1, jj, u - 1, u, VRNA_DECOMP_EXT_EXT_STEM, sc->data);
@@ -387,7 +389,7 @@ BT_ext_loop_f5(vrna_fold_compound_t *fc,
       if (evaluate(1, jj, 1, jj, VRNA_DECOMP_EXT_STEM, &hc_dat_local)) {
         type = vrna_get_ptype(idx[jj] + 1, ptype);
 
-        en = my_c[idx[jj] + 1];
+        en = my_c[VRNA_MX_MFE_IDX(mx, 1, jj)];
         if (sc)
           if (sc->f)
             en += sc->f(1, jj, 1, jj, VRNA_DECOMP_EXT_STEM, sc->data);
@@ -412,7 +414,7 @@ BT_ext_loop_f5(vrna_fold_compound_t *fc,
           mm3   = S1[jj];
           type  = vrna_get_ptype(idx[jj - 1] + 1, ptype);
 
-          en = my_c[idx[jj - 1] + 1];
+          en = my_c[VRNA_MX_MFE_IDX(mx, 1, jj - 1)];
           if (sc) {
             if (sc->energy_up)
               en += sc->energy_up[jj][1];
@@ -448,7 +450,7 @@ BT_ext_loop_f5(vrna_fold_compound_t *fc,
 
         type = vrna_get_ptype(idx[jj] + u, ptype);
 
-        en = my_c[idx[jj] + u];
+        en = my_c[VRNA_MX_MFE_IDX(mx, u, jj)];
 #if 0
         if (sn[jj] != sn[u])
           en += P->DuplexInit;
@@ -501,7 +503,7 @@ BT_ext_loop_f5(vrna_fold_compound_t *fc,
 
         type = vrna_get_ptype(idx[jj - 1] + u, ptype);
 
-        en = my_c[idx[jj - 1] + u];
+        en = my_c[VRNA_MX_MFE_IDX(mx, u, jj - 1)];
 
 #if 0
         if (sn[jj - 1] != sn[u])
@@ -577,6 +579,7 @@ BT_ext_loop_f5_comparative(vrna_fold_compound_t *fc,
                             dangle_model, with_gquad, n_seq, ss, mm5, mm3;
   vrna_param_t              *P;
   vrna_md_t                 *md;
+  vrna_mx_mfe_t             *mx;
   vrna_sc_t                 **scs;
   vrna_hc_eval_f evaluate;
   struct hc_ext_def_dat     hc_dat_local;
@@ -591,6 +594,7 @@ BT_ext_loop_f5_comparative(vrna_fold_compound_t *fc,
   md            = &(P->model_details);
   scs           = fc->scs;
   my_f5         = fc->matrices->f5;
+  mx            = fc->matrices;
   my_c          = fc->matrices->c;
   my_ggg        = fc->matrices->ggg;
   idx           = fc->jindx;
@@ -645,7 +649,7 @@ BT_ext_loop_f5_comparative(vrna_fold_compound_t *fc,
         }
 
         if (evaluate(1, jj, u - 1, u, VRNA_DECOMP_EXT_EXT_STEM, &hc_dat_local)) {
-          en = my_c[idx[jj] + u] +
+          en = my_c[VRNA_MX_MFE_IDX(mx, u, jj)] +
                my_f5[u - 1];
 
           for (ss = 0; ss < n_seq; ss++) {
@@ -682,7 +686,7 @@ BT_ext_loop_f5_comparative(vrna_fold_compound_t *fc,
         }
 
         if (evaluate(1, jj, u - 1, u, VRNA_DECOMP_EXT_EXT_STEM, &hc_dat_local)) {
-          en = my_c[idx[jj] + u] +
+          en = my_c[VRNA_MX_MFE_IDX(mx, u, jj)] +
                my_f5[u - 1];
 
           for (ss = 0; ss < n_seq; ss++) {
@@ -12,6 +12,7 @@
 #include "ViennaRNA/fold_vars.h"
 #include "ViennaRNA/params/default.h"
 #include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/utils/higher_order_functions.h"
 #include "ViennaRNA/alphabet.h"
 #include "ViennaRNA/constraints/hard.h"
 #include "ViennaRNA/constraints/soft.h"
@@ -37,6 +38,8 @@ struct vrna_mx_pf_aux_el_s {
 
   int         qqu_size;
   FLT_OR_DBL  **qqu;
+
+  unsigned char attached;  /* qq and qq1 point to external memory */
 };
 
 /*
@@ -230,8 +233,10 @@ vrna_exp_E_ext_fast_free(struct vrna_mx_pf_aux_el_s *aux_mx)
   if (aux_mx) {
     int u;
 
-    free(aux_mx->qq);
-    free(aux_mx->qq1);
+    if (!aux_mx->attached) {
+      free(aux_mx->qq);
+      free(aux_mx->qq1);
+    }
 
     if (aux_mx->qqu) {
       for (u = 0; u <= aux_mx->qqu_size; u++)
@@ -245,6 +250,24 @@ vrna_exp_E_ext_fast_free(struct vrna_mx_pf_aux_el_s *aux_mx)
 }
 
 
+PUBLIC void
+vrna_exp_E_ext_fast_attach(struct vrna_mx_pf_aux_el_s *aux_mx,
+                           FLT_OR_DBL                 *qq,
+                           FLT_OR_DBL                 *qq1)
+{
+  if (aux_mx) {
+    if (!aux_mx->attached) {
+      free(aux_mx->qq);
+      free(aux_mx->qq1);
+      aux_mx->attached = 1;
+    }
+
+    aux_mx->qq  = qq;
+    aux_mx->qq1 = qq1;
+  }
+}
+
+
 PUBLIC FLT_OR_DBL
 vrna_exp_E_ext_fast(vrna_fold_compound_t        *fc,
                     int                         i,
@@ -545,11 +568,9 @@ split_ext_fast(vrna_fold_compound_t       *fc,
    *  strands in hard constraints, we have to think of something else...
    */
   if ((evaluate == &hc_ext_cb_def) || (evaluate == &hc_ext_cb_def_window)) {
-    for (k = j; k > i; k--) {
-      qbt += q[ij1] *
-             qqq[k];
-      ij1 -= factor;
-    }
+    qbt += (factor == 1) ?
+           vrna_fun_zip_mult_sum(q + i, qqq + i + 1, j - i) :
+           vrna_fun_zip_mult_sum_rev(q - i, qqq + i + 1, j - i);
   } else {
     for (k = j; k > i; k--) {
       if (evaluate(i, j, k - 1, k, VRNA_DECOMP_EXT_EXT_EXT, hc_dat_local))
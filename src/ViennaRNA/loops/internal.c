@@ -10,6 +10,7 @@
 #include "ViennaRNA/fold_vars.h"
 #include "ViennaRNA/alphabet.h"
 #include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/utils/higher_order_functions.h"
 #include "ViennaRNA/constraints/hard.h"
 #include "ViennaRNA/constraints/soft.h"
 #include "ViennaRNA/loops/external.h"
@@ -370,8 +371,9 @@ E_internal_loop(vrna_fold_compound_t  *fc,
   short                 *S, **SS, **S5, **S3;
   unsigned int          *sn, **a2s, n_seq, s, n;
   int                   e, eee, *idx, ij, *c, *ggg, *rtype, with_ud, with_gquad, noclose,
-                        *hc_up, **c_local, **ggg_local;
+                        *hc_up, **c_local, **ggg_local, vectorize, tiled;
   vrna_param_t          *P;
+  vrna_mx_mfe_t         *mx;
   vrna_md_t             *md;
   vrna_ud_t             *domains_up;
   struct hc_int_def_dat hc_dat_local;
@@ -400,6 +402,8 @@ E_internal_loop(vrna_fold_compound_t  *fc,
   S5          = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S5;
   S3          = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S3;
   a2s         = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->a2s;
+  mx          = fc->matrices;
+  tiled       = (mx->type == VRNA_MX_TILED) ? 1 : 0;
   c           = (sliding_window) ? NULL : fc->matrices->c;
   ggg         = (sliding_window) ? NULL : fc->matrices->ggg;
   c_local     = (sliding_window) ? fc->matrices->c_local : NULL;
@@ -415,7 +419,7 @@ E_internal_loop(vrna_fold_compound_t  *fc,
 
   if (hc_decompose & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
     unsigned int  type, type2, has_nick, *tt;
-    int           k, l, kl, last_k, first_l, u1, u2, noGUclosure;
+    int           k, l, kl, first_k, last_k, first_l, u1, u2, noGUclosure;
 
     has_nick    = sn[i] != sn[j] ? 1 : 0;
     noGUclosure = md->noGUclosure;
@@ -429,6 +433,19 @@ E_internal_loop(vrna_fold_compound_t  *fc,
 
     noclose = ((noGUclosure) && (type == 3 || type == 4)) ? 1 : 0;
 
+    /*
+     *  generic interior loops of single sequences without soft constraints,
+     *  user-defined hard constraints, or unstructured domains are evaluated
+     *  row-wise by the (SIMD) kernel vrna_fun_int_loop_min()
+     */
+    vectorize = ((fc->type == VRNA_FC_TYPE_SINGLE) &&
+                 (!sliding_window) &&
+                 (!has_nick) &&
+                 (!fc->hc->f) &&
+                 (!sc_wrapper.pair) &&
+                 (!with_ud) &&
+                 (md->salt == VRNA_MODEL_DEFAULT_SALT)) ? 1 : 0;
+
     if (fc->type == VRNA_FC_TYPE_COMPARATIVE) {
       tt = (unsigned int *)vrna_alloc(sizeof(unsigned int) * n_seq);
       for (s = 0; s < n_seq; s++)
@@ -444,7 +461,7 @@ E_internal_loop(vrna_fold_compound_t  *fc,
 
       if ((hc_decompose & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) &&
           (evaluate(i, j, k, l, &hc_dat_local))) {
-        eee = (sliding_window) ? c_local[k][l - k] : c[kl];
+        eee = (sliding_window) ? c_local[k][l - k] : c[VRNA_MX_MFE_IDX(mx, k, l)];
 
         if (eee != INF) {
           switch (fc->type) {
@@ -518,7 +535,7 @@ E_internal_loop(vrna_fold_compound_t  *fc,
 
           if ((hc_decompose & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) &&
               (evaluate(i, j, k, l, &hc_dat_local))) {
-            eee = (sliding_window) ? c_local[k][l - k] : c[kl];
+            eee = (sliding_window) ? c_local[k][l - k] : c[VRNA_MX_MFE_IDX(mx, k, l)];
 
             if (eee < INF) {
               switch (fc->type) {
@@ -602,7 +619,7 @@ E_internal_loop(vrna_fold_compound_t  *fc,
 
           if ((hc_decompose & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) &&
               (evaluate(i, j, k, l, &hc_dat_local))) {
-            eee = (sliding_window) ? c_local[k][l - k] : c[kl];
+            eee = (sliding_window) ? c_local[k][l - k] : c[VRNA_MX_MFE_IDX(mx, k, l)];
 
             if (eee < INF) {
               switch (fc->type) {
@@ -691,12 +708,66 @@ E_internal_loop(vrna_fold_compound_t  *fc,
 
         hc_mx += n * l;
 
+        if (vectorize) {
+          /* leave the special cases 1x1, 2x1, 1xn, 2x2, and 2x3 to the scalar loop below */
+          switch (u2) {
+            case 1:
+              first_k = i + 4;
+              break;
+            case 2:
+              first_k = i + 5;
+              break;
+            case 3:
+              first_k = i + 4;
+              break;
+            default:
+              first_k = i + 3;
+              break;
+          }
+
+          if (first_k <= last_k) {
+            int p, count, en;
+
+            /*
+             *  the kernel requires consecutive entries c[k,l], which tiled
+             *  matrices only provide within each panel of rows
+             */
+            eee = INF;
+            for (p = first_k; p <= last_k; p += count) {
+              count = last_k - p + 1;
+
+              if (tiled)
+                count = MIN2(count, VRNA_MX_TILE_SIZE - p % VRNA_MX_TILE_SIZE);
+
+              en = vrna_fun_int_loop_min(c + VRNA_MX_MFE_IDX(mx, p, l),
+                                         ptype + idx[l] + p,
+                                         hc_mx + p,
+                                         S + p - 1,
+                                         p - i - 1,
+                                         u2,
+                                         S[l + 1],
+                                         count,
+                                         P);
+              eee = MIN2(eee, en);
+            }
+
+            if (eee < INF) {
+              eee += (u2 == 1) ?
+                     P->mismatch1nI[type][S[i + 1]][S[j - 1]] :
+                     P->mismatchI[type][S[i + 1]][S[j - 1]];
+              e = MIN2(e, eee);
+            }
+
+            last_k = first_k - 1;
+          }
+        }
+
         for (; k <= last_k; k++, u1++, kl++) {
           hc_decompose = (sliding_window) ? hc_mx_local[k][l - k] : hc_mx[k];
 
           if ((hc_decompose & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) &&
               (evaluate(i, j, k, l, &hc_dat_local))) {
-            eee = (sliding_window) ? c_local[k][l - k] : c[kl];
+            eee = (sliding_window) ? c_local[k][l - k] : c[VRNA_MX_MFE_IDX(mx, k, l)];
 
             if (eee < INF) {
               switch (fc->type) {
@@ -102,6 +102,7 @@ BT_stack(vrna_fold_compound_t *fc,
   int                   ret, eee, ij, p, q, *idx, *my_c, **c_local, *rtype;
   vrna_param_t          *P;
   vrna_md_t             *md;
+  vrna_mx_mfe_t         *mx;
   vrna_hc_t             *hc;
   eval_hc               evaluate;
   struct hc_int_def_dat hc_dat_local;
@@ -118,6 +119,7 @@ BT_stack(vrna_fold_compound_t *fc,
   P               = fc->params;
   md              = &(P->model_details);
   hc              = fc->hc;
+  mx              = fc->matrices;
   my_c            = (sliding_window) ? NULL : fc->matrices->c;
   c_local         = (sliding_window) ? fc->matrices->c_local : NULL;
   ij              = (sliding_window) ? 0 : idx[*j] + *i;
@@ -129,7 +131,7 @@ BT_stack(vrna_fold_compound_t *fc,
 
   init_sc_int(fc, &sc_wrapper);
 
-  eee = (sliding_window) ? c_local[*i][*j - *i] : my_c[ij];
+  eee = (sliding_window) ? c_local[*i][*j - *i] : my_c[VRNA_MX_MFE_IDX(mx, *i, *j)];
 
   if (eee == *en) {
     /*  always true, if (i.j) closes canonical structure,
@@ -219,6 +221,7 @@ BT_int_loop(vrna_fold_compound_t  *fc,
                         **c_local, ret;
   vrna_param_t          *P;
   vrna_md_t             *md;
+  vrna_mx_mfe_t         *mx;
   vrna_hc_t             *hc;
   eval_hc               evaluate;
   struct hc_int_def_dat hc_dat_local;
@@ -234,6 +237,7 @@ BT_int_loop(vrna_fold_compound_t  *fc,
   P               = fc->params;
   md              = &(P->model_details);
   hc              = fc->hc;
+  mx              = fc->matrices;
   my_c            = (sliding_window) ? NULL : fc->matrices->c;
   c_local         = (sliding_window) ? fc->matrices->c_local : NULL;
   ij              = (sliding_window) ? 0 : idx[*j] + *i;
@@ -266,7 +270,7 @@ BT_int_loop(vrna_fold_compound_t  *fc,
 
         energy = (sliding_window) ?
                  c_local[p][q - p] :
-                 my_c[idx[q] + p];
+                 my_c[VRNA_MX_MFE_IDX(mx, p, q)];
 
         energy += vrna_eval_int_loop(fc, *i, *j, p, q);
 
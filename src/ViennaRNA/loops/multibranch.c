@@ -104,6 +104,16 @@ ml_pair53(vrna_fold_compound_t      *fc,
           struct sc_mb_dat          *sc_wrapper);
 
 
+PRIVATE INLINE int
+ml_split_min(vrna_mx_mfe_t  *mx,
+             int            *fmi,
+             int            *fm,
+             unsigned char  *mask,
+             int            k,
+             int            j,
+             int            count);
+
+
 /*
  #################################
  # BEGIN OF FUNCTION DEFINITIONS #
@@ -725,6 +735,7 @@ E_mb_loop_stack(vrna_fold_compound_t  *fc,
                             type, type_2, *rtype, **c_local, **fML_local;
   vrna_param_t              *P;
   vrna_md_t                 *md;
+  vrna_mx_mfe_t             *mx;
   vrna_hc_eval_f evaluate;
   struct hc_mb_def_dat      hc_dat_local;
   struct sc_mb_dat          sc_wrapper;
@@ -736,6 +747,7 @@ E_mb_loop_stack(vrna_fold_compound_t  *fc,
   indx        = fc->jindx;
   P           = fc->params;
   md          = &(P->model_details);
+  mx          = fc->matrices;
   c           = (sliding_window) ? NULL : fc->matrices->c;
   fML         = (sliding_window) ? NULL : fc->matrices->fML;
   c_local     = (sliding_window) ? fc->matrices->c_local : NULL;
@@ -823,8 +835,8 @@ E_mb_loop_stack(vrna_fold_compound_t  *fc,
         i1k = indx[k] + i + 1;
 
         if (evaluate(i, j, i + 1, k, VRNA_DECOMP_ML_COAXIAL, &hc_dat_local)) {
-          en = c[i1k] +
-               fML[k1j1];
+          en = c[VRNA_MX_MFE_IDX(mx, i + 1, k)] +
+               fML[VRNA_MX_MFE_IDX(mx, k + 1, j - 1)];
 
           switch (fc->type) {
             case VRNA_FC_TYPE_SINGLE:
@@ -849,8 +861,8 @@ E_mb_loop_stack(vrna_fold_compound_t  *fc,
         }
 
         if (evaluate(i, j, k + 1, j - 1, VRNA_DECOMP_ML_COAXIAL, &hc_dat_local)) {
-          en = c[k1j1] +
-               fML[i1k];
+          en = c[VRNA_MX_MFE_IDX(mx, k + 1, j - 1)] +
+               fML[VRNA_MX_MFE_IDX(mx, i + 1, k)];
 
           switch (fc->type) {
             case VRNA_FC_TYPE_SINGLE:
@@ -915,6 +927,7 @@ extend_fm_3p(int                        i,
   vrna_param_t  *P;
   vrna_md_t     *md;
   vrna_ud_t     *domains_up;
+  vrna_mx_mfe_t *mx;
 
   sliding_window  = (fc->hc->type == VRNA_HC_WINDOW) ? 1 : 0;
   n_seq           = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq;
@@ -925,6 +938,7 @@ extend_fm_3p(int                        i,
   S3              = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S3;
   indx            = (sliding_window) ? NULL : fc->jindx;
   sn              = fc->strand_number;
+  mx              = fc->matrices;
   c               = (sliding_window) ? NULL : fc->matrices->c;
   ggg             = (sliding_window) ? NULL : fc->matrices->ggg;
   c_local         = (sliding_window) ? fc->matrices->c_local : NULL;
@@ -947,7 +961,7 @@ extend_fm_3p(int                        i,
   }
 
   if (evaluate(i, j, i, j, VRNA_DECOMP_ML_STEM, hc_dat_local)) {
-    en = (sliding_window) ? c_local[i][j - i] : c[ij];
+    en = (sliding_window) ? c_local[i][j - i] : c[VRNA_MX_MFE_IDX(mx, i, j)];
     if (en != INF) {
       switch (fc->type) {
         case VRNA_FC_TYPE_SINGLE:
@@ -995,7 +1009,7 @@ extend_fm_3p(int                        i,
   }
 
   if (evaluate(i, j, i, j - 1, VRNA_DECOMP_ML_ML, hc_dat_local)) {
-    en = (sliding_window) ? fm_local[i][j - 1 - i] : fm[indx[j - 1] + i];
+    en = (sliding_window) ? fm_local[i][j - 1 - i] : fm[VRNA_MX_MFE_IDX(mx, i, j - 1)];
     if (en != INF) {
       en += P->MLbase *
             n_seq;
@@ -1010,7 +1024,7 @@ extend_fm_3p(int                        i,
   if (dangle_model % 2) {
     if ((i + 1 < j) &&
         (evaluate(i, j, i + 1, j, VRNA_DECOMP_ML_STEM, hc_dat_local))) {
-      en = (sliding_window) ? c_local[i + 1][j - i - 1] : c[indx[j] + i + 1];
+      en = (sliding_window) ? c_local[i + 1][j - i - 1] : c[VRNA_MX_MFE_IDX(mx, i + 1, j)];
       if (en != INF) {
         switch (fc->type) {
           case VRNA_FC_TYPE_SINGLE:
@@ -1038,7 +1052,7 @@ extend_fm_3p(int                        i,
 
     if ((i + 1 < j) &&
         (evaluate(i, j, i, j - 1, VRNA_DECOMP_ML_STEM, hc_dat_local))) {
-      en = (sliding_window) ? c_local[i][j - 1 - i] : c[indx[j - 1] + i];
+      en = (sliding_window) ? c_local[i][j - 1 - i] : c[VRNA_MX_MFE_IDX(mx, i, j - 1)];
       if (en != INF) {
         switch (fc->type) {
           case VRNA_FC_TYPE_SINGLE:
@@ -1066,7 +1080,7 @@ extend_fm_3p(int                        i,
 
     if ((i + 2 < j) &&
         (evaluate(i, j, i + 1, j - 1, VRNA_DECOMP_ML_STEM, hc_dat_local))) {
-      en = (sliding_window) ? c_local[i + 1][j - 1 - i - 1] : c[indx[j - 1] + i + 1];
+      en = (sliding_window) ? c_local[i + 1][j - 1 - i - 1] : c[VRNA_MX_MFE_IDX(mx, i + 1, j - 1)];
       if (en != INF) {
         switch (fc->type) {
           case VRNA_FC_TYPE_SINGLE:
@@ -1099,7 +1113,7 @@ extend_fm_3p(int                        i,
       u = domains_up->uniq_motif_size[cnt];
       k = j - u + 1;
       if ((k > i) && (evaluate(i, j, i, k - 1, VRNA_DECOMP_ML_ML, hc_dat_local))) {
-        en = (sliding_window) ? fm_local[i][k - 1 - i] : fm[indx[k - 1] + i];
+        en = (sliding_window) ? fm_local[i][k - 1 - i] : fm[VRNA_MX_MFE_IDX(mx, i, k - 1)];
         if (en != INF) {
           en += u * P->MLbase *
                 n_seq;
@@ -1144,6 +1158,7 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
   vrna_param_t              *P;
   vrna_md_t                 *md;
   vrna_ud_t                 *domains_up;
+  vrna_mx_mfe_t             *mx;
   vrna_hc_eval_f evaluate;
   struct hc_mb_def_dat      hc_dat_local;
   struct sc_mb_dat          sc_wrapper;
@@ -1164,6 +1179,7 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
   se            = fc->strand_end;
   hc            = fc->hc;
   sc            = fc->sc;
+  mx            = fc->matrices;
   c             = (sliding_window) ? NULL : fc->matrices->c;
   c_local       = (sliding_window) ? fc->matrices->c_local : NULL;
   fm            = (sliding_window) ? NULL : fc->matrices->fML;
@@ -1194,7 +1210,7 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
    */
   if ((i + 1 < j) &&
       (evaluate(i, j, i + 1, j, VRNA_DECOMP_ML_ML, &hc_dat_local))) {
-    en = (sliding_window) ? fm_local[i + 1][j - i - 1] : fm[ij + 1];
+    en = (sliding_window) ? fm_local[i + 1][j - i - 1] : fm[VRNA_MX_MFE_IDX(mx, i + 1, j)];
     if (en != INF) {
       en += P->MLbase *
             n_seq;
@@ -1212,7 +1228,7 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
       u = domains_up->uniq_motif_size[cnt];
       k = i + u - 1;
       if ((k < j) && (evaluate(i, j, k + 1, j, VRNA_DECOMP_ML_ML, &hc_dat_local))) {
-        decomp = (sliding_window) ? fm_local[i + u][j - (i + u)] : fm[ij + u];
+        decomp = (sliding_window) ? fm_local[i + u][j - (i + u)] : fm[VRNA_MX_MFE_IDX(mx, i + u, j)];
         if (decomp != INF) {
           decomp += u * P->MLbase *
                     n_seq;
@@ -1249,7 +1265,7 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
 
     if ((i + 1 < j) &&
         (evaluate(i, j, i + 1, j, VRNA_DECOMP_ML_STEM, &hc_dat_local))) {
-      en = (sliding_window) ? c_local[i + 1][j - (i + 1)] : c[ij + 1];
+      en = (sliding_window) ? c_local[i + 1][j - (i + 1)] : c[VRNA_MX_MFE_IDX(mx, i + 1, j)];
       if (en != INF) {
         en += P->MLbase *
               n_seq;
@@ -1280,7 +1296,7 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
 
     if ((i + 1 < j) &&
         (evaluate(i, j, i, j - 1, VRNA_DECOMP_ML_STEM, &hc_dat_local))) {
-      en = (sliding_window) ? c_local[i][j - 1 - i] : c[indx[j - 1] + i];
+      en = (sliding_window) ? c_local[i][j - 1 - i] : c[VRNA_MX_MFE_IDX(mx, i, j - 1)];
       if (en != INF) {
         en += P->MLbase *
               n_seq;
@@ -1312,7 +1328,7 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
 
     if ((i + 2 < j) &&
         (evaluate(i, j, i + 1, j - 1, VRNA_DECOMP_ML_STEM, &hc_dat_local))) {
-      en = (sliding_window) ? c_local[i + 1][j - 1 - (i + 1)] : c[indx[j - 1] + i + 1];
+      en = (sliding_window) ? c_local[i + 1][j - 1 - (i + 1)] : c[VRNA_MX_MFE_IDX(mx, i + 1, j - 1)];
       if (en != INF) {
         en += 2 * P->MLbase *
               n_seq;
@@ -1349,21 +1365,17 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
     dmli  -= i;
   }
 
-  /* use fmi pointer that we may extend to include hard/soft constraints if necessary */
-  int *fmi_tmp = fmi;
+  /* use fmi pointer that we may extend to include soft constraints if necessary */
+  int           *fmi_tmp  = fmi;
+  unsigned char *hc_mask  = NULL;
 
   if (hc->f) {
-    fmi_tmp = (int *)vrna_alloc(sizeof(int) * (j - i + 2));
-    fmi_tmp -= i;
-
-    /* copy data */
-    for (k = i + 1; k <= j - 2; k++)
-      fmi_tmp[k] = fmi[k];
+    hc_mask = (unsigned char *)vrna_alloc(sizeof(unsigned char) * (j - i + 2));
+    hc_mask -= i;
 
     /* mask unavailable decompositions */
     for (k = i + 1; k <= j - 2; k++)
-      if (!hc->f(i, j, k, k + 1, VRNA_DECOMP_ML_ML_ML, hc->data))
-        fmi_tmp[k] = INF;
+      hc_mask[k] = (hc->f(i, j, k, k + 1, VRNA_DECOMP_ML_ML_ML, hc->data)) ? 1 : 0;
   }
 
   if (sc_wrapper.decomp_ml) {
@@ -1384,6 +1396,9 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
   /* modular decomposition -------------------------------*/
   if (sliding_window) {
     for (decomp = INF, k = i + 1; k <= j - 2; k++) {
+      if ((hc_mask) && (!hc_mask[k]))
+        continue;
+
       if ((fmi_tmp[k] != INF) && (fm_local[k + 1][j - (k + 1)] != INF)) {
         en      = fmi_tmp[k] + fm_local[k + 1][j - (k + 1)];
         decomp  = MIN2(decomp, en);
@@ -1395,8 +1410,6 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
     if (k >= j)
       k = j - 1;
 
-    k1j = indx[j] + k + 1;
-
     /*
      *  loop over entire range but skip decompositions with in-between strand nick,
      *  this should be faster than evaluating hard constraints callback for each
@@ -1412,12 +1425,11 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
 
       const int count = last_nt - k;
 
-      en      = vrna_fun_zip_add_min(fmi_tmp + k, fm + k1j, count);
+      en      = ml_split_min(mx, fmi_tmp, fm, hc_mask, k, j, count);
       decomp  = MIN2(decomp, en);
 
-      /* advance counters by processed subsegment and add 1 for the split point between strands */
-      k   += count + 1;
-      k1j += count + 1;
+      /* advance counter by processed subsegment and add 1 for the split point between strands */
+      k += count + 1;
 
       if (k > j - 2)
         break;
@@ -1431,6 +1443,11 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
     free(fmi_tmp);
   }
 
+  if (hc_mask) {
+    hc_mask += i;
+    free(hc_mask);
+  }
+
   dmli[j] = decomp;               /* store for use in fast ML decompositon */
 
   e = MIN2(e, decomp);
@@ -1481,8 +1498,8 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
         for (; k <= stop; k++, k1j++) {
           ik = indx[k] + i;
           if (evaluate(i, k, k + 1, j, VRNA_DECOMP_ML_COAXIAL_ENC, &hc_dat_local)) {
-            en = c[ik] +
-                 c[k1j];
+            en = c[VRNA_MX_MFE_IDX(mx, i, k)] +
+                 c[VRNA_MX_MFE_IDX(mx, k + 1, j)];
 
             switch (fc->type) {
               case VRNA_FC_TYPE_SINGLE:
@@ -1546,3 +1563,37 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
 
   return e;
 }
+
+
+/*
+ *  MIN(fmi[u] + fm[u + 1, j]) for all u = k, ..., k + count - 1 (with
+ *  mask[u] != 0, if a mask is given). The column entries fm[u + 1, j] are
+ *  consecutive in memory for default matrices, but only within each panel
+ *  of rows for tiled matrices, so we process the range panel-wise
+ */
+PRIVATE INLINE int
+ml_split_min(vrna_mx_mfe_t  *mx,
+             int            *fmi,
+             int            *fm,
+             unsigned char  *mask,
+             int            k,
+             int            j,
+             int            count)
+{
+  int decomp, en, run;
+
+  for (decomp = INF; count > 0; k += run, count -= run) {
+    run = count;
+
+    if (mx->type == VRNA_MX_TILED)
+      run = MIN2(run, VRNA_MX_TILE_SIZE - (k + 1) % VRNA_MX_TILE_SIZE);
+
+    en = (mask) ?
+         vrna_fun_zip_add_min_masked(fmi + k, fm + VRNA_MX_MFE_IDX(mx, k + 1, j), mask + k, run) :
+         vrna_fun_zip_add_min(fmi + k, fm + VRNA_MX_MFE_IDX(mx, k + 1, j), run);
+
+    decomp = MIN2(decomp, en);
+  }
+
+  return decomp;
+}
@@ -116,6 +116,21 @@ void
 vrna_exp_E_ml_fast_free(vrna_mx_pf_aux_ml_t aux_mx);
 
 
+/**
+ *  @brief  Let the helper arrays of the multibranch loop decomposition point to external memory
+ *
+ *  Replaces the arrays for the current (@p qqm) and previous (@p qqm1) column @f$ j @f$
+ *  by user-provided memory, e.g. the columns of a full @f$ qm^1 @f$ matrix. This allows
+ *  for filling the DP matrices in any order that respects the dependencies of the recursions,
+ *  such as the anti-diagonal parallel fill. Attached memory is never released by
+ *  vrna_exp_E_ml_fast_free() and the structure must not be rotated anymore.
+ */
+void
+vrna_exp_E_ml_fast_attach(vrna_mx_pf_aux_ml_t aux_mx,
+                          FLT_OR_DBL          *qqm,
+                          FLT_OR_DBL          *qqm1);
+
+
 const FLT_OR_DBL *
 vrna_exp_E_ml_fast_qqm(vrna_mx_pf_aux_ml_t aux_mx);
 
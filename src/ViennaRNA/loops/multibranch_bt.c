@@ -119,6 +119,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
                             with_ud, type, type_2, en2, **c_local, **fML_local, **ggg_local;
   vrna_param_t              *P;
   vrna_md_t                 *md;
+  vrna_mx_mfe_t             *mx;
   vrna_ud_t                 *domains_up;
   vrna_hc_eval_f evaluate;
   struct hc_mb_def_dat      hc_dat_local;
@@ -138,6 +139,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
   S3              = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S3;
   domains_up      = fc->domains_up;
 
+  mx        = fc->matrices;
   my_c      = (sliding_window) ? NULL : fc->matrices->c;
   my_fML    = (sliding_window) ? NULL : fc->matrices->fML;
   my_ggg    = (sliding_window) ? NULL : fc->matrices->ggg;
@@ -158,14 +160,14 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
   if (with_ud) {
     /* nibble off unpaired stretches at 3' site */
     do {
-      fij = (sliding_window) ? fML_local[ii][jj - ii] : my_fML[idx[jj] + ii];
+      fij = (sliding_window) ? fML_local[ii][jj - ii] : my_fML[VRNA_MX_MFE_IDX(mx, ii, jj)];
       fi  = INF;
 
       /* process regular unpaired nucleotides (unbound by ligand) first */
       if (evaluate(ii, jj, ii, jj - 1, VRNA_DECOMP_ML_ML, &hc_dat_local)) {
         fi = P->MLbase *
              n_seq;
-        fi += (sliding_window) ? fML_local[ii][jj - 1 - ii] : my_fML[idx[jj - 1] + ii];
+        fi += (sliding_window) ? fML_local[ii][jj - 1 - ii] : my_fML[VRNA_MX_MFE_IDX(mx, ii, jj - 1)];
 
         if (sc_wrapper.red_ml)
           fi += sc_wrapper.red_ml(ii, jj, ii, jj - 1, &sc_wrapper);
@@ -196,7 +198,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
           fi = en +
                u * P->MLbase *
                n_seq;
-          fi += (sliding_window) ? fML_local[ii][kk - 1 - ii] : my_fML[idx[kk - 1] + ii];
+          fi += (sliding_window) ? fML_local[ii][kk - 1 - ii] : my_fML[VRNA_MX_MFE_IDX(mx, ii, kk - 1)];
 
           if (fij == fi) {
             /* skip remaining motifs after first hit */
@@ -212,14 +214,14 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
 
     /* nibble off unpaired stretches at 5' site */
     do {
-      fij = (sliding_window) ? fML_local[ii][jj - ii] : my_fML[idx[jj] + ii];
+      fij = (sliding_window) ? fML_local[ii][jj - ii] : my_fML[VRNA_MX_MFE_IDX(mx, ii, jj)];
       fi  = INF;
 
       /* again, process regular unpaired nucleotides (unbound by ligand) first */
       if (evaluate(ii, jj, ii + 1, jj, VRNA_DECOMP_ML_ML, &hc_dat_local)) {
         fi = P->MLbase *
              n_seq;
-        fi += (sliding_window) ? fML_local[ii + 1][jj - (ii + 1)] : my_fML[idx[jj] + ii + 1];
+        fi += (sliding_window) ? fML_local[ii + 1][jj - (ii + 1)] : my_fML[VRNA_MX_MFE_IDX(mx, ii + 1, jj)];
 
         if (sc_wrapper.red_ml)
           fi += sc_wrapper.red_ml(ii, jj, ii + 1, jj, &sc_wrapper);
@@ -251,7 +253,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
                u * P->MLbase *
                n_seq;
 
-          fi += (sliding_window) ? fML_local[kk + 1][jj - (kk + 1)] : my_fML[idx[jj] + kk + 1];
+          fi += (sliding_window) ? fML_local[kk + 1][jj - (kk + 1)] : my_fML[VRNA_MX_MFE_IDX(mx, kk + 1, jj)];
 
           if (fij == fi) {
             /* skip remaining motifs after first hit */
@@ -267,13 +269,13 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
   } else {
     /* nibble off unpaired 3' bases */
     do {
-      fij = (sliding_window) ? fML_local[ii][jj - ii] : my_fML[idx[jj] + ii];
+      fij = (sliding_window) ? fML_local[ii][jj - ii] : my_fML[VRNA_MX_MFE_IDX(mx, ii, jj)];
       fi  = INF;
 
       if (evaluate(ii, jj, ii, jj - 1, VRNA_DECOMP_ML_ML, &hc_dat_local)) {
         fi = P->MLbase *
              n_seq;
-        fi += (sliding_window) ? fML_local[ii][jj - 1 - ii] : my_fML[idx[jj - 1] + ii];
+        fi += (sliding_window) ? fML_local[ii][jj - 1 - ii] : my_fML[VRNA_MX_MFE_IDX(mx, ii, jj - 1)];
 
         if (sc_wrapper.red_ml)
           fi += sc_wrapper.red_ml(ii, jj, ii, jj - 1, &sc_wrapper);
@@ -286,13 +288,13 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
 
     /* nibble off unpaired 5' bases */
     do {
-      fij = (sliding_window) ? fML_local[ii][jj - ii] : my_fML[idx[jj] + ii];
+      fij = (sliding_window) ? fML_local[ii][jj - ii] : my_fML[VRNA_MX_MFE_IDX(mx, ii, jj)];
       fi  = INF;
 
       if (evaluate(ii, jj, ii + 1, jj, VRNA_DECOMP_ML_ML, &hc_dat_local)) {
         fi = P->MLbase *
              n_seq;
-        fi += (sliding_window) ? fML_local[ii + 1][jj - (ii + 1)] : my_fML[idx[jj] + ii + 1];
+        fi += (sliding_window) ? fML_local[ii + 1][jj - (ii + 1)] : my_fML[VRNA_MX_MFE_IDX(mx, ii + 1, jj)];
 
         if (sc_wrapper.red_ml)
           fi += sc_wrapper.red_ml(ii, jj, ii + 1, jj, &sc_wrapper);
@@ -325,7 +327,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
     }
   }
 
-  en = (sliding_window) ? c_local[ii][jj - ii] : my_c[ij];
+  en = (sliding_window) ? c_local[ii][jj - ii] : my_c[VRNA_MX_MFE_IDX(mx, ii, jj)];
 
   if (sc_wrapper.red_stem)
     en += sc_wrapper.red_stem(ii, jj, ii, jj, &sc_wrapper);
@@ -422,7 +424,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
       if (evaluate(ii, jj, ii + 1, jj, VRNA_DECOMP_ML_STEM, &hc_dat_local)) {
         en2 = P->MLbase *
               n_seq;
-        en2 += (sliding_window) ? c_local[ii + 1][jj - (ii + 1)] : my_c[ij + 1];
+        en2 += (sliding_window) ? c_local[ii + 1][jj - (ii + 1)] : my_c[VRNA_MX_MFE_IDX(mx, ii + 1, jj)];
 
         switch (fc->type) {
           case VRNA_FC_TYPE_SINGLE:
@@ -456,7 +458,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
       if (evaluate(ii, jj, ii, jj - 1, VRNA_DECOMP_ML_STEM, &hc_dat_local)) {
         en2 = P->MLbase *
               n_seq;
-        en2 += (sliding_window) ? c_local[ii][jj - 1 - ii] : my_c[idx[jj - 1] + ii];
+        en2 += (sliding_window) ? c_local[ii][jj - 1 - ii] : my_c[VRNA_MX_MFE_IDX(mx, ii, jj - 1)];
 
         switch (fc->type) {
           case VRNA_FC_TYPE_SINGLE:
@@ -491,7 +493,7 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
       if (evaluate(ii, jj, ii + 1, jj - 1, VRNA_DECOMP_ML_STEM, &hc_dat_local)) {
         en2 = 2 * P->MLbase *
               n_seq;
-        en2 += (sliding_window) ? c_local[ii + 1][jj - 1 - (ii + 1)] : my_c[idx[jj - 1] + ii + 1];
+        en2 += (sliding_window) ? c_local[ii + 1][jj - 1 - (ii + 1)] : my_c[VRNA_MX_MFE_IDX(mx, ii + 1, jj - 1)];
 
         switch (fc->type) {
           case VRNA_FC_TYPE_SINGLE:
@@ -536,8 +538,8 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
         en = fML_local[ii][u - ii] +
              fML_local[u + 1][jj - (u + 1)];
       else
-        en = my_fML[idx[u] + ii] +
-             my_fML[idx[jj] + u + 1];
+        en = my_fML[VRNA_MX_MFE_IDX(mx, ii, u)] +
+             my_fML[VRNA_MX_MFE_IDX(mx, u + 1, jj)];
 
       if (sc_wrapper.decomp_ml)
         en += sc_wrapper.decomp_ml(ii, jj, u, u + 1, &sc_wrapper);
@@ -561,8 +563,9 @@ BT_mb_loop_split(vrna_fold_compound_t *fc,
       if (evaluate(ii, u, u + 1, jj, VRNA_DECOMP_ML_COAXIAL_ENC, &hc_dat_local)) {
         en = 2 * P->MLintern[1] *
              n_seq;
-        en += (sliding_window) ? c_local[ii][u - ii] + c_local[u + 1][jj - (u + 1)] : my_c[ik] +
-              my_c[k1j];
+        en += (sliding_window) ?
+              c_local[ii][u - ii] + c_local[u + 1][jj - (u + 1)] :
+              my_c[VRNA_MX_MFE_IDX(mx, ii, u)] + my_c[VRNA_MX_MFE_IDX(mx, u + 1, jj)];
 
         switch (fc->type) {
           case VRNA_FC_TYPE_SINGLE:
@@ -624,6 +627,7 @@ BT_mb_loop(vrna_fold_compound_t *fc,
                             *my_c, *my_fML, *rtype, type, type_2, **c_local, **fML_local;
   vrna_param_t              *P;
   vrna_md_t                 *md;
+  vrna_mx_mfe_t             *mx;
   vrna_hc_eval_f evaluate;
   struct hc_mb_def_dat      hc_dat_local;
   struct sc_mb_dat          sc_wrapper;
@@ -639,6 +643,7 @@ BT_mb_loop(vrna_fold_compound_t *fc,
   P               = fc->params;
   md              = &(P->model_details);
   sn              = fc->strand_number;
+  mx              = fc->matrices;
   my_c            = (sliding_window) ? NULL : fc->matrices->c;
   my_fML          = (sliding_window) ? NULL : fc->matrices->fML;
   c_local         = (sliding_window) ? fc->matrices->c_local : NULL;
@@ -717,8 +722,8 @@ BT_mb_loop(vrna_fold_compound_t *fc,
           tmp_en = fML_local[p][r - p] +
                    fML_local[r + 1][q - (r + 1)];
         else
-          tmp_en = my_fML[idx[r] + p] +
-                   my_fML[idx[q] + r + 1];
+          tmp_en = my_fML[VRNA_MX_MFE_IDX(mx, p, r)] +
+                   my_fML[VRNA_MX_MFE_IDX(mx, r + 1, q)];
 
         if (sc_wrapper.decomp_ml)
           tmp_en += sc_wrapper.decomp_ml(p, q, r, r + 1, &sc_wrapper);
@@ -756,8 +761,8 @@ BT_mb_loop(vrna_fold_compound_t *fc,
             tmp_en = fML_local[p + 1][r - (p + 1)] +
                      fML_local[r + 1][q - (r + 1)];
           else
-            tmp_en = my_fML[idx[r] + p + 1] +
-                     my_fML[idx[q] + r + 1];
+            tmp_en = my_fML[VRNA_MX_MFE_IDX(mx, p + 1, r)] +
+                     my_fML[VRNA_MX_MFE_IDX(mx, r + 1, q)];
 
           if (sc_wrapper.decomp_ml)
             tmp_en += sc_wrapper.decomp_ml(p + 1, q, r, r + 1, &sc_wrapper);
@@ -795,8 +800,8 @@ BT_mb_loop(vrna_fold_compound_t *fc,
             tmp_en = fML_local[p][r - p] +
                      fML_local[r + 1][q - 1 - (r + 1)];
           else
-            tmp_en = my_fML[idx[r] + p] +
-                     my_fML[idx[q - 1] + r + 1];
+            tmp_en = my_fML[VRNA_MX_MFE_IDX(mx, p, r)] +
+                     my_fML[VRNA_MX_MFE_IDX(mx, r + 1, q - 1)];
 
           if (sc_wrapper.decomp_ml)
             tmp_en += sc_wrapper.decomp_ml(p, q - 1, r, r + 1, &sc_wrapper);
@@ -836,8 +841,8 @@ BT_mb_loop(vrna_fold_compound_t *fc,
             tmp_en = fML_local[p + 1][r - (p + 1)] +
                      fML_local[r + 1][q - 1 - (r + 1)];
           else
-            tmp_en = my_fML[idx[r] + p + 1] +
-                     my_fML[idx[q - 1] + r + 1];
+            tmp_en = my_fML[VRNA_MX_MFE_IDX(mx, p + 1, r)] +
+                     my_fML[VRNA_MX_MFE_IDX(mx, r + 1, q - 1)];
 
           if (sc_wrapper.decomp_ml)
             tmp_en += sc_wrapper.decomp_ml(p + 1, q - 1, r, r + 1, &sc_wrapper);
@@ -872,8 +877,8 @@ BT_mb_loop(vrna_fold_compound_t *fc,
             tmp_en = c_local[p][r - p] +
                      fML_local[r + 1][q - (r + 1)];
           else
-            tmp_en = my_c[idx[r] + p] +
-                     my_fML[idx[q] + r + 1];
+            tmp_en = my_c[VRNA_MX_MFE_IDX(mx, p, r)] +
+                     my_fML[VRNA_MX_MFE_IDX(mx, r + 1, q)];
 
           switch (fc->type) {
             case VRNA_FC_TYPE_SINGLE:
@@ -907,8 +912,8 @@ BT_mb_loop(vrna_fold_compound_t *fc,
             tmp_en = c_local[r + 1][q - (r + 1)] +
                      fML_local[p][r - p];
           else
-            tmp_en = my_c[idx[q] + r + 1] +
-                     my_fML[idx[r] + p];
+            tmp_en = my_c[VRNA_MX_MFE_IDX(mx, r + 1, q)] +
+                     my_fML[VRNA_MX_MFE_IDX(mx, p, r)];
 
           switch (fc->type) {
             case VRNA_FC_TYPE_SINGLE:
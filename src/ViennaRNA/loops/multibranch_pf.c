@@ -9,6 +9,7 @@
 #include <ctype.h>
 #include <string.h>
 #include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/utils/higher_order_functions.h"
 #include "ViennaRNA/fold_vars.h"
 #include "ViennaRNA/alphabet.h"
 #include "ViennaRNA/params/default.h"
@@ -34,6 +35,8 @@ struct vrna_mx_pf_aux_ml_s {
 
   int         qqmu_size;
   FLT_OR_DBL  **qqmu;
+
+  unsigned char attached;  /* qqm and qqm1 point to external memory */
 };
 
 
@@ -192,8 +195,10 @@ vrna_exp_E_ml_fast_free(struct vrna_mx_pf_aux_ml_s *aux_mx)
   if (aux_mx) {
     int u;
 
-    free(aux_mx->qqm);
-    free(aux_mx->qqm1);
+    if (!aux_mx->attached) {
+      free(aux_mx->qqm);
+      free(aux_mx->qqm1);
+    }
 
     if (aux_mx->qqmu) {
       for (u = 0; u <= aux_mx->qqmu_size; u++)
@@ -207,6 +212,24 @@ vrna_exp_E_ml_fast_free(struct vrna_mx_pf_aux_ml_s *aux_mx)
 }
 
 
+PUBLIC void
+vrna_exp_E_ml_fast_attach(struct vrna_mx_pf_aux_ml_s  *aux_mx,
+                          FLT_OR_DBL                  *qqm,
+                          FLT_OR_DBL                  *qqm1)
+{
+  if (aux_mx) {
+    if (!aux_mx->attached) {
+      free(aux_mx->qqm);
+      free(aux_mx->qqm1);
+      aux_mx->attached = 1;
+    }
+
+    aux_mx->qqm   = qqm;
+    aux_mx->qqm1  = qqm1;
+  }
+}
+
+
 PUBLIC const FLT_OR_DBL *
 vrna_exp_E_ml_fast_qqm(struct vrna_mx_pf_aux_ml_s *aux_mx)
 {
@@ -336,9 +359,7 @@ exp_E_mb_loop_fast(vrna_fold_compound_t       *fc,
     k = i + 2;
 
     if (sliding_window) {
-      for (; k <= j - 1; k++, kl--)
-        temp += qm_local[i + 1][k - 1] *
-                qqm1_tmp[k];
+      temp += vrna_fun_zip_mult_sum(qm_local[i + 1] + k - 1, qqm1_tmp + k, j - k);
     } else {
       kl = my_iindx[i + 1] - (i + 1);
       /*
@@ -350,9 +371,11 @@ exp_E_mb_loop_fast(vrna_fold_compound_t       *fc,
         /* limit for-loop to last nucleotide of 5' part strand */
         int stop = MIN2(j - 1, se[sn[k - 1]]);
 
-        for (; k <= stop; k++, kl--)
-          temp += qm[kl] *
-                  qqm1_tmp[k];
+        if (k <= stop) {
+          temp  += vrna_fun_zip_mult_sum_rev(qm + kl, qqm1_tmp + k, stop - k + 1);
+          kl    -= stop - k + 1;
+          k     = stop + 1;
+        }
 
         k++;
         kl--;
@@ -555,18 +578,19 @@ exp_E_ml_fast(vrna_fold_compound_t        *fc,
   k     = j;
 
   if (sliding_window) {
-    for (; k > i; k--)
-      temp += qm_local[i][k - 1] *
-              qqm_tmp[k];
+    temp += vrna_fun_zip_mult_sum(qm_local[i] + i, qqm_tmp + i + 1, j - i);
   } else {
     kl = iidx[i] - j + 1; /* ii-k=[i,k-1] */
 
     while (1) {
       /* limit for-loop to first nucleotide of 3' part strand */
       int stop = MAX2(i, ss[sn[k]]);
-      for (; k > stop; k--, kl++)
-        temp += qm[kl] *
-                qqm_tmp[k];
+
+      if (k > stop) {
+        temp  += vrna_fun_zip_mult_sum_rev(qm + kl + (k - stop - 1), qqm_tmp + stop + 1, k - stop);
+        kl    += k - stop;
+        k     = stop;
+      }
 
       k--;
       kl++;
@@ -22,8 +22,13 @@
 #include <string.h>
 #include <limits.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "ViennaRNA/utils/basic.h"
 #include "ViennaRNA/utils/structures.h"
+#include "ViennaRNA/utils/cpu.h"
 #include "ViennaRNA/params/default.h"
 #include "ViennaRNA/datastructures/basic.h"
 #include "ViennaRNA/fold_vars.h"
@@ -92,6 +97,15 @@ postprocess_circular(vrna_fold_compound_t *fc,
                      int                  *bt);
 
 
+#ifdef _OPENMP
+PRIVATE void
+fill_arrays_wavefront(vrna_fold_compound_t  *fc,
+                      int                   num_threads);
+
+
+#endif
+
+
 PRIVATE INLINE void
 fill_fM_d5(vrna_fold_compound_t *fc,
            int                  *fM_d5);
@@ -256,11 +270,11 @@ vrna_mfe(vrna_fold_compound_t *fc,
 
     switch (fc->params->model_details.backtrack_type) {
       case 'C':
-        mfe = (float)fc->matrices->c[fc->jindx[length] + 1] / 100.;
+        mfe = (float)fc->matrices->c[VRNA_MX_MFE_IDX(fc->matrices, 1, length)] / 100.;
         break;
 
       case 'M':
-        mfe = (float)fc->matrices->fML[fc->jindx[length] + 1] / 100.;
+        mfe = (float)fc->matrices->fML[VRNA_MX_MFE_IDX(fc->matrices, 1, length)] / 100.;
         break;
 
       default:
@@ -351,7 +365,7 @@ fill_arrays(vrna_fold_compound_t  *fc,
             struct ms_helpers     *ms_dat)
 {
   unsigned int      *sn;
-  int               i, j, ij, length, uniq_ML, *indx, *f5, *c, *fML, *fM1;
+  int               i, j, ij, length, uniq_ML, *f5, *c, *fML, *fM1;
   vrna_param_t      *P;
   vrna_md_t         *md;
   vrna_mx_mfe_t     *matrices;
@@ -359,7 +373,6 @@ fill_arrays(vrna_fold_compound_t  *fc,
   struct aux_arrays *helper_arrays;
 
   length      = (int)fc->length;
-  indx        = fc->jindx;
   P           = fc->params;
   md          = &(P->model_details);
   uniq_ML     = md->uniq_ML;
@@ -380,9 +393,10 @@ fill_arrays(vrna_fold_compound_t  *fc,
 
   /* prefill matrices with init contributions */
   for (i = 1; i <= length; i++) {
-    c[indx[i] + i] = fML[indx[i] + i] = INF;
+    ij      = VRNA_MX_MFE_IDX(matrices, i, i);
+    c[ij]   = fML[ij] = INF;
     if (uniq_ML)
-      fM1[indx[i] + i] = INF;
+      fM1[ij] = INF;
   }
 
   /* start recursion */
@@ -394,13 +408,35 @@ fill_arrays(vrna_fold_compound_t  *fc,
     return 0;
   }
 
+#ifdef _OPENMP
+  int num_threads = vrna_cpu_threads(md->threads);
+
+  /*
+   *  parallel fill along the anti-diagonals, multi-strand cases and
+   *  auxiliary grammar extensions require the row-wise order below
+   */
+  if ((md->threads != 1) &&
+      (num_threads > 1) &&
+      (fc->strands == 1) &&
+      (!fc->aux_grammar)) {
+    free_aux_arrays(helper_arrays);
+
+    fill_arrays_wavefront(fc, num_threads);
+
+    (void)vrna_E_ext_loop_5(fc);
+
+    return f5[length];
+  }
+
+#endif
+
   for (i = length - 1; i >= 1; i--) {
     if ((fc->strands > 1) &&
         (sn[i] != sn[i + 1]))
       update_fms3_arrays(fc, sn[i + 1], ms_dat);
 
     for (j = i + 1; j <= length; j++) {
-      ij = indx[j] + i;
+      ij = VRNA_MX_MFE_IDX(matrices, i, j);
 
       /* decompose subsegment [i, j] with pair (i, j) */
       c[ij] = decompose_pair(fc, i, j, helper_arrays, ms_dat);
@@ -433,6 +469,111 @@ fill_arrays(vrna_fold_compound_t  *fc,
 }
 
 
+#ifdef _OPENMP
+/*
+ *  Fill the c, fML, and fM1 arrays in order of increasing span d = j - i,
+ *  such that all cells (i, j) of an anti-diagonal can be processed in
+ *  parallel. The row-based helper arrays of the serial fill are replaced
+ *  by thread-local copies that we populate from the last few anti-diagonals
+ *  before decomposing a cell, which renders the results identical to the
+ *  serial implementation. For the modular decomposition, we additionally
+ *  keep a row-wise copy of the fML matrix to avoid strided memory access.
+ */
+PRIVATE void
+fill_arrays_wavefront(vrna_fold_compound_t  *fc,
+                      int                   num_threads)
+{
+  int           k, length, uniq_ML, *c, *fML, *fM1, *dml[5], *cc[3], *fml_rows;
+  unsigned int  *row_start;
+  vrna_mx_mfe_t *matrices;
+
+  length    = (int)fc->length;
+  uniq_ML   = fc->params->model_details.uniq_ML;
+  matrices  = fc->matrices;
+  c         = fc->matrices->c;
+  fML       = fc->matrices->fML;
+  fM1       = fc->matrices->fM1;
+
+  /*
+   *  dml[d % 5][i] holds MIN(fML[i,k] + fML[k+1,i+d]) of the last five anti-diagonals,
+   *  cc[d % 3][i] the stacking-only energies of (i, i+d) for the --noLP option
+   */
+  for (k = 0; k < 5; k++) {
+    dml[k] = (int *)vrna_alloc(sizeof(int) * (length + 2));
+    if (k < 3)
+      cc[k] = (int *)vrna_alloc(sizeof(int) * (length + 2));
+  }
+
+  /* fml_rows[row_start[i] + k - i] holds fML[i,k] */
+  row_start     = (unsigned int *)vrna_alloc(sizeof(unsigned int) * (length + 2));
+  row_start[1]  = 1;
+  for (k = 1; k <= length; k++)
+    row_start[k + 1] = row_start[k] + length - k + 1;
+
+  fml_rows = (int *)vrna_alloc(sizeof(int) * (row_start[length + 1] + 1));
+
+#pragma omp parallel num_threads(num_threads)
+  {
+    int               d, i, j, ij, *dml_d, *dml_d2, *dml_d3, *dml_d4, *cc_d, *cc_d2;
+    struct aux_arrays *aux = get_aux_arrays(length);
+
+    for (d = 1; d < length; d++) {
+      dml_d   = dml[d % 5];
+      dml_d2  = dml[(d + 3) % 5];
+      dml_d3  = dml[(d + 2) % 5];
+      dml_d4  = dml[(d + 1) % 5];
+      cc_d    = cc[d % 3];
+      cc_d2   = cc[(d + 1) % 3];
+
+#pragma omp for schedule(static)
+      for (i = 1; i <= length - d; i++) {
+        j   = i + d;
+        ij  = VRNA_MX_MFE_IDX(matrices, i, j);
+
+        /*
+         *  provide the values the serial fill would find in its row-wise
+         *  helper arrays, i.e. INF for decompositions that have never been
+         *  computed and 0 for the not yet rotated stacking arrays
+         */
+        aux->DMLi1[j - 1] = (d > 2) ? dml_d2[i + 1] : INF;
+        aux->DMLi1[j - 2] = (d > 3) ? dml_d3[i + 1] : INF;
+        aux->DMLi2[j - 1] = (d > 3) ? dml_d3[i + 2] : INF;
+        aux->DMLi2[j - 2] = (d > 4) ? dml_d4[i + 2] : INF;
+        aux->cc1[j - 1]   = (d > 2) ? cc_d2[i + 1] : ((i + 1 >= length - 1) ? 0 : INF);
+        aux->cc[j]        = (i >= length - 1) ? 0 : INF;
+
+        /* decompose subsegment [i, j] with pair (i, j) */
+        c[ij] = decompose_pair(fc, i, j, aux, NULL);
+
+        /* decompose subsegment [i, j] that is multibranch loop part with at least one branch */
+        fML[ij] = vrna_E_ml_stems_fast(fc, i, j, fml_rows + row_start[i] - i, aux->DMLi);
+
+        /* decompose subsegment [i, j] that is multibranch loop part with exactly one branch */
+        if (uniq_ML)
+          fM1[ij] = E_ml_rightmost_stem(i, j, fc);
+
+        dml_d[i]  = aux->DMLi[j];
+        cc_d[i]   = aux->cc[j];
+      }
+    }
+
+    free_aux_arrays(aux);
+  }
+
+  for (k = 0; k < 5; k++) {
+    free(dml[k]);
+    if (k < 3)
+      free(cc[k]);
+  }
+
+  free(fml_rows);
+  free(row_start);
+}
+
+
+#endif
+
+
 /* post-processing step for circular RNAs */
 PRIVATE int
 postprocess_circular(vrna_fold_compound_t *fc,
@@ -3331,7 +3472,7 @@ repeat1:
     ij = indx[j] + i;
 
     if (canonical)
-      cij = my_c[ij];
+      cij = my_c[VRNA_MX_MFE_IDX(fc->matrices, i, j)];
 
     if (noLP) {
       if (vrna_BT_stack(fc, &i, &j, &cij, bp_stack, &b)) {
@@ -3343,7 +3484,7 @@ repeat1:
     canonical = 1;
 
     if (fc->type == VRNA_FC_TYPE_COMPARATIVE)
-      cij += pscore[indx[j] + i];
+      cij += pscore[ij];
 
     if (vrna_BT_hp_loop(fc, i, j, cij, bp_stack, &b))
       continue;
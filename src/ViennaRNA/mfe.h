@@ -154,6 +154,42 @@ vrna_circfold(const char  *sequence,
               char        *structure);
 
 
+/**
+ *  @brief  Compute Minimum Free Energies (MFE), and corresponding secondary structures for many RNA sequences
+ *
+ *  This interface computes the MFE and, if required, a secondary structure for each sequence of the
+ *  @p NULL terminated list @p sequences. It is meant for screening large numbers of short sequences,
+ *  where the setup of a #vrna_fold_compound_t for each sequence takes a considerable amount of time.
+ *  Instead, every thread re-targets a single #vrna_fold_compound_t to its next sequence with
+ *  vrna_fold_compound_retarget(). Sequences are processed in order of decreasing length, such that
+ *  the DP matrices of each thread only need to be allocated once.
+ *
+ *  The sequences are distributed over #vrna_md_t.threads threads (0 = OpenMP default), while
+ *  the prediction for each individual sequence is done serially. The results are identical to
+ *  those obtained with vrna_mfe() for each sequence separately.
+ *
+ *  If no @p structures are requested, sequences of equal length (up to 150 nt) are processed in
+ *  groups of 8 by a lane-batched kernel that evaluates each decomposition for all sequences of a
+ *  group at once, using AVX2 instructions if the CPU supports them. This applies to single strands
+ *  with dangles = 0 or 2, and without circular RNAs, G-quadruplexes, noLP, noGUclosure, a maximum
+ *  base pair span, or non-default salt concentrations. All other sequences are processed one at a
+ *  time as described above.
+ *
+ *  @see vrna_fold(), vrna_mfe(), vrna_pf_batch(), vrna_fold_compound_retarget()
+ *
+ *  @param sequences  A @p NULL terminated list of RNA sequences
+ *  @param md_p       An optional set of model details (may be @p NULL)
+ *  @param mfe        An array where the MFE of each sequence in kcal/mol will be stored
+ *  @param structures An optional array where the newly allocated MFE structures will be stored (may be @p NULL)
+ *  @return           The number of sequences that have been processed successfully
+ */
+unsigned int
+vrna_mfe_batch(const char       **sequences,
+               const vrna_md_t  *md_p,
+               float            *mfe,
+               char             **structures);
+
+
 /**
  *  @brief  Compute Minimum Free Energy (MFE), and a corresponding consensus secondary structure
  *          for an RNA sequence alignment using a comparative method
@@ -645,6 +645,9 @@ fill_arrays(vrna_fold_compound_t            *vc,
 
       /* update distance matrix */
       if (dm) {
+        vc->params  = vrna_params_unshare(vc->params);
+        md          = &(vc->params->model_details);
+
         for (i = 0; i < 7; i++) {
           for (j = 0; j < 7; j++)
             md->pair_dist[i][j] = dm[i][j];
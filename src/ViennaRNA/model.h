@@ -219,6 +219,13 @@ typedef struct vrna_md_s vrna_md_t;
  */
 #define VRNA_MODEL_DEFAULT_BACKBONE_LENGTH   VRNA_MODEL_BACKBONE_LENGTH_RNA
 
+/**
+ *  @brief  Default number of threads used to fill the DP matrices of a single prediction
+ *
+ *  @see  #vrna_md_t.threads, vrna_md_defaults_threads(), vrna_md_defaults_reset(), vrna_md_set_default()
+ */
+#define VRNA_MODEL_DEFAULT_THREADS   1
+
 
 #ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
 
@@ -308,6 +315,27 @@ struct vrna_md_s {
   float   saltDPXInitFact;                  /**<  @brief  */
   float   helical_rise;                     /**<  @brief  */
   float   backbone_length;                  /**<  @brief  */
+  int     threads;                          /**<  @brief  Number of threads used to fill the DP matrices of a single prediction
+                                             *
+                                             *    If set to 1 (default), the serial recursions are used. Any other value
+                                             *    activates the anti-diagonal (wavefront) parallel fill of the MFE and
+                                             *    partition function matrices, as well as the parallel outside recursions
+                                             *    for base pair probabilities, with the specified number of threads, where
+                                             *    0 means the default number of OpenMP threads. The sliding window
+                                             *    partition function splits long sequences into chunks that are processed
+                                             *    in parallel, see vrna_probs_window(), batches of refolding
+                                             *    paths are processed concurrently, see vrna_path_findpath_batch(),
+                                             *    the partition functions required for heat capacity curves are
+                                             *    computed for several temperatures at once, see vrna_heat_capacity(),
+                                             *    and strand permutations of multi-strand complexes are processed
+                                             *    concurrently, see vrna_pf_complexes().
+                                             *    Each matrix entry is still computed by a single thread in the
+                                             *    order of the serial recursions, i.e. results are deterministic and
+                                             *    identical to those of the serial implementation, regardless of the
+                                             *    number of threads. User-defined callbacks, e.g. for soft
+                                             *    constraints, must be thread-safe. Without OpenMP support, this
+                                             *    setting has no effect.
+                                             */
 };
 
 
@@ -1007,6 +1035,28 @@ float
 vrna_md_defaults_backbone_length_get(void);
 
 
+/**
+ *  @brief  Set the default number of threads used to fill the DP matrices of a single prediction
+ *
+ *  @see vrna_md_defaults_threads_get(), vrna_md_defaults_reset(), vrna_md_set_default(), #vrna_md_t, #VRNA_MODEL_DEFAULT_THREADS
+ *
+ *  @param  num_threads   The number of threads (0 = OpenMP default, 1 = serial fill)
+ */
+void
+vrna_md_defaults_threads(int num_threads);
+
+
+/**
+ *  @brief  Get the default number of threads used to fill the DP matrices of a single prediction
+ *
+ *  @see vrna_md_defaults_threads(), vrna_md_defaults_reset(), vrna_md_set_default(), #vrna_md_t, #VRNA_MODEL_DEFAULT_THREADS
+ *
+ *  @return The number of threads
+ */
+int
+vrna_md_defaults_threads_get(void);
+
+
 #ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
 
 #define model_detailsT        vrna_md_t               /* restore compatibility of struct rename */
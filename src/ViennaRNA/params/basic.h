@@ -169,7 +169,13 @@ struct vrna_exp_param_s {
  *  If a NULL pointer is passed for the model details parameter, the default
  *  model parameters are stored within the requested #vrna_param_t structure.
  *
- *  @see #vrna_md_t, vrna_md_set_default(), vrna_exp_params()
+ *  @note Scaled parameter sets are kept in a process-wide cache, such that
+ *        subsequent calls with identical model details only need to copy
+ *        the data. See vrna_params_cache_clear() if you modify the global
+ *        energy parameter tables directly.
+ *
+ *  @see #vrna_md_t, vrna_md_set_default(), vrna_exp_params(), vrna_params_cache_stats(),
+ *       vrna_params_shared()
  *
  *  @param  md  A pointer to the model details to store inside the structure (Maybe NULL)
  *  @return     A pointer to the memory location where the requested parameters are stored
@@ -237,6 +243,116 @@ vrna_exp_params_comparative(unsigned int  n_seq,
                             vrna_md_t     *md);
 
 
+/**
+ *  @brief  Get a shared, read-only set of prescaled free energy parameters
+ *
+ *  Same as vrna_params(), but instead of a private copy, the parameter set
+ *  stored in the process-wide parameter cache is returned directly whenever
+ *  the model details match a cached set exactly. If they only differ in the
+ *  number of threads, the window size, or the maximum base pair span, a
+ *  private copy is returned just like vrna_params() does. This is how fold
+ *  compounds obtain their energy parameters, i.e. many fold compounds with
+ *  the same model details use a single parameter set.
+ *
+ *  The returned parameter set must not be modified. Use vrna_params_unshare()
+ *  to obtain a private copy that can be modified, and vrna_params_free() to
+ *  release it.
+ *
+ *  @see vrna_params(), vrna_params_unshare(), vrna_params_free(), vrna_params_cache_stats()
+ *
+ *  @param  md  A pointer to the model details to store inside the structure (Maybe NULL)
+ *  @return     A pointer to the (possibly shared) parameter set
+ */
+vrna_param_t *
+vrna_params_shared(vrna_md_t *md);
+
+
+/**
+ *  @brief  Get a shared, read-only set of Boltzmann factors
+ *
+ *  @see vrna_params_shared(), vrna_exp_params(), vrna_exp_params_unshare(), vrna_exp_params_free()
+ *
+ *  @param  md  A pointer to the model details to store inside the structure (Maybe NULL)
+ *  @return     A pointer to the (possibly shared) parameter set
+ */
+vrna_exp_param_t *
+vrna_exp_params_shared(vrna_md_t *md);
+
+
+/**
+ *  @brief  Get a shared, read-only set of Boltzmann factors (alifold version)
+ *
+ *  @see vrna_params_shared(), vrna_exp_params_comparative(), vrna_exp_params_unshare(),
+ *       vrna_exp_params_free()
+ *
+ *  @param  n_seq   The number of sequences in the alignment
+ *  @param  md      A pointer to the model details to store inside the structure (Maybe NULL)
+ *  @return         A pointer to the (possibly shared) parameter set
+ */
+vrna_exp_param_t *
+vrna_exp_params_comparative_shared(unsigned int n_seq,
+                                   vrna_md_t    *md);
+
+
+/**
+ *  @brief  Make a free energy parameter set modifiable
+ *
+ *  If @p par is a shared parameter set, e.g. the one attached to a fold
+ *  compound, a private copy is returned and the reference to the shared set
+ *  is released. Otherwise, @p par itself is returned. Use it like
+ *
+ *  @code
+ *  fc->params = vrna_params_unshare(fc->params);
+ *  fc->params->model_details.dangles = 2;
+ *  @endcode
+ *
+ *  @see vrna_params_shared(), vrna_params_free()
+ *
+ *  @param  par   The free energy parameters (Maybe NULL)
+ *  @return       A parameter set owned by the caller
+ */
+vrna_param_t *
+vrna_params_unshare(vrna_param_t *par);
+
+
+/**
+ *  @brief  Make a set of Boltzmann factors modifiable
+ *
+ *  @see vrna_params_unshare(), vrna_exp_params_shared(), vrna_exp_params_free()
+ *
+ *  @param  par   The Boltzmann factors (Maybe NULL)
+ *  @return       A parameter set owned by the caller
+ */
+vrna_exp_param_t *
+vrna_exp_params_unshare(vrna_exp_param_t *par);
+
+
+/**
+ *  @brief  Release a free energy parameter set
+ *
+ *  Shared parameter sets are merely dereferenced, all others are freed.
+ *  Parameter sets attached to a fold compound must be released with this
+ *  function rather than free().
+ *
+ *  @see vrna_params_shared(), vrna_params_unshare()
+ *
+ *  @param  par   The free energy parameters (Maybe NULL)
+ */
+void
+vrna_params_free(vrna_param_t *par);
+
+
+/**
+ *  @brief  Release a set of Boltzmann factors
+ *
+ *  @see vrna_params_free(), vrna_exp_params_shared(), vrna_exp_params_unshare()
+ *
+ *  @param  par   The Boltzmann factors (Maybe NULL)
+ */
+void
+vrna_exp_params_free(vrna_exp_param_t *par);
+
+
 /**
  *  @brief Get a copy of the provided free energy parameters (provided as Boltzmann factors)
  *
@@ -377,6 +493,56 @@ vrna_params_prepare(vrna_fold_compound_t  *fc,
                     unsigned int          options);
 
 
+/**
+ *  @brief  Usage statistics of the energy parameter cache
+ *
+ *  @see  vrna_params_cache_stats()
+ */
+typedef struct {
+  unsigned long hits;         /**< @brief Number of parameter sets obtained from the cache */
+  unsigned long misses;       /**< @brief Number of parameter sets that had to be computed */
+  unsigned int  entries;      /**< @brief Number of parameter sets currently stored */
+  unsigned int  shared;       /**< @brief Number of stored parameter sets currently in use by fold compounds */
+  size_t        memory;       /**< @brief Memory occupied by the stored parameter sets in bytes */
+  size_t        bytes_saved;  /**< @brief Number of bytes that were shared instead of copied */
+} vrna_params_cache_stats_t;
+
+
+/**
+ *  @brief  Get usage statistics of the energy parameter cache
+ *
+ *  vrna_params(), vrna_exp_params(), and vrna_exp_params_comparative()
+ *  keep the most recently used parameter sets together with their
+ *  model details. Requesting parameters for the same model details
+ *  again, e.g. for each sequence in batch mode, merely copies the cached
+ *  data instead of re-scaling all energy contributions. Fold compounds
+ *  do not even copy the data but share the cached parameter sets, see
+ *  vrna_params_shared(). Cached sets are identified by the model details
+ *  that enter the energy contributions, i.e. the number of threads, the
+ *  window size, and the maximum base pair span are ignored.
+ *
+ *  @see  vrna_params_cache_clear(), vrna_params()
+ *
+ *  @param  stats   A pointer to the data structure that will be filled with the statistics
+ */
+void
+vrna_params_cache_stats(vrna_params_cache_stats_t *stats);
+
+
+/**
+ *  @brief  Remove all parameter sets from the energy parameter cache
+ *
+ *  The cache is cleared automatically whenever a new energy parameter set
+ *  is loaded. This function is only required if the global energy
+ *  parameter tables are modified otherwise. Parameter sets still in use
+ *  by fold compounds remain valid until they are released.
+ *
+ *  @see  vrna_params_cache_stats(), vrna_params()
+ */
+void
+vrna_params_cache_clear(void);
+
+
 #ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
 
 /**
@@ -20,6 +20,7 @@
 #include "ViennaRNA/io/utils.h"
 #include "ViennaRNA/params/constants.h"
 #include "ViennaRNA/params/default.h"
+#include "ViennaRNA/params/basic.h"
 #include "ViennaRNA/params/io.h"
 #include "ViennaRNA/static/energy_parameter_sets.h"
 
@@ -696,6 +697,10 @@ set_parameters_from_string(char       **file_content,
   }
 
   check_symmetry();
+
+  /* previously scaled parameter sets are invalid from now on */
+  vrna_params_cache_clear();
+
   return 1;
 }
 
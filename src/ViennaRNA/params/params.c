@@ -13,6 +13,11 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+
+#if VRNA_WITH_PTHREADS
+# include <pthread.h>
+#endif
+
 #include "ViennaRNA/params/default.h"
 #include "ViennaRNA/fold_vars.h"
 #include "ViennaRNA/utils/basic.h"
@@ -84,6 +89,45 @@
 
 #define saltT md->temperature+K0
 
+/* maximum number of parameter sets kept in the cache */
+#define PARAMS_CACHE_SIZE   16
+
+#define PARAMS_CACHE_ENERGY 1U
+#define PARAMS_CACHE_BF     2U
+#define PARAMS_CACHE_BF_ALI 3U
+
+/*
+ *  Model details that enter the parameter sets, i.e. the cache key. The
+ *  number of threads, the window size, and the maximum base pair span do
+ *  not change any energy contribution
+ */
+#define MD_KEY_SCALARS(F) \
+  F(temperature) F(betaScale) F(pf_smooth) F(dangles) F(special_hp) F(noLP) \
+  F(noGU) F(noGUclosure) F(logML) F(circ) F(gquad) F(uniq_ML) F(energy_set) \
+  F(backtrack) F(backtrack_type) F(compute_bpp) F(min_loop_size) F(oldAliEn) \
+  F(ribo) F(cv_fact) F(nc_fact) F(sfact) F(salt) F(saltMLLower) F(saltMLUpper) \
+  F(saltDPXInit) F(saltDPXInitFact) F(helical_rise) F(backbone_length)
+
+#define MD_KEY_ARRAYS(F) \
+  F(rtype) F(alias) F(pair) F(pair_dist)
+
+/*
+ #################################
+ # PRIVATE DATA STRUCTURES       #
+ #################################
+ */
+struct params_cache_entry {
+  unsigned int  type;
+  unsigned int  n_seq;
+  unsigned int  hash;
+  vrna_md_t     md;
+  void          *data;      /* immutable parameter set */
+  size_t        size;
+  unsigned int  refs;       /* number of owners sharing data */
+  int           stale;      /* not handed out anymore, freed with the last reference */
+  unsigned long last_use;
+};
+
 /*
  #################################
  # PRIVATE VARIABLES             #
@@ -99,6 +143,22 @@ PRIVATE int               pf_id = -1;
 #pragma omp threadprivate(id, pf_id)
 #endif
 
+/* process-wide cache of scaled parameter sets */
+PRIVATE struct params_cache_entry params_cache[PARAMS_CACHE_SIZE];
+PRIVATE unsigned long             params_cache_hits   = 0;
+PRIVATE unsigned long             params_cache_misses = 0;
+PRIVATE unsigned long             params_cache_clock  = 0;
+PRIVATE size_t                    params_cache_saved  = 0;
+
+#if VRNA_WITH_PTHREADS
+PRIVATE pthread_mutex_t           params_cache_mtx = PTHREAD_MUTEX_INITIALIZER;
+# define PARAMS_CACHE_LOCK        pthread_mutex_lock(&params_cache_mtx)
+# define PARAMS_CACHE_UNLOCK      pthread_mutex_unlock(&params_cache_mtx)
+#else
+# define PARAMS_CACHE_LOCK
+# define PARAMS_CACHE_UNLOCK
+#endif
+
 /*
  #################################
  # PRIVATE FUNCTION DECLARATIONS #
@@ -124,6 +184,59 @@ PRIVATE void
 rescale_params(vrna_fold_compound_t *vc);
 
 
+PRIVATE unsigned int
+md_hash(const vrna_md_t *md);
+
+
+PRIVATE unsigned int
+fnv1a(unsigned int  h,
+      const void    *data,
+      size_t        size);
+
+
+PRIVATE int
+md_equal(const vrna_md_t  *a,
+         const vrna_md_t  *b);
+
+
+PRIVATE double
+default_pf_scale(vrna_exp_param_t *pf,
+                 unsigned int     n_seq);
+
+
+PRIVATE vrna_param_t *
+get_params(vrna_md_t  *md,
+           int        share);
+
+
+PRIVATE vrna_exp_param_t *
+get_exp_params(unsigned int type,
+               unsigned int n_seq,
+               vrna_md_t    *md,
+               int          share);
+
+
+PRIVATE void *
+params_cache_get(unsigned int     type,
+                 unsigned int     n_seq,
+                 const vrna_md_t  *md,
+                 int              *shared);
+
+
+PRIVATE int
+params_cache_put(unsigned int     type,
+                 unsigned int     n_seq,
+                 const vrna_md_t  *md,
+                 void             *data,
+                 size_t           size,
+                 int              share);
+
+
+PRIVATE void *
+params_cache_release(void *data,
+                     int  keep);
+
+
 /*
  #################################
  # BEGIN OF FUNCTION DEFINITIONS #
@@ -132,26 +245,14 @@ rescale_params(vrna_fold_compound_t *vc);
 PUBLIC vrna_param_t *
 vrna_params(vrna_md_t *md)
 {
-  if (md) {
-    return get_scaled_params(md);
-  } else {
-    vrna_md_t md;
-    vrna_md_set_default(&md);
-    return get_scaled_params(&md);
-  }
+  return get_params(md, 0);
 }
 
 
 PUBLIC vrna_exp_param_t *
 vrna_exp_params(vrna_md_t *md)
 {
-  if (md) {
-    return get_scaled_exp_params(md, -1.);
-  } else {
-    vrna_md_t md;
-    vrna_md_set_default(&md);
-    return get_scaled_exp_params(&md, -1.);
-  }
+  return get_exp_params(PARAMS_CACHE_BF, 0, md, 0);
 }
 
 
@@ -159,13 +260,57 @@ PUBLIC vrna_exp_param_t *
 vrna_exp_params_comparative(unsigned int  n_seq,
                             vrna_md_t     *md)
 {
-  if (md) {
-    return get_exp_params_ali(md, n_seq, -1.);
-  } else {
-    vrna_md_t md;
-    vrna_md_set_default(&md);
-    return get_exp_params_ali(&md, n_seq, -1.);
-  }
+  return get_exp_params(PARAMS_CACHE_BF_ALI, n_seq, md, 0);
+}
+
+
+PUBLIC vrna_param_t *
+vrna_params_shared(vrna_md_t *md)
+{
+  return get_params(md, 1);
+}
+
+
+PUBLIC vrna_exp_param_t *
+vrna_exp_params_shared(vrna_md_t *md)
+{
+  return get_exp_params(PARAMS_CACHE_BF, 0, md, 1);
+}
+
+
+PUBLIC vrna_exp_param_t *
+vrna_exp_params_comparative_shared(unsigned int n_seq,
+                                   vrna_md_t    *md)
+{
+  return get_exp_params(PARAMS_CACHE_BF_ALI, n_seq, md, 1);
+}
+
+
+PUBLIC vrna_param_t *
+vrna_params_unshare(vrna_param_t *par)
+{
+  return (vrna_param_t *)params_cache_release(par, 1);
+}
+
+
+PUBLIC vrna_exp_param_t *
+vrna_exp_params_unshare(vrna_exp_param_t *par)
+{
+  return (vrna_exp_param_t *)params_cache_release(par, 1);
+}
+
+
+PUBLIC void
+vrna_params_free(vrna_param_t *par)
+{
+  free(params_cache_release(par, 0));
+}
+
+
+PUBLIC void
+vrna_exp_params_free(vrna_exp_param_t *par)
+{
+  free(params_cache_release(par, 0));
 }
 
 
@@ -203,7 +348,7 @@ vrna_params_subst(vrna_fold_compound_t  *vc,
 {
   if (vc) {
     if (vc->params)
-      free(vc->params);
+      vrna_params_free(vc->params);
 
     if (parameters) {
       vc->params = vrna_params_copy(parameters);
@@ -212,7 +357,7 @@ vrna_params_subst(vrna_fold_compound_t  *vc,
         case VRNA_FC_TYPE_SINGLE:     /* fall through */
 
         case VRNA_FC_TYPE_COMPARATIVE:
-          vc->params = vrna_params(NULL);
+          vc->params = vrna_params_shared(NULL);
           break;
 
         default:
@@ -233,14 +378,14 @@ vrna_params_reset(vrna_fold_compound_t  *vc,
 
       case VRNA_FC_TYPE_COMPARATIVE:
         if (vc->params)
-          free(vc->params);
+          vrna_params_free(vc->params);
 
-        vc->params = vrna_params(md_p);
+        vc->params = vrna_params_shared(md_p);
 
         if (vc->exp_params) {
-          free(vc->exp_params);
+          vrna_exp_params_free(vc->exp_params);
 
-          vc->exp_params = vrna_exp_params(md_p);
+          vc->exp_params = vrna_exp_params_shared(md_p);
         }
 
         break;
@@ -262,9 +407,9 @@ vrna_exp_params_reset(vrna_fold_compound_t  *vc,
 
       case VRNA_FC_TYPE_COMPARATIVE:
         if (vc->exp_params)
-          free(vc->exp_params);
+          vrna_exp_params_free(vc->exp_params);
 
-        vc->exp_params = vrna_exp_params(md_p);
+        vc->exp_params = vrna_exp_params_shared(md_p);
         break;
 
       default:
@@ -278,23 +423,26 @@ PUBLIC void
 vrna_exp_params_subst(vrna_fold_compound_t  *vc,
                       vrna_exp_param_t      *params)
 {
+  vrna_md_t md;
+
   if (vc) {
     if (vc->exp_params)
-      free(vc->exp_params);
+      vrna_exp_params_free(vc->exp_params);
 
     if (params) {
       vc->exp_params = vrna_exp_params_copy(params);
     } else {
       switch (vc->type) {
         case VRNA_FC_TYPE_SINGLE:
-          vc->exp_params = vrna_exp_params(NULL);
+          vrna_md_set_default(&md);
           if (vc->strands > 1)
-            vc->exp_params->model_details.min_loop_size = 0;
+            md.min_loop_size = 0;
 
+          vc->exp_params = vrna_exp_params_shared(&md);
           break;
 
         case VRNA_FC_TYPE_COMPARATIVE:
-          vc->exp_params = vrna_exp_params_comparative(vc->n_seq, NULL);
+          vc->exp_params = vrna_exp_params_comparative_shared(vc->n_seq, NULL);
           break;
 
         default:
@@ -313,48 +461,59 @@ vrna_exp_params_rescale(vrna_fold_compound_t  *vc,
                         double                *mfe)
 {
   vrna_exp_param_t  *pf;
-  double            e_per_nt, kT;
+  double            e_per_nt, kT, pf_scale;
   vrna_md_t         *md;
 
   if (vc) {
     if (!vc->exp_params) {
       switch (vc->type) {
         case VRNA_FC_TYPE_SINGLE:
-          vc->exp_params = vrna_exp_params(&(vc->params->model_details));
+          vc->exp_params = vrna_exp_params_shared(&(vc->params->model_details));
           break;
         case VRNA_FC_TYPE_COMPARATIVE:
-          vc->exp_params = vrna_exp_params_comparative(vc->n_seq, &(vc->params->model_details));
+          vc->exp_params = vrna_exp_params_comparative_shared(vc->n_seq,
+                                                              &(vc->params->model_details));
           break;
       }
     } else if (memcmp(&(vc->params->model_details),
                       &(vc->exp_params->model_details),
                       sizeof(vrna_md_t)) != 0) {
       /* make sure that model details are matching */
+      vc->exp_params = vrna_exp_params_unshare(vc->exp_params);
       (void)vrna_md_copy(&(vc->exp_params->model_details), &(vc->params->model_details));
       /* we probably need some mechanism to check whether DP matrices still match the new model settings! */
     }
 
     pf = vc->exp_params;
     if (pf) {
-      kT  = pf->kT;
-      md  = &(pf->model_details);
-
-      if (vc->type == VRNA_FC_TYPE_COMPARATIVE)
-        kT /= vc->n_seq;
+      pf_scale = pf->pf_scale;
 
       /* re-compute scaling factor if necessary */
-      if ((mfe) || (pf->pf_scale < 1.)) {
-        if (mfe)  /* use largest known Boltzmann factor for scaling */
-          e_per_nt = *mfe * 1000. / vc->length;
-        else      /* use mean energy for random sequences: 184.3*length cal for scaling */
-          e_per_nt = -185 + (pf->temperature - 37.) * 7.27;
+      if (mfe) {
+        kT  = pf->kT;
+        md  = &(pf->model_details);
+
+        if (vc->type == VRNA_FC_TYPE_COMPARATIVE)
+          kT /= vc->n_seq;
+
+        /* use largest known Boltzmann factor for scaling */
+        e_per_nt = *mfe * 1000. / vc->length;
 
         /* apply user-defined scaling factor to allow scaling for unusually stable/unstable structure enembles */
-        pf->pf_scale = exp(-(md->sfact * e_per_nt) / kT);
+        pf_scale = exp(-(md->sfact * e_per_nt) / kT);
+      } else if (pf_scale < 1.) {
+        pf_scale = default_pf_scale(pf,
+                                    (vc->type == VRNA_FC_TYPE_COMPARATIVE) ? vc->n_seq : 0);
       }
 
-      if (pf->pf_scale < 1.)
-        pf->pf_scale = 1.;
+      if (pf_scale < 1.)
+        pf_scale = 1.;
+
+      /* shared parameter sets are immutable */
+      if (pf_scale != pf->pf_scale) {
+        vc->exp_params  = pf = vrna_exp_params_unshare(pf);
+        pf->pf_scale    = pf_scale;
+      }
 
       rescale_params(vc);
     }
@@ -362,6 +521,57 @@ vrna_exp_params_rescale(vrna_fold_compound_t  *vc,
 }
 
 
+PUBLIC void
+vrna_params_cache_stats(vrna_params_cache_stats_t *stats)
+{
+  unsigned int i;
+
+  if (stats) {
+    memset(stats, 0, sizeof(vrna_params_cache_stats_t));
+
+    PARAMS_CACHE_LOCK;
+
+    stats->hits         = params_cache_hits;
+    stats->misses       = params_cache_misses;
+    stats->bytes_saved  = params_cache_saved;
+
+    for (i = 0; i < PARAMS_CACHE_SIZE; i++)
+      if (params_cache[i].data) {
+        if (!params_cache[i].stale)
+          stats->entries++;
+
+        if (params_cache[i].refs > 0)
+          stats->shared++;
+
+        stats->memory += params_cache[i].size;
+      }
+
+    PARAMS_CACHE_UNLOCK;
+  }
+}
+
+
+PUBLIC void
+vrna_params_cache_clear(void)
+{
+  unsigned int i;
+
+  PARAMS_CACHE_LOCK;
+
+  for (i = 0; i < PARAMS_CACHE_SIZE; i++) {
+    if (params_cache[i].refs > 0) {
+      /* still in use, release with the last reference */
+      params_cache[i].stale = 1;
+    } else {
+      free(params_cache[i].data);
+      params_cache[i].data = NULL;
+    }
+  }
+
+  PARAMS_CACHE_UNLOCK;
+}
+
+
 PUBLIC void
 vrna_params_prepare(vrna_fold_compound_t  *fc,
                     unsigned int          options)
@@ -380,15 +590,15 @@ vrna_params_prepare(vrna_fold_compound_t  *fc,
       /* remove previous parameters if present and they differ from reference model */
       if (fc->exp_params) {
         if (memcmp(md_p, &(fc->exp_params->model_details), sizeof(vrna_md_t)) != 0) {
-          free(fc->exp_params);
+          vrna_exp_params_free(fc->exp_params);
           fc->exp_params = NULL;
         }
       }
 
       if (!fc->exp_params)
         fc->exp_params = (fc->type == VRNA_FC_TYPE_SINGLE) ? \
-                         vrna_exp_params(md_p) : \
-                         vrna_exp_params_comparative(fc->n_seq, md_p);
+                         vrna_exp_params_shared(md_p) : \
+                         vrna_exp_params_comparative_shared(fc->n_seq, md_p);
     }
   }
 }
@@ -399,6 +609,337 @@ vrna_params_prepare(vrna_fold_compound_t  *fc,
  # BEGIN OF STATIC HELPER FUNCTIONS  #
  #####################################
  */
+
+/* FNV-1a hash of the model details that enter the parameter sets */
+PRIVATE unsigned int
+md_hash(const vrna_md_t *md)
+{
+  unsigned int h = 2166136261U;
+
+#define MD_HASH(field)  h = fnv1a(h, &(md->field), sizeof(md->field));
+  MD_KEY_SCALARS(MD_HASH)
+  MD_KEY_ARRAYS(MD_HASH)
+#undef MD_HASH
+
+  h = fnv1a(h, md->nonstandards, strnlen(md->nonstandards, sizeof(md->nonstandards)));
+
+  return h;
+}
+
+
+PRIVATE unsigned int
+fnv1a(unsigned int  h,
+      const void    *data,
+      size_t        size)
+{
+  size_t              i;
+  const unsigned char *c = (const unsigned char *)data;
+
+  for (i = 0; i < size; i++) {
+    h ^= c[i];
+    h *= 16777619U;
+  }
+
+  return h;
+}
+
+
+/*
+ *  Compare the model details that enter the parameter sets, i.e.
+ *  two parameter sets with equal model details only differ in their
+ *  copies of the model details
+ */
+PRIVATE int
+md_equal(const vrna_md_t  *a,
+         const vrna_md_t  *b)
+{
+#define MD_CMP_SCALAR(field)  if (a->field != b->field) return 0;
+#define MD_CMP_ARRAY(field)   if (memcmp(a->field, b->field, sizeof(a->field)) != 0) return 0;
+  MD_KEY_SCALARS(MD_CMP_SCALAR)
+  MD_KEY_ARRAYS(MD_CMP_ARRAY)
+#undef MD_CMP_SCALAR
+#undef MD_CMP_ARRAY
+
+  return (strncmp(a->nonstandards, b->nonstandards, sizeof(a->nonstandards)) == 0) ? 1 : 0;
+}
+
+
+/*
+ *  Scaling factor for the Boltzmann factors of sequences of unknown
+ *  stability, i.e. using the mean energy of random sequences
+ */
+PRIVATE double
+default_pf_scale(vrna_exp_param_t *pf,
+                 unsigned int     n_seq)
+{
+  double kT, e_per_nt, pf_scale;
+
+  kT = pf->kT;
+
+  if (n_seq > 0)
+    kT /= n_seq;
+
+  /* use mean energy for random sequences: 184.3*length cal for scaling */
+  e_per_nt = -185 + (pf->temperature - 37.) * 7.27;
+
+  /* apply user-defined scaling factor to allow scaling for unusually stable/unstable structure enembles */
+  pf_scale = exp(-(pf->model_details.sfact * e_per_nt) / kT);
+
+  return (pf_scale < 1.) ? 1. : pf_scale;
+}
+
+
+PRIVATE vrna_param_t *
+get_params(vrna_md_t  *md,
+           int        share)
+{
+  int           shared;
+  vrna_param_t  *P;
+  vrna_md_t     md_default;
+
+  if (!md) {
+    vrna_md_set_default(&md_default);
+    md = &md_default;
+  }
+
+  shared  = share;
+  P       = (vrna_param_t *)params_cache_get(PARAMS_CACHE_ENERGY, 0, md, &shared);
+
+  if (P) {
+    if (!shared) {
+      P->model_details  = *md;
+      P->id             = ++id;
+    }
+  } else {
+    P = get_scaled_params(md);
+    (void)params_cache_put(PARAMS_CACHE_ENERGY, 0, md, P, sizeof(vrna_param_t), share);
+  }
+
+  return P;
+}
+
+
+PRIVATE vrna_exp_param_t *
+get_exp_params(unsigned int type,
+               unsigned int n_seq,
+               vrna_md_t    *md,
+               int          share)
+{
+  int               shared;
+  vrna_exp_param_t  *P;
+  vrna_md_t         md_default;
+
+  if (!md) {
+    vrna_md_set_default(&md_default);
+    md = &md_default;
+  }
+
+  shared  = share;
+  P       = (vrna_exp_param_t *)params_cache_get(type, n_seq, md, &shared);
+
+  if (P) {
+    if (!shared)
+      P->model_details = *md;
+  } else {
+    P = (type == PARAMS_CACHE_BF_ALI) ? \
+        get_exp_params_ali(md, n_seq, -1.) : \
+        get_scaled_exp_params(md, -1.);
+
+    /*
+     *  apply the default scaling factor right away such that
+     *  shared parameter sets need no adjustment later on
+     */
+    P->pf_scale = default_pf_scale(P, n_seq);
+
+    (void)params_cache_put(type, n_seq, md, P, sizeof(vrna_exp_param_t), share);
+  }
+
+  return P;
+}
+
+
+/*
+ *  Retrieve a cached parameter set for the given model details, or
+ *  NULL if no such set is available. If *shared is non-zero on input,
+ *  the cached set itself is returned and referenced, provided that the
+ *  model details match exactly. Otherwise, a private copy is returned.
+ *  On output, *shared indicates which of the two was returned.
+ */
+PRIVATE void *
+params_cache_get(unsigned int     type,
+                 unsigned int     n_seq,
+                 const vrna_md_t  *md,
+                 int              *shared)
+{
+  unsigned int              i, h;
+  void                      *data;
+  struct params_cache_entry *e;
+
+  h     = md_hash(md);
+  data  = NULL;
+  e     = NULL;
+
+  PARAMS_CACHE_LOCK;
+
+  for (i = 0; i < PARAMS_CACHE_SIZE; i++) {
+    if ((params_cache[i].data) &&
+        (!params_cache[i].stale) &&
+        (params_cache[i].type == type) &&
+        (params_cache[i].hash == h) &&
+        (params_cache[i].n_seq == n_seq) &&
+        (md_equal(&(params_cache[i].md), md))) {
+      e = params_cache + i;
+      break;
+    }
+  }
+
+  if (e) {
+    e->last_use = ++params_cache_clock;
+
+    if ((*shared) &&
+        (e->md.threads == md->threads) &&
+        (e->md.window_size == md->window_size) &&
+        (e->md.max_bp_span == md->max_bp_span)) {
+      e->refs++;
+      data                = e->data;
+      params_cache_saved  += e->size;
+    } else {
+      data    = vrna_alloc(e->size);
+      memcpy(data, e->data, e->size);
+      *shared = 0;
+    }
+
+    params_cache_hits++;
+  } else {
+    *shared = 0;
+    params_cache_misses++;
+  }
+
+  PARAMS_CACHE_UNLOCK;
+
+  return data;
+}
+
+
+/*
+ *  Store a freshly computed parameter set, replacing the least recently
+ *  used entry that is not referenced anymore. If share is non-zero, the
+ *  cache takes over the parameter set itself and references it once.
+ *  Otherwise, a copy is stored. Returns non-zero if data has become
+ *  a shared parameter set
+ */
+PRIVATE int
+params_cache_put(unsigned int     type,
+                 unsigned int     n_seq,
+                 const vrna_md_t  *md,
+                 void             *data,
+                 size_t           size,
+                 int              share)
+{
+  unsigned int              i, h;
+  void                      *copy;
+  struct params_cache_entry *e;
+
+  h = md_hash(md);
+
+  if (share) {
+    copy = data;
+  } else {
+    copy = vrna_alloc(size);
+    memcpy(copy, data, size);
+  }
+
+  PARAMS_CACHE_LOCK;
+
+  for (e = NULL, i = 0; i < PARAMS_CACHE_SIZE; i++) {
+    if (params_cache[i].refs > 0)
+      continue;
+
+    if (!params_cache[i].data) {
+      e = params_cache + i;
+      break;
+    }
+
+    if ((!e) || (params_cache[i].last_use < e->last_use))
+      e = params_cache + i;
+  }
+
+  if (e) {
+    free(e->data);
+
+    e->type     = type;
+    e->n_seq    = n_seq;
+    e->hash     = h;
+    e->md       = *md;
+    e->data     = copy;
+    e->size     = size;
+    e->refs     = (share) ? 1 : 0;
+    e->stale    = 0;
+    e->last_use = ++params_cache_clock;
+  }
+
+  PARAMS_CACHE_UNLOCK;
+
+  if (!e) {
+    /* all entries are in use, so data simply stays private */
+    if (!share)
+      free(copy);
+
+    return 0;
+  }
+
+  return share;
+}
+
+
+/*
+ *  Drop one reference to a shared parameter set. If keep is non-zero,
+ *  a private copy of the parameter set is returned. Parameter sets that
+ *  are not shared are returned as they are, since they are owned by the
+ *  caller anyway
+ */
+PRIVATE void *
+params_cache_release(void *data,
+                     int  keep)
+{
+  unsigned int  i;
+  void          *copy;
+
+  if (!data)
+    return NULL;
+
+  PARAMS_CACHE_LOCK;
+
+  for (i = 0; i < PARAMS_CACHE_SIZE; i++)
+    if ((params_cache[i].data == data) &&
+        (params_cache[i].refs > 0))
+      break;
+
+  if (i == PARAMS_CACHE_SIZE) {
+    PARAMS_CACHE_UNLOCK;
+    return data;
+  }
+
+  copy = NULL;
+
+  if (keep) {
+    copy = vrna_alloc(params_cache[i].size);
+    memcpy(copy, data, params_cache[i].size);
+  }
+
+  if ((--params_cache[i].refs == 0) &&
+      (params_cache[i].stale)) {
+    free(params_cache[i].data);
+    params_cache[i].data  = NULL;
+    params_cache[i].stale = 0;
+  }
+
+  PARAMS_CACHE_UNLOCK;
+
+  return copy;
+}
+
+
 PRIVATE vrna_param_t *
 get_scaled_params(vrna_md_t *md)
 {
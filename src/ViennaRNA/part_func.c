@@ -17,6 +17,7 @@
 #include <limits.h>
 
 #include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/utils/cpu.h"
 #include "ViennaRNA/params/default.h"
 #include "ViennaRNA/fold_vars.h"
 #include "ViennaRNA/loops/all.h"
@@ -32,6 +33,8 @@
 #include <omp.h>
 #endif
 
+#define MAX_CALIBRATIONS  16  /* restarts of the fill to calibrate the scaling factor */
+
 /*
  #################################
  # GLOBAL VARIABLES              #
@@ -50,13 +53,40 @@
  #################################
  */
 PRIVATE int
-fill_arrays(vrna_fold_compound_t *fc);
+fill_arrays(vrna_fold_compound_t  *fc,
+            int                   *checkpoint);
+
+
+PRIVATE int
+fill_pf(vrna_fold_compound_t  *fc,
+        FLT_OR_DBL            *Q,
+        int                   *checkpoint);
+
+
+PRIVATE double
+calibration_rate(vrna_fold_compound_t *fc,
+                 int                  j);
+
+
+PRIVATE int
+rescale_by(vrna_fold_compound_t *fc,
+           double               rate);
 
 
 PRIVATE void
 postprocess_circular(vrna_fold_compound_t *fc);
 
 
+#ifdef _OPENMP
+PRIVATE int
+fill_arrays_wavefront(vrna_fold_compound_t  *fc,
+                      int                   num_threads,
+                      int                   *checkpoint);
+
+
+#endif
+
+
 PRIVATE FLT_OR_DBL
 decompose_pair(vrna_fold_compound_t *fc,
                int                  i,
@@ -82,8 +112,9 @@ PUBLIC FLT_OR_DBL
 vrna_pf(vrna_fold_compound_t  *fc,
         char                  *structure)
 {
-  int               n;
+  int               n, k, ret, cp, last_cp;
   FLT_OR_DBL        Q, dG;
+  double            pf_scale, min_real;
   vrna_md_t         *md;
   vrna_exp_param_t  *params;
   vrna_mx_pf_t      *matrices;
@@ -98,9 +129,7 @@ vrna_pf(vrna_fold_compound_t  *fc,
     }
 
     n         = fc->length;
-    params    = fc->exp_params;
-    matrices  = fc->exp_matrices;
-    md        = &(params->model_details);
+    min_real  = (sizeof(FLT_OR_DBL) == sizeof(float)) ? FLT_MIN : DBL_MIN;
 
 #ifdef _OPENMP
     /* Explicitly turn off dynamic threads */
@@ -113,6 +142,8 @@ vrna_pf(vrna_fold_compound_t  *fc,
     fpsetfastmode(1);
 #endif
 
+    pf_scale = fc->exp_params->pf_scale;
+
     /* call user-defined recursion status callback function */
     if (fc->stat_cb)
       fc->stat_cb(VRNA_STATUS_PF_PRE, fc->auxdata);
@@ -125,46 +156,72 @@ vrna_pf(vrna_fold_compound_t  *fc,
     if ((fc->aux_grammar) && (fc->aux_grammar->cb_proc))
       fc->aux_grammar->cb_proc(fc, VRNA_STATUS_PF_PRE, fc->aux_grammar->data);
 
-    if (!fill_arrays(fc)) {
-#ifdef SUN4
-      standard_arithmetic();
-#elif defined(HP9)
-      fpsetfastmode(0);
-#endif
-      return dG;
-    }
+    /*
+     *  calibrate the scaling factor on the fly. At prefix lengths j = 16,
+     *  24, 32, 48, ..., the fill extrapolates the partition function of
+     *  the 5' prefix [1:j] to the entire sequence. If the result leaves the
+     *  safe range of the floating point type, the fill stops and restarts
+     *  with a scaling factor that compensates for the observed growth.
+     *  Subsequent passes only check larger prefixes, so a restart costs a
+     *  fraction of a complete fill and the number of restarts is bounded
+     */
+    cp = 0;
+
+    for (k = 0; k <= MAX_CALIBRATIONS; k++) {
+      last_cp = cp;
+      ret     = fill_pf(fc, &Q, (k < MAX_CALIBRATIONS) ? &cp : NULL);
+
+      if (cp == last_cp)
+        break;
 
-    if (md->circ)
-      /* do post processing step for circular RNAs */
-      postprocess_circular(fc);
+      /* fill stopped at prefix length cp, complete it without checks if we can't adjust */
+      if (!rescale_by(fc, calibration_rate(fc, cp)))
+        k = MAX_CALIBRATIONS - 1;
+    }
 
-    /* call user-defined grammar post-condition callback function */
+    /* underflow of the entire partition function, calibrate with Q itself */
+    if ((ret) &&
+        (Q <= min_real) &&
+        (Q > 0.) &&
+        (rescale_by(fc, log(Q) / n)))
+      ret = fill_pf(fc, &Q, NULL);
+
+    /*
+     *  pre- and post-condition callbacks are paired once around all passes
+     *  of the fill above, even if the partition function could not be computed
+     */
     if ((fc->aux_grammar) && (fc->aux_grammar->cb_proc))
       fc->aux_grammar->cb_proc(fc, VRNA_STATUS_PF_POST, fc->aux_grammar->data);
 
     if (fc->strands > 1)
       vrna_gr_reset(fc);
 
-    /* call user-defined recursion status callback function */
     if (fc->stat_cb)
       fc->stat_cb(VRNA_STATUS_PF_POST, fc->auxdata);
 
-    switch (md->backtrack_type) {
-      case 'C':
-        Q = matrices->qb[fc->iindx[1] - n];
-        break;
-
-      case 'M':
-        Q = matrices->qm[fc->iindx[1] - n];
-        break;
+    /* the scaling factor of the fold compound remains changed, so let the caller know */
+    if (fc->exp_params->pf_scale != pf_scale)
+      vrna_message_warning("vrna_pf@part_func.c: "
+                           "scaling factor adjusted from pf_scale = %g to pf_scale = %g",
+                           pf_scale,
+                           fc->exp_params->pf_scale);
 
-      default:
-        Q = (md->circ) ? matrices->qo : matrices->q[fc->iindx[1] - n];
-        break;
+    if (!ret) {
+#ifdef SUN4
+      standard_arithmetic();
+#elif defined(HP9)
+      fpsetfastmode(0);
+#endif
+      return dG;
     }
 
+    /* parameters may have been re-scaled above */
+    params    = fc->exp_params;
+    matrices  = fc->exp_matrices;
+    md        = &(params->model_details);
+
     /* ensemble free energy in Kcal/mol              */
-    if (Q <= FLT_MIN)
+    if (Q <= min_real)
       vrna_message_warning("pf_scale too large");
 
     if (fc->strands > 1) {
@@ -297,8 +354,129 @@ vrna_pf_add(FLT_OR_DBL  dG1,
  # STATIC helper functions below #
  #################################
  */
+/*
+ *  Fill the DP matrices and retrieve the partition function of the entire
+ *  sequence. Status and grammar callbacks are not fired here, since the
+ *  fill may be repeated several times to calibrate the scaling factor
+ */
 PRIVATE int
-fill_arrays(vrna_fold_compound_t *fc)
+fill_pf(vrna_fold_compound_t  *fc,
+        FLT_OR_DBL            *Q,
+        int                   *checkpoint)
+{
+  unsigned int  n;
+  vrna_md_t     *md;
+  vrna_mx_pf_t  *matrices;
+
+  n         = fc->length;
+  md        = &(fc->exp_params->model_details);
+  matrices  = fc->exp_matrices;
+  *Q        = 0.;
+
+  if (!fill_arrays(fc, checkpoint))
+    return 0;
+
+  if (md->circ)
+    /* do post processing step for circular RNAs */
+    postprocess_circular(fc);
+
+  switch (md->backtrack_type) {
+    case 'C':
+      *Q = matrices->qb[fc->iindx[1] - n];
+      break;
+
+    case 'M':
+      *Q = matrices->qm[fc->iindx[1] - n];
+      break;
+
+    default:
+      *Q = (md->circ) ? matrices->qo : matrices->q[fc->iindx[1] - n];
+      break;
+  }
+
+  return 1;
+}
+
+
+/*
+ *  Per-nucleotide correction of the log-scaling factor suggested by prefix
+ *  [1:j]. Checkpoints are j = 16, 24, 32, 48, 64, 96, ..., where we
+ *  extrapolate the partition function of the entire sequence from the
+ *  growth between prefixes [1:j/2] and [1:j]. A correction is only
+ *  suggested if the result leaves the safe part of the floating point
+ *  range, which widens from one half towards the end of the sequence,
+ *  where extrapolation is more accurate. Returns 0 otherwise. The serial
+ *  and parallel fill both use the same checkpoints to arrive at the same
+ *  scaling factor regardless of the number of threads
+ */
+PRIVATE double
+calibration_rate(vrna_fold_compound_t *fc,
+                 int                  j)
+{
+  int         n, p;
+  FLT_OR_DBL  q1j, q1h;
+  double      lq, proj, max_log;
+
+  n = (int)fc->length;
+
+  if ((j < 16) ||
+      (j >= n))
+    return 0.;
+
+  for (p = 16; 2 * p <= j; p *= 2)
+    ;
+
+  if (j % (p / 2))
+    return 0.;
+
+  q1j = fc->exp_matrices->q[fc->iindx[1] - j];
+  q1h = fc->exp_matrices->q[fc->iindx[1] - j / 2];
+
+  if ((q1j <= 0.) ||
+      (q1h <= 0.))
+    return 0.;
+
+  max_log = (sizeof(FLT_OR_DBL) == sizeof(float)) ? log(FLT_MAX) : log(DBL_MAX);
+  lq      = log((double)q1j);
+  proj    = lq + (lq - log((double)q1h)) / (j - j / 2) * (n - j);
+
+  if (fabs(proj) > max_log * (0.5 + 0.4 * j / n))
+    return proj / n;
+
+  return 0.;
+}
+
+
+/*
+ *  Multiply the scaling factor by exp(rate), i.e. divide the scaled
+ *  partition function of a segment of length l by exp(rate * l). Returns
+ *  whether the scaling factor actually changed
+ */
+PRIVATE int
+rescale_by(vrna_fold_compound_t *fc,
+           double               rate)
+{
+  double pf_scale, scale;
+
+  pf_scale  = fc->exp_params->pf_scale;
+  scale     = MAX2(1., pf_scale * exp(rate));
+
+  if (scale == pf_scale)
+    return 0;
+
+  /* Boltzmann factors may be shared with other fold compounds */
+  fc->exp_params            = vrna_exp_params_unshare(fc->exp_params);
+  fc->exp_params->pf_scale  = scale;
+
+  vrna_exp_params_rescale(fc, NULL);
+
+  return 1;
+}
+
+
+PRIVATE int
+fill_arrays(vrna_fold_compound_t  *fc,
+            int                   *checkpoint)
 {
   int                 n, i, j, k, ij, *my_iindx, *jindx, with_gquad, with_ud;
   FLT_OR_DBL          temp, Qmax, *q, *qb, *qm, *qm1, *q1k, *qln;
@@ -368,6 +546,29 @@ fill_arrays(vrna_fold_compound_t *fc)
     qb[ij]  = 0.0;
   }
 
+#ifdef _OPENMP
+  int num_threads = vrna_cpu_threads(md->threads);
+
+  /*
+   *  parallel fill along the anti-diagonals, multi-strand cases, auxiliary
+   *  grammar extensions, and unstructured domains require the column-wise
+   *  order below
+   */
+  if ((md->threads != 1) &&
+      (num_threads > 1) &&
+      (fc->strands == 1) &&
+      (!fc->aux_grammar) &&
+      (!with_ud)) {
+    /* the parallel fill uses its own, thread-local auxiliary arrays */
+    vrna_exp_E_ml_fast_free(aux_mx_ml);
+    vrna_exp_E_ext_fast_free(aux_mx_el);
+    aux_mx_ml = NULL;
+    aux_mx_el = NULL;
+
+    if (!fill_arrays_wavefront(fc, num_threads, checkpoint))
+      return 0; /* failure */
+  } else
+#endif
   for (j = 2; j <= n; j++) {
     for (i = j - 1; i >= 1; i--) {
       ij = my_iindx[i] - j;
@@ -411,6 +612,18 @@ fill_arrays(vrna_fold_compound_t *fc)
       }
     }
 
+    /* stop early if the scaling factor requires calibration */
+    if ((checkpoint) &&
+        (j > *checkpoint) &&
+        (calibration_rate(fc, j) != 0.)) {
+      *checkpoint = j;
+
+      vrna_exp_E_ml_fast_free(aux_mx_ml);
+      vrna_exp_E_ext_fast_free(aux_mx_el);
+
+      return 0;
+    }
+
     /* rotate auxiliary arrays */
     vrna_exp_E_ext_fast_rotate(aux_mx_el);
     vrna_exp_E_ml_fast_rotate(aux_mx_ml);
@@ -434,6 +647,135 @@ fill_arrays(vrna_fold_compound_t *fc)
 }
 
 
+#ifdef _OPENMP
+/*
+ *  Fill the qb, qm, qm1, and q arrays in order of increasing span d = j - i,
+ *  such that all cells (i, j) of an anti-diagonal can be processed in parallel.
+ *  Instead of the rotating column helper arrays of the serial fill, each thread
+ *  attaches its exterior and multibranch loop helpers to the columns j and j - 1
+ *  of full-size matrices (the qm1 matrix itself, if available). Every cell is
+ *  still computed by a single thread with the summation order of the serial
+ *  implementation, so the results are identical and independent of the number
+ *  of threads.
+ */
+PRIVATE int
+fill_arrays_wavefront(vrna_fold_compound_t  *fc,
+                      int                   num_threads,
+                      int                   *checkpoint)
+{
+  unsigned char       failed;
+  int                 n, t, *my_iindx, *jindx;
+  FLT_OR_DBL          Qmax, *q, *qb, *qm, *qm1, *qq_mx, *qqm_mx;
+  double              max_real;
+  vrna_mx_pf_t        *matrices;
+  vrna_mx_pf_aux_el_t *aux_mx_el;
+  vrna_mx_pf_aux_ml_t *aux_mx_ml;
+
+  n         = (int)fc->length;
+  my_iindx  = fc->iindx;
+  jindx     = fc->jindx;
+  matrices  = fc->exp_matrices;
+  q         = matrices->q;
+  qb        = matrices->qb;
+  qm        = matrices->qm;
+  qm1       = matrices->qm1;
+  failed    = 0;
+  Qmax      = 0;
+  max_real  = (sizeof(FLT_OR_DBL) == sizeof(float)) ? FLT_MAX : DBL_MAX;
+
+  /*
+   *  column j of the helper matrices, i.e. qq_mx + jindx[j], replaces the
+   *  helper array for column j of the serial fill. Position jindx[j] + j
+   *  corresponds to the unused entry (0, j + 1) and remains 0, just like
+   *  the serial helper arrays
+   */
+  qq_mx   = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (((n + 1) * (n + 2)) / 2));
+  qqm_mx  = (qm1) ? qm1 : (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (((n + 1) * (n + 2)) / 2));
+
+  if (qm1)
+    for (t = 1; t <= n; t++)
+      qm1[jindx[t] + t] = 0.;
+
+  aux_mx_el = (vrna_mx_pf_aux_el_t *)vrna_alloc(sizeof(vrna_mx_pf_aux_el_t) * num_threads);
+  aux_mx_ml = (vrna_mx_pf_aux_ml_t *)vrna_alloc(sizeof(vrna_mx_pf_aux_ml_t) * num_threads);
+
+  for (t = 0; t < num_threads; t++) {
+    aux_mx_el[t]  = vrna_exp_E_ext_fast_init(fc);
+    aux_mx_ml[t]  = vrna_exp_E_ml_fast_init(fc);
+  }
+
+#pragma omp parallel num_threads(num_threads)
+  {
+    int                 d, i, j, ij;
+    vrna_mx_pf_aux_el_t aux_el  = aux_mx_el[omp_get_thread_num()];
+    vrna_mx_pf_aux_ml_t aux_ml  = aux_mx_ml[omp_get_thread_num()];
+
+    for (d = 1; (d < n) && (!failed); d++) {
+#pragma omp for schedule(static)
+      for (i = 1; i <= n - d; i++) {
+        j   = i + d;
+        ij  = my_iindx[i] - j;
+
+        vrna_exp_E_ext_fast_attach(aux_el, qq_mx + jindx[j], qq_mx + jindx[j - 1]);
+        vrna_exp_E_ml_fast_attach(aux_ml, qqm_mx + jindx[j], qqm_mx + jindx[j - 1]);
+
+        qb[ij]  = decompose_pair(fc, i, j, aux_ml);
+        qm[ij]  = vrna_exp_E_ml_fast(fc, i, j, aux_ml);
+        q[ij]   = vrna_exp_E_ext_fast(fc, i, j, aux_el);
+      }
+
+      /* overflow checks in the same order for any number of threads */
+#pragma omp single
+      {
+        for (i = 1; i <= n - d; i++) {
+          j   = i + d;
+          ij  = my_iindx[i] - j;
+
+          if (q[ij] > Qmax) {
+            Qmax = q[ij];
+            if (Qmax > max_real / 10.)
+              vrna_message_warning("Q close to overflow: %d %d %g", i, j, q[ij]);
+          }
+
+          if (q[ij] >= max_real) {
+            vrna_message_warning("overflow while computing partition function for segment q[%d,%d]\n"
+                                 "use larger pf_scale", i, j);
+            failed = 1;
+            break;
+          }
+        }
+
+        /* q[1, d + 1] is complete, stop early if the scaling factor requires calibration */
+        if ((checkpoint) &&
+            (!failed) &&
+            (d + 1 > *checkpoint) &&
+            (calibration_rate(fc, d + 1) != 0.)) {
+          *checkpoint = d + 1;
+          failed      = 1;
+        }
+      }
+    }
+  }
+
+  for (t = 0; t < num_threads; t++) {
+    vrna_exp_E_ext_fast_free(aux_mx_el[t]);
+    vrna_exp_E_ml_fast_free(aux_mx_ml[t]);
+  }
+
+  free(aux_mx_el);
+  free(aux_mx_ml);
+  free(qq_mx);
+
+  if (qqm_mx != qm1)
+    free(qqm_mx);
+
+  return !failed;
+}
+
+
+#endif
+
+
 PRIVATE FLT_OR_DBL
 decompose_pair(vrna_fold_compound_t *fc,
                int                  i,
@@ -102,6 +102,14 @@ struct vrna_multimer_pf_s {
  *        or numerical over-/underflow. In the latter case, a corresponding warning
  *        will be issued to @p stdout.
  *
+ *  @note If the partition function is about to over- or underflow, the scaling factor
+ *        #vrna_exp_param_t.pf_scale is adjusted from the growth of the partition function
+ *        observed during the computation, and the affected part is re-computed. The
+ *        adjusted scaling factor remains in the fold compound on return, and a warning
+ *        that reports both, the previous and the new scaling factor, is issued. No MFE
+ *        prediction is involved. If the partition function still over- or underflows,
+ *        a warning asks for a different scaling factor, see vrna_exp_params_rescale().
+ *
  *  @see  #vrna_fold_compound_t, vrna_fold_compound(), vrna_pf_fold(), vrna_pf_circfold(),
  *        vrna_fold_compound_comparative(), vrna_pf_alifold(), vrna_pf_circalifold(),
  *        vrna_db_from_probs(), vrna_exp_params(), vrna_aln_pinfo()
@@ -213,6 +221,29 @@ vrna_pf_circfold(const char *sequence,
                  vrna_ep_t  **pl);
 
 
+/**
+ *  @brief  Compute the ensemble free energies (and pairing propensities) for many RNA sequences
+ *
+ *  This is the partition function counterpart of vrna_mfe_batch(). For each sequence, the
+ *  scaling factor is estimated from its MFE, as done in vrna_pf_fold(), and base pair probabilities
+ *  are only computed if @p structures is not @p NULL and #vrna_md_t.compute_bpp is set. The results
+ *  are identical to those obtained for each sequence separately.
+ *
+ *  @see vrna_pf_fold(), vrna_pf(), vrna_mfe_batch(), vrna_fold_compound_retarget()
+ *
+ *  @param sequences  A @p NULL terminated list of RNA sequences
+ *  @param md_p       An optional set of model details (may be @p NULL)
+ *  @param energies   An array where the ensemble free energy of each sequence in kcal/mol will be stored
+ *  @param structures An optional array where the newly allocated pairing propensity strings will be stored (may be @p NULL)
+ *  @return           The number of sequences that have been processed successfully
+ */
+unsigned int
+vrna_pf_batch(const char      **sequences,
+              const vrna_md_t *md_p,
+              float           *energies,
+              char            **structures);
+
+
 /**
  *  @brief  Compute Partition function @f$Q@f$ (and base pair probabilities) for an RNA
  *          sequence alignment using a comparative method
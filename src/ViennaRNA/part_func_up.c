@@ -61,6 +61,10 @@
 #include <math.h>
 #include <float.h>    /* #defines FLT_MAX ... */
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #ifdef _WIN32
 #ifdef __MINGW32__
 #include <unistd.h>
@@ -77,6 +81,7 @@
 #include "ViennaRNA/fold_vars.h"
 #include "ViennaRNA/pair_mat.h"
 #include "ViennaRNA/params/basic.h"
+#include "ViennaRNA/alphabet.h"
 #include "ViennaRNA/part_func.h"
 #include "ViennaRNA/loops/all.h"
 #include "ViennaRNA/part_func_up.h"
@@ -95,24 +100,52 @@
  #################################
  */
 
+/*
+ #################################
+ # PRIVATE DATA STRUCTURES       #
+ #################################
+ */
+
+/*
+ *  Everything a single call of the unpaired probability computation works
+ *  on. The DP matrices of the partition function, the energy parameters and
+ *  the scaling arrays are only read, the remaining arrays are per-call
+ *  workspace.
+ */
+struct up_workspace {
+  short             *S1;
+  char              *ptype;     /* pair types, indexed by iindx[i] - j */
+  int               *iindx;
+  vrna_exp_param_t  *Pf;
+  FLT_OR_DBL        *qb;
+  FLT_OR_DBL        *qm;
+  FLT_OR_DBL        *probs;
+  FLT_OR_DBL        *q1k;
+  FLT_OR_DBL        *qln;
+  FLT_OR_DBL        *scale;
+  FLT_OR_DBL        *expMLbase;
+
+  FLT_OR_DBL        *prpr;
+  double            *qqm2;
+  double            *qq_1m2;
+  double            *qqm;
+  double            *qqm1;
+};
+
+
 /*
  #################################
  # PRIVATE VARIABLES             #
  #################################
  */
-PRIVATE short             *S = NULL, *S1 = NULL, *SS = NULL, *SS2 = NULL;
-PRIVATE vrna_exp_param_t  *Pf = NULL;                           /* use this structure for all the exp-arrays*/
-PRIVATE FLT_OR_DBL        *qb = NULL, *qm = NULL, *prpr = NULL; /* add arrays for pf_unpaired()*/
-PRIVATE FLT_OR_DBL        *probs = NULL;
-PRIVATE FLT_OR_DBL        *q1k = NULL, *qln = NULL;
-PRIVATE double            *qqm2 = NULL, *qq_1m2 = NULL, *qqm = NULL, *qqm1 = NULL;
-PRIVATE FLT_OR_DBL        *scale = NULL, *expMLbase = NULL;
-PRIVATE char              *ptype = NULL;  /* precomputed array of pair types */
-PRIVATE int               init_length;    /* length in last call to init_pf_fold()*/
-PRIVATE double            init_temp;      /* temperature in last call to scale_pf_params */
-PRIVATE int               *my_iindx = NULL;
-/* make iptypes array for intermolecular constrains (ipidx for indexing)*/
+PRIVATE vrna_exp_param_t  *Pf = NULL;  /* energy parameters of the backward compatibility functions */
+PRIVATE double            init_temp;  /* temperature in last call to scale_pf_params */
+
+#ifdef _OPENMP
+
+#pragma omp threadprivate(Pf, init_temp)
 
+#endif
 
 /*
  #################################
@@ -133,41 +166,56 @@ plot_free_pu_out(pu_out   *res,
 
 
 PRIVATE void
-scale_stru_pf_params(unsigned int length);
+scale_stru_pf_params(unsigned int length,
+                     FLT_OR_DBL   *scale,
+                     FLT_OR_DBL   *expMLbase);
 
 
 PRIVATE void
-init_pf_two(int length);
+init_pf_two(struct up_workspace *ws,
+            int                 length);
 
 
-PRIVATE void
+PRIVATE double
 scale_int(const char  *s,
           const char  *sl,
-          double      *sc_int);
+          double      kT);
 
 
-PRIVATE void
-encode_seq(const char *s1,
-           const char *s2);
+PRIVATE pu_contrib *
+unstru(const char           *sequence,
+       int                  w,
+       struct up_workspace  *ws);
 
 
-PRIVATE constrain *
-get_ptypes_up(char        *S,
-              const char  *structure);
+PRIVATE interact *
+interact_pf(const char        *s1,
+            const char        *s2,
+            pu_contrib        *p_c,
+            pu_contrib        *p_c2,
+            int               w,
+            const char        *cstruc,
+            int               incr3,
+            int               incr5,
+            vrna_exp_param_t  *Pf,
+            double            int_scale,
+            int               constrained);
 
 
-PRIVATE void
-get_up_arrays(unsigned int length);
+PRIVATE constrain *
+get_ptypes_up(const char  *Seq,
+              const char  *structure,
+              vrna_md_t   *md,
+              int         constrained);
 
 
 PRIVATE void
-free_up_arrays(void);
+get_up_arrays(struct up_workspace *ws,
+              unsigned int        length);
 
 
 PRIVATE void
-set_encoded_seq(const char  *sequence,
-                short       **S,
-                short       **S1);
+free_up_arrays(struct up_workspace *ws);
 
 
 PRIVATE void
@@ -249,13 +297,120 @@ PUBLIC pu_contrib *
 pf_unstru(char  *sequence,
           int   w)
 {
-  int           n, i, j, v, k, l, o, p, ij, kl, po, u, u1, d, type, type_2, tt;
-  unsigned int  size;
-  double        temp, tqm2;
-  double        qbt1, *tmp, sum_l, *sum_M;
-  double        *store_H, *store_Io, **store_I2o; /* hairp., interior contribs */
-  double        *store_M_qm_o, *store_M_mlbase;   /* multiloop contributions */
-  pu_contrib    *pu_test;
+  int                 n;
+  pu_contrib          *pu;
+  struct up_workspace ws;
+
+  n = (int)strlen(sequence);
+
+  get_up_arrays(&ws, (unsigned int)n);
+
+  ws.iindx      = vrna_idx_row_wise((unsigned int)n);
+  ws.scale      = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 2));
+  ws.expMLbase  = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 2));
+
+  init_pf_two(&ws, n);
+
+  pu = unstru(sequence, w, &ws);
+
+  free(ws.iindx);
+  free(ws.scale);
+  free(ws.expMLbase);
+  free_up_arrays(&ws);
+
+  return pu;
+}
+
+
+PUBLIC pu_contrib *
+vrna_pf_unstru(vrna_fold_compound_t *fc,
+               int                  w)
+{
+  int                 i, j, n, *jindx;
+  pu_contrib          *pu;
+  vrna_mx_pf_t        *matrices;
+  struct up_workspace ws;
+
+  if ((!fc) ||
+      (fc->type != VRNA_FC_TYPE_SINGLE) ||
+      (fc->strands > 1) ||
+      (!fc->exp_matrices) ||
+      (fc->exp_matrices->type != VRNA_MX_DEFAULT) ||
+      (!fc->exp_matrices->probs)) {
+    vrna_message_warning("vrna_pf_unstru: "
+                         "requires a single sequence fold compound with base pair probabilities");
+    return NULL;
+  }
+
+  n         = (int)fc->length;
+  jindx     = fc->jindx;
+  matrices  = fc->exp_matrices;
+
+  get_up_arrays(&ws, (unsigned int)n);
+
+  ws.S1         = fc->sequence_encoding;
+  ws.iindx      = fc->iindx;
+  ws.Pf         = fc->exp_params;
+  ws.qb         = matrices->qb;
+  ws.qm         = matrices->qm;
+  ws.probs      = matrices->probs;
+  ws.q1k        = matrices->q1k;
+  ws.qln        = matrices->qln;
+  ws.scale      = matrices->scale;
+  ws.expMLbase  = matrices->expMLbase;
+
+  /* the recursions below address pair types by iindx[i] - j */
+  ws.ptype = (char *)vrna_alloc(sizeof(char) * (((n + 1) * (n + 2)) >> 1));
+  for (i = 1; i < n; i++)
+    for (j = i + 1; j <= n; j++)
+      ws.ptype[ws.iindx[i] - j] = fc->ptype[jindx[j] + i];
+
+  pu = unstru(fc->sequence, w, &ws);
+
+  free(ws.ptype);
+  free_up_arrays(&ws);
+
+  return pu;
+}
+
+
+PRIVATE pu_contrib *
+unstru(const char           *sequence,
+       int                  w,
+       struct up_workspace  *ws)
+{
+  int               n, i, j, v, k, l, o, p, ij, kl, po, u, u1, d, type, type_2, tt;
+  unsigned int      size;
+  double            temp, tqm2;
+  double            qbt1, *tmp, sum_l, *sum_M;
+  double            *store_H, *store_Io, **store_I2o; /* hairp., interior contribs */
+  double            *store_M_qm_o, *store_M_mlbase;   /* multiloop contributions */
+  pu_contrib        *pu_test;
+  short             *S1;
+  char              *ptype;
+  int               *my_iindx, *rtype, no_closingGU;
+  FLT_OR_DBL        *qb, *qm, *prpr, *probs, *q1k, *qln, *scale, *expMLbase;
+  double            *qqm2, *qq_1m2, *qqm, *qqm1;
+  vrna_exp_param_t  *Pf;
+
+  S1            = ws->S1;
+  ptype         = ws->ptype;
+  my_iindx      = ws->iindx;
+  Pf            = ws->Pf;
+  rtype         = &(Pf->model_details.rtype[0]);
+  no_closingGU  = Pf->model_details.noGUclosure;
+  qb            = ws->qb;
+  qm            = ws->qm;
+  prpr          = ws->prpr;
+  probs         = ws->probs;
+  q1k           = ws->q1k;
+  qln           = ws->qln;
+  scale         = ws->scale;
+  expMLbase     = ws->expMLbase;
+  qqm2          = ws->qqm2;
+  qq_1m2        = ws->qq_1m2;
+  qqm           = ws->qqm;
+  qqm1          = ws->qqm1;
 
   sum_l   = 0.0;
   temp    = 0;
@@ -264,9 +419,6 @@ pf_unstru(char  *sequence,
   pu_test = get_pu_contrib_struct((unsigned)n, (unsigned)w);
   size    = ((n + 1) * (n + 2)) >> 1;
 
-  get_up_arrays((unsigned)n);
-  init_pf_two(n);
-
   /* init everything */
   for (d = 0; d <= TURN; d++)
     for (i = 1; i <= n - d; i++) {
@@ -548,7 +700,7 @@ pf_unstru(char  *sequence,
 
   free(sum_M);
   free(store_M_mlbase);
-  free_up_arrays();
+
   return pu_test;
 }
 
@@ -600,18 +752,102 @@ pf_interact(const char  *s1,
             int         incr3,
             int         incr5)
 {
-  int         i, j, k, l, n1, n2, add_i5, add_i3, pc_size;
-  double      temp, Z, rev_d, E, Z2, **p_c_S, **p_c2_S, int_scale;
-  FLT_OR_DBL  ****qint_4, **qint_ik;
+  unsigned int  n1;
+  double        int_scale, temppfs;
+  FLT_OR_DBL    *scale, *expMLbase;
+  interact      *Int;
+
+  n1 = (unsigned int)strlen(s1);
+
+  /* use a different scaling for pf_interact*/
+  int_scale = scale_int(s2, s1, Pf->kT / 1000.0);
+
+  /* set the global variable pf_scale to the value used to scale the
+   * interaction, keep its former value !! */
+  temppfs   = pf_scale;
+  pf_scale  = int_scale;
+
+  /* in order to scale expLoopEnergy correctly call*/
+  /* we also pass twice the seq-length to avoid bogus access to scale[] array */
+  scale     = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * ((n1 + 1) * 2));
+  expMLbase = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * ((n1 + 1) * 2));
+  scale_stru_pf_params(2 * n1, scale, expMLbase);
+
+  Int = interact_pf(s1, s2, p_c, p_c2, w, cstruc, incr3, incr5, Pf, int_scale, fold_constrained);
+
+  /* reset the global variable pf_scale to its original value */
+  pf_scale = temppfs;
+  scale_stru_pf_params(n1, scale, expMLbase);
+  free_pf_arrays(); /* for arrays for pf_fold(...) */
+
+  free(scale);
+  free(expMLbase);
+
+  return Int;
+}
+
+
+PUBLIC interact *
+vrna_pf_interact(vrna_fold_compound_t *fc,
+                 const char           *s2,
+                 pu_contrib           *p_c,
+                 pu_contrib           *p_c2,
+                 int                  w,
+                 const char           *cstruc,
+                 int                  incr3,
+                 int                  incr5)
+{
+  double int_scale;
+
+  if ((!fc) || (fc->type != VRNA_FC_TYPE_SINGLE) || (!fc->exp_params) || (!s2) || (!p_c)) {
+    vrna_message_warning("vrna_pf_interact: "
+                         "requires a single sequence fold compound with Boltzmann factors");
+    return NULL;
+  }
+
+  int_scale = scale_int(s2, fc->sequence, fc->exp_params->kT / 1000.0);
+
+  return interact_pf(fc->sequence,
+                     s2,
+                     p_c,
+                     p_c2,
+                     w,
+                     cstruc,
+                     incr3,
+                     incr5,
+                     fc->exp_params,
+                     int_scale,
+                     (cstruc) ? 1 : 0);
+}
+
+
+PRIVATE interact *
+interact_pf(const char        *s1,
+            const char        *s2,
+            pu_contrib        *p_c,
+            pu_contrib        *p_c2,
+            int               w,
+            const char        *cstruc,
+            int               incr3,
+            int               incr5,
+            vrna_exp_param_t  *Pf,
+            double            int_scale,
+            int               constrained)
+{
+  int         i, j, k, l, n1, n2, add_i5, add_i3, pc_size, *rtype;
+  double      temp, Z, rev_d, E, Z2, **p_c_S, **p_c2_S;
+  FLT_OR_DBL  ****qint_4, **qint_ik, *scale;
   /* PRIVATE double **pint; array for pf_up() output */
   interact    *Int;
   double      G_min, G_is, Gi_min;
   int         gi, gj, gk, gl, ci, cj, ck, cl, prev_k, prev_l;
   FLT_OR_DBL  **int_ik;
-  double      Z_int, temp_int, temppfs;
+  double      Z_int, temp_int;
   double      const_scale, const_T;
   constrain   *cc = NULL;                           /* constrains for cofolding */
   char        *Seq, *i_long, *i_short, *pos = NULL; /* short seq appended to long one */
+  short       *S1, *SS2;
+  vrna_md_t   *md;
 
   /* int ***pu_jl; */ /* positions of interaction in the short RNA */
 
@@ -630,10 +866,12 @@ pf_interact(const char  *s1,
   strcpy(Seq, s1);
   strcat(Seq, s2);
 
-  set_encoded_seq(s1, &S, &S1);
-  set_encoded_seq(s2, &SS, &SS2);
+  md    = &(Pf->model_details);
+  rtype = &(md->rtype[0]);
+  S1    = vrna_seq_encode(s1, md);
+  SS2   = vrna_seq_encode(s2, md);
 
-  cc = get_ptypes_up(Seq, cstruc);
+  cc = get_ptypes_up(Seq, cstruc, md, constrained);
 
   get_interact_arrays(n1, n2, p_c, p_c2, w, incr5, incr3, &p_c_S, &p_c2_S);
 
@@ -642,17 +880,13 @@ pf_interact(const char  *s1,
   Int->Pi = (double *)vrna_alloc(sizeof(double) * (n1 + 2));
   Int->Gi = (double *)vrna_alloc(sizeof(double) * (n1 + 2));
 
-  /* use a different scaling for pf_interact*/
-  scale_int(s2, s1, &int_scale);
-
-  /* set the global scale array and the global variable pf_scale to the
-   * values used to scale the interaction, keep their former values !! */
-  temppfs   = pf_scale;
-  pf_scale  = int_scale;
-
-  /* in order to scale expLoopEnergy correctly call*/
-  /* we also pass twice the seq-length to avoid bogus access to scale[] array */
-  scale_stru_pf_params((unsigned)2 * n1);
+  /* scale the interaction with int_scale, we also fill twice the seq-length
+   * to avoid bogus access to scale[] array */
+  scale     = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * ((n1 + 1) * 2));
+  scale[0]  = 1.;
+  scale[1]  = 1. / int_scale;
+  for (i = 2; i <= 2 * n1 + 1; i++)
+    scale[i] = scale[i / 2] * scale[i - (i / 2)];
 
   qint_ik = (FLT_OR_DBL **)vrna_alloc(sizeof(FLT_OR_DBL *) * (n1 + 1));
   for (i = 1; i <= n1; i++)
@@ -663,16 +897,14 @@ pf_interact(const char  *s1,
     int_ik[i] = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n1 + 1));
   Z_int = 0.;
   /*  Gint = ( -log(int_ik[gk][gi])-( ((int) w/2)*log(pf_scale)) )*((Pf->temperature+K0)*GASCONST/1000.0); */
-  const_scale = ((int)w / 2) * log(pf_scale);
+  const_scale = ((int)w / 2) * log(int_scale);
   const_T     = (Pf->kT / 1000.0);
-  encode_seq(s1, s2);
-  /* static  short *S~S1, *S1~SS1, *SS~S2, *SS2; */
   for (i = 0; i <= n1; i++)
     Int->Pi[i] = Int->Gi[i] = 0.;
   E = 0.;
   Z = 0.;
 
-  if (fold_constrained && cstruc != NULL) {
+  if (constrained && cstruc != NULL) {
     pos = strchr(cstruc, '|');
     if (pos) {
       ci = ck = cl = cj = 0;
@@ -713,11 +945,11 @@ pf_interact(const char  *s1,
         vrna_message_error("pf_interact: could not satisfy all constraints");
       }
     }
-  } else if (fold_constrained && cstruc == NULL) {
+  } else if (constrained && cstruc == NULL) {
     vrna_message_error("option -C selected, but no constrained structure given\n");
   }
 
-  if (fold_constrained)
+  if (constrained)
     pos = strchr(cstruc, '|');
 
   /*  qint_4[i][j][k][l] contribution that region (k-i) in seq1 (l=n1)
@@ -729,16 +961,16 @@ pf_interact(const char  *s1,
   for (i = 1; i <= n1; i++) {
     int end_k;
     end_k = i - w;
-    if (fold_constrained && pos && ci)
+    if (constrained && pos && ci)
       end_k = MAX2(i - w, ci - w);
 
     /* '|' constrains for long sequence: index i from 1 to n1 (5' to 3')*/
     /* interaction has to include 3' most '|' constrain, ci */
-    if (fold_constrained && pos && ci && i == 1 && i < ci)
+    if (constrained && pos && ci && i == 1 && i < ci)
       i = ci - w + 1 > 1 ? ci - w + 1 : 1;
 
     /* interaction has to include 5' most '|' constrain, ck*/
-    if (fold_constrained && pos && ck && i > ck + w - 1)
+    if (constrained && pos && ck && i > ck + w - 1)
       break;
 
     /* note: qint_4[i] will be freed before we allocate qint_4[i+1] */
@@ -753,16 +985,16 @@ pf_interact(const char  *s1,
     for (j = n2; j > 0; j--) {
       int type, type2, end_l;
       end_l = j + w;
-      if (fold_constrained && pos && ci)
+      if (constrained && pos && ci)
         end_l = MIN2(cj + w, j + w);
 
       /* '|' constrains for short sequence: index j from n2 to 1 (3' to 5')*/
       /* interaction has to include 5' most '|' constrain, cj */
-      if (fold_constrained && pos && cj && j == n2 && j > cj)
+      if (constrained && pos && cj && j == n2 && j > cj)
         j = cj + w - 1 > n2 ? n2 : cj + w - 1;
 
       /* interaction has to include 3' most '|' constrain, cl*/
-      if (fold_constrained && pos && cl && j < cl - w + 1)
+      if (constrained && pos && cl && j < cl - w + 1)
         break;
 
       type                = cc->ptype[cc->indx[i] - (n1 + j)];
@@ -813,7 +1045,7 @@ pf_interact(const char  *s1,
       temp    = 0.;
       prev_l  = n2;
       for (k = i - 1; k > end_k && k > 0; k--) {
-        if (fold_constrained && pos && cstruc[k - 1] == '|' && k > prev_k)
+        if (constrained && pos && cstruc[k - 1] == '|' && k > prev_k)
           prev_k = k;
 
         for (l = j + 1; l < end_l && l <= n2; l++) {
@@ -822,13 +1054,13 @@ pf_interact(const char  *s1,
 
           type2 = cc->ptype[cc->indx[k] - (n1 + l)];
           /* '|' : l HAS TO be paired: not pair (k,x) where x>l allowed */
-          if (fold_constrained && pos && cstruc[n1 + l - 1] == '|' && l < prev_l)
+          if (constrained && pos && cstruc[n1 + l - 1] == '|' && l < prev_l)
             prev_l = l; /*break*/
 
-          if (fold_constrained && pos && (k <= ck || i >= ci) && !type2)
+          if (constrained && pos && (k <= ck || i >= ci) && !type2)
             continue;
 
-          if (fold_constrained && pos && ((cstruc[k - 1] == '|') || (cstruc[n1 + l - 1] == '|')) &&
+          if (constrained && pos && ((cstruc[k - 1] == '|') || (cstruc[n1 + l - 1] == '|')) &&
               !type2)
             break;
 
@@ -884,20 +1116,20 @@ pf_interact(const char  *s1,
 
           /* '|' constrain in long sequence */
           /* collect interactions starting before 5' most '|' constrain */
-          if (fold_constrained && pos && ci && i < ci)
+          if (constrained && pos && ci && i < ci)
             continue;
 
           /* collect interactions ending after 3' most '|' constrain*/
-          if (fold_constrained && pos && ck && k > ck)
+          if (constrained && pos && ck && k > ck)
             continue;
 
           /* '|' constrain in short sequence */
           /* collect interactions starting before 5' most '|' constrain */
-          if (fold_constrained && pos && cj && j > cj)
+          if (constrained && pos && cj && j > cj)
             continue;
 
           /* collect interactions ending after 3' most '|' constrain*/
-          if (fold_constrained && pos && cl && l < cl)
+          if (constrained && pos && cl && l < cl)
             continue;
 
           /* scale everything to w/2*/
@@ -947,10 +1179,10 @@ pf_interact(const char  *s1,
     if (i > w) {
       int bla;
       bla = i - w;
-      if (fold_constrained && pos && ci && i - w < ci - w + 1)
+      if (constrained && pos && ci && i - w < ci - w + 1)
         continue;
 
-      if (fold_constrained && pos && ci)
+      if (constrained && pos && ci)
         bla = MAX2(ci - w + 1, i - w);
 
       for (j = n2; j > 0; j--) {
@@ -974,7 +1206,7 @@ pf_interact(const char  *s1,
         Int->Pi[l] += qint_ik[i][k] / Z;
         /* Int->Gi[l]: minimal delta G at position [l] */
         Int->Gi[l] = MIN2(Int->Gi[l],
-                          (-log(qint_ik[i][k]) - (((int)w / 2) * log(pf_scale))) *
+                          (-log(qint_ik[i][k]) - (((int)w / 2) * log(int_scale))) *
                           (Pf->kT / 1000.0));
       }
     }
@@ -983,7 +1215,7 @@ pf_interact(const char  *s1,
     int start_i, end_i;
     start_i = n1 - w + 1;
     end_i   = n1;
-    if (fold_constrained && pos && ci) {
+    if (constrained && pos && ci) {
       /* a break in the k loop might result in unfreed values */
       start_i = ci - w + 1 < n1 - w + 1 ? ci - w + 1 : n1 - w + 1;
       start_i = start_i > 0 ? start_i : 1;
@@ -1007,7 +1239,7 @@ pf_interact(const char  *s1,
     int start_i, end_i;
     start_i = 1;
     end_i   = n1;
-    if (fold_constrained && pos) {
+    if (constrained && pos) {
       start_i = ci - w + 1 > 0 ? ci - w + 1 : 1;
       end_i   = ck + w - 1 > n1 ? n1 : ck + w - 1;
     }
@@ -1023,7 +1255,7 @@ pf_interact(const char  *s1,
     free(qint_4);
   }
 
-  if (fold_constrained && (gi == 0 || gk == 0 || gl == 0 || gj == 0))
+  if (constrained && (gi == 0 || gk == 0 || gl == 0 || gj == 0))
     vrna_message_error("pf_interact: could not satisfy all constraints");
 
   /* fill structure interact */
@@ -1045,20 +1277,9 @@ pf_interact(const char  *s1,
     free(qint_ik[i]);
   free(qint_ik);
 
-  /* reset the global variables pf_scale and scale to their original values */
-  pf_scale = temppfs;                 /* reset pf_scale */
-  scale_stru_pf_params((unsigned)n1); /* reset the scale array */
-  free_pf_arrays();                   /* for arrays for pf_fold(...) */
-
-  if (expMLbase != NULL) {
-    free(expMLbase);
-    expMLbase = NULL;
-  }
-
-  if (scale != NULL) {
-    free(scale);
-    scale = NULL;
-  }
+  free(scale);
+  free(S1);
+  free(SS2);
 
   for (i = 1; i <= n1; i++)
     free(p_c_S[i]);
@@ -1079,35 +1300,28 @@ pf_interact(const char  *s1,
 
 /*------------------------------------------------------------------------*/
 /* use an extra scale for pf_interact, here sl is the longer sequence */
-PRIVATE void
+PRIVATE double
 scale_int(const char  *s,
           const char  *sl,
-          double      *sc_int)
+          double      kT)
 {
-  int     n, nl;
+  int     n;
+  double  sc_int;
   duplexT mfe;
-  double  kT;
-
-  n   = strlen(s);
-  nl  = strlen(sl);
-
-  free(expMLbase);
-  free(scale);
 
-  expMLbase = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * ((nl + 1) * 2));
-  scale     = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * ((nl + 1) * 2));
+  n = strlen(s);
 
   /* use RNA duplex to get a realistic estimate for the best possible
    * interaction energy between the short RNA s and its target sl */
   mfe = duplexfold(s, sl);
 
-  kT = Pf->kT / 1000.0; /* in Kcal */
-
   /* sc_int is similar to pf_scale: i.e. one time the scale */
-  *sc_int = exp(-(mfe.energy) / kT / n);
+  sc_int = exp(-(mfe.energy) / kT / n);
 
   /* free the structure returned by duplexfold */
   free(mfe.structure);
+
+  return sc_int;
 }
 
 
@@ -1116,8 +1330,11 @@ scale_int(const char  *s,
 /* get_pf_arrays(&S, &S1, &ptype, &qb, &qm, &q1k, &qln);*/
 /* init_pf_fold(), update_pf_params, encode_char(), make_ptypes() are called by pf_fold() */
 PRIVATE void
-init_pf_two(int length)
+init_pf_two(struct up_workspace *ws,
+            int                 length)
 {
+  short *S;
+
 #ifdef SUN4
   nonstandard_arithmetic();
 #else
@@ -1128,95 +1345,53 @@ init_pf_two(int length)
   make_pair_matrix();
 
   /* gets the arrays, that we need, from part_func.c */
-  if (!get_pf_arrays(&S, &S1, &ptype, &qb, &qm, &q1k, &qln))
+  if (!get_pf_arrays(&S, &(ws->S1), &(ws->ptype), &(ws->qb), &(ws->qm), &(ws->q1k), &(ws->qln)))
     vrna_message_error("init_pf_two: pf_fold() has to be called before calling pf_unstru()\n");
 
   /* get a pointer to the base pair probs */
-  probs = export_bppm();
+  ws->probs = export_bppm();
+
+  scale_stru_pf_params((unsigned)length, ws->scale, ws->expMLbase);
 
-  scale_stru_pf_params((unsigned)length);
+  ws->Pf = Pf;
 
-  init_length = length;
   if (init_temp != Pf->temperature)
     vrna_message_error("init_pf_two: inconsistency with temperature");
 }
 
 
 PRIVATE void
-get_up_arrays(unsigned int length)
+get_up_arrays(struct up_workspace *ws,
+              unsigned int        length)
 {
   unsigned int  l1  = length + 1;
   unsigned int  l2  = length + 2;
 
-  prpr      = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * ((l1 * l2) >> 1));
-  expMLbase = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * l2);
-  scale     = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * l2);
-  qqm2      = (double *)vrna_alloc(sizeof(double) * l2);
-  qq_1m2    = (double *)vrna_alloc(sizeof(double) * l2);
-  qqm       = (double *)vrna_alloc(sizeof(double) * l2);
-  qqm1      = (double *)vrna_alloc(sizeof(double) * l2);
-  my_iindx  = vrna_idx_row_wise(length);
+  ws->prpr    = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * ((l1 * l2) >> 1));
+  ws->qqm2    = (double *)vrna_alloc(sizeof(double) * l2);
+  ws->qq_1m2  = (double *)vrna_alloc(sizeof(double) * l2);
+  ws->qqm     = (double *)vrna_alloc(sizeof(double) * l2);
+  ws->qqm1    = (double *)vrna_alloc(sizeof(double) * l2);
 }
 
 
 PRIVATE void
-free_up_arrays(void)
+free_up_arrays(struct up_workspace *ws)
 {
-  if (prpr != NULL) {
-    free(prpr);
-    prpr = NULL;
-  }
-
-  if (expMLbase != NULL) {
-    free(expMLbase);
-    expMLbase = NULL;
-  }
-
-  if (scale != NULL) {
-    free(scale);
-    scale = NULL;
-  }
-
-  if (qqm != NULL) {
-    free(qqm);
-    qqm = NULL;
-  }
-
-  if (qqm1 != NULL) {
-    free(qqm1);
-    qqm1 = NULL;
-  }
-
-  if (qqm2 != NULL) {
-    free(qqm2);
-    qqm2 = NULL;
-  }
-
-  if (qq_1m2 != NULL) {
-    free(qq_1m2);
-    qq_1m2 = NULL;
-  }
-
-  if (my_iindx != NULL) {
-    free(my_iindx);
-    my_iindx = NULL;
-  }
+  free(ws->prpr);
+  free(ws->qqm);
+  free(ws->qqm1);
+  free(ws->qqm2);
+  free(ws->qq_1m2);
+
+  ws->prpr  = NULL;
+  ws->qqm   = ws->qqm1 = ws->qqm2 = ws->qq_1m2 = NULL;
 }
 
 
 PUBLIC void
 free_interact(interact *pin)
 {
-  if (S != NULL && pin != NULL) {
-    free(S);
-    S = NULL;
-  }
-
-  if (S1 != NULL && pin != NULL) {
-    free(S1);
-    S1 = NULL;
-  }
-
   if (pin != NULL) {
     free(pin->Pi);
     free(pin->Gi);
@@ -1226,44 +1401,14 @@ free_interact(interact *pin)
 }
 
 
-/*---------------------------------------------------------------------------*/
-
-PRIVATE void
-encode_seq(const char *s1,
-           const char *s2)
-{
-  unsigned int i, l;
-
-  l = strlen(s1);
-  /* S and S1 are freed by free_pf_arrays(); ! */
-  S   = (short *)vrna_alloc(sizeof(short) * (l + 1));
-  S1  = (short *)vrna_alloc(sizeof(short) * (l + 1));
-  /* S1 exists only for the special X K and I bases and energy_set!=0 */
-  S[0] = l;
-  for (i = 1; i <= l; i++) {
-    /* make numerical encoding of sequence */
-    S[i]  = (short)encode_char(toupper(s1[i - 1]));
-    S1[i] = alias[S[i]]; /* for mismatches of nostandard bases */
-  }
-  if (s2 != NULL) {
-    l = strlen(s2);
-    /* SS2 exists only for the special X K and I bases and energy_set!=0 */
-    SS[0] = l;
-    for (i = 1; i <= l; i++) {
-      /* make numerical encoding of sequence */
-      SS[i]   = (short)encode_char(toupper(s2[i - 1]));
-      SS2[i]  = alias[SS[i]]; /* for mismatches of nostandard bases */
-    }
-  }
-}
-
-
 /*-------------------------------------------------------------------------*/
 /* scale energy parameters and pre-calculate Boltzmann weights:
  * most of this is done in structure Pf see params.c,h (function:
  * get_scaled_pf_parameters(), only arrays scale and expMLbase are handled here*/
 PRIVATE void
-scale_stru_pf_params(unsigned int length)
+scale_stru_pf_params(unsigned int length,
+                     FLT_OR_DBL   *scale,
+                     FLT_OR_DBL   *expMLbase)
 {
   unsigned int  i;
   double        kT;
@@ -1495,7 +1640,7 @@ plot_free_pu_out(pu_out   *res,
   double  dG_u;
   char    nan[4], *time, dg[11];
   FILE    *wastl;
-  double  kT = Pf->kT;
+  double  kT = (temperature + K0) * GASCONST;
 
   wastl = fopen(ofile, "a");
   if (wastl == NULL) {
@@ -1629,22 +1774,23 @@ Up_plot(pu_contrib    *p_c,
 /*-------------------------------------------------------------------------*/
 /* copy from part_func_co.c */
 PRIVATE constrain *
-get_ptypes_up(char        *Seq,
-              const char  *structure)
+get_ptypes_up(const char  *Seq,
+              const char  *structure,
+              vrna_md_t   *md,
+              int         constrained)
 {
   int       n, i, j, k, l, length;
   constrain *con;
-  short     *s, *s1;
+  short     *s;
 
   length = strlen(Seq);
-  make_pair_matrix();
   con       = (constrain *)vrna_alloc(sizeof(constrain));
   con->indx = (int *)vrna_alloc(sizeof(int) * (length + 1));
   for (i = 1; i <= length; i++)
     con->indx[i] = ((length + 1 - i) * (length - i)) / 2 + length + 1;
   con->ptype = (char *)vrna_alloc(sizeof(char) * ((length + 1) * (length + 2) / 2));
 
-  set_encoded_seq((const char *)Seq, &s, &s1);
+  s = vrna_seq_encode_simple(Seq, md);
 
   n = s[0];
   for (k = 1; k <= n - CO_TURN - 1; k++)
@@ -1655,12 +1801,12 @@ get_ptypes_up(char        *Seq,
       if (j > n)
         continue;
 
-      type = pair[s[i]][s[j]];
+      type = md->pair[s[i]][s[j]];
       while ((i >= 1) && (j <= n)) {
         if ((i > 1) && (j < n))
-          ntype = pair[s[i - 1]][s[j + 1]];
+          ntype = md->pair[s[i - 1]][s[j + 1]];
 
-        if (noLonelyPairs && (!otype) && (!ntype))
+        if (md->noLP && (!otype) && (!ntype))
           type = 0; /* i.j can only form isolated pairs */
 
         con->ptype[con->indx[i] - j]  = (char)type;
@@ -1671,7 +1817,7 @@ get_ptypes_up(char        *Seq,
       }
     }
 
-  if (fold_constrained && (structure != NULL)) {
+  if (constrained && (structure != NULL)) {
     int   hx, *stack;
     char  type;
     stack = (int *)vrna_alloc(sizeof(int) * (n + 1));
@@ -1714,34 +1860,5 @@ get_ptypes_up(char        *Seq,
   }
 
   free(s);
-  free(s1);
   return con;
 }
-
-
-PRIVATE void
-set_encoded_seq(const char  *sequence,
-                short       **S,
-                short       **S1)
-{
-  unsigned int i, l;
-
-  l = strlen(sequence);
-  if (S != NULL) {
-    *S = (short *)vrna_alloc(sizeof(short) * (l + 2));
-    for (i = 1; i <= l; i++) /* make numerical encoding of sequence */
-      (*S)[i] = (short)encode_char(toupper(sequence[i - 1]));
-    (*S)[l + 1] = (*S)[1];
-    (*S)[0]     = (short)l;
-  }
-
-  /* S1 exists only for the special X K and I bases and energy_set!=0 */
-  if (S1 != NULL) {
-    *S1 = (short *)vrna_alloc(sizeof(short) * (l + 2));
-    for (i = 1; i <= l; i++)                                            /* make numerical encoding of sequence */
-      (*S1)[i] = alias[(short)encode_char(toupper(sequence[i - 1]))];   /* for mismatches of nostandard bases */
-    /* for circular folding add first base at position n+1 and last base at position 0 in S1 */
-    (*S1)[l + 1]  = (*S1)[1];
-    (*S1)[0]      = (*S1)[l];
-  }
-}
@@ -2,6 +2,7 @@
 #define VIENNA_RNA_PACKAGE_PART_FUNC_UP_H
 
 #include <ViennaRNA/datastructures/basic.h>
+#include <ViennaRNA/fold_compound.h>
 
 #ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
 
@@ -100,6 +101,57 @@ interact *pf_interact(const char *s1,
                       int incr3,
                       int incr5);
 
+/**
+ *  @brief Calculate the partition function over all unpaired regions of a maximal length
+ *
+ *  This is the reentrant counterpart of pf_unstru(). Instead of the global state left
+ *  behind by pf_fold(), it reads the partition function matrices, base pair probabilities
+ *  and Boltzmann factors of the fold compound @p fc, which therefore must have been
+ *  passed through vrna_pf() with base pair probability computation enabled. The fold
+ *  compound is not modified, and all auxiliary arrays are allocated for each call, so
+ *  several threads may run vrna_pf_unstru() on distinct fold compounds at the same time.
+ *
+ *  @see  pf_unstru(), vrna_pf_interact(), free_pu_contrib_struct()
+ *
+ *  @param  fc    A single sequence fold compound with filled partition function matrices
+ *  @param  max_w The maximal length of the unpaired regions
+ *  @return       The contributions to the probabilities of being unpaired (see #pu_contrib),
+ *                or @p NULL if @p fc does not meet the requirements
+ */
+pu_contrib *vrna_pf_unstru(vrna_fold_compound_t *fc,
+                           int                  max_w);
+
+/**
+ *  @brief Calculates the probability of a local interaction between two sequences
+ *
+ *  This is the reentrant counterpart of pf_interact(), where the longer sequence 's1'
+ *  and the Boltzmann factors are taken from the fold compound @p fc. Its energy parameters
+ *  are only read, and the interaction is scaled with a separate set of scaling factors
+ *  that is allocated for each call. Thus, a single fold compound may be shared among
+ *  concurrent calls, e.g. when many sequences are screened against the same RNA.
+ *  Intermolecular constraints are applied whenever @p cstruc is not @p NULL.
+ *
+ *  @see  pf_interact(), vrna_pf_unstru(), free_interact()
+ *
+ *  @param  fc      A single sequence fold compound for the longer sequence 's1'
+ *  @param  s2      The shorter sequence
+ *  @param  p_c     The probabilities of being unpaired for 's1' as obtained from vrna_pf_unstru()
+ *  @param  p_c2    The probabilities of being unpaired for 's2', or @p NULL
+ *  @param  max_w   The maximal length of the interaction
+ *  @param  cstruc  Constraint string for the concatenated sequences 's1' and 's2', or @p NULL
+ *  @param  incr3   The number of unpaired residues right of the interaction in 's1'
+ *  @param  incr5   The number of unpaired residues left of the interaction in 's1'
+ *  @return         The interaction (see #interact), or @p NULL if @p fc does not meet the requirements
+ */
+interact *vrna_pf_interact(vrna_fold_compound_t *fc,
+                           const char           *s2,
+                           pu_contrib           *p_c,
+                           pu_contrib           *p_c2,
+                           int                  max_w,
+                           const char           *cstruc,
+                           int                  incr3,
+                           int                  incr5);
+
 /**
  *  @brief Frees the output of function pf_interact().
  */
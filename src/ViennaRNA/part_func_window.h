@@ -209,6 +209,21 @@ DEPRECATED(typedef void (vrna_probs_window_callback)(FLT_OR_DBL    *pr,
  *  @note   The parameter @p ulength only affects computation and resulting data if unpaired
  *          probability computations are requested through the @p options flag.
  *
+ *  @note   If the model details of @p fc request more than one thread (#vrna_md_t.threads),
+ *          long sequences are split into chunks of sliding window iterations that are
+ *          processed in parallel, each re-computing an overlap of about four window sizes
+ *          to its 5' side. The data of each chunk is buffered and passed to @p cb in the
+ *          same order and with the same values as in the serial scan, and @p cb is never
+ *          called concurrently. Fold compounds with soft constraints, unstructured domains,
+ *          grammar extensions, or hard constraints other than the defaults are always
+ *          processed serially.
+ *
+ *  @note   If the partition function of a segment overflows, the scan is repeated with a
+ *          scaling factor derived from the MFE of that segment, see vrna_exp_params_rescale().
+ *          Iterations that have already been passed to @p cb are not reported again, so the
+ *          callback still receives the data of each iteration exactly once. The scaling
+ *          factor of @p fc remains changed on return.
+ *
  *  #### Options: ####
  *  * #VRNA_PROBS_WINDOW_BPP      - @copybrief #VRNA_PROBS_WINDOW_BPP
  *  * #VRNA_PROBS_WINDOW_UP       - @copybrief #VRNA_PROBS_WINDOW_UP
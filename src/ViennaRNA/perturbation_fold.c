@@ -113,6 +113,8 @@ evaluate_perturbation_vector_score(vrna_fold_compound_t *vc,
 
   addSoftConstraint(vc, epsilon, length);
 
+  vc->params                                = vrna_params_unshare(vc->params);
+  vc->exp_params                            = vrna_exp_params_unshare(vc->exp_params);
   vc->params->model_details.compute_bpp     = 1;
   vc->exp_params->model_details.compute_bpp = 1;
 
@@ -155,6 +157,8 @@ pairing_probabilities_from_restricted_pf(vrna_fold_compound_t *vc,
   int i;
 
   addSoftConstraint(vc, epsilon, length);
+  vc->params                                = vrna_params_unshare(vc->params);
+  vc->exp_params                            = vrna_exp_params_unshare(vc->exp_params);
   vc->params->model_details.compute_bpp     = 1;
   vc->exp_params->model_details.compute_bpp = 1;
 
@@ -218,6 +222,8 @@ pairing_probabilities_from_sampling(vrna_fold_compound_t  *vc,
   length = vc->length;
   addSoftConstraint(vc, epsilon, length);
 
+  vc->params                                = vrna_params_unshare(vc->params);
+  vc->exp_params                            = vrna_exp_params_unshare(vc->exp_params);
   vc->params->model_details.compute_bpp     = 0;
   vc->exp_params->model_details.compute_bpp = 0;
 
@@ -1,11 +1,32 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
 
 #include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/utils/cpu.h"
+#include "ViennaRNA/params/constants.h"
+#include "ViennaRNA/params/basic.h"
 #include "ViennaRNA/alphabet.h"
+#include "ViennaRNA/combinatorics.h"
+#include "ViennaRNA/grammar.h"
+#include "ViennaRNA/mfe.h"
+#include "ViennaRNA/part_func.h"
 #include "ViennaRNA/loops/external.h"
+#include "ViennaRNA/loops/hairpin.h"
+#include "ViennaRNA/loops/internal.h"
+#include "ViennaRNA/loops/multibranch.h"
 #include "ViennaRNA/pf_multifold.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #ifdef __GNUC__
 # define INLINE inline
 #else
@@ -14,6 +35,75 @@
 
 #include "ViennaRNA/loops/external_hc.inc"
 
+/*
+ #################################
+ # PRIVATE DATA STRUCTURES       #
+ #################################
+ */
+
+/*
+ *  Partition function matrices of a strand permutation, kept for all
+ *  permutations that extend it. Entries (i,j) are stored column-wise at
+ *  j * (j - 1) / 2 + i, such that the matrices of a prefix are independent
+ *  of its length. For single strands, the helper arrays of all columns are
+ *  kept as well, since their matrices also serve as the block of the last
+ *  strand in all permutations that end with it
+ */
+struct prefix_state {
+  unsigned int  length;
+  unsigned int  columns;  /* number of columns that do not depend on subsequent strands */
+  double        pf_scale;
+  FLT_OR_DBL    *q;
+  FLT_OR_DBL    *qb;
+  FLT_OR_DBL    *qm;
+  FLT_OR_DBL    *qq;      /* exterior loop helper array of the last reusable column */
+  FLT_OR_DBL    *qqm;     /* multibranch loop helper array of the last reusable column */
+  FLT_OR_DBL    *qq_mx;   /* exterior loop helper arrays of all columns (single strands only) */
+  FLT_OR_DBL    *qqm_mx;  /* multibranch loop helper arrays of all columns (single strands only) */
+};
+
+
+/* a strand permutation, i.e. a path from the (virtual) root of the trie */
+struct prefix_node {
+  unsigned int        strand;
+  unsigned int        depth;
+  unsigned int        length;
+  int                 parent;
+  int                 child;
+  int                 sibling;
+  double              cost;     /* estimated work for the node and all its descendants */
+  double              dG;       /* ensemble free energy of the permutation */
+  struct prefix_state *state;
+};
+
+
+struct prefix_trie {
+  struct prefix_node  *nodes;
+  int                 num;
+  int                 size;
+  const char          **strands;
+  unsigned int        *lengths;
+  int                 *monomers;      /* node of each single strand, or -1 */
+  int                 *node_jobs;     /* first permutation of each node, or -1 */
+  int                 *job_next;      /* next permutation of the same node, or -1 */
+  int                 *job_nodes;     /* node of each permutation */
+  size_t              *job_complex;   /* complex of each permutation */
+  size_t              *first_job;     /* first permutation of each complex */
+  unsigned int        *remaining;     /* number of permutations of each complex not done yet */
+  unsigned int        *sizes;         /* size of each complex */
+  size_t              *indices;       /* index of each complex among those of the same size */
+  int                 keep_monomers;  /* whether single strands serve as last strand of others */
+  double              kT;
+  vrna_pf_complexes_f cb;
+  void                *data;
+};
+
+
+/*
+ #################################
+ # PRIVATE FUNCTION DECLARATIONS #
+ #################################
+ */
 PRIVATE FLT_OR_DBL
 mf_rule_pair(vrna_fold_compound_t *fc,
              int                  i,
@@ -21,6 +111,59 @@ mf_rule_pair(vrna_fold_compound_t *fc,
              void                 *data);
 
 
+PRIVATE int
+trie_insert(struct prefix_trie  *trie,
+            const unsigned int  *strands,
+            unsigned int        num_strands);
+
+
+PRIVATE void
+process_subtree(struct prefix_trie  *trie,
+                int                 node,
+                vrna_md_t           *md);
+
+
+PRIVATE void
+process_node(struct prefix_trie *trie,
+             int                node,
+             vrna_md_t          *md);
+
+
+PRIVATE void
+report_node(struct prefix_trie *trie,
+            int                node);
+
+
+PRIVATE void
+store_dG(unsigned int size,
+         size_t       complex,
+         double       dG,
+         void         *data);
+
+
+PRIVATE int
+fill_columns(vrna_fold_compound_t *fc,
+             struct prefix_state  *prefix,
+             struct prefix_state  *suffix,
+             struct prefix_state  **state,
+             int                  all_columns);
+
+
+PRIVATE INLINE FLT_OR_DBL
+exp_pair(vrna_fold_compound_t *fc,
+         int                  i,
+         int                  j,
+         vrna_mx_pf_aux_ml_t  aux_mx_ml);
+
+
+PRIVATE FLT_OR_DBL
+ensemble_energy(vrna_fold_compound_t *fc);
+
+
+PRIVATE void
+prefix_state_free(struct prefix_state *state);
+
+
 /*
  #################################
  # BEGIN OF FUNCTION DEFINITIONS #
@@ -36,6 +179,327 @@ vrna_pf_multifold_prepare(vrna_fold_compound_t *fc)
 }
 
 
+PUBLIC double **
+vrna_pf_complexes(vrna_fold_compound_t  *fc,
+                  unsigned int          ***complexes,
+                  size_t                max_size)
+{
+  unsigned int  s;
+  const char    **strands;
+  double        **dG;
+  vrna_md_t     md;
+
+  if ((!fc) ||
+      (fc->type != VRNA_FC_TYPE_SINGLE))
+    return NULL;
+
+  md = fc->params->model_details;
+
+  /* base pair spans of fc are limited to its length unless restricted further */
+  if (md.max_bp_span >= md.window_size)
+    md.max_bp_span = -1;
+
+  md.window_size = -1;
+
+  strands = (const char **)vrna_alloc(sizeof(char *) * fc->strands);
+
+  for (s = 0; s < fc->strands; s++)
+    strands[s] = fc->nucleotides[s].string;
+
+  dG = vrna_pf_complexes_strands(strands, fc->strands, &md, complexes, max_size);
+
+  free(strands);
+
+  return dG;
+}
+
+
+PUBLIC double **
+vrna_pf_complexes_strands(const char    **strands,
+                          unsigned int  num_strands,
+                          vrna_md_t     *md,
+                          unsigned int  ***complexes,
+                          size_t        max_size)
+{
+  unsigned int  k;
+  size_t        c;
+  double        **dG;
+
+  if ((!strands) ||
+      (num_strands == 0) ||
+      (!complexes) ||
+      (max_size == 0))
+    return NULL;
+
+  dG = (double **)vrna_alloc(sizeof(double *) * max_size);
+
+  for (k = 1; k <= max_size; k++) {
+    for (c = 0; complexes[k - 1][c]; c++);
+
+    dG[k - 1] = (double *)vrna_alloc(sizeof(double) * (c + 1));
+  }
+
+  if (!vrna_pf_complexes_strands_cb(strands,
+                                    num_strands,
+                                    md,
+                                    complexes,
+                                    max_size,
+                                    &store_dG,
+                                    (void *)dG)) {
+    for (k = 1; k <= max_size; k++)
+      free(dG[k - 1]);
+
+    free(dG);
+    dG = NULL;
+  }
+
+  return dG;
+}
+
+
+PUBLIC int
+vrna_pf_complexes_strands_cb(const char           **strands,
+                             unsigned int         num_strands,
+                             vrna_md_t            *md_p,
+                             unsigned int         ***complexes,
+                             size_t               max_size,
+                             vrna_pf_complexes_f  cb,
+                             void                 *data)
+{
+  unsigned int        *species, *species_count, *mapping, **permutations, *perm;
+  int                 i, u, d, node, split, num_threads, num_units, *units;
+  size_t              k, c, s, p, num_species, num_jobs, num_complexes;
+  vrna_md_t           md;
+  struct prefix_trie  trie;
+
+  if ((!strands) ||
+      (num_strands == 0) ||
+      (!complexes) ||
+      (max_size == 0) ||
+      (!cb))
+    return 0;
+
+  if (md_p)
+    md = *md_p;
+  else
+    vrna_md_set_default(&md);
+
+  md.compute_bpp  = 0;
+  num_threads     = 1;
+
+#ifdef _OPENMP
+  if (md.threads != 1)
+    num_threads = vrna_cpu_threads(md.threads);
+
+#endif
+
+  /* each permutation is processed by a single thread */
+  md.threads = 1;
+
+  trie.num    = 1;
+  trie.size   = 64;
+  trie.nodes  = (struct prefix_node *)vrna_alloc(sizeof(struct prefix_node) * trie.size);
+
+  trie.nodes[0].parent  = -1;
+  trie.nodes[0].child   = -1;
+  trie.nodes[0].sibling = -1;
+  trie.strands          = strands;
+  trie.lengths          = (unsigned int *)vrna_alloc(sizeof(unsigned int) * num_strands);
+  trie.monomers         = (int *)vrna_alloc(sizeof(int) * num_strands);
+  trie.job_nodes        = NULL;
+  trie.job_complex      = NULL;
+  trie.first_job        = NULL;
+  trie.remaining        = NULL;
+  trie.sizes            = NULL;
+  trie.indices          = NULL;
+  trie.keep_monomers    = (max_size > 1) ? 1 : 0;
+  trie.kT               = md.betaScale * (md.temperature + K0) * GASCONST / 1000.;
+  trie.cb               = cb;
+  trie.data             = data;
+
+  for (s = 0; s < num_strands; s++) {
+    trie.lengths[s]   = (unsigned int)strlen(strands[s]);
+    trie.monomers[s]  = -1;
+  }
+
+  species       = (unsigned int *)vrna_alloc(sizeof(unsigned int) * (max_size + 1));
+  perm          = (unsigned int *)vrna_alloc(sizeof(unsigned int) * max_size);
+  species_count = (unsigned int *)vrna_alloc(sizeof(unsigned int) * num_strands);
+  mapping       = (unsigned int *)vrna_alloc(sizeof(unsigned int) * num_strands);
+  num_jobs      = 0;
+  num_complexes = 0;
+
+  /* insert all non-cyclic permutations of all complexes into the trie */
+  for (k = 1; k <= max_size; k++) {
+    for (c = 0; complexes[k - 1][c]; c++) {
+      memset(species_count, 0, sizeof(unsigned int) * num_strands);
+
+      for (s = 0; s < k; s++)
+        species_count[complexes[k - 1][c][s]]++;
+
+      for (num_species = s = 0; s < num_strands; s++) {
+        if (species_count[s] > 0) {
+          mapping[num_species]  = s;
+          species[num_species]  = species_count[s];
+          num_species++;
+        }
+      }
+
+      species[num_species] = 0;
+
+      permutations = vrna_enumerate_necklaces(species);
+
+      trie.first_job  = (size_t *)vrna_realloc(trie.first_job,
+                                               sizeof(size_t) * (num_complexes + 2));
+      trie.remaining  = (unsigned int *)vrna_realloc(trie.remaining,
+                                                     sizeof(unsigned int) * (num_complexes + 1));
+      trie.sizes      = (unsigned int *)vrna_realloc(trie.sizes,
+                                                     sizeof(unsigned int) * (num_complexes + 1));
+      trie.indices    = (size_t *)vrna_realloc(trie.indices,
+                                               sizeof(size_t) * (num_complexes + 1));
+
+      trie.first_job[num_complexes] = num_jobs;
+      trie.remaining[num_complexes] = 0;
+      trie.sizes[num_complexes]     = (unsigned int)k;
+      trie.indices[num_complexes]   = c;
+
+      for (p = 0; permutations[p]; p++) {
+        for (s = 0; s < k; s++)
+          perm[s] = mapping[permutations[p][s + 1]];
+
+        trie.job_nodes    = (int *)vrna_realloc(trie.job_nodes, sizeof(int) * (num_jobs + 1));
+        trie.job_complex  = (size_t *)vrna_realloc(trie.job_complex,
+                                                   sizeof(size_t) * (num_jobs + 1));
+
+        trie.job_nodes[num_jobs]    = trie_insert(&trie, perm, k);
+        trie.job_complex[num_jobs]  = num_complexes;
+        trie.remaining[num_complexes]++;
+        num_jobs++;
+
+        free(permutations[p]);
+      }
+
+      free(permutations);
+      num_complexes++;
+    }
+  }
+
+  free(species);
+  free(perm);
+  free(species_count);
+  free(mapping);
+
+  if (num_complexes > 0)
+    trie.first_job[num_complexes] = num_jobs;
+
+  /* link the permutations of each node, such that finished nodes can be reported */
+  trie.node_jobs  = (int *)vrna_alloc(sizeof(int) * trie.num);
+  trie.job_next   = (int *)vrna_alloc(sizeof(int) * (num_jobs + 1));
+
+  for (i = 0; i < trie.num; i++)
+    trie.node_jobs[i] = -1;
+
+  for (i = (int)num_jobs - 1; i >= 0; i--) {
+    node                  = trie.job_nodes[i];
+    trie.job_next[i]      = trie.node_jobs[node];
+    trie.node_jobs[node]  = i;
+  }
+
+  /* accumulate the cost estimates of the subtrees, parents always precede their children */
+  for (i = trie.num - 1; i > 0; i--)
+    trie.nodes[trie.nodes[i].parent].cost += trie.nodes[i].cost;
+
+  units = (int *)vrna_alloc(sizeof(int) * trie.num);
+
+  /*
+   *  single strands are processed first, their matrices serve as the block
+   *  of the last strand in all other permutations
+   */
+  for (num_units = 0, i = 1; i < trie.num; i++)
+    if (trie.nodes[i].depth == 1) {
+      units[num_units++]                      = i;
+      trie.monomers[trie.nodes[i].strand]  = i;
+    }
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads) if (num_threads > 1)
+  for (i = 0; i < num_units; i++)
+    process_node(&trie, units[i], &md);
+
+  /*
+   *  subtrees below the split depth are processed depth-first by a single
+   *  thread each. Nodes above are processed level by level, such that enough
+   *  subtrees are available to keep all threads busy
+   */
+  for (split = 2; split < (int)max_size; split++) {
+    for (num_units = 0, i = 1; i < trie.num; i++)
+      if (trie.nodes[i].depth == (unsigned int)split)
+        num_units++;
+
+    if (num_units >= 2 * num_threads)
+      break;
+  }
+
+  for (d = 2; d <= split; d++) {
+    for (num_units = 0, i = 1; i < trie.num; i++)
+      if (trie.nodes[i].depth == (unsigned int)d)
+        units[num_units++] = i;
+
+    /*
+     *  largest subtrees first. Complexes of maximum size are processed in
+     *  their input order instead, such that they can be reported early
+     */
+    if ((d == split) &&
+        (d < (int)max_size)) {
+      for (i = 1; i < num_units; i++) {
+        node = units[i];
+        for (u = i; (u > 0) && (trie.nodes[units[u - 1]].cost < trie.nodes[node].cost); u--)
+          units[u] = units[u - 1];
+
+        units[u] = node;
+      }
+    }
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(num_threads) if (num_threads > 1)
+    for (i = 0; i < num_units; i++) {
+      if (d == split)
+        process_subtree(&trie, units[i], &md);
+      else
+        process_node(&trie, units[i], &md);
+    }
+
+    /* states of the previous level are no longer required */
+    if (d > 2) {
+      for (i = 1; i < trie.num; i++)
+        if (trie.nodes[i].depth == (unsigned int)(d - 1)) {
+          prefix_state_free(trie.nodes[i].state);
+          trie.nodes[i].state = NULL;
+        }
+    }
+  }
+
+  for (i = 1; i < trie.num; i++)
+    if (trie.nodes[i].depth == 1) {
+      prefix_state_free(trie.nodes[i].state);
+      trie.nodes[i].state = NULL;
+    }
+
+  free(units);
+  free(trie.node_jobs);
+  free(trie.job_next);
+  free(trie.job_nodes);
+  free(trie.job_complex);
+  free(trie.first_job);
+  free(trie.remaining);
+  free(trie.sizes);
+  free(trie.indices);
+  free(trie.monomers);
+  free(trie.lengths);
+  free(trie.nodes);
+
+  return 1;
+}
+
+
 /*
  #################################
  # STATIC helper functions below #
@@ -137,3 +601,492 @@ mf_rule_pair(vrna_fold_compound_t *fc,
 
   return contribution;
 }
+
+
+PRIVATE int
+trie_insert(struct prefix_trie  *trie,
+            const unsigned int  *strands,
+            unsigned int        num_strands)
+{
+  unsigned int  k;
+  int           node, v;
+  double        l, l_parent;
+
+  for (node = 0, k = 0; k < num_strands; k++) {
+    for (v = trie->nodes[node].child; v >= 0; v = trie->nodes[v].sibling)
+      if (trie->nodes[v].strand == strands[k])
+        break;
+
+    if (v < 0) {
+      if (trie->num == trie->size) {
+        trie->size  *= 2;
+        trie->nodes = (struct prefix_node *)vrna_realloc(trie->nodes,
+                                                         sizeof(struct prefix_node) * trie->size);
+      }
+
+      v = trie->num++;
+
+      trie->nodes[v].strand   = strands[k];
+      trie->nodes[v].depth    = k + 1;
+      trie->nodes[v].length   = trie->nodes[node].length + trie->lengths[strands[k]];
+      trie->nodes[v].parent   = node;
+      trie->nodes[v].child    = -1;
+      trie->nodes[v].sibling  = trie->nodes[node].child;
+      trie->nodes[v].dG       = (double)INF / 100.;
+      trie->nodes[v].state    = NULL;
+      trie->nodes[node].child = v;
+
+      /* only the columns beyond the prefix need to be computed */
+      l                     = (double)trie->nodes[v].length;
+      l_parent              = (double)trie->nodes[node].length;
+      trie->nodes[v].cost   = l * l * l - l_parent * l_parent * l_parent;
+    }
+
+    node = v;
+  }
+
+  return node;
+}
+
+
+PRIVATE void
+process_subtree(struct prefix_trie  *trie,
+                int                 node,
+                vrna_md_t           *md)
+{
+  int v;
+
+  process_node(trie, node, md);
+
+  for (v = trie->nodes[node].child; v >= 0; v = trie->nodes[v].sibling)
+    process_subtree(trie, v, md);
+
+  prefix_state_free(trie->nodes[node].state);
+  trie->nodes[node].state = NULL;
+}
+
+
+PRIVATE void
+process_node(struct prefix_trie *trie,
+             int                node,
+             vrna_md_t          *md)
+{
+  char                  *sequence, *ptr;
+  unsigned int          d, *strands;
+  int                   v, done, keep;
+  double                e, mfe;
+  struct prefix_node    *p;
+  struct prefix_state   *prefix, *suffix;
+  vrna_fold_compound_t  *fc_node;
+
+  p       = trie->nodes + node;
+  prefix  = (p->parent > 0) ? trie->nodes[p->parent].state : NULL;
+  suffix  = ((p->depth > 1) && (trie->monomers[p->strand] >= 0)) ?
+            trie->nodes[trie->monomers[p->strand]].state :
+            NULL;
+  keep    = ((p->depth == 1) && (trie->keep_monomers)) ? 1 : 0;
+  strands = (unsigned int *)vrna_alloc(sizeof(unsigned int) * p->depth);
+
+  for (v = node, d = p->depth; v > 0; v = trie->nodes[v].parent)
+    strands[--d] = trie->nodes[v].strand;
+
+  sequence  = (char *)vrna_alloc(sizeof(char) * (p->length + p->depth));
+  ptr       = sequence;
+
+  for (d = 0; d < p->depth; d++) {
+    if (d > 0)
+      *(ptr++) = '&';
+
+    memcpy(ptr, trie->strands[strands[d]], trie->lengths[strands[d]]);
+    ptr += trie->lengths[strands[d]];
+  }
+
+  *ptr    = '\0';
+  fc_node = vrna_fold_compound(sequence, md, VRNA_OPTION_PF);
+  mfe     = (double)INF;
+  done    = 0;
+
+  if ((!md->gquad) &&
+      (!md->circ)) {
+    /*
+     *  extrapolate the scaling factor from the prefix, otherwise derive it
+     *  from the MFE as for an independent prediction
+     */
+    if (prefix) {
+      e = trie->nodes[p->parent].dG * (double)p->length / (double)prefix->length;
+    } else {
+      e = mfe = (double)vrna_mfe(fc_node, NULL);
+      vrna_mx_mfe_free(fc_node);
+    }
+
+    if (vrna_fold_compound_prepare(fc_node, VRNA_OPTION_PF)) {
+      vrna_exp_params_rescale(fc_node, &e);
+
+      if (fill_columns(fc_node,
+                       prefix,
+                       suffix,
+                       ((p->child >= 0) || (keep)) ? &(p->state) : NULL,
+                       keep)) {
+        p->dG = (double)ensemble_energy(fc_node);
+        done  = 1;
+      }
+    }
+  }
+
+  if (!done) {
+    /* the permutations that extend this one start from scratch */
+    if (mfe >= (double)INF)
+      mfe = (double)vrna_mfe(fc_node, NULL);
+
+    vrna_exp_params_rescale(fc_node, &mfe);
+    p->dG = (double)vrna_pf(fc_node, NULL);
+  }
+
+  vrna_fold_compound_free(fc_node);
+  free(sequence);
+  free(strands);
+
+  report_node(trie, node);
+}
+
+
+/*
+ *  Pass the ensemble free energy of each complex to the callback as soon as
+ *  all of its permutations are done. The partition functions are summed up
+ *  in the order of the permutations, such that the result does not depend
+ *  on the order in which the threads finish
+ */
+PRIVATE void
+report_node(struct prefix_trie *trie,
+            int                node)
+{
+  int     v;
+  size_t  c, j;
+  double  F;
+
+  for (v = trie->node_jobs[node]; v >= 0; v = trie->job_next[v]) {
+    c = trie->job_complex[v];
+
+#pragma omp critical (pf_complexes_report)
+    {
+      if (--(trie->remaining[c]) == 0) {
+        F = trie->nodes[trie->job_nodes[trie->first_job[c]]].dG;
+
+        for (j = trie->first_job[c] + 1; j < trie->first_job[c + 1]; j++)
+          F = vrna_pf_add(F, trie->nodes[trie->job_nodes[j]].dG, trie->kT);
+
+        trie->cb(trie->sizes[c], trie->indices[c], F, trie->data);
+      }
+    }
+  }
+}
+
+
+PRIVATE void
+store_dG(unsigned int size,
+         size_t       complex,
+         double       dG,
+         void         *data)
+{
+  double **dG_all = (double **)data;
+
+  dG_all[size - 1][complex] = dG;
+}
+
+
+/*
+ *  Fill the partition function matrices column-wise as in the serial
+ *  recursions of vrna_pf(). All columns of a prefix permutation are copied
+ *  and adapted to the scaling factor of the current sequence. The
+ *  helper arrays of the exterior and multibranch loop decompositions are
+ *  attached to our own buffers, such that those of the last column of the
+ *  prefix can be restored as well. With lonely pairs disallowed, whether
+ *  a pair (i, j) may be stacked by (i - 1, j + 1) depends on the first
+ *  nucleotide of the next strand, so the last column of a prefix is
+ *  re-computed.
+ *
+ *  Segments [i, j] within the last strand do not depend on any other
+ *  strand either. If the matrices of the last strand by itself (suffix)
+ *  are available, those entries, including the helper arrays, are copied
+ *  as well and only the rows i of the preceding strands are computed for
+ *  the remaining columns. Here, lonely pairs affect the first row of the
+ *  last strand instead
+ */
+PRIVATE int
+fill_columns(vrna_fold_compound_t *fc,
+             struct prefix_state  *prefix,
+             struct prefix_state  *suffix,
+             struct prefix_state  **state,
+             int                  all_columns)
+{
+  unsigned int        n, n1, P, size;
+  int                 i, j, ij, jj, l, u, first, ret, *my_iindx;
+  FLT_OR_DBL          *q, *qb, *qm, *qq[2], *qqm[2], *qq_mx, *qqm_mx, *f, *fs, Q, max_real,
+                      min_real;
+  double              d;
+  vrna_md_t           *md;
+  vrna_mx_pf_aux_el_t aux_mx_el;
+  vrna_mx_pf_aux_ml_t aux_mx_ml;
+  struct prefix_state *s;
+
+  n         = fc->length;
+  my_iindx  = fc->iindx;
+  q         = fc->exp_matrices->q;
+  qb        = fc->exp_matrices->qb;
+  qm        = fc->exp_matrices->qm;
+  md        = &(fc->exp_params->model_details);
+  max_real  = (sizeof(FLT_OR_DBL) == sizeof(float)) ? FLT_MAX : DBL_MAX;
+  min_real  = (sizeof(FLT_OR_DBL) == sizeof(float)) ? FLT_MIN : DBL_MIN;
+  qq_mx     = NULL;
+  qqm_mx    = NULL;
+  fs        = NULL;
+  n1        = n;
+  first     = n + 1;
+  size      = n * (n + 1) / 2 + 1;
+  ret       = 1;
+
+  if (fc->strands > 1)
+    vrna_pf_multifold_prepare(fc);
+
+  aux_mx_el = vrna_exp_E_ext_fast_init(fc);
+  aux_mx_ml = vrna_exp_E_ml_fast_init(fc);
+
+  for (i = 0; i < 2; i++) {
+    qq[i]   = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 2));
+    qqm[i]  = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 2));
+  }
+
+  if ((state) && (all_columns)) {
+    qq_mx   = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size);
+    qqm_mx  = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size);
+  }
+
+  for (i = 1; i <= (int)n; i++)
+    qb[my_iindx[i] - i] = 0.;
+
+  P = 1;
+
+  if ((prefix) && (prefix->columns > 0)) {
+    P = prefix->columns;
+
+    /* entries for segments of length l are re-scaled by (old / new pf_scale)^l */
+    f = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (P + 1));
+    d = log(prefix->pf_scale) - log(fc->exp_params->pf_scale);
+
+    for (l = 0; l <= (int)P; l++)
+      f[l] = (FLT_OR_DBL)exp((double)l * d);
+
+    for (j = 1; j <= (int)P; j++) {
+      jj = j * (j - 1) / 2;
+      for (i = 1; i <= j; i++) {
+        ij      = my_iindx[i] - j;
+        q[ij]   = prefix->q[jj + i] * f[j - i + 1];
+        qb[ij]  = prefix->qb[jj + i] * f[j - i + 1];
+        qm[ij]  = prefix->qm[jj + i] * f[j - i + 1];
+      }
+    }
+
+    for (i = 1; i <= (int)P; i++) {
+      qq[P & 1][i]  = prefix->qq[i] * f[P - i + 1];
+      qqm[P & 1][i] = prefix->qqm[i] * f[P - i + 1];
+    }
+
+    free(f);
+  }
+
+  if ((suffix) &&
+      (suffix->qq_mx) &&
+      (suffix->length < n)) {
+    n1    = n - suffix->length;
+    first = (md->noLP) ? n1 + 2 : n1 + 1;
+    fs    = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (suffix->length + 1));
+    d     = log(suffix->pf_scale) - log(fc->exp_params->pf_scale);
+
+    for (l = 0; l <= (int)suffix->length; l++)
+      fs[l] = (FLT_OR_DBL)exp((double)l * d);
+  }
+
+  for (j = P + 1; (j <= (int)n) && (ret); j++) {
+    vrna_exp_E_ext_fast_attach(aux_mx_el, qq[j & 1], qq[(j - 1) & 1]);
+    vrna_exp_E_ml_fast_attach(aux_mx_ml, qqm[j & 1], qqm[(j - 1) & 1]);
+
+    i = j - 1;
+
+    if (j > first) {
+      jj = (j - n1) * (j - n1 - 1) / 2;
+      for (i = first; i < j; i++) {
+        ij            = my_iindx[i] - j;
+        l             = j - i + 1;
+        u             = jj + i - n1;
+        q[ij]         = suffix->q[u] * fs[l];
+        qb[ij]        = suffix->qb[u] * fs[l];
+        qm[ij]        = suffix->qm[u] * fs[l];
+        qq[j & 1][i]  = suffix->qq_mx[u] * fs[l];
+        qqm[j & 1][i] = suffix->qqm_mx[u] * fs[l];
+
+        if (q[ij] >= max_real)
+          ret = 0;
+      }
+
+      i = first - 1;
+    }
+
+    for (; (i >= 1) && (ret); i--) {
+      ij      = my_iindx[i] - j;
+      qb[ij]  = exp_pair(fc, i, j, aux_mx_ml);
+      qm[ij]  = vrna_exp_E_ml_fast(fc, i, j, aux_mx_ml);
+      q[ij]   = vrna_exp_E_ext_fast(fc, i, j, aux_mx_el);
+
+      if (q[ij] >= max_real)
+        ret = 0;
+    }
+
+    if (qq_mx) {
+      jj = j * (j - 1) / 2;
+      memcpy(qq_mx + jj + 1, qq[j & 1] + 1, sizeof(FLT_OR_DBL) * (j - 1));
+      memcpy(qqm_mx + jj + 1, qqm[j & 1] + 1, sizeof(FLT_OR_DBL) * (j - 1));
+    }
+  }
+
+  if (ret) {
+    switch (md->backtrack_type) {
+      case 'C':
+        Q = qb[my_iindx[1] - n];
+        break;
+
+      case 'M':
+        Q = qm[my_iindx[1] - n];
+        break;
+
+      default:
+        Q = q[my_iindx[1] - n];
+        break;
+    }
+
+    if (!((Q > min_real) && (Q < max_real)))
+      ret = 0;
+  }
+
+  if ((ret) && (state)) {
+    s = (struct prefix_state *)vrna_alloc(sizeof(struct prefix_state));
+
+    s->length   = n;
+    s->columns  = (md->noLP) ? n - 1 : n;
+    s->pf_scale = fc->exp_params->pf_scale;
+    s->q        = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size);
+    s->qb       = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size);
+    s->qm       = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size);
+    s->qq       = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 1));
+    s->qqm      = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 1));
+    s->qq_mx    = qq_mx;
+    s->qqm_mx   = qqm_mx;
+    qq_mx       = NULL;
+    qqm_mx      = NULL;
+
+    for (j = 1; j <= (int)n; j++) {
+      jj = j * (j - 1) / 2;
+      for (i = 1; i <= j; i++) {
+        ij            = my_iindx[i] - j;
+        s->q[jj + i]  = q[ij];
+        s->qb[jj + i] = qb[ij];
+        s->qm[jj + i] = qm[ij];
+      }
+    }
+
+    /* column n - 1 is still present in the other buffer */
+    memcpy(s->qq, qq[s->columns & 1], sizeof(FLT_OR_DBL) * (n + 1));
+    memcpy(s->qqm, qqm[s->columns & 1], sizeof(FLT_OR_DBL) * (n + 1));
+
+    *state = s;
+  }
+
+  vrna_exp_E_ml_fast_free(aux_mx_ml);
+  vrna_exp_E_ext_fast_free(aux_mx_el);
+
+  for (i = 0; i < 2; i++) {
+    free(qq[i]);
+    free(qqm[i]);
+  }
+
+  free(qq_mx);
+  free(qqm_mx);
+  free(fs);
+
+  if (fc->strands > 1)
+    vrna_gr_reset(fc);
+
+  return ret;
+}
+
+
+PRIVATE INLINE FLT_OR_DBL
+exp_pair(vrna_fold_compound_t *fc,
+         int                  i,
+         int                  j,
+         vrna_mx_pf_aux_ml_t  aux_mx_ml)
+{
+  FLT_OR_DBL contribution = 0.;
+
+  if (fc->hc->mx[j * fc->length + i]) {
+    contribution += vrna_exp_E_hp_loop(fc, i, j);
+    contribution += vrna_exp_E_int_loop(fc, i, j);
+    contribution += vrna_exp_E_mb_loop_fast(fc, i, j, aux_mx_ml);
+
+    if ((fc->aux_grammar) && (fc->aux_grammar->cb_aux_exp_c))
+      contribution += fc->aux_grammar->cb_aux_exp_c(fc, i, j, fc->aux_grammar->data);
+  }
+
+  return contribution;
+}
+
+
+/* same as the final step of vrna_pf() */
+PRIVATE FLT_OR_DBL
+ensemble_energy(vrna_fold_compound_t *fc)
+{
+  unsigned int      n;
+  FLT_OR_DBL        Q;
+  vrna_exp_param_t  *params;
+
+  n       = fc->length;
+  params  = fc->exp_params;
+
+  switch (params->model_details.backtrack_type) {
+    case 'C':
+      Q = fc->exp_matrices->qb[fc->iindx[1] - n];
+      break;
+
+    case 'M':
+      Q = fc->exp_matrices->qm[fc->iindx[1] - n];
+      break;
+
+    default:
+      Q = fc->exp_matrices->q[fc->iindx[1] - n];
+      break;
+  }
+
+  if (fc->strands > 1) {
+    Q /= (FLT_OR_DBL)vrna_rotational_symmetry(fc->sequence);
+    Q *= pow(params->expDuplexInit, (FLT_OR_DBL)(fc->strands - 1));
+  }
+
+  return (FLT_OR_DBL)((-log(Q) - n * log(params->pf_scale)) *
+                      params->kT /
+                      1000.0);
+}
+
+
+PRIVATE void
+prefix_state_free(struct prefix_state *state)
+{
+  if (state) {
+    free(state->q);
+    free(state->qb);
+    free(state->qm);
+    free(state->qq);
+    free(state->qqm);
+    free(state->qq_mx);
+    free(state->qqm_mx);
+    free(state);
+  }
+}
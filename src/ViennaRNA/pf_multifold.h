@@ -3,8 +3,120 @@
 
 #include "ViennaRNA/fold_compound.h"
 
+/**
+ *  @brief  Callback to receive the ensemble free energy of a complex
+ *
+ *  @see vrna_pf_complexes_strands_cb()
+ *
+ *  @param  size    The number of strands in the complex
+ *  @param  complex The index of the complex among those of the same @p size
+ *  @param  dG      The ensemble free energy of the complex (in kcal/mol)
+ *  @param  data    The auxiliary data passed to vrna_pf_complexes_strands_cb()
+ */
+typedef void (*vrna_pf_complexes_f)(unsigned int  size,
+                                    size_t        complex,
+                                    double        dG,
+                                    void          *data);
+
+
 int
 vrna_pf_multifold_prepare(vrna_fold_compound_t *fc);
 
 
+/**
+ *  @brief  Compute the ensemble free energies of all complexes up to a maximum size
+ *
+ *  For each complex, i.e. a multiset of strands of @p fc, the partition
+ *  functions of all its non-cyclic permutations are computed and summed up.
+ *  Here, @p complexes[k - 1] is the @p NULL terminated list of complexes of
+ *  size @p k, where each complex is an array of @p k strand numbers, as
+ *  obtained from vrna_n_multichoose_k(). Permutations that start with the
+ *  same strands share their partition function matrices for the common
+ *  prefix, which therefore only needs to be computed once. If the complexes
+ *  of size 1 are requested as well, the matrices of each strand by itself
+ *  also serve for the segments within the last strand of any permutation,
+ *  such that only the rows of the preceding strands are computed. Independent
+ *  permutations are processed in parallel if OpenMP is available and the
+ *  model details of @p fc allow for multiple threads (see #vrna_md_t.threads).
+ *
+ *  The result agrees with predicting each permutation separately with
+ *  vrna_pf(), after the scaling factor has been adapted to its MFE, up to
+ *  floating point rounding (about 1e-14 kcal/mol), since the re-used
+ *  matrices are re-scaled to the scaling factor of each permutation.
+ *
+ *  @see vrna_n_multichoose_k(), vrna_enumerate_necklaces(), vrna_pf_add()
+ *
+ *  @param  fc          The fold compound holding all strands
+ *  @param  complexes   The complexes for each size 1 to @p max_size
+ *  @param  max_size    The maximum number of strands in a complex
+ *  @return             The ensemble free energies @p dG[k - 1][c] of complex @p c of size @p k (in kcal/mol), or @p NULL on error
+ */
+double **
+vrna_pf_complexes(vrna_fold_compound_t  *fc,
+                  unsigned int          ***complexes,
+                  size_t                max_size);
+
+
+/**
+ *  @brief  Compute the ensemble free energies of all complexes formed by a list of strands
+ *
+ *  Same as vrna_pf_complexes(), but the strands are given as individual
+ *  sequences instead of a fold compound, which avoids the memory requirements
+ *  of a fold compound for the concatenation of all strands. This is useful to
+ *  screen large libraries of strands, e.g. all pairs of @p num_strands strands
+ *  for dimer formation, where each strand is folded only once. The dimers AB
+ *  then start from the partition function matrices of A and B, and only the
+ *  entries (i, j) with i in A and j in B are computed.
+ *
+ *  @see vrna_pf_complexes(), vrna_pf_complexes_strands_cb(), vrna_n_multichoose_k()
+ *
+ *  @param  strands     The sequences of the strands (without strand delimiter)
+ *  @param  num_strands The number of strands
+ *  @param  md          The model details (may be @p NULL to use default settings)
+ *  @param  complexes   The complexes for each size 1 to @p max_size
+ *  @param  max_size    The maximum number of strands in a complex
+ *  @return             The ensemble free energies @p dG[k - 1][c] of complex @p c of size @p k (in kcal/mol), or @p NULL on error
+ */
+double **
+vrna_pf_complexes_strands(const char    **strands,
+                          unsigned int  num_strands,
+                          vrna_md_t     *md,
+                          unsigned int  ***complexes,
+                          size_t        max_size);
+
+
+/**
+ *  @brief  Compute the ensemble free energies of all complexes formed by a list of strands and pass them to a callback
+ *
+ *  Same as vrna_pf_complexes_strands(), but the ensemble free energy of each
+ *  complex is passed to the callback @p cb as soon as it is available, rather
+ *  than being stored. This allows for processing the results of large screens
+ *  without keeping all of them in memory. The complexes of size 1 are reported
+ *  before any other complex. Complexes of size @p max_size are processed in
+ *  the order of @p complexes, although with multiple threads they may finish
+ *  in a different order, e.g. use an ordered output stream (see
+ *  vrna_ostream_init()) to process them in order. The callback is never
+ *  executed concurrently.
+ *
+ *  @see vrna_pf_complexes_strands(), #vrna_pf_complexes_f
+ *
+ *  @param  strands     The sequences of the strands (without strand delimiter)
+ *  @param  num_strands The number of strands
+ *  @param  md          The model details (may be @p NULL to use default settings)
+ *  @param  complexes   The complexes for each size 1 to @p max_size
+ *  @param  max_size    The maximum number of strands in a complex
+ *  @param  cb          The callback that receives the ensemble free energy of each complex
+ *  @param  data        Auxiliary data passed to the callback
+ *  @return             Non-zero on success, 0 otherwise
+ */
+int
+vrna_pf_complexes_strands_cb(const char           **strands,
+                             unsigned int         num_strands,
+                             vrna_md_t            *md,
+                             unsigned int         ***complexes,
+                             size_t               max_size,
+                             vrna_pf_complexes_f  cb,
+                             void                 *data);
+
+
 #endif
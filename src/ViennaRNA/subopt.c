@@ -32,6 +32,7 @@
 #include "ViennaRNA/params/default.h"
 #include "ViennaRNA/fold_vars.h"
 #include "ViennaRNA/datastructures/lists.h"
+#include "ViennaRNA/datastructures/heap.h"
 #include "ViennaRNA/eval.h"
 #include "ViennaRNA/params/basic.h"
 #include "ViennaRNA/loops/all.h"
@@ -66,6 +67,9 @@
 #define true              1
 #define false             0
 
+/* number of nodes allocated at once by the STATE/INTERVAL node pools */
+#define NODE_POOL_BLOCK   1024
+
 typedef struct {
   struct hc_ext_def_dat     hc_dat_ext;
   vrna_hc_eval_f hc_eval_ext;
@@ -95,17 +99,40 @@ typedef struct INTERVAL {
 } INTERVAL;
 
 typedef struct {
-  char  *structure;
-  LIST  *Intervals;
-  int   partial_energy;
-  int   is_duplex;
-  /* int best_energy;   */ /* best attainable energy */
+  char    *structure;
+  LIST    *Intervals;
+  int     partial_energy;
+  int     is_duplex;
+  int     best_energy;    /* best attainable energy */
+  size_t  queue_pos;      /* position in the priority queue */
+  size_t  evict_pos;      /* position in the eviction queue */
 } STATE;
 
+/**
+ *  @brief  Free-list allocator for STATE and INTERVAL nodes
+ *
+ *  Nodes carry the usual LST_BUCKET header such that they can be linked
+ *  into a LIST. Released nodes are chained through that very header and
+ *  handed out again before a new block is allocated.
+ */
 typedef struct {
-  LIST  *Intervals;
-  LIST  *Stack;
-  int   nopush;
+  size_t      node_size;    /* size of a node, including its list header */
+  char        **blocks;
+  size_t      num_blocks;
+  size_t      block_fill;   /* number of nodes handed out from the last block */
+  LST_BUCKET  *recycled;    /* released nodes */
+  size_t      in_use;       /* number of nodes currently in use */
+} node_pool;
+
+typedef struct {
+  LIST                  *Stack;
+  int                   nopush;
+  vrna_fold_compound_t  *fc;
+  int                   length;
+  node_pool             states;     /* STATE, its LIST of intervals, and its structure */
+  node_pool             intervals;
+  vrna_heap_t           queue;      /* energy-ordered subopt: states by best attainable energy */
+  vrna_heap_t           evict;      /* energy-ordered subopt: states by decreasing best attainable energy */
 } subopt_env;
 
 
@@ -158,6 +185,15 @@ PRIVATE void
 free_constraint_helpers(constraint_helpers *d);
 
 
+PRIVATE int
+subopt_run(vrna_fold_compound_t *fc,
+           int                  delta,
+           int                  sorted,
+           size_t               max_memory,
+           vrna_subopt_result_f cb,
+           void                 *data);
+
+
 #ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
 
 PRIVATE vrna_subopt_solution_t *
@@ -186,22 +222,40 @@ make_gquad(int    i,
            STATE  *state);
 
 
+PRIVATE void
+init_node_pool(node_pool  *pool,
+               size_t     size);
+
+
+PRIVATE void
+free_node_pool(node_pool *pool);
+
+
+PRIVATE void *
+node_pool_get(node_pool *pool);
+
+
+PRIVATE void
+node_pool_release(node_pool *pool,
+                  void      *node);
+
+
 PRIVATE INTERVAL *
-make_interval(int i,
-              int j,
-              int ml);
+make_interval(int         i,
+              int         j,
+              int         ml,
+              subopt_env  *env);
 
 
 PRIVATE STATE *
-make_state(LIST *Intervals,
-           char *structure,
-           int  partial_energy,
-           int  is_duplex,
-           int  length);
+make_state(int        partial_energy,
+           int        is_duplex,
+           subopt_env *env);
 
 
 PRIVATE STATE *
-copy_state(STATE *state);
+copy_state(STATE      *state,
+           subopt_env *env);
 
 
 PRIVATE void
@@ -221,6 +275,55 @@ push(LIST *list,
      void *data);
 
 
+PRIVATE void
+push_state(subopt_env *env,
+           STATE      *state);
+
+
+PRIVATE void
+evict_states(subopt_env *env,
+             size_t     max_memory,
+             int        *threshold);
+
+
+PRIVATE size_t
+subopt_memory(subopt_env *env);
+
+
+PRIVATE int
+state_cmp(const void  *a,
+          const void  *b,
+          void        *data);
+
+
+PRIVATE int
+state_cmp_rev(const void  *a,
+              const void  *b,
+              void        *data);
+
+
+PRIVATE size_t
+state_get_queue_pos(const void  *a,
+                    void        *data);
+
+
+PRIVATE void
+state_set_queue_pos(const void  *a,
+                    size_t      pos,
+                    void        *data);
+
+
+PRIVATE size_t
+state_get_evict_pos(const void  *a,
+                    void        *data);
+
+
+PRIVATE void
+state_set_evict_pos(const void  *a,
+                    size_t      pos,
+                    void        *data);
+
+
 PRIVATE void *
 pop(LIST *list);
 
@@ -323,16 +426,18 @@ scan_gquad(vrna_fold_compound_t *fc,
 
 
 PRIVATE void
-free_interval_node(INTERVAL *node);
+free_interval_node(INTERVAL   *node,
+                   subopt_env *env);
 
 
 PRIVATE void
-free_state_node(STATE *node);
+free_state_node(STATE       *node,
+                subopt_env  *env);
 
 
 PRIVATE void
-push_back(LIST  *Stack,
-          STATE *state);
+push_back(subopt_env  *env,
+          STATE       *state);
 
 
 PRIVATE char *
@@ -512,6 +617,34 @@ vrna_subopt_cb(vrna_fold_compound_t *fc,
                int                  delta,
                vrna_subopt_result_f cb,
                void                 *data)
+{
+  (void)subopt_run(fc, delta, 0, 0, cb, data);
+}
+
+
+PUBLIC int
+vrna_subopt_sorted_cb(vrna_fold_compound_t  *fc,
+                      int                   delta,
+                      size_t                max_memory,
+                      vrna_subopt_result_f  cb,
+                      void                  *data)
+{
+  return subopt_run(fc, delta, 1, max_memory, cb, data);
+}
+
+
+/*
+ #####################################
+ # BEGIN OF STATIC HELPER FUNCTIONS  #
+ #####################################
+ */
+PRIVATE int
+subopt_run(vrna_fold_compound_t *fc,
+           int                  delta,
+           int                  sorted,
+           size_t               max_memory,
+           vrna_subopt_result_f cb,
+           void                 *data)
 {
   subopt_env          *env;
   STATE               *state;
@@ -530,6 +663,10 @@ vrna_subopt_cb(vrna_fold_compound_t *fc,
   int                 *f5;
   constraint_helpers  constraints_dat;
 
+  /* the recursions below address the MFE matrices via jindx, i.e. tiled matrices won't do */
+  if ((fc->matrices) && (fc->matrices->type == VRNA_MX_TILED))
+    vrna_mx_mfe_free(fc);
+
   vrna_fold_compound_prepare(fc, VRNA_OPTION_MFE);
 
   length  = fc->length;
@@ -547,6 +684,14 @@ vrna_subopt_cb(vrna_fold_compound_t *fc,
   logML       = md->logML;
   old_dangles = dangle_model = md->dangles;
 
+  if ((md->uniq_ML != 1) ||
+      ((md->dangles != 0) && (md->dangles != 2))) {
+    /* energy parameters may be shared with other fold compounds */
+    fc->params  = vrna_params_unshare(fc->params);
+    P           = fc->params;
+    md          = &(P->model_details);
+  }
+
   if (md->uniq_ML != 1) /* failsafe mechanism to enforce valid fM1 array */
     md->uniq_ML = 1;
 
@@ -559,7 +704,8 @@ vrna_subopt_cb(vrna_fold_compound_t *fc,
   min_en = vrna_mfe(fc, struc);
 
   /* restore dangle model */
-  md->dangles = old_dangles;
+  if (md->dangles != old_dangles)
+    md->dangles = old_dangles;
 
   /* re-evaluate in case we're using logML etc */
   min_en  = vrna_eval_structure(fc, struc);
@@ -588,17 +734,37 @@ vrna_subopt_cb(vrna_fold_compound_t *fc,
   }
 
   /* init env data structure */
-  env             = (subopt_env *)vrna_alloc(sizeof(subopt_env));
-  env->Stack      = NULL;
-  env->nopush     = true;
-  env->Stack      = make_list();                      /* anchor */
-  env->Intervals  = make_list();                      /* initial state: */
-  interval        = make_interval(1, length, 0);      /* interval [1,length,0] */
-  push(env->Intervals, interval);
-  env->nopush = false;
-  state       = make_state(env->Intervals, NULL, partial_energy, 0, length);
-  /* state->best_energy = minimal_energy; */
-  push(env->Stack, state);
+  env         = (subopt_env *)vrna_alloc(sizeof(subopt_env));
+  env->fc     = fc;
+  env->length = length;
+  env->nopush = true;
+  env->Stack  = make_list();                          /* anchor */
+  env->queue  = NULL;
+  env->evict  = NULL;
+
+  init_node_pool(&(env->states), sizeof(STATE) + sizeof(LIST) + length + 1);
+  init_node_pool(&(env->intervals), sizeof(INTERVAL));
+
+  if (sorted) {
+    /* process the states in order of their best attainable energy */
+    env->queue = vrna_heap_init(1024,
+                                state_cmp,
+                                state_get_queue_pos,
+                                state_set_queue_pos,
+                                NULL);
+
+    if (max_memory > 0)
+      env->evict = vrna_heap_init(1024,
+                                  state_cmp_rev,
+                                  state_get_evict_pos,
+                                  state_set_evict_pos,
+                                  NULL);
+  }
+
+  state     = make_state(partial_energy, 0, env); /* initial state: */
+  interval  = make_interval(1, length, 0, env);   /* interval [1,length,0] */
+  push(state->Intervals, interval);
+  push_state(env, state);
   env->nopush = false;
 
   /* end initialize ------------------------------------------------------- */
@@ -607,24 +773,36 @@ vrna_subopt_cb(vrna_fold_compound_t *fc,
   while (1) {
     /* forever, til nothing remains on stack */
 
-    maxlevel = (env->Stack->count > maxlevel ? env->Stack->count : maxlevel);
+    if (env->queue) {
+      /*
+       * the state with lowest best attainable energy comes first. Since
+       * the best attainable energy never decreases upon expansion of a
+       * state, solutions are found in order of increasing energy
+       */
+      state = vrna_heap_pop(env->queue);
+      if ((state) && (env->evict))
+        vrna_heap_remove(env->evict, state);
+
+      /* remaining states may not be complete anymore due to the memory limit */
+      if ((state) && (state->best_energy > threshold))
+        state = NULL;
+    } else {
+      maxlevel  = (env->Stack->count > maxlevel ? env->Stack->count : maxlevel);
+      state     = (LST_EMPTY(env->Stack)) ? NULL : pop(env->Stack);
+    }
 
-    if (LST_EMPTY(env->Stack)) {
+    if (state == NULL) {
       /*
        * we are done! clean up and quit
        * fprintf(stderr, "maxlevel: %d\n", maxlevel);
        */
 
-      lst_kill(env->Stack, free_state_node);
-
       cb(NULL, 0, data);   /* NULL (last time to call callback function */
 
       break;
     }
 
-    /* pop the last element ---------------------------------------------- */
-
-    state = pop(env->Stack);                       /* current state to work with */
+    /* state is the current state to work with --------------------------- */
 
     if (LST_EMPTY(state->Intervals)) {
       int e;
@@ -687,24 +865,29 @@ vrna_subopt_cb(vrna_fold_compound_t *fc,
                     state, env,
                     &constraints_dat);
 
-      free_interval_node(interval);        /* free the current interval */
+      free_interval_node(interval, env);   /* free the current interval */
     }
 
-    free_state_node(state);                     /* free the current state */
+    free_state_node(state, env);                /* free the current state */
+
+    if ((env->evict) && (subopt_memory(env) > max_memory))
+      evict_states(env, max_memory, &threshold);
   } /* end of while (1) */
 
   /* cleanup memory */
   free_constraint_helpers(&constraints_dat);
 
+  vrna_heap_free(env->queue);
+  vrna_heap_free(env->evict);
+  free_node_pool(&(env->states));
+  free_node_pool(&(env->intervals));
+  free(env->Stack);
   free(env);
+
+  return threshold - minimal_energy;
 }
 
 
-/*
- #####################################
- # BEGIN OF STATIC HELPER FUNCTIONS  #
- #####################################
- */
 PRIVATE void
 init_constraint_helpers(vrna_fold_compound_t  *fc,
                         constraint_helpers    *d)
@@ -765,14 +948,87 @@ make_gquad(int    i,
 }
 
 
+PRIVATE void
+init_node_pool(node_pool  *pool,
+               size_t     size)
+{
+  /* keep all nodes aligned to the list header */
+  size = (size + sizeof(LST_BUCKET) - 1) / sizeof(LST_BUCKET) + 1;
+
+  pool->node_size   = size * sizeof(LST_BUCKET);
+  pool->blocks      = NULL;
+  pool->num_blocks  = 0;
+  pool->block_fill  = NODE_POOL_BLOCK;
+  pool->recycled    = NULL;
+  pool->in_use      = 0;
+}
+
+
+PRIVATE void
+free_node_pool(node_pool *pool)
+{
+  size_t b;
+
+  for (b = 0; b < pool->num_blocks; b++)
+    free(pool->blocks[b]);
+
+  free(pool->blocks);
+
+  pool->blocks      = NULL;
+  pool->num_blocks  = 0;
+  pool->block_fill  = NODE_POOL_BLOCK;
+  pool->recycled    = NULL;
+  pool->in_use      = 0;
+}
+
+
+PRIVATE void *
+node_pool_get(node_pool *pool)
+{
+  LST_BUCKET *node;
+
+  if (pool->recycled) {
+    node            = pool->recycled;
+    pool->recycled  = node->next;
+  } else {
+    if (pool->block_fill == NODE_POOL_BLOCK) {
+      pool->blocks = (char **)vrna_realloc(pool->blocks,
+                                           sizeof(char *) * (pool->num_blocks + 1));
+      pool->blocks[pool->num_blocks++] = (char *)vrna_alloc(pool->node_size * NODE_POOL_BLOCK);
+      pool->block_fill                 = 0;
+    }
+
+    node = (LST_BUCKET *)(pool->blocks[pool->num_blocks - 1] +
+                          pool->node_size * pool->block_fill++);
+  }
+
+  pool->in_use++;
+
+  return LST_USERSPACE(node);
+}
+
+
+PRIVATE void
+node_pool_release(node_pool *pool,
+                  void      *node)
+{
+  LST_BUCKET *header = LST_HEADER(node);
+
+  header->next    = pool->recycled;
+  pool->recycled  = header;
+  pool->in_use--;
+}
+
+
 PRIVATE INTERVAL *
-make_interval(int i,
-              int j,
-              int array_flag)
+make_interval(int         i,
+              int         j,
+              int         array_flag,
+              subopt_env  *env)
 {
   INTERVAL *interval;
 
-  interval              = lst_newnode(sizeof(INTERVAL));
+  interval              = node_pool_get(&(env->intervals));
   interval->i           = i;
   interval->j           = j;
   interval->array_flag  = array_flag;
@@ -781,79 +1037,94 @@ make_interval(int i,
 
 
 PRIVATE void
-free_interval_node(INTERVAL *node)
+free_interval_node(INTERVAL   *node,
+                   subopt_env *env)
 {
-  lst_freenode(node);
+  node_pool_release(&(env->intervals), node);
 }
 
 
 PRIVATE void
-free_state_node(STATE *node)
+free_state_node(STATE       *node,
+                subopt_env  *env)
 {
-  free(node->structure);
-  if (node->Intervals)
-    lst_kill(node->Intervals, lst_freenode);
+  while (!LST_EMPTY(node->Intervals))
+    node_pool_release(&(env->intervals), pop(node->Intervals));
 
-  lst_freenode(node);
+  node_pool_release(&(env->states), node);
 }
 
 
-PRIVATE STATE *
-make_state(LIST *Intervals,
-           char *structure,
-           int  partial_energy,
-           int  is_duplex,
-           int  length)
+/*
+ * States are allocated from the node pool together with their list of
+ * intervals and the partial structure, i.e. as a single chunk of memory
+ */
+PRIVATE INLINE STATE *
+new_state_node(subopt_env *env)
 {
   STATE *state;
+  LIST  *l;
 
-  state = lst_newnode(sizeof(STATE));
+  state = node_pool_get(&(env->states));
+  l     = (LIST *)(state + 1);
 
-  if (Intervals)
-    state->Intervals = Intervals;
-  else
-    state->Intervals = lst_init();
+  l->count          = 0;
+  l->head           = &(l->hz[0]);
+  l->z              = &(l->hz[1]);
+  l->head->next     = l->z->next = l->z;
+  state->Intervals  = l;
+  state->structure  = (char *)(l + 1);
+  state->is_duplex  = 0;
+  state->queue_pos  = 0;
+  state->evict_pos  = 0;
+
+  return state;
+}
 
-  if (structure) {
-    state->structure = structure;
-  } else {
-    int i;
-    state->structure = (char *)vrna_alloc(length + 1);
-    for (i = 0; i < length; i++)
-      state->structure[i] = '.';
-  }
+
+PRIVATE STATE *
+make_state(int        partial_energy,
+           int        is_duplex,
+           subopt_env *env)
+{
+  STATE *state;
+
+  state = new_state_node(env);
+
+  memset(state->structure, '.', env->length);
+  state->structure[env->length] = '\0';
 
   state->partial_energy = partial_energy;
+  state->is_duplex      = is_duplex;
+  state->best_energy    = partial_energy;
 
   return state;
 }
 
 
 PRIVATE STATE *
-copy_state(STATE *state)
+copy_state(STATE      *state,
+           subopt_env *env)
 {
   STATE     *new_state;
   void      *after;
   INTERVAL  *new_interval, *next;
 
-  new_state                 = lst_newnode(sizeof(STATE));
-  new_state->Intervals      = lst_init();
+  new_state                 = new_state_node(env);
   new_state->partial_energy = state->partial_energy;
-  /* new_state->best_energy = state->best_energy; */
+  new_state->best_energy    = state->best_energy;
 
   if (state->Intervals->count) {
     after = LST_HEAD(new_state->Intervals);
     for (next = lst_first(state->Intervals); next; next = lst_next(next)) {
-      new_interval  = lst_newnode(sizeof(INTERVAL));
+      new_interval  = node_pool_get(&(env->intervals));
       *new_interval = *next;
       lst_insertafter(new_state->Intervals, new_interval, after);
       after = new_interval;
     }
   }
 
-  new_state->structure = strdup(state->structure);
-  if (!new_state->structure)
-    vrna_message_error("out of memory");
+  memcpy(new_state->structure, state->structure, env->length + 1);
 
   return new_state;
 }
@@ -874,7 +1145,7 @@ print_state(STATE *state)
   printf("partial structure: %s\n", state->structure);
   printf("\n");
   printf(" partial_energy: %d\n", state->partial_energy);
-  /* printf(" best_energy: %d\n", state->best_energy); */
+  printf(" best_energy: %d\n", state->best_energy);
   (void)fflush(stdout);
 }
 
@@ -947,7 +1218,7 @@ best_attainable_energy(vrna_fold_compound_t *fc,
   INTERVAL      *next;
   vrna_md_t     *md;
   vrna_mx_mfe_t *matrices;
-  int           *indx;
+  int           *indx, e, stack;
 
   md        = &(fc->params->model_details);
   matrices  = fc->matrices;
@@ -956,20 +1227,38 @@ best_attainable_energy(vrna_fold_compound_t *fc,
   sum = state->partial_energy;  /* energy of already found elements */
 
   for (next = lst_first(state->Intervals); next; next = lst_next(next)) {
-    if (next->array_flag == 0)
+    if (next->array_flag == 0) {
       sum += (md->circ) ? matrices->Fc : matrices->f5[next->j];
-    else if (next->array_flag == 1)
+    } else if (next->array_flag == 1) {
       sum += matrices->fML[indx[next->j] + next->i];
-    else if (next->array_flag == 2)
-      sum += matrices->c[indx[next->j] + next->i];
-    else if (next->array_flag == 3)
+    } else if (next->array_flag == 2) {
+      e = matrices->c[indx[next->j] + next->i];
+
+      /*
+       *  with --noLP, c[i,j] only covers (i,j) stacked onto (i + 1, j - 1).
+       *  Any other loop closed by (i,j) requires the stack (i - 1, j + 1),
+       *  and their best energy is contained in c[i - 1, j + 1] instead
+       */
+      if ((md->noLP) &&
+          (next->i > 1) &&
+          (next->j < (int)fc->length)) {
+        stack = matrices->c[indx[next->j + 1] + next->i - 1];
+        if (stack < INF) {
+          stack -= vrna_E_stack(fc, next->i - 1, next->j + 1);
+          e     = MIN2(e, stack);
+        }
+      }
+
+      sum += e;
+    } else if (next->array_flag == 3) {
       sum += matrices->fM1[indx[next->j] + next->i];
-    else if (next->array_flag == 4)
+    } else if (next->array_flag == 4) {
       sum += matrices->fms5[next->j][next->i];
-    else if (next->array_flag == 5)
+    } else if (next->array_flag == 5) {
       sum += matrices->fms3[next->j][next->i];
-    else if (next->array_flag == 6)
+    } else if (next->array_flag == 6) {
       sum += matrices->ggg[indx[next->j] + next->i];
+    }
   }
 
   return sum;
@@ -977,14 +1266,129 @@ best_attainable_energy(vrna_fold_compound_t *fc,
 
 
 PRIVATE void
-push_back(LIST  *Stack,
-          STATE *state)
+push_back(subopt_env  *env,
+          STATE       *state)
 {
-  push(Stack, copy_state(state));
+  push_state(env, copy_state(state, env));
   return;
 }
 
 
+PRIVATE void
+push_state(subopt_env *env,
+           STATE      *state)
+{
+  if (env->queue) {
+    state->best_energy = best_attainable_energy(env->fc, state);
+    vrna_heap_insert(env->queue, state);
+    if (env->evict)
+      vrna_heap_insert(env->evict, state);
+  } else {
+    push(env->Stack, state);
+  }
+}
+
+
+PRIVATE size_t
+subopt_memory(subopt_env *env)
+{
+  return env->states.in_use * (env->states.node_size + 2 * sizeof(void *)) +
+         env->intervals.in_use * env->intervals.node_size;
+}
+
+
+PRIVATE void
+evict_states(subopt_env *env,
+             size_t     max_memory,
+             int        *threshold)
+{
+  STATE *state;
+
+  /*
+   * Drop the states with highest best attainable energy until we are
+   * below the memory limit again. All structures at or above the lowest
+   * energy of the dropped states are incomplete from now on, so we
+   * lower the energy threshold and drop all other states above it too
+   */
+  while ((vrna_heap_size(env->queue) > 1) && (subopt_memory(env) > max_memory)) {
+    state = vrna_heap_pop(env->evict);
+    vrna_heap_remove(env->queue, state);
+
+    if (state->best_energy <= *threshold)
+      *threshold = state->best_energy - 1;
+
+    free_state_node(state, env);
+  }
+
+  while (((state = (STATE *)vrna_heap_top(env->evict))) &&
+         (state->best_energy > *threshold)) {
+    vrna_heap_pop(env->evict);
+    vrna_heap_remove(env->queue, state);
+    free_state_node(state, env);
+  }
+}
+
+
+PRIVATE int
+state_cmp(const void  *a,
+          const void  *b,
+          void        *data)
+{
+  const STATE *s1 = (const STATE *)a;
+  const STATE *s2 = (const STATE *)b;
+
+  if (s1->best_energy < s2->best_energy)
+    return -1;
+  else if (s1->best_energy > s2->best_energy)
+    return 1;
+
+  return 0;
+}
+
+
+PRIVATE int
+state_cmp_rev(const void  *a,
+              const void  *b,
+              void        *data)
+{
+  return state_cmp(b, a, data);
+}
+
+
+PRIVATE size_t
+state_get_queue_pos(const void  *a,
+                    void        *data)
+{
+  return ((const STATE *)a)->queue_pos;
+}
+
+
+PRIVATE void
+state_set_queue_pos(const void  *a,
+                    size_t      pos,
+                    void        *data)
+{
+  ((STATE *)a)->queue_pos = pos;
+}
+
+
+PRIVATE size_t
+state_get_evict_pos(const void  *a,
+                    void        *data)
+{
+  return ((const STATE *)a)->evict_pos;
+}
+
+
+PRIVATE void
+state_set_evict_pos(const void  *a,
+                    size_t      pos,
+                    void        *data)
+{
+  ((STATE *)a)->evict_pos = pos;
+}
+
+
 PRIVATE char *
 get_structure(STATE *state)
 {
@@ -1054,14 +1458,15 @@ make_output(vrna_subopt_solution_t  *SL,
 
 
 PRIVATE STATE *
-derive_new_state(int    i,
-                 int    j,
-                 STATE  *s,
-                 int    e,
-                 int    flag)
+derive_new_state(int         i,
+                 int         j,
+                 STATE       *s,
+                 int         e,
+                 int         flag,
+                 subopt_env  *env)
 {
-  STATE     *s_new  = copy_state(s);
-  INTERVAL  *ival   = make_interval(i, j, flag);
+  STATE     *s_new  = copy_state(s, env);
+  INTERVAL  *ival   = make_interval(i, j, flag, env);
 
   push(s_new->Intervals, ival);
 
@@ -1079,9 +1484,9 @@ fork_state(int        i,
            int        flag,
            subopt_env *env)
 {
-  STATE *s_new = derive_new_state(i, j, s, e, flag);
+  STATE *s_new = derive_new_state(i, j, s, e, flag, env);
 
-  push(env->Stack, s_new);
+  push_state(env, s_new);
   env->nopush = false;
 }
 
@@ -1095,11 +1500,11 @@ fork_int_state(int        i,
                int        e,
                subopt_env *env)
 {
-  STATE *s_new = derive_new_state(p, q, s, e, 2);
+  STATE *s_new = derive_new_state(p, q, s, e, 2, env);
 
   make_pair(i, j, s_new);
   make_pair(p, q, s_new);
-  push(env->Stack, s_new);
+  push_state(env, s_new);
   env->nopush = false;
 }
 
@@ -1113,10 +1518,10 @@ fork_state_pair(int         i,
 {
   STATE *new_state;
 
-  new_state = copy_state(s);
+  new_state = copy_state(s, env);
   make_pair(i, j, new_state);
   new_state->partial_energy += e;
-  push(env->Stack, new_state);
+  push_state(env, new_state);
   env->nopush = false;
 }
 
@@ -1134,9 +1539,9 @@ fork_two_states_pair(int        i,
   INTERVAL  *interval1, *interval2;
   STATE     *new_state;
 
-  new_state = copy_state(s);
-  interval1 = make_interval(i + 1, k - 1, flag1);
-  interval2 = make_interval(k, j - 1, flag2);
+  new_state = copy_state(s, env);
+  interval1 = make_interval(i + 1, k - 1, flag1, env);
+  interval2 = make_interval(k, j - 1, flag2, env);
   if (k - i < j - k) {
     /* push larger interval first */
     push(new_state->Intervals, interval1);
@@ -1149,7 +1554,7 @@ fork_two_states_pair(int        i,
   make_pair(i, j, new_state);
   new_state->partial_energy += e;
 
-  push(env->Stack, new_state);
+  push_state(env, new_state);
   env->nopush = false;
 }
 
@@ -1167,14 +1572,14 @@ fork_state_pair_interval(int        i,
   INTERVAL  *interval;
   STATE     *new_state;
 
-  new_state = copy_state(s);
-  interval  = make_interval(k, l, flag);
+  new_state = copy_state(s, env);
+  interval  = make_interval(k, l, flag, env);
   push(new_state->Intervals, interval);
 
   make_pair(i, j, new_state);
   new_state->partial_energy += e;
 
-  push(env->Stack, new_state);
+  push_state(env, new_state);
   env->nopush = false;
 }
 
@@ -1191,16 +1596,16 @@ fork_two_states_pair_ms(int         i,
   INTERVAL  *interval1, *interval2;
   STATE     *new_state;
 
-  new_state = copy_state(s);
-  interval1 = make_interval(i + 1, sn1, 4);
-  interval2 = make_interval(j - 1, sn2, 5);
+  new_state = copy_state(s, env);
+  interval1 = make_interval(i + 1, sn1, 4, env);
+  interval2 = make_interval(j - 1, sn2, 5, env);
   push(new_state->Intervals, interval1);
   push(new_state->Intervals, interval2);
 
   make_pair(i, j, new_state);
   new_state->partial_energy += e;
 
-  push(env->Stack, new_state);
+  push_state(env, new_state);
   env->nopush = false;
 }
 
@@ -1219,9 +1624,9 @@ fork_two_states(int         i,
   INTERVAL  *interval1, *interval2;
   STATE     *new_state;
 
-  new_state = copy_state(s);
-  interval1 = make_interval(i, j, flag1);
-  interval2 = make_interval(p, q, flag2);
+  new_state = copy_state(s, env);
+  interval1 = make_interval(i, j, flag1, env);
+  interval2 = make_interval(p, q, flag2, env);
 
   if ((j - i) < (q - p)) {
     push(new_state->Intervals, interval1);
@@ -1233,7 +1638,7 @@ fork_two_states(int         i,
 
   new_state->partial_energy += e;
 
-  push(env->Stack, new_state);
+  push_state(env, new_state);
   env->nopush = false;
 }
 
@@ -1290,7 +1695,7 @@ scan_interval(vrna_fold_compound_t  *fc,
   }
 
   if (env->nopush) {
-    push_back(env->Stack, state);
+    push_back(env, state);
     env->nopush = false;
   }
 }
@@ -1347,7 +1752,7 @@ scan_mb(vrna_fold_compound_t  *fc,
   if ((j < i + 1) &&
       (sn[i] == so[j])) {
     if (env->nopush) {
-      push_back(env->Stack, state);
+      push_back(env, state);
       env->nopush = false;
     }
 
@@ -1366,7 +1771,7 @@ scan_mb(vrna_fold_compound_t  *fc,
         element_energy = E_MLstem(0, -1, -1, P);
 
         if (fML[indx[k] + i] + ggg[indx[j] + k + 1] + element_energy + best_energy <= threshold) {
-          temp_state  = derive_new_state(i, k, state, 0, 1);
+          temp_state  = derive_new_state(i, k, state, 0, 1, env);
           env->nopush = false;
           repeat_gquad(fc,
                        k + 1,
@@ -1378,7 +1783,7 @@ scan_mb(vrna_fold_compound_t  *fc,
                        threshold,
                        env,
                        constraints_dat);
-          free_state_node(temp_state);
+          free_state_node(temp_state, env);
         }
       }
 
@@ -1409,7 +1814,7 @@ scan_mb(vrna_fold_compound_t  *fc,
           element_energy += sc_red_stem(k + 1, j, k + 1, j, sc_dat);
 
         if (fML[indx[k] + i] + c[k1j] + element_energy + best_energy <= threshold) {
-          temp_state  = derive_new_state(i, k, state, 0, 1);
+          temp_state  = derive_new_state(i, k, state, 0, 1, env);
           env->nopush = false;
           repeat(fc,
                  k + 1,
@@ -1421,7 +1826,7 @@ scan_mb(vrna_fold_compound_t  *fc,
                  threshold,
                  env,
                  constraints_dat);
-          free_state_node(temp_state);
+          free_state_node(temp_state, env);
         }
       }
     }
@@ -1549,7 +1954,7 @@ scan_m1(vrna_fold_compound_t  *fc,
   if ((j < i + 1) &&
       (sn[i] == so[j])) {
     if (env->nopush) {
-      push_back(env->Stack, state);
+      push_back(env, state);
       env->nopush = false;
     }
 
@@ -1657,7 +2062,7 @@ scan_pair(vrna_fold_compound_t  *fc,
   if ((j < i + 1) &&
       (sn[i] == sn[j])) {
     if (env->nopush) {
-      push_back(env->Stack, state);
+      push_back(env, state);
       env->nopush = false;
     }
 
@@ -1752,7 +2157,7 @@ scan_ext(vrna_fold_compound_t *fc,
     state->partial_energy += f5[j];
 
     if (env->nopush) {
-      push_back(env->Stack, state);
+      push_back(env, state);
       env->nopush = false;
     }
 
@@ -1784,7 +2189,7 @@ scan_ext(vrna_fold_compound_t *fc,
         element_energy += sc_decomp_stem(j, k - 1, k, sc_dat);
 
       if (f5[k - 1] + ggg[kj] + element_energy + best_energy <= threshold) {
-        temp_state  = derive_new_state(1, k - 1, state, 0, 0);
+        temp_state  = derive_new_state(1, k - 1, state, 0, 0, env);
         env->nopush = false;
         /* backtrace the quadruplex */
         repeat_gquad(fc,
@@ -1797,7 +2202,7 @@ scan_ext(vrna_fold_compound_t *fc,
                      threshold,
                      env,
                      constraints_dat);
-        free_state_node(temp_state);
+        free_state_node(temp_state, env);
       }
     }
 
@@ -1823,7 +2228,7 @@ scan_ext(vrna_fold_compound_t *fc,
         element_energy += sc_decomp_stem(j, k - 1, k, sc_dat);
 
       if (f5[k - 1] + c[kj] + element_energy + best_energy <= threshold) {
-        temp_state  = derive_new_state(1, k - 1, state, 0, 0);
+        temp_state  = derive_new_state(1, k - 1, state, 0, 0, env);
         env->nopush = false;
         repeat(fc,
                k,
@@ -1835,7 +2240,7 @@ scan_ext(vrna_fold_compound_t *fc,
                threshold,
                env,
                constraints_dat);
-        free_state_node(temp_state);
+        free_state_node(temp_state, env);
       }
     }
   }
@@ -1981,7 +2386,7 @@ scan_circular(vrna_fold_compound_t  *fc,
     state->partial_energy += Fc;
 
     if (env->nopush) {
-      push_back(env->Stack, state);
+      push_back(env, state);
       env->nopush = false;
     }
 
@@ -2007,9 +2412,9 @@ scan_circular(vrna_fold_compound_t  *fc,
     }
 
     if (tmp_en <= threshold) {
-      new_state                 = derive_new_state(1, 2, state, 0, 0);
+      new_state                 = derive_new_state(1, 2, state, 0, 0, env);
       new_state->partial_energy = 0;
-      push(env->Stack, new_state);
+      push_state(env, new_state);
       env->nopush = false;
     }
   }
@@ -2151,27 +2556,27 @@ scan_circular(vrna_fold_compound_t  *fc,
                  * we've (hopefully) found a valid decomposition of fM2 and therefor we have all
                  * three intervals for our new state to be pushed on stack R
                  */
-                new_state = copy_state(state);
+                new_state = copy_state(state, env);
 
                 /* first interval leads for search in fML array */
-                new_interval = make_interval(1, k, 1);
+                new_interval = make_interval(1, k, 1, env);
                 push(new_state->Intervals, new_interval);
                 env->nopush = false;
 
                 /* next, we have the first interval that has to be traced in fM1 */
-                new_interval = make_interval(k + 1, l, 3);
+                new_interval = make_interval(k + 1, l, 3, env);
                 push(new_state->Intervals, new_interval);
                 env->nopush = false;
 
                 /* and the last of our three intervals is also one to be traced within fM1 array... */
-                new_interval = make_interval(l + 1, j, 3);
+                new_interval = make_interval(l + 1, j, 3, env);
                 push(new_state->Intervals, new_interval);
                 env->nopush = false;
 
                 /* mmh, we add the energy for closing the multiloop now... */
                 new_state->partial_energy += P->MLclosing;
                 /* next we push our state onto the R stack */
-                push(env->Stack, new_state);
+                push_state(env, new_state);
                 env->nopush = false;
               }
             }
@@ -2243,7 +2648,7 @@ scan_fms5(vrna_fold_compound_t  *fc,
     state->partial_energy += fms5[strand][i];
 
     if (env->nopush) {
-      push_back(env->Stack, state);
+      push_back(env, state);
       env->nopush = false;
     }
 
@@ -2332,7 +2737,7 @@ scan_fms5(vrna_fold_compound_t  *fc,
         element_energy += sc_red_stem(i, k, i, k, sc_dat);
 
       if (fms5[strand][k + 1] + ggg[indx[k] + i] + element_energy + best_energy <= threshold) {
-        temp_state  = derive_new_state(k + 1, strand, state, 0, 4);
+        temp_state  = derive_new_state(k + 1, strand, state, 0, 4, env);
         env->nopush = false;
         repeat_gquad(fc,
                      i,
@@ -2344,7 +2749,7 @@ scan_fms5(vrna_fold_compound_t  *fc,
                      threshold,
                      env,
                      constraints_dat);
-        free_state_node(temp_state);
+        free_state_node(temp_state, env);
       }
     }
 
@@ -2372,7 +2777,7 @@ scan_fms5(vrna_fold_compound_t  *fc,
         element_energy += sc_red_stem(i, k, i, k, sc_dat);
 
       if (fms5[strand][k + 1] + c[indx[k] + i] + element_energy + best_energy <= threshold) {
-        temp_state  = derive_new_state(k + 1, strand, state, 0, 4);
+        temp_state  = derive_new_state(k + 1, strand, state, 0, 4, env);
         env->nopush = false;
         repeat(fc,
                i,
@@ -2384,7 +2789,7 @@ scan_fms5(vrna_fold_compound_t  *fc,
                threshold,
                env,
                constraints_dat);
-        free_state_node(temp_state);
+        free_state_node(temp_state, env);
       }
     }
   }
@@ -2447,7 +2852,7 @@ scan_fms3(vrna_fold_compound_t  *fc,
     state->partial_energy += fms3[strand][i];
 
     if (env->nopush) {
-      push_back(env->Stack, state);
+      push_back(env, state);
       env->nopush = false;
     }
 
@@ -2532,7 +2937,7 @@ scan_fms3(vrna_fold_compound_t  *fc,
         element_energy += sc_red_stem(k + 1, i, k + 1, i, sc_dat);
 
       if (fms3[strand][k] + ggg[indx[i] + k + 1] + element_energy + best_energy <= threshold) {
-        temp_state  = derive_new_state(k, strand, state, 0, 5);
+        temp_state  = derive_new_state(k, strand, state, 0, 5, env);
         env->nopush = false;
         repeat_gquad(fc,
                      k + 1,
@@ -2544,7 +2949,7 @@ scan_fms3(vrna_fold_compound_t  *fc,
                      threshold,
                      env,
                      constraints_dat);
-        free_state_node(temp_state);
+        free_state_node(temp_state, env);
       }
     }
 
@@ -2571,7 +2976,7 @@ scan_fms3(vrna_fold_compound_t  *fc,
         element_energy += sc_red_stem(k + 1, i, k + 1, i, sc_dat);
 
       if (fms3[strand][k] + c[indx[i] + k + 1] + element_energy + best_energy <= threshold) {
-        temp_state  = derive_new_state(k, strand, state, 0, 5);
+        temp_state  = derive_new_state(k, strand, state, 0, 5, env);
         env->nopush = false;
         repeat(fc,
                k + 1,
@@ -2583,7 +2988,7 @@ scan_fms3(vrna_fold_compound_t  *fc,
                threshold,
                env,
                constraints_dat);
-        free_state_node(temp_state);
+        free_state_node(temp_state, env);
       }
     }
   }
@@ -2664,14 +3069,14 @@ repeat_gquad(vrna_fold_compound_t *fc,
       get_gquad_pattern_exhaustive(S1, i, j, P, L, l, threshold - best_energy);
 
       for (cnt = 0; L[cnt] != -1; cnt++) {
-        new_state = copy_state(state);
+        new_state = copy_state(state, env);
         make_gquad(i, L[cnt], &(l[3 * cnt]), new_state);
         new_state->partial_energy += part_energy;
         /* re-compute energies */
         new_state->partial_energy += E_gquad(L[cnt], &(l[3*cnt]), P);
         /* new_state->best_energy =
          * hairpin[unpaired] + element_energy + best_energy; */
-        push(env->Stack, new_state);
+        push_state(env, new_state);
         env->nopush = false;
       }
       free(L);
@@ -2791,12 +3196,12 @@ repeat(vrna_fold_compound_t *fc,
                               sc_dat_int);
       }
 
-      new_state = derive_new_state(i + 1, j - 1, state, part_energy + energy, 2);
+      new_state = derive_new_state(i + 1, j - 1, state, part_energy + energy, 2, env);
       make_pair(i, j, new_state);
       make_pair(i + 1, j - 1, new_state);
 
       /* new_state->best_energy = new + best_energy; */
-      push(env->Stack, new_state);
+      push_state(env, new_state);
       env->nopush = false;
       if (i == 1 || state->structure[i - 2] != '(' || state->structure[j] != ')')
         /* adding a stack is the only possible structure */
@@ -3033,12 +3438,12 @@ repeat(vrna_fold_compound_t *fc,
           if (sc_int_pair)
             tmp_en += sc_int_pair(i, j, ps[cnt], qs[cnt], sc_dat_int);
 
-          new_state = derive_new_state(ps[cnt], qs[cnt], state, tmp_en + part_energy, 6);
+          new_state = derive_new_state(ps[cnt], qs[cnt], state, tmp_en + part_energy, 6, env);
 
           make_pair(i, j, new_state);
 
           /* new_state->best_energy = new + best_energy; */
-          push(env->Stack, new_state);
+          push_state(env, new_state);
           env->nopush = false;
         }
       }
@@ -3215,7 +3620,7 @@ wrap_subopt(char          *string,
 
   if (parameters) {
     /* replace params if necessary */
-    free(fc->params);
+    vrna_params_free(fc->params);
     fc->params = P;
   } else {
     free(P);
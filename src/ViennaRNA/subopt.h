@@ -170,6 +170,45 @@ vrna_subopt_cb(vrna_fold_compound_t *fc,
                void                 *data);
 
 
+/**
+ *  @brief  Generate suboptimal structures in order of increasing free energy with bounded memory
+ *
+ *  Same as vrna_subopt_cb(), but the partial structures are processed in order of
+ *  their best attainable free energy rather than depth-first. As a consequence,
+ *  the callback @p cb receives the structures in ascending order of their free
+ *  energy as they are generated, without storing and sorting the entire set of
+ *  suboptimal structures first. The order of degenerate structures is arbitrary.
+ *
+ *  The memory occupied by the partial structures may be limited by @p max_memory.
+ *  Whenever this limit is exceeded, the partial structures with the highest
+ *  attainable free energy are discarded and the energy band is narrowed down
+ *  accordingly, such that all structures that are passed to the callback still
+ *  form the complete set of structures within the (narrowed) energy band. The
+ *  actual energy band is returned.
+ *
+ *  @ingroup subopt_wuchty
+ *
+ *  @note The order is determined by the free energies of the recursions, i.e. the
+ *        energies are not strictly ascending if they require re-evaluation, e.g.
+ *        for #vrna_md_t.logML != 0 or #vrna_md_t.dangles = 1 or 3.
+ *
+ *  @see vrna_subopt_cb(), vrna_subopt_result_f
+ *
+ *  @param  fc          fold compount with the sequence data
+ *  @param  delta       Energy band arround the MFE in 10cal/mol, i.e. deka-calories
+ *  @param  max_memory  Approximate memory limit for the partial structures in bytes (0 for no limit)
+ *  @param  cb          Pointer to a callback function that handles the backtracked structure and its free energy in kcal/mol
+ *  @param  data        Pointer to some data structure that is passed along to the callback
+ *  @return             The energy band in 10cal/mol that has been enumerated completely
+ */
+int
+vrna_subopt_sorted_cb(vrna_fold_compound_t  *fc,
+                      int                   delta,
+                      size_t                max_memory,
+                      vrna_subopt_result_f  cb,
+                      void                  *data);
+
+
 /**
  *  @brief printing threshold for use with logML
  *
@@ -121,6 +121,10 @@ vrna_subopt_zuker(vrna_fold_compound_t *fc)
   sol = NULL;
 
   if (fc) {
+    /* the recursions below address the MFE matrices via jindx, i.e. tiled matrices won't do */
+    if ((fc->matrices) && (fc->matrices->type == VRNA_MX_TILED))
+      vrna_mx_mfe_free(fc);
+
     (void)vrna_mfe(fc, NULL);
 
     n             = fc->length;
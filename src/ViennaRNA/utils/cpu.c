@@ -13,6 +13,10 @@
 #include <stdint.h>
 #include <string.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "ViennaRNA/utils/basic.h"
 #include "ViennaRNA/utils/cpu.h"
 
@@ -90,6 +94,20 @@ vrna_cpu_simd_capabilities(void)
 }
 
 
+PUBLIC int
+vrna_cpu_threads(int num_threads)
+{
+#ifdef _OPENMP
+  if (num_threads <= 0)
+    num_threads = omp_get_max_threads();
+
+  return num_threads;
+#else
+  return 1;
+#endif
+}
+
+
 /*
  #################################
  # STATIC helper functions below #
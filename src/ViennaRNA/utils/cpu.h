@@ -19,4 +19,13 @@ unsigned int
 vrna_cpu_simd_capabilities(void);
 
 
+/*
+ *  Number of threads to use for a parallel computation. Non-positive
+ *  values select the OpenMP default, and 1 is returned whenever the
+ *  library has been built without OpenMP support
+ */
+int
+vrna_cpu_threads(int num_threads);
+
+
 #endif
@@ -8,6 +8,9 @@
 
 #include "ViennaRNA/utils/basic.h"
 #include "ViennaRNA/utils/cpu.h"
+#include "ViennaRNA/params/default.h"
+#include "ViennaRNA/constraints/hard.h"
+#include "ViennaRNA/utils/higher_order_functions.h"
 
 
 typedef int (*proto_fun_zip_reduce)(const int  *a,
@@ -15,23 +18,112 @@ typedef int (*proto_fun_zip_reduce)(const int  *a,
                                     int        size);
 
 
+typedef int (*proto_fun_zip_reduce_masked)(const int            *a,
+                                           const int            *b,
+                                           const unsigned char  *mask,
+                                           int                  size);
+
+
+typedef FLT_OR_DBL (*proto_fun_zip_reduce_pf)(const FLT_OR_DBL *a,
+                                              const FLT_OR_DBL *b,
+                                              int              size);
+
+
+typedef int (*proto_fun_int_loop_min)(const int           *c,
+                                      const char          *ptype,
+                                      const unsigned char *hc,
+                                      const short         *S,
+                                      int                 u1,
+                                      int                 u2,
+                                      int                 sq,
+                                      int                 count,
+                                      vrna_param_t        *P);
+
+
 /*
  #################################
  # PRIVATE FUNCTION DECLARATIONS #
  #################################
  */
+static void
+dispatch(void);
+
+
 static int
 zip_add_min_dispatcher(const int  *a,
                        const int  *b,
                        int        size);
 
 
+static int
+zip_add_min_masked_dispatcher(const int           *a,
+                              const int           *b,
+                              const unsigned char *mask,
+                              int                 size);
+
+
+static FLT_OR_DBL
+zip_mult_sum_dispatcher(const FLT_OR_DBL  *a,
+                        const FLT_OR_DBL  *b,
+                        int               size);
+
+
+static FLT_OR_DBL
+zip_mult_sum_rev_dispatcher(const FLT_OR_DBL  *a,
+                            const FLT_OR_DBL  *b,
+                            int               size);
+
+
+static int
+int_loop_min_dispatcher(const int           *c,
+                        const char          *ptype,
+                        const unsigned char *hc,
+                        const short         *S,
+                        int                 u1,
+                        int                 u2,
+                        int                 sq,
+                        int                 count,
+                        vrna_param_t        *P);
+
+
 static int
 fun_zip_add_min_default(const int *e1,
                         const int *e2,
                         int       count);
 
 
+static int
+fun_zip_add_min_masked_default(const int            *e1,
+                               const int            *e2,
+                               const unsigned char  *mask,
+                               int                  count);
+
+
+static FLT_OR_DBL
+fun_zip_mult_sum_default(const FLT_OR_DBL *e1,
+                         const FLT_OR_DBL *e2,
+                         int              count);
+
+
+static FLT_OR_DBL
+fun_zip_mult_sum_rev_default(const FLT_OR_DBL *e1,
+                             const FLT_OR_DBL *e2,
+                             int              count);
+
+
+/* scalar kernel, also used by the SIMD variants for the remaining elements */
+int
+vrna_fun_int_loop_min_scalar(const int            *c,
+                             const char           *ptype,
+                             const unsigned char  *hc,
+                             const short          *S,
+                             int                  u1,
+                             int                  u2,
+                             int                  sq,
+                             int                  count,
+                             vrna_param_t         *P);
+
+
 #if VRNA_WITH_SIMD_AVX512
 int
 vrna_fun_zip_add_min_avx512(const int *e1,
@@ -39,6 +131,77 @@ vrna_fun_zip_add_min_avx512(const int *e1,
                             int       count);
 
 
+int
+vrna_fun_zip_add_min_masked_avx512(const int            *e1,
+                                   const int            *e2,
+                                   const unsigned char  *mask,
+                                   int                  count);
+
+
+FLT_OR_DBL
+vrna_fun_zip_mult_sum_avx512(const FLT_OR_DBL *e1,
+                             const FLT_OR_DBL *e2,
+                             int              count);
+
+
+FLT_OR_DBL
+vrna_fun_zip_mult_sum_rev_avx512(const FLT_OR_DBL *e1,
+                                 const FLT_OR_DBL *e2,
+                                 int              count);
+
+
+int
+vrna_fun_int_loop_min_avx512(const int            *c,
+                             const char           *ptype,
+                             const unsigned char  *hc,
+                             const short          *S,
+                             int                  u1,
+                             int                  u2,
+                             int                  sq,
+                             int                  count,
+                             vrna_param_t         *P);
+
+
+#endif
+
+#if VRNA_WITH_SIMD_AVX2
+int
+vrna_fun_zip_add_min_avx2(const int *e1,
+                          const int *e2,
+                          int       count);
+
+
+int
+vrna_fun_zip_add_min_masked_avx2(const int            *e1,
+                                 const int            *e2,
+                                 const unsigned char  *mask,
+                                 int                  count);
+
+
+FLT_OR_DBL
+vrna_fun_zip_mult_sum_avx2(const FLT_OR_DBL *e1,
+                           const FLT_OR_DBL *e2,
+                           int              count);
+
+
+FLT_OR_DBL
+vrna_fun_zip_mult_sum_rev_avx2(const FLT_OR_DBL *e1,
+                               const FLT_OR_DBL *e2,
+                               int              count);
+
+
+int
+vrna_fun_int_loop_min_avx2(const int            *c,
+                           const char           *ptype,
+                           const unsigned char  *hc,
+                           const short          *S,
+                           int                  u1,
+                           int                  u2,
+                           int                  sq,
+                           int                  count,
+                           vrna_param_t         *P);
+
+
 #endif
 
 #if VRNA_WITH_SIMD_SSE41
@@ -48,10 +211,45 @@ vrna_fun_zip_add_min_sse41(const int  *e1,
                            int        count);
 
 
+int
+vrna_fun_zip_add_min_masked_sse41(const int           *e1,
+                                  const int           *e2,
+                                  const unsigned char *mask,
+                                  int                 count);
+
+
+FLT_OR_DBL
+vrna_fun_zip_mult_sum_sse41(const FLT_OR_DBL  *e1,
+                            const FLT_OR_DBL  *e2,
+                            int               count);
+
+
+FLT_OR_DBL
+vrna_fun_zip_mult_sum_rev_sse41(const FLT_OR_DBL  *e1,
+                                const FLT_OR_DBL  *e2,
+                                int               count);
+
+
+int
+vrna_fun_int_loop_min_sse41(const int           *c,
+                            const char          *ptype,
+                            const unsigned char *hc,
+                            const short         *S,
+                            int                 u1,
+                            int                 u2,
+                            int                 sq,
+                            int                 count,
+                            vrna_param_t        *P);
+
+
 #endif
 
 
-static proto_fun_zip_reduce fun_zip_add_min = &zip_add_min_dispatcher;
+static proto_fun_zip_reduce         fun_zip_add_min         = &zip_add_min_dispatcher;
+static proto_fun_zip_reduce_masked  fun_zip_add_min_masked  = &zip_add_min_masked_dispatcher;
+static proto_fun_zip_reduce_pf      fun_zip_mult_sum        = &zip_mult_sum_dispatcher;
+static proto_fun_zip_reduce_pf      fun_zip_mult_sum_rev    = &zip_mult_sum_rev_dispatcher;
+static proto_fun_int_loop_min       fun_int_loop_min        = &int_loop_min_dispatcher;
 
 
 /*
@@ -62,14 +260,22 @@ static proto_fun_zip_reduce fun_zip_add_min = &zip_add_min_dispatcher;
 PUBLIC void
 vrna_fun_dispatch_disable(void)
 {
-  fun_zip_add_min = &fun_zip_add_min_default;
+  fun_zip_add_min         = &fun_zip_add_min_default;
+  fun_zip_add_min_masked  = &fun_zip_add_min_masked_default;
+  fun_zip_mult_sum        = &fun_zip_mult_sum_default;
+  fun_zip_mult_sum_rev    = &fun_zip_mult_sum_rev_default;
+  fun_int_loop_min        = &vrna_fun_int_loop_min_scalar;
 }
 
 
 PUBLIC void
 vrna_fun_dispatch_enable(void)
 {
-  fun_zip_add_min = &zip_add_min_dispatcher;
+  fun_zip_add_min         = &zip_add_min_dispatcher;
+  fun_zip_add_min_masked  = &zip_add_min_masked_dispatcher;
+  fun_zip_mult_sum        = &zip_mult_sum_dispatcher;
+  fun_zip_mult_sum_rev    = &zip_mult_sum_rev_dispatcher;
+  fun_int_loop_min        = &int_loop_min_dispatcher;
 }
 
 
@@ -82,44 +288,168 @@ vrna_fun_zip_add_min(const int  *e1,
 }
 
 
+PUBLIC int
+vrna_fun_zip_add_min_masked(const int           *e1,
+                            const int           *e2,
+                            const unsigned char *mask,
+                            int                 count)
+{
+  return (*fun_zip_add_min_masked)(e1, e2, mask, count);
+}
+
+
+PUBLIC FLT_OR_DBL
+vrna_fun_zip_mult_sum(const FLT_OR_DBL  *e1,
+                      const FLT_OR_DBL  *e2,
+                      int               count)
+{
+  return (*fun_zip_mult_sum)(e1, e2, count);
+}
+
+
+PUBLIC FLT_OR_DBL
+vrna_fun_zip_mult_sum_rev(const FLT_OR_DBL  *e1,
+                          const FLT_OR_DBL  *e2,
+                          int               count)
+{
+  return (*fun_zip_mult_sum_rev)(e1, e2, count);
+}
+
+
+PUBLIC int
+vrna_fun_int_loop_min(const int           *c,
+                      const char          *ptype,
+                      const unsigned char *hc,
+                      const short         *S,
+                      int                 u1,
+                      int                 u2,
+                      int                 sq,
+                      int                 count,
+                      vrna_param_t        *P)
+{
+  return (*fun_int_loop_min)(c, ptype, hc, S, u1, u2, sq, count, P);
+}
+
+
 /*
  #################################
  # STATIC helper functions below #
  #################################
  */
 
-/* zip_add_min() dispatcher */
-static int
-zip_add_min_dispatcher(const int  *a,
-                       const int  *b,
-                       int        size)
+/* select the best implementations available on the current CPU */
+static void
+dispatch(void)
 {
   unsigned int features = vrna_cpu_simd_capabilities();
 
 #if VRNA_WITH_SIMD_AVX512
   if (features & VRNA_CPU_SIMD_AVX512F) {
-    fun_zip_add_min = &vrna_fun_zip_add_min_avx512;
-    goto exec_fun_zip_add_min;
+    fun_zip_add_min         = &vrna_fun_zip_add_min_avx512;
+    fun_zip_add_min_masked  = &vrna_fun_zip_add_min_masked_avx512;
+    fun_zip_mult_sum        = &vrna_fun_zip_mult_sum_avx512;
+    fun_zip_mult_sum_rev    = &vrna_fun_zip_mult_sum_rev_avx512;
+    fun_int_loop_min        = &vrna_fun_int_loop_min_avx512;
+    return;
+  }
+
+#endif
+
+#if VRNA_WITH_SIMD_AVX2
+  if (features & VRNA_CPU_SIMD_AVX2) {
+    fun_zip_add_min         = &vrna_fun_zip_add_min_avx2;
+    fun_zip_add_min_masked  = &vrna_fun_zip_add_min_masked_avx2;
+    fun_zip_mult_sum        = &vrna_fun_zip_mult_sum_avx2;
+    fun_zip_mult_sum_rev    = &vrna_fun_zip_mult_sum_rev_avx2;
+    fun_int_loop_min        = &vrna_fun_int_loop_min_avx2;
+    return;
   }
 
 #endif
 
 #if VRNA_WITH_SIMD_SSE41
   if (features & VRNA_CPU_SIMD_SSE41) {
-    fun_zip_add_min = &vrna_fun_zip_add_min_sse41;
-    goto exec_fun_zip_add_min;
+    fun_zip_add_min         = &vrna_fun_zip_add_min_sse41;
+    fun_zip_add_min_masked  = &vrna_fun_zip_add_min_masked_sse41;
+    fun_zip_mult_sum        = &vrna_fun_zip_mult_sum_sse41;
+    fun_zip_mult_sum_rev    = &vrna_fun_zip_mult_sum_rev_sse41;
+    fun_int_loop_min        = &vrna_fun_int_loop_min_sse41;
+    return;
   }
 
 #endif
 
-  fun_zip_add_min = &fun_zip_add_min_default;
+  vrna_fun_dispatch_disable();
+}
+
 
-exec_fun_zip_add_min:
+/* zip_add_min() dispatcher */
+static int
+zip_add_min_dispatcher(const int  *a,
+                       const int  *b,
+                       int        size)
+{
+  dispatch();
 
   return (*fun_zip_add_min)(a, b, size);
 }
 
 
+/* zip_add_min_masked() dispatcher */
+static int
+zip_add_min_masked_dispatcher(const int           *a,
+                              const int           *b,
+                              const unsigned char *mask,
+                              int                 size)
+{
+  dispatch();
+
+  return (*fun_zip_add_min_masked)(a, b, mask, size);
+}
+
+
+/* zip_mult_sum() dispatcher */
+static FLT_OR_DBL
+zip_mult_sum_dispatcher(const FLT_OR_DBL  *a,
+                        const FLT_OR_DBL  *b,
+                        int               size)
+{
+  dispatch();
+
+  return (*fun_zip_mult_sum)(a, b, size);
+}
+
+
+/* zip_mult_sum_rev() dispatcher */
+static FLT_OR_DBL
+zip_mult_sum_rev_dispatcher(const FLT_OR_DBL  *a,
+                            const FLT_OR_DBL  *b,
+                            int               size)
+{
+  dispatch();
+
+  return (*fun_zip_mult_sum_rev)(a, b, size);
+}
+
+
+/* int_loop_min() dispatcher */
+static int
+int_loop_min_dispatcher(const int           *c,
+                        const char          *ptype,
+                        const unsigned char *hc,
+                        const short         *S,
+                        int                 u1,
+                        int                 u2,
+                        int                 sq,
+                        int                 count,
+                        vrna_param_t        *P)
+{
+  dispatch();
+
+  return (*fun_int_loop_min)(c, ptype, hc, S, u1, u2, sq, count, P);
+}
+
+
 static int
 fun_zip_add_min_default(const int *e1,
                         const int *e2,
@@ -137,3 +467,94 @@ fun_zip_add_min_default(const int *e1,
 
   return decomp;
 }
+
+
+static int
+fun_zip_add_min_masked_default(const int            *e1,
+                               const int            *e2,
+                               const unsigned char  *mask,
+                               int                  count)
+{
+  int i;
+  int decomp = INF;
+
+  for (i = 0; i < count; i++) {
+    if ((mask[i]) && (e1[i] != INF) && (e2[i] != INF)) {
+      const int en = e1[i] + e2[i];
+      decomp = MIN2(decomp, en);
+    }
+  }
+
+  return decomp;
+}
+
+
+static FLT_OR_DBL
+fun_zip_mult_sum_default(const FLT_OR_DBL *e1,
+                         const FLT_OR_DBL *e2,
+                         int              count)
+{
+  int         i;
+  FLT_OR_DBL  sum = 0.;
+
+  for (i = 0; i < count; i++)
+    sum += e1[i] * e2[i];
+
+  return sum;
+}
+
+
+static FLT_OR_DBL
+fun_zip_mult_sum_rev_default(const FLT_OR_DBL *e1,
+                             const FLT_OR_DBL *e2,
+                             int              count)
+{
+  int         i;
+  FLT_OR_DBL  sum = 0.;
+
+  for (i = 0; i < count; i++)
+    sum += e1[-i] * e2[i];
+
+  return sum;
+}
+
+
+PUBLIC int
+vrna_fun_int_loop_min_scalar(const int            *c,
+                             const char           *ptype,
+                             const unsigned char  *hc,
+                             const short          *S,
+                             int                  u1,
+                             int                  u2,
+                             int                  sq,
+                             int                  count,
+                             vrna_param_t         *P)
+{
+  int t, type2, u, e, decomp, noGUclosure, *rtype, (*mismatch)[5][5];
+
+  decomp      = INF;
+  noGUclosure = P->model_details.noGUclosure;
+  rtype       = &(P->model_details.rtype[0]);
+  mismatch    = (u2 == 1) ? P->mismatch1nI : P->mismatchI;
+
+  for (t = 0; t < count; t++, u1++) {
+    if ((hc[t] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) &&
+        (c[t] < INF)) {
+      /* no pair (type 0) is treated as non-standard pair, see vrna_get_ptype() */
+      type2 = rtype[(ptype[t]) ? (unsigned char)ptype[t] : 7];
+
+      if ((noGUclosure) && (type2 == 3 || type2 == 4))
+        continue;
+
+      u = (u1 > u2) ? u1 - u2 : u2 - u1;
+      e = c[t] +
+          P->internal_loop[u1 + u2] +
+          MIN2(MAX_NINIO, u * P->ninio[2]) +
+          mismatch[type2][sq][S[t]];
+
+      decomp = MIN2(decomp, e);
+    }
+  }
+
+  return decomp;
+}
@@ -1,6 +1,8 @@
 #ifndef VIENNA_RNA_PACKAGE_UTILS_FUN_H
 #define VIENNA_RNA_PACKAGE_UTILS_FUN_H
 
+#include <ViennaRNA/params/basic.h>
+
 void
 vrna_fun_dispatch_disable(void);
 
@@ -9,10 +11,64 @@ void
 vrna_fun_dispatch_enable(void);
 
 
+/*
+ *  Minimum of e1[i] + e2[i] over all i < count where neither value is INF
+ */
 int
 vrna_fun_zip_add_min(const int  *e1,
                      const int  *e2,
                      int        count);
 
 
+/*
+ *  Same as vrna_fun_zip_add_min() but restricted to those i where mask[i]
+ *  is non-zero, e.g. decompositions that pass the hard constraints
+ */
+int
+vrna_fun_zip_add_min_masked(const int           *e1,
+                            const int           *e2,
+                            const unsigned char *mask,
+                            int                 count);
+
+
+/*
+ *  Sum of e1[i] * e2[i] over all i < count
+ */
+FLT_OR_DBL
+vrna_fun_zip_mult_sum(const FLT_OR_DBL  *e1,
+                      const FLT_OR_DBL  *e2,
+                      int               count);
+
+
+/*
+ *  Sum of e1[-i] * e2[i] over all i < count, i.e. e1 is read backwards as
+ *  required for rows of matrices addressed via vrna_fold_compound_t.iindx
+ */
+FLT_OR_DBL
+vrna_fun_zip_mult_sum_rev(const FLT_OR_DBL  *e1,
+                          const FLT_OR_DBL  *e2,
+                          int               count);
+
+
+/*
+ *  Minimum over a row of interior loops (i,j,k,l) with fixed l, i.e.
+ *  fixed 3' unpaired size u2, and k = k0, ..., k0 + count - 1, i.e. 5'
+ *  unpaired sizes u1, ..., u1 + count - 1. The arrays c, ptype, hc, and
+ *  S must point to the entries of (k0,l) and nucleotide k0 - 1. The
+ *  mismatch energy of the enclosing pair is not included. All loops in
+ *  the row must be either generic interior loops or 1xn loops (u2 == 1),
+ *  i.e. the special cases of E_IntLoop() must be handled by the caller.
+ */
+int
+vrna_fun_int_loop_min(const int           *c,
+                      const char          *ptype,
+                      const unsigned char *hc,
+                      const short         *S,
+                      int                 u1,
+                      int                 u2,
+                      int                 sq,
+                      int                 count,
+                      vrna_param_t        *P);
+
+
 #endif
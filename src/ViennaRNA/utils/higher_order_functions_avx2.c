@@ -0,0 +1,273 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/params/default.h"
+#include "ViennaRNA/constraints/hard.h"
+#include "ViennaRNA/utils/higher_order_functions.h"
+
+#include <immintrin.h>
+
+#ifdef USE_FLOAT_PF
+# define PF_VEC           __m256
+# define PF_WIDTH         8
+# define PF_ZERO()        _mm256_setzero_ps()
+# define PF_LOAD(p)       _mm256_loadu_ps(p)
+# define PF_STORE(p, x)   _mm256_storeu_ps((p), (x))
+# define PF_ADD(x, y)     _mm256_add_ps((x), (y))
+# define PF_MUL(x, y)     _mm256_mul_ps((x), (y))
+# define PF_REVERSE(x)    _mm256_permutevar8x32_ps((x), _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0))
+#else
+# define PF_VEC           __m256d
+# define PF_WIDTH         4
+# define PF_ZERO()        _mm256_setzero_pd()
+# define PF_LOAD(p)       _mm256_loadu_pd(p)
+# define PF_STORE(p, x)   _mm256_storeu_pd((p), (x))
+# define PF_ADD(x, y)     _mm256_add_pd((x), (y))
+# define PF_MUL(x, y)     _mm256_mul_pd((x), (y))
+# define PF_REVERSE(x)    _mm256_permute4x64_pd((x), _MM_SHUFFLE(0, 1, 2, 3))
+#endif
+
+
+static int
+horizontal_min_Vec8i(__m256i x);
+
+
+int
+vrna_fun_int_loop_min_scalar(const int            *c,
+                             const char           *ptype,
+                             const unsigned char  *hc,
+                             const short          *S,
+                             int                  u1,
+                             int                  u2,
+                             int                  sq,
+                             int                  count,
+                             vrna_param_t         *P);
+
+
+PUBLIC int
+vrna_fun_zip_add_min_avx2(const int *e1,
+                          const int *e2,
+                          int       count)
+{
+  int     i       = 0;
+  int     decomp  = INF;
+
+  __m256i inf   = _mm256_set1_epi32(INF);
+  __m256i minv  = inf;
+
+  for (i = 0; i < count - 7; i += 8) {
+    __m256i a = _mm256_loadu_si256((__m256i *)&e1[i]);
+    __m256i b = _mm256_loadu_si256((__m256i *)&e2[i]);
+
+    /* create mask for non-INF values */
+    __m256i mask = _mm256_and_si256(_mm256_cmpgt_epi32(inf, a),
+                                    _mm256_cmpgt_epi32(inf, b));
+
+    /* keep INF where a or b has been INF before */
+    minv = _mm256_min_epi32(minv,
+                            _mm256_blendv_epi8(inf, _mm256_add_epi32(a, b), mask));
+  }
+
+  decomp = horizontal_min_Vec8i(minv);
+
+  for (; i < count; i++) {
+    if ((e1[i] != INF) && (e2[i] != INF)) {
+      const int en = e1[i] + e2[i];
+      decomp = MIN2(decomp, en);
+    }
+  }
+
+  return decomp;
+}
+
+
+PUBLIC int
+vrna_fun_zip_add_min_masked_avx2(const int            *e1,
+                                 const int            *e2,
+                                 const unsigned char  *mask,
+                                 int                  count)
+{
+  int     i       = 0;
+  int     decomp  = INF;
+
+  __m256i inf   = _mm256_set1_epi32(INF);
+  __m256i zero  = _mm256_setzero_si256();
+  __m256i minv  = inf;
+
+  for (i = 0; i < count - 7; i += 8) {
+    __m256i a = _mm256_loadu_si256((__m256i *)&e1[i]);
+    __m256i b = _mm256_loadu_si256((__m256i *)&e2[i]);
+    __m256i m = _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i *)&mask[i]));
+
+    /* create mask for allowed decompositions with non-INF values */
+    m = _mm256_andnot_si256(_mm256_cmpeq_epi32(m, zero),
+                            _mm256_and_si256(_mm256_cmpgt_epi32(inf, a),
+                                             _mm256_cmpgt_epi32(inf, b)));
+
+    minv = _mm256_min_epi32(minv,
+                            _mm256_blendv_epi8(inf, _mm256_add_epi32(a, b), m));
+  }
+
+  decomp = horizontal_min_Vec8i(minv);
+
+  for (; i < count; i++) {
+    if ((mask[i]) && (e1[i] != INF) && (e2[i] != INF)) {
+      const int en = e1[i] + e2[i];
+      decomp = MIN2(decomp, en);
+    }
+  }
+
+  return decomp;
+}
+
+
+PUBLIC FLT_OR_DBL
+vrna_fun_zip_mult_sum_avx2(const FLT_OR_DBL *e1,
+                           const FLT_OR_DBL *e2,
+                           int              count)
+{
+  int         i, k;
+  FLT_OR_DBL  sum, lanes[PF_WIDTH];
+  PF_VEC      acc = PF_ZERO();
+
+  for (i = 0; i < count - (PF_WIDTH - 1); i += PF_WIDTH)
+    acc = PF_ADD(acc, PF_MUL(PF_LOAD(e1 + i), PF_LOAD(e2 + i)));
+
+  PF_STORE(lanes, acc);
+
+  for (sum = 0., k = 0; k < PF_WIDTH; k++)
+    sum += lanes[k];
+
+  for (; i < count; i++)
+    sum += e1[i] * e2[i];
+
+  return sum;
+}
+
+
+PUBLIC FLT_OR_DBL
+vrna_fun_zip_mult_sum_rev_avx2(const FLT_OR_DBL *e1,
+                               const FLT_OR_DBL *e2,
+                               int              count)
+{
+  int         i, k;
+  FLT_OR_DBL  sum, lanes[PF_WIDTH];
+  PF_VEC      acc = PF_ZERO();
+
+  for (i = 0; i < count - (PF_WIDTH - 1); i += PF_WIDTH)
+    acc = PF_ADD(acc, PF_MUL(PF_REVERSE(PF_LOAD(e1 - i - (PF_WIDTH - 1))), PF_LOAD(e2 + i)));
+
+  PF_STORE(lanes, acc);
+
+  for (sum = 0., k = 0; k < PF_WIDTH; k++)
+    sum += lanes[k];
+
+  for (; i < count; i++)
+    sum += e1[-i] * e2[i];
+
+  return sum;
+}
+
+
+PUBLIC int
+vrna_fun_int_loop_min_avx2(const int            *c,
+                           const char           *ptype,
+                           const unsigned char  *hc,
+                           const short          *S,
+                           int                  u1,
+                           int                  u2,
+                           int                  sq,
+                           int                  count,
+                           vrna_param_t         *P)
+{
+  int     t, decomp, noGUclosure, *rtype, *mismatch;
+
+  noGUclosure = P->model_details.noGUclosure;
+  rtype       = &(P->model_details.rtype[0]);
+  mismatch    = (u2 == 1) ? &(P->mismatch1nI[0][sq][0]) : &(P->mismatchI[0][sq][0]);
+
+  __m256i inf     = _mm256_set1_epi32(INF);
+  __m256i zero    = _mm256_setzero_si256();
+  __m256i nonstd  = _mm256_set1_epi32(7);
+  __m256i enc     = _mm256_set1_epi32(VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC);
+  __m256i ninio   = _mm256_set1_epi32(P->ninio[2]);
+  __m256i ninio_m = _mm256_set1_epi32(MAX_NINIO);
+  __m256i stride  = _mm256_set1_epi32(25);
+  __m256i gu      = _mm256_set1_epi32(3);
+  __m256i ug      = _mm256_set1_epi32(4);
+  __m256i eight   = _mm256_set1_epi32(8);
+  __m256i u       = _mm256_add_epi32(_mm256_set1_epi32(u1 - u2),
+                                     _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+  __m256i minv = inf;
+
+  for (t = 0; t < count - 7; t += 8) {
+    __m256i cv  = _mm256_loadu_si256((__m256i *)&c[t]);
+    __m256i il  = _mm256_loadu_si256((__m256i *)&(P->internal_loop[u1 + u2 + t]));
+    __m256i pt  = _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i *)&ptype[t]));
+    __m256i sp  = _mm256_cvtepi16_epi32(_mm_loadu_si128((__m128i *)&S[t]));
+    __m256i hcv = _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i *)&hc[t]));
+
+    /* no pair (type 0) is treated as non-standard pair, see vrna_get_ptype() */
+    pt = _mm256_blendv_epi8(pt, nonstd, _mm256_cmpeq_epi32(pt, zero));
+
+    /* gather reversed pair types (l,k) and the mismatch energies mismatch[type2][sq][sp] */
+    __m256i type2 = _mm256_i32gather_epi32(rtype, pt, 4);
+    __m256i mm    = _mm256_i32gather_epi32(mismatch,
+                                           _mm256_add_epi32(_mm256_mullo_epi32(type2, stride), sp),
+                                           4);
+
+    /* ninio asymmetry penalty */
+    __m256i asym = _mm256_min_epi32(_mm256_mullo_epi32(_mm256_abs_epi32(u), ninio), ninio_m);
+
+    __m256i e = _mm256_add_epi32(_mm256_add_epi32(cv, il),
+                                 _mm256_add_epi32(asym, mm));
+
+    /* mask for decompositions allowed by hard constraints and with finite energy */
+    __m256i mask = _mm256_andnot_si256(_mm256_cmpeq_epi32(_mm256_and_si256(hcv, enc), zero),
+                                       _mm256_cmpgt_epi32(inf, cv));
+
+    if (noGUclosure)
+      mask = _mm256_andnot_si256(_mm256_or_si256(_mm256_cmpeq_epi32(type2, gu),
+                                                 _mm256_cmpeq_epi32(type2, ug)),
+                                 mask);
+
+    minv  = _mm256_min_epi32(minv, _mm256_blendv_epi8(inf, e, mask));
+    u     = _mm256_add_epi32(u, eight);
+  }
+
+  decomp = horizontal_min_Vec8i(minv);
+
+  if (t < count) {
+    const int en = vrna_fun_int_loop_min_scalar(c + t,
+                                                ptype + t,
+                                                hc + t,
+                                                S + t,
+                                                u1 + t,
+                                                u2,
+                                                sq,
+                                                count - t,
+                                                P);
+    decomp = MIN2(decomp, en);
+  }
+
+  return decomp;
+}
+
+
+/* AVX2 minimum over all eight lanes */
+static int
+horizontal_min_Vec8i(__m256i x)
+{
+  __m128i min1  = _mm_min_epi32(_mm256_castsi256_si128(x),
+                                _mm256_extracti128_si256(x, 1));
+  __m128i min2  = _mm_min_epi32(min1, _mm_shuffle_epi32(min1, _MM_SHUFFLE(0, 0, 3, 2)));
+  __m128i min3  = _mm_min_epi32(min2, _mm_shuffle_epi32(min2, _MM_SHUFFLE(0, 0, 0, 1)));
+
+  return _mm_cvtsi128_si32(min3);
+}
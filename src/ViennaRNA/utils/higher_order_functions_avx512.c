@@ -7,9 +7,44 @@
 #include <math.h>
 
 #include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/params/default.h"
+#include "ViennaRNA/constraints/hard.h"
+#include "ViennaRNA/utils/higher_order_functions.h"
 
 #include <immintrin.h>
 
+#ifdef USE_FLOAT_PF
+# define PF_VEC           __m512
+# define PF_WIDTH         16
+# define PF_ZERO()        _mm512_setzero_ps()
+# define PF_LOAD(p)       _mm512_loadu_ps(p)
+# define PF_STORE(p, x)   _mm512_storeu_ps((p), (x))
+# define PF_ADD(x, y)     _mm512_add_ps((x), (y))
+# define PF_MUL(x, y)     _mm512_mul_ps((x), (y))
+# define PF_REVERSE(x)    _mm512_permutexvar_ps(_mm512_setr_epi32(15, 14, 13, 12, 11, 10, 9, 8, \
+                                                                  7, 6, 5, 4, 3, 2, 1, 0), (x))
+#else
+# define PF_VEC           __m512d
+# define PF_WIDTH         8
+# define PF_ZERO()        _mm512_setzero_pd()
+# define PF_LOAD(p)       _mm512_loadu_pd(p)
+# define PF_STORE(p, x)   _mm512_storeu_pd((p), (x))
+# define PF_ADD(x, y)     _mm512_add_pd((x), (y))
+# define PF_MUL(x, y)     _mm512_mul_pd((x), (y))
+# define PF_REVERSE(x)    _mm512_permutexvar_pd(_mm512_setr_epi64(7, 6, 5, 4, 3, 2, 1, 0), (x))
+#endif
+
+int
+vrna_fun_int_loop_min_scalar(const int            *c,
+                             const char           *ptype,
+                             const unsigned char  *hc,
+                             const short          *S,
+                             int                  u1,
+                             int                  u2,
+                             int                  sq,
+                             int                  count,
+                             vrna_param_t         *P);
+
 
 PUBLIC int
 vrna_fun_zip_add_min_avx512(const int *e1,
@@ -48,3 +83,175 @@ vrna_fun_zip_add_min_avx512(const int *e1,
 
   return decomp;
 }
+
+
+PUBLIC int
+vrna_fun_zip_add_min_masked_avx512(const int            *e1,
+                                   const int            *e2,
+                                   const unsigned char  *mask,
+                                   int                  count)
+{
+  int     i       = 0;
+  int     decomp  = INF;
+
+  __m512i inf   = _mm512_set1_epi32(INF);
+  __m512i minv  = inf;
+
+  for (i = 0; i < count - 15; i += 16) {
+    __m512i   a = _mm512_loadu_si512((__m512i *)&e1[i]);
+    __m512i   b = _mm512_loadu_si512((__m512i *)&e2[i]);
+    __m512i   m = _mm512_cvtepu8_epi32(_mm_loadu_si128((__m128i *)&mask[i]));
+
+    /* compute mask for allowed entries where both, a and b, are less than INF */
+    __mmask16 k = _kand_mask16(_mm512_test_epi32_mask(m, m),
+                               _kand_mask16(_mm512_cmplt_epi32_mask(a, inf),
+                                            _mm512_cmplt_epi32_mask(b, inf)));
+
+    minv = _mm512_mask_min_epi32(minv, k, minv, _mm512_add_epi32(a, b));
+  }
+
+  decomp = _mm512_reduce_min_epi32(minv);
+
+  for (; i < count; i++) {
+    if ((mask[i]) && (e1[i] != INF) && (e2[i] != INF)) {
+      const int en = e1[i] + e2[i];
+      decomp = MIN2(decomp, en);
+    }
+  }
+
+  return decomp;
+}
+
+
+PUBLIC FLT_OR_DBL
+vrna_fun_zip_mult_sum_avx512(const FLT_OR_DBL *e1,
+                             const FLT_OR_DBL *e2,
+                             int              count)
+{
+  int         i, k;
+  FLT_OR_DBL  sum, lanes[PF_WIDTH];
+  PF_VEC      acc = PF_ZERO();
+
+  for (i = 0; i < count - (PF_WIDTH - 1); i += PF_WIDTH)
+    acc = PF_ADD(acc, PF_MUL(PF_LOAD(e1 + i), PF_LOAD(e2 + i)));
+
+  PF_STORE(lanes, acc);
+
+  for (sum = 0., k = 0; k < PF_WIDTH; k++)
+    sum += lanes[k];
+
+  for (; i < count; i++)
+    sum += e1[i] * e2[i];
+
+  return sum;
+}
+
+
+PUBLIC FLT_OR_DBL
+vrna_fun_zip_mult_sum_rev_avx512(const FLT_OR_DBL *e1,
+                                 const FLT_OR_DBL *e2,
+                                 int              count)
+{
+  int         i, k;
+  FLT_OR_DBL  sum, lanes[PF_WIDTH];
+  PF_VEC      acc = PF_ZERO();
+
+  for (i = 0; i < count - (PF_WIDTH - 1); i += PF_WIDTH)
+    acc = PF_ADD(acc, PF_MUL(PF_REVERSE(PF_LOAD(e1 - i - (PF_WIDTH - 1))), PF_LOAD(e2 + i)));
+
+  PF_STORE(lanes, acc);
+
+  for (sum = 0., k = 0; k < PF_WIDTH; k++)
+    sum += lanes[k];
+
+  for (; i < count; i++)
+    sum += e1[-i] * e2[i];
+
+  return sum;
+}
+
+
+PUBLIC int
+vrna_fun_int_loop_min_avx512(const int            *c,
+                             const char           *ptype,
+                             const unsigned char  *hc,
+                             const short          *S,
+                             int                  u1,
+                             int                  u2,
+                             int                  sq,
+                             int                  count,
+                             vrna_param_t         *P)
+{
+  int     t, decomp, noGUclosure, *rtype, *mismatch;
+
+  noGUclosure = P->model_details.noGUclosure;
+  rtype       = &(P->model_details.rtype[0]);
+  mismatch    = (u2 == 1) ? &(P->mismatch1nI[0][sq][0]) : &(P->mismatchI[0][sq][0]);
+
+  __m512i inf     = _mm512_set1_epi32(INF);
+  __m512i enc     = _mm512_set1_epi32(VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC);
+  __m512i ninio   = _mm512_set1_epi32(P->ninio[2]);
+  __m512i ninio_m = _mm512_set1_epi32(MAX_NINIO);
+  __m512i stride  = _mm512_set1_epi32(25);
+  __m512i zero    = _mm512_setzero_si512();
+  __m512i nonstd  = _mm512_set1_epi32(7);
+  __m512i gu      = _mm512_set1_epi32(3);
+  __m512i ug      = _mm512_set1_epi32(4);
+  __m512i sixteen = _mm512_set1_epi32(16);
+  __m512i u       = _mm512_add_epi32(_mm512_set1_epi32(u1 - u2),
+                                     _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7,
+                                                       8, 9, 10, 11, 12, 13, 14, 15));
+  __m512i minv = inf;
+
+  for (t = 0; t < count - 15; t += 16) {
+    __m512i   cv  = _mm512_loadu_si512((__m512i *)&c[t]);
+    __m512i   il  = _mm512_loadu_si512((__m512i *)&(P->internal_loop[u1 + u2 + t]));
+    __m512i   pt  = _mm512_cvtepu8_epi32(_mm_loadu_si128((__m128i *)&ptype[t]));
+
+    /* no pair (type 0) is treated as non-standard pair, see vrna_get_ptype() */
+    pt = _mm512_mask_mov_epi32(pt, _mm512_cmpeq_epi32_mask(pt, zero), nonstd);
+    __m512i   sp  = _mm512_cvtepi16_epi32(_mm256_loadu_si256((__m256i *)&S[t]));
+    __m512i   hcv = _mm512_cvtepu8_epi32(_mm_loadu_si128((__m128i *)&hc[t]));
+
+    /* gather reversed pair types (l,k) and the mismatch energies mismatch[type2][sq][sp] */
+    __m512i   type2 = _mm512_i32gather_epi32(pt, rtype, 4);
+    __m512i   mm    = _mm512_i32gather_epi32(_mm512_add_epi32(_mm512_mullo_epi32(type2, stride), sp),
+                                             mismatch,
+                                             4);
+
+    /* ninio asymmetry penalty */
+    __m512i   asym = _mm512_min_epi32(_mm512_mullo_epi32(_mm512_abs_epi32(u), ninio), ninio_m);
+
+    __m512i   e = _mm512_add_epi32(_mm512_add_epi32(cv, il),
+                                   _mm512_add_epi32(asym, mm));
+
+    /* mask for decompositions allowed by hard constraints and with finite energy */
+    __mmask16 mask = _kand_mask16(_mm512_test_epi32_mask(hcv, enc),
+                                  _mm512_cmplt_epi32_mask(cv, inf));
+
+    if (noGUclosure)
+      mask = _kand_mask16(mask,
+                          _kand_mask16(_mm512_cmpneq_epi32_mask(type2, gu),
+                                       _mm512_cmpneq_epi32_mask(type2, ug)));
+
+    minv  = _mm512_mask_min_epi32(minv, mask, minv, e);
+    u     = _mm512_add_epi32(u, sixteen);
+  }
+
+  decomp = _mm512_reduce_min_epi32(minv);
+
+  if (t < count) {
+    const int en = vrna_fun_int_loop_min_scalar(c + t,
+                                                ptype + t,
+                                                hc + t,
+                                                S + t,
+                                                u1 + t,
+                                                u2,
+                                                sq,
+                                                count - t,
+                                                P);
+    decomp = MIN2(decomp, en);
+  }
+
+  return decomp;
+}
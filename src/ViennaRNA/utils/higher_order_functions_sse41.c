@@ -5,16 +5,52 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
 
 #include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/params/default.h"
+#include "ViennaRNA/constraints/hard.h"
+#include "ViennaRNA/utils/higher_order_functions.h"
 
 #include <emmintrin.h>
 #include <smmintrin.h>
 
+#ifdef USE_FLOAT_PF
+# define PF_VEC           __m128
+# define PF_WIDTH         4
+# define PF_ZERO()        _mm_setzero_ps()
+# define PF_LOAD(p)       _mm_loadu_ps(p)
+# define PF_STORE(p, x)   _mm_storeu_ps((p), (x))
+# define PF_ADD(x, y)     _mm_add_ps((x), (y))
+# define PF_MUL(x, y)     _mm_mul_ps((x), (y))
+# define PF_REVERSE(x)    _mm_shuffle_ps((x), (x), _MM_SHUFFLE(0, 1, 2, 3))
+#else
+# define PF_VEC           __m128d
+# define PF_WIDTH         2
+# define PF_ZERO()        _mm_setzero_pd()
+# define PF_LOAD(p)       _mm_loadu_pd(p)
+# define PF_STORE(p, x)   _mm_storeu_pd((p), (x))
+# define PF_ADD(x, y)     _mm_add_pd((x), (y))
+# define PF_MUL(x, y)     _mm_mul_pd((x), (y))
+# define PF_REVERSE(x)    _mm_shuffle_pd((x), (x), 1)
+#endif
+
 static int
 horizontal_min_Vec4i(__m128i x);
 
 
+int
+vrna_fun_int_loop_min_scalar(const int            *c,
+                             const char           *ptype,
+                             const unsigned char  *hc,
+                             const short          *S,
+                             int                  u1,
+                             int                  u2,
+                             int                  sq,
+                             int                  count,
+                             vrna_param_t         *P);
+
+
 PUBLIC int
 vrna_fun_zip_add_min_sse41(const int  *e1,
                            const int  *e2,
@@ -55,6 +91,181 @@ vrna_fun_zip_add_min_sse41(const int  *e1,
 }
 
 
+PUBLIC int
+vrna_fun_zip_add_min_masked_sse41(const int           *e1,
+                                  const int           *e2,
+                                  const unsigned char *mask,
+                                  int                 count)
+{
+  int     i       = 0;
+  int     decomp  = INF;
+
+  __m128i inf   = _mm_set1_epi32(INF);
+  __m128i zero  = _mm_setzero_si128();
+  __m128i minv  = inf;
+
+  for (i = 0; i < count - 3; i += 4) {
+    int     m4;
+    __m128i a = _mm_loadu_si128((__m128i *)&e1[i]);
+    __m128i b = _mm_loadu_si128((__m128i *)&e2[i]);
+    __m128i c = _mm_add_epi32(a, b);
+
+    memcpy(&m4, mask + i, sizeof(int));
+
+    /* create mask for allowed decompositions with non-INF values */
+    __m128i m = _mm_andnot_si128(_mm_cmpeq_epi32(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(m4)), zero),
+                                 _mm_and_si128(_mm_cmplt_epi32(a, inf),
+                                               _mm_cmplt_epi32(b, inf)));
+
+    minv = _mm_min_epi32(minv, _mm_blendv_epi8(inf, c, m));
+  }
+
+  decomp = horizontal_min_Vec4i(minv);
+
+  for (; i < count; i++) {
+    if ((mask[i]) && (e1[i] != INF) && (e2[i] != INF)) {
+      const int en = e1[i] + e2[i];
+      decomp = MIN2(decomp, en);
+    }
+  }
+
+  return decomp;
+}
+
+
+PUBLIC FLT_OR_DBL
+vrna_fun_zip_mult_sum_sse41(const FLT_OR_DBL  *e1,
+                            const FLT_OR_DBL  *e2,
+                            int               count)
+{
+  int         i, k;
+  FLT_OR_DBL  sum, lanes[PF_WIDTH];
+  PF_VEC      acc = PF_ZERO();
+
+  for (i = 0; i < count - (PF_WIDTH - 1); i += PF_WIDTH)
+    acc = PF_ADD(acc, PF_MUL(PF_LOAD(e1 + i), PF_LOAD(e2 + i)));
+
+  PF_STORE(lanes, acc);
+
+  for (sum = 0., k = 0; k < PF_WIDTH; k++)
+    sum += lanes[k];
+
+  for (; i < count; i++)
+    sum += e1[i] * e2[i];
+
+  return sum;
+}
+
+
+PUBLIC FLT_OR_DBL
+vrna_fun_zip_mult_sum_rev_sse41(const FLT_OR_DBL  *e1,
+                                const FLT_OR_DBL  *e2,
+                                int               count)
+{
+  int         i, k;
+  FLT_OR_DBL  sum, lanes[PF_WIDTH];
+  PF_VEC      acc = PF_ZERO();
+
+  for (i = 0; i < count - (PF_WIDTH - 1); i += PF_WIDTH)
+    acc = PF_ADD(acc, PF_MUL(PF_REVERSE(PF_LOAD(e1 - i - (PF_WIDTH - 1))), PF_LOAD(e2 + i)));
+
+  PF_STORE(lanes, acc);
+
+  for (sum = 0., k = 0; k < PF_WIDTH; k++)
+    sum += lanes[k];
+
+  for (; i < count; i++)
+    sum += e1[-i] * e2[i];
+
+  return sum;
+}
+
+
+PUBLIC int
+vrna_fun_int_loop_min_sse41(const int           *c,
+                            const char          *ptype,
+                            const unsigned char *hc,
+                            const short         *S,
+                            int                 u1,
+                            int                 u2,
+                            int                 sq,
+                            int                 count,
+                            vrna_param_t        *P)
+{
+  int     t, decomp, noGUclosure, *rtype, (*mismatch)[5][5];
+
+  noGUclosure = P->model_details.noGUclosure;
+  rtype       = &(P->model_details.rtype[0]);
+  mismatch    = (u2 == 1) ? P->mismatch1nI : P->mismatchI;
+
+  __m128i inf     = _mm_set1_epi32(INF);
+  __m128i zero    = _mm_setzero_si128();
+  __m128i enc     = _mm_set1_epi32(VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC);
+  __m128i ninio   = _mm_set1_epi32(P->ninio[2]);
+  __m128i ninio_m = _mm_set1_epi32(MAX_NINIO);
+  __m128i gu      = _mm_set1_epi32(3);
+  __m128i ug      = _mm_set1_epi32(4);
+  __m128i u       = _mm_setr_epi32(u1 - u2, u1 - u2 + 1, u1 - u2 + 2, u1 - u2 + 3);
+  __m128i four    = _mm_set1_epi32(4);
+  __m128i minv    = inf;
+
+  for (t = 0; t < count - 3; t += 4) {
+    int     hc4;
+    __m128i cv    = _mm_loadu_si128((__m128i *)&c[t]);
+    __m128i il    = _mm_loadu_si128((__m128i *)&(P->internal_loop[u1 + u2 + t]));
+
+    /* no gather instructions in SSE, so look up pair types and mismatches one by one */
+    int     tt0 = rtype[(ptype[t]) ? (unsigned char)ptype[t] : 7];
+    int     tt1 = rtype[(ptype[t + 1]) ? (unsigned char)ptype[t + 1] : 7];
+    int     tt2 = rtype[(ptype[t + 2]) ? (unsigned char)ptype[t + 2] : 7];
+    int     tt3 = rtype[(ptype[t + 3]) ? (unsigned char)ptype[t + 3] : 7];
+    __m128i type2 = _mm_setr_epi32(tt0, tt1, tt2, tt3);
+    __m128i mm    = _mm_setr_epi32(mismatch[tt0][sq][S[t]],
+                                   mismatch[tt1][sq][S[t + 1]],
+                                   mismatch[tt2][sq][S[t + 2]],
+                                   mismatch[tt3][sq][S[t + 3]]);
+
+    memcpy(&hc4, hc + t, sizeof(int));
+    __m128i hcv = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(hc4));
+
+    /* ninio asymmetry penalty */
+    __m128i asym = _mm_min_epi32(_mm_mullo_epi32(_mm_abs_epi32(u), ninio), ninio_m);
+
+    __m128i e = _mm_add_epi32(_mm_add_epi32(cv, il),
+                              _mm_add_epi32(asym, mm));
+
+    /* mask for decompositions allowed by hard constraints and with finite energy */
+    __m128i mask = _mm_andnot_si128(_mm_cmpeq_epi32(_mm_and_si128(hcv, enc), zero),
+                                    _mm_cmplt_epi32(cv, inf));
+
+    if (noGUclosure)
+      mask = _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi32(type2, gu),
+                                           _mm_cmpeq_epi32(type2, ug)),
+                              mask);
+
+    minv  = _mm_min_epi32(minv, _mm_blendv_epi8(inf, e, mask));
+    u     = _mm_add_epi32(u, four);
+  }
+
+  decomp = horizontal_min_Vec4i(minv);
+
+  if (t < count) {
+    const int en = vrna_fun_int_loop_min_scalar(c + t,
+                                                ptype + t,
+                                                hc + t,
+                                                S + t,
+                                                u1 + t,
+                                                u2,
+                                                sq,
+                                                count - t,
+                                                P);
+    decomp = MIN2(decomp, en);
+  }
+
+  return decomp;
+}
+
+
 /*
  *  SSE minimum
  *  see also: http://stackoverflow.com/questions/9877700/getting-max-value-in-a-m128i-vector-with-sse
@@ -0,0 +1,495 @@
+/*
+ *  A simple work-stealing task scheduler
+ *
+ *  Every worker owns a bounded task queue, each protected by its own mutex.
+ *  Tasks are submitted to the queues in a round-robin fashion. Workers take
+ *  the most recent task from their own queue, and steal the oldest task from
+ *  another queue if they run out of work. The number of queued and pending
+ *  tasks is maintained in atomic counters. A single scheduler-wide mutex is
+ *  only taken to put workers and submitters to sleep, or to wake them up,
+ *  i.e. there is no polling anywhere.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if VRNA_WITH_PTHREADS
+# include <pthread.h>
+#endif
+
+#include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/utils/scheduler.h"
+
+#if VRNA_WITH_PTHREADS
+# define LOAD(x)            __atomic_load_n(&(x), __ATOMIC_SEQ_CST)
+# define STORE(x, v)        __atomic_store_n(&(x), (v), __ATOMIC_SEQ_CST)
+# define INCREMENT(x)       __atomic_add_fetch(&(x), 1, __ATOMIC_SEQ_CST)
+# define DECREMENT(x)       __atomic_sub_fetch(&(x), 1, __ATOMIC_SEQ_CST)
+#endif
+
+/*
+ #################################
+ # PRIVATE DATA STRUCTURES       #
+ #################################
+ */
+struct task {
+  vrna_scheduler_task_f f;
+  void                  *data;
+};
+
+#if VRNA_WITH_PTHREADS
+
+struct worker {
+  pthread_t               thread;
+  pthread_mutex_t         mtx;      /* protects the task queue below */
+  struct task             *tasks;   /* ring buffer of size queue_size */
+  unsigned int            head;     /* position of the oldest task */
+  unsigned int            count;    /* number of tasks in the queue */
+  unsigned int            id;
+  struct vrna_scheduler_s *scheduler;
+};
+
+#endif
+
+struct vrna_scheduler_s {
+  unsigned int    num_workers;
+  unsigned int    queue_size;
+#if VRNA_WITH_PTHREADS
+  struct worker   *workers;
+
+  /* atomic counters */
+  unsigned int    next;             /* next queue for round-robin submission */
+  unsigned int    reserved;         /* queue slots reserved by submitters but not yet freed by a worker */
+  unsigned int    available;        /* tasks in the queues not yet claimed by a worker */
+  unsigned int    pending;          /* tasks submitted but not yet finished */
+  unsigned int    idle;             /* workers waiting for work */
+  unsigned int    blocked;          /* submitters waiting for a free slot */
+  unsigned int    waiting;          /* threads waiting for all tasks to finish */
+  unsigned int    shutdown;
+
+  pthread_mutex_t mtx;              /* only used to sleep on, and to signal, the conditions below */
+  pthread_cond_t  work_available;
+  pthread_cond_t  slot_available;
+  pthread_cond_t  all_done;
+#endif
+};
+
+
+/*
+ #################################
+ # PRIVATE FUNCTION DECLARATIONS #
+ #################################
+ */
+#if VRNA_WITH_PTHREADS
+
+PRIVATE void *
+worker_loop(void *arg);
+
+
+PRIVATE int
+queue_push(struct worker  *w,
+           struct task    *t);
+
+
+PRIVATE int
+queue_pop_newest(struct worker  *w,
+                 struct task    *t);
+
+
+PRIVATE int
+queue_pop_oldest(struct worker  *w,
+                 struct task    *t);
+
+
+PRIVATE int
+claim(unsigned int  *counter,
+      unsigned int  limit,
+      int           increase);
+
+
+PRIVATE void
+wake(struct vrna_scheduler_s  *scheduler,
+     pthread_cond_t           *cond,
+     unsigned int             *sleepers,
+     int                      all);
+
+
+#endif
+
+/*
+ #################################
+ # BEGIN OF FUNCTION DEFINITIONS #
+ #################################
+ */
+PUBLIC struct vrna_scheduler_s *
+vrna_scheduler_init(unsigned int  num_workers,
+                    unsigned int  queue_size)
+{
+  struct vrna_scheduler_s *scheduler;
+
+  scheduler = (struct vrna_scheduler_s *)vrna_alloc(sizeof(struct vrna_scheduler_s));
+
+  scheduler->num_workers  = 0;
+  scheduler->queue_size   = (queue_size > 0) ? queue_size : VRNA_SCHEDULER_QUEUE_SIZE;
+
+#if VRNA_WITH_PTHREADS
+  unsigned int i;
+
+  if (num_workers < 2)
+    return scheduler;
+
+  pthread_mutex_init(&(scheduler->mtx), NULL);
+  pthread_cond_init(&(scheduler->work_available), NULL);
+  pthread_cond_init(&(scheduler->slot_available), NULL);
+  pthread_cond_init(&(scheduler->all_done), NULL);
+
+  scheduler->workers = (struct worker *)vrna_alloc(sizeof(struct worker) * num_workers);
+
+  for (i = 0; i < num_workers; i++) {
+    struct worker *w = scheduler->workers + i;
+
+    pthread_mutex_init(&(w->mtx), NULL);
+    w->tasks      = (struct task *)vrna_alloc(sizeof(struct task) * scheduler->queue_size);
+    w->id         = i;
+    w->scheduler  = scheduler;
+  }
+
+  /*
+   *  workers must not look at the other queues before the final number of
+   *  workers is known, so they wait for this lock to be released
+   */
+  pthread_mutex_lock(&(scheduler->mtx));
+
+  for (i = 0; i < num_workers; i++) {
+    if (pthread_create(&(scheduler->workers[i].thread),
+                       NULL,
+                       &worker_loop,
+                       (void *)(scheduler->workers + i)) != 0) {
+      vrna_message_warning("vrna_scheduler_init: "
+                           "Failed to start worker thread %u, using %u threads instead",
+                           i + 1,
+                           i);
+
+      /* release the queues of workers that have not been started */
+      for (; i < num_workers; i++) {
+        pthread_mutex_destroy(&(scheduler->workers[i].mtx));
+        free(scheduler->workers[i].tasks);
+      }
+
+      break;
+    }
+
+    scheduler->num_workers++;
+  }
+
+  pthread_mutex_unlock(&(scheduler->mtx));
+
+  /* we can't use a single worker, so let the calling thread do all the work */
+  if (scheduler->num_workers == 1) {
+    vrna_scheduler_free(scheduler);
+    return vrna_scheduler_init(0, queue_size);
+  }
+
+#endif
+
+  return scheduler;
+}
+
+
+PUBLIC int
+vrna_scheduler_submit(struct vrna_scheduler_s *scheduler,
+                      vrna_scheduler_task_f   f,
+                      void                    *data)
+{
+  if ((!scheduler) || (!f))
+    return 0;
+
+#if VRNA_WITH_PTHREADS
+  if (scheduler->num_workers > 0) {
+    unsigned int  i, start;
+    struct task   t;
+
+    t.f     = f;
+    t.data  = data;
+
+    /* apply backpressure, a reserved slot guarantees that at least one queue has space */
+    while (!claim(&(scheduler->reserved), scheduler->num_workers * scheduler->queue_size, 1)) {
+      pthread_mutex_lock(&(scheduler->mtx));
+      INCREMENT(scheduler->blocked);
+
+      while (LOAD(scheduler->reserved) == scheduler->num_workers * scheduler->queue_size)
+        pthread_cond_wait(&(scheduler->slot_available), &(scheduler->mtx));
+
+      DECREMENT(scheduler->blocked);
+      pthread_mutex_unlock(&(scheduler->mtx));
+    }
+
+    INCREMENT(scheduler->pending);
+
+    start = (__atomic_fetch_add(&(scheduler->next), 1, __ATOMIC_RELAXED)) % scheduler->num_workers;
+
+    for (i = 0; !queue_push(scheduler->workers + ((start + i) % scheduler->num_workers), &t); i++);
+
+    /* the task can be claimed only now that it is actually in a queue */
+    INCREMENT(scheduler->available);
+    wake(scheduler, &(scheduler->work_available), &(scheduler->idle), 0);
+
+    return 1;
+  }
+
+#endif
+
+  f(data);
+
+  return 1;
+}
+
+
+PUBLIC void
+vrna_scheduler_wait(struct vrna_scheduler_s *scheduler)
+{
+#if VRNA_WITH_PTHREADS
+  if ((scheduler) &&
+      (scheduler->num_workers > 0)) {
+    if (LOAD(scheduler->pending) == 0)
+      return;
+
+    pthread_mutex_lock(&(scheduler->mtx));
+    INCREMENT(scheduler->waiting);
+
+    while (LOAD(scheduler->pending) > 0)
+      pthread_cond_wait(&(scheduler->all_done), &(scheduler->mtx));
+
+    DECREMENT(scheduler->waiting);
+    pthread_mutex_unlock(&(scheduler->mtx));
+  }
+
+#endif
+}
+
+
+PUBLIC unsigned int
+vrna_scheduler_workers(struct vrna_scheduler_s *scheduler)
+{
+  return (scheduler) ? scheduler->num_workers : 0;
+}
+
+
+PUBLIC void
+vrna_scheduler_free(struct vrna_scheduler_s *scheduler)
+{
+  if (scheduler) {
+#if VRNA_WITH_PTHREADS
+    if (scheduler->workers) {
+      unsigned int i;
+
+      vrna_scheduler_wait(scheduler);
+
+      pthread_mutex_lock(&(scheduler->mtx));
+      STORE(scheduler->shutdown, 1);
+      pthread_cond_broadcast(&(scheduler->work_available));
+      pthread_mutex_unlock(&(scheduler->mtx));
+
+      for (i = 0; i < scheduler->num_workers; i++)
+        pthread_join(scheduler->workers[i].thread, NULL);
+
+      for (i = 0; i < scheduler->num_workers; i++) {
+        pthread_mutex_destroy(&(scheduler->workers[i].mtx));
+        free(scheduler->workers[i].tasks);
+      }
+
+      free(scheduler->workers);
+
+      pthread_cond_destroy(&(scheduler->all_done));
+      pthread_cond_destroy(&(scheduler->slot_available));
+      pthread_cond_destroy(&(scheduler->work_available));
+      pthread_mutex_destroy(&(scheduler->mtx));
+    }
+
+#endif
+
+    free(scheduler);
+  }
+}
+
+
+/*
+ #################################
+ # STATIC helper functions below #
+ #################################
+ */
+#if VRNA_WITH_PTHREADS
+
+PRIVATE void *
+worker_loop(void *arg)
+{
+  unsigned int            i;
+  int                     found;
+  struct task             t;
+  struct worker           *w          = (struct worker *)arg;
+  struct vrna_scheduler_s *scheduler  = w->scheduler;
+
+  /* wait until all workers have been started */
+  pthread_mutex_lock(&(scheduler->mtx));
+  pthread_mutex_unlock(&(scheduler->mtx));
+
+  while (1) {
+    if (!claim(&(scheduler->available), 0, 0)) {
+      /* nothing to do, so sleep until a task becomes available */
+      pthread_mutex_lock(&(scheduler->mtx));
+      INCREMENT(scheduler->idle);
+
+      while ((LOAD(scheduler->available) == 0) &&
+             (!LOAD(scheduler->shutdown)))
+        pthread_cond_wait(&(scheduler->work_available), &(scheduler->mtx));
+
+      DECREMENT(scheduler->idle);
+      pthread_mutex_unlock(&(scheduler->mtx));
+
+      if ((LOAD(scheduler->available) == 0) &&
+          (LOAD(scheduler->shutdown)))
+        break;
+
+      continue;
+    }
+
+    /*
+     *  we claimed a task that has already been pushed, so there is one in
+     *  the queues for us. Take the most recent one of our own queue first,
+     *  then steal the oldest ones from the others
+     */
+    for (found = 0, i = 0; !found; i = (i + 1) % scheduler->num_workers)
+      found = (i == 0) ?
+              queue_pop_newest(w, &t) :
+              queue_pop_oldest(scheduler->workers + ((w->id + i) % scheduler->num_workers), &t);
+
+    DECREMENT(scheduler->reserved);
+    wake(scheduler, &(scheduler->slot_available), &(scheduler->blocked), 0);
+
+    t.f(t.data);
+
+    if (DECREMENT(scheduler->pending) == 0)
+      wake(scheduler, &(scheduler->all_done), &(scheduler->waiting), 1);
+  }
+
+  return NULL;
+}
+
+
+PRIVATE int
+queue_push(struct worker  *w,
+           struct task    *t)
+{
+  int ret = 0;
+
+  pthread_mutex_lock(&(w->mtx));
+
+  if (w->count < w->scheduler->queue_size) {
+    w->tasks[(w->head + w->count) % w->scheduler->queue_size] = *t;
+    w->count++;
+    ret = 1;
+  }
+
+  pthread_mutex_unlock(&(w->mtx));
+
+  return ret;
+}
+
+
+/* the owner of a queue processes its tasks in LIFO order, while their data is still in cache */
+PRIVATE int
+queue_pop_newest(struct worker  *w,
+                 struct task    *t)
+{
+  int ret = 0;
+
+  pthread_mutex_lock(&(w->mtx));
+
+  if (w->count > 0) {
+    w->count--;
+    *t  = w->tasks[(w->head + w->count) % w->scheduler->queue_size];
+    ret = 1;
+  }
+
+  pthread_mutex_unlock(&(w->mtx));
+
+  return ret;
+}
+
+
+/* other workers steal the oldest task of a queue */
+PRIVATE int
+queue_pop_oldest(struct worker  *w,
+                 struct task    *t)
+{
+  int ret = 0;
+
+  pthread_mutex_lock(&(w->mtx));
+
+  if (w->count > 0) {
+    *t      = w->tasks[w->head];
+    w->head = (w->head + 1) % w->scheduler->queue_size;
+    w->count--;
+    ret     = 1;
+  }
+
+  pthread_mutex_unlock(&(w->mtx));
+
+  return ret;
+}
+
+
+/*
+ *  Atomically increase a counter that is below 'limit', or decrease a
+ *  counter that is above 'limit'. Returns 0 if the counter is at its limit
+ */
+PRIVATE int
+claim(unsigned int  *counter,
+      unsigned int  limit,
+      int           increase)
+{
+  unsigned int c = LOAD(*counter);
+
+  while (c != limit)
+    if (__atomic_compare_exchange_n(counter,
+                                    &c,
+                                    (increase) ? c + 1 : c - 1,
+                                    0,
+                                    __ATOMIC_SEQ_CST,
+                                    __ATOMIC_SEQ_CST))
+      return 1;
+
+  return 0;
+}
+
+
+/*
+ *  Wake up threads sleeping on a condition after its state has been
+ *  changed. Sleepers register themselves in 'sleepers' before they check
+ *  the state while holding the mutex, so either they see the change, or
+ *  we see them and they are already waiting when we get the mutex
+ */
+PRIVATE void
+wake(struct vrna_scheduler_s  *scheduler,
+     pthread_cond_t           *cond,
+     unsigned int             *sleepers,
+     int                      all)
+{
+  if (LOAD(*sleepers) > 0) {
+    pthread_mutex_lock(&(scheduler->mtx));
+
+    if (all)
+      pthread_cond_broadcast(cond);
+    else
+      pthread_cond_signal(cond);
+
+    pthread_mutex_unlock(&(scheduler->mtx));
+  }
+}
+
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef VIENNA_RNA_PACKAGE_UTILS_SCHEDULER_H
+#define VIENNA_RNA_PACKAGE_UTILS_SCHEDULER_H
+
+/**
+ *  @file     ViennaRNA/utils/scheduler.h
+ *  @ingroup  utils
+ *  @brief    A simple work-stealing task scheduler for parallel batch processing
+ */
+
+/**
+ *  @addtogroup   utils
+ *  @{
+ */
+
+/**
+ *  @brief  Default number of tasks each worker may hold in its queue
+ *
+ *  @see  vrna_scheduler_init()
+ */
+#define VRNA_SCHEDULER_QUEUE_SIZE   64
+
+/**
+ *  @brief  A task scheduler with a fixed number of worker threads
+ *
+ *  Each worker owns a bounded task queue. Tasks are distributed over the
+ *  queues in a round-robin fashion. Workers process the most recent task of
+ *  their own queue first, and idle workers steal the oldest tasks from the
+ *  queues of other workers. Hence, tasks are not necessarily started in the
+ *  order of submission. If all queues are full, submission of a new task
+ *  blocks until a slot becomes available.
+ */
+typedef struct vrna_scheduler_s *vrna_scheduler_t;
+
+/**
+ *  @brief  A task to be executed by the scheduler
+ *
+ *  @param  data  The data pointer passed to vrna_scheduler_submit()
+ */
+typedef void (*vrna_scheduler_task_f)(void *data);
+
+
+/**
+ *  @brief  Create a task scheduler
+ *
+ *  If @p num_workers is less than 2, or the library has been compiled without
+ *  POSIX threads support, no worker threads are started and all tasks are
+ *  executed immediately by vrna_scheduler_submit().
+ *
+ *  @see  vrna_scheduler_submit(), vrna_scheduler_wait(), vrna_scheduler_free()
+ *
+ *  @param  num_workers   The number of worker threads
+ *  @param  queue_size    The maximum number of pending tasks per worker (0 = #VRNA_SCHEDULER_QUEUE_SIZE)
+ *  @return               The scheduler
+ */
+vrna_scheduler_t
+vrna_scheduler_init(unsigned int  num_workers,
+                    unsigned int  queue_size);
+
+
+/**
+ *  @brief  Submit a task to the scheduler
+ *
+ *  Blocks while the task queues of all workers are full.
+ *
+ *  @param  scheduler   The scheduler
+ *  @param  f           The task function
+ *  @param  data        The data passed to the task function
+ *  @return             1 on success, 0 otherwise
+ */
+int
+vrna_scheduler_submit(vrna_scheduler_t      scheduler,
+                      vrna_scheduler_task_f f,
+                      void                  *data);
+
+
+/**
+ *  @brief  Wait until all submitted tasks have been processed
+ *
+ *  @param  scheduler   The scheduler
+ */
+void
+vrna_scheduler_wait(vrna_scheduler_t scheduler);
+
+
+/**
+ *  @brief  Get the number of worker threads of a scheduler
+ *
+ *  @param  scheduler   The scheduler
+ *  @return             The number of worker threads (0 for immediate execution)
+ */
+unsigned int
+vrna_scheduler_workers(vrna_scheduler_t scheduler);
+
+
+/**
+ *  @brief  Process all remaining tasks, stop the workers, and release the scheduler
+ *
+ *  @param  scheduler   The scheduler
+ */
+void
+vrna_scheduler_free(vrna_scheduler_t scheduler);
+
+
+/**
+ * @}
+ */
+
+#endif
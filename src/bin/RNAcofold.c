@@ -29,6 +29,8 @@
 #include "ViennaRNA/cofold.h"
 #include "ViennaRNA/fold.h"
 #include "ViennaRNA/part_func_co.h"
+#include "ViennaRNA/pf_multifold.h"
+#include "ViennaRNA/combinatorics.h"
 #include "ViennaRNA/part_func.h"
 #include "ViennaRNA/centroid.h"
 #include "ViennaRNA/MEA.h"
@@ -53,6 +55,7 @@ struct options {
   int             pf;
   int             doT;
   int             doC;
+  int             screen;
   int             noPS;
   int             noconv;
   int             centroid;
@@ -87,6 +90,10 @@ struct options {
   int             keep_order;
   unsigned int    next_record_number;
   vrna_ostream_t  output_queue;
+
+  unsigned int    screen_num;     /* number of monomers collected for the all-vs-all screen */
+  char            **screen_ids;
+  char            **screen_sequences;
 };
 
 
@@ -109,10 +116,43 @@ struct output_stream {
 };
 
 
+struct screen_data {
+  struct options  *opt;
+  unsigned int    **complexes;  /* the dimers */
+  double          *dG;          /* free energies of the monomers */
+  size_t          requested;    /* number of rows requested from the output queue */
+  vrna_ostream_t  queue;
+};
+
+
 static void
 process_record(struct record_data *record);
 
 
+static void
+screen_add_monomer(struct options *opt,
+                   char           *id,
+                   char           *sequence,
+                   char           **rest);
+
+
+static void
+screen_dimers(struct options *opt);
+
+
+static void
+screen_store(unsigned int size,
+             size_t       complex,
+             double       dG,
+             void         *data);
+
+
+static void
+screen_write_row(void         *auxdata,
+                 unsigned int i,
+                 void         *data);
+
+
 PRIVATE vrna_dimer_pf_t
 do_partfunc(char            *string,
             int             length,
@@ -193,6 +233,11 @@ init_default_options(struct options *opt)
   opt->doC                = 0; /* toggle to compute concentrations */
   opt->concentration_file = NULL;
 
+  opt->screen           = 0;  /* all-vs-all dimer screen */
+  opt->screen_num       = 0;
+  opt->screen_ids       = NULL;
+  opt->screen_sequences = NULL;
+
   opt->constraint_file      = NULL;
   opt->constraint_batch     = 0;
   opt->constraint_enforce   = 0;
@@ -253,6 +298,32 @@ flush_cstr_callback(void          *auxdata,
 }
 
 
+/*
+ *  Same as flush_cstr_callback() but for the ordered output queue. Data is
+ *  only written to the stream buffers, flushing is done once for each batch
+ *  of consecutive records in flush_output_callback()
+ */
+static void
+write_cstr_callback(void          *auxdata,
+                    unsigned int  i,
+                    void          *data)
+{
+  struct output_stream *s = (struct output_stream *)data;
+
+  vrna_cstr_write(s->err);
+  vrna_cstr_write(s->data);
+
+  flush_cstr_callback(auxdata, i, data);
+}
+
+
+static void
+flush_output_callback(void *auxdata)
+{
+  (void)fflush(NULL);
+}
+
+
 int
 main(int  argc,
      char *argv[])
@@ -344,6 +415,14 @@ main(int  argc,
       opt.md.compute_bpp = 1;
   }
 
+  /* all-vs-all dimer screen */
+  if (args_info.all_vs_all_given)
+    opt.screen = opt.pf = 1;
+
+  /* number of threads for the all-vs-all dimer screen */
+  if (args_info.numThreads_given)
+    opt.md.threads = args_info.numThreads_arg;
+
   /* MEA (maximum expected accuracy) settings */
   if (args_info.MEA_given) {
     opt.MEA = 1;
@@ -379,6 +458,20 @@ main(int  argc,
                                  opt.mod_params,
                                  &(opt.md));
 
+  if ((opt.screen) &&
+      ((opt.doC) || (fold_constrained) || (opt.shape) || (opt.commands) || (opt.mod_params)))
+    vrna_message_error("Structure constraints, modified bases, and concentrations "
+                       "are not available for the all-vs-all screen");
+
+  /*
+   *  the monomer free energies of regular dimer runs apply the lonely pair
+   *  check to the concatenated sequence, which the screen can't reproduce
+   *  as it folds each monomer by itself
+   */
+  if ((opt.screen) &&
+      (opt.md.noLP))
+    vrna_message_error("Lonely pairs can not be disallowed (--noLP) in the all-vs-all screen");
+
   /* filename sanitize delimiter */
   if (args_info.filename_delim_given)
     opt.filename_delim = strdup(args_info.filename_delim_arg);
@@ -470,14 +563,18 @@ main(int  argc,
     vrna_message_error(
       "G-Quadruplex support is currently not available for partition function computations");
 
-  if ((opt.csv_output) && (opt.csv_header))
+  if ((opt.csv_output) && (opt.csv_header) && (!opt.screen))
     write_csv_header(stdout, &opt);
 
   if ((opt.verbose) && (opt.jobs > 1))
     vrna_message_info(stderr, "Preparing %d parallel computation slots", opt.jobs);
 
   if (opt.keep_order)
-    opt.output_queue = vrna_ostream_init(&flush_cstr_callback, NULL);
+    opt.output_queue = vrna_ostream_init_bounded(&write_cstr_callback,
+                                                 &flush_output_callback,
+                                                 NULL,
+                                                 0,
+                                                 (opt.jobs > 1) ? VRNA_OSTREAM_WRITER_THREAD : 0);
 
   /*
    ################################################
@@ -521,6 +618,9 @@ main(int  argc,
    # post processing
    ################################################
    */
+  if (opt.screen)
+    screen_dimers(&opt);
+
   vrna_ostream_free(opt.output_queue);
 
 
@@ -618,6 +718,12 @@ process_input(FILE            *input_stream,
     /* construct the sequence ID */
     set_next_id(&rec_id, opt->id_control);
 
+    if (opt->screen) {
+      /* collect monomers for the all-vs-all screen, which starts after all input has been read */
+      screen_add_monomer(opt, rec_id, rec_sequence, rec_rest);
+      continue;
+    }
+
     struct record_data *record = (struct record_data *)vrna_alloc(sizeof(struct record_data));
 
     record->number          = opt->next_record_number;
@@ -883,6 +989,7 @@ process_record(struct record_data *record)
     pairing_propensity = (char *)vrna_alloc(sizeof(char) * (n + 1));
 
     if (opt->md.dangles == 1) {
+      vc->params                        = vrna_params_unshare(vc->params);
       vc->params->model_details.dangles = 2;   /* recompute with dangles as in pf_fold() */
       min_en                            = vrna_eval_structure(vc, mfe_structure);
       vc->params->model_details.dangles = 1;
@@ -1258,6 +1365,201 @@ cleanup_record:
 }
 
 
+static void
+screen_add_monomer(struct options *opt,
+                   char           *id,
+                   char           *sequence,
+                   char           **rest)
+{
+  unsigned int i;
+
+  if (rest) {
+    for (i = 0; rest[i]; i++)
+      free(rest[i]);
+
+    free(rest);
+  }
+
+  if (strchr(sequence, '&')) {
+    vrna_message_warning("Skipping \"%s\", the all-vs-all screen requires single strands as input",
+                         (id) ? id : sequence);
+    free(id);
+    free(sequence);
+    return;
+  }
+
+  /* convert DNA alphabet to RNA if not explicitely switched off */
+  if (!opt->noconv)
+    vrna_seq_toRNA(sequence);
+
+  vrna_seq_toupper(sequence);
+
+  opt->screen_ids = (char **)vrna_realloc(opt->screen_ids,
+                                          sizeof(char *) * (opt->screen_num + 1));
+  opt->screen_sequences = (char **)vrna_realloc(opt->screen_sequences,
+                                                sizeof(char *) * (opt->screen_num + 1));
+
+  opt->screen_ids[opt->screen_num]        = (id) ? id : vrna_strdup_printf("%u", opt->screen_num + 1);
+  opt->screen_sequences[opt->screen_num]  = sequence;
+  opt->screen_num++;
+}
+
+
+/*
+ *  Print one line of the all-vs-all screen, called in the order of the
+ *  dimers by the ordered output stream
+ */
+static void
+screen_write_row(void         *auxdata,
+                 unsigned int i,
+                 void         *data)
+{
+  vrna_cstr_free((vrna_cstr_t)data);
+}
+
+
+/*
+ *  Receive the free energy of a monomer or dimer from the screen. Monomers
+ *  are reported first, each dimer is formatted right away and passed to the
+ *  ordered output stream
+ */
+static void
+screen_store(unsigned int size,
+             size_t       complex,
+             double       dG,
+             void         *data)
+{
+  unsigned int        a, b;
+  char                d;
+  vrna_cstr_t         row;
+  struct screen_data  *screen;
+
+  screen = (struct screen_data *)data;
+
+  if (size == 1) {
+    screen->dG[complex] = dG;
+    return;
+  }
+
+  a = screen->complexes[complex][0];
+  b = screen->complexes[complex][1];
+  d = screen->opt->csv_output_delim;
+
+  row = vrna_cstr(100, stdout);
+
+  if (screen->opt->csv_output)
+    vrna_cstr_printf(row,
+                     "%s%c"
+                     "%s%c"
+                     "%.6f%c" /* AB */
+                     "%.6f%c" /* A */
+                     "%.6f%c" /* B */
+                     "%.6f\n", /* delta G binding */
+                     screen->opt->screen_ids[a], d,
+                     screen->opt->screen_ids[b], d,
+                     dG, d,
+                     screen->dG[a], d,
+                     screen->dG[b], d,
+                     dG - screen->dG[a] - screen->dG[b]);
+  else
+    vrna_cstr_printf_tbody(row,
+                           "%s\t%s\t%6f\t%6f\t%6f\t%6f",
+                           screen->opt->screen_ids[a],
+                           screen->opt->screen_ids[b],
+                           dG,
+                           screen->dG[a],
+                           screen->dG[b],
+                           dG - screen->dG[a] - screen->dG[b]);
+
+  /* the screen reports each dimer once, so all preceding ones can be requested in order */
+  while (screen->requested <= complex)
+    vrna_ostream_request(screen->queue, screen->requested++);
+
+  vrna_ostream_provide(screen->queue, (unsigned int)complex, (void *)row);
+}
+
+
+/*
+ *  Compute the free energies of all dimers AB, including homodimers, and
+ *  monomers of the collected input sequences. Each monomer is folded once
+ *  and the rows of the table are printed as soon as they are available
+ */
+static void
+screen_dimers(struct options *opt)
+{
+  unsigned int        k, c, a, ***complexes;
+  char                d;
+  vrna_cstr_t         stream;
+  struct screen_data  screen;
+
+  if (opt->screen_num == 0)
+    return;
+
+  if (opt->verbose)
+    vrna_message_info(stderr,
+                      "Screening %u sequences for dimer formation",
+                      opt->screen_num);
+
+  complexes = (unsigned int ***)vrna_alloc(sizeof(unsigned int **) * 2);
+
+  for (k = 1; k <= 2; k++)
+    complexes[k - 1] = vrna_n_multichoose_k(opt->screen_num, k);
+
+  stream  = vrna_cstr(100, stdout);
+  d       = opt->csv_output_delim;
+
+  if (opt->csv_output) {
+    if (opt->csv_header)
+      vrna_cstr_printf(stream,
+                       "seq_id_A%c"
+                       "seq_id_B%c"
+                       "AB%c"
+                       "A%c"
+                       "B%c"
+                       "dG_binding\n",
+                       d, d, d, d, d);
+  } else {
+    vrna_cstr_printf_comment(stream, "Free Energies:");
+    vrna_cstr_printf_thead(stream, "A\tB\tAB\t\tA\t\tB\t\tdG_binding");
+  }
+
+  vrna_cstr_close(stream);
+
+  screen.opt        = opt;
+  screen.complexes  = complexes[1];
+  screen.dG         = (double *)vrna_alloc(sizeof(double) * opt->screen_num);
+  screen.requested  = 0;
+  screen.queue      = vrna_ostream_init(&screen_write_row, (void *)&screen);
+
+  vrna_pf_complexes_strands_cb((const char **)opt->screen_sequences,
+                               opt->screen_num,
+                               &(opt->md),
+                               complexes,
+                               2,
+                               &screen_store,
+                               (void *)&screen);
+
+  vrna_ostream_free(screen.queue);
+
+  for (k = 1; k <= 2; k++) {
+    for (c = 0; complexes[k - 1][c]; c++)
+      free(complexes[k - 1][c]);
+
+    free(complexes[k - 1]);
+  }
+
+  for (a = 0; a < opt->screen_num; a++) {
+    free(opt->screen_ids[a]);
+    free(opt->screen_sequences[a]);
+  }
+
+  free(complexes);
+  free(screen.dG);
+  free(opt->screen_ids);
+  free(opt->screen_sequences);
+}
+
+
 static void
 write_csv_header(FILE           *output,
                  struct options *opt)
@@ -195,6 +195,32 @@ flush_cstr_callback(void          *auxdata,
 }
 
 
+/*
+ *  Same as flush_cstr_callback() but for the ordered output queue. Data is
+ *  only written to the stream buffers, flushing is done once for each batch
+ *  of consecutive records in flush_output_callback()
+ */
+static void
+write_cstr_callback(void          *auxdata,
+                    unsigned int  i,
+                    void          *data)
+{
+  struct output_stream *s = (struct output_stream *)data;
+
+  vrna_cstr_write(s->err);
+  vrna_cstr_write(s->data);
+
+  flush_cstr_callback(auxdata, i, data);
+}
+
+
+static void
+flush_output_callback(void *auxdata)
+{
+  (void)fflush(NULL);
+}
+
+
 int
 main(int  argc,
      char *argv[])
@@ -321,7 +347,11 @@ main(int  argc,
     vrna_message_error("G-Quadruplex support is currently not available for circular RNA structures");
 
   if (opt.keep_order)
-    opt.output_queue = vrna_ostream_init(&flush_cstr_callback, NULL);
+    opt.output_queue = vrna_ostream_init_bounded(&write_cstr_callback,
+                                                 &flush_output_callback,
+                                                 NULL,
+                                                 0,
+                                                 (opt.jobs > 1) ? VRNA_OSTREAM_WRITER_THREAD : 0);
 
   int (*processing_func)(FILE           *stream,
                          const char     *filename,
@@ -630,9 +660,10 @@ process_record(struct record_data *record)
   /* convert sequence to uppercase letters only */
   vrna_seq_toupper(rec_sequence);
 
-  vc = vrna_fold_compound(rec_sequence,
-                          &(opt->md),
-                          VRNA_OPTION_MFE | VRNA_OPTION_EVAL_ONLY);
+  vc = vrna_fold_compound_pool_acquire(fc_pool,
+                                       rec_sequence,
+                                       &(opt->md),
+                                       VRNA_OPTION_MFE | VRNA_OPTION_EVAL_ONLY);
 
   if (!vc) {
     vrna_message_warning("Skipping computations for \"%s\"",
@@ -767,7 +798,7 @@ process_record(struct record_data *record)
     flush_cstr_callback(NULL, 0, (void *)o_stream);
 
   /* clean up */
-  vrna_fold_compound_free(vc);
+  vrna_fold_compound_pool_release(fc_pool, vc);
   free(record->id);
   free(record->SEQ_ID);
   free(record->sequence);
@@ -96,15 +96,28 @@ struct options {
 };
 
 struct record_data {
-  unsigned int    number;
-  char            *id;
-  char            *sequence;
-  char            *SEQ_ID;
-  char            **rest;
-  char            *input_filename;
-  int             multiline_input;
-  struct options  *options;
-  int             tty;
+  unsigned int        number;
+  char                *id;
+  char                *sequence;
+  char                *SEQ_ID;
+  char                **rest;
+  char                *input_filename;
+  int                 multiline_input;
+  struct options      *options;
+  int                 tty;
+  vrna_fasta_record_t view; /* data set within a memory mapped input file if sequence is NULL */
+};
+
+
+/* number of bytes of a memory mapped input file that are scanned for data sets by a single task */
+#define SHARD_SIZE  (1 << 26)
+
+struct input_shard {
+  vrna_fasta_reader_t reader;
+  vrna_fasta_record_t *records;
+  char                **sequences;  /* copies of sequences that span multiple lines */
+  size_t              num;
+  unsigned int        type;         /* what the reader returned after the last data set */
 };
 
 
@@ -194,6 +207,27 @@ process_input(FILE            *input_stream,
               struct options  *opt);
 
 
+static int
+process_mapped_input(FILE           *input_stream,
+                     const char     *input_filename,
+                     unsigned int   read_opt,
+                     struct options *opt);
+
+
+static void
+scan_shard(struct input_shard *shard);
+
+
+static int
+submit_record(char                      *rec_id,
+              char                      *rec_sequence,
+              char                      **rec_rest,
+              const vrna_fasta_record_t *view,
+              const char                *input_filename,
+              int                       tty,
+              struct options            *opt);
+
+
 static void
 process_record(struct record_data *record);
 
@@ -218,6 +252,32 @@ flush_cstr_callback(void          *auxdata,
 }
 
 
+/*
+ *  Same as flush_cstr_callback() but for the ordered output queue. Data is
+ *  only written to the stream buffers, flushing is done once for each batch
+ *  of consecutive records in flush_output_callback()
+ */
+static void
+write_cstr_callback(void          *auxdata,
+                    unsigned int  i,
+                    void          *data)
+{
+  struct output_stream *s = (struct output_stream *)data;
+
+  if (s)
+    vrna_cstr_write(s->data);
+
+  flush_cstr_callback(auxdata, i, data);
+}
+
+
+static void
+flush_output_callback(void *auxdata)
+{
+  (void)fflush(NULL);
+}
+
+
 static void
 postscript_layout(vrna_fold_compound_t  *fc,
                   const char            *orig_sequence,
@@ -576,7 +636,11 @@ main(int  argc,
     vrna_message_info(stderr, "Preparing %d parallel computation slots", opt.jobs);
 
   if (opt.keep_order)
-    opt.output_queue = vrna_ostream_init(&flush_cstr_callback, NULL);
+    opt.output_queue = vrna_ostream_init_bounded(&write_cstr_callback,
+                                                 &flush_output_callback,
+                                                 NULL,
+                                                 0,
+                                                 (opt.jobs > 1) ? VRNA_OSTREAM_WRITER_THREAD : 0);
 
   /*
    ################################################
@@ -748,15 +812,21 @@ process_input(FILE            *input_stream,
   if (!fold_constrained)
     read_opt |= VRNA_INPUT_NO_REST;
 
+  /* read regular input files through memory mapped readers */
+  if ((input_filename) &&
+      (!istty_in) &&
+      ((ret = process_mapped_input(input_stream, input_filename, read_opt, opt)) >= 0))
+    return ret;
+
+  ret = 1;
+
   /* main loop that processes each record obtained from input stream */
   do {
     char          *rec_sequence, *rec_id, **rec_rest;
     unsigned int  rec_type;
-    int           maybe_multiline;
 
-    rec_id          = NULL;
-    rec_rest        = NULL;
-    maybe_multiline = 0;
+    rec_id    = NULL;
+    rec_rest  = NULL;
 
     rec_type = vrna_file_fasta_read_record(&rec_id,
                                            &rec_sequence,
@@ -767,38 +837,17 @@ process_input(FILE            *input_stream,
     if (rec_type & (VRNA_INPUT_ERROR | VRNA_INPUT_QUIT))
       break;
 
-    /*
-     ########################################################
-     # init everything according to the data we've read
-     ########################################################
-     */
-    if (rec_id) {
-      maybe_multiline = 1;
-      /* remove '>' from FASTA header */
+    /* remove '>' from FASTA header */
+    if (rec_id)
       rec_id = memmove(rec_id, rec_id + 1, strlen(rec_id));
-    }
-
-    /* construct the sequence ID */
-    set_next_id(&rec_id, opt->id_control);
-
-    struct record_data *record = (struct record_data *)vrna_alloc(sizeof(struct record_data));
-
-    record->number          = opt->next_record_number;
-    record->sequence        = rec_sequence;
-    record->SEQ_ID          = fileprefix_from_id(rec_id, opt->id_control, opt->filename_full);
-    record->id              = rec_id;
-    record->rest            = rec_rest;
-    record->multiline_input = maybe_multiline;
-    record->options         = opt;
-    record->tty             = istty_in && istty_out;
-    record->input_filename  = (input_filename) ? strdup(input_filename) : NULL;
-
-    if (opt->output_queue)
-      vrna_ostream_request(opt->output_queue, opt->next_record_number++);
 
-    RUN_IN_PARALLEL(process_record, record);
-
-    if (opt->shape || (opt->constraint_file && (!opt->constraint_batch))) {
+    if (!submit_record(rec_id,
+                       rec_sequence,
+                       rec_rest,
+                       NULL,
+                       input_filename,
+                       istty_in && istty_out,
+                       opt)) {
       ret = 0;
       break;
     }
@@ -819,6 +868,209 @@ process_input(FILE            *input_stream,
 }
 
 
+/*
+ *  Process a regular input file through memory mapped readers. The file is
+ *  split into shards that are scanned for data sets by the workers, a round
+ *  of NUM_WORKERS shards at a time. While the data sets of one round are
+ *  processed, the next round is scanned already. Data sets are handed to
+ *  process_record() as views into the mapped file and copied by the worker
+ *  only. Returns -1 if the file can not be mapped
+ */
+static int
+process_mapped_input(FILE           *input_stream,
+                     const char     *input_filename,
+                     unsigned int   read_opt,
+                     struct options *opt)
+{
+  char                *rec_id;
+  int                 ret, stop;
+  long                size;
+  unsigned int        s, first, last, next, num_shards;
+  size_t              r;
+  vrna_fasta_record_t *rec;
+  struct input_shard  *shards;
+
+  if ((fseek(input_stream, 0, SEEK_END) != 0) ||
+      ((size = ftell(input_stream)) < 0)) {
+    rewind(input_stream);
+    return -1;
+  }
+
+  rewind(input_stream);
+
+  num_shards  = (unsigned int)(size / SHARD_SIZE) + 1;
+  shards      = (struct input_shard *)vrna_alloc(sizeof(struct input_shard) * num_shards);
+
+  if (!(shards[0].reader = vrna_file_fasta_reader(input_filename, 0, num_shards, read_opt))) {
+    free(shards);
+    return -1;
+  }
+
+  ret   = 1;
+  stop  = 0;
+  last  = MIN2(NUM_WORKERS, num_shards);
+
+  /* scan the shards of the first round */
+  for (s = 0; s < last; s++) {
+    if ((s > 0) &&
+        (!(shards[s].reader = vrna_file_fasta_reader(input_filename, s, num_shards, read_opt))))
+      break;
+
+    RUN_IN_PARALLEL(scan_shard, &(shards[s]));
+  }
+
+  WAIT_FOR_ALL_TASKS;
+
+  for (first = 0; first < num_shards; first = last) {
+    last  = MIN2(first + NUM_WORKERS, num_shards);
+    next  = MIN2(last + NUM_WORKERS, num_shards);
+
+    /* scan the shards of the next round in the meantime */
+    for (s = last; (s < next) && (!stop); s++) {
+      if (!(shards[s].reader = vrna_file_fasta_reader(input_filename, s, num_shards, read_opt)))
+        break;
+
+      RUN_IN_PARALLEL(scan_shard, &(shards[s]));
+    }
+
+    for (s = first; s < last; s++) {
+      for (r = 0; (r < shards[s].num) && (!stop); r++) {
+        rec     = shards[s].records + r;
+        rec_id  = NULL;
+
+        if (rec->header) {
+          rec_id = (char *)vrna_alloc(sizeof(char) * (rec->header_length + 1));
+          memcpy(rec_id, rec->header, sizeof(char) * rec->header_length);
+        }
+
+        if (!submit_record(rec_id, NULL, NULL, rec, input_filename, 0, opt)) {
+          ret   = 0;
+          stop  = 1;
+        }
+      }
+
+      /* a single reader would stop here, so data sets of subsequent shards are discarded */
+      if ((!shards[s].reader) ||
+          (shards[s].type & VRNA_INPUT_ERROR) ||
+          (vrna_file_fasta_reader_quit(shards[s].reader)))
+        stop = 1;
+    }
+
+    /* the views of this round must remain valid until all data sets are processed */
+    WAIT_FOR_ALL_TASKS;
+
+    for (s = first; s < last; s++) {
+      for (r = 0; r < shards[s].num; r++)
+        free(shards[s].sequences[r]);
+
+      free(shards[s].sequences);
+      free(shards[s].records);
+      vrna_file_fasta_reader_free(shards[s].reader);
+    }
+
+    if (stop)
+      break;
+  }
+
+  /* release the shards of the next round that may have been scanned already */
+  for (s = last; s < num_shards; s++) {
+    for (r = 0; r < shards[s].num; r++)
+      free(shards[s].sequences[r]);
+
+    free(shards[s].sequences);
+    free(shards[s].records);
+    vrna_file_fasta_reader_free(shards[s].reader);
+  }
+
+  free(shards);
+
+  return ret;
+}
+
+
+/*
+ *  Collect the views of all data sets in a shard. Only sequences that
+ *  span multiple lines are copied, since the reader re-uses their buffer
+ */
+static void
+scan_shard(struct input_shard *shard)
+{
+  size_t              mem;
+  vrna_fasta_record_t record;
+
+  mem = 0;
+
+  while (!((shard->type = vrna_file_fasta_reader_next(shard->reader, &record)) &
+           (VRNA_INPUT_ERROR | VRNA_INPUT_QUIT))) {
+    if (shard->num == mem) {
+      mem               = 2 * mem + 64;
+      shard->records    = (vrna_fasta_record_t *)vrna_realloc(shard->records,
+                                                              sizeof(vrna_fasta_record_t) * mem);
+      shard->sequences  = (char **)vrna_realloc(shard->sequences, sizeof(char *) * mem);
+    }
+
+    shard->sequences[shard->num] = NULL;
+
+    if (record.buffered) {
+      shard->sequences[shard->num] = (char *)vrna_alloc(sizeof(char) * record.length);
+      memcpy(shard->sequences[shard->num], record.sequence, sizeof(char) * record.length);
+      record.sequence = shard->sequences[shard->num];
+    }
+
+    shard->records[shard->num++] = record;
+  }
+}
+
+
+/*
+ *  Prepare a data set for process_record() and submit it. Either
+ *  rec_sequence and rec_rest are set, or the data set is a view into
+ *  a memory mapped input file. Returns 0 if no further data sets are
+ *  to be processed
+ */
+static int
+submit_record(char                      *rec_id,
+              char                      *rec_sequence,
+              char                      **rec_rest,
+              const vrna_fasta_record_t *view,
+              const char                *input_filename,
+              int                       tty,
+              struct options            *opt)
+{
+  struct record_data *record;
+
+  record = (struct record_data *)vrna_alloc(sizeof(struct record_data));
+
+  /* FASTA header present, so the sequence may span multiple lines */
+  record->multiline_input = (rec_id) ? 1 : 0;
+
+  /* construct the sequence ID */
+  set_next_id(&rec_id, opt->id_control);
+
+  record->number          = opt->next_record_number;
+  record->sequence        = rec_sequence;
+  record->SEQ_ID          = fileprefix_from_id(rec_id, opt->id_control, opt->filename_full);
+  record->id              = rec_id;
+  record->rest            = rec_rest;
+  record->options         = opt;
+  record->tty             = tty;
+  record->input_filename  = (input_filename) ? strdup(input_filename) : NULL;
+
+  if (view)
+    record->view = *view;
+
+  if (opt->output_queue)
+    vrna_ostream_request(opt->output_queue, opt->next_record_number++);
+
+  RUN_IN_PARALLEL(process_record, record);
+
+  if (opt->shape || (opt->constraint_file && (!opt->constraint_batch)))
+    return 0;
+
+  return 1;
+}
+
+
 static void
 process_record(struct record_data *record)
 {
@@ -833,6 +1085,13 @@ process_record(struct record_data *record)
 
   opt = record->options;
 
+  /* data sets of memory mapped input files are only copied here */
+  if (!record->sequence) {
+    record->sequence = (char *)vrna_alloc(sizeof(char) * (record->view.length + 1));
+    memcpy(record->sequence, record->view.sequence, sizeof(char) * record->view.length);
+    record->rest = vrna_file_fasta_record_rest(&(record->view));
+  }
+
   rec_sequence = strdup(record->sequence);
 
   mod_positions   = mod_positions_seq_prepare(rec_sequence,
@@ -849,7 +1108,7 @@ process_record(struct record_data *record)
   /* convert sequence to uppercase letters only */
   vrna_seq_toupper(rec_sequence);
 
-  vc = vrna_fold_compound(rec_sequence, &(opt->md), VRNA_OPTION_DEFAULT);
+  vc = vrna_fold_compound_pool_acquire(fc_pool, rec_sequence, &(opt->md), VRNA_OPTION_DEFAULT);
 
   if (!vc) {
     vrna_message_warning("Skipping computations for \"%s\"",
@@ -970,6 +1229,7 @@ process_record(struct record_data *record)
     char *pf_struc = (char *)vrna_alloc(sizeof(char) * (length + 1));
     if (vc->params->model_details.dangles % 2) {
       int dang_bak = vc->params->model_details.dangles;
+      vc->params                        = vrna_params_unshare(vc->params);
       vc->params->model_details.dangles = 2;   /* recompute with dangles as in pf_fold() */
       min_en                            = vrna_eval_structure(vc, mfe_structure);
       vc->params->model_details.dangles = dang_bak;
@@ -1100,7 +1360,7 @@ process_record(struct record_data *record)
   }
 
   /* clean up */
-  vrna_fold_compound_free(vc);
+  vrna_fold_compound_pool_release(fc_pool, vc);
   free(record->id);
   free(record->SEQ_ID);
   free(record->sequence);
@@ -1178,10 +1438,15 @@ compute_MEA(vrna_fold_compound_t  *fc,
    *  while MEA_seq() still expects unresolved gquads */
   int   gq = fc->exp_params->model_details.gquad;
 
-  fc->exp_params->model_details.gquad = 0;
+  if (gq) {
+    fc->exp_params                      = vrna_exp_params_unshare(fc->exp_params);
+    fc->exp_params->model_details.gquad = 0;
+  }
+
   plist *pl = vrna_plist_from_probs(fc, 1e-4 / (1 + MEAgamma));
 
-  fc->exp_params->model_details.gquad = gq;
+  if (gq)
+    fc->exp_params->model_details.gquad = gq;
 
   structure = vrna_MEA(fc, MEAgamma, &mea);
 
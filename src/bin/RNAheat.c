@@ -163,6 +163,32 @@ flush_cstr_callback(void          *auxdata,
 }
 
 
+/*
+ *  Same as flush_cstr_callback() but for the ordered output queue. Data is
+ *  only written to the stream buffers, flushing is done once for each batch
+ *  of consecutive records in flush_output_callback()
+ */
+static void
+write_cstr_callback(void          *auxdata,
+                    unsigned int  i,
+                    void          *data)
+{
+  struct output_stream *s = (struct output_stream *)data;
+
+  vrna_cstr_write(s->err);
+  vrna_cstr_write(s->data);
+
+  flush_cstr_callback(auxdata, i, data);
+}
+
+
+static void
+flush_output_callback(void *auxdata)
+{
+  (void)fflush(NULL);
+}
+
+
 int
 main(int  argc,
      char *argv[])
@@ -235,6 +261,10 @@ main(int  argc,
       opt.mpoints = 100;
   }
 
+  /* number of threads per heat capacity curve */
+  if (args_info.numThreads_given)
+    opt.md.threads = args_info.numThreads_arg;
+
   ggo_geometry_settings(args_info, &(opt.md));
 
   if (args_info.jobs_given) {
@@ -282,7 +312,11 @@ main(int  argc,
     vrna_message_error("G-Quadruplex support is currently not available for circular RNA structures");
 
   if (opt.keep_order)
-    opt.output_queue = vrna_ostream_init(&flush_cstr_callback, NULL);
+    opt.output_queue = vrna_ostream_init_bounded(&write_cstr_callback,
+                                                 &flush_output_callback,
+                                                 NULL,
+                                                 0,
+                                                 (opt.jobs > 1) ? VRNA_OSTREAM_WRITER_THREAD : 0);
 
   /*
    #############################################
@@ -29,6 +29,7 @@
 #include "ViennaRNA/fold.h"
 #include "ViennaRNA/part_func_co.h"
 #include "ViennaRNA/part_func.h"
+#include "ViennaRNA/pf_multifold.h"
 #include "ViennaRNA/centroid.h"
 #include "ViennaRNA/MEA.h"
 #include "ViennaRNA/utils/basic.h"
@@ -225,6 +226,32 @@ flush_cstr_callback(void          *auxdata,
 }
 
 
+/*
+ *  Same as flush_cstr_callback() but for the ordered output queue. Data is
+ *  only written to the stream buffers, flushing is done once for each batch
+ *  of consecutive records in flush_output_callback()
+ */
+static void
+write_cstr_callback(void          *auxdata,
+                    unsigned int  i,
+                    void          *data)
+{
+  struct output_stream *s = (struct output_stream *)data;
+
+  vrna_cstr_write(s->err);
+  vrna_cstr_write(s->data);
+
+  flush_cstr_callback(auxdata, i, data);
+}
+
+
+static void
+flush_output_callback(void *auxdata)
+{
+  (void)fflush(NULL);
+}
+
+
 int
 main(int  argc,
      char *argv[])
@@ -299,6 +326,10 @@ main(int  argc,
       opt.concentration_absolute = 1;
   }
 
+  /* number of threads for the free energies of all complexes */
+  if (args_info.numThreads_given)
+    opt.md.threads = args_info.numThreads_arg;
+
   if (args_info.commands_given)
     opt.cmds = vrna_file_commands_read(args_info.commands_arg, VRNA_CMD_PARSE_DEFAULTS);
 
@@ -367,7 +398,11 @@ main(int  argc,
     vrna_message_info(stderr, "Preparing %d parallel computation slots", opt.jobs);
 
   if (opt.keep_order)
-    opt.output_queue = vrna_ostream_init(&flush_cstr_callback, NULL);
+    opt.output_queue = vrna_ostream_init_bounded(&write_cstr_callback,
+                                                 &flush_output_callback,
+                                                 NULL,
+                                                 0,
+                                                 (opt.jobs > 1) ? VRNA_OSTREAM_WRITER_THREAD : 0);
 
   /*
    ################################################
@@ -730,6 +765,7 @@ process_record(struct record_data *record)
     pairing_propensity  = (char *)vrna_alloc(sizeof(char) * (n + 1));
 
     if (opt->md.dangles == 1) {
+      vc->params                        = vrna_params_unshare(vc->params);
       vc->params->model_details.dangles = 2;   /* recompute with dangles as in pf_fold() */
       min_en                            = vrna_eval_structure(vc, mfe_structure);
       vc->params->model_details.dangles = 1;
@@ -809,136 +845,26 @@ process_record(struct record_data *record)
 
       unsigned int  ***complexes = (unsigned int ***)vrna_alloc(
         sizeof(unsigned int **) * max_interacting_strands);
-      double        **dG_complexes = (double **)vrna_alloc(
-        sizeof(double *) * max_interacting_strands);
-
-      complexes     -= 1;
-      dG_complexes  -= 1;
+      double        **dG_complexes;
 
-      for (size_t k = 1; k <= max_interacting_strands; k++) {
-        size_t num_complexes = 0;
+      complexes -= 1;
 
-        /* enumerate all complexes of current size */
+      /* enumerate all complexes of each size */
+      for (size_t k = 1; k <= max_interacting_strands; k++)
         complexes[k] = vrna_n_multichoose_k(vc->strands, k);
 
-        /* count number of complexes of current size */
-        for (; complexes[k][num_complexes] != NULL; num_complexes++);
-
-        dG_complexes[k] = (double *)vrna_alloc(sizeof(double) * num_complexes);
-
-        char *verbose_line = NULL;
-
-        if (opt->verbose)
-          fprintf(stderr, "Processing complexes of size %lu\n", k);
-
-        for (size_t c_cnt = 0; c_cnt < num_complexes; c_cnt++) {
-          if (opt->verbose) {
-            vrna_strcat_printf(&verbose_line,
-                               "Complex %u/%u (size %d) ",
-                               c_cnt + 1,
-                               num_complexes, k);
-          }
-
-          /* Now, enumerate all non-cyclic permutations for current complex */
-
-          /* first, compose a list of species counts */
-          unsigned int  *species =
-            (unsigned int *)vrna_alloc(sizeof(unsigned int) * (k + 1));
-          unsigned int  *species_count = (unsigned int *)vrna_alloc(
-            sizeof(unsigned int) * vc->strands);
-          unsigned int  *mapping = (unsigned int *)vrna_alloc(
-            sizeof(unsigned int) * vc->strands);
-          size_t        known_species = 0;
-          for (size_t kk = 0; kk < k; kk++)
-            species_count[complexes[k][c_cnt][kk]]++;
-
-          for (size_t kk = 0; kk < vc->strands; kk++) {
-            if (species_count[kk] > 0) {
-              mapping[known_species]  = kk;
-              species[known_species]  = species_count[kk];
-
-              if (opt->verbose) {
-                vrna_strcat_printf(&verbose_line,
-                                   ", %u x %c",
-                                   species_count[kk],
-                                   kk < 26 ? kk + 'A' : kk + 'a');
-              }
-
-              known_species++;
-            }
-          }
-          species[known_species] = 0;
-
-          /* enumerate all non-cyclic permutations of current complex */
-          unsigned int  **permutations = vrna_enumerate_necklaces(species);
-
-          double        dG_current  = 0.;
-          size_t        num_perm    = 0;
-
-          if (opt->verbose)
-            for (; permutations[num_perm]; num_perm++);
-
-          for (size_t i = 0; permutations[i]; i++) {
-            char *current_sequence = NULL;
-
-            if (opt->verbose) {
-              fprintf(stderr, "\r%s, permutation %lu/%lu                    ",
-                      verbose_line,
-                      i + 1, num_perm);
-              fflush(stderr);
-            }
-
-            vrna_strcat_printf(&current_sequence,
-                               "%s",
-                               vc->nucleotides[mapping[permutations[i][1]]].string);
-
-            for (size_t j = 2; j <= k; j++) {
-              vrna_strcat_printf(&current_sequence,
-                                 "&%s",
-                                 vc->nucleotides[mapping[permutations[i][j]]].string);
-            }
-
-            /* for now, do not compute base pair probs */
-            int                   bpp_comp = opt->md.compute_bpp;
-            opt->md.compute_bpp = 0;
-
-            /* compute MFE and PF for current permutation */
-            vrna_fold_compound_t  *fc_current = vrna_fold_compound(current_sequence,
-                                                                   &(opt->md),
-                                                                   VRNA_OPTION_DEFAULT);
-
-            double                mfe_current = vrna_mfe(fc_current, NULL);
-
-            vrna_exp_params_rescale(fc_current, &mfe_current);
-
-            double                F = vrna_pf(fc_current, NULL);
-
-            /* store, or add up contribution from current permutation */
-            dG_current = (i == 0) ? F : vrna_pf_add(dG_current, F, kT);
-
-            free(current_sequence);
-            vrna_fold_compound_free(fc_current);
-
-            /* restore original base pair probs behavior */
-            opt->md.compute_bpp = bpp_comp;
-
-            free(permutations[i]);
-          }
-
-          free(species);
-          free(species_count);
-          free(mapping);
-          free(permutations);
-
-          dG_complexes[k][c_cnt] = dG_current;
-          if (opt->verbose) {
-            free(verbose_line);
-            verbose_line = NULL;
-          }
-        }
-        if (opt->verbose)
-          fprintf(stderr, "\n");
-      }
+      if (opt->verbose)
+        fprintf(stderr,
+                "Processing complexes of size 1 to %lu\n",
+                max_interacting_strands);
+
+      /*
+       *  compute ensemble free energies of all complexes, where
+       *  permutations that share a prefix of strands re-use its
+       *  partition function matrices
+       */
+      dG_complexes = vrna_pf_complexes(vc, complexes + 1, max_interacting_strands);
+      dG_complexes -= 1;
 
       vrna_cstr_printf_comment(o_stream->data, "Free Energies:");
 
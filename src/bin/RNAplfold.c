@@ -28,6 +28,7 @@
 #include "ViennaRNA/constraints/SHAPE.h"
 #include "ViennaRNA/constraints/soft_special.h"
 #include "ViennaRNA/io/file_formats.h"
+#include "ViennaRNA/io/file_formats_plfold.h"
 #include "ViennaRNA/io/utils.h"
 #include "ViennaRNA/commands.h"
 
@@ -75,18 +76,19 @@ isnan_ld(long double x)
 #endif /* ifndef isnan */
 
 typedef struct {
-  float     cutoff;
-  FILE      *pUfp;
-  FILE      *spup;
-  vrna_ep_t *plist;
-  int       plist_cnt;
-  int       plexoutput;
-  int       simply_putout;
-  int       openenergies;
-  double    **pup;
-  int       ulength;
-  int       n;
-  double    kT;
+  float                     cutoff;
+  FILE                      *pUfp;
+  FILE                      *spup;
+  vrna_ep_t                 *plist;
+  int                       plist_cnt;
+  int                       plexoutput;
+  int                       simply_putout;
+  int                       openenergies;
+  double                    **pup;
+  int                       ulength;
+  int                       n;
+  double                    kT;
+  vrna_plfold_bin_writer_t  *bin;
 } plfold_data;
 
 int unpaired;
@@ -148,7 +150,7 @@ main(int  argc,
   unsigned int                rec_type, read_opt;
   int                         length, istty, winsize, pairdist, tempwin, temppair, tempunpaired,
                               noconv, i, plexoutput, simply_putout, openenergies, binaries,
-                              filename_full, with_shapes, verbose;
+                              binary_out, filename_full, with_shapes, verbose;
   float                       cutoff;
   vrna_exp_param_t            *pf_parameters;
   vrna_md_t                   md;
@@ -164,6 +166,7 @@ main(int  argc,
   unpaired            = 0;
   simply_putout       = plexoutput = openenergies = noconv = 0;
   binaries            = 0;
+  binary_out          = 0;
   tempwin             = temppair = tempunpaired = 0;
   structure           = ParamFile = ns_bases = NULL;
   rec_type            = read_opt = 0;
@@ -260,6 +263,10 @@ main(int  argc,
   if (args_info.ulength_given)
     unpaired = args_info.ulength_arg;
 
+  /* number of threads for the sliding window computations */
+  if (args_info.numThreads_given)
+    md.threads = args_info.numThreads_arg;
+
   /* compute opening energies */
   if (args_info.opening_energies_given)
     openenergies = 1;
@@ -276,6 +283,10 @@ main(int  argc,
   if (args_info.binaries_given)
     binaries = 1;
 
+  /* turn on memory-mappable binary output */
+  if (args_info.binary_output_given)
+    binary_out = 1;
+
   /* check for errorneous parameter options */
   if ((pairdist < 0) || (cutoff < 0.) || (unpaired < 0) || (winsize < 0)) {
     RNAplfold_cmdline_parser_print_help();
@@ -459,7 +470,7 @@ main(int  argc,
 
     if (length > 0) {
       /* construct output file names */
-      char *fname1, *fname2, *fname3, *fname4, *ffname, *tmp_string;
+      char *fname1, *fname2, *fname3, *fname4, *fname5, *ffname, *tmp_string;
 
       if (!SEQ_ID)
         SEQ_ID = strdup("plfold");
@@ -475,7 +486,8 @@ main(int  argc,
                 vrna_strdup_printf("%s%sopenen",
                                    SEQ_ID,
                                    filename_delim);
-      ffname = vrna_strdup_printf("%s%sdp.ps", SEQ_ID, filename_delim);
+      fname5  = vrna_strdup_printf("%s%splfold.bin", SEQ_ID, filename_delim);
+      ffname  = vrna_strdup_printf("%s%sdp.ps", SEQ_ID, filename_delim);
 
       /* sanitize filenames */
       tmp_string = vrna_filename_sanitize(fname1, filename_delim);
@@ -490,6 +502,9 @@ main(int  argc,
       tmp_string  = vrna_filename_sanitize(fname4, filename_delim);
       free(fname4);
       fname4      = tmp_string;
+      tmp_string  = vrna_filename_sanitize(fname5, filename_delim);
+      free(fname5);
+      fname5      = tmp_string;
       tmp_string  = vrna_filename_sanitize(ffname, filename_delim);
       free(ffname);
       ffname = tmp_string;
@@ -525,7 +540,23 @@ main(int  argc,
       plfold_data data;
 
       data.cutoff         = cutoff;
-      data.spup           = (simply_putout) ? fopen(fname2, "w") : NULL;
+      data.bin            = NULL;
+
+      if (binary_out) {
+        /* everything goes to the binary file while it is computed */
+        data.bin = vrna_file_plfold_bin_writer(fname5,
+                                               length,
+                                               fc->window_size,
+                                               fc->params->model_details.max_bp_span,
+                                               unpaired,
+                                               cutoff);
+        if (!data.bin) {
+          vrna_message_warning("Failed to open binary output file %s", fname5);
+          goto rnaplfold_exit;
+        }
+      }
+
+      data.spup           = ((simply_putout) && (!data.bin)) ? fopen(fname2, "w") : NULL;
       data.plexoutput     = plexoutput;
       data.simply_putout  = simply_putout;
       data.openenergies   = openenergies;
@@ -535,7 +566,7 @@ main(int  argc,
       data.n              = length;
       data.kT             = pf_parameters->kT;
 
-      if (unpaired > 0) {
+      if ((unpaired > 0) && (!data.bin)) {
         if (simply_putout) {
           data.pup  = NULL;
           data.pUfp = fopen(openenergies ? fname4 : fname1, "w");
@@ -564,13 +595,19 @@ main(int  argc,
       /* perform recursions */
       int r = vrna_probs_window(fc, unpaired, plfold_opt, &plfold_callback, (void *)&data);
 
+      if ((data.bin) &&
+          (!vrna_file_plfold_bin_writer_close(data.bin))) {
+        vrna_message_warning("Failed to write binary output file %s", fname5);
+        r = 0;
+      }
+
       if (!r) {
         vrna_message_warning("Something bad happened while processing the input! "
                              "Aborting now...");
         goto rnaplfold_exit;
       }
 
-      if (!simply_putout) {
+      if ((!simply_putout) && (!data.bin)) {
         /* create dot plot output */
         PS_dot_plot_turn(orig_sequence, data.plist, ffname, pairdist);
 
@@ -630,6 +667,7 @@ main(int  argc,
       free(fname2);
       free(fname3);
       free(fname4);
+      free(fname5);
       free(ffname);
     }
 
@@ -756,6 +794,11 @@ plfold_callback(FLT_OR_DBL    *pr,
 
   d = (plfold_data *)data;
 
+  if (d->bin) {
+    vrna_file_plfold_bin_cb(pr, pr_size, i, max, type, (void *)d->bin);
+    return;
+  }
+
   if (type & VRNA_PROBS_WINDOW_BPP) {
     if (!d->simply_putout) {
       /* store pair probabilities in plist */
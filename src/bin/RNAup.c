@@ -21,6 +21,8 @@
 #include <float.h>
 #include "ViennaRNA/fold.h"
 #include "ViennaRNA/fold_vars.h"
+#include "ViennaRNA/fold_compound.h"
+#include "ViennaRNA/mfe.h"
 #include "ViennaRNA/params/io.h"
 #include "ViennaRNA/plotting/probabilities.h"
 #include "ViennaRNA/utils/basic.h"
@@ -33,14 +35,104 @@
 #include "ViennaRNA/constraints/basic.h"
 #include "ViennaRNA/constraints/hard.h"
 #include "ViennaRNA/constraints/soft.h"
+#include "ViennaRNA/datastructures/char_stream.h"
+#include "ViennaRNA/datastructures/stream_output.h"
 
 #include "gengetopt_helpers.h"
+#include "parallel_helpers.h"
 #include "RNAup_cmdl.h"
 
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
 #define MAX(x, y) (((x) > (y)) ? (x) : (y))
 #define EQUAL(A, B) (fabs((A)-(B)) < 1000 * DBL_EPSILON)
 
+struct options {
+  int                   w;
+  int                   incr3;
+  int                   incr5;
+  int                   header;
+  int                   output;
+  int                   max_u;
+  int                   **unpaired_values;
+  char                  *my_contrib;
+  char                  *cmdl_parameters;
+  vrna_md_t             md;
+
+  int                   jobs;
+  unsigned int          next_record_number;
+  vrna_ostream_t        output_queue;
+
+  /* the first sequence in --interaction_first mode, shared (read-only) by all records */
+  char                  *target;
+  char                  *target_orig;
+  char                  *target_fname;
+  char                  *target_cstruc;
+  vrna_fold_compound_t  *target_fc;
+  pu_contrib            *target_unstr;
+};
+
+
+struct record_data {
+  unsigned int    number;
+  unsigned int    up_mode;
+  char            *headers;
+  char            *s1;
+  char            *s2;
+  char            *orig_s1;
+  char            *orig_s2;
+  char            *cstruc1;
+  char            *cstruc2;
+  char            *fname1;
+  char            *fname2;
+  char            *up_out;
+  struct options  *options;
+};
+
+
+struct output_stream {
+  vrna_cstr_t     data;
+  vrna_cstr_t     err;
+
+  /* the output file is written in input order as well, see write_output_callback() */
+  unsigned int    up_mode;
+  char            *name;
+  char            *head;
+  pu_contrib      *contrib1;
+  pu_contrib      *contrib2;
+  pu_contrib      *unstr;
+  interact        *inter_out;
+  struct options  *options;
+};
+
+
+PRIVATE void
+process_record(struct record_data *record);
+
+
+PRIVATE pu_contrib *
+unstructured(const char           *sequence,
+             const char           *constraint,
+             int                  w,
+             vrna_md_t            *md,
+             vrna_cstr_t          err,
+             vrna_fold_compound_t **fc_p);
+
+
+PRIVATE void
+prepare_target(struct options *opt,
+               int            length);
+
+
+PRIVATE void
+write_output_callback(void          *auxdata,
+                      unsigned int  i,
+                      void          *data);
+
+
+PRIVATE void
+flush_output_callback(void *auxdata);
+
+
 PRIVATE void
 tokenize(char *line,
          char **seq1,
@@ -55,19 +147,21 @@ seperate_bp(char  **inter,
 
 
 PRIVATE void
-print_interaction(interact    *Int,
-                  char        *s1,
-                  char        *s2,
-                  pu_contrib  *p_c,
-                  pu_contrib  *p_c2,
-                  int         w,
-                  int         incr3,
-                  int         incr5);
+print_interaction(struct output_stream  *o_stream,
+                  interact              *Int,
+                  char                  *s1,
+                  char                  *s2,
+                  pu_contrib            *p_c,
+                  pu_contrib            *p_c2,
+                  int                   w,
+                  int                   incr3,
+                  int                   incr5);
 
 
 PRIVATE void
-print_unstru(pu_contrib *p_c,
-             int        w);
+print_unstru(vrna_cstr_t  stream,
+             pu_contrib   *p_c,
+             int          w);
 
 
 PRIVATE int
@@ -94,23 +188,19 @@ main(int  argc,
      char *argv[])
 {
   struct RNAup_args_info  args_info;
+  struct options          opt;
   unsigned int            input_type, up_mode;
-  char                    my_contrib[10], *up_out, *name, fname1[FILENAME_MAX_LENGTH],
+  char                    my_contrib[10], *up_out, fname1[FILENAME_MAX_LENGTH],
                           fname2[FILENAME_MAX_LENGTH], fname_target[FILENAME_MAX_LENGTH],
                           *ParamFile,
-                          *ns_bases, *c, *structure, *head, *input_string, *s1, *s2, *s3, *s_target,
+                          *ns_bases, *c, *headers, *input_string, *s1, *s2, *s3, *s_target,
                           *cstruc1,
-                          *cstruc2, *cstruc_target, *cstruc_combined, *cmdl_parameters, *orig_s1,
+                          *cstruc2, *cstruc_target, *cmdl_parameters, *orig_s1,
                           *orig_s2,
                           *orig_target;
-  int         i, j, length1, length2, length_target, sym, istty,
-              noconv, max_u, **unpaired_values, ulength_num;
-  double      min_en, sfact;
-
-  /* variables for output */
-  pu_contrib  *unstr_out, *unstr_short, *unstr_target, *contrib1, *contrib2;
-  interact    *inter_out;
-  /* pu_out *longer; */
+  int         i, length1, length2, length_target, sym, istty,
+              noconv, max_u, **unpaired_values, ulength_num, jobs;
+  double      sfact;
 
   /* commandline parameters */
   int         w       = 25;             /* length of region of interaction */
@@ -133,12 +223,10 @@ main(int  argc,
   sfact         = 1.07;
   dangles       = 2;
   do_backtrack  = 1;
-  input_string  = s1 = s2 = s3 = s_target = cstruc1 = cstruc2 = cstruc_target = cstruc_combined =
-    NULL;
+  jobs          = 1;
+  input_string  = s1 = s2 = s3 = s_target = cstruc1 = cstruc2 = cstruc_target = NULL;
   length1         = length2 = length_target = 0;
-  inter_out       = NULL;
-  unstr_out       = unstr_short = unstr_target = contrib1 = contrib2 = NULL;
-  structure       = ParamFile = ns_bases = head = orig_s1 = orig_s2 = orig_target = NULL;
+  ParamFile       = ns_bases = headers = orig_s1 = orig_s2 = orig_target = NULL;
   up_out          = NULL;
   fname_target[0] = '\0';
   /* allocate init length for commandline parameter string */
@@ -315,6 +403,31 @@ main(int  argc,
       vrna_strcat_printf(&cmdl_parameters, "-c %s ", my_contrib);
   }
 
+  /* process input in parallel */
+  if (args_info.jobs_given) {
+#if VRNA_WITH_PTHREADS
+    int thread_max = max_user_threads();
+    if (args_info.jobs_arg == 0) {
+      /* use maximum of concurrent threads */
+      int proc_cores, proc_cores_conf;
+      if (num_proc_cores(&proc_cores, &proc_cores_conf)) {
+        jobs = MIN2(thread_max, proc_cores_conf);
+      } else {
+        vrna_message_warning("Could not determine number of available processor cores!\n"
+                             "Defaulting to serial computation");
+        jobs = 1;
+      }
+    } else {
+      jobs = MIN2(thread_max, args_info.jobs_arg);
+    }
+
+    jobs = MAX2(1, jobs);
+#else
+    vrna_message_warning(
+      "This version of RNAup has been built without parallel input processing capabilities");
+#endif
+  }
+
   /* set length(s) of unpaired (unstructured) region(s) */
   int min, max, tmp;
 
@@ -421,6 +534,30 @@ main(int  argc,
   }
 
   RT = ((temperature + K0) * GASCONST / 1000.0);
+
+  memset(&opt, 0, sizeof(struct options));
+  set_model_details(&(opt.md));
+  opt.md.sfact        = sfact;
+  opt.md.compute_bpp  = 1;
+
+  opt.w               = w;
+  opt.incr3           = incr3;
+  opt.incr5           = incr5;
+  opt.header          = header;
+  opt.output          = output;
+  opt.max_u           = max_u;
+  opt.unpaired_values = unpaired_values;
+  opt.my_contrib      = my_contrib;
+  opt.cmdl_parameters = cmdl_parameters;
+  opt.jobs            = jobs;
+  opt.output_queue    = vrna_ostream_init_bounded(&write_output_callback,
+                                                  &flush_output_callback,
+                                                  NULL,
+                                                  0,
+                                                  (jobs > 1) ? VRNA_OSTREAM_WRITER_THREAD : 0);
+
+  INIT_PARALLELIZATION(opt.jobs);
+
   /*
    #############################################
    # main loop: continue until end of file
@@ -465,7 +602,7 @@ main(int  argc,
     /* extract filename from fasta header if available */
     while ((input_type = get_input_line(&input_string, 0)) & VRNA_INPUT_FASTA_HEADER) {
       (void)sscanf(input_string, "%" XSTR(FILENAME_ID_LENGTH) "s", fname1);
-      printf(">%s\n", input_string); /* print fasta header if available */
+      vrna_strcat_printf(&headers, ">%s\n", input_string); /* print fasta header if available */
       free(input_string);
     }
 
@@ -517,7 +654,7 @@ main(int  argc,
       /* extract filename from fasta header if available */
       while ((input_type = get_input_line(&input_string, 0)) & VRNA_INPUT_FASTA_HEADER) {
         (void)sscanf(input_string, "%" XSTR(FILENAME_ID_LENGTH) "s", fname2);
-        printf(">%s\n", input_string); /* print fasta header if available */
+        vrna_strcat_printf(&headers, ">%s\n", input_string); /* print fasta header if available */
         free(input_string);
       }
       /* break on any error, EOF or quit request */
@@ -666,6 +803,15 @@ main(int  argc,
      ########################################################
      */
 
+    /* the probabilities to be unstructured of the target are computed only once */
+    if ((up_mode & RNA_UP_MODE_3) && (opt.target_unstr == NULL)) {
+      opt.target        = s_target;
+      opt.target_orig   = orig_target;
+      opt.target_fname  = fname_target;
+      opt.target_cstruc = cstruc_target;
+      prepare_target(&opt, length_target);
+    }
+
     /* compose file names */
 
     /* first file name */
@@ -684,231 +830,346 @@ main(int  argc,
     if (!(up_mode & RNA_UP_MODE_1))
       vrna_strcat_printf(&up_out, "_w%d", w);
 
-    structure =
-      (char *)vrna_alloc(sizeof(char) * (MAX2(length_target, MAX2(length1, length2)) + 1));
+    struct record_data *record = (struct record_data *)vrna_alloc(sizeof(struct record_data));
 
+    record->number  = opt.next_record_number;
+    record->up_mode = up_mode;
+    record->headers = headers;
+    record->s1      = s1;
+    record->s2      = s2;
+    record->orig_s1 = orig_s1;
+    record->orig_s2 = orig_s2;
+    record->cstruc1 = cstruc1;
+    record->cstruc2 = cstruc2;
+    record->fname1  = strdup(fname1);
+    record->fname2  = strdup(fname2);
+    record->up_out  = up_out;
+    record->options = &opt;
 
-    /* begin actual computations */
-    update_fold_params();
+    vrna_ostream_request(opt.output_queue, opt.next_record_number++);
 
-    /* calc mfe of first sequence */
-    if (cstruc1 != NULL)
-      strncpy(structure, cstruc1, length1 + 1);
+    RUN_IN_PARALLEL(process_record, record);
 
-    min_en = fold(s1, structure);
+    headers = s1 = s2 = orig_s1 = orig_s2 = cstruc1 = cstruc2 = up_out = NULL;
+  } while (1);
 
-    (void)fflush(stdout);
+  UNINIT_PARALLELIZATION
 
-    /* calc probability to be unstructured for 1st sequence (in upmode=3 this is not the target!) */
+  vrna_ostream_free(opt.output_queue);
 
-    int wplus = w;
-    if (!(up_mode & RNA_UP_MODE_3)) {
-      wplus += incr3 + incr5;
-      /* reset window size if maximum unstructured region is exceeds it */
-      if (max_u > wplus)
-        wplus = max_u;
-    }
+  free_pu_contrib_struct(opt.target_unstr);
+  vrna_fold_compound_free(opt.target_fc);
+  free(s_target);
+  free(orig_target);
+  free(cstruc_target);
+  free(headers);
+  free(cmdl_parameters);
 
-    /* reset window size if sequence length is shorter */
-    if (length1 < wplus)
-      wplus = length1;
+  return EXIT_SUCCESS;
+}
 
-    /* calc mfe for first sequence (2nd if upmode = 3) */
-    if (cstruc1 != NULL)
-      strncpy(structure, cstruc1, length1 + 1);
 
-    min_en    = fold(s1, structure);
-    pf_scale  = exp(-(sfact * min_en) / RT / length1);
-    if (length1 > 2000)
-      vrna_message_info(stderr, "scaling factor %f", pf_scale);
+PRIVATE void
+process_record(struct record_data *record)
+{
+  unsigned int          up_mode;
+  int                   i, j, w, incr3, incr5, length1, length2, length_target, wplus;
+  char                  *s1, *s2, *cstruc_combined;
+  pu_contrib            *unstr_out, *unstr_target;
+  interact              *inter_out;
+  vrna_fold_compound_t  *fc;
+  struct options        *opt;
+  struct output_stream  *o_stream;
+
+  opt             = record->options;
+  up_mode         = record->up_mode;
+  w               = opt->w;
+  incr3           = opt->incr3;
+  incr5           = opt->incr5;
+  s1              = record->s1;
+  s2              = record->s2;
+  length1         = (int)strlen(s1);
+  length2         = (s2) ? (int)strlen(s2) : 0;
+  length_target   = (opt->target) ? (int)strlen(opt->target) : 0;
+  unstr_target    = opt->target_unstr;
+  cstruc_combined = NULL;
+  inter_out       = NULL;
 
-    if (cstruc1 != NULL)
-      strncpy(structure, cstruc1, length1 + 1);
+  o_stream          = (struct output_stream *)vrna_alloc(sizeof(struct output_stream));
+  o_stream->data    = vrna_cstr(6 * length1, stdout);
+  o_stream->err     = vrna_cstr(length1, stderr);
+  o_stream->up_mode = up_mode;
+  o_stream->options = opt;
+
+  if (record->headers)
+    vrna_cstr_printf(o_stream->data, "%s", record->headers);
+
+  /* calc probability to be unstructured for 1st sequence (in upmode=3 this is not the target!) */
+  wplus = w;
+  if (!(up_mode & RNA_UP_MODE_3)) {
+    wplus += incr3 + incr5;
+    /* reset window size if maximum unstructured region is exceeds it */
+    if (opt->max_u > wplus)
+      wplus = opt->max_u;
+  }
 
-    (void)pf_fold(s1, structure);
-    unstr_out = pf_unstru(s1, wplus);
-    free_pf_arrays();
+  /* reset window size if sequence length is shorter */
+  if (length1 < wplus)
+    wplus = length1;
+
+  unstr_out       = unstructured(s1, record->cstruc1, wplus, &(opt->md), o_stream->err, &fc);
+  o_stream->unstr = unstr_out;
+
+  if (record->cstruc1) {
+    if (up_mode & RNA_UP_MODE_2) {
+      cstruc_combined = (char *)vrna_alloc(sizeof(char) * (length1 + length2 + 1));
+      strncpy(cstruc_combined, record->cstruc1, length1 + 1);
+      strcat(cstruc_combined, record->cstruc2);
+    } else if (up_mode & RNA_UP_MODE_3) {
+      cstruc_combined = (char *)vrna_alloc(sizeof(char) * (length_target + length1 + 1));
+      strncpy(cstruc_combined, opt->target_cstruc, length_target + 1);
+      strcat(cstruc_combined, record->cstruc1);
+    }
+  }
 
-    if (fold_constrained) {
-      if (up_mode & RNA_UP_MODE_2) {
-        cstruc_combined = (char *)vrna_alloc(sizeof(char) * (length1 + length2 + 1));
-        strncpy(cstruc_combined, cstruc1, length1 + 1);
-        strcat(cstruc_combined, cstruc2);
-      } else if (up_mode & RNA_UP_MODE_3) {
-        cstruc_combined = (char *)vrna_alloc(sizeof(char) * (length_target + length1 + 1));
-        strncpy(cstruc_combined, cstruc_target, length_target + 1);
-        strcat(cstruc_combined, cstruc1);
+  switch (up_mode) {
+    case RNA_UP_MODE_1:
+      for (i = 1; i <= opt->unpaired_values[0][0]; i++) {
+        j = opt->unpaired_values[i][0];
+        do
+          print_unstru(o_stream->data, unstr_out, j);
+        while (++j <= opt->unpaired_values[i][1]);
+      }
+      if (opt->output && opt->header)
+        o_stream->head = vrna_strdup_printf("# %s\n# %d %s\n# %s",
+                                            opt->cmdl_parameters,
+                                            length1,
+                                            record->fname1,
+                                            record->orig_s1);
+
+      o_stream->contrib1 = unstr_out;
+      break;
+    case RNA_UP_MODE_2:
+      inter_out = vrna_pf_interact(fc, s2, unstr_out, NULL, w, cstruc_combined, incr3, incr5);
+      print_interaction(o_stream,
+                        inter_out,
+                        record->orig_s1,
+                        record->orig_s2,
+                        unstr_out,
+                        NULL,
+                        w,
+                        incr3,
+                        incr5);
+      if (opt->output && opt->header)
+        o_stream->head = vrna_strdup_printf("# %s\n# %d %s\n# %s\n# %d %s\n# %s",
+                                            opt->cmdl_parameters,
+                                            length1,
+                                            record->fname1,
+                                            record->orig_s1,
+                                            length2,
+                                            record->fname2,
+                                            record->orig_s2);
+
+      o_stream->contrib1 = unstr_out;
+      break;
+    case RNA_UP_MODE_3:
+      /* check if target sequence is actually longer than query, if not rotate both sequences */
+      if (length_target < length1) {
+        inter_out = vrna_pf_interact(fc,
+                                     opt->target,
+                                     unstr_out,
+                                     unstr_target,
+                                     w,
+                                     cstruc_combined,
+                                     incr3,
+                                     incr5);
+        print_interaction(o_stream,
+                          inter_out,
+                          record->orig_s1,
+                          opt->target_orig,
+                          unstr_out,
+                          unstr_target,
+                          w,
+                          incr3,
+                          incr5);
+        o_stream->contrib1  = unstr_out;
+        o_stream->contrib2  = unstr_target;
+      } else {
+        inter_out = vrna_pf_interact(opt->target_fc,
+                                     s1,
+                                     unstr_target,
+                                     unstr_out,
+                                     w,
+                                     cstruc_combined,
+                                     incr3,
+                                     incr5);
+        print_interaction(o_stream,
+                          inter_out,
+                          opt->target_orig,
+                          record->orig_s1,
+                          unstr_target,
+                          unstr_out,
+                          w,
+                          incr3,
+                          incr5);
+        o_stream->contrib1  = unstr_target;
+        o_stream->contrib2  = unstr_out;
       }
-    }
 
-    contrib1  = contrib2 = NULL;
-    inter_out = NULL;
+      if (opt->output && opt->header)
+        o_stream->head = vrna_strdup_printf("# %s\n# %d %s\n# %s\n# %d %s\n# %s",
+                                            opt->cmdl_parameters,
+                                            length_target,
+                                            opt->target_fname,
+                                            opt->target_orig,
+                                            length1,
+                                            record->fname1,
+                                            record->orig_s1);
+
+      break;
+  }
 
-    switch (up_mode) {
-      case RNA_UP_MODE_1:
-        for (i = 1; i <= unpaired_values[0][0]; i++) {
-          j = unpaired_values[i][0];
-          do
-            print_unstru(unstr_out, j);
-          while (++j <= unpaired_values[i][1]);
-        }
-        if (output && header)
-          head =
-            vrna_strdup_printf("# %s\n# %d %s\n# %s", cmdl_parameters, length1, fname1, orig_s1);
+  o_stream->inter_out = inter_out;
 
-        contrib1 = unstr_out;
-        break;
-      case RNA_UP_MODE_2:
-        inter_out = pf_interact(s1, s2, unstr_out, NULL, w, cstruc_combined, incr3, incr5);
-        print_interaction(inter_out, orig_s1, orig_s2, unstr_out, NULL, w, incr3, incr5);
-        if (output && header)
-          head = vrna_strdup_printf("# %s\n# %d %s\n# %s\n# %d %s\n# %s",
-                                    cmdl_parameters,
-                                    length1,
-                                    fname1,
-                                    orig_s1,
-                                    length2,
-                                    fname2,
-                                    orig_s2);
-
-        contrib1 = unstr_out;
-        break;
-      case RNA_UP_MODE_3:   /* calculate prob. unstruct. for target seq */
-        if (unstr_target == NULL) {
-          wplus = w + incr3 + incr5;
-          if (max_u > wplus)
-            wplus = max_u;
+  /* create additional output */
+  if (opt->output) {
+    /* since we do not limit the amount of ulength values anymore we just put
+     * the maximum length into the filename, the actual printed lengths
+     * should be somewhere in the output itself */
+    o_stream->name = vrna_strdup_printf("%s_u%d.out", record->up_out, opt->unpaired_values[0][0]);
+    vrna_cstr_printf(o_stream->data, "RNAup output in file: %s\n", o_stream->name);
+  }
 
-          if (length_target < wplus)
-            wplus = length_target;
+  vrna_ostream_provide(opt->output_queue, record->number, (void *)o_stream);
 
-          if (cstruc_target != NULL)
-            strncpy(structure, cstruc_target, length_target + 1);
+  /*
+   ########################################################
+   # clean up
+   ########################################################
+   */
+  vrna_fold_compound_free(fc);
+  free(cstruc_combined);
+  free(record->headers);
+  free(record->s1);
+  free(record->s2);
+  free(record->orig_s1);
+  free(record->orig_s2);
+  free(record->cstruc1);
+  free(record->cstruc2);
+  free(record->fname1);
+  free(record->fname2);
+  free(record->up_out);
+  free(record);
+}
 
-          min_en    = fold(s_target, structure);
-          pf_scale  = exp(-(sfact * min_en) / RT / length_target);
-          if (length_target > 2000)
-            vrna_message_info(stderr, "scaling factor %f", pf_scale);
 
-          if (cstruc_target != NULL)
-            strncpy(structure, cstruc_target, length_target + 1);
+/* compute the probabilities to be unstructured for a single sequence */
+PRIVATE pu_contrib *
+unstructured(const char           *sequence,
+             const char           *constraint,
+             int                  w,
+             vrna_md_t            *md,
+             vrna_cstr_t          err,
+             vrna_fold_compound_t **fc_p)
+{
+  unsigned int          n;
+  double                min_en;
+  pu_contrib            *pu;
+  vrna_fold_compound_t  *fc;
 
-          (void)pf_fold(s_target, structure);
-          unstr_target = pf_unstru(s_target, wplus);
-          free_pf_arrays();                     /* for arrays for pf_fold(...) */
-        }
+  n   = (unsigned int)strlen(sequence);
+  fc  = vrna_fold_compound(sequence, md, VRNA_OPTION_DEFAULT);
 
-        /* check if target sequence is actually longer than query, if not rotate both sequences */
-        if (length_target < length1) {
-          inter_out = pf_interact(s1,
-                                  s_target,
-                                  unstr_out,
-                                  unstr_target,
-                                  w,
-                                  cstruc_combined,
-                                  incr3,
-                                  incr5);
-          print_interaction(inter_out,
-                            orig_s1,
-                            orig_target,
-                            unstr_out,
-                            unstr_target,
-                            w,
-                            incr3,
-                            incr5);
-          contrib1  = unstr_out;
-          contrib2  = unstr_target;
-        } else {
-          inter_out = pf_interact(s_target,
-                                  s1,
-                                  unstr_target,
-                                  unstr_out,
-                                  w,
-                                  cstruc_combined,
-                                  incr3,
-                                  incr5);
-          print_interaction(inter_out,
-                            orig_target,
-                            orig_s1,
-                            unstr_target,
-                            unstr_out,
-                            w,
-                            incr3,
-                            incr5);
-          contrib1  = unstr_target;
-          contrib2  = unstr_out;
-        }
+  if (constraint)
+    vrna_constraints_add(fc,
+                         constraint,
+                         VRNA_CONSTRAINT_DB
+                         | VRNA_CONSTRAINT_DB_PIPE
+                         | VRNA_CONSTRAINT_DB_DOT
+                         | VRNA_CONSTRAINT_DB_X
+                         | VRNA_CONSTRAINT_DB_ANG_BRACK
+                         | VRNA_CONSTRAINT_DB_RND_BRACK);
 
-        if (output && header)
-          head = vrna_strdup_printf("# %s\n# %d %s\n# %s\n# %d %s\n# %s",
-                                    cmdl_parameters,
-                                    length_target,
-                                    fname_target,
-                                    orig_target,
-                                    length1,
-                                    fname1,
-                                    orig_s1);
+  /* calc mfe to get a reasonable scaling factor for the partition function */
+  min_en = (double)vrna_mfe(fc, NULL);
+  vrna_exp_params_rescale(fc, &min_en);
 
-        break;
-    }
+  if (n > 2000)
+    vrna_cstr_message_info(err, "scaling factor %f", fc->exp_params->pf_scale);
 
-    /* create additional output */
-    if (output) {
-      /* how to best compose a reasonable filename */
-      printf("RNAup output in file: ");
-      /* since we do not limit the amount of ulength values anymore we just put
-       * the maximum length into the filename, the actual printed lengths
-       * should be somewhere in the output itself */
-      name = vrna_strdup_printf("%s_u%d.out", up_out, unpaired_values[0][0]);
-      printf("%s\n", name);
-
-      Up_plot(contrib1, contrib2, inter_out, name, unpaired_values, my_contrib, head, up_mode);
-    }
+  (void)vrna_pf(fc, NULL);
+  pu = vrna_pf_unstru(fc, w);
 
-    /*
-     ########################################################
-     # clean up
-     ########################################################
-     */
+  *fc_p = fc;
 
-    /* we can save the pu contribution structure of the target sequence for the next run */
-    if (unstr_target != NULL) {
-      if (length_target < length1)
-        free_pu_contrib_struct(contrib1);
-      else
-        free_pu_contrib_struct(contrib2);
-    } else {
-      if (contrib1 != NULL)
-        free_pu_contrib_struct(contrib1);
+  return pu;
+}
 
-      if (contrib2 != NULL)
-        free_pu_contrib_struct(contrib2);
-    }
 
-    if (inter_out != NULL)
-      free_interact(inter_out);
-
-    /* free all unnecessary character arrays */
-    free(structure);
-    free(s1);
-    free(s2);
-    free(orig_s1);
-    free(orig_s2);
-    free(cstruc1);
-    free(cstruc2);
-    free(head);
-    free(cstruc_combined);
-    free(up_out);
-    free(name);
-
-    structure = s1 = s2 = orig_s1 = orig_s2 = cstruc1 = cstruc2 = head = cstruc_combined = NULL;
-    up_out    = name = NULL;
-
-    free_arrays(); /* for arrays for fold(...) */
-  } while (1);
-  free(cmdl_parameters);
+PRIVATE void
+prepare_target(struct options *opt,
+               int            length)
+{
+  int         wplus;
+  vrna_cstr_t err;
+
+  wplus = opt->w + opt->incr3 + opt->incr5;
+  if (opt->max_u > wplus)
+    wplus = opt->max_u;
+
+  if (length < wplus)
+    wplus = length;
+
+  err               = vrna_cstr(length, stderr);
+  opt->target_unstr = unstructured(opt->target,
+                                   opt->target_cstruc,
+                                   wplus,
+                                   &(opt->md),
+                                   err,
+                                   &(opt->target_fc));
+  vrna_cstr_free(err);
+}
 
-  return EXIT_SUCCESS;
+
+/*
+ *  Output of each record is written in input order, including the file
+ *  created by Up_plot() which may be appended to by several records
+ */
+PRIVATE void
+write_output_callback(void          *auxdata,
+                      unsigned int  i,
+                      void          *data)
+{
+  struct output_stream  *s    = (struct output_stream *)data;
+  struct options        *opt  = s->options;
+
+  vrna_cstr_write(s->err);
+  vrna_cstr_write(s->data);
+
+  if (s->name)
+    Up_plot(s->contrib1,
+            s->contrib2,
+            s->inter_out,
+            s->name,
+            opt->unpaired_values,
+            opt->my_contrib,
+            s->head,
+            s->up_mode);
+
+  vrna_cstr_free(s->err);
+  vrna_cstr_free(s->data);
+  free_pu_contrib_struct(s->unstr);
+  free_interact(s->inter_out);
+  free(s->name);
+  free(s->head);
+  free(s);
+}
+
+
+PRIVATE void
+flush_output_callback(void *auxdata)
+{
+  (void)fflush(NULL);
 }
 
 
@@ -1180,14 +1441,15 @@ seperate_bp(char  **inter,
 
 
 PRIVATE void
-print_interaction(interact    *Int,
-                  char        *s1,
-                  char        *s2,
-                  pu_contrib  *p_c,
-                  pu_contrib  *p_c2,
-                  int         w,
-                  int         incr3,
-                  int         incr5)
+print_interaction(struct output_stream  *o_stream,
+                  interact              *Int,
+                  char                  *s1,
+                  char                  *s2,
+                  pu_contrib            *p_c,
+                  pu_contrib            *p_c2,
+                  int                   w,
+                  int                   incr3,
+                  int                   incr5)
 {
   char    *i_long, *i_short;
   int     i, l_l, l_s, len1, end5, end3, i_min, j_min, l1, add_a, add_b, nix_up;
@@ -1265,9 +1527,10 @@ print_interaction(interact    *Int,
     G_sum = Gi_min + Gul;
 
     /* printf("dG = dGint + dGu_l\n"); */
-    printf("%s %3d,%-3d : %3d,%-3d (%.2f = %.2f + %.2f)\n",
-           struc, Int->k, Int->i, Int->j, Int->l, G_min, Gi_min, Gul);
-    printf("%s&%s\n", i_long, i_short);
+    vrna_cstr_printf(o_stream->data,
+                     "%s %3d,%-3d : %3d,%-3d (%.2f = %.2f + %.2f)\n",
+                     struc, Int->k, Int->i, Int->j, Int->l, G_min, Gi_min, Gul);
+    vrna_cstr_printf(o_stream->data, "%s&%s\n", i_long, i_short);
   } else {
     p_c_S = p_c2->H[Int->j][(Int->l) - (Int->j)] +
             p_c2->I[Int->j][(Int->l) - (Int->j)] +
@@ -1279,20 +1542,21 @@ print_interaction(interact    *Int,
 
     G_sum = Gi_min + Gul + Gus;
     /* printf("dG = dGint + dGu_l + dGu_s\n"); */
-    printf("%s %3d,%-3d : %3d,%-3d (%.2f = %.2f + %.2f + %.2f)\n",
-           struc, Int->k, Int->i, Int->j, Int->l, G_min, Gi_min, Gul, Gus);
-    printf("%s&%s\n", i_long, i_short);
+    vrna_cstr_printf(o_stream->data,
+                     "%s %3d,%-3d : %3d,%-3d (%.2f = %.2f + %.2f + %.2f)\n",
+                     struc, Int->k, Int->i, Int->j, Int->l, G_min, Gi_min, Gul, Gus);
+    vrna_cstr_printf(o_stream->data, "%s&%s\n", i_long, i_short);
   }
 
   if (!EQUAL(G_min, G_sum)) {
-    printf("ERROR\n");
+    vrna_cstr_printf(o_stream->data, "ERROR\n");
     diff = fabs((G_min) - (G_sum));
-    printf("diff %.18f\n", diff);
+    vrna_cstr_printf(o_stream->data, "diff %.18f\n", diff);
   }
 
   if (nix_up)
-    vrna_message_warning(
-      "RNAduplex structure doesn't match any structure of RNAup structure ensemble");
+    vrna_cstr_message_warning(o_stream->err,
+                              "RNAduplex structure doesn't match any structure of RNAup structure ensemble");
 
   free(i_long);
   free(i_short);
@@ -1303,8 +1567,9 @@ print_interaction(interact    *Int,
 
 /* print coordinates and free energy for the region of highest accessibility */
 PRIVATE void
-print_unstru(pu_contrib *p_c,
-             int        w)
+print_unstru(vrna_cstr_t  stream,
+             pu_contrib   *p_c,
+             int          w)
 {
   int     i, j, len, min_i, min_j;
   double  dG_u, min_gu;
@@ -1330,7 +1595,7 @@ print_unstru(pu_contrib *p_c,
         }
       }
     }
-    printf("%4d,%4d \t (%.3f) \t for u=%3d\n", min_i, min_j, min_gu, w);
+    vrna_cstr_printf(stream, "%4d,%4d \t (%.3f) \t for u=%3d\n", min_i, min_j, min_gu, w);
   } else {
     vrna_message_error("error with prob unpaired");
   }
@@ -1,15 +1,26 @@
 #ifndef VRNA_PARALLELIZATION_HELPERS
 #define VRNA_PARALLELIZATION_HELPERS
 
+#include <ViennaRNA/fold_compound.h>
+
+/*
+ *  fold compounds of processed records are kept in a pool and re-targeted to
+ *  subsequent records, such that each worker effectively re-uses its own one
+ */
+vrna_fold_compound_pool_t fc_pool;
+
+/* fold compounds of longer sequences are not kept in the pool to save memory */
+#define FC_POOL_MAX_LENGTH  2000
+
 #if VRNA_WITH_PTHREADS
 
 #include <pthread.h>
-#include "thpool.h"
+#include <ViennaRNA/utils/scheduler.h>
 
-pthread_mutex_t output_mutex;
-pthread_mutex_t output_file_mutex;
-unsigned int    max_threads;
-threadpool      worker_pool;
+pthread_mutex_t   output_mutex;
+pthread_mutex_t   output_file_mutex;
+unsigned int      max_threads;
+vrna_scheduler_t  worker_pool;
 
 #define ATOMIC_BLOCK(a) { \
     if (max_threads > 1) { \
@@ -47,40 +58,46 @@ threadpool      worker_pool;
     if (max_threads > 1) { \
       pthread_mutex_init(&output_mutex, NULL); \
       pthread_mutex_init(&output_file_mutex, NULL); \
-      worker_pool = thpool_init(max_threads); \
+      worker_pool = vrna_scheduler_init(max_threads, 0); \
     } \
+    fc_pool = vrna_fold_compound_pool_init(FC_POOL_MAX_LENGTH); \
 }
 
 #define UNINIT_PARALLELIZATION  { \
     if (max_threads > 1) \
-      thpool_wait(worker_pool); \
+      vrna_scheduler_free(worker_pool); \
+    vrna_fold_compound_pool_free(fc_pool); \
     pthread_mutex_destroy(&output_mutex); \
     pthread_mutex_destroy(&output_file_mutex); \
-    if (max_threads > 1) \
-      thpool_destroy(worker_pool); \
 }
 
+/* blocks while the queues of all workers are full */
 #define RUN_IN_PARALLEL(fun, data)  { \
-    if (max_threads > 1) { thpool_add_work(worker_pool, (void *)&fun, (void *)data); } \
+    if (max_threads > 1) { vrna_scheduler_submit(worker_pool, (vrna_scheduler_task_f)&fun, (void *)data); } \
     else { fun(data); } \
 }
 
-#define WAIT_FOR_FREE_SLOT(a) { \
-    if (max_threads > 1) { \
-      while (thpool_num_threads_working(worker_pool) == (a)) \
-        sleep(1); \
-    } \
+/* submission itself applies backpressure, so there is nothing to wait for */
+#define WAIT_FOR_FREE_SLOT(a)
+
+/* blocks until all submitted tasks are finished */
+#define WAIT_FOR_ALL_TASKS  { \
+    if (max_threads > 1) { vrna_scheduler_wait(worker_pool); } \
 }
 
+#define NUM_WORKERS         (max_threads)
+
 #else
 
 #define ATOMIC_BLOCK(a)             { (a); }
 #define THREADSAFE_FILE_OUTPUT(a)   { (a); }
 #define THREADSAFE_STREAM_OUTPUT(a)   { (a); }
-#define INIT_PARALLELIZATION(a)
-#define UNINIT_PARALLELIZATION
+#define INIT_PARALLELIZATION(a)     { fc_pool = vrna_fold_compound_pool_init(FC_POOL_MAX_LENGTH); }
+#define UNINIT_PARALLELIZATION      { vrna_fold_compound_pool_free(fc_pool); }
 #define RUN_IN_PARALLEL(fun, data)  { fun(data); }
 #define WAIT_FOR_FREE_SLOT(a)
+#define WAIT_FOR_ALL_TASKS
+#define NUM_WORKERS                 1
 
 #endif
 
@@ -1,6 +1,11 @@
+#include <stddef.h>
+
 #include <ViennaRNA/params/basic.h>
 #include <ViennaRNA/utils/basic.h>
 #include <ViennaRNA/loops/all.h>
+#include <ViennaRNA/params/io.h>
+#include <ViennaRNA/mfe.h>
+#include <ViennaRNA/eval.h>
 
 #suite EnergyEvaluation
 
@@ -210,5 +215,161 @@
 }
 
 
+/*
+ * check that scaled parameter sets are cached for identical model details only
+ */
+
+#test params_cache
+{
+  vrna_md_t                 md, md2;
+  vrna_param_t              *P1, *P2, *P3;
+  vrna_exp_param_t          *pf1, *pf2;
+  vrna_params_cache_stats_t s0, s1;
+
+  vrna_params_cache_clear();
+  vrna_md_set_default(&md);
+  vrna_params_cache_stats(&s0);
+
+  ck_assert_int_eq(s0.entries, 0);
+
+  /* first request computes, the second one is a copy from the cache */
+  P1 = vrna_params(&md);
+  P2 = vrna_params(&md);
+  vrna_params_cache_stats(&s1);
+
+  ck_assert(P1 != P2);
+  ck_assert(P1->id != P2->id);
+  ck_assert(memcmp(P1->stack, P2->stack, sizeof(vrna_param_t) - offsetof(vrna_param_t, stack)) == 0);
+  ck_assert_int_eq(s1.misses - s0.misses, 1);
+  ck_assert_int_eq(s1.hits - s0.hits, 1);
+  ck_assert_int_eq(s1.entries, 1);
+  ck_assert(s1.memory >= sizeof(vrna_param_t));
+  free(P2);
+
+  pf1 = vrna_exp_params(&md);
+  pf2 = vrna_exp_params(&md);
+  vrna_params_cache_stats(&s0);
+
+  ck_assert(memcmp(pf1, pf2, sizeof(vrna_exp_param_t)) == 0);
+  ck_assert_int_eq(s0.misses - s1.misses, 1);
+  ck_assert_int_eq(s0.hits - s1.hits, 1);
+  ck_assert_int_eq(s0.entries, 2);
+  free(pf1);
+  free(pf2);
+
+  /* any change of the model details must miss */
+  md2             = md;
+  md2.temperature = 42.;
+  P2              = vrna_params(&md2);
+  md2             = md;
+  md2.noLP        = 1;
+  P3              = vrna_params(&md2);
+  vrna_params_cache_stats(&s1);
+
+  ck_assert_int_eq(s1.misses - s0.misses, 2);
+  ck_assert_int_eq(s1.hits - s0.hits, 0);
+  ck_assert_int_eq(s1.entries, 4);
+  ck_assert(P2->stack[1][2] != P1->stack[1][2]);
+  ck_assert_int_eq(P3->model_details.noLP, 1);
+  free(P2);
+  free(P3);
+
+  /* loading another parameter set invalidates all cached entries */
+  ck_assert(vrna_params_load_RNA_Turner1999());
+  vrna_params_cache_stats(&s0);
+  ck_assert_int_eq(s0.entries, 0);
+
+  P2 = vrna_params(&md);
+  vrna_params_cache_stats(&s1);
+
+  ck_assert_int_eq(s1.misses - s0.misses, 1);
+  ck_assert_int_eq(s1.hits - s0.hits, 0);
+  ck_assert(memcmp(P1->stack, P2->stack, sizeof(P1->stack)) != 0);
+  free(P2);
+
+  ck_assert(vrna_params_load_defaults());
+  P2 = vrna_params(&md);
+  vrna_params_cache_stats(&s0);
+
+  /* the reloaded defaults carry a parameter file name, so only compare the energy tables */
+  ck_assert_int_eq(s0.misses - s1.misses, 1);
+  ck_assert(memcmp(P1->stack, P2->stack, offsetof(vrna_param_t, ninio) - offsetof(vrna_param_t, stack)) == 0);
+  ck_assert_int_eq(P1->MLclosing, P2->MLclosing);
+  ck_assert_int_eq(P1->TerminalAU, P2->TerminalAU);
+
+  free(P1);
+  free(P2);
+  vrna_params_cache_clear();
+}
+
+
+/*
+ * check that fold compounds share cached parameter sets and copy them on write
+ */
+
+#test params_cache_shared
+{
+  float                     e;
+  double                    mfe, pf_scale;
+  vrna_md_t                 md, md2;
+  vrna_fold_compound_t      *fc1, *fc2, *fc3;
+  vrna_params_cache_stats_t s0, s1;
+
+  vrna_params_cache_clear();
+  vrna_md_set_default(&md);
+  vrna_params_cache_stats(&s0);
+
+  fc1 = vrna_fold_compound("GGGGAAAACCCC", &md, VRNA_OPTION_DEFAULT | VRNA_OPTION_PF);
+  fc2 = vrna_fold_compound("GGGAUAAAUCCC", &md, VRNA_OPTION_DEFAULT | VRNA_OPTION_PF);
+  vrna_params_cache_stats(&s1);
+
+  ck_assert(fc1->params == fc2->params);
+  ck_assert(fc1->exp_params == fc2->exp_params);
+  ck_assert_int_eq(s1.misses - s0.misses, 2);
+  ck_assert_int_eq(s1.shared, 2);
+  ck_assert_int_eq(s1.bytes_saved - s0.bytes_saved,
+                   sizeof(vrna_param_t) + sizeof(vrna_exp_param_t));
+
+  /* the number of threads does not enter the parameters */
+  md2         = md;
+  md2.threads = 4;
+  fc3         = vrna_fold_compound("GGGAUAAAUCCC", &md2, VRNA_OPTION_DEFAULT);
+  vrna_params_cache_stats(&s0);
+
+  ck_assert(fc3->params != fc1->params);
+  ck_assert_int_eq(fc3->params->model_details.threads, 4);
+  ck_assert_int_eq(s0.misses - s1.misses, 0);
+  ck_assert_int_eq(s0.hits - s1.hits, 1);
+  ck_assert_int_eq(s0.bytes_saved, s1.bytes_saved);
+  vrna_fold_compound_free(fc3);
+
+  /* re-scaling the Boltzmann factors detaches them from the shared set */
+  pf_scale  = fc1->exp_params->pf_scale;
+  mfe       = (double)vrna_mfe(fc2, NULL);
+  vrna_exp_params_rescale(fc2, &mfe);
+
+  ck_assert(fc1->exp_params != fc2->exp_params);
+  ck_assert(fc1->exp_params->pf_scale == pf_scale);
+  ck_assert(fc2->exp_params->pf_scale != pf_scale);
+  ck_assert(fc1->params == fc2->params);
+
+  /* shared parameter sets stay valid until their last user is gone */
+  e = vrna_eval_structure(fc1, "((((....))))");
+  vrna_params_cache_clear();
+  vrna_params_cache_stats(&s0);
+
+  ck_assert_int_eq(s0.entries, 0);
+  ck_assert_int_eq(s0.shared, 2);
+  ck_assert(vrna_eval_structure(fc1, "((((....))))") == e);
+
+  vrna_fold_compound_free(fc1);
+  vrna_fold_compound_free(fc2);
+  vrna_params_cache_stats(&s0);
+
+  ck_assert_int_eq(s0.shared, 0);
+  ck_assert_int_eq(s0.memory, 0);
+}
+
+
 #main-pre
     srunner_set_tap(sr, "-");
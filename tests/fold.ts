@@ -1,13 +1,324 @@
 #include <stdio.h>      /* printf, scanf, NULL */
 #include <stdlib.h>     /* malloc, free, rand */
+#include <string.h>     /* strcmp, memcpy, memcmp */
+#include <math.h>       /* fabs */
+#include <pthread.h>
 
 #include <ViennaRNA/fold_vars.h>
 #include <ViennaRNA/data_structures.h>
 #include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/utils/strings.h>
 #include <ViennaRNA/utils/structures.h>
+#include <ViennaRNA/utils/higher_order_functions.h>
 #include <ViennaRNA/constraints/basic.h>
 #include <ViennaRNA/fold.h>
 #include <ViennaRNA/part_func.h>
+#include <ViennaRNA/part_func_co.h>
+#include <ViennaRNA/part_func_up.h>
+#include <ViennaRNA/part_func_window.h>
+#include <ViennaRNA/subopt.h>
+#include <ViennaRNA/heat_capacity.h>
+#include <ViennaRNA/pf_multifold.h>
+#include <ViennaRNA/combinatorics.h>
+#include <ViennaRNA/io/file_formats_plfold.h>
+
+typedef struct {
+  FLT_OR_DBL  *p;
+  size_t      n;
+} window_probs;
+
+/* concatenate all base pair probabilities reported by the sliding window scan */
+static void
+collect_window_bpp(FLT_OR_DBL   *pr,
+                   int          pr_size,
+                   int          i,
+                   int          max,
+                   unsigned int type,
+                   void         *data)
+{
+  int           j;
+  window_probs  *w = (window_probs *)data;
+
+  if (type & VRNA_PROBS_WINDOW_BPP)
+    for (j = i + 1; j <= pr_size; j++)
+      w->p[w->n++] = pr[j];
+}
+
+
+/* count the recursion status messages of each kind */
+static void
+count_status(unsigned char  status,
+             void           *data)
+{
+  int *counts = (int *)data;
+
+  counts[status]++;
+}
+
+
+typedef struct {
+  float   *en;
+  char    **s;
+  size_t  n;
+} subopt_energies;
+
+/* collect the free energies of all suboptimal structures */
+static void
+collect_subopt_energies(const char  *structure,
+                        float       energy,
+                        void        *data)
+{
+  subopt_energies *e = (subopt_energies *)data;
+
+  if (structure) {
+    e->en         = (float *)vrna_realloc(e->en, sizeof(float) * (e->n + 1));
+    e->en[e->n++] = energy;
+  }
+}
+
+
+/* collect the free energies and the suboptimal structures themselves */
+static void
+collect_subopt_structures(const char  *structure,
+                          float       energy,
+                          void        *data)
+{
+  subopt_energies *e = (subopt_energies *)data;
+
+  if (structure) {
+    e->s          = (char **)vrna_realloc(e->s, sizeof(char *) * (e->n + 1));
+    e->s[e->n]    = strdup(structure);
+    collect_subopt_energies(structure, energy, data);
+  }
+}
+
+
+static int
+compare_strings(const void  *a,
+                const void  *b)
+{
+  return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+
+typedef struct {
+  char    **s;
+  size_t  n;
+} sample_list;
+
+/* collect all structures reported by the stochastic backtracking */
+static void
+collect_samples(const char  *structure,
+                void        *data)
+{
+  sample_list *l = (sample_list *)data;
+
+  l->s          = (char **)vrna_realloc(l->s, sizeof(char *) * (l->n + 1));
+  l->s[l->n++]  = strdup(structure);
+}
+
+
+typedef struct {
+  vrna_plfold_bin_writer_t  *writer;
+  unsigned int              ulength;
+  float                     cutoff;
+  size_t                    *num_pairs; /* number of base pairs above the cutoff per 5' position */
+  double                    *pU;        /* unpaired probabilities, (i - 1) * ulength + u - 1 */
+} plfold_bin_data;
+
+/* write sliding window data to a binary file and keep what we expect to read back */
+static void
+write_plfold_bin(FLT_OR_DBL   *pr,
+                 int          pr_size,
+                 int          i,
+                 int          max,
+                 unsigned int type,
+                 void         *data)
+{
+  int             j;
+  plfold_bin_data *d = (plfold_bin_data *)data;
+
+  vrna_file_plfold_bin_cb(pr, pr_size, i, max, type, d->writer);
+
+  if (type & VRNA_PROBS_WINDOW_BPP) {
+    for (j = i + 1; j <= pr_size; j++)
+      if (pr[j] >= d->cutoff)
+        d->num_pairs[i]++;
+  } else if ((type & VRNA_PROBS_WINDOW_UP) &&
+             ((type & VRNA_ANY_LOOP) == VRNA_ANY_LOOP)) {
+    for (j = 1; (j <= pr_size) && (j <= (int)d->ulength); j++)
+      d->pU[(i - 1) * d->ulength + j - 1] = pr[j];
+  }
+}
+
+
+/*
+ *  ensemble free energy of a complex as the sum over its non-cyclic
+ *  permutations, each predicted independently with vrna_pf() after
+ *  adapting the scaling factor to its MFE
+ */
+static double
+complex_energy(const char   **strands,
+               unsigned int num_strands,
+               unsigned int *complex,
+               unsigned int size,
+               vrna_md_t    *md)
+{
+  unsigned int          s, p, n, *species, *mapping, **permutations;
+  char                  *seq;
+  double                kT, mfe, F, dG;
+  vrna_fold_compound_t  *fc;
+
+  kT      = md->betaScale * (md->temperature + K0) * GASCONST / 1000.;
+  species = (unsigned int *)vrna_alloc(sizeof(unsigned int) * (size + 1));
+  mapping = (unsigned int *)vrna_alloc(sizeof(unsigned int) * num_strands);
+  dG      = 0.;
+
+  for (n = s = 0; s < num_strands; s++) {
+    for (p = 0; p < size; p++)
+      if (complex[p] == s)
+        species[n]++;
+
+    if (species[n] > 0)
+      mapping[n++] = s;
+  }
+
+  permutations = vrna_enumerate_necklaces(species);
+
+  for (p = 0; permutations[p]; p++) {
+    for (n = 0, s = 1; s <= size; s++)
+      n += strlen(strands[mapping[permutations[p][s]]]) + 1;
+
+    seq     = (char *)vrna_alloc(sizeof(char) * (n + 1));
+    seq[0]  = '\0';
+
+    for (s = 1; s <= size; s++) {
+      if (s > 1)
+        strcat(seq, "&");
+
+      strcat(seq, strands[mapping[permutations[p][s]]]);
+    }
+
+    fc  = vrna_fold_compound(seq, md, VRNA_OPTION_DEFAULT | VRNA_OPTION_PF);
+    mfe = (double)vrna_mfe(fc, NULL);
+    vrna_exp_params_rescale(fc, &mfe);
+    F   = (double)vrna_pf(fc, NULL);
+    dG  = (p == 0) ? F : vrna_pf_add(dG, F, kT);
+
+    vrna_fold_compound_free(fc);
+    free(permutations[p]);
+    free(seq);
+  }
+
+  free(permutations);
+  free(species);
+  free(mapping);
+
+  return dG;
+}
+
+
+/* probabilities of being unpaired as computed by RNAup with the global state functions */
+static pu_contrib *
+unstructured_legacy(char  *sequence,
+                    int   w)
+{
+  int     n;
+  char    *structure;
+  double  mfe, kT;
+
+  n         = (int)strlen(sequence);
+  structure = (char *)vrna_alloc(sizeof(char) * (n + 1));
+  kT        = (temperature + K0) * GASCONST / 1000.;
+  mfe       = (double)fold(sequence, structure);
+  pf_scale  = exp(-(1.07 * mfe) / kT / n);
+  (void)pf_fold(sequence, structure);
+  free_arrays();
+  free(structure);
+
+  return pf_unstru(sequence, w);
+}
+
+
+/* probabilities of being unpaired as computed by RNAup with a fold compound */
+static pu_contrib *
+unstructured(const char           *sequence,
+             int                  w,
+             vrna_md_t            *md,
+             vrna_fold_compound_t **fc_p)
+{
+  double                mfe;
+  vrna_fold_compound_t  *fc;
+
+  fc  = vrna_fold_compound(sequence, md, VRNA_OPTION_DEFAULT);
+  mfe = (double)vrna_mfe(fc, NULL);
+  vrna_exp_params_rescale(fc, &mfe);
+  (void)vrna_pf(fc, NULL);
+
+  *fc_p = fc;
+
+  return vrna_pf_unstru(fc, w);
+}
+
+
+static void
+compare_pu_contrib(pu_contrib *a,
+                   pu_contrib *b)
+{
+  int i;
+
+  ck_assert_int_eq(a->length, b->length);
+  ck_assert_int_eq(a->w, b->w);
+
+  for (i = 0; i <= a->length; i++) {
+    ck_assert(memcmp(a->H[i], b->H[i], sizeof(double) * (a->w + 1)) == 0);
+    ck_assert(memcmp(a->I[i], b->I[i], sizeof(double) * (a->w + 1)) == 0);
+    ck_assert(memcmp(a->M[i], b->M[i], sizeof(double) * (a->w + 1)) == 0);
+    ck_assert(memcmp(a->E[i], b->E[i], sizeof(double) * (a->w + 1)) == 0);
+  }
+}
+
+
+static void
+compare_interact(interact *a,
+                 interact *b)
+{
+  ck_assert_int_eq(a->length, b->length);
+  ck_assert_int_eq(a->i, b->i);
+  ck_assert_int_eq(a->k, b->k);
+  ck_assert_int_eq(a->j, b->j);
+  ck_assert_int_eq(a->l, b->l);
+  ck_assert(a->Gikjl == b->Gikjl);
+  ck_assert(a->Gikjl_wo == b->Gikjl_wo);
+  ck_assert(memcmp(a->Pi + 1, b->Pi + 1, sizeof(double) * a->length) == 0);
+  ck_assert(memcmp(a->Gi + 1, b->Gi + 1, sizeof(double) * a->length) == 0);
+}
+
+
+typedef struct {
+  vrna_fold_compound_t  *fc;
+  pu_contrib            *pu;
+  const char            **s2;
+  pu_contrib            **pu2;
+  interact              **in;
+  unsigned int          num;
+  unsigned int          thread;
+  unsigned int          num_threads;
+} interaction_jobs;
+
+/* interactions of a shared fold compound with every num_threads-th sequence */
+static void *
+interact_shared(void *arg)
+{
+  unsigned int      i;
+  interaction_jobs  *d = (interaction_jobs *)arg;
+
+  for (i = d->thread; i < d->num; i += d->num_threads)
+    d->in[i] = vrna_pf_interact(d->fc, d->s2[i], d->pu, d->pu2[i], 25, NULL, 0, 0);
+
+  return NULL;
+}
+
 
 #suite  MFE_Prediction
 
@@ -24,6 +335,329 @@
   free(structure);
 }
 
+#tcase  Parallel_Fill
+
+#test test_mfe_threads
+{
+  const char            sequence[] =
+    "UGCCUGGCGGCCGUAGCGCGGUGGUCCCACCUGACCCCAUGCCGAACUCAGAAGUGAAACGCCGUAGCGCCGAUGGUAGUGUGGGGUCUCCCCAUGCGAGAGUAGGGAACUGCCAGGCAU";
+  char                  s1[sizeof(sequence)], s2[sizeof(sequence)];
+  float                 e1, e2;
+  int                   d;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *vc;
+
+  for (d = 0; d < 4; d++) {
+    vrna_md_set_default(&md);
+    md.dangles  = d;
+    md.threads  = 1;
+    vc          = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+    e1          = vrna_mfe(vc, s1);
+    vrna_fold_compound_free(vc);
+
+    md.threads  = 4;
+    vc          = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+    e2          = vrna_mfe(vc, s2);
+    vrna_fold_compound_free(vc);
+
+    ck_assert(e1 == e2);
+    ck_assert(strcmp(s1, s2) == 0);
+  }
+}
+
+#tcase  Fold_Compound_Reuse
+
+#test test_mfe_retarget
+{
+  const char                *sequences[] = {
+    "UGCCUGGCGGCCGUAGCGCGGUGGUCCCACCUGACCCCAUGCCGAACUCAGAAGUGAAACGCCGUAGCGCCGAUGGUAGUGUGGGGUCUCCCCAUGCGAGAGUAGGGAACUGCCAGGCAU",
+    "CGCAGGGAUACCCGCG",
+    "GGGGAAAACCCCAUGCGAUUCGCAUGGGCAAAGCCC",
+    NULL
+  };
+  char                      s1[256], s2[256];
+  float                     e1, e2;
+  int                       i;
+  vrna_md_t                 md;
+  vrna_fold_compound_t      *vc, *vc_pooled;
+  vrna_fold_compound_pool_t pool;
+
+  vrna_md_set_default(&md);
+  pool = vrna_fold_compound_pool_init(0);
+
+  for (i = 0; sequences[i]; i++) {
+    vc        = vrna_fold_compound(sequences[i], &md, VRNA_OPTION_DEFAULT);
+    vc_pooled = vrna_fold_compound_pool_acquire(pool, sequences[i], &md, VRNA_OPTION_DEFAULT);
+
+    ck_assert(vc_pooled->length == vc->length);
+
+    e1  = vrna_mfe(vc, s1);
+    e2  = vrna_mfe(vc_pooled, s2);
+
+    ck_assert(e1 == e2);
+    ck_assert(strcmp(s1, s2) == 0);
+
+    vrna_fold_compound_free(vc);
+    vrna_fold_compound_pool_release(pool, vc_pooled);
+  }
+
+  vrna_fold_compound_pool_free(pool);
+}
+
+#test test_mfe_batch
+{
+  const char  *sequences[] = {
+    "CGCAGGGAUACCCGCG",
+    "GGGGAAAACCCCAUGCGAUUCGCAUGGGCAAAGCCC",
+    "UUUUUUUU",
+    "GGGCGCAAGCCU",
+    NULL
+  };
+  char        s[64], *structures[4];
+  float       energies[4];
+  int         i;
+  vrna_md_t   md;
+
+  vrna_md_set_default(&md);
+  md.threads = 2;
+
+  ck_assert(vrna_mfe_batch(sequences, &md, energies, structures) == 4);
+
+  for (i = 0; sequences[i]; i++) {
+    ck_assert(vrna_fold(sequences[i], s) == energies[i]);
+    ck_assert(strcmp(s, structures[i]) == 0);
+    free(structures[i]);
+  }
+}
+
+#test test_mfe_batch_lanes
+{
+  /* equal-length sequences without structures go through the lane-batched kernel */
+  char                  *sequences[20];
+  float                 energies[19];
+  int                   d, i, k, n;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *vc;
+
+  srand(42);
+
+  for (d = 0; d <= 2; d += 2) {
+    vrna_md_set_default(&md);
+    md.dangles  = d;
+    md.threads  = 1;
+
+    for (k = 0; k < 19; k++) {
+      n             = (k < 17) ? 48 : 23;
+      sequences[k]  = (char *)malloc(sizeof(char) * (n + 1));
+      for (i = 0; i < n; i++)
+        sequences[k][i] = "ACGU"[rand() % 4];
+      sequences[k][n] = '\0';
+    }
+    sequences[19] = NULL;
+
+    /* add some hairpins with special hairpin loop energies */
+    memcpy(sequences[3], "GGGGAAAACCCCAUGCGAUUCGCAUG", 26);
+    memcpy(sequences[18], "CGCAGGGAUACCCGCG", 16);
+
+    ck_assert(vrna_mfe_batch((const char **)sequences, &md, energies, NULL) == 19);
+
+    for (k = 0; k < 19; k++) {
+      vc = vrna_fold_compound(sequences[k], &md, VRNA_OPTION_DEFAULT);
+      ck_assert(vrna_mfe(vc, NULL) == energies[k]);
+      vrna_fold_compound_free(vc);
+      free(sequences[k]);
+    }
+  }
+}
+
+#tcase  SIMD_Kernels
+
+#test test_mfe_simd
+{
+  const char            sequence[] =
+    "UGCCUGGCGGCCGUAGCGCGGUGGUCCCACCUGACCCCAUGCCGAACUCAGAAGUGAAACGCCGUAGCGCCGAUGGUAGUGUGGGGUCUCCCCAUGCGAGAGUAGGGAACUGCCAGGCAU";
+  char                  s1[sizeof(sequence)], s2[sizeof(sequence)];
+  int                   d, *c1, size;
+  float                 e1, e2;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *vc;
+
+  size  = ((sizeof(sequence) - 1) * sizeof(sequence)) / 2 + 2;
+  c1    = (int *)malloc(sizeof(int) * size);
+
+  for (d = 0; d < 4; d++) {
+    vrna_md_set_default(&md);
+    md.dangles      = d;
+    md.noLP         = d % 2;
+
+    /* scalar kernels */
+    vrna_fun_dispatch_disable();
+    vc  = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+    e1  = vrna_mfe(vc, s1);
+    memcpy(c1, vc->matrices->c, sizeof(int) * size);
+    vrna_fold_compound_free(vc);
+
+    /* SIMD kernels selected at run time */
+    vrna_fun_dispatch_enable();
+    vc  = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+    e2  = vrna_mfe(vc, s2);
+
+    ck_assert(e1 == e2);
+    ck_assert(strcmp(s1, s2) == 0);
+    ck_assert(memcmp(c1, vc->matrices->c, sizeof(int) * size) == 0);
+
+    vrna_fold_compound_free(vc);
+  }
+
+  free(c1);
+}
+
+#test test_pf_simd
+{
+  const char            sequence[] =
+    "UGCCUGGCGGCCGUAGCGCGGUGGUCCCACCUGACCCCAUGCCGAACUCAGAAGUGAAACGCCGUAGCGCCGAUGGUAGUGUGGGGUCUCCCCAUGCGAGAGUAGGGAACUGCCAGGCAU";
+  double                e1, e2;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *vc;
+
+  vrna_md_set_default(&md);
+  md.compute_bpp = 0;
+
+  /* SIMD reductions only change the order of summation */
+  vrna_fun_dispatch_disable();
+  vc  = vrna_fold_compound(sequence, &md, VRNA_OPTION_PF);
+  e1  = vrna_pf(vc, NULL);
+  vrna_fold_compound_free(vc);
+
+  vrna_fun_dispatch_enable();
+  vc  = vrna_fold_compound(sequence, &md, VRNA_OPTION_PF);
+  e2  = vrna_pf(vc, NULL);
+  vrna_fold_compound_free(vc);
+
+  ck_assert(fabs(e1 - e2) < 1e-6);
+}
+
+#tcase  Matrix_Layout
+
+#test test_mfe_tiled
+{
+  const char            sequence[] =
+    "UGCCUGGCGGCCGUAGCGCGGUGGUCCCACCUGACCCCAUGCCGAACUCAGAAGUGAAACGCCGUAGCGCCGAUGGUAGUGUGGGGUCUCCCCAUGCGAGAGUAGGGAACUGCCAGGCAU";
+  char                  s1[sizeof(sequence)], s2[sizeof(sequence)];
+  int                   d, i, j, n;
+  float                 e1, e2;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *vc1, *vc2;
+
+  n = sizeof(sequence) - 1;
+
+  for (d = 0; d < 4; d++) {
+    vrna_md_set_default(&md);
+    md.dangles  = d;
+    md.noLP     = d % 2;
+
+    vc1 = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+    vc2 = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+
+    ck_assert(vrna_mx_add(vc2, VRNA_MX_TILED, VRNA_OPTION_MFE) == 1);
+
+    e1  = vrna_mfe(vc1, s1);
+    e2  = vrna_mfe(vc2, s2);
+
+    ck_assert(vc2->matrices->type == VRNA_MX_TILED);
+    ck_assert(e1 == e2);
+    ck_assert(strcmp(s1, s2) == 0);
+
+    for (j = 1; j <= n; j++)
+      for (i = 1; i <= j; i++) {
+        ck_assert(VRNA_MX_MFE_IDX(vc1->matrices, i, j) == vc1->jindx[j] + i);
+        ck_assert(vc1->matrices->c[vc1->jindx[j] + i] ==
+                  vc2->matrices->c[VRNA_MX_MFE_IDX(vc2->matrices, i, j)]);
+      }
+
+    vrna_fold_compound_free(vc1);
+    vrna_fold_compound_free(vc2);
+  }
+}
+
+#tcase  Suboptimal_Structures
+
+#test test_subopt_sorted
+{
+  vrna_md_t             md;
+  vrna_fold_compound_t  *vc;
+  const char            sequence[] =
+    "UCAGUUAAAUGGCAGAAAACUGGCAGGGCUUUUAGUCGUGGGAUGAUCAGUGGGUAAAGGUGGCGCGGGGUAACGCGCGCUAAGGCUCAG";
+  subopt_energies       all, sorted, bounded;
+  size_t                i, n;
+  int                   delta;
+
+  vrna_md_set_default(&md);
+  md.uniq_ML = 1;
+
+  vc = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+
+  all.en  = sorted.en = bounded.en = NULL;
+  all.n   = sorted.n = bounded.n = 0;
+
+  vrna_subopt_cb(vc, 300, collect_subopt_energies, &all);
+  delta = vrna_subopt_sorted_cb(vc, 300, 0, collect_subopt_energies, &sorted);
+
+  /* same number of structures, but in ascending order of free energy */
+  ck_assert_int_eq(delta, 300);
+  ck_assert_int_eq(sorted.n, all.n);
+  for (i = 1; i < sorted.n; i++)
+    ck_assert(sorted.en[i - 1] <= sorted.en[i]);
+
+  /* a memory limit narrows down the energy band, which is still enumerated completely */
+  delta = vrna_subopt_sorted_cb(vc, 300, 20000, collect_subopt_energies, &bounded);
+  ck_assert(delta < 300);
+
+  for (n = 0, i = 0; i < sorted.n; i++)
+    if (sorted.en[i] <= sorted.en[0] + delta / 100. + 1e-4)
+      n++;
+
+  ck_assert_int_eq(bounded.n, n);
+  for (i = 0; i < bounded.n; i++)
+    ck_assert(fabs(bounded.en[i] - sorted.en[i]) < 1e-4);
+
+  free(all.en);
+  free(sorted.en);
+  free(bounded.en);
+  vrna_fold_compound_free(vc);
+
+  /* with --noLP, pairs that only exist within a stack must not be dismissed */
+  md.noLP = 1;
+  vc      = vrna_fold_compound("GGGGAAAACCCCAUGCGAUUCGCAUGGGCAAAGCCC", &md, VRNA_OPTION_DEFAULT);
+
+  all.en  = sorted.en = NULL;
+  all.s   = sorted.s = NULL;
+  all.n   = sorted.n = 0;
+
+  vrna_subopt_cb(vc, 300, collect_subopt_structures, &all);
+  vrna_subopt_sorted_cb(vc, 300, 0, collect_subopt_structures, &sorted);
+
+  ck_assert(all.n > 0);
+  ck_assert_int_eq(sorted.n, all.n);
+  for (i = 1; i < sorted.n; i++)
+    ck_assert(sorted.en[i - 1] <= sorted.en[i]);
+
+  qsort(all.s, all.n, sizeof(char *), compare_strings);
+  qsort(sorted.s, sorted.n, sizeof(char *), compare_strings);
+
+  for (i = 0; i < all.n; i++) {
+    ck_assert_str_eq(sorted.s[i], all.s[i]);
+    free(all.s[i]);
+    free(sorted.s[i]);
+  }
+
+  free(all.en);
+  free(all.s);
+  free(sorted.en);
+  free(sorted.s);
+  vrna_fold_compound_free(vc);
+}
+
 #suite  Partition_Function
 
 #tcase Stochastic_Backtracking
@@ -55,6 +689,789 @@
   vrna_fold_compound_free(vc);
 }
 
+#test test_sample_non_redundant
+{
+  vrna_md_t             md;
+  vrna_fold_compound_t  *vc;
+  vrna_pbacktrack_mem_t nr_mem;
+  const char            sequence[] =
+    "UGCCUGGCGGCCGUAGCGCGGUGGUCCCACCUGACCCCAUGCCGAACUCAGAAGUGAAACGCCGUAGCGCCGAUGGUAGUGUGGGGUCUCCCCAUGCGAGAGUAGGGAACUGCCAGGCAU";
+  char                  **s1, **s2;
+  unsigned int          i, j;
+
+  vrna_md_set_default(&md);
+  md.uniq_ML      = 1;
+  md.compute_bpp  = 0;
+
+  vc = vrna_fold_compound(sequence, &md, VRNA_OPTION_PF);
+  vrna_pf(vc, NULL);
+
+  nr_mem  = NULL;
+  s1      = vrna_pbacktrack_resume(vc, 100, &nr_mem, VRNA_PBACKTRACK_NON_REDUNDANT);
+  s2      = vrna_pbacktrack_resume(vc, 100, &nr_mem, VRNA_PBACKTRACK_NON_REDUNDANT);
+
+  /* all samples are unique, also across resumed rounds */
+  for (i = 0; i < 100; i++) {
+    ck_assert(s1[i] != NULL);
+    ck_assert(s2[i] != NULL);
+
+    for (j = i + 1; j < 100; j++) {
+      ck_assert_str_ne(s1[i], s1[j]);
+      ck_assert_str_ne(s2[i], s2[j]);
+    }
+
+    for (j = 0; j < 100; j++)
+      ck_assert_str_ne(s1[i], s2[j]);
+  }
+
+  for (i = 0; i < 100; i++) {
+    free(s1[i]);
+    free(s2[i]);
+  }
+
+  free(s1);
+  free(s2);
+  vrna_pbacktrack_mem_free(nr_mem);
+  vrna_fold_compound_free(vc);
+}
+
+#test test_sample_seeded
+{
+  vrna_md_t             md;
+  vrna_fold_compound_t  *vc;
+  const char            sequence[] =
+    "UGCCUGGCGGCCGUAGCGCGGUGGUCCCACCUGACCCCAUGCCGAACUCAGAAGUGAAACGCCGUAGCGCCGAUGGUAGUGUGGGGUCUCCCCAUGCGAGAGUAGGGAACUGCCAGGCAU";
+  char                  **s1, **s2, **s3;
+  unsigned int          i;
+
+  vrna_md_set_default(&md);
+  md.uniq_ML      = 1;
+  md.compute_bpp  = 0;
+  md.threads      = 1;
+
+  vc = vrna_fold_compound(sequence, &md, VRNA_OPTION_PF);
+  vrna_pf(vc, NULL);
+  s1 = vrna_pbacktrack_seeded_num(vc, 100, 42, VRNA_PBACKTRACK_DEFAULT);
+  vrna_fold_compound_free(vc);
+
+  md.threads = 4;
+
+  vc = vrna_fold_compound(sequence, &md, VRNA_OPTION_PF);
+  vrna_pf(vc, NULL);
+  s2  = vrna_pbacktrack_seeded_num(vc, 100, 42, VRNA_PBACKTRACK_DEFAULT);
+  s3  = vrna_pbacktrack_seeded_num(vc, 100, 43, VRNA_PBACKTRACK_DEFAULT);
+  vrna_fold_compound_free(vc);
+
+  /* same seed, same samples in the same order, regardless of the number of threads */
+  for (i = 0; i < 100; i++) {
+    ck_assert(s1[i] != NULL);
+    ck_assert_str_eq(s1[i], s2[i]);
+  }
+
+  ck_assert(s1[100] == NULL);
+  ck_assert(s2[100] == NULL);
+
+  for (i = 0; (i < 100) && (strcmp(s1[i], s3[i]) == 0); i++);
+  ck_assert(i < 100);
+
+  for (i = 0; i < 100; i++) {
+    free(s1[i]);
+    free(s2[i]);
+    free(s3[i]);
+  }
+
+  free(s1);
+  free(s2);
+  free(s3);
+}
+
+#test test_sample_seeded_failure
+{
+  vrna_md_t             md;
+  vrna_fold_compound_t  *vc;
+  const char            sequence[] =
+    "UGCCUGGCGGCCGUAGCGCGGUGGUCCCACCUGACCCCAUGCCGAACUCAGAAGUGAAACGCCGUAGCGCCGAUGGUAGUGUGGGGUCUCCCCAUGCGAGAGUAGGGAACUGCCAGGCAU";
+  sample_list           l[2];
+  unsigned int          i, k, n, num[2];
+
+  vrna_md_set_default(&md);
+  md.uniq_ML      = 1;
+  md.compute_bpp  = 0;
+
+  n = strlen(sequence);
+
+  for (k = 0; k < 2; k++) {
+    md.threads  = (k == 0) ? 1 : 4;
+    l[k].s      = NULL;
+    l[k].n      = 0;
+
+    vc = vrna_fold_compound(sequence, &md, VRNA_OPTION_PF);
+    vrna_pf(vc, NULL);
+
+    /* inflate the ensemble such that backtracking of some samples fails */
+    vc->exp_matrices->q[vc->iindx[1] - n] *= 1.5;
+
+    num[k] = vrna_pbacktrack_seeded_cb(vc,
+                                       100,
+                                       42,
+                                       &collect_samples,
+                                       (void *)&(l[k]),
+                                       VRNA_PBACKTRACK_DEFAULT);
+    vrna_fold_compound_free(vc);
+  }
+
+  /* failed samples are treated alike, regardless of the number of threads */
+  ck_assert(l[0].n < 100);
+  ck_assert_int_eq(num[0], num[1]);
+  ck_assert_int_eq(l[0].n, l[1].n);
+
+  for (i = 0; i < l[0].n; i++) {
+    ck_assert_str_eq(l[0].s[i], l[1].s[i]);
+    free(l[0].s[i]);
+    free(l[1].s[i]);
+  }
+
+  free(l[0].s);
+  free(l[1].s);
+}
+
+#tcase Parallel_Probabilities
+
+#test test_pf_threads
+{
+  vrna_md_t             md;
+  vrna_fold_compound_t  *vc;
+  const char            sequence[] =
+    "UGCCUGGCGGCCGUAGCGCGGUGGUCCCACCUGACCCCAUGCCGAACUCAGAAGUGAAACGCCGUAGCGCCGAUGGUAGUGUGGGGUCUCCCCAUGCGAGAGUAGGGAACUGCCAGGCAU";
+  int                   i, n, size;
+  double                e1, e2;
+  FLT_OR_DBL            *p1;
+
+  n     = sizeof(sequence) - 1;
+  size  = ((n + 1) * (n + 2)) / 2;
+  p1    = (FLT_OR_DBL *)malloc(sizeof(FLT_OR_DBL) * size);
+
+  vrna_md_set_default(&md);
+  md.uniq_ML  = 1;
+  md.threads  = 1;
+
+  vc = vrna_fold_compound(sequence, &md, VRNA_OPTION_PF);
+  e1 = vrna_pf(vc, NULL);
+  memcpy(p1, vc->exp_matrices->probs, sizeof(FLT_OR_DBL) * size);
+  vrna_fold_compound_free(vc);
+
+  md.threads = 4;
+
+  vc = vrna_fold_compound(sequence, &md, VRNA_OPTION_PF);
+  e2 = vrna_pf(vc, NULL);
+
+  ck_assert(e1 == e2);
+
+  for (i = 1; i <= n; i++)
+    ck_assert(memcmp(p1 + vc->iindx[i] - n,
+                     vc->exp_matrices->probs + vc->iindx[i] - n,
+                     sizeof(FLT_OR_DBL) * (n - i + 1)) == 0);
+
+  vrna_fold_compound_free(vc);
+  free(p1);
+}
+
+#test test_heat_capacity_threads
+{
+  vrna_md_t             md;
+  vrna_fold_compound_t  *vc;
+  vrna_heat_capacity_t  *hc1, *hc2;
+  const char            sequence[] =
+    "GGGGAAAACCCCAUGCGAUUCGCAUGGGCAAAGCCCUAGCUAGCUAGGCAUCGAUCGA";
+  unsigned int          i, num;
+
+  vrna_md_set_default(&md);
+  md.threads = 1;
+
+  vc  = vrna_fold_compound(sequence, &md, VRNA_OPTION_PF);
+  hc1 = vrna_heat_capacity(vc, 0., 100., 1., 2);
+  vrna_fold_compound_free(vc);
+
+  md.threads = 4;
+
+  vc  = vrna_fold_compound(sequence, &md, VRNA_OPTION_PF);
+  hc2 = vrna_heat_capacity(vc, 0., 100., 1., 2);
+
+  ck_assert_ptr_ne(hc1, NULL);
+  ck_assert_ptr_ne(hc2, NULL);
+
+  for (num = 0; hc1[num].temperature >= -K0; num++);
+
+  ck_assert_int_eq(num, 101);
+
+  /* both sweeps must produce bit-identical results */
+  for (i = 0; i <= num; i++) {
+    ck_assert(hc1[i].temperature == hc2[i].temperature);
+    ck_assert(hc1[i].heat_capacity == hc2[i].heat_capacity);
+  }
+
+  /* the fold compound must be restored to its original temperature */
+  ck_assert(vc->params->model_details.temperature == md.temperature);
+
+  vrna_fold_compound_free(vc);
+  free(hc1);
+  free(hc2);
+}
+
+#test test_pfl_threads
+{
+  vrna_md_t             md;
+  vrna_fold_compound_t  *vc;
+  char                  sequence[4001];
+  int                   i;
+  window_probs          w1, w2;
+
+  /* long enough to be split into several chunks */
+  for (i = 0; i < 4000; i++)
+    sequence[i] = "ACGU"[(i * 7 + i / 5 + i / 13) % 4];
+
+  sequence[4000] = '\0';
+
+  w1.p  = (FLT_OR_DBL *)malloc(sizeof(FLT_OR_DBL) * 4000 * 31);
+  w2.p  = (FLT_OR_DBL *)malloc(sizeof(FLT_OR_DBL) * 4000 * 31);
+  w1.n  = w2.n = 0;
+
+  vrna_md_set_default(&md);
+  md.window_size  = 30;
+  md.max_bp_span  = 30;
+  md.threads      = 1;
+
+  vc = vrna_fold_compound(sequence, &md, VRNA_OPTION_WINDOW);
+  ck_assert(vrna_probs_window(vc, 0, VRNA_PROBS_WINDOW_BPP, &collect_window_bpp, (void *)&w1));
+  vrna_fold_compound_free(vc);
+
+  md.threads = 4;
+
+  vc = vrna_fold_compound(sequence, &md, VRNA_OPTION_WINDOW);
+  ck_assert(vrna_probs_window(vc, 0, VRNA_PROBS_WINDOW_BPP, &collect_window_bpp, (void *)&w2));
+  vrna_fold_compound_free(vc);
+
+  ck_assert(w1.n > 0);
+  ck_assert(w1.n == w2.n);
+  ck_assert(memcmp(w1.p, w2.p, sizeof(FLT_OR_DBL) * w1.n) == 0);
+
+  free(w1.p);
+  free(w2.p);
+}
+
+#tcase Automatic_Rescaling
+
+#test test_pf_rescale
+{
+  vrna_md_t             md;
+  vrna_fold_compound_t  *vc;
+  char                  sequence[601];
+  int                   i;
+  double                mfe, e1, e2;
+
+  /* a GC-rich sequence that overflows with the default scaling factor */
+  for (i = 0; i < 600; i++)
+    sequence[i] = "GGGGCCCC"[i % 8];
+
+  sequence[600] = '\0';
+
+  vrna_md_set_default(&md);
+  md.compute_bpp = 0;
+
+  vc  = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+  mfe = (double)vrna_mfe(vc, NULL);
+  vrna_exp_params_rescale(vc, &mfe);
+  e1 = vrna_pf(vc, NULL);
+  vrna_fold_compound_free(vc);
+
+  vc  = vrna_fold_compound(sequence, &md, VRNA_OPTION_PF);
+  e2  = vrna_pf(vc, NULL);
+
+  ck_assert(e2 < mfe);
+  ck_assert(fabs(e1 - e2) < 1e-4);
+  ck_assert(vc->matrices == NULL);
+
+  vrna_fold_compound_free(vc);
+}
+
+#test test_pf_calibrate
+{
+  vrna_md_t             md;
+  vrna_fold_compound_t  *vc;
+  char                  sequence[801];
+  int                   i;
+  double                e1, e2, s1;
+
+  /* calibration of the scaling factor must not depend on the number of threads */
+  for (i = 0; i < 800; i++)
+    sequence[i] = "GGGCCCAU"[(i * 7 + i / 3) % 8];
+
+  sequence[800] = '\0';
+
+  vrna_md_set_default(&md);
+  md.compute_bpp  = 0;
+  md.threads      = 1;
+
+  vc  = vrna_fold_compound(sequence, &md, VRNA_OPTION_PF);
+  e1  = vrna_pf(vc, NULL);
+  s1  = vc->exp_params->pf_scale;
+  vrna_fold_compound_free(vc);
+
+  md.threads = 4;
+
+  vc  = vrna_fold_compound(sequence, &md, VRNA_OPTION_PF);
+  e2  = vrna_pf(vc, NULL);
+
+  ck_assert(e1 < 0.);
+  ck_assert(e1 == e2);
+  ck_assert(s1 == vc->exp_params->pf_scale);
+
+  vrna_fold_compound_free(vc);
+}
+
+#test test_pf_calibrate_callbacks
+{
+  vrna_md_t             md;
+  vrna_fold_compound_t  *vc;
+  char                  sequence[601];
+  int                   i, counts[5];
+  double                s1;
+
+  /* restarts of the fill must not repeat the status messages */
+  for (i = 0; i < 600; i++)
+    sequence[i] = "GGGGCCCC"[i % 8];
+
+  sequence[600] = '\0';
+
+  vrna_md_set_default(&md);
+  md.compute_bpp = 0;
+
+  vc  = vrna_fold_compound(sequence, &md, VRNA_OPTION_PF);
+  s1  = vc->exp_params->pf_scale;
+
+  memset(counts, 0, sizeof(counts));
+  vrna_fold_compound_add_auxdata(vc, (void *)counts, NULL);
+  vrna_fold_compound_add_callback(vc, &count_status);
+
+  (void)vrna_pf(vc, NULL);
+
+  ck_assert(vc->exp_params->pf_scale != s1);
+  ck_assert_int_eq(counts[VRNA_STATUS_PF_PRE], 1);
+  ck_assert_int_eq(counts[VRNA_STATUS_PF_POST], 1);
+
+  vrna_fold_compound_free(vc);
+}
+
+#test test_pfl_rescale
+{
+  vrna_md_t             md;
+  vrna_fold_compound_t  *vc;
+  char                  sequence[451];
+  int                   i;
+  size_t                k;
+  double                s1, s2;
+  window_probs          w1, w2;
+
+  /* long helices within the window overflow with the default scaling factor */
+  for (i = 0; i < 450; i++)
+    sequence[i] = "GC"[i % 2];
+
+  sequence[450] = '\0';
+
+  w1.p  = (FLT_OR_DBL *)malloc(sizeof(FLT_OR_DBL) * 450 * 381);
+  w2.p  = (FLT_OR_DBL *)malloc(sizeof(FLT_OR_DBL) * 450 * 381);
+  w1.n  = w2.n = 0;
+
+  vrna_md_set_default(&md);
+  md.window_size  = 380;
+  md.max_bp_span  = 380;
+
+  vc  = vrna_fold_compound(sequence, &md, VRNA_OPTION_PF | VRNA_OPTION_WINDOW);
+  s1  = vc->exp_params->pf_scale;
+  ck_assert(vrna_probs_window(vc, 0, VRNA_PROBS_WINDOW_BPP, &collect_window_bpp, (void *)&w1));
+  s2 = vc->exp_params->pf_scale;
+  vrna_fold_compound_free(vc);
+
+  ck_assert(s2 > s1);
+
+  /* same probabilities as if the final scaling factor had been used right from the start */
+  vc                        = vrna_fold_compound(sequence, &md, VRNA_OPTION_PF | VRNA_OPTION_WINDOW);
+  vc->exp_params->pf_scale  = s2;
+  vrna_exp_params_rescale(vc, NULL);
+  ck_assert(vrna_probs_window(vc, 0, VRNA_PROBS_WINDOW_BPP, &collect_window_bpp, (void *)&w2));
+  ck_assert(vc->exp_params->pf_scale == s2);
+  vrna_fold_compound_free(vc);
+
+  ck_assert(w1.n > 0);
+  ck_assert(w1.n == w2.n);
+  for (k = 0; k < w1.n; k++)
+    ck_assert(fabs(w1.p[k] - w2.p[k]) < 1e-10);
+
+  free(w1.p);
+  free(w2.p);
+}
+
+#tcase Binary_Output
+
+#test test_plfold_bin
+{
+  vrna_md_t                     md;
+  vrna_fold_compound_t          *vc;
+  const char                    sequence[] =
+    "GGGAAAUCCCGCAUGCGAUUCGCAUGGGUAAAGCCCUUAGCGCUAAGGCUCAGUUAAAUGGCAGAAAACUGGCAGGGCUUUUAGUCGUGGGAUGAUCAGUGG";
+  const char                    *filename = "test_plfold.bin";
+  unsigned int                  n, i, u, ulength = 8;
+  size_t                        num, total, index_offset;
+  uint64_t                      *index;
+  float                         v;
+  FILE                          *fp;
+  char                          *buf;
+  long                          size;
+  plfold_bin_data               d;
+  vrna_plfold_bin_t             *bin;
+  const vrna_plfold_bin_pair_t  *pairs;
+
+  n = strlen(sequence);
+
+  vrna_md_set_default(&md);
+  md.window_size  = 40;
+  md.max_bp_span  = 30;
+
+  d.ulength   = ulength;
+  d.cutoff    = 0.01;
+  d.num_pairs = (size_t *)vrna_alloc(sizeof(size_t) * (n + 1));
+  d.pU        = (double *)vrna_alloc(sizeof(double) * n * ulength);
+  d.writer    = vrna_file_plfold_bin_writer(filename, n, 40, 30, ulength, d.cutoff);
+  ck_assert(d.writer != NULL);
+
+  vc = vrna_fold_compound(sequence, &md, VRNA_OPTION_WINDOW);
+  ck_assert(vrna_probs_window(vc,
+                              ulength,
+                              VRNA_PROBS_WINDOW_BPP | VRNA_PROBS_WINDOW_UP,
+                              &write_plfold_bin,
+                              (void *)&d));
+  vrna_fold_compound_free(vc);
+
+  ck_assert_int_eq(vrna_file_plfold_bin_writer_close(d.writer), 1);
+
+  bin = vrna_file_plfold_bin_open(filename);
+  ck_assert(bin != NULL);
+  ck_assert_int_eq(bin->length, n);
+  ck_assert_int_eq(bin->window_size, 40);
+  ck_assert_int_eq(bin->max_bp_span, 30);
+  ck_assert_int_eq(bin->ulength, ulength);
+
+  /* unpaired probabilities, segments must not reach beyond the 5' end */
+  for (i = 1; i <= n; i++)
+    for (u = 1; u <= ulength; u++) {
+      v = vrna_plfold_bin_unpaired(bin, i, u);
+      if (u > i)
+        ck_assert(isnan(v));
+      else
+        ck_assert(fabs(v - d.pU[(i - 1) * ulength + u - 1]) < 1e-6);
+    }
+
+  ck_assert(isnan(vrna_plfold_bin_unpaired(bin, 0, 1)));
+  ck_assert(isnan(vrna_plfold_bin_unpaired(bin, n + 1, 1)));
+  ck_assert(isnan(vrna_plfold_bin_unpaired(bin, n, ulength + 1)));
+
+  /* base pairs, per 5' position and for the entire sequence */
+  for (total = 0, i = 1; i <= n; i++) {
+    pairs = vrna_plfold_bin_pairs(bin, i, i, &num);
+    ck_assert_int_eq(num, d.num_pairs[i]);
+    for (; num > 0; num--, pairs++) {
+      ck_assert_int_eq(pairs->i, i);
+      ck_assert(pairs->j > i);
+      ck_assert(pairs->j - i <= 30);
+      ck_assert(pairs->p >= d.cutoff);
+    }
+    total += d.num_pairs[i];
+  }
+
+  ck_assert(total > 0);
+  ck_assert_int_eq(bin->num_pairs, total);
+  (void)vrna_plfold_bin_pairs(bin, 1, n, &num);
+  ck_assert_int_eq(num, total);
+
+  size          = (long)bin->size;
+  index_offset  = (size_t)((const char *)bin->index - (const char *)bin->data);
+  vrna_file_plfold_bin_close(bin);
+
+  /* a truncated file is rejected */
+  buf = (char *)vrna_alloc(size);
+  fp  = fopen(filename, "rb");
+  ck_assert_int_eq(fread(buf, 1, size, fp), size);
+  fclose(fp);
+
+  fp = fopen(filename, "wb");
+  ck_assert_int_eq(fwrite(buf, 1, size - 1, fp), size - 1);
+  fclose(fp);
+
+  ck_assert(vrna_file_plfold_bin_open(filename) == NULL);
+
+  /* so is a base pair index that is decreasing or does not end at the number of pairs */
+  index = (uint64_t *)(buf + index_offset);
+
+  index[1] = total + 1;
+  fp = fopen(filename, "wb");
+  ck_assert_int_eq(fwrite(buf, 1, size, fp), size);
+  fclose(fp);
+  ck_assert(vrna_file_plfold_bin_open(filename) == NULL);
+
+  index[1]      = 0;
+  index[n + 1]  = total - 1;
+  fp            = fopen(filename, "wb");
+  ck_assert_int_eq(fwrite(buf, 1, size, fp), size);
+  fclose(fp);
+  ck_assert(vrna_file_plfold_bin_open(filename) == NULL);
+
+  remove(filename);
+  free(buf);
+  free(d.num_pairs);
+  free(d.pU);
+}
+
+#tcase  Multistrand_Complexes
+
+#test test_pf_complexes
+{
+  const char            *strands[] = {
+    "GGGCUAUUAGCUCAGUUGGUUAGAGC",
+    "GCUCUAACCAACUGAGCUAAUAGCCC",
+    "ACGUACGGAUCCGUACGU"
+  };
+  char                  input[100];
+  unsigned int          k, c, ***complexes;
+  int                   setting;
+  double                **dG;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+
+  sprintf(input, "%s&%s&%s", strands[0], strands[1], strands[2]);
+
+  complexes = (unsigned int ***)vrna_alloc(sizeof(unsigned int **) * 3);
+  for (k = 1; k <= 3; k++)
+    complexes[k - 1] = vrna_n_multichoose_k(3, k);
+
+  /* default model, no lonely pairs, and no dangles */
+  for (setting = 0; setting < 3; setting++) {
+    vrna_md_set_default(&md);
+    md.threads = 2;
+
+    if (setting == 1)
+      md.noLP = 1;
+    else if (setting == 2)
+      md.dangles = 0;
+
+    fc  = vrna_fold_compound(input, &md, VRNA_OPTION_DEFAULT | VRNA_OPTION_PF);
+    dG  = vrna_pf_complexes(fc, complexes, 3);
+
+    ck_assert_ptr_ne(dG, NULL);
+
+    for (k = 1; k <= 3; k++) {
+      for (c = 0; complexes[k - 1][c]; c++)
+        ck_assert(fabs(dG[k - 1][c] - complex_energy(strands, 3, complexes[k - 1][c], k, &md)) <
+                  1e-10);
+
+      free(dG[k - 1]);
+    }
+
+    free(dG);
+    vrna_fold_compound_free(fc);
+  }
+
+  for (k = 1; k <= 3; k++) {
+    for (c = 0; complexes[k - 1][c]; c++)
+      free(complexes[k - 1][c]);
+
+    free(complexes[k - 1]);
+  }
+
+  free(complexes);
+}
+
+
+#test test_pf_complexes_strands
+{
+  const char            *strands[] = {
+    "GGGCUAUUAGCUCAGUUGGUUAGAGC",
+    "GCUCUAACCAACUGAGCUAAUAGCCC",
+    "GGAUCCGUACGUACGGAUCC"
+  };
+  char                  *seq;
+  unsigned int          k, c, a, b, ***complexes;
+  int                   setting;
+  double                mfe, **dG;
+  vrna_md_t             md;
+  vrna_dimer_pf_t       AB;
+  vrna_fold_compound_t  *fc;
+
+  complexes = (unsigned int ***)vrna_alloc(sizeof(unsigned int **) * 2);
+  for (k = 1; k <= 2; k++)
+    complexes[k - 1] = vrna_n_multichoose_k(3, k);
+
+  /* all heterodimers and homodimers, with and without lonely pairs */
+  for (setting = 0; setting < 2; setting++) {
+    vrna_md_set_default(&md);
+    md.compute_bpp  = 0;
+    md.threads      = 2;
+    md.noLP         = setting;
+
+    dG = vrna_pf_complexes_strands(strands, 3, &md, complexes, 2);
+
+    ck_assert_ptr_ne(dG, NULL);
+
+    for (c = 0; complexes[1][c]; c++) {
+      a   = complexes[1][c][0];
+      b   = complexes[1][c][1];
+      seq = vrna_strdup_printf("%s&%s", strands[a], strands[b]);
+      fc  = vrna_fold_compound(seq, &md, VRNA_OPTION_DEFAULT | VRNA_OPTION_PF);
+      mfe = (double)vrna_mfe(fc, NULL);
+      vrna_exp_params_rescale(fc, &mfe);
+      AB  = vrna_pf_dimer(fc, NULL);
+
+      ck_assert(fabs(dG[1][c] - AB.FcAB) < 1e-10);
+
+      /*
+       *  the monomers of vrna_pf_dimer() apply the lonely pair check to the
+       *  concatenated sequence, so compare against the isolated strands instead
+       */
+      if (md.noLP) {
+        ck_assert(fabs(dG[0][a] - complex_energy(strands, 3, &a, 1, &md)) < 1e-10);
+        ck_assert(fabs(dG[0][b] - complex_energy(strands, 3, &b, 1, &md)) < 1e-10);
+      } else {
+        ck_assert(fabs(dG[0][a] - AB.FA) < 1e-10);
+        ck_assert(fabs(dG[0][b] - AB.FB) < 1e-10);
+      }
+
+      vrna_fold_compound_free(fc);
+      free(seq);
+    }
+
+    free(dG[0]);
+    free(dG[1]);
+    free(dG);
+  }
+
+  for (k = 1; k <= 2; k++) {
+    for (c = 0; complexes[k - 1][c]; c++)
+      free(complexes[k - 1][c]);
+
+    free(complexes[k - 1]);
+  }
+
+  free(complexes);
+}
+
+
+#tcase  RNAup_Interaction
+
+#test test_pf_interact_legacy
+{
+  char                  target[] =
+    "GGGCUAUUAGCUCAGUUGGUUAGAGCGCACCCCUGAUAAGGGUGAGGUCGCUGAUUCGAAUUCAGCAUAGCCCAAUUGCAUCGAUGCAAAGCUU";
+  char                  srna[] = "AAGCUUUGCAUCGAUGCAAUUGGGCUAUGC";
+  pu_contrib            *pu1, *pu2, *pu1_ref, *pu2_ref;
+  interact              *in, *in_ref;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc1, *fc2;
+
+  /* with the scaling factor set as in RNAup, both APIs must agree */
+  pu2_ref = unstructured_legacy(srna, 25);
+  free_pf_arrays();
+  pu1_ref = unstructured_legacy(target, 25);
+  in_ref  = pf_interact(target, srna, pu1_ref, pu2_ref, 25, NULL, 0, 0);
+  free_pf_arrays();
+  pf_scale = -1;
+
+  set_model_details(&md);
+  md.sfact = 1.07;
+
+  pu2 = unstructured(srna, 25, &md, &fc2);
+  pu1 = unstructured(target, 25, &md, &fc1);
+  in  = vrna_pf_interact(fc1, srna, pu1, pu2, 25, NULL, 0, 0);
+
+  ck_assert_ptr_ne(in, NULL);
+  compare_pu_contrib(pu1, pu1_ref);
+  compare_pu_contrib(pu2, pu2_ref);
+  compare_interact(in, in_ref);
+
+  free_interact(in);
+  free_interact(in_ref);
+  free_pu_contrib_struct(pu1);
+  free_pu_contrib_struct(pu2);
+  free_pu_contrib_struct(pu1_ref);
+  free_pu_contrib_struct(pu2_ref);
+  vrna_fold_compound_free(fc1);
+  vrna_fold_compound_free(fc2);
+}
+
+#test test_pf_interact_shared
+{
+  const char            target[] =
+    "GGGCUAUUAGCUCAGUUGGUUAGAGCGCACCCCUGAUAAGGGUGAGGUCGCUGAUUCGAAUUCAGCAUAGCCCAAUUGCAUCGAUGCAAAGCUU";
+  const char            *srnas[] = {
+    "AAGCUUUGCAUCGAUGCAAUUGGGCUAUGC",
+    "GCUCUAACCAACUGAGCUAAUAGCCC",
+    "CGAAUCAGCGACCUCACCCUUAUCAGG",
+    "UGCUGAAUUCGAAUCAGC",
+    "GGAUCCGUACGUACGGAUCC",
+    "ACGUACGUACGUACGUACGUACGU",
+    "GGGGAAAACCCCAUGCGAUUCGCAU",
+    "UUUUUUUUUUUUUUUU"
+  };
+  unsigned int          i, t, num, num_threads;
+  pu_contrib            *pu, *pu2[8];
+  interact              *in[8], *in_ref[8];
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc, *fc2;
+  pthread_t             tid[4];
+  interaction_jobs      jobs[4];
+
+  num         = 8;
+  num_threads = 4;
+
+  vrna_md_set_default(&md);
+  md.sfact = 1.07;
+
+  pu = unstructured(target, 25, &md, &fc);
+
+  for (i = 0; i < num; i++) {
+    pu2[i] = unstructured(srnas[i], 25, &md, &fc2);
+    vrna_fold_compound_free(fc2);
+  }
+
+  for (i = 0; i < num; i++)
+    in_ref[i] = vrna_pf_interact(fc, srnas[i], pu, pu2[i], 25, NULL, 0, 0);
+
+  /* all threads share the fold compound of the target */
+  for (t = 0; t < num_threads; t++) {
+    jobs[t].fc          = fc;
+    jobs[t].pu          = pu;
+    jobs[t].s2          = srnas;
+    jobs[t].pu2         = pu2;
+    jobs[t].in          = in;
+    jobs[t].num         = num;
+    jobs[t].thread      = t;
+    jobs[t].num_threads = num_threads;
+    ck_assert_int_eq(pthread_create(tid + t, NULL, &interact_shared, (void *)(jobs + t)), 0);
+  }
+
+  for (t = 0; t < num_threads; t++)
+    pthread_join(tid[t], NULL);
+
+  for (i = 0; i < num; i++) {
+    ck_assert_ptr_ne(in[i], NULL);
+    compare_interact(in[i], in_ref[i]);
+    free_interact(in[i]);
+    free_interact(in_ref[i]);
+    free_pu_contrib_struct(pu2[i]);
+  }
+
+  free_pu_contrib_struct(pu);
+  vrna_fold_compound_free(fc);
+}
+
 #suite  Constraints_Implementation
 
 #tcase  Soft_Constraints
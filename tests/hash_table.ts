@@ -79,5 +79,43 @@ free_dummy(void *x)
 }
 
 
+#test test_vrna_hash_table_remove
+{
+  /* all entries collide, so removal has to shift the remainder of a long bucket */
+  vrna_hash_table_t ht = vrna_ht_init(27,
+                                      hash_comparison_test,
+                                      hash_function_test,
+                                      free_dummy);
+  unsigned int      val[8], removed[8], *res_p;
+  int               i, j, order[4] = {
+    2, 0, 7, 4
+  };
+
+  for (i = 0; i < 8; i++) {
+    val[i]      = 10 * i;
+    removed[i]  = 0;
+    ck_assert_int_eq(vrna_ht_insert(ht, (void *)&(val[i])), 0);
+  }
+
+  /* remove from the middle, the head and the tail of the bucket */
+  for (j = 0; j < 4; j++) {
+    vrna_ht_remove(ht, (void *)&(val[order[j]]));
+    removed[order[j]] = 1;
+
+    for (i = 0; i < 8; i++) {
+      res_p = vrna_ht_get(ht, (void *)&(val[i]));
+      if (removed[i]) {
+        ck_assert_ptr_eq(res_p, NULL);
+      } else {
+        ck_assert_ptr_ne(res_p, NULL);
+        ck_assert_int_eq(*res_p, val[i]);
+      }
+    }
+  }
+
+  vrna_ht_free(ht);
+}
+
+
 #main-pre
     srunner_set_tap(sr, "-");
@@ -1,10 +1,13 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include <ViennaRNA/landscape/neighbor.h>
 #include <ViennaRNA/model.h>
 #include <ViennaRNA/utils/basic.h>
 #include <ViennaRNA/utils/structures.h>
 #include <ViennaRNA/data_structures.h>
+#include <ViennaRNA/eval.h>
 #include <stdarg.h>
 
 
@@ -775,5 +778,75 @@ test_RNA2_move_it(vrna_fold_compound_t  *vc,
 }
 
 
+/* Test cached move energies along random walks through the landscape */
+#test test_loop_cache_random_walk
+{
+  char                  *seq = "GGGAAAUCCCAGCGCAUUGCGCUUAGGGAAACCCUAUGGCAAGCCAUCCGGAAUUCCGGA";
+  char                  *structure;
+  short                 *pt;
+  int                   d, k, step, n, dG, dG_cache, e;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *vc;
+  vrna_loop_cache_t     *cache;
+  vrna_move_t           *neighbors, *m;
+
+  srand(1);
+
+  for (d = 0; d <= 2; d++) {
+    vrna_md_set_default(&md);
+    md.dangles = d;
+
+    vc          = vrna_fold_compound(seq, &md, VRNA_OPTION_EVAL_ONLY);
+    structure   = vrna_alloc(sizeof(char) * (strlen(seq) + 1));
+    memset(structure, '.', strlen(seq));
+    pt          = vrna_ptable(structure);
+    cache       = vrna_loop_cache_init(vc, pt);
+    e           = vrna_eval_structure_pt(vc, pt);
+
+    ck_assert_int_eq(vrna_loop_cache_energy(cache), e);
+
+    for (step = 0; step < 200; step++) {
+      neighbors = vrna_neighbors(vc, pt, VRNA_MOVESET_DEFAULT | VRNA_MOVESET_SHIFT);
+
+      for (n = 0, m = neighbors; m->pos_5 != 0; m++, n++) {
+        dG_cache = vrna_eval_move_cache(vc, cache, m->pos_5, m->pos_3);
+
+        if (vrna_move_is_shift(m))
+          dG = vrna_eval_move_shift_pt(vc, m, pt);
+        else
+          dG = (int)roundf(100. * vrna_eval_move(vc, structure, m->pos_5, m->pos_3));
+
+        ck_assert_int_eq(dG_cache, dG);
+      }
+
+      if (n == 0) {
+        vrna_move_list_free(neighbors);
+        break;
+      }
+
+      /* proceed with a random neighbor */
+      m         = neighbors + rand() % n;
+      dG_cache  = vrna_loop_cache_apply(vc, cache, m->pos_5, m->pos_3);
+      vrna_move_apply(pt, m);
+      free(structure);
+      structure = vrna_db_from_ptable(pt);
+      vrna_move_list_free(neighbors);
+
+      ck_assert_int_eq(vrna_loop_cache_energy(cache), e + dG_cache);
+      e = vrna_eval_structure_pt(vc, pt);
+      ck_assert_int_eq(vrna_loop_cache_energy(cache), e);
+
+      for (k = 0; k <= pt[0]; k++)
+        ck_assert_int_eq(vrna_loop_cache_ptable(cache)[k], pt[k]);
+    }
+
+    vrna_loop_cache_free(cache);
+    free(structure);
+    free(pt);
+    vrna_fold_compound_free(vc);
+  }
+}
+
+
 #main-pre
     srunner_set_tap(sr, "-");
@@ -1,11 +1,16 @@
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include <ViennaRNA/model.h>
 #include <ViennaRNA/utils/basic.h>
 #include <ViennaRNA/utils/strings.h>
 #include <ViennaRNA/alphabet.h>
 #include <ViennaRNA/mfe.h>
+#include <ViennaRNA/utils/scheduler.h>
+#include <ViennaRNA/datastructures/stream_output.h>
+#include <ViennaRNA/io/file_formats.h>
 
 static int
 compare_str(const void  *a,
@@ -14,6 +19,264 @@ compare_str(const void  *a,
   return strcmp(*((const char **)a), *((const char **)b));
 }
 
+
+typedef struct {
+  pthread_mutex_t mtx;
+  pthread_cond_t  cond;
+  unsigned int    started;    /* tasks that started execution */
+  unsigned int    submitted;  /* tasks that returned from vrna_scheduler_submit() */
+  int             gate_open;  /* tasks wait until this is set */
+  unsigned int    *executed;  /* number of executions for each task */
+} task_counter;
+
+typedef struct {
+  task_counter  *counter;
+  unsigned int  id;
+} task_data;
+
+typedef struct {
+  vrna_scheduler_t  scheduler;
+  task_data         *tasks;
+  unsigned int      num;
+} submit_data;
+
+
+static void
+count_task(void *data)
+{
+  task_data *t = (task_data *)data;
+
+  pthread_mutex_lock(&(t->counter->mtx));
+  t->counter->started++;
+  pthread_cond_broadcast(&(t->counter->cond));
+
+  while (!t->counter->gate_open)
+    pthread_cond_wait(&(t->counter->cond), &(t->counter->mtx));
+
+  t->counter->executed[t->id]++;
+  pthread_mutex_unlock(&(t->counter->mtx));
+}
+
+
+static void *
+submit_tasks(void *data)
+{
+  unsigned int  i;
+  submit_data   *d = (submit_data *)data;
+
+  for (i = 0; i < d->num; i++) {
+    vrna_scheduler_submit(d->scheduler, &count_task, d->tasks + i);
+
+    pthread_mutex_lock(&(d->tasks[i].counter->mtx));
+    d->tasks[i].counter->submitted++;
+    pthread_cond_broadcast(&(d->tasks[i].counter->cond));
+    pthread_mutex_unlock(&(d->tasks[i].counter->mtx));
+  }
+
+  return NULL;
+}
+
+
+static task_data *
+init_tasks(task_counter *counter,
+           unsigned int num,
+           int          gate_open)
+{
+  unsigned int  i;
+  task_data     *tasks = (task_data *)vrna_alloc(sizeof(task_data) * num);
+
+  pthread_mutex_init(&(counter->mtx), NULL);
+  pthread_cond_init(&(counter->cond), NULL);
+  counter->started    = 0;
+  counter->submitted  = 0;
+  counter->gate_open  = gate_open;
+  counter->executed   = (unsigned int *)vrna_alloc(sizeof(unsigned int) * num);
+
+  for (i = 0; i < num; i++) {
+    tasks[i].counter  = counter;
+    tasks[i].id       = i;
+  }
+
+  return tasks;
+}
+
+
+static void
+free_tasks(task_counter *counter,
+           task_data    *tasks)
+{
+  pthread_cond_destroy(&(counter->cond));
+  pthread_mutex_destroy(&(counter->mtx));
+  free(counter->executed);
+  free(tasks);
+}
+
+
+typedef struct {
+  unsigned int  next;         /* index expected by the next output callback */
+  unsigned int  errors;       /* out of order or corrupted data blocks */
+  unsigned int  since_flush;  /* output callbacks since the last flush */
+  unsigned int  flushes;
+  unsigned int  empty_flushes;
+} stream_log;
+
+typedef struct {
+  vrna_ostream_t  stream;
+  pthread_mutex_t mtx;
+  unsigned int    next;       /* next index to request */
+  unsigned int    num;        /* total number of data blocks */
+} stream_source;
+
+
+static void
+log_output(void         *auxdata,
+           unsigned int i,
+           void         *data)
+{
+  stream_log *log = (stream_log *)auxdata;
+
+  if ((i != log->next) ||
+      (*((unsigned int *)data) != 3 * i + 1))
+    log->errors++;
+
+  log->next = i + 1;
+  log->since_flush++;
+  free(data);
+}
+
+
+static void
+log_flush(void *auxdata)
+{
+  stream_log *log = (stream_log *)auxdata;
+
+  if (log->since_flush == 0)
+    log->empty_flushes++;
+
+  log->since_flush = 0;
+  log->flushes++;
+}
+
+
+/* request small blocks of indices, and provide their data in reverse order */
+static void *
+provide_blocks(void *arg)
+{
+  unsigned int  i, first, last, *data;
+  stream_source *src = (stream_source *)arg;
+
+  while (1) {
+    pthread_mutex_lock(&(src->mtx));
+    first     = src->next;
+    last      = first + 1 + rand() % 4;
+    last      = (last > src->num) ? src->num : last;
+    src->next = last;
+    pthread_mutex_unlock(&(src->mtx));
+
+    if (first >= last)
+      break;
+
+    for (i = first; i < last; i++)
+      vrna_ostream_request(src->stream, i);
+
+    for (i = last; i > first; i--) {
+      data  = (unsigned int *)vrna_alloc(sizeof(unsigned int));
+      *data = 3 * (i - 1) + 1;
+      vrna_ostream_provide(src->stream, i - 1, (void *)data);
+    }
+  }
+
+  return NULL;
+}
+
+
+/*
+ *  compare all data sets obtained from the shards of a memory mapped reader
+ *  to those obtained by vrna_file_fasta_read_record() from the same file
+ */
+static void
+compare_fasta_shards(const char   *input,
+                     unsigned int num_shards)
+{
+  char                *filename, *header, *sequence, **rest, **rest2;
+  int                 fd, quit;
+  unsigned int        k, r, ret, ret2, num;
+  FILE                *fp;
+  vrna_fasta_reader_t reader;
+  vrna_fasta_record_t record;
+
+  filename  = vrna_strdup_printf("/tmp/vrna_fasta_XXXXXX");
+  fd        = mkstemp(filename);
+  ck_assert(fd >= 0);
+  ck_assert_int_eq(write(fd, input, strlen(input)), strlen(input));
+  close(fd);
+
+  fp      = fopen(filename, "r");
+  num     = 0;
+  ret     = vrna_file_fasta_read_record(&header, &sequence, &rest, fp, 0);
+
+  for (k = 0; k < num_shards; k++) {
+    reader = vrna_file_fasta_reader(filename, k, num_shards, 0);
+    ck_assert(reader != NULL);
+
+    while (!((ret2 = vrna_file_fasta_reader_next(reader, &record)) &
+             (VRNA_INPUT_ERROR | VRNA_INPUT_QUIT))) {
+      /* the stream reader must have read the same data set */
+      ck_assert(!(ret & (VRNA_INPUT_ERROR | VRNA_INPUT_QUIT)));
+      ck_assert_int_eq(ret2, ret);
+
+      if (header) {
+        ck_assert_int_eq(record.header_length, strlen(header) - 1);
+        ck_assert(strncmp(record.header, header + 1, record.header_length) == 0);
+      } else {
+        ck_assert(record.header == NULL);
+      }
+
+      ck_assert_int_eq(record.length, strlen(sequence));
+      ck_assert(strncmp(record.sequence, sequence, record.length) == 0);
+
+      rest2 = vrna_file_fasta_record_rest(&record);
+      for (r = 0; rest[r] && rest2[r]; r++)
+        ck_assert_str_eq(rest2[r], rest[r]);
+
+      ck_assert(rest[r] == NULL);
+      ck_assert(rest2[r] == NULL);
+
+      for (r = 0; rest[r]; r++) {
+        free(rest[r]);
+        free(rest2[r]);
+      }
+
+      free(rest);
+      free(rest2);
+      free(header);
+      free(sequence);
+      num++;
+
+      ret = vrna_file_fasta_read_record(&header, &sequence, &rest, fp, 0);
+    }
+
+    /* see vrna_file_fasta_reader(), data sets of subsequent shards must be discarded */
+    quit = vrna_file_fasta_reader_quit(reader);
+
+    vrna_file_fasta_reader_free(reader);
+
+    if ((ret2 & VRNA_INPUT_ERROR) ||
+        (quit))
+      break;
+  }
+
+  /* no data sets left */
+  ck_assert(ret & (VRNA_INPUT_ERROR | VRNA_INPUT_QUIT));
+  ck_assert(num > 0);
+
+  free(rest);
+  fclose(fp);
+  unlink(filename);
+  free(filename);
+}
+
+
 #suite Utilities
 
 #tcase Sequence_Utils
@@ -299,10 +562,322 @@ compare_str(const void  *a,
 }
 
 
+#tcase Task_Scheduler
+
+#test test_scheduler_immediate
+{
+  unsigned int      i;
+  task_counter      counter;
+  task_data         *tasks;
+  vrna_scheduler_t  scheduler;
+
+  tasks     = init_tasks(&counter, 10, 1);
+  scheduler = vrna_scheduler_init(1, 0);
+
+  /* a single worker is no worker at all, tasks are executed by the submitting thread */
+  ck_assert_int_eq(vrna_scheduler_workers(scheduler), 0);
+
+  for (i = 0; i < 10; i++) {
+    ck_assert_int_eq(vrna_scheduler_submit(scheduler, &count_task, tasks + i), 1);
+    ck_assert_int_eq(counter.executed[i], 1);
+  }
+
+  ck_assert_int_eq(vrna_scheduler_submit(scheduler, NULL, tasks), 0);
+  ck_assert_int_eq(vrna_scheduler_submit(NULL, &count_task, tasks), 0);
+
+  vrna_scheduler_free(scheduler);
+  free_tasks(&counter, tasks);
+}
+
+#test test_scheduler_submit_wait
+{
+  unsigned int      i, n = 1000;
+  task_counter      counter;
+  task_data         *tasks;
+  vrna_scheduler_t  scheduler;
+
+  /* many more tasks than there are slots in the queues */
+  tasks     = init_tasks(&counter, n, 1);
+  scheduler = vrna_scheduler_init(4, 2);
+
+  ck_assert_int_eq(vrna_scheduler_workers(scheduler), 4);
+
+  for (i = 0; i < n; i++)
+    ck_assert_int_eq(vrna_scheduler_submit(scheduler, &count_task, tasks + i), 1);
+
+  vrna_scheduler_wait(scheduler);
+
+  /* every task has been executed exactly once */
+  ck_assert_int_eq(counter.started, n);
+  for (i = 0; i < n; i++)
+    ck_assert_int_eq(counter.executed[i], 1);
+
+  /* the scheduler can be re-used after waiting */
+  for (i = 0; i < n; i++)
+    vrna_scheduler_submit(scheduler, &count_task, tasks + i);
+
+  vrna_scheduler_wait(scheduler);
+
+  for (i = 0; i < n; i++)
+    ck_assert_int_eq(counter.executed[i], 2);
+
+  vrna_scheduler_free(scheduler);
+  free_tasks(&counter, tasks);
+}
+
+#test test_scheduler_backpressure
+{
+  unsigned int      i, n = 5;
+  task_counter      counter;
+  task_data         *tasks;
+  submit_data       submitter;
+  pthread_t         tid;
+  vrna_scheduler_t  scheduler;
+
+  /* 2 workers with a single queue slot each */
+  tasks     = init_tasks(&counter, n, 0);
+  scheduler = vrna_scheduler_init(2, 1);
+
+  ck_assert_int_eq(vrna_scheduler_workers(scheduler), 2);
+
+  submitter.scheduler = scheduler;
+  submitter.tasks     = tasks;
+  submitter.num       = n;
+
+  pthread_create(&tid, NULL, &submit_tasks, &submitter);
+
+  /* both workers are busy and both queues are full ... */
+  pthread_mutex_lock(&(counter.mtx));
+  while ((counter.started < 2) || (counter.submitted < 4))
+    pthread_cond_wait(&(counter.cond), &(counter.mtx));
+
+  pthread_mutex_unlock(&(counter.mtx));
+
+  /* ... so the last submission must block */
+  usleep(100000);
+
+  pthread_mutex_lock(&(counter.mtx));
+  ck_assert_int_eq(counter.started, 2);
+  ck_assert_int_eq(counter.submitted, 4);
+
+  counter.gate_open = 1;
+  pthread_cond_broadcast(&(counter.cond));
+  pthread_mutex_unlock(&(counter.mtx));
+
+  pthread_join(tid, NULL);
+  vrna_scheduler_wait(scheduler);
+
+  ck_assert_int_eq(counter.submitted, n);
+  for (i = 0; i < n; i++)
+    ck_assert_int_eq(counter.executed[i], 1);
+
+  vrna_scheduler_free(scheduler);
+  free_tasks(&counter, tasks);
+}
+
+#test test_scheduler_concurrent_submit
+{
+  unsigned int      i, k, n = 400, num_submitters = 4;
+  task_counter      counter;
+  task_data         *tasks;
+  submit_data       submitters[4];
+  pthread_t         tid[4];
+  vrna_scheduler_t  scheduler;
+
+  /* several threads submit into small queues, while workers keep running dry */
+  tasks     = init_tasks(&counter, n * num_submitters, 1);
+  scheduler = vrna_scheduler_init(3, 1);
+
+  for (k = 0; k < 20; k++) {
+    for (i = 0; i < num_submitters; i++) {
+      submitters[i].scheduler = scheduler;
+      submitters[i].tasks     = tasks + i * n;
+      submitters[i].num       = n;
+      pthread_create(tid + i, NULL, &submit_tasks, submitters + i);
+    }
+
+    for (i = 0; i < num_submitters; i++)
+      pthread_join(tid[i], NULL);
+
+    vrna_scheduler_wait(scheduler);
+
+    /* no task got lost or executed twice, and waiting returned only after all of them finished */
+    ck_assert_int_eq(counter.started, (k + 1) * n * num_submitters);
+    for (i = 0; i < n * num_submitters; i++)
+      ck_assert_int_eq(counter.executed[i], k + 1);
+  }
+
+  vrna_scheduler_free(scheduler);
+  free_tasks(&counter, tasks);
+}
+
+#test test_scheduler_free_pending
+{
+  unsigned int      i, n = 100;
+  task_counter      counter;
+  task_data         *tasks;
+  submit_data       submitter;
+  pthread_t         tid;
+  vrna_scheduler_t  scheduler;
+
+  tasks     = init_tasks(&counter, n, 0);
+  scheduler = vrna_scheduler_init(3, 0);
+
+  submitter.scheduler = scheduler;
+  submitter.tasks     = tasks;
+  submitter.num       = n;
+
+  pthread_create(&tid, NULL, &submit_tasks, &submitter);
+
+  /* all tasks fit into the queues and none of them has finished yet */
+  pthread_mutex_lock(&(counter.mtx));
+  while (counter.submitted < n)
+    pthread_cond_wait(&(counter.cond), &(counter.mtx));
+
+  counter.gate_open = 1;
+  pthread_cond_broadcast(&(counter.cond));
+  pthread_mutex_unlock(&(counter.mtx));
+
+  pthread_join(tid, NULL);
+
+  /* shutting down still processes all pending tasks */
+  vrna_scheduler_free(scheduler);
+
+  ck_assert_int_eq(counter.started, n);
+  for (i = 0; i < n; i++)
+    ck_assert_int_eq(counter.executed[i], 1);
+
+  free_tasks(&counter, tasks);
+}
+
+
 //@TODO: extend alphabeth
 //@TODO: details.noLP = 1
 //@TODO: idx_type = 1
 
 
+#tcase Ordered_Stream
+
+#test test_ostream_concurrent_providers
+{
+  unsigned int  c, o, t, num_threads = 8;
+  unsigned int  capacity[2] = { 8, 0 };
+  unsigned int  options[2]  = { 0, VRNA_OSTREAM_WRITER_THREAD };
+  pthread_t     threads[8];
+  stream_log    log;
+  stream_source src;
+
+  /* a small and the default capacity, with and without writer thread */
+  for (c = 0; c < 2; c++) {
+    for (o = 0; o < 2; o++) {
+      memset(&log, 0, sizeof(stream_log));
+
+      src.stream  = vrna_ostream_init_bounded(&log_output,
+                                              &log_flush,
+                                              (void *)&log,
+                                              capacity[c],
+                                              options[o]);
+      src.next    = 0;
+      src.num     = 20000;
+      pthread_mutex_init(&(src.mtx), NULL);
+
+      for (t = 0; t < num_threads; t++)
+        pthread_create(&(threads[t]), NULL, &provide_blocks, (void *)&src);
+
+      for (t = 0; t < num_threads; t++)
+        pthread_join(threads[t], NULL);
+
+      vrna_ostream_free(src.stream);
+      pthread_mutex_destroy(&(src.mtx));
+
+      /* all data blocks arrive in order, and each batch is flushed once */
+      ck_assert_int_eq(log.errors, 0);
+      ck_assert_int_eq(log.next, src.num);
+      ck_assert_int_eq(log.since_flush, 0);
+      ck_assert_int_eq(log.empty_flushes, 0);
+      ck_assert(log.flushes > 0);
+      ck_assert(log.flushes <= src.num);
+    }
+  }
+}
+
+#test test_ostream_unbounded
+{
+  unsigned int  i, t, num_threads = 8, *data;
+  pthread_t     threads[8];
+  stream_log    log;
+  stream_source src;
+
+  /* a single thread may request more indices than the default capacity */
+  memset(&log, 0, sizeof(stream_log));
+  src.stream  = vrna_ostream_init(&log_output, (void *)&log);
+  src.num     = 3 * VRNA_OSTREAM_DEFAULT_CAPACITY + 5;
+
+  for (i = 0; i < src.num; i++)
+    vrna_ostream_request(src.stream, i);
+
+  for (i = src.num; i > 0; i--) {
+    data  = (unsigned int *)vrna_alloc(sizeof(unsigned int));
+    *data = 3 * (i - 1) + 1;
+    vrna_ostream_provide(src.stream, i - 1, (void *)data);
+
+    /* nothing can be processed before the first data block arrives */
+    ck_assert_int_eq(log.next, (i > 1) ? 0 : src.num);
+  }
+
+  vrna_ostream_free(src.stream);
+
+  ck_assert_int_eq(log.errors, 0);
+  ck_assert_int_eq(log.next, src.num);
+
+  /* the buffer also grows while other threads provide data */
+  memset(&log, 0, sizeof(stream_log));
+  src.stream  = vrna_ostream_init(&log_output, (void *)&log);
+  src.next    = 0;
+  src.num     = 20000;
+  pthread_mutex_init(&(src.mtx), NULL);
+
+  for (t = 0; t < num_threads; t++)
+    pthread_create(&(threads[t]), NULL, &provide_blocks, (void *)&src);
+
+  for (t = 0; t < num_threads; t++)
+    pthread_join(threads[t], NULL);
+
+  vrna_ostream_free(src.stream);
+  pthread_mutex_destroy(&(src.mtx));
+
+  ck_assert_int_eq(log.errors, 0);
+  ck_assert_int_eq(log.next, src.num);
+}
+
+
+#tcase File_Formats
+
+#test test_fasta_reader_shards
+{
+  unsigned int  i, n;
+  const char    *inputs[] = {
+    /* multi-line sequences and structures */
+    ">a some description\nACGUAGCUAGCU\nGGCCAUUA\n((....))....\n........\n>b\nAAAA\nCCCC\n\n>c\nGGGGAAAACCCC\n",
+    /* CRLF line breaks */
+    ">a\r\nACGUAGCU\r\nGGCC\r\n((....))\r\n>b\r\nAAAACCCC\r\n>c\r\nGGGG\r\n",
+    /* comments */
+    "# leading comment\n>a\n; comment\nACGU\n# comment\nGGCC\n((..))..\n>b\n* comment\nCCCC\n% comment\n>c\nGGGG\n",
+    /* quit line */
+    ">a\nACGU\n@\n>b\nCCCC\n",
+    ">a\nACGU\n>b\nCCCC\n@\n>c\nGGGG\n>d\nUUUU\n",
+    /* no headers at all */
+    "ACGUAGCU\n((....))\nGGGGCCCC\nAAAA\n....\n",
+    /* missing sequence */
+    ">a\nACGU\n>b\n>c\nGGGG\n",
+    NULL
+  };
+
+  for (i = 0; inputs[i]; i++)
+    for (n = 1; n <= 5; n++)
+      compare_fasta_shards(inputs[i], n);
+}
+
+
 #main-pre
     srunner_set_tap(sr, "-");
@@ -1,9 +1,13 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <ViennaRNA/landscape/walk.h>
 #include <ViennaRNA/model.h>
 #include <ViennaRNA/utils/structures.h>
 #include <ViennaRNA/data_structures.h>
+#include <ViennaRNA/utils/basic.h>
+#include <ViennaRNA/subopt.h>
+#include <ViennaRNA/landscape/findpath.h>
 
 #suite Walks
 
@@ -50,5 +54,80 @@
 }
 
 
+#test Findpath_Batch
+{
+  char                    *sequence = "GGGGAAAACCCCAUGCGAUUCGCAUGGGCAAAGCCCUAUAGCGCAUUUGCGCUAUA";
+  vrna_md_t               md, md_ref;
+  vrna_fold_compound_t    *vc;
+  vrna_subopt_solution_t  *sol;
+  vrna_path_t             **paths, *ref, *p, *q;
+  const char              **s1, **s2;
+  int                     *saddles, threads;
+  size_t                  n, k;
+
+  vrna_md_set_default(&md);
+  md.uniq_ML = 1;
+
+  vc  = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+  sol = vrna_subopt(vc, 200, 0, NULL);
+
+  for (n = 0; sol[n].structure; n++);
+
+  ck_assert(n > 2);
+
+  /* refold each suboptimal structure into the next one */
+  n--;
+  s1      = (const char **)vrna_alloc(sizeof(char *) * n);
+  s2      = (const char **)vrna_alloc(sizeof(char *) * n);
+  saddles = (int *)vrna_alloc(sizeof(int) * n);
+  paths   = (vrna_path_t **)vrna_alloc(sizeof(vrna_path_t *) * n);
+
+  for (k = 0; k < n; k++) {
+    s1[k] = sol[k].structure;
+    s2[k] = sol[k + 1].structure;
+  }
+
+  for (threads = 1; threads <= 4; threads += 3) {
+    vc->params->model_details.threads = threads;
+    md_ref                            = vc->params->model_details;
+
+    ck_assert_int_eq(vrna_path_findpath_batch(vc, s1, s2, n, 10, saddles, paths), 1);
+
+    /* the shared fold compound must remain untouched */
+    ck_assert(memcmp(&md_ref, &(vc->params->model_details), sizeof(vrna_md_t)) == 0);
+
+    for (k = 0; k < n; k++) {
+      ck_assert_int_eq(saddles[k], vrna_path_findpath_saddle(vc, s1[k], s2[k], 10));
+
+      ref = vrna_path_findpath(vc, s1[k], s2[k], 10);
+      for (p = ref, q = paths[k]; p->s && q->s; p++, q++) {
+        ck_assert_str_eq(p->s, q->s);
+        ck_assert(p->en == q->en);
+      }
+      ck_assert(p->s == NULL);
+      ck_assert(q->s == NULL);
+
+      vrna_path_free(ref);
+      vrna_path_free(paths[k]);
+    }
+
+    /* saddle energies only */
+    ck_assert_int_eq(vrna_path_findpath_batch(vc, s1, s2, n, 10, saddles, NULL), 1);
+    for (k = 0; k < n; k++)
+      ck_assert_int_eq(saddles[k], vrna_path_findpath_saddle(vc, s1[k], s2[k], 10));
+  }
+
+  for (k = 0; sol[k].structure; k++)
+    free(sol[k].structure);
+
+  free(sol);
+  free(s1);
+  free(s2);
+  free(saddles);
+  free(paths);
+  vrna_fold_compound_free(vc);
+}
+
+
 #main-pre
     srunner_set_tap(sr, "-");